@@ -125,6 +125,7 @@ print_connections(void)
 int main(int argc, char **argv)
 {
 	void			*history_ptr;
+	uint64_t		histories_size;
 	struct spdk_trace_histories *histories;
 	struct spdk_trace_history *history;
 
@@ -165,12 +166,24 @@ int main(int argc, char **argv)
 		exit(1);
 	}
 
+	/* Remap the entire trace file to reach the per lcore histories */
+	histories_size = spdk_get_trace_histories_size((struct spdk_trace_histories *)history_ptr);
+	munmap(history_ptr, sizeof(*histories));
+	history_ptr = mmap(NULL, histories_size, PROT_READ, MAP_SHARED, history_fd, 0);
+	if (history_ptr == MAP_FAILED) {
+		fprintf(stderr, "Unable to mmap history shm (%d).\n", errno);
+		exit(1);
+	}
+
 	histories = (struct spdk_trace_histories *)history_ptr;
 
 	memset(last_tasks_done, 0, sizeof(last_tasks_done));
 
 	for (i = 0; i < SPDK_TRACE_MAX_LCORE; i++) {
 		history = spdk_get_per_lcore_history(histories, i);
+		if (history == NULL) {
+			continue;
+		}
 		last_tasks_done[i] = history->tpoint_count[TRACE_ISCSI_TASK_DONE];
 	}
 
@@ -229,6 +242,9 @@ int main(int argc, char **argv)
 		total_tasks_done_per_sec = 0;
 		for (i = 0; i < SPDK_TRACE_MAX_LCORE; i++) {
 			history = spdk_get_per_lcore_history(histories, i);
+			if (history == NULL) {
+				continue;
+			}
 			tasks_done = history->tpoint_count[TRACE_ISCSI_TASK_DONE];
 			tasks_done_delta = tasks_done - last_tasks_done[i];
 			if (tasks_done_delta == 0) {
@@ -245,7 +261,7 @@ int main(int argc, char **argv)
 cleanup:
 	tcsetattr(0, TCSANOW, &oldt);
 
-	munmap(history_ptr, sizeof(*histories));
+	munmap(history_ptr, histories_size);
 	close(history_fd);
 
 	return (0);
@@ -33,7 +33,10 @@
 
 #include "spdk/stdinc.h"
 
+#include <algorithm>
 #include <map>
+#include <string>
+#include <vector>
 
 extern "C" {
 #include "spdk/trace.h"
@@ -42,6 +45,8 @@ extern "C" {
 
 static struct spdk_trace_histories *g_histories;
 static bool g_print_tsc = false;
+static bool g_json = false;
+static bool g_summary = false;
 
 static void usage(void);
 
@@ -64,7 +69,17 @@ public:
 	}
 };
 
-typedef std::map<entry_key, spdk_trace_entry *, compare_entry_key> entry_map;
+struct entry_info {
+	entry_info() : entry(NULL), thread_id(0), num_args(0) {}
+	struct spdk_trace_entry *entry;
+	/* spdk_thread the entry was recorded for, 0 if unknown */
+	uint64_t thread_id;
+	/* Arguments recorded after arg1 */
+	uint8_t num_args;
+	uint64_t args[SPDK_TRACE_MAX_ARGS_COUNT - 1];
+};
+
+typedef std::map<entry_key, entry_info, compare_entry_key> entry_map;
 
 entry_map g_entry_map;
 
@@ -161,12 +176,14 @@ print_arg(uint8_t arg_type, const char *arg_string, uint64_t arg)
 }
 
 static void
-print_event(struct spdk_trace_entry *e, uint64_t tsc_rate,
+print_event(struct entry_info *info, uint64_t tsc_rate,
 	    uint64_t tsc_offset, uint16_t lcore)
 {
+	struct spdk_trace_entry		*e = info->entry;
 	struct spdk_trace_tpoint	*d;
 	struct object_stats		*stats;
 	float				us;
+	uint8_t				i;
 
 	d = &g_histories->flags.tpoint[e->tpoint_id];
 	stats = &g_stats[d->object_type];
@@ -194,6 +211,9 @@ print_event(struct spdk_trace_entry *e, uint64_t tsc_rate,
 	print_size(e->size);
 
 	print_arg(d->arg1_type, d->arg1_name, e->arg1);
+	for (i = 0; i < info->num_args && i + 1 < d->num_args; i++) {
+		print_arg(d->args[i].type, d->args[i].name, info->args[i]);
+	}
 	if (d->new_object) {
 		print_object_id(d->object_type, stats->index[e->object_id]);
 	} else if (d->object_type != OBJECT_NONE) {
@@ -208,15 +228,289 @@ print_event(struct spdk_trace_entry *e, uint64_t tsc_rate,
 	} else if (e->object_id != 0) {
 		print_arg(SPDK_TRACE_ARG_TYPE_PTR, "object: ", e->object_id);
 	}
+	if (info->thread_id != 0) {
+		printf("thread: %ju", info->thread_id);
+	}
 	printf("\n");
 }
 
+/*
+ * Spans follow an object from the tracepoint that created it (new_object) to the
+ *  last tracepoint recorded for it before the object was created again, or the
+ *  trace ended.
+ */
+struct span_info {
+	uint64_t id;
+	uint64_t start_tsc;
+	uint64_t last_tsc;
+	uint16_t start_tpoint;
+	uint16_t last_tpoint;
+	uint16_t lcore;
+};
+
+typedef std::pair<uint8_t, uint64_t> span_key;
+typedef std::map<span_key, span_info> span_map;
+typedef std::pair<uint16_t, uint16_t> tpoint_pair;
+typedef std::map<tpoint_pair, std::vector<uint64_t> > latency_map;
+
+static span_map g_spans;
+static uint64_t g_span_id;
+static bool g_json_first_event = true;
+
+/* Latencies between consecutive tracepoints of an object */
+static latency_map g_step_latencies;
+/* Latencies from the first to the last tracepoint of an object */
+static latency_map g_span_latencies;
+
+static double
+get_json_ts(uint64_t tsc, uint64_t tsc_rate, uint64_t tsc_offset)
+{
+	return ((double)(tsc - tsc_offset)) * 1000 * 1000 / tsc_rate;
+}
+
+static char
+get_object_prefix(uint8_t object_type)
+{
+	char prefix = g_histories->flags.object[object_type].id_prefix;
+
+	return prefix != 0 ? prefix : 'x';
+}
+
+static std::string
+get_arg_name(const char *name, size_t max_len)
+{
+	std::string arg_name(name, strnlen(name, max_len));
+
+	/* Names are padded for the text output, e.g. "type:   " */
+	while (!arg_name.empty() && (arg_name.back() == ' ' || arg_name.back() == ':' ||
+				     arg_name.back() == '\t')) {
+		arg_name.pop_back();
+	}
+
+	return arg_name;
+}
+
 static void
-process_event(struct spdk_trace_entry *e, uint64_t tsc_rate,
+print_json_arg(uint8_t arg_type, const char *arg_name, size_t max_len, uint64_t arg)
+{
+	std::string name = get_arg_name(arg_name, max_len);
+	const char *str = (const char *)&arg;
+	size_t i;
+
+	if (name.empty()) {
+		return;
+	}
+
+	switch (arg_type) {
+	case SPDK_TRACE_ARG_TYPE_PTR:
+		printf(",\"%s\":\"0x%jx\"", name.c_str(), arg);
+		break;
+	case SPDK_TRACE_ARG_TYPE_INT:
+		printf(",\"%s\":%jd", name.c_str(), arg);
+		break;
+	case SPDK_TRACE_ARG_TYPE_STR:
+		printf(",\"%s\":\"", name.c_str());
+		for (i = 0; i < sizeof(arg) && str[i] != '\0'; i++) {
+			if (isprint(str[i]) && str[i] != '"' && str[i] != '\\') {
+				putchar(str[i]);
+			}
+		}
+		printf("\"");
+		break;
+	}
+}
+
+static void
+print_json_event(struct entry_info *info, const char *name, char phase, uint64_t span_id,
+		 uint64_t tsc_rate, uint64_t tsc_offset, uint16_t lcore)
+{
+	struct spdk_trace_entry		*e = info->entry;
+	struct spdk_trace_tpoint	*d = &g_histories->flags.tpoint[e->tpoint_id];
+	uint8_t				i;
+
+	printf("%s\n{\"name\":\"%s\",\"cat\":\"%c\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":0,\"tid\":%u",
+	       g_json_first_event ? "" : ",", name,
+	       get_object_prefix(d->object_type), phase,
+	       get_json_ts(e->tsc, tsc_rate, tsc_offset), lcore);
+	g_json_first_event = false;
+
+	if (phase == 'i') {
+		printf(",\"s\":\"t\"");
+	} else {
+		printf(",\"id\":\"0x%jx\"", span_id);
+	}
+
+	printf(",\"args\":{\"object\":\"0x%jx\"", e->object_id);
+	if (info->thread_id != 0) {
+		printf(",\"thread\":%ju", info->thread_id);
+	}
+	if (e->size != 0) {
+		printf(",\"size\":%u", e->size);
+	}
+	print_json_arg(d->arg1_type, d->arg1_name, sizeof(d->arg1_name), e->arg1);
+	for (i = 0; i < info->num_args && i + 1 < d->num_args; i++) {
+		print_json_arg(d->args[i].type, d->args[i].name, sizeof(d->args[i].name), info->args[i]);
+	}
+	printf("}}");
+}
+
+static void
+print_json_span_end(const span_info &span, uint64_t tsc_rate, uint64_t tsc_offset)
+{
+	struct spdk_trace_tpoint *d = &g_histories->flags.tpoint[span.start_tpoint];
+
+	printf(",\n{\"name\":\"%s\",\"cat\":\"%c\",\"ph\":\"e\",\"ts\":%.3f,\"pid\":0,\"tid\":%u,"
+	       "\"id\":\"0x%jx\",\"args\":{\"last\":\"%s\"}}",
+	       d->name, get_object_prefix(d->object_type),
+	       get_json_ts(span.last_tsc, tsc_rate, tsc_offset), span.lcore, span.id,
+	       g_histories->flags.tpoint[span.last_tpoint].name);
+}
+
+static void
+print_json_header(void)
+{
+	struct spdk_trace_history *history;
+	int i;
+
+	printf("{\"otherData\":{\"tsc_rate\":%ju},\"traceEvents\":[", g_tsc_rate);
+	for (i = 0; i < SPDK_TRACE_MAX_LCORE; i++) {
+		history = spdk_get_per_lcore_history(g_histories, i);
+		if (history == NULL || history->num_entries == 0) {
+			continue;
+		}
+
+		printf("%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,"
+		       "\"args\":{\"name\":\"lcore %d\"}}", g_json_first_event ? "" : ",", i, i);
+		g_json_first_event = false;
+	}
+}
+
+static void
+end_span(const span_info &span, bool complete, uint64_t tsc_rate, uint64_t tsc_offset)
+{
+	if (g_json) {
+		print_json_span_end(span, tsc_rate, tsc_offset);
+	}
+
+	/* Spans cut off by the end of the trace would skew the latencies */
+	if (g_summary && complete && span.last_tpoint != span.start_tpoint) {
+		g_span_latencies[tpoint_pair(span.start_tpoint, span.last_tpoint)].push_back(
+			span.last_tsc - span.start_tsc);
+	}
+}
+
+static void
+track_event(struct entry_info *info, uint64_t tsc_rate, uint64_t tsc_offset, uint16_t lcore)
+{
+	struct spdk_trace_entry		*e = info->entry;
+	struct spdk_trace_tpoint	*d = &g_histories->flags.tpoint[e->tpoint_id];
+	span_map::iterator		it;
+	span_info			span;
+
+	if (d->object_type == OBJECT_NONE) {
+		if (g_json) {
+			print_json_event(info, d->name, 'i', 0, tsc_rate, tsc_offset, lcore);
+		}
+		return;
+	}
+
+	it = g_spans.find(span_key(d->object_type, e->object_id));
+
+	if (d->new_object) {
+		if (it != g_spans.end()) {
+			end_span(it->second, true, tsc_rate, tsc_offset);
+			g_spans.erase(it);
+		}
+
+		span.id = g_span_id++;
+		span.start_tsc = span.last_tsc = e->tsc;
+		span.start_tpoint = span.last_tpoint = e->tpoint_id;
+		span.lcore = lcore;
+		g_spans[span_key(d->object_type, e->object_id)] = span;
+
+		if (g_json) {
+			print_json_event(info, d->name, 'b', span.id, tsc_rate, tsc_offset, lcore);
+		}
+		return;
+	}
+
+	if (it == g_spans.end()) {
+		/* The object was created before the start of the trace */
+		if (g_json) {
+			print_json_event(info, d->name, 'i', 0, tsc_rate, tsc_offset, lcore);
+		}
+		return;
+	}
+
+	if (g_json) {
+		print_json_event(info, d->name, 'n', it->second.id, tsc_rate, tsc_offset, lcore);
+	}
+
+	if (g_summary) {
+		g_step_latencies[tpoint_pair(it->second.last_tpoint, e->tpoint_id)].push_back(
+			e->tsc - it->second.last_tsc);
+	}
+
+	it->second.last_tsc = e->tsc;
+	it->second.last_tpoint = e->tpoint_id;
+}
+
+static float
+get_percentile_us(const std::vector<uint64_t> &sorted, double percentile, uint64_t tsc_rate)
+{
+	/* Nearest-rank percentile */
+	double rank = percentile * sorted.size() / 100;
+	size_t idx = (size_t)rank;
+
+	if ((double)idx == rank && idx > 0) {
+		idx--;
+	}
+	if (idx >= sorted.size()) {
+		idx = sorted.size() - 1;
+	}
+
+	return get_us_from_tsc(sorted[idx], tsc_rate);
+}
+
+static void
+print_latency_summary(const char *title, latency_map &latencies, uint64_t tsc_rate)
+{
+	latency_map::iterator it;
+	uint64_t sum;
+
+	printf("\n%s\n", title);
+	printf("%-24s %-24s %10s %10s %10s %10s %10s %10s %10s\n", "from", "to", "count",
+	       "avg (us)", "p50", "p90", "p99", "p99.9", "max");
+
+	for (it = latencies.begin(); it != latencies.end(); it++) {
+		std::vector<uint64_t> &values = it->second;
+
+		std::sort(values.begin(), values.end());
+		sum = 0;
+		for (size_t i = 0; i < values.size(); i++) {
+			sum += values[i];
+		}
+
+		printf("%-24.24s %-24.24s %10zu %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+		       g_histories->flags.tpoint[it->first.first].name,
+		       g_histories->flags.tpoint[it->first.second].name, values.size(),
+		       get_us_from_tsc(sum, tsc_rate) / values.size(),
+		       get_percentile_us(values, 50, tsc_rate),
+		       get_percentile_us(values, 90, tsc_rate),
+		       get_percentile_us(values, 99, tsc_rate),
+		       get_percentile_us(values, 99.9, tsc_rate),
+		       get_us_from_tsc(values.back(), tsc_rate));
+	}
+}
+
+static void
+process_event(struct entry_info *info, uint64_t tsc_rate,
 	      uint64_t tsc_offset, uint16_t lcore)
 {
-	if (g_verbose) {
-		print_event(e, tsc_rate, tsc_offset, lcore);
+	if (g_json || g_summary) {
+		track_event(info, tsc_rate, tsc_offset, lcore);
+	} else if (g_verbose) {
+		print_event(info, tsc_rate, tsc_offset, lcore);
 	}
 }
 
@@ -225,6 +519,8 @@ populate_events(struct spdk_trace_history *history, int num_entries)
 {
 	int i, num_entries_filled;
 	struct spdk_trace_entry *e;
+	struct entry_info *info = NULL;
+	uint64_t thread_id = 0;
 	int first, last, lcore;
 
 	lcore = history->lcore;
@@ -242,7 +538,7 @@ populate_events(struct spdk_trace_history *history, int num_entries)
 			if (e[i].tsc < e[first].tsc) {
 				first = i;
 			}
-			if (e[i].tsc > e[last].tsc) {
+			if (e[i].tsc >= e[last].tsc) {
 				last = i;
 			}
 		}
@@ -263,7 +559,23 @@ populate_events(struct spdk_trace_history *history, int num_entries)
 
 	i = first;
 	while (1) {
-		g_entry_map[entry_key(lcore, e[i].tsc)] = &e[i];
+		if (e[i].tpoint_id == SPDK_TRACE_TPOINT_THREAD) {
+			/* Following entries were recorded for this spdk_thread */
+			thread_id = e[i].object_id;
+		} else if (e[i].tpoint_id == SPDK_TRACE_TPOINT_ARGS) {
+			/* Further arguments of the preceding entry, if it was not overwritten */
+			if (info != NULL && info->num_args < SPDK_COUNTOF(info->args)) {
+				info->args[info->num_args++] = e[i].object_id;
+			}
+			if (info != NULL && info->num_args < SPDK_COUNTOF(info->args)) {
+				info->args[info->num_args++] = e[i].arg1;
+			}
+		} else if (e[i].tpoint_id < SPDK_TRACE_MAX_TPOINT_ID) {
+			info = &g_entry_map[entry_key(lcore, e[i].tsc)];
+			info->entry = &e[i];
+			info->thread_id = thread_id;
+			info->num_args = 0;
+		}
 		if (i == last) {
 			break;
 		}
@@ -283,6 +595,11 @@ static void usage(void)
 	fprintf(stderr, "        option = '-q' to disable verbose mode\n");
 	fprintf(stderr, "                 '-c' to display single lcore history\n");
 	fprintf(stderr, "                 '-t' to display TSC offset for each event\n");
+	fprintf(stderr, "                 '-j' to print the events in Chrome trace event JSON\n");
+	fprintf(stderr, "                      format, with a span from the creation of each\n");
+	fprintf(stderr, "                      object to its last event\n");
+	fprintf(stderr, "                 '-l' to print latency percentiles between the\n");
+	fprintf(stderr, "                      events of each object instead of the events\n");
 	fprintf(stderr, "                 '-s' to specify spdk_trace shm name for a\n");
 	fprintf(stderr, "                      currently running process\n");
 	fprintf(stderr, "                 '-i' to specify the shared memory ID\n");
@@ -309,7 +626,7 @@ int main(int argc, char **argv)
 	struct stat		_stat;
 
 	g_exe_name = argv[0];
-	while ((op = getopt(argc, argv, "c:f:i:p:qs:t")) != -1) {
+	while ((op = getopt(argc, argv, "c:f:i:jlp:qs:t")) != -1) {
 		switch (op) {
 		case 'c':
 			lcore = atoi(optarg);
@@ -338,6 +655,12 @@ int main(int argc, char **argv)
 		case 't':
 			g_print_tsc = true;
 			break;
+		case 'j':
+			g_json = true;
+			break;
+		case 'l':
+			g_summary = true;
+			break;
 		default:
 			usage();
 			exit(1);
@@ -350,6 +673,17 @@ int main(int argc, char **argv)
 		exit(1);
 	}
 
+	if (g_json && g_summary) {
+		fprintf(stderr, "-j and -l are mutually exclusive\n");
+		usage();
+		exit(1);
+	}
+
+	if (g_json || g_summary) {
+		/* Keep stdout parseable */
+		g_verbose = 0;
+	}
+
 	if (file_name == NULL && app_name == NULL) {
 		fprintf(stderr, "One of -f and -s must be specified\n");
 		usage();
@@ -426,7 +760,7 @@ int main(int argc, char **argv)
 	if (lcore == SPDK_TRACE_MAX_LCORE) {
 		for (i = 0; i < SPDK_TRACE_MAX_LCORE; i++) {
 			history = spdk_get_per_lcore_history(g_histories, i);
-			if (history->num_entries == 0 || history->entries[0].tsc == 0) {
+			if (history == NULL || history->num_entries == 0 || history->entries[0].tsc == 0) {
 				continue;
 			}
 
@@ -438,7 +772,7 @@ int main(int argc, char **argv)
 		}
 	} else {
 		history = spdk_get_per_lcore_history(g_histories, lcore);
-		if (history->num_entries > 0 && history->entries[0].tsc != 0) {
+		if (history != NULL && history->num_entries > 0 && history->entries[0].tsc != 0) {
 			if (g_verbose && history->num_entries) {
 				printf("Trace Size of lcore (%d): %ju\n", lcore, history->num_entries);
 			}
@@ -447,12 +781,31 @@ int main(int argc, char **argv)
 		}
 	}
 
+	if (g_json) {
+		print_json_header();
+	}
+
 	tsc_offset = g_first_tsc;
 	for (entry_map::iterator it = g_entry_map.begin(); it != g_entry_map.end(); it++) {
 		if (it->first.tsc < g_first_tsc) {
 			continue;
 		}
-		process_event(it->second, g_tsc_rate, tsc_offset, it->first.lcore);
+		process_event(&it->second, g_tsc_rate, tsc_offset, it->first.lcore);
+	}
+
+	for (span_map::iterator it = g_spans.begin(); it != g_spans.end(); it++) {
+		end_span(it->second, false, g_tsc_rate, tsc_offset);
+	}
+
+	if (g_json) {
+		printf("\n]}\n");
+	}
+
+	if (g_summary) {
+		print_latency_summary("Latency between consecutive events of an object:",
+				      g_step_latencies, g_tsc_rate);
+		print_latency_summary("Latency from the first to the last event of an object:",
+				      g_span_latencies, g_tsc_rate);
 	}
 
 	munmap(history_ptr, trace_histories_size);
@@ -41,6 +41,8 @@
 
 #define TRACE_FILE_COPY_SIZE	(32 * 1024)
 #define TRACE_PATH_MAX		2048
+#define TRACE_WRITE_BUF_SIZE	(256 * 1024)
+#define TRACE_IDLE_POLL_US	100
 
 static char *g_exe_name;
 static int g_verbose = 1;
@@ -64,6 +66,13 @@ struct lcore_trace_record_ctx {
 
 	/* Total number of entries in lcore trace file */
 	uint64_t num_entries;
+
+	/* Number of entries overwritten in shm before they could be recorded */
+	uint64_t missed_entries;
+
+	/* Entries not yet written to the lcore trace file */
+	char *write_buf;
+	size_t write_len;
 };
 
 struct aggr_trace_record_ctx {
@@ -74,6 +83,8 @@ struct aggr_trace_record_ctx {
 	struct spdk_trace_histories *trace_histories;
 };
 
+static struct aggr_trace_record_ctx g_ctx;
+
 static int
 input_trace_file_mmap(struct aggr_trace_record_ctx *ctx, const char *shm_name)
 {
@@ -123,6 +134,9 @@ input_trace_file_mmap(struct aggr_trace_record_ctx *ctx, const char *shm_name)
 	ctx->trace_histories = (struct spdk_trace_histories *)history_ptr;
 	for (i = 0; i < SPDK_TRACE_MAX_LCORE; i++) {
 		ctx->lcore_ports[i].in_history = spdk_get_per_lcore_history(ctx->trace_histories, i);
+		if (ctx->lcore_ports[i].in_history == NULL) {
+			continue;
+		}
 
 		if (g_verbose) {
 			printf("Number of trace entries for lcore (%d): %ju\n", i,
@@ -176,6 +190,9 @@ output_trace_files_prepare(struct aggr_trace_record_ctx *ctx, const char *aggr_p
 
 	for (i = 0; i < SPDK_TRACE_MAX_LCORE; i++) {
 		port_ctx = &ctx->lcore_ports[i];
+		if (port_ctx->in_history == NULL) {
+			continue;
+		}
 
 		port_ctx->fd = open(port_ctx->lcore_file, flags, 0600);
 		if (port_ctx->fd < 0) {
@@ -192,6 +209,12 @@ output_trace_files_prepare(struct aggr_trace_record_ctx *ctx, const char *aggr_p
 			fprintf(stderr, "Failed to allocate memory for out_history.\n");
 			goto err;
 		}
+
+		port_ctx->write_buf = malloc(TRACE_WRITE_BUF_SIZE);
+		if (port_ctx->write_buf == NULL) {
+			fprintf(stderr, "Failed to allocate memory for write buffer.\n");
+			goto err;
+		}
 	}
 
 	return 0;
@@ -200,6 +223,7 @@ err:
 	for (i = 0; i < SPDK_TRACE_MAX_LCORE; i++) {
 		port_ctx = &ctx->lcore_ports[i];
 		free(port_ctx->out_history);
+		free(port_ctx->write_buf);
 
 		if (port_ctx->fd > 0) {
 			close(port_ctx->fd);
@@ -217,8 +241,12 @@ output_trace_files_finish(struct aggr_trace_record_ctx *ctx)
 
 	for (i = 0; i < SPDK_TRACE_MAX_LCORE; i++) {
 		port_ctx = &ctx->lcore_ports[i];
+		if (port_ctx->in_history == NULL) {
+			continue;
+		}
 
 		free(port_ctx->out_history);
+		free(port_ctx->write_buf);
 		close(port_ctx->fd);
 		unlink(port_ctx->lcore_file);
 
@@ -274,6 +302,51 @@ cont_read(int fildes, void *buf, size_t nbyte)
 	return nbyte;
 }
 
+/*
+ * Entries are staged in a per-lcore buffer and written out in large chunks,
+ *  so that the recorder keeps up with busy lcores without a syscall per poll.
+ */
+static int
+lcore_trace_flush(struct lcore_trace_record_ctx *lcore_port)
+{
+	int rc;
+
+	if (lcore_port->write_len == 0) {
+		return 0;
+	}
+
+	rc = cont_write(lcore_port->fd, lcore_port->write_buf, lcore_port->write_len);
+	if (rc < 0) {
+		fprintf(stderr, "Failed to append entries into lcore file\n");
+		return rc;
+	}
+
+	lcore_port->write_len = 0;
+	return 0;
+}
+
+static int
+lcore_trace_append(struct lcore_trace_record_ctx *lcore_port, const void *buf, size_t nbyte)
+{
+	int rc;
+
+	if (lcore_port->write_len + nbyte > TRACE_WRITE_BUF_SIZE) {
+		rc = lcore_trace_flush(lcore_port);
+		if (rc < 0) {
+			return rc;
+		}
+
+		if (nbyte > TRACE_WRITE_BUF_SIZE) {
+			return cont_write(lcore_port->fd, buf, nbyte);
+		}
+	}
+
+	memcpy(lcore_port->write_buf + lcore_port->write_len, buf, nbyte);
+	lcore_port->write_len += nbyte;
+
+	return nbyte;
+}
+
 static int
 lcore_trace_last_entry_idx(struct spdk_trace_history *in_history, int cir_next_idx)
 {
@@ -289,8 +362,8 @@ lcore_trace_last_entry_idx(struct spdk_trace_history *in_history, int cir_next_i
 }
 
 static int
-circular_buffer_padding_backward(int fd, struct spdk_trace_history *in_history,
-				 int cir_start, int cir_end)
+circular_buffer_padding_backward(struct lcore_trace_record_ctx *lcore_port,
+				 struct spdk_trace_history *in_history, int cir_start, int cir_end)
 {
 	int rc;
 
@@ -299,7 +372,7 @@ circular_buffer_padding_backward(int fd, struct spdk_trace_history *in_history,
 		return -1;
 	}
 
-	rc = cont_write(fd, &in_history->entries[cir_start],
+	rc = lcore_trace_append(lcore_port, &in_history->entries[cir_start],
 			sizeof(struct spdk_trace_entry) * (cir_end - cir_start));
 	if (rc < 0) {
 		fprintf(stderr, "Failed to append entries into lcore file\n");
@@ -310,8 +383,8 @@ circular_buffer_padding_backward(int fd, struct spdk_trace_history *in_history,
 }
 
 static int
-circular_buffer_padding_across(int fd, struct spdk_trace_history *in_history,
-			       int cir_start, int cir_end)
+circular_buffer_padding_across(struct lcore_trace_record_ctx *lcore_port,
+			       struct spdk_trace_history *in_history, int cir_start, int cir_end)
 {
 	int rc;
 	int num_entries = in_history->num_entries;
@@ -321,7 +394,7 @@ circular_buffer_padding_across(int fd, struct spdk_trace_history *in_history,
 		return -1;
 	}
 
-	rc = cont_write(fd, &in_history->entries[cir_start],
+	rc = lcore_trace_append(lcore_port, &in_history->entries[cir_start],
 			sizeof(struct spdk_trace_entry) * (num_entries - cir_start));
 	if (rc < 0) {
 		fprintf(stderr, "Failed to append entries into lcore file backward\n");
@@ -332,7 +405,7 @@ circular_buffer_padding_across(int fd, struct spdk_trace_history *in_history,
 		return 0;
 	}
 
-	rc = cont_write(fd, &in_history->entries[0], sizeof(struct spdk_trace_entry) * cir_end);
+	rc = lcore_trace_append(lcore_port, &in_history->entries[0], sizeof(struct spdk_trace_entry) * cir_end);
 	if (rc < 0) {
 		fprintf(stderr, "Failed to append entries into lcore file forward\n");
 		return rc;
@@ -342,10 +415,10 @@ circular_buffer_padding_across(int fd, struct spdk_trace_history *in_history,
 }
 
 static int
-circular_buffer_padding_all(int fd, struct spdk_trace_history *in_history,
-			    int cir_end)
+circular_buffer_padding_all(struct lcore_trace_record_ctx *lcore_port,
+			    struct spdk_trace_history *in_history, int cir_end)
 {
-	return circular_buffer_padding_across(fd, in_history, cir_end, cir_end);
+	return circular_buffer_padding_across(lcore_port, in_history, cir_end, cir_end);
 }
 
 static int
@@ -354,7 +427,6 @@ lcore_trace_record(struct lcore_trace_record_ctx *lcore_port)
 	struct spdk_trace_history	*in_history = lcore_port->in_history;
 	uint64_t			rec_next_entry = lcore_port->rec_next_entry;
 	uint64_t			rec_num_entries = lcore_port->num_entries;
-	int				fd = lcore_port->fd;
 	uint64_t			shm_next_entry;
 	uint64_t			num_cir_entries;
 	uint64_t			shm_cir_next;
@@ -390,7 +462,7 @@ lcore_trace_record(struct lcore_trace_record_ctx *lcore_port)
 			lcore_port->first_entry_tsc = in_history->entries[0].tsc;
 
 			lcore_port->num_entries += shm_cir_next;
-			rc = circular_buffer_padding_backward(fd, in_history, 0, shm_cir_next);
+			rc = circular_buffer_padding_backward(lcore_port, in_history, 0, shm_cir_next);
 		} else {
 			/* Updates have already been across circular buffer.
 			 * The eldest entry in shared memory is pointed by shm_cir_next.
@@ -398,7 +470,7 @@ lcore_trace_record(struct lcore_trace_record_ctx *lcore_port)
 			lcore_port->first_entry_tsc = in_history->entries[shm_cir_next].tsc;
 
 			lcore_port->num_entries += num_cir_entries;
-			rc = circular_buffer_padding_all(fd, in_history, shm_cir_next);
+			rc = circular_buffer_padding_all(lcore_port, in_history, shm_cir_next);
 		}
 
 		goto out;
@@ -406,15 +478,18 @@ lcore_trace_record(struct lcore_trace_record_ctx *lcore_port)
 
 	if (shm_next_entry - rec_next_entry > num_cir_entries) {
 		/* There must be missed updates */
-		fprintf(stderr, "Trace-record missed %ju trace entries\n",
-			shm_next_entry - rec_next_entry - num_cir_entries);
+		lcore_port->missed_entries += shm_next_entry - rec_next_entry - num_cir_entries;
+		if (g_verbose) {
+			fprintf(stderr, "Trace-record missed %ju trace entries for lcore %d\n",
+				shm_next_entry - rec_next_entry - num_cir_entries, in_history->lcore);
+		}
 
 		lcore_port->num_entries += num_cir_entries;
-		rc = circular_buffer_padding_all(fd, in_history, shm_cir_next);
+		rc = circular_buffer_padding_all(lcore_port, in_history, shm_cir_next);
 	} else if (shm_next_entry - rec_next_entry == num_cir_entries) {
 		/* All circular buffer is updated */
 		lcore_port->num_entries += num_cir_entries;
-		rc = circular_buffer_padding_all(fd, in_history, shm_cir_next);
+		rc = circular_buffer_padding_all(lcore_port, in_history, shm_cir_next);
 	} else {
 		/* Part of circular buffer is updated */
 		rec_cir_next = rec_next_entry & (num_cir_entries - 1);
@@ -422,11 +497,11 @@ lcore_trace_record(struct lcore_trace_record_ctx *lcore_port)
 		if (shm_cir_next > rec_cir_next) {
 			/* Updates are not across circular buffer */
 			lcore_port->num_entries += shm_cir_next - rec_cir_next;
-			rc = circular_buffer_padding_backward(fd, in_history, rec_cir_next, shm_cir_next);
+			rc = circular_buffer_padding_backward(lcore_port, in_history, rec_cir_next, shm_cir_next);
 		} else {
 			/* Updates are across circular buffer */
 			lcore_port->num_entries += num_cir_entries - rec_cir_next + shm_cir_next;
-			rc = circular_buffer_padding_across(fd, in_history, rec_cir_next, shm_cir_next);
+			rc = circular_buffer_padding_across(lcore_port, in_history, rec_cir_next, shm_cir_next);
 		}
 	}
 
@@ -480,12 +555,18 @@ trace_files_aggregate(struct aggr_trace_record_ctx *ctx)
 		goto out;
 	}
 
-	/* Update and append lcore offsets converged trace file */
-	lcore_offsets[0] = sizeof(struct spdk_trace_flags);
-	for (i = 1; i < (int)SPDK_COUNTOF(lcore_offsets); i++) {
-		lcore_offsets[i] = spdk_get_trace_history_size(ctx->lcore_ports[i - 1].num_entries) +
-				   lcore_offsets[i - 1];
+	/* Update and append lcore offsets converged trace file, lcores without history keep 0 */
+	memset(lcore_offsets, 0, sizeof(lcore_offsets));
+	len_sum = sizeof(struct spdk_trace_flags);
+	for (i = 0; i < SPDK_TRACE_MAX_LCORE; i++) {
+		if (ctx->lcore_ports[i].in_history == NULL) {
+			continue;
+		}
+
+		lcore_offsets[i] = len_sum;
+		len_sum += spdk_get_trace_history_size(ctx->lcore_ports[i].num_entries);
 	}
+	lcore_offsets[SPDK_TRACE_MAX_LCORE] = len_sum;
 
 	rc = cont_write(ctx->out_fd, lcore_offsets, sizeof(lcore_offsets));
 	if (rc < 0) {
@@ -496,6 +577,14 @@ trace_files_aggregate(struct aggr_trace_record_ctx *ctx)
 	/* Append each lcore trace file into converged trace file */
 	for (i = 0; i < SPDK_TRACE_MAX_LCORE; i++) {
 		lcore_port = &ctx->lcore_ports[i];
+		if (lcore_port->in_history == NULL) {
+			continue;
+		}
+
+		rc = lcore_trace_flush(lcore_port);
+		if (rc < 0) {
+			goto out;
+		}
 
 		lcore_port->out_history->num_entries = lcore_port->num_entries;
 		rc = cont_write(ctx->out_fd, lcore_port->out_history, sizeof(struct spdk_trace_history));
@@ -591,8 +680,10 @@ int main(int argc, char **argv)
 	int				shm_id = -1, shm_pid = -1;
 	int				rc = 0;
 	int				i;
-	struct aggr_trace_record_ctx	ctx = {};
+	struct aggr_trace_record_ctx	*ctx = &g_ctx;
 	struct lcore_trace_record_ctx	*lcore_port;
+	uint64_t			rec_next_entry;
+	bool				updated;
 
 	g_exe_name = argv[0];
 	while ((op = getopt(argc, argv, "f:i:p:qs:h")) != -1) {
@@ -648,25 +739,37 @@ int main(int argc, char **argv)
 		exit(1);
 	}
 
-	rc = input_trace_file_mmap(&ctx, shm_name);
+	rc = input_trace_file_mmap(ctx, shm_name);
 	if (rc) {
 		exit(1);
 	}
 
-	rc = output_trace_files_prepare(&ctx, file_name);
+	rc = output_trace_files_prepare(ctx, file_name);
 	if (rc) {
 		exit(1);
 	}
 
 	printf("Start to poll trace shm file %s\n", shm_name);
 	while (!g_shutdown && rc == 0) {
+		updated = false;
 		for (i = 0; i < SPDK_TRACE_MAX_LCORE; i++) {
-			lcore_port = &ctx.lcore_ports[i];
+			lcore_port = &ctx->lcore_ports[i];
+			if (lcore_port->in_history == NULL) {
+				continue;
+			}
 
+			rec_next_entry = lcore_port->rec_next_entry;
 			rc = lcore_trace_record(lcore_port);
 			if (rc) {
 				break;
 			}
+
+			updated |= lcore_port->rec_next_entry != rec_next_entry;
+		}
+
+		/* Back off briefly when no lcore recorded anything since the last pass */
+		if (!updated && rc == 0) {
+			usleep(TRACE_IDLE_POLL_US);
 		}
 	}
 
@@ -675,7 +778,7 @@ int main(int argc, char **argv)
 	}
 
 	printf("Start to aggregate lcore trace files\n");
-	rc = trace_files_aggregate(&ctx);
+	rc = trace_files_aggregate(ctx);
 	if (rc) {
 		exit(1);
 	}
@@ -683,7 +786,7 @@ int main(int argc, char **argv)
 	/* Summary report */
 	printf("TSC Rate: %ju\n", g_tsc_rate);
 	for (i = 0; i < SPDK_TRACE_MAX_LCORE; i++) {
-		lcore_port = &ctx.lcore_ports[i];
+		lcore_port = &ctx->lcore_ports[i];
 
 		if (lcore_port->num_entries == 0) {
 			continue;
@@ -692,13 +795,16 @@ int main(int argc, char **argv)
 		printf("Port %ju trace entries for lcore (%d) in %ju usec\n",
 		       lcore_port->num_entries, i,
 		       (lcore_port->last_entry_tsc - lcore_port->first_entry_tsc) / g_utsc_rate);
+		if (lcore_port->missed_entries) {
+			printf("Missed %ju trace entries for lcore (%d)\n", lcore_port->missed_entries, i);
+		}
 
 	}
 
-	munmap(ctx.trace_histories, g_histories_size);
-	close(ctx.shm_fd);
+	munmap(ctx->trace_histories, g_histories_size);
+	close(ctx->shm_fd);
 
-	output_trace_files_finish(&ctx);
+	output_trace_files_finish(ctx);
 
 	return 0;
 }
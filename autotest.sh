@@ -283,6 +283,7 @@ if [ $SPDK_RUN_FUNCTIONAL_TEST -eq 1 ]; then
         if [ $SPDK_TEST_REDUCE -eq 1 ]; then
                 run_test "compress_qat" ./test/compress/compress.sh "qat"
                 run_test "compress_isal" ./test/compress/compress.sh "isal"
+                run_test "compress_sw" ./test/compress/compress.sh "sw"
         fi
 
 	if [ $SPDK_TEST_OPAL -eq 1 ]; then
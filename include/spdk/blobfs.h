@@ -218,6 +218,16 @@ int spdk_fs_file_stat(struct spdk_filesystem *fs, struct spdk_fs_thread_ctx *ctx
 
 #define SPDK_BLOBFS_OPEN_CREATE	(1ULL << 0)
 
+/**
+ * Open the file for direct I/O.
+ *
+ * Large sequential writes that are aligned to the blobstore io unit size are
+ * written straight to the underlying blob instead of being staged in the
+ * cache buffers. Small or unaligned writes still go through the cache. See
+ * spdk_file_write() for the requirements on the payload.
+ */
+#define SPDK_BLOBFS_OPEN_DIRECT	(1ULL << 1)
+
 /**
  * Create a new file on the given blobstore filesystem.
  *
@@ -335,6 +345,13 @@ uint64_t spdk_file_get_length(struct spdk_file *file);
 /**
  * Write data to the given file.
  *
+ * If the file was opened with SPDK_BLOBFS_OPEN_DIRECT, nothing is cached for
+ * the file yet, and offset and length are both aligned to the blobstore io
+ * unit size with length of at least 128 KiB, the data is written directly to
+ * the blob and this function returns once the write completes. In that case
+ * the payload must be allocated with spdk_malloc() or spdk_zmalloc() using
+ * SPDK_MALLOC_DMA.
+ *
  * \param file File to write.
  * \param ctx The thread context for this operation
  * \param payload The specified buffer which should contain the data to be transmitted.
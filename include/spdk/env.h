@@ -1216,6 +1216,25 @@ int spdk_mem_map_clear_translation(struct spdk_mem_map *map, uint64_t vaddr, uin
  */
 uint64_t spdk_mem_map_translate(const struct spdk_mem_map *map, uint64_t vaddr, uint64_t *size);
 
+/**
+ * Look up the translations of the buffers of an I/O vector in a memory map.
+ *
+ * Translation stops at the first buffer that is not covered by a single
+ * translation, i.e. that spans non-contiguous regions of the map.
+ *
+ * \param map Memory map.
+ * \param iov I/O vector to translate.
+ * \param iovcnt Number of elements in iov.
+ * \param translations Array of at least iovcnt elements that is filled with
+ * the translation of the start address of each buffer.
+ *
+ * \return the number of leading buffers of iov that are fully covered by their
+ * translation. The translation of the buffer at the returned index, if lower
+ * than iovcnt, is valid only for part of the buffer.
+ */
+int spdk_mem_map_translate_iov(const struct spdk_mem_map *map, const struct iovec *iov,
+			       int iovcnt, uint64_t *translations);
+
 /**
  * Register the specified memory region for address translation.
  *
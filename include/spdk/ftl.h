@@ -93,6 +93,12 @@ struct spdk_ftl_conf {
 	/* Use append instead of write */
 	bool					use_append;
 
+	/*
+	 * Write frequently updated user data, rarely updated user data and relocated data
+	 * through separate bands
+	 */
+	bool					hot_cold_separation;
+
 	/* Maximum supported number of IO channels */
 	uint32_t				max_io_channels;
 
@@ -105,6 +111,15 @@ struct spdk_ftl_conf {
 
 	/* Create l2p table on l2p_path persistent memory file or device instead of in DRAM */
 	const char				*l2p_path;
+
+	/*
+	 * Maximum amount of DRAM (in bytes) used by the l2p table. If non-zero, the table is kept
+	 * on l2p_bdev and only the most recently used parts of it are loaded into memory.
+	 */
+	size_t					l2p_dram_limit;
+
+	/* Name of the bdev storing the l2p table when its memory usage is limited */
+	const char				*l2p_bdev;
 };
 
 enum spdk_ftl_mode {
@@ -154,6 +154,72 @@ int spdk_json_decode_uint32(const struct spdk_json_val *val, void *out);
 int spdk_json_decode_uint64(const struct spdk_json_val *val, void *out);
 int spdk_json_decode_string(const struct spdk_json_val *val, void *out);
 
+/**
+ * Memory arena used to hold decoded values.
+ *
+ * Allocations are carved out of large chunks and are released all at once by
+ * spdk_json_arena_reset() or spdk_json_arena_free().
+ */
+struct spdk_json_arena;
+
+/**
+ * Create a memory arena for decoded values.
+ *
+ * \param chunk_size Size in bytes of each chunk of memory allocated by the arena.
+ * Pass 0 to use the default size. Allocations larger than chunk_size get a chunk
+ * of their own.
+ *
+ * \return the new arena or NULL on failure.
+ */
+struct spdk_json_arena *spdk_json_arena_create(size_t chunk_size);
+
+/**
+ * Allocate memory from an arena.
+ *
+ * The memory is aligned to 8 bytes and remains valid until the arena is reset or freed.
+ *
+ * \param arena Arena to allocate from.
+ * \param size Number of bytes to allocate.
+ *
+ * \return pointer to the memory or NULL on failure.
+ */
+void *spdk_json_arena_alloc(struct spdk_json_arena *arena, size_t size);
+
+/**
+ * Release all allocations made from an arena while keeping its memory for reuse.
+ *
+ * \param arena Arena to reset.
+ */
+void spdk_json_arena_reset(struct spdk_json_arena *arena);
+
+/**
+ * Free an arena and all memory allocated from it.
+ *
+ * \param arena Arena to free.
+ */
+void spdk_json_arena_free(struct spdk_json_arena *arena);
+
+/**
+ * Decode a JSON object, allocating decoded strings from an arena.
+ *
+ * This is the same as spdk_json_decode_object(), except that spdk_json_decode_string()
+ * (including calls made from nested spdk_json_decode_object() and spdk_json_decode_array())
+ * copies strings into the arena instead of allocating each of them with malloc().
+ * String fields in out must be NULL or already point into the arena, and must not be
+ * passed to free(); they are released by spdk_json_arena_reset() or spdk_json_arena_free().
+ *
+ * \param values Parsed JSON object to decode.
+ * \param decoders Array of decoders for the object members.
+ * \param num_decoders Number of entries in decoders.
+ * \param out Structure to decode into.
+ * \param arena Arena to allocate decoded strings from.
+ *
+ * \return 0 on success or -1 on failure.
+ */
+int spdk_json_decode_object_arena(const struct spdk_json_val *values,
+				  const struct spdk_json_object_decoder *decoders, size_t num_decoders,
+				  void *out, struct spdk_json_arena *arena);
+
 /**
  * Get length of a value in number of values.
  *
@@ -198,6 +198,19 @@ struct spdk_json_write_ctx *spdk_jsonrpc_begin_result(struct spdk_jsonrpc_reques
  */
 void spdk_jsonrpc_end_result(struct spdk_jsonrpc_request *request, struct spdk_json_write_ctx *w);
 
+/**
+ * Get the length of the part of a response that is written, but not sent yet.
+ *
+ * Large responses are sent while they are being written. Handlers that write
+ * a large response over several polls can use this to wait for the client to
+ * receive the data written so far.
+ *
+ * \param request Request with a response in progress.
+ *
+ * \return the number of bytes waiting to be sent.
+ */
+size_t spdk_jsonrpc_get_unsent_len(struct spdk_jsonrpc_request *request);
+
 /**
  * Send an error response to a JSON-RPC request.
  *
@@ -84,6 +84,7 @@ struct spdk_nvmf_transport_opts {
 	bool		c2h_success;
 	bool		dif_insert_or_strip;
 	uint32_t	sock_priority;
+	uint32_t	sock_busy_poll;
 };
 
 struct spdk_nvmf_poll_group_stat {
@@ -111,6 +112,13 @@ struct spdk_nvmf_transport_poll_group_stat {
 			uint64_t num_devices;
 			struct spdk_nvmf_rdma_device_stat *devices;
 		} rdma;
+		struct {
+			uint64_t placement_hits;
+			uint64_t placement_misses;
+			uint64_t no_placement_id;
+			uint64_t pdus_sent;
+			uint64_t sends;
+		} tcp;
 	};
 };
 
@@ -443,6 +451,42 @@ int spdk_nvmf_subsystem_resume(struct spdk_nvmf_subsystem *subsystem,
 			       spdk_nvmf_subsystem_state_change_done cb_fn,
 			       void *cb_arg);
 
+/**
+ * Pause a single namespace of an active NVMe-oF subsystem.
+ *
+ * I/O to the namespace is held on every poll group and the callback is called
+ * once all of its outstanding I/O has completed. The rest of the subsystem keeps
+ * processing I/O. While paused, the namespace may be added with
+ * spdk_nvmf_subsystem_add_ns() or removed with spdk_nvmf_subsystem_remove_ns().
+ * Only namespace IDs up to the current maximum NSID of the subsystem can be paused.
+ *
+ * \param subsystem The NVMe-oF subsystem.
+ * \param nsid The namespace ID to pause. It doesn't need to be allocated.
+ * \param cb_fn A function that will be called once the namespace is paused.
+ * \param cb_arg Argument passed to cb_fn.
+ *
+ * \return 0 on success, or negated errno on failure. The callback provided will only
+ * be called on success.
+ */
+int spdk_nvmf_subsystem_pause_ns(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+				 spdk_nvmf_subsystem_state_change_done cb_fn,
+				 void *cb_arg);
+
+/**
+ * Resume a namespace paused by spdk_nvmf_subsystem_pause_ns().
+ *
+ * \param subsystem The NVMe-oF subsystem.
+ * \param nsid The namespace ID to resume.
+ * \param cb_fn A function that will be called once the namespace is resumed.
+ * \param cb_arg Argument passed to cb_fn.
+ *
+ * \return 0 on success, or negated errno on failure. The callback provided will only
+ * be called on success.
+ */
+int spdk_nvmf_subsystem_resume_ns(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+				  spdk_nvmf_subsystem_state_change_done cb_fn,
+				  void *cb_arg);
+
 /**
  * Search the target for a subsystem with the given NQN.
  *
@@ -705,7 +749,8 @@ void spdk_nvmf_ns_opts_get_defaults(struct spdk_nvmf_ns_opts *opts, size_t opts_
 /**
  * Add a namespace to a subsytem.
  *
- * May only be performed on subsystems in the PAUSED or INACTIVE states.
+ * May only be performed on subsystems in the PAUSED or INACTIVE states, or on
+ * an active subsystem when opts->nsid was paused with spdk_nvmf_subsystem_pause_ns().
  *
  * \param subsystem Subsystem to add namespace to.
  * \param bdev Block device to add as a namespace.
@@ -722,7 +767,8 @@ uint32_t spdk_nvmf_subsystem_add_ns(struct spdk_nvmf_subsystem *subsystem, struc
 /**
  * Remove a namespace from a subsytem.
  *
- * May only be performed on subsystems in the PAUSED or INACTIVE states.
+ * May only be performed on subsystems in the PAUSED or INACTIVE states, or on
+ * an active subsystem when nsid was paused with spdk_nvmf_subsystem_pause_ns().
  *
  * \param subsystem Subsystem the namespace belong to.
  * \param nsid Namespace ID to be removed.
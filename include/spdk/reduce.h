@@ -81,6 +81,16 @@ struct spdk_reduce_vol_params {
 	 *  of the chunk size.
 	 */
 	uint64_t		vol_size;
+
+	/**
+	 * Compression backend and level used by the owner of the
+	 *  volume.  libreduce doesn't interpret them, it only
+	 *  persists them with the rest of the parameters so that
+	 *  they're restored when the volume is loaded.  0 in
+	 *  comp_backend means that neither was set.
+	 */
+	uint32_t		comp_backend;
+	uint32_t		comp_level;
 };
 
 struct spdk_reduce_vol;
@@ -232,6 +242,22 @@ void spdk_reduce_vol_writev(struct spdk_reduce_vol *vol,
 			    struct iovec *iov, int iovcnt, uint64_t offset, uint64_t length,
 			    spdk_reduce_vol_op_complete cb_fn, void *cb_arg);
 
+/**
+ * Set the size of the decompressed chunk cache for a libreduce compressed volume.
+ *
+ * Reads that hit a cached chunk are served without reading or decompressing it,
+ * and partial writes to a cached chunk skip the read-modify-write read step.
+ * The cache is disabled by default.  Any previously cached chunks are dropped.
+ * This must be called from the thread that submits I/O to the volume.
+ *
+ * \param vol Previously loaded or initialized compressed volume.
+ * \param size Size of the cache in bytes.  It is rounded down to a multiple of
+ * the chunk size; 0 disables the cache.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_reduce_vol_set_cache_size(struct spdk_reduce_vol *vol, uint64_t size);
+
 /**
  * Get the params structure for a libreduce compressed volume.
  *
@@ -149,9 +149,12 @@ int spdk_sock_close(struct spdk_sock **sock);
 /**
  * Flush a socket from data gathered in previous writev_async calls.
  *
+ * Some implementations, e.g. uring, send the data of sockets that are in a
+ * sock group only when the group is polled. The flush sends nothing for them.
+ *
  * \param sock Socket to flush.
  *
- * \return 0 on success, -1 on failure.
+ * \return number of bytes sent on success, 0 if nothing could be sent, -1 on failure.
  */
 int spdk_sock_flush(struct spdk_sock *sock);
 
@@ -227,6 +230,20 @@ int spdk_sock_set_recvbuf(struct spdk_sock *sock, int sz);
  */
 int spdk_sock_set_priority(struct spdk_sock *sock, int priority);
 
+/**
+ * Enable busy polling of the NIC receive queue for the given socket.
+ *
+ * A receive on a socket with busy polling enabled that finds no data polls the
+ * NIC receive queue the socket's packets arrive on for up to \c usec microseconds
+ * instead of waiting for an interrupt.
+ *
+ * \param sock Socket to set busy polling for.
+ * \param usec Time to busy poll for in microseconds. 0 disables busy polling.
+ *
+ * \return 0 on success, -1 on failure with errno set.
+ */
+int spdk_sock_set_busy_poll(struct spdk_sock *sock, int usec);
+
 /**
  * Set send buffer size for the given socket.
  *
@@ -237,6 +254,16 @@ int spdk_sock_set_priority(struct spdk_sock *sock, int priority);
  */
 int spdk_sock_set_sendbuf(struct spdk_sock *sock, int sz);
 
+/**
+ * Get the send buffer size of the given socket.
+ *
+ * \param sock Socket to get the buffer size of.
+ * \param sz Buffer size in bytes, as reported by the kernel.
+ *
+ * \return 0 on success, -1 on failure with errno set.
+ */
+int spdk_sock_get_sendbuf(struct spdk_sock *sock, int *sz);
+
 /**
  * Check whether the address of socket is ipv6.
  *
@@ -344,12 +371,20 @@ int spdk_sock_group_close(struct spdk_sock_group **group);
 /**
  * Get the optimal sock group for this sock.
  *
+ * The optimal sock group is the one already serving sockets that receive on the
+ * same NIC receive queue (identified by the placement ID reported by the socket
+ * implementation, e.g. SO_INCOMING_NAPI_ID).
+ *
  * \param sock The socket
  * \param group Returns the optimal sock group. If there is no optimal sock group, returns NULL.
+ * \param hint If no sock group serves the socket's placement ID yet, this group
+ * is assigned to it and returned. The assignment is kept until the socket is
+ * added to a sock group or closed. May be NULL.
  *
- * \return 0 on success. Negated errno on failure.
+ * \return 0 on success. Negated errno on failure, e.g. if the socket has no placement ID.
  */
-int spdk_sock_get_optimal_sock_group(struct spdk_sock *sock, struct spdk_sock_group **group);
+int spdk_sock_get_optimal_sock_group(struct spdk_sock *sock, struct spdk_sock_group **group,
+				     struct spdk_sock_group *hint);
 
 #ifdef __cplusplus
 }
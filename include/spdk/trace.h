@@ -56,6 +56,9 @@ struct spdk_trace_entry {
 	uint64_t	arg1;
 };
 
+/* Number of arguments carried by each SPDK_TRACE_TPOINT_ARGS entry */
+#define SPDK_TRACE_ENTRY_EXTRA_ARGS	2
+
 /* If type changes from a uint8_t, change this value. */
 #define SPDK_TRACE_MAX_OWNER (UCHAR_MAX + 1)
 
@@ -76,10 +79,30 @@ struct spdk_trace_object {
 #define SPDK_TRACE_MAX_TPOINT_ID (SPDK_TRACE_MAX_GROUP_ID * 64)
 #define SPDK_TPOINT_ID(group, tpoint)	((group * 64) + tpoint)
 
+/*
+ * Entries with the following tpoint IDs are not tracepoints on their own.
+ *
+ * SPDK_TRACE_TPOINT_ARGS entries follow a tracepoint entry recorded with more
+ *  than one argument and carry SPDK_TRACE_ENTRY_EXTRA_ARGS further arguments
+ *  in object_id and arg1.
+ *
+ * SPDK_TRACE_TPOINT_THREAD entries precede the entries recorded by the spdk_thread
+ *  with the ID in object_id, until the next SPDK_TRACE_TPOINT_THREAD entry.
+ */
+#define SPDK_TRACE_TPOINT_ARGS		(SPDK_TRACE_MAX_TPOINT_ID)
+#define SPDK_TRACE_TPOINT_THREAD	(SPDK_TRACE_MAX_TPOINT_ID + 1)
+
 #define SPDK_TRACE_ARG_TYPE_INT 0
 #define SPDK_TRACE_ARG_TYPE_PTR 1
 #define SPDK_TRACE_ARG_TYPE_STR 2
 
+#define SPDK_TRACE_MAX_ARGS_COUNT	(1 + 2 * SPDK_TRACE_ENTRY_EXTRA_ARGS)
+
+struct spdk_trace_argument {
+	char		name[8];
+	uint8_t		type;
+};
+
 struct spdk_trace_tpoint {
 	char		name[24];
 	uint16_t	tpoint_id;
@@ -87,8 +110,11 @@ struct spdk_trace_tpoint {
 	uint8_t		object_type;
 	uint8_t		new_object;
 	uint8_t		arg1_type;
-	uint8_t		reserved;
+	/** Number of arguments, including arg1 */
+	uint8_t		num_args;
 	char		arg1_name[8];
+	/** Arguments recorded after arg1 */
+	struct spdk_trace_argument	args[SPDK_TRACE_MAX_ARGS_COUNT - 1];
 };
 
 struct spdk_trace_history {
@@ -108,6 +134,12 @@ struct spdk_trace_history {
 	/** Index to next spdk_trace_entry to fill. */
 	uint64_t			next_entry;
 
+	/** ID of the spdk_thread the last entry was recorded for, 0 for none. */
+	uint64_t			thread_id;
+
+	/** Index of the last SPDK_TRACE_TPOINT_THREAD entry. */
+	uint64_t			thread_entry;
+
 	/**
 	 * Circular buffer of spdk_trace_entry structures for tracing
 	 *  tpoints on this core.  Debug tool spdk_trace reads this
@@ -117,7 +149,7 @@ struct spdk_trace_history {
 	struct spdk_trace_entry		entries[0];
 };
 
-#define SPDK_TRACE_MAX_LCORE		128
+#define SPDK_TRACE_MAX_LCORE		1024
 
 struct spdk_trace_flags {
 	uint64_t			tsc_rate;
@@ -127,7 +159,8 @@ struct spdk_trace_flags {
 	struct spdk_trace_tpoint	tpoint[SPDK_TRACE_MAX_TPOINT_ID];
 
 	/** Offset of each trace_history from the beginning of this data structure.
-	 * The last one is the offset of the file end.
+	 * The last one is the offset of the file end. Lcores without a trace_history
+	 * have an offset of 0.
 	 */
 	uint64_t			lcore_history_offsets[SPDK_TRACE_MAX_LCORE + 1];
 };
@@ -159,6 +192,14 @@ spdk_get_trace_histories_size(struct spdk_trace_histories *trace_histories)
 	return trace_histories->flags.lcore_history_offsets[SPDK_TRACE_MAX_LCORE];
 }
 
+/**
+ * Get the trace history of an lcore.
+ *
+ * \param trace_histories Trace histories.
+ * \param lcore Lcore to get the history of.
+ *
+ * \return the trace history of the lcore, or NULL if the lcore has no trace history.
+ */
 static inline struct spdk_trace_history *
 spdk_get_per_lcore_history(struct spdk_trace_histories *trace_histories, unsigned lcore)
 {
@@ -168,6 +209,10 @@ spdk_get_per_lcore_history(struct spdk_trace_histories *trace_histories, unsigne
 		return NULL;
 	}
 
+	if (trace_histories->flags.lcore_history_offsets[lcore] == 0) {
+		return NULL;
+	}
+
 	lcore_history_offset = (char *)trace_histories;
 	lcore_history_offset += trace_histories->flags.lcore_history_offsets[lcore];
 
@@ -177,6 +222,10 @@ spdk_get_per_lcore_history(struct spdk_trace_histories *trace_histories, unsigne
 void _spdk_trace_record(uint64_t tsc, uint16_t tpoint_id, uint16_t poller_id,
 			uint32_t size, uint64_t object_id, uint64_t arg1);
 
+void _spdk_trace_record_args(uint64_t tsc, uint16_t tpoint_id, uint16_t poller_id,
+			     uint32_t size, uint64_t object_id, uint8_t num_args,
+			     const uint64_t *args);
+
 /**
  * Record the current trace state for tracing tpoints. Debug tool can read the
  * information from shared memory to post-process the tpoint entries and display
@@ -237,6 +286,48 @@ void spdk_trace_record_tsc(uint64_t tsc, uint16_t tpoint_id, uint16_t poller_id,
 	_spdk_trace_record(tsc, tpoint_id, poller_id, size, object_id, arg1);
 }
 
+/**
+ * Record the current trace state for a tpoint with several arguments.
+ *
+ * The arguments are described by spdk_trace_register_description_ext(). The
+ * first argument is stored in the tracepoint entry like arg1 and the others in
+ * up to two entries following it.
+ *
+ * \param tsc Current tsc, or 0 to use spdk_get_ticks().
+ * \param tpoint_id Tracepoint id to record.
+ * \param poller_id Poller id to record.
+ * \param size Size to record.
+ * \param object_id Object id to record.
+ * \param num_args Number of arguments, at most SPDK_TRACE_MAX_ARGS_COUNT.
+ * \param args Arguments to record.
+ */
+static inline
+void spdk_trace_record_args(uint64_t tsc, uint16_t tpoint_id, uint16_t poller_id,
+			    uint32_t size, uint64_t object_id, uint8_t num_args,
+			    const uint64_t *args)
+{
+	assert(tpoint_id < SPDK_TRACE_MAX_TPOINT_ID);
+	assert(num_args <= SPDK_TRACE_MAX_ARGS_COUNT);
+	if (g_trace_histories == NULL ||
+	    !((1ULL << (tpoint_id & 0x3F)) & g_trace_histories->flags.tpoint_mask[tpoint_id >> 6])) {
+		return;
+	}
+
+	_spdk_trace_record_args(tsc, tpoint_id, poller_id, size, object_id, num_args, args);
+}
+
+/**
+ * Set the spdk_thread that the following tracepoints on this system thread are
+ * recorded for.
+ *
+ * Entries are stored in the trace history of the lcore they are recorded on. The
+ * history notes each change of the spdk_thread, so that entries can be attributed
+ * to spdk_threads even when they move between lcores.
+ *
+ * \param thread_id ID of the spdk_thread, 0 for none.
+ */
+void spdk_trace_set_thread_id(uint64_t thread_id);
+
 /**
  * Get the current tpoint mask of the given tpoint group.
  *
@@ -290,6 +381,9 @@ void spdk_trace_clear_tpoint_group_mask(uint64_t tpoint_group_mask);
  * the given shared memory to post-process the tpoint entries and display in a
  * human-readable format.
  *
+ * Trace histories are allocated for the lcores of the environment only, so
+ * the environment must be initialized first.
+ *
  * \param shm_name Name of shared memory.
  * \param num_entries Number of trace entries per lcore.
  * \return 0 on success, else non-zero indicates a failure.
@@ -340,6 +434,28 @@ void spdk_trace_register_description(const char *name, uint16_t tpoint_id, uint8
 				     uint8_t object_type, uint8_t new_object,
 				     uint8_t arg1_type, const char *arg1_name);
 
+struct spdk_trace_tpoint_arg {
+	const char	*name;
+	uint8_t		type;
+};
+
+/**
+ * Register the description for a tpoint recorded with several arguments by
+ * spdk_trace_record_args().
+ *
+ * \param name Name for the tpoint.
+ * \param tpoint_id Id for the tpoint.
+ * \param owner_type Owner type for the tpoint.
+ * \param object_type Object type for the tpoint.
+ * \param new_object New object for the tpoint.
+ * \param num_args Number of arguments, at most SPDK_TRACE_MAX_ARGS_COUNT.
+ * \param args Names and types of the arguments.
+ */
+void spdk_trace_register_description_ext(const char *name, uint16_t tpoint_id,
+		uint8_t owner_type, uint8_t object_type,
+		uint8_t new_object, uint8_t num_args,
+		const struct spdk_trace_tpoint_arg *args);
+
 struct spdk_trace_register_fn *spdk_trace_get_first_register_fn(void);
 
 struct spdk_trace_register_fn *spdk_trace_get_next_register_fn(struct spdk_trace_register_fn
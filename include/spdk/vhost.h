@@ -212,6 +212,39 @@ int spdk_vhost_set_coalescing(struct spdk_vhost_dev *vdev, uint32_t delay_base_u
 void spdk_vhost_get_coalescing(struct spdk_vhost_dev *vdev, uint32_t *delay_base_us,
 			       uint32_t *iops_threshold);
 
+/**
+ * Set adaptive interrupt coalescing for a single virtqueue.
+ *
+ * Instead of the device-wide IOPS based scheme from \c spdk_vhost_set_coalescing,
+ * the virtqueue delays an event until its oldest unsignalled completion has
+ * waited \c latency_budget_us, but signals right away if no further completion
+ * is expected within the budget - e.g. no other request is outstanding or the
+ * observed completion rate is too low. Queues with a budget of 0 use the
+ * device-wide settings.
+ *
+ * \param vdev vhost device.
+ * \param vq_idx virtqueue index.
+ * \param latency_budget_us maximum delay of an event in microseconds. If 0,
+ * adaptive coalescing is disabled for this virtqueue.
+ *
+ * \return 0 on success, negative errno on error.
+ */
+int spdk_vhost_set_vq_coalescing(struct spdk_vhost_dev *vdev, uint16_t vq_idx,
+				 uint32_t latency_budget_us);
+
+/**
+ * Get adaptive interrupt coalescing latency budget of a virtqueue.
+ *
+ * \see spdk_vhost_set_vq_coalescing
+ *
+ * \param vdev vhost device.
+ * \param vq_idx virtqueue index.
+ *
+ * \return latency budget in microseconds, 0 if adaptive coalescing is disabled
+ * or the virtqueue index is invalid.
+ */
+uint32_t spdk_vhost_get_vq_coalescing(struct spdk_vhost_dev *vdev, uint16_t vq_idx);
+
 /**
  * Construct an empty vhost SCSI device.  This will create a
  * Unix domain socket together with a vhost-user slave server waiting
@@ -229,10 +262,12 @@ void spdk_vhost_get_coalescing(struct spdk_vhost_dev *vdev, uint32_t *delay_base
  * \param cpumask string containing cpumask in hex. The leading *0x*
  * is allowed but not required. The mask itself can be constructed as:
  * ((1 << cpu0) | (1 << cpu1) | ... | (1 << cpuN)).
+ * \param packed_ring if set, the device will offer packed virtqueues
+ * (VIRTIO_F_RING_PACKED) to the driver.
  *
  * \return 0 on success, negative errno on error.
  */
-int spdk_vhost_scsi_dev_construct(const char *name, const char *cpumask);
+int spdk_vhost_scsi_dev_construct(const char *name, const char *cpumask, bool packed_ring);
 
 /**
  * Construct and attach new SCSI target to the vhost SCSI device
@@ -313,11 +348,13 @@ int spdk_vhost_scsi_dev_remove_tgt(struct spdk_vhost_dev *vdev, unsigned scsi_tg
  * \param dev_name bdev name to associate with this vhost device
  * \param readonly if set, all writes to the device will fail with
  * \c VIRTIO_BLK_S_IOERR error code.
+ * \param packed_ring if set, the device will offer packed virtqueues
+ * (VIRTIO_F_RING_PACKED) to the driver.
  *
  * \return 0 on success, negative errno on error.
  */
 int spdk_vhost_blk_construct(const char *name, const char *cpumask, const char *dev_name,
-			     bool readonly);
+			     bool readonly, bool packed_ring);
 
 /**
  * Remove a vhost device. The device must not have any open connections on it's socket.
@@ -110,9 +110,18 @@ struct spdk_reactor *spdk_reactor_get(uint32_t lcore);
  */
 void spdk_for_each_reactor(spdk_event_fn fn, void *arg1, void *arg2, spdk_event_fn cpl);
 
+enum spdk_subsystem_init_state {
+	SPDK_SUBSYSTEM_INIT_PENDING = 0,
+	SPDK_SUBSYSTEM_INIT_IN_PROGRESS,
+	SPDK_SUBSYSTEM_INIT_DONE,
+};
+
 struct spdk_subsystem {
 	const char *name;
-	/* User must call spdk_subsystem_init_next() when they are done with their initialization. */
+	/*
+	 * User must call spdk_subsystem_init_next() when they are done with their initialization,
+	 * or spdk_subsystem_init_done() if concurrent_init is set.
+	 */
 	void (*init)(void);
 	void (*fini)(void);
 	void (*config)(FILE *fp);
@@ -123,6 +132,19 @@ struct spdk_subsystem {
 	 * \param w JSON write context
 	 */
 	void (*write_config_json)(struct spdk_json_write_ctx *w);
+
+	/*
+	 * Set if init() reports completion with spdk_subsystem_init_done(). Such subsystems
+	 * are initialized concurrently with all other subsystems they don't depend on.
+	 * Subsystems without it are initialized one at a time, after all subsystems before
+	 * them in dependency order, while no other initialization is in progress.
+	 */
+	bool concurrent_init;
+
+	/* Initialization state, managed by the subsystem framework. */
+	enum spdk_subsystem_init_state init_state;
+	uint64_t init_start_tsc;
+
 	TAILQ_ENTRY(spdk_subsystem) tailq;
 };
 
@@ -147,6 +169,14 @@ typedef void (*spdk_subsystem_init_fn)(int rc, void *ctx);
 void spdk_subsystem_init(spdk_subsystem_init_fn cb_fn, void *cb_arg);
 void spdk_subsystem_fini(spdk_msg_fn cb_fn, void *cb_arg);
 void spdk_subsystem_init_next(int rc);
+
+/**
+ * Complete the initialization of a subsystem with concurrent_init set.
+ *
+ * \param subsystem Subsystem that finished its initialization.
+ * \param rc 0 on success or negative errno on failure.
+ */
+void spdk_subsystem_init_done(struct spdk_subsystem *subsystem, int rc);
 void spdk_subsystem_fini_next(void);
 void spdk_subsystem_config(FILE *fp);
 void spdk_app_json_config_load(const char *json_config_file, const char *rpc_addr,
@@ -165,6 +195,19 @@ void spdk_subsystem_config_json(struct spdk_json_write_ctx *w, struct spdk_subsy
 void spdk_rpc_initialize(const char *listen_addr);
 void spdk_rpc_finish(void);
 
+/**
+ * Record a step of the application startup in the startup timeline.
+ *
+ * The step ends when this function is called.
+ *
+ * \param phase Startup phase the step belongs to, e.g. "subsystem_init".
+ * \param name Name of the step within the phase. The string is copied.
+ * \param start_tsc Tick count when the step started.
+ * \param count Number of operations done in this step, e.g. RPCs sent, or 0.
+ */
+void spdk_app_timeline_add(const char *phase, const char *name, uint64_t start_tsc,
+			   uint32_t count);
+
 /**
  * \brief Register a new subsystem
  */
@@ -61,6 +61,7 @@ struct spdk_sock {
 	TAILQ_HEAD(, spdk_sock_request)	queued_reqs;
 	TAILQ_HEAD(, spdk_sock_request)	pending_reqs;
 	int				queued_iovcnt;
+	int				placement_id;
 
 	struct {
 		uint8_t		closed		: 1;
@@ -99,7 +100,9 @@ struct spdk_net_impl {
 	int (*set_recvlowat)(struct spdk_sock *sock, int nbytes);
 	int (*set_recvbuf)(struct spdk_sock *sock, int sz);
 	int (*set_sendbuf)(struct spdk_sock *sock, int sz);
+	int (*get_sendbuf)(struct spdk_sock *sock, int *sz);
 	int (*set_priority)(struct spdk_sock *sock, int priority);
+	int (*set_busy_poll)(struct spdk_sock *sock, int usec);
 
 	bool (*is_ipv6)(struct spdk_sock *sock);
 	bool (*is_ipv4)(struct spdk_sock *sock);
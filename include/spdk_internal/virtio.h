@@ -129,6 +129,8 @@ struct virtio_dev_ops {
 struct vq_desc_extra {
 	void *cookie;
 	uint16_t ndescs;
+	/** Next free buffer ID. Used only by packed virtqueues. */
+	uint16_t next;
 };
 
 struct virtqueue {
@@ -171,6 +173,35 @@ struct virtqueue {
 	uint16_t req_end;
 	uint16_t reqs_finished;
 
+	/** Statistics, updated by the owner thread. */
+	struct {
+		/** Requests made available to the device. */
+		uint64_t	reqs;
+		/** Notifications sent to the device. */
+		uint64_t	notifies;
+	} stats;
+
+	/**
+	 * Packed virtqueue state, valid only if VIRTIO_F_RING_PACKED was
+	 * negotiated. In such case vq_avail_idx and vq_used_cons_idx are
+	 * descriptor ring positions, the free chain in vq_descx holds
+	 * buffer IDs, req_start is the buffer ID of the current request
+	 * and reqs_finished counts descriptors rather than requests.
+	 */
+	struct {
+		bool				packed_ring;
+		struct vring_packed_desc	*desc;
+		struct vring_packed_desc_event	*driver_event;
+		struct vring_packed_desc_event	*device_event;
+		/** AVAIL/USED flags of descriptors made available in the current lap. */
+		uint16_t			avail_flags;
+		/** Position of the first descriptor of the current request. */
+		uint16_t			req_head_idx;
+		/** Flags of the first descriptor, written last to publish the request. */
+		uint16_t			req_head_flags;
+		bool				used_wrap_counter;
+	} packed;
+
 	struct vq_desc_extra vq_descx[0];
 };
 
@@ -196,10 +227,9 @@ uint16_t virtio_recv_pkts(struct virtqueue *vq, void **io, uint32_t *len, uint16
 /**
  * Start a new request on the current vring head position and associate it
  * with an opaque cookie object. The previous request in given vq will be
- * made visible to the device in hopes it can be processed early, but there's
- * no guarantee it will be until the device is notified with \c
- * virtqueue_req_flush. This behavior is simply an optimization and virtqueues
- * must always be flushed. Empty requests (with no descriptors added) will be
+ * finished, but on split virtqueues it's only published to the device by
+ * \c virtqueue_req_flush, so multiple requests can be started and then
+ * flushed together. Virtqueues must always be flushed. Empty requests (with no descriptors added) will be
  * ignored. The device owning given virtqueue must be started.
  *
  * \param vq virtio queue
@@ -215,12 +245,14 @@ uint16_t virtio_recv_pkts(struct virtqueue *vq, void **io, uint32_t *len, uint16
 int virtqueue_req_start(struct virtqueue *vq, void *cookie, int iovcnt);
 
 /**
- * Flush a virtqueue. This will notify the device if it's required.
- * The device owning given virtqueue must be started.
+ * Flush a virtqueue. This publishes all requests started since the previous
+ * flush and will notify the device if it's required. The device owning given
+ * virtqueue must be started.
  *
  * \param vq virtio queue
+ * \return true if the device was notified, false otherwise.
  */
-void virtqueue_req_flush(struct virtqueue *vq);
+bool virtqueue_req_flush(struct virtqueue *vq);
 
 /**
  * Abort the very last request in a virtqueue. This will restore virtqueue
@@ -246,6 +278,19 @@ void virtqueue_req_abort(struct virtqueue *vq);
 void virtqueue_req_add_iovs(struct virtqueue *vq, struct iovec *iovs, uint16_t iovcnt,
 			    enum spdk_virtio_desc_type desc_type);
 
+/**
+ * Get the offsets of the driver and device areas within the virtqueue ring
+ * memory. The descriptor area always starts at offset 0. For split virtqueues
+ * these are the avail and used rings, for packed virtqueues - the driver and
+ * device event suppression structures.
+ *
+ * \param vq virtio queue
+ * \param driver_area_offset will be set to the driver area offset
+ * \param device_area_offset will be set to the device area offset
+ */
+void virtqueue_get_ring_offsets(struct virtqueue *vq, uint64_t *driver_area_offset,
+				uint64_t *device_area_offset);
+
 /**
  * Construct a virtio device.  The device will be in stopped state by default.
  * Before doing any I/O, it has to be manually started via \c virtio_dev_restart.
@@ -1962,6 +1962,30 @@ bdev_io_split_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_i
 /* Explicitly mark this inline, since it's used as a function pointer and otherwise won't
  *  be inlined, at least on some compilers.
  */
+static inline void
+bdev_io_trace_start(struct spdk_bdev_io *bdev_io, uint64_t tsc)
+{
+	uint64_t args[3] = { bdev_io->type, 0, 0 };
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+	case SPDK_BDEV_IO_TYPE_WRITE:
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+	case SPDK_BDEV_IO_TYPE_FLUSH:
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+	case SPDK_BDEV_IO_TYPE_COMPARE:
+	case SPDK_BDEV_IO_TYPE_COMPARE_AND_WRITE:
+		args[1] = bdev_io->u.bdev.offset_blocks;
+		args[2] = bdev_io->u.bdev.num_blocks;
+		break;
+	default:
+		break;
+	}
+
+	spdk_trace_record_args(tsc, TRACE_BDEV_IO_START, 0, 0, (uintptr_t)bdev_io,
+			       SPDK_COUNTOF(args), args);
+}
+
 static inline void
 _bdev_io_submit(void *ctx)
 {
@@ -1973,7 +1997,7 @@ _bdev_io_submit(void *ctx)
 
 	tsc = spdk_get_ticks();
 	bdev_io->internal.submit_tsc = tsc;
-	spdk_trace_record_tsc(tsc, TRACE_BDEV_IO_START, 0, 0, (uintptr_t)bdev_io, bdev_io->type);
+	bdev_io_trace_start(bdev_io, tsc);
 
 	if (spdk_likely(bdev_ch->flags == 0)) {
 		bdev_io_do_submit(bdev_ch, bdev_io);
@@ -2086,8 +2110,7 @@ bdev_io_submit(struct spdk_bdev_io *bdev_io)
 
 	if (bdev->split_on_optimal_io_boundary && bdev_io_should_split(bdev_io)) {
 		bdev_io->internal.submit_tsc = spdk_get_ticks();
-		spdk_trace_record_tsc(bdev_io->internal.submit_tsc, TRACE_BDEV_IO_START, 0, 0,
-				      (uintptr_t)bdev_io, bdev_io->type);
+		bdev_io_trace_start(bdev_io, bdev_io->internal.submit_tsc);
 		bdev_io_split(NULL, bdev_io);
 		return;
 	}
@@ -6407,10 +6430,17 @@ SPDK_LOG_REGISTER_COMPONENT("bdev", SPDK_LOG_BDEV)
 
 SPDK_TRACE_REGISTER_FN(bdev_trace, "bdev", TRACE_GROUP_BDEV)
 {
+	struct spdk_trace_tpoint_arg io_start_args[] = {
+		{ "type:", SPDK_TRACE_ARG_TYPE_INT },
+		{ "offset:", SPDK_TRACE_ARG_TYPE_INT },
+		{ "len:", SPDK_TRACE_ARG_TYPE_INT },
+	};
+
 	spdk_trace_register_owner(OWNER_BDEV, 'b');
 	spdk_trace_register_object(OBJECT_BDEV_IO, 'i');
-	spdk_trace_register_description("BDEV_IO_START", TRACE_BDEV_IO_START, OWNER_BDEV,
-					OBJECT_BDEV_IO, 1, 0, "type:   ");
+	spdk_trace_register_description_ext("BDEV_IO_START", TRACE_BDEV_IO_START, OWNER_BDEV,
+					    OBJECT_BDEV_IO, 1, SPDK_COUNTOF(io_start_args),
+					    io_start_args);
 	spdk_trace_register_description("BDEV_IO_DONE", TRACE_BDEV_IO_DONE, OWNER_BDEV,
 					OBJECT_BDEV_IO, 0, 0, "");
 }
@@ -116,6 +116,7 @@ spdk_cache_buffer_free(struct cache_buffer *cache_buffer)
 }
 
 #define CACHE_READAHEAD_THRESHOLD	(128 * 1024)
+#define DIRECT_IO_WRITE_THRESHOLD	(128 * 1024)
 
 struct spdk_file {
 	struct spdk_filesystem	*fs;
@@ -125,6 +126,7 @@ struct spdk_file {
 	uint64_t		length;
 	bool                    is_deleted;
 	bool			open_for_writing;
+	bool			direct_io;
 	uint64_t		length_flushed;
 	uint64_t		length_xattr;
 	uint64_t		append_pos;
@@ -1218,6 +1220,10 @@ fs_open_blob_create_cb(void *ctx, int bserrno)
 		args->file = file;
 	}
 
+	if (args->op.open.flags & SPDK_BLOBFS_OPEN_DIRECT) {
+		file->direct_io = true;
+	}
+
 	file->ref_count++;
 	TAILQ_INSERT_TAIL(&file->open_requests, req, args.op.open.tailq);
 	if (file->ref_count == 1) {
@@ -1271,6 +1277,7 @@ spdk_fs_open_file_async(struct spdk_filesystem *fs, const char *name, uint32_t f
 	args->file = f;
 	args->fs = fs;
 	args->op.open.name = name;
+	args->op.open.flags = flags;
 
 	if (f == NULL) {
 		spdk_fs_create_file_async(fs, name, fs_open_blob_create_cb, req);
@@ -2451,13 +2458,112 @@ __send_rw_from_file(struct spdk_file *file, void *payload,
 	return 0;
 }
 
+static int
+__file_extend(struct spdk_file *file, struct spdk_fs_channel *channel, uint64_t length)
+{
+	struct spdk_fs_cb_args extend_args = {};
+	uint64_t cluster_sz;
+
+	cluster_sz = file->fs->bs_opts.cluster_sz;
+	extend_args.sem = &channel->sem;
+	extend_args.op.resize.num_clusters = __bytes_to_clusters(length, cluster_sz);
+	extend_args.file = file;
+	BLOBFS_TRACE(file, "start resize to %u clusters\n", extend_args.op.resize.num_clusters);
+	file->fs->send_request(__file_extend_blob, &extend_args);
+	sem_wait(&channel->sem);
+
+	return extend_args.rc;
+}
+
+static void
+__file_direct_write_done(void *ctx, int bserrno)
+{
+	struct spdk_fs_cb_args *args = ctx;
+	struct spdk_file *file = args->file;
+	uint64_t end = args->op.rw.offset + args->op.rw.length;
+
+	if (bserrno == 0) {
+		pthread_spin_lock(&file->lock);
+		if (file->length < end) {
+			file->length = end;
+		}
+		if (file->length_flushed < end) {
+			file->length_flushed = end;
+		}
+		pthread_spin_unlock(&file->lock);
+	}
+
+	__wake_caller(args, bserrno);
+}
+
+static void
+__file_direct_write(void *ctx)
+{
+	struct spdk_fs_cb_args *args = ctx;
+	struct spdk_file *file = args->file;
+	uint64_t start_lba, num_lba;
+	uint32_t lba_size;
+
+	__get_page_parameters(file, args->op.rw.offset, args->op.rw.length,
+			      &start_lba, &lba_size, &num_lba);
+
+	BLOBFS_TRACE(file, "offset=%jx length=%jx page start=%jx num=%jx\n",
+		     args->op.rw.offset, args->op.rw.length, start_lba, num_lba);
+	spdk_blob_io_writev(file->blob, file->fs->sync_target.sync_fs_channel->bs_channel,
+			    args->iovs, args->iovcnt, start_lba, num_lba,
+			    __file_direct_write_done, args);
+}
+
+static bool
+__file_can_write_direct(struct spdk_file *file, uint64_t offset, uint64_t length)
+{
+	return file->direct_io && file->last == NULL &&
+	       length >= DIRECT_IO_WRITE_THRESHOLD &&
+	       __is_lba_aligned(file, offset, length);
+}
+
+static int
+__file_write_direct(struct spdk_file *file, struct spdk_fs_channel *channel,
+		    void *payload, uint64_t offset, uint64_t length)
+{
+	struct spdk_fs_cb_args direct_args = {};
+	int rc;
+
+	if ((offset + length) > __file_get_blob_size(file)) {
+		rc = __file_extend(file, channel, offset + length);
+		if (rc) {
+			return rc;
+		}
+	}
+
+	direct_args.sem = &channel->sem;
+	direct_args.file = file;
+	direct_args.iov.iov_base = payload;
+	direct_args.iov.iov_len = (size_t)length;
+	direct_args.iovs = &direct_args.iov;
+	direct_args.iovcnt = 1;
+	direct_args.op.rw.offset = offset;
+	direct_args.op.rw.length = length;
+	file->fs->send_request(__file_direct_write, &direct_args);
+	sem_wait(&channel->sem);
+	if (direct_args.rc) {
+		return direct_args.rc;
+	}
+
+	pthread_spin_lock(&file->lock);
+	file->append_pos += length;
+	pthread_spin_unlock(&file->lock);
+
+	return 0;
+}
+
 int
 spdk_file_write(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
 		void *payload, uint64_t offset, uint64_t length)
 {
 	struct spdk_fs_channel *channel = (struct spdk_fs_channel *)ctx;
 	struct spdk_fs_request *flush_req;
-	uint64_t rem_length, copy, blob_size, cluster_sz;
+	uint64_t rem_length, copy, blob_size;
 	uint32_t cache_buffers_filled = 0;
 	uint8_t *cur_payload;
 	struct cache_buffer *last;
@@ -2476,6 +2582,11 @@ spdk_file_write(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
 	pthread_spin_lock(&file->lock);
 	file->open_for_writing = true;
 
+	if (__file_can_write_direct(file, offset, length)) {
+		pthread_spin_unlock(&file->lock);
+		return __file_write_direct(file, channel, payload, offset, length);
+	}
+
 	if ((file->last == NULL) && (file->append_pos % CACHE_BUFFER_SIZE == 0)) {
 		cache_append_buffer(file);
 	}
@@ -2493,18 +2604,12 @@ spdk_file_write(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
 	blob_size = __file_get_blob_size(file);
 
 	if ((offset + length) > blob_size) {
-		struct spdk_fs_cb_args extend_args = {};
+		int rc;
 
-		cluster_sz = file->fs->bs_opts.cluster_sz;
-		extend_args.sem = &channel->sem;
-		extend_args.op.resize.num_clusters = __bytes_to_clusters((offset + length), cluster_sz);
-		extend_args.file = file;
-		BLOBFS_TRACE(file, "start resize to %u clusters\n", extend_args.op.resize.num_clusters);
 		pthread_spin_unlock(&file->lock);
-		file->fs->send_request(__file_extend_blob, &extend_args);
-		sem_wait(&channel->sem);
-		if (extend_args.rc) {
-			return extend_args.rc;
+		rc = __file_extend(file, channel, offset + length);
+		if (rc) {
+			return rc;
 		}
 	}
 
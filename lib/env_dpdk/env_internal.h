@@ -57,7 +57,8 @@
 #define MASK_256TB	((1ULL << SHIFT_256TB) - 1)
 
 #define SHIFT_1GB	30 /* (1 << 30) == 1 GB */
-#define MASK_1GB	((1ULL << SHIFT_1GB) - 1)
+#define VALUE_1GB	(1ULL << SHIFT_1GB)
+#define MASK_1GB	(VALUE_1GB - 1)
 
 #define SPDK_PMD_REGISTER_PCI(pci_drv)									\
 __attribute__((constructor)) static void pci_drv ## _register(void)					\
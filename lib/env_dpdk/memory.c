@@ -119,6 +119,8 @@ struct map_2mb {
  */
 struct map_1gb {
 	struct map_2mb map[1ULL << (SHIFT_1GB - SHIFT_2MB)];
+	/* All translations of this 1GB region are contiguous, e.g. for a 1GB hugepage */
+	bool contiguous;
 };
 
 /* Top-level map table indexed by bits [30..47] of the virtual address.
@@ -133,6 +135,8 @@ struct spdk_mem_map {
 	struct map_256tb map_256tb;
 	pthread_mutex_t mutex;
 	uint64_t default_translation;
+	/* Changes with every update of the translations, see struct map_tlb_entry */
+	uint64_t generation;
 	struct spdk_mem_map_ops ops;
 	void *cb_ctx;
 	TAILQ_ENTRY(spdk_mem_map) tailq;
@@ -150,6 +154,37 @@ static pthread_mutex_t g_spdk_mem_map_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static bool g_legacy_mem;
 
+/* Source of unique spdk_mem_map generations */
+static uint64_t g_mem_map_generation;
+
+/*
+ * Per-thread cache of contiguity lookups. spdk_mem_map_translate() with a size
+ * has to walk the map until the translations stop being contiguous. The entries
+ * remember how far the translation of a 2MB page is known to be contiguous, and
+ * are only valid while the generation of their map is unchanged. Generations are
+ * unique across all maps, so entries of a freed map never match a new map.
+ */
+#define MAP_TLB_ENTRIES	16
+
+struct map_tlb_entry {
+	const struct spdk_mem_map	*map;
+	uint64_t			generation;
+	uint64_t			vfn_2mb;
+	uint64_t			translation;
+	/* Length from the start of the 2MB page known to be contiguous */
+	uint64_t			contig_len;
+};
+
+static __thread struct map_tlb_entry t_map_tlb[MAP_TLB_ENTRIES];
+
+static inline void
+spdk_mem_map_update_generation(struct spdk_mem_map *map)
+{
+	__atomic_store_n(&map->generation,
+			 __atomic_add_fetch(&g_mem_map_generation, 1, __ATOMIC_RELAXED),
+			 __ATOMIC_RELEASE);
+}
+
 /*
  * Walk the currently registered memory via the main memory registration map
  * and call the new map's notify callback for each virtually contiguous region.
@@ -299,6 +334,7 @@ spdk_mem_map_alloc(uint64_t default_translation, const struct spdk_mem_map_ops *
 
 	map->default_translation = default_translation;
 	map->cb_ctx = cb_ctx;
+	spdk_mem_map_update_generation(map);
 	if (ops) {
 		map->ops = *ops;
 	}
@@ -550,6 +586,8 @@ spdk_mem_map_get_map_1gb(struct spdk_mem_map *map, uint64_t vfn_2mb)
 				for (i = 0; i < SPDK_COUNTOF(map_1gb->map); i++) {
 					map_1gb->map[i].translation_2mb = map->default_translation;
 				}
+				/* Default translations are never reported as contiguous */
+				map_1gb->contiguous = false;
 				map->map_256tb.map[idx_256tb] = map_1gb;
 			}
 		}
@@ -565,14 +603,31 @@ spdk_mem_map_get_map_1gb(struct spdk_mem_map *map, uint64_t vfn_2mb)
 	return map_1gb;
 }
 
+static void
+spdk_mem_map_update_contiguous_1gb(const struct spdk_mem_map *map, struct map_1gb *map_1gb)
+{
+	bool contiguous;
+	size_t i;
+
+	contiguous = map->ops.are_contiguous != NULL &&
+		     map_1gb->map[0].translation_2mb != map->default_translation;
+	for (i = 1; contiguous && i < SPDK_COUNTOF(map_1gb->map); i++) {
+		contiguous = map->ops.are_contiguous(map_1gb->map[i - 1].translation_2mb,
+						     map_1gb->map[i].translation_2mb);
+	}
+
+	map_1gb->contiguous = contiguous;
+}
+
 int
 spdk_mem_map_set_translation(struct spdk_mem_map *map, uint64_t vaddr, uint64_t size,
 			     uint64_t translation)
 {
 	uint64_t vfn_2mb;
-	struct map_1gb *map_1gb;
+	struct map_1gb *map_1gb, *prev_map_1gb = NULL;
 	uint64_t idx_1gb;
 	struct map_2mb *map_2mb;
+	int rc = 0;
 
 	if ((uintptr_t)vaddr & ~MASK_256TB) {
 		DEBUG_PRINT("invalid usermode virtual address %lu\n", vaddr);
@@ -592,7 +647,16 @@ spdk_mem_map_set_translation(struct spdk_mem_map *map, uint64_t vaddr, uint64_t
 		map_1gb = spdk_mem_map_get_map_1gb(map, vfn_2mb);
 		if (!map_1gb) {
 			DEBUG_PRINT("could not get %p map\n", (void *)vaddr);
-			return -ENOMEM;
+			rc = -ENOMEM;
+			break;
+		}
+
+		if (map_1gb != prev_map_1gb) {
+			if (prev_map_1gb != NULL) {
+				spdk_mem_map_update_contiguous_1gb(map, prev_map_1gb);
+			}
+			map_1gb->contiguous = false;
+			prev_map_1gb = map_1gb;
 		}
 
 		idx_1gb = MAP_1GB_IDX(vfn_2mb);
@@ -603,7 +667,13 @@ spdk_mem_map_set_translation(struct spdk_mem_map *map, uint64_t vaddr, uint64_t
 		vfn_2mb++;
 	}
 
-	return 0;
+	if (prev_map_1gb != NULL) {
+		spdk_mem_map_update_contiguous_1gb(map, prev_map_1gb);
+	}
+
+	spdk_mem_map_update_generation(map);
+
+	return rc;
 }
 
 int
@@ -612,17 +682,74 @@ spdk_mem_map_clear_translation(struct spdk_mem_map *map, uint64_t vaddr, uint64_
 	return spdk_mem_map_set_translation(map, vaddr, size, map->default_translation);
 }
 
+/*
+ * Get the length of the contiguous translations starting at the 2MB page vfn_2mb,
+ *  walking at least until min_len. Regions with contiguous 1GB maps are skipped
+ *  as a whole.
+ */
+static uint64_t
+spdk_mem_map_get_contig_len(const struct spdk_mem_map *map, uint64_t vfn_2mb,
+			    const struct map_1gb *map_1gb, uint64_t min_len)
+{
+	const uint64_t last_idx_1gb = (1ULL << (SHIFT_1GB - SHIFT_2MB)) - 1;
+	uint64_t idx_256tb;
+	uint64_t idx_1gb;
+	uint64_t contig_len;
+	uint64_t prev_translation;
+
+	idx_1gb = MAP_1GB_IDX(vfn_2mb);
+	if (map_1gb->contiguous) {
+		contig_len = (last_idx_1gb - idx_1gb + 1) << SHIFT_2MB;
+		prev_translation = map_1gb->map[last_idx_1gb].translation_2mb;
+		vfn_2mb += last_idx_1gb - idx_1gb;
+	} else {
+		contig_len = VALUE_2MB;
+		prev_translation = map_1gb->map[idx_1gb].translation_2mb;
+	}
+
+	while (contig_len < min_len) {
+		vfn_2mb++;
+		idx_256tb = MAP_256TB_IDX(vfn_2mb);
+		idx_1gb = MAP_1GB_IDX(vfn_2mb);
+
+		if (spdk_unlikely(idx_256tb >= SPDK_COUNTOF(map->map_256tb.map))) {
+			break;
+		}
+
+		map_1gb = map->map_256tb.map[idx_256tb];
+		if (spdk_unlikely(!map_1gb)) {
+			break;
+		}
+
+		if (!map->ops.are_contiguous(prev_translation, map_1gb->map[idx_1gb].translation_2mb)) {
+			break;
+		}
+
+		if (idx_1gb == 0 && map_1gb->contiguous) {
+			contig_len += VALUE_1GB;
+			prev_translation = map_1gb->map[last_idx_1gb].translation_2mb;
+			vfn_2mb += last_idx_1gb;
+		} else {
+			contig_len += VALUE_2MB;
+			prev_translation = map_1gb->map[idx_1gb].translation_2mb;
+		}
+	}
+
+	return contig_len;
+}
+
 inline uint64_t
 spdk_mem_map_translate(const struct spdk_mem_map *map, uint64_t vaddr, uint64_t *size)
 {
 	const struct map_1gb *map_1gb;
 	const struct map_2mb *map_2mb;
+	struct map_tlb_entry *tlb = NULL;
 	uint64_t idx_256tb;
 	uint64_t idx_1gb;
 	uint64_t vfn_2mb;
 	uint64_t cur_size;
-	uint64_t prev_translation;
-	uint64_t orig_translation;
+	uint64_t generation = 0;
+	uint64_t offset;
 
 	if (spdk_unlikely(vaddr & ~MASK_256TB)) {
 		DEBUG_PRINT("invalid usermode virtual address %p\n", (void *)vaddr);
@@ -630,6 +757,18 @@ spdk_mem_map_translate(const struct spdk_mem_map *map, uint64_t vaddr, uint64_t
 	}
 
 	vfn_2mb = vaddr >> SHIFT_2MB;
+	offset = _2MB_OFFSET(vaddr);
+
+	if (size != NULL && map->ops.are_contiguous != NULL) {
+		/* Read the generation before the map, so that concurrent updates invalidate the entry */
+		generation = __atomic_load_n(&map->generation, __ATOMIC_ACQUIRE);
+		tlb = &t_map_tlb[vfn_2mb & (MAP_TLB_ENTRIES - 1)];
+		if (tlb->map == map && tlb->vfn_2mb == vfn_2mb && tlb->generation == generation &&
+		    tlb->contig_len - offset >= *size) {
+			return tlb->translation;
+		}
+	}
+
 	idx_256tb = MAP_256TB_IDX(vfn_2mb);
 	idx_1gb = MAP_1GB_IDX(vfn_2mb);
 
@@ -638,7 +777,7 @@ spdk_mem_map_translate(const struct spdk_mem_map *map, uint64_t vaddr, uint64_t
 		return map->default_translation;
 	}
 
-	cur_size = VALUE_2MB - _2MB_OFFSET(vaddr);
+	cur_size = VALUE_2MB - offset;
 	map_2mb = &map_1gb->map[idx_1gb];
 	if (size == NULL || map->ops.are_contiguous == NULL ||
 	    map_2mb->translation_2mb == map->default_translation) {
@@ -648,29 +787,32 @@ spdk_mem_map_translate(const struct spdk_mem_map *map, uint64_t vaddr, uint64_t
 		return map_2mb->translation_2mb;
 	}
 
-	orig_translation = map_2mb->translation_2mb;
-	prev_translation = orig_translation;
-	while (cur_size < *size) {
-		vfn_2mb++;
-		idx_256tb = MAP_256TB_IDX(vfn_2mb);
-		idx_1gb = MAP_1GB_IDX(vfn_2mb);
+	tlb->map = map;
+	tlb->generation = generation;
+	tlb->vfn_2mb = vfn_2mb;
+	tlb->translation = map_2mb->translation_2mb;
+	tlb->contig_len = spdk_mem_map_get_contig_len(map, vfn_2mb, map_1gb, *size + offset);
 
-		map_1gb = map->map_256tb.map[idx_256tb];
-		if (spdk_unlikely(!map_1gb)) {
-			break;
-		}
+	*size = spdk_min(*size, tlb->contig_len - offset);
+	return tlb->translation;
+}
 
-		map_2mb = &map_1gb->map[idx_1gb];
-		if (!map->ops.are_contiguous(prev_translation, map_2mb->translation_2mb)) {
+int
+spdk_mem_map_translate_iov(const struct spdk_mem_map *map, const struct iovec *iov, int iovcnt,
+			   uint64_t *translations)
+{
+	uint64_t len;
+	int i;
+
+	for (i = 0; i < iovcnt; i++) {
+		len = iov[i].iov_len;
+		translations[i] = spdk_mem_map_translate(map, (uint64_t)iov[i].iov_base, &len);
+		if (len < iov[i].iov_len) {
 			break;
 		}
-
-		cur_size += VALUE_2MB;
-		prev_translation = map_2mb->translation_2mb;
 	}
 
-	*size = spdk_min(*size, cur_size);
-	return orig_translation;
+	return i;
 }
 
 #if RTE_VERSION >= RTE_VERSION_NUM(18, 05, 0, 0)
@@ -75,6 +75,20 @@ static bool g_shutdown_sig_received = false;
 static char *g_executable_name;
 static struct spdk_app_opts g_default_opts;
 
+struct spdk_app_timeline_entry {
+	const char				*phase;
+	char					*name;
+	uint64_t				start_tsc;
+	uint64_t				end_tsc;
+	uint32_t				count;
+	STAILQ_ENTRY(spdk_app_timeline_entry)	link;
+};
+
+static STAILQ_HEAD(, spdk_app_timeline_entry) g_timeline = STAILQ_HEAD_INITIALIZER(g_timeline);
+/* When the app thread started the application bootstrap and when start_fn was called */
+static uint64_t g_timeline_start_tsc;
+static uint64_t g_timeline_started_tsc;
+
 int
 spdk_app_get_shm_id(void)
 {
@@ -341,11 +355,78 @@ spdk_app_setup_signal_handlers(struct spdk_app_opts *opts)
 	return 0;
 }
 
+void
+spdk_app_timeline_add(const char *phase, const char *name, uint64_t start_tsc, uint32_t count)
+{
+	struct spdk_app_timeline_entry *entry;
+
+	entry = calloc(1, sizeof(*entry));
+	if (entry == NULL) {
+		return;
+	}
+
+	entry->name = strdup(name);
+	if (entry->name == NULL) {
+		free(entry);
+		return;
+	}
+
+	entry->phase = phase;
+	entry->start_tsc = start_tsc;
+	entry->end_tsc = spdk_get_ticks();
+	entry->count = count;
+	STAILQ_INSERT_TAIL(&g_timeline, entry, link);
+}
+
+static void
+spdk_app_timeline_free(void)
+{
+	struct spdk_app_timeline_entry *entry;
+
+	while ((entry = STAILQ_FIRST(&g_timeline)) != NULL) {
+		STAILQ_REMOVE_HEAD(&g_timeline, link);
+		free(entry->name);
+		free(entry);
+	}
+}
+
+static uint64_t
+spdk_app_timeline_us(uint64_t tsc)
+{
+	return tsc * SPDK_SEC_TO_USEC / spdk_get_ticks_hz();
+}
+
+/* Time from the first step of phase to the end of the last one */
+static uint64_t
+spdk_app_timeline_phase_us(const char *phase)
+{
+	struct spdk_app_timeline_entry *entry;
+	uint64_t start_tsc = UINT64_MAX, end_tsc = 0;
+
+	STAILQ_FOREACH(entry, &g_timeline, link) {
+		if (strcmp(entry->phase, phase) == 0) {
+			start_tsc = spdk_min(start_tsc, entry->start_tsc);
+			end_tsc = spdk_max(end_tsc, entry->end_tsc);
+		}
+	}
+
+	return end_tsc > start_tsc ? spdk_app_timeline_us(end_tsc - start_tsc) : 0;
+}
+
 static void
 spdk_app_start_application(void)
 {
 	assert(spdk_get_thread() == g_app_thread);
 
+	if (g_timeline_started_tsc == 0) {
+		g_timeline_started_tsc = spdk_get_ticks();
+		SPDK_NOTICELOG("Application started in %" PRIu64 " ms (subsystem init %" PRIu64
+			       " ms, JSON config %" PRIu64 " ms)\n",
+			       spdk_app_timeline_us(g_timeline_started_tsc - g_timeline_start_tsc) / 1000,
+			       spdk_app_timeline_phase_us("subsystem_init") / 1000,
+			       spdk_app_timeline_phase_us("json_config") / 1000);
+	}
+
 	g_start_fn(g_start_arg);
 }
 
@@ -684,6 +765,7 @@ spdk_app_start(struct spdk_app_opts *opts, spdk_msg_fn start_fn,
 	g_start_fn = start_fn;
 	g_start_arg = arg1;
 
+	g_timeline_start_tsc = spdk_get_ticks();
 	spdk_thread_send_msg(g_app_thread, bootstrap_fn, NULL);
 
 	/* This blocks until spdk_app_stop is called */
@@ -699,6 +781,7 @@ spdk_app_fini(void)
 	spdk_reactors_fini();
 	spdk_env_fini();
 	spdk_conf_free(g_spdk_app.config);
+	spdk_app_timeline_free();
 	spdk_log_close();
 }
 
@@ -1140,3 +1223,44 @@ spdk_rpc_framework_wait_init(struct spdk_jsonrpc_request *request,
 SPDK_RPC_REGISTER("framework_wait_init", spdk_rpc_framework_wait_init,
 		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
 SPDK_RPC_REGISTER_ALIAS_DEPRECATED(framework_wait_init, wait_subsystem_init)
+
+static void
+spdk_rpc_framework_get_startup_timeline(struct spdk_jsonrpc_request *request,
+					const struct spdk_json_val *params)
+{
+	struct spdk_app_timeline_entry *entry;
+	struct spdk_json_write_ctx *w;
+
+	if (params != NULL) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "framework_get_startup_timeline requires no parameters");
+		return;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_object_begin(w);
+	if (g_timeline_started_tsc != 0) {
+		spdk_json_write_named_uint64(w, "total_us",
+					     spdk_app_timeline_us(g_timeline_started_tsc - g_timeline_start_tsc));
+	}
+
+	spdk_json_write_named_array_begin(w, "steps");
+	STAILQ_FOREACH(entry, &g_timeline, link) {
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "phase", entry->phase);
+		spdk_json_write_named_string(w, "name", entry->name);
+		spdk_json_write_named_uint64(w, "start_us",
+					     spdk_app_timeline_us(entry->start_tsc - g_timeline_start_tsc));
+		spdk_json_write_named_uint64(w, "duration_us",
+					     spdk_app_timeline_us(entry->end_tsc - entry->start_tsc));
+		if (entry->count != 0) {
+			spdk_json_write_named_uint32(w, "count", entry->count);
+		}
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(request, w);
+}
+SPDK_RPC_REGISTER("framework_get_startup_timeline", spdk_rpc_framework_get_startup_timeline,
+		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
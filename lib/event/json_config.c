@@ -68,10 +68,6 @@
  *
  */
 
-struct load_json_config_ctx;
-typedef void (*client_resp_handler)(struct load_json_config_ctx *,
-				    struct spdk_jsonrpc_client_response *);
-
 #define RPC_SOCKET_PATH_MAX sizeof(((struct sockaddr_un *)0)->sun_path)
 
 /* 1s connections timeout */
@@ -83,6 +79,24 @@ typedef void (*client_resp_handler)(struct load_json_config_ctx *,
  * So just print WARNLOG every 10s. */
 #define RPC_CLIENT_REQUEST_TIMEOUT_US (10U * 1000 * 1000)
 
+/*
+ * The JSON-RPC client handles one request at a time, so requests are issued in
+ * parallel over this many connections to the RPC server.
+ */
+#define RPC_CLIENT_MAX_PARALLEL_REQUESTS 16
+
+struct load_json_config_ctx;
+
+struct load_json_config_client {
+	struct spdk_jsonrpc_client *conn;
+	bool connected;
+	/* Request sent and no response received yet */
+	bool busy;
+
+	/* Timeout for current RPC client action. */
+	uint64_t timeout;
+};
+
 struct load_json_config_ctx {
 	/* Thread used during configuration. */
 	struct spdk_thread *thread;
@@ -110,25 +124,51 @@ struct load_json_config_ctx {
 	size_t values_cnt;
 	struct spdk_json_val *values;
 
+	/* Holds strings decoded from the current "config" entry. */
+	struct spdk_json_arena *arena;
+
 	char rpc_socket_path_temp[RPC_SOCKET_PATH_MAX + 1];
 
-	struct spdk_jsonrpc_client *client_conn;
+	struct load_json_config_client clients[RPC_CLIENT_MAX_PARALLEL_REQUESTS];
 	struct spdk_poller *client_conn_poller;
 
-	client_resp_handler client_resp_cb;
+	/* Number of clients with a request in flight */
+	uint32_t clients_busy;
+	/* Method of the requests in flight if they may run in parallel, NULL otherwise */
+	const char *parallel_method;
+	/* Config entry processing waits for requests in flight to complete */
+	bool waiting;
 
-	/* Timeout for current RPC client action. */
-	uint64_t timeout;
+	/* Start of the current subsystem config pass and the number of requests sent by it */
+	uint64_t subsystem_start_tsc;
+	uint32_t subsystem_requests;
+};
+
+/*
+ * Methods that don't depend on the completion of earlier entries with the same method,
+ * so consecutive entries calling them are sent without waiting for each other. Any
+ * other entry waits for all requests in flight and is the only request in flight.
+ */
+static const char *const g_parallel_methods[] = {
+	"bdev_nvme_attach_controller",
+	"bdev_aio_create",
+	"bdev_malloc_create",
+	"bdev_null_create",
 };
 
 static void spdk_app_json_config_load_subsystem(void *_ctx);
+static void spdk_app_json_config_load_subsystem_config_entry(void *_ctx);
 
 static void
 spdk_app_json_config_load_done(struct load_json_config_ctx *ctx, int rc)
 {
+	uint32_t i;
+
 	spdk_poller_unregister(&ctx->client_conn_poller);
-	if (ctx->client_conn != NULL) {
-		spdk_jsonrpc_client_close(ctx->client_conn);
+	for (i = 0; i < RPC_CLIENT_MAX_PARALLEL_REQUESTS; i++) {
+		if (ctx->clients[i].conn != NULL) {
+			spdk_jsonrpc_client_close(ctx->clients[i].conn);
+		}
 	}
 
 	spdk_rpc_finish();
@@ -138,19 +178,20 @@ spdk_app_json_config_load_done(struct load_json_config_ctx *ctx, int rc)
 
 	free(ctx->json_data);
 	free(ctx->values);
+	spdk_json_arena_free(ctx->arena);
 	free(ctx);
 }
 
 static void
-rpc_client_set_timeout(struct load_json_config_ctx *ctx, uint64_t timeout_us)
+rpc_client_set_timeout(struct load_json_config_client *client, uint64_t timeout_us)
 {
-	ctx->timeout = spdk_get_ticks() + timeout_us * spdk_get_ticks_hz() / (1000 * 1000);
+	client->timeout = spdk_get_ticks() + timeout_us * spdk_get_ticks_hz() / (1000 * 1000);
 }
 
 static int
-rpc_client_check_timeout(struct load_json_config_ctx *ctx)
+rpc_client_check_timeout(struct load_json_config_client *client)
 {
-	if (ctx->timeout < spdk_get_ticks()) {
+	if (client->timeout < spdk_get_ticks()) {
 		SPDK_WARNLOG("RPC client command timeout.\n");
 		return -ETIMEDOUT;
 	}
@@ -162,49 +203,58 @@ static int
 rpc_client_poller(void *arg)
 {
 	struct load_json_config_ctx *ctx = arg;
+	struct load_json_config_client *client;
 	struct spdk_jsonrpc_client_response *resp;
-	client_resp_handler cb;
+	bool completed = false;
+	bool failed;
+	uint32_t i;
 	int rc;
 
 	assert(spdk_get_thread() == ctx->thread);
 
-	rc = spdk_jsonrpc_client_poll(ctx->client_conn, 0);
-	if (rc == 0) {
-		rc = rpc_client_check_timeout(ctx);
-		if (rc == -ETIMEDOUT) {
-			rpc_client_set_timeout(ctx, RPC_CLIENT_REQUEST_TIMEOUT_US);
-			rc = 0;
+	for (i = 0; i < RPC_CLIENT_MAX_PARALLEL_REQUESTS && ctx->clients_busy > 0; i++) {
+		client = &ctx->clients[i];
+		if (!client->busy) {
+			continue;
 		}
-	}
 
-	if (rc == 0) {
-		/* No response yet */
-		return -1;
-	} else if (rc < 0) {
-		spdk_app_json_config_load_done(ctx, rc);
-		return -1;
-	}
+		rc = spdk_jsonrpc_client_poll(client->conn, 0);
+		if (rc == 0) {
+			/* No response yet */
+			if (rpc_client_check_timeout(client) == -ETIMEDOUT) {
+				rpc_client_set_timeout(client, RPC_CLIENT_REQUEST_TIMEOUT_US);
+			}
+			continue;
+		} else if (rc < 0) {
+			spdk_app_json_config_load_done(ctx, rc);
+			return -1;
+		}
 
-	resp = spdk_jsonrpc_client_get_response(ctx->client_conn);
-	assert(resp);
+		resp = spdk_jsonrpc_client_get_response(client->conn);
+		assert(resp);
 
-	if (resp->error) {
-		SPDK_ERRLOG("error response: %*s", (int)resp->error->len, (char *)resp->error->start);
-	}
+		client->busy = false;
+		ctx->clients_busy--;
+		completed = true;
 
-	if (resp->error && ctx->stop_on_error) {
+		failed = resp->error != NULL;
+		if (failed) {
+			SPDK_ERRLOG("error response: %*s", (int)resp->error->len, (char *)resp->error->start);
+		}
+
+		/* Don't care about the response */
 		spdk_jsonrpc_client_free_response(resp);
-		spdk_app_json_config_load_done(ctx, -EINVAL);
-	} else {
-		/* We have response so we must have callback for it. */
-		cb = ctx->client_resp_cb;
-		assert(cb != NULL);
 
-		/* Mark we are done with this handler. */
-		ctx->client_resp_cb = NULL;
-		cb(ctx, resp);
+		if (failed && ctx->stop_on_error) {
+			spdk_app_json_config_load_done(ctx, -EINVAL);
+			return -1;
+		}
 	}
 
+	if (completed && ctx->waiting) {
+		ctx->waiting = false;
+		spdk_app_json_config_load_subsystem_config_entry(ctx);
+	}
 
 	return -1;
 }
@@ -213,41 +263,69 @@ static int
 rpc_client_connect_poller(void *_ctx)
 {
 	struct load_json_config_ctx *ctx = _ctx;
+	struct load_json_config_client *client;
+	bool connected = true;
+	uint32_t i;
 	int rc;
 
-	rc = spdk_jsonrpc_client_poll(ctx->client_conn, 0);
-	if (rc != -ENOTCONN) {
+	for (i = 0; i < RPC_CLIENT_MAX_PARALLEL_REQUESTS; i++) {
+		client = &ctx->clients[i];
+		if (client->connected) {
+			continue;
+		}
+
+		rc = spdk_jsonrpc_client_poll(client->conn, 0);
+		if (rc != -ENOTCONN) {
+			client->connected = true;
+			continue;
+		}
+
+		rc = rpc_client_check_timeout(client);
+		if (rc) {
+			spdk_app_json_config_load_done(ctx, rc);
+			return -1;
+		}
+		connected = false;
+	}
+
+	if (connected) {
 		/* We are connected. Start regular poller and issue first request */
 		spdk_poller_unregister(&ctx->client_conn_poller);
 		ctx->client_conn_poller = spdk_poller_register(rpc_client_poller, ctx, 100);
 		spdk_app_json_config_load_subsystem(ctx);
-	} else {
-		rc = rpc_client_check_timeout(ctx);
-		if (rc) {
-			spdk_app_json_config_load_done(ctx, rc);
-		}
 	}
 
 	return -1;
 }
 
 static int
-client_send_request(struct load_json_config_ctx *ctx, struct spdk_jsonrpc_client_request *request,
-		    client_resp_handler client_resp_cb)
+client_send_request(struct load_json_config_ctx *ctx, struct spdk_jsonrpc_client_request *request)
 {
+	struct load_json_config_client *client = NULL;
+	uint32_t i;
 	int rc;
 
 	assert(spdk_get_thread() == ctx->thread);
 
-	ctx->client_resp_cb = client_resp_cb;
-	rpc_client_set_timeout(ctx, RPC_CLIENT_REQUEST_TIMEOUT_US);
-	rc = spdk_jsonrpc_client_send_request(ctx->client_conn, request);
+	for (i = 0; i < RPC_CLIENT_MAX_PARALLEL_REQUESTS; i++) {
+		if (!ctx->clients[i].busy) {
+			client = &ctx->clients[i];
+			break;
+		}
+	}
+	assert(client != NULL);
 
+	rpc_client_set_timeout(client, RPC_CLIENT_REQUEST_TIMEOUT_US);
+	rc = spdk_jsonrpc_client_send_request(client->conn, request);
 	if (rc) {
 		SPDK_DEBUG_APP_CFG("Sending request to client failed (%d)\n", rc);
+		return rc;
 	}
 
-	return rc;
+	client->busy = true;
+	ctx->clients_busy++;
+	ctx->subsystem_requests++;
+	return 0;
 }
 
 static int
@@ -300,96 +378,135 @@ static struct spdk_json_object_decoder jsonrpc_cmd_decoders[] = {
 	{"params", offsetof(struct config_entry, params), cap_object, true}
 };
 
-static void spdk_app_json_config_load_subsystem_config_entry(void *_ctx);
+static const char *
+config_entry_parallel_method(const char *method)
+{
+	size_t i;
+
+	for (i = 0; i < SPDK_COUNTOF(g_parallel_methods); i++) {
+		if (strcmp(method, g_parallel_methods[i]) == 0) {
+			return g_parallel_methods[i];
+		}
+	}
+
+	return NULL;
+}
 
 static void
-spdk_app_json_config_load_subsystem_config_entry_next(struct load_json_config_ctx *ctx,
-		struct spdk_jsonrpc_client_response *resp)
+spdk_app_json_config_load_subsystem_done(struct load_json_config_ctx *ctx)
 {
-	/* Don't care about the response */
-	spdk_jsonrpc_client_free_response(resp);
+	char name[64];
 
-	ctx->config_it = spdk_json_next(ctx->config_it);
-	spdk_app_json_config_load_subsystem_config_entry(ctx);
+	SPDK_DEBUG_APP_CFG("Subsystem '%.*s': configuration done.\n", ctx->subsystem_name->len,
+			   (char *)ctx->subsystem_name->start);
+
+	if (ctx->subsystem_requests > 0) {
+		snprintf(name, sizeof(name), "%.*s (%s)", (int)spdk_min(ctx->subsystem_name->len, 48),
+			 (char *)ctx->subsystem_name->start,
+			 spdk_rpc_get_state() == SPDK_RPC_STARTUP ? "startup" : "runtime");
+		spdk_app_timeline_add("json_config", name, ctx->subsystem_start_tsc, ctx->subsystem_requests);
+	}
+
+	ctx->subsystems_it = spdk_json_next(ctx->subsystems_it);
+	/* Invoke later to avoid recurrency */
+	spdk_thread_send_msg(ctx->thread, spdk_app_json_config_load_subsystem, ctx);
 }
 
-/* Load "config" entry */
+/*
+ * Load "config" entries, starting with the one pointed by ctx->config_it. Requests
+ * are sent until an entry has to wait for the requests in flight, in which case
+ * the poller calls this function again once a response arrives.
+ */
 static void
 spdk_app_json_config_load_subsystem_config_entry(void *_ctx)
 {
 	struct load_json_config_ctx *ctx = _ctx;
 	struct spdk_jsonrpc_client_request *rpc_request;
 	struct spdk_json_write_ctx *w;
-	struct config_entry cfg = {};
+	struct config_entry cfg;
 	struct spdk_json_val *params_end;
+	const char *parallel_method;
 	size_t params_len;
 	int rc;
 
-	if (ctx->config_it == NULL) {
-		SPDK_DEBUG_APP_CFG("Subsystem '%.*s': configuration done.\n", ctx->subsystem_name->len,
-				   (char *)ctx->subsystem_name->start);
-		ctx->subsystems_it = spdk_json_next(ctx->subsystems_it);
-		/* Invoke later to avoid recurrency */
-		spdk_thread_send_msg(ctx->thread, spdk_app_json_config_load_subsystem, ctx);
-		return;
-	}
+	for (; ctx->config_it != NULL; ctx->config_it = spdk_json_next(ctx->config_it)) {
+		/* Strings decoded from the previous entry are no longer needed */
+		spdk_json_arena_reset(ctx->arena);
+		memset(&cfg, 0, sizeof(cfg));
+
+		if (spdk_json_decode_object_arena(ctx->config_it, jsonrpc_cmd_decoders,
+						  SPDK_COUNTOF(jsonrpc_cmd_decoders), &cfg, ctx->arena)) {
+			params_end = spdk_json_next(ctx->config_it);
+			assert(params_end != NULL);
+			params_len = params_end->start - ctx->config->start + 1;
+			SPDK_ERRLOG("Failed to decode config entry: %*s!\n", (int)params_len, (char *)ctx->config_it);
+			spdk_app_json_config_load_done(ctx, -EINVAL);
+			return;
+		}
 
-	if (spdk_json_decode_object(ctx->config_it, jsonrpc_cmd_decoders,
-				    SPDK_COUNTOF(jsonrpc_cmd_decoders), &cfg)) {
-		params_end = spdk_json_next(ctx->config_it);
-		assert(params_end != NULL);
-		params_len = params_end->start - ctx->config->start + 1;
-		SPDK_ERRLOG("Failed to decode config entry: %*s!\n", (int)params_len, (char *)ctx->config_it);
-		spdk_app_json_config_load_done(ctx, -EINVAL);
-		goto out;
-	}
+		rc = spdk_rpc_is_method_allowed(cfg.method, spdk_rpc_get_state());
+		if (rc == -EPERM) {
+			SPDK_DEBUG_APP_CFG("Method '%s' not allowed -> skipping\n", cfg.method);
+			continue;
+		}
 
-	rc = spdk_rpc_is_method_allowed(cfg.method, spdk_rpc_get_state());
-	if (rc == -EPERM) {
-		SPDK_DEBUG_APP_CFG("Method '%s' not allowed -> skipping\n", cfg.method);
-		/* Invoke later to avoid recurrency */
-		ctx->config_it = spdk_json_next(ctx->config_it);
-		spdk_thread_send_msg(ctx->thread, spdk_app_json_config_load_subsystem_config_entry, ctx);
-		goto out;
-	}
+		/*
+		 * Wait for the requests in flight unless this entry may run in parallel with
+		 * them and there is a client free to send it.
+		 */
+		parallel_method = config_entry_parallel_method(cfg.method);
+		if (ctx->clients_busy > 0 &&
+		    (parallel_method == NULL || parallel_method != ctx->parallel_method ||
+		     ctx->clients_busy == RPC_CLIENT_MAX_PARALLEL_REQUESTS)) {
+			ctx->waiting = true;
+			return;
+		}
 
-	/* Get _END by skipping params and going back by one element. */
-	params_end = cfg.params + spdk_json_val_len(cfg.params) - 1;
+		/* Get _END by skipping params and going back by one element. */
+		params_end = cfg.params + spdk_json_val_len(cfg.params) - 1;
 
-	/* Need to add one character to include '}' */
-	params_len = params_end->start - cfg.params->start + 1;
+		/* Need to add one character to include '}' */
+		params_len = params_end->start - cfg.params->start + 1;
 
-	SPDK_DEBUG_APP_CFG("\tmethod: %s\n", cfg.method);
-	SPDK_DEBUG_APP_CFG("\tparams: %.*s\n", (int)params_len, (char *)cfg.params->start);
+		SPDK_DEBUG_APP_CFG("\tmethod: %s\n", cfg.method);
+		SPDK_DEBUG_APP_CFG("\tparams: %.*s\n", (int)params_len, (char *)cfg.params->start);
 
-	rpc_request = spdk_jsonrpc_client_create_request();
-	if (!rpc_request) {
-		spdk_app_json_config_load_done(ctx, -errno);
-		goto out;
-	}
+		rpc_request = spdk_jsonrpc_client_create_request();
+		if (!rpc_request) {
+			spdk_app_json_config_load_done(ctx, -errno);
+			return;
+		}
 
-	w = spdk_jsonrpc_begin_request(rpc_request, ctx->rpc_request_id, NULL);
-	if (!w) {
-		spdk_jsonrpc_client_free_request(rpc_request);
-		spdk_app_json_config_load_done(ctx, -ENOMEM);
-		goto out;
-	}
+		w = spdk_jsonrpc_begin_request(rpc_request, ctx->rpc_request_id, NULL);
+		if (!w) {
+			spdk_jsonrpc_client_free_request(rpc_request);
+			spdk_app_json_config_load_done(ctx, -ENOMEM);
+			return;
+		}
+
+		spdk_json_write_named_string(w, "method", cfg.method);
 
-	spdk_json_write_named_string(w, "method", cfg.method);
+		/* No need to parse "params". Just dump the whole content of "params"
+		 * directly into the request and let the remote side verify it. */
+		spdk_json_write_name(w, "params");
+		spdk_json_write_val_raw(w, cfg.params->start, params_len);
+		spdk_jsonrpc_end_request(rpc_request, w);
 
-	/* No need to parse "params". Just dump the whole content of "params"
-	 * directly into the request and let the remote side verify it. */
-	spdk_json_write_name(w, "params");
-	spdk_json_write_val_raw(w, cfg.params->start, params_len);
-	spdk_jsonrpc_end_request(rpc_request, w);
+		rc = client_send_request(ctx, rpc_request);
+		if (rc != 0) {
+			spdk_app_json_config_load_done(ctx, -rc);
+			return;
+		}
+
+		ctx->parallel_method = parallel_method;
+	}
 
-	rc = client_send_request(ctx, rpc_request, spdk_app_json_config_load_subsystem_config_entry_next);
-	if (rc != 0) {
-		spdk_app_json_config_load_done(ctx, -rc);
-		goto out;
+	if (ctx->clients_busy > 0) {
+		ctx->waiting = true;
+		return;
 	}
-out:
-	free(cfg.method);
+
+	spdk_app_json_config_load_subsystem_done(ctx);
 }
 
 static void
@@ -465,6 +582,8 @@ spdk_app_json_config_load_subsystem(void *_ctx)
 
 	/* Get 'config' array first configuration entry */
 	ctx->config_it = spdk_json_array_first(ctx->config);
+	ctx->subsystem_start_tsc = spdk_get_ticks();
+	ctx->subsystem_requests = 0;
 	spdk_app_json_config_load_subsystem_config_entry(ctx);
 }
 
@@ -537,6 +656,7 @@ spdk_app_json_config_load(const char *json_config_file, const char *rpc_addr,
 			  bool stop_on_error)
 {
 	struct load_json_config_ctx *ctx = calloc(1, sizeof(*ctx));
+	uint32_t i;
 	int rc;
 
 	assert(cb_fn);
@@ -550,6 +670,11 @@ spdk_app_json_config_load(const char *json_config_file, const char *rpc_addr,
 	ctx->stop_on_error = stop_on_error;
 	ctx->thread = spdk_get_thread();
 
+	ctx->arena = spdk_json_arena_create(0);
+	if (ctx->arena == NULL) {
+		goto fail;
+	}
+
 	rc = spdk_app_json_config_read(json_config_file, ctx);
 	if (rc) {
 		goto fail;
@@ -582,13 +707,16 @@ spdk_app_json_config_load(const char *json_config_file, const char *rpc_addr,
 
 	/* FIXME: spdk_rpc_initialize() function should return error code. */
 	spdk_rpc_initialize(ctx->rpc_socket_path_temp);
-	ctx->client_conn = spdk_jsonrpc_client_connect(ctx->rpc_socket_path_temp, AF_UNIX);
-	if (ctx->client_conn == NULL) {
-		SPDK_ERRLOG("Failed to connect to '%s'\n", ctx->rpc_socket_path_temp);
-		goto fail;
+	for (i = 0; i < RPC_CLIENT_MAX_PARALLEL_REQUESTS; i++) {
+		ctx->clients[i].conn = spdk_jsonrpc_client_connect(ctx->rpc_socket_path_temp, AF_UNIX);
+		if (ctx->clients[i].conn == NULL) {
+			SPDK_ERRLOG("Failed to connect to '%s'\n", ctx->rpc_socket_path_temp);
+			goto fail;
+		}
+
+		rpc_client_set_timeout(&ctx->clients[i], RPC_CLIENT_CONNECT_TIMEOUT_US);
 	}
 
-	rpc_client_set_timeout(ctx, RPC_CLIENT_CONNECT_TIMEOUT_US);
 	ctx->client_conn_poller = spdk_poller_register(rpc_client_connect_poller, ctx, 100);
 	return;
 
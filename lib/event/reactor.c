@@ -40,6 +40,7 @@
 
 #include "spdk/log.h"
 #include "spdk/thread.h"
+#include "spdk/trace.h"
 #include "spdk/env.h"
 #include "spdk/util.h"
 
@@ -320,7 +321,9 @@ reactor_run(struct spdk_reactor *reactor)
 
 	TAILQ_FOREACH_SAFE(lw_thread, &reactor->threads, link, tmp) {
 		thread = spdk_thread_get_from_ctx(lw_thread);
+		spdk_trace_set_thread_id(spdk_thread_get_id(thread));
 		spdk_thread_poll(thread, 0, reactor->tsc_last);
+		spdk_trace_set_thread_id(0);
 		reactor->tsc_last = spdk_thread_get_last_tsc(thread);
 
 		if (spdk_unlikely(lw_thread->resched)) {
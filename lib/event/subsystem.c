@@ -42,6 +42,12 @@
 struct spdk_subsystem_list g_subsystems = TAILQ_HEAD_INITIALIZER(g_subsystems);
 struct spdk_subsystem_depend_list g_subsystems_deps = TAILQ_HEAD_INITIALIZER(g_subsystems_deps);
 static struct spdk_subsystem *g_next_subsystem;
+/* Subsystem without concurrent_init that is being initialized */
+static struct spdk_subsystem *g_serial_subsystem;
+static uint32_t g_subsystems_init_pending;
+static bool g_subsystems_init_scheduling = false;
+static bool g_subsystems_init_rescan = false;
+static bool g_subsystems_init_failed = false;
 static bool g_subsystems_initialized = false;
 static bool g_subsystems_init_interrupted = false;
 static spdk_subsystem_init_fn g_subsystem_start_fn = NULL;
@@ -117,43 +123,164 @@ subsystem_sort(void)
 	}
 }
 
-void
-spdk_subsystem_init_next(int rc)
+static bool
+subsystem_deps_initialized(struct spdk_subsystem *subsystem)
+{
+	struct spdk_subsystem_depend *dep;
+	struct spdk_subsystem *depends_on;
+
+	TAILQ_FOREACH(dep, &g_subsystems_deps, tailq) {
+		if (strcmp(subsystem->name, dep->name) != 0) {
+			continue;
+		}
+
+		depends_on = spdk_subsystem_find(&g_subsystems, dep->depends_on);
+		if (depends_on == NULL || depends_on->init_state != SPDK_SUBSYSTEM_INIT_DONE) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void subsystem_init_complete(struct spdk_subsystem *subsystem, int rc);
+
+static void
+subsystem_init_start(struct spdk_subsystem *subsystem)
+{
+	subsystem->init_state = SPDK_SUBSYSTEM_INIT_IN_PROGRESS;
+	subsystem->init_start_tsc = spdk_get_ticks();
+	if (!subsystem->concurrent_init) {
+		g_serial_subsystem = subsystem;
+	}
+
+	if (subsystem->init) {
+		subsystem->init();
+	} else {
+		subsystem_init_complete(subsystem, 0);
+	}
+}
+
+/*
+ * Start initializing every subsystem that is ready, i.e. all of its dependencies
+ * are initialized. Subsystems without concurrent_init also wait for all subsystems
+ * before them in g_subsystems and hold back all subsystems after them.
+ */
+static void
+subsystem_init_schedule(void)
+{
+	struct spdk_subsystem *subsystem;
+	bool preceding_done;
+
+	if (g_subsystems_init_scheduling) {
+		/* An init() completed synchronously - look again once it returns. */
+		g_subsystems_init_rescan = true;
+		return;
+	}
+
+	g_subsystems_init_scheduling = true;
+	do {
+		g_subsystems_init_rescan = false;
+		preceding_done = true;
+
+		TAILQ_FOREACH(subsystem, &g_subsystems, tailq) {
+			if (g_subsystems_init_failed || g_subsystems_init_interrupted) {
+				break;
+			}
+
+			if (subsystem->init_state == SPDK_SUBSYSTEM_INIT_DONE) {
+				continue;
+			}
+
+			if (!subsystem->concurrent_init) {
+				if (preceding_done && subsystem->init_state == SPDK_SUBSYSTEM_INIT_PENDING) {
+					subsystem_init_start(subsystem);
+				}
+				if (subsystem->init_state != SPDK_SUBSYSTEM_INIT_DONE) {
+					break;
+				}
+				continue;
+			}
+
+			if (subsystem->init_state == SPDK_SUBSYSTEM_INIT_PENDING &&
+			    subsystem_deps_initialized(subsystem)) {
+				subsystem_init_start(subsystem);
+			}
+			if (subsystem->init_state != SPDK_SUBSYSTEM_INIT_DONE) {
+				preceding_done = false;
+			}
+		}
+	} while (g_subsystems_init_rescan);
+	g_subsystems_init_scheduling = false;
+
+	if (g_subsystems_init_pending == 0 && !g_subsystems_initialized &&
+	    !g_subsystems_init_failed && !g_subsystems_init_interrupted) {
+		g_subsystems_initialized = true;
+		g_subsystem_start_fn(0, g_subsystem_start_arg);
+	}
+}
+
+static void
+subsystem_init_complete(struct spdk_subsystem *subsystem, int rc)
 {
 	/* The initialization is interrupted by the spdk_subsystem_fini, so just return */
 	if (g_subsystems_init_interrupted) {
 		return;
 	}
 
+	assert(subsystem->init_state == SPDK_SUBSYSTEM_INIT_IN_PROGRESS);
+	subsystem->init_state = SPDK_SUBSYSTEM_INIT_DONE;
+	g_subsystems_init_pending--;
+	if (subsystem == g_serial_subsystem) {
+		g_serial_subsystem = NULL;
+	}
+
+	spdk_app_timeline_add("subsystem_init", subsystem->name, subsystem->init_start_tsc, 0);
+
+	if (g_subsystems_init_failed) {
+		/* Another subsystem failed already and the failure has been reported */
+		return;
+	}
+
 	if (rc) {
-		SPDK_ERRLOG("Init subsystem %s failed\n", g_next_subsystem->name);
+		SPDK_ERRLOG("Init subsystem %s failed\n", subsystem->name);
+		g_subsystems_init_failed = true;
 		g_subsystem_start_fn(rc, g_subsystem_start_arg);
 		return;
 	}
 
-	if (!g_next_subsystem) {
-		g_next_subsystem = TAILQ_FIRST(&g_subsystems);
-	} else {
-		g_next_subsystem = TAILQ_NEXT(g_next_subsystem, tailq);
-	}
+	subsystem_init_schedule();
+}
 
-	if (!g_next_subsystem) {
-		g_subsystems_initialized = true;
-		g_subsystem_start_fn(0, g_subsystem_start_arg);
+void
+spdk_subsystem_init_next(int rc)
+{
+	/* The initialization is interrupted by the spdk_subsystem_fini, so just return */
+	if (g_subsystems_init_interrupted) {
 		return;
 	}
 
-	if (g_next_subsystem->init) {
-		g_next_subsystem->init();
-	} else {
-		spdk_subsystem_init_next(0);
+	if (g_serial_subsystem == NULL) {
+		SPDK_ERRLOG("spdk_subsystem_init_next() called with no subsystem being initialized\n");
+		assert(false);
+		return;
 	}
+
+	subsystem_init_complete(g_serial_subsystem, rc);
+}
+
+void
+spdk_subsystem_init_done(struct spdk_subsystem *subsystem, int rc)
+{
+	assert(subsystem->concurrent_init);
+	subsystem_init_complete(subsystem, rc);
 }
 
 void
 spdk_subsystem_init(spdk_subsystem_init_fn cb_fn, void *cb_arg)
 {
 	struct spdk_subsystem_depend *dep;
+	struct spdk_subsystem *subsystem;
 
 	g_subsystem_start_fn = cb_fn;
 	g_subsystem_start_arg = cb_arg;
@@ -175,7 +302,15 @@ spdk_subsystem_init(spdk_subsystem_init_fn cb_fn, void *cb_arg)
 
 	subsystem_sort();
 
-	spdk_subsystem_init_next(0);
+	g_subsystems_init_pending = 0;
+	g_subsystems_initialized = false;
+	g_subsystems_init_failed = false;
+	TAILQ_FOREACH(subsystem, &g_subsystems, tailq) {
+		subsystem->init_state = SPDK_SUBSYSTEM_INIT_PENDING;
+		g_subsystems_init_pending++;
+	}
+
+	subsystem_init_schedule();
 }
 
 static void
@@ -184,22 +319,19 @@ _spdk_subsystem_fini_next(void *arg1)
 	assert(g_fini_thread == spdk_get_thread());
 
 	if (!g_next_subsystem) {
-		/* If the initialized flag is false, then we've failed to initialize
-		 * the very first subsystem and no de-init is needed
-		 */
-		if (g_subsystems_initialized) {
-			g_next_subsystem = TAILQ_LAST(&g_subsystems, spdk_subsystem_list);
-		}
-	} else {
-		if (g_subsystems_initialized || g_subsystems_init_interrupted) {
-			g_next_subsystem = TAILQ_PREV(g_next_subsystem, spdk_subsystem_list, tailq);
-		} else {
+		/* First call - stop any initialization still in progress */
+		if (!g_subsystems_initialized) {
 			g_subsystems_init_interrupted = true;
 		}
+		g_next_subsystem = TAILQ_LAST(&g_subsystems, spdk_subsystem_list);
+	} else {
+		g_next_subsystem = TAILQ_PREV(g_next_subsystem, spdk_subsystem_list, tailq);
 	}
 
 	while (g_next_subsystem) {
-		if (g_next_subsystem->fini) {
+		/* Subsystems whose initialization never started don't need de-init */
+		if (g_next_subsystem->fini &&
+		    g_next_subsystem->init_state != SPDK_SUBSYSTEM_INIT_PENDING) {
 			g_next_subsystem->fini();
 			return;
 		}
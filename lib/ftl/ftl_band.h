@@ -155,6 +155,9 @@ struct ftl_band {
 	/* Latest merit calculation */
 	double					merit;
 
+	/* Write stream the band was opened for */
+	enum ftl_stream				stream;
+
 	/* High defrag priority - means that the metadata should be copied and */
 	/* the band should be defragged immediately */
 	int					high_prio;
@@ -69,6 +69,9 @@ struct ftl_wptr {
 	/* Band currently being written to */
 	struct ftl_band			*band;
 
+	/* Write stream the band is written through */
+	enum ftl_stream			stream;
+
 	/* Current logical block's offset */
 	uint64_t			offset;
 
@@ -193,86 +196,264 @@ ftl_release_wbuf_entry(struct ftl_wbuf_entry *entry)
 	spdk_ring_enqueue(io_channel->free_queue, (void **)&entry, 1, NULL);
 }
 
+/*
+ * Ratio of a range's write count to the average one (among the ranges written recently) above
+ * which the range is considered hot
+ */
+#define FTL_WRITE_HEAT_RATIO 2
+
+static enum ftl_stream
+ftl_write_heat_update(struct spdk_ftl_dev *dev, uint64_t lba)
+{
+	struct ftl_write_heat *heat = &dev->heat;
+	uint64_t i, range = lba >> FTL_WRITE_HEAT_RANGE_SHIFT;
+
+	assert(range < heat->num_ranges);
+	if (heat->counters[range] < UINT16_MAX) {
+		if (heat->counters[range]++ == 0) {
+			heat->num_active++;
+		}
+
+		heat->sum++;
+	}
+
+	/* Age the counters, so that they reflect the recent write pattern */
+	if (++heat->num_writes >= heat->decay_interval) {
+		heat->sum = 0;
+		heat->num_active = 0;
+		for (i = 0; i < heat->num_ranges; ++i) {
+			heat->counters[i] /= 2;
+			heat->sum += heat->counters[i];
+			heat->num_active += heat->counters[i] != 0;
+		}
+
+		heat->num_writes = 0;
+	}
+
+	if (heat->counters[range] * heat->num_active > FTL_WRITE_HEAT_RATIO * heat->sum) {
+		return FTL_STREAM_HOT;
+	}
+
+	return FTL_STREAM_COLD;
+}
+
+static enum ftl_stream
+ftl_wbuf_entry_stream(struct spdk_ftl_dev *dev, const struct ftl_wbuf_entry *entry)
+{
+	if (dev->num_streams == 1) {
+		return FTL_STREAM_HOT;
+	}
+
+	/* Padding is always directed to the stream it was requested for */
+	if (entry->io_flags & FTL_IO_PAD) {
+		return entry->stream;
+	}
+
+	if (entry->io_flags & FTL_IO_WEAK) {
+		return FTL_STREAM_RELOC;
+	}
+
+	return ftl_write_heat_update(dev, entry->lba);
+}
+
 static struct ftl_batch *
-ftl_get_next_batch(struct spdk_ftl_dev *dev)
+ftl_get_pending_batch(struct spdk_ftl_dev *dev, enum ftl_stream stream)
 {
-	struct ftl_batch *batch = dev->current_batch;
-	struct ftl_io_channel *ioch;
-#define FTL_DEQUEUE_ENTRIES 128
-	struct ftl_wbuf_entry *entries[FTL_DEQUEUE_ENTRIES];
-	TAILQ_HEAD(, ftl_io_channel) ioch_queue;
-	size_t i, num_dequeued, num_remaining;
-	uint64_t *metadata;
+	struct ftl_batch *batch;
 
-	if (batch == NULL) {
-		batch = TAILQ_FIRST(&dev->pending_batches);
-		if (batch != NULL) {
+	TAILQ_FOREACH(batch, &dev->pending_batches, tailq) {
+		if (batch->stream == stream) {
 			TAILQ_REMOVE(&dev->pending_batches, batch, tailq);
 			return batch;
 		}
+	}
+
+	return NULL;
+}
+
+static bool
+ftl_prep_current_batches(struct spdk_ftl_dev *dev)
+{
+	struct ftl_batch *batch;
+	unsigned int stream;
+
+	for (stream = 0; stream < dev->num_streams; ++stream) {
+		if (dev->current_batch[stream] != NULL) {
+			continue;
+		}
 
 		batch = TAILQ_FIRST(&dev->free_batches);
 		if (spdk_unlikely(batch == NULL)) {
-			return NULL;
+			return false;
 		}
 
 		assert(TAILQ_EMPTY(&batch->entries));
 		assert(batch->num_entries == 0);
 		TAILQ_REMOVE(&dev->free_batches, batch, tailq);
+		batch->stream = stream;
+		dev->current_batch[stream] = batch;
 	}
 
+	return true;
+}
+
+static size_t
+ftl_current_batches_space(const struct spdk_ftl_dev *dev)
+{
+	size_t space = dev->xfer_size;
+	unsigned int stream;
+
+	for (stream = 0; stream < dev->num_streams; ++stream) {
+		space = spdk_min(space, dev->xfer_size - dev->current_batch[stream]->num_entries);
+	}
+
+	return space;
+}
+
+static void
+ftl_release_current_batches(struct spdk_ftl_dev *dev)
+{
+	struct ftl_batch *batch;
+	unsigned int stream;
+
+	/* Return the batches that didn't receive any entries */
+	for (stream = 0; stream < dev->num_streams; ++stream) {
+		batch = dev->current_batch[stream];
+		if (batch != NULL && batch->num_entries == 0) {
+			TAILQ_INSERT_HEAD(&dev->free_batches, batch, tailq);
+			dev->current_batch[stream] = NULL;
+		}
+	}
+}
+
+static struct ftl_batch *
+ftl_batch_add_entry(struct spdk_ftl_dev *dev, struct ftl_wbuf_entry *entry)
+{
+	struct ftl_batch *batch;
+	uint64_t *metadata;
+
+	entry->stream = ftl_wbuf_entry_stream(dev, entry);
+	batch = dev->current_batch[entry->stream];
+	assert(batch != NULL && batch->num_entries < dev->xfer_size);
+
+	batch->iov[batch->num_entries].iov_base = entry->payload;
+	batch->iov[batch->num_entries].iov_len = FTL_BLOCK_SIZE;
+
+	if (batch->metadata != NULL) {
+		metadata = (uint64_t *)((char *)batch->metadata + batch->num_entries * dev->md_size);
+		*metadata = entry->lba;
+	}
+
+	TAILQ_INSERT_TAIL(&batch->entries, entry, tailq);
+	if (++batch->num_entries < dev->xfer_size) {
+		return NULL;
+	}
+
+	TAILQ_INSERT_TAIL(&dev->pending_batches, batch, tailq);
+	dev->current_batch[entry->stream] = NULL;
+
+	return batch;
+}
+
+/*
+ * Moves the write buffer entries from IO channels' submission queues onto the batches of their
+ * write streams.  Stops as soon as a batch of the specified stream is filled up or, if
+ * FTL_STREAM_COUNT is passed, once all of the queues are drained.
+ */
+static void
+ftl_route_wbuf_entries(struct spdk_ftl_dev *dev, enum ftl_stream stream)
+{
+	struct ftl_io_channel *ioch;
+#define FTL_DEQUEUE_ENTRIES 128
+	struct ftl_wbuf_entry *entries[FTL_DEQUEUE_ENTRIES];
+	TAILQ_HEAD(, ftl_io_channel) ioch_queue;
+	struct ftl_batch *batch;
+	size_t i, num_dequeued;
+	bool done = false;
+
 	/*
 	 * Keep shifting the queue to ensure fairness in IO channel selection.  Each time
 	 * ftl_get_next_batch() is called, we're starting to dequeue write buffer entries from a
 	 * different IO channel.
 	 */
 	TAILQ_INIT(&ioch_queue);
-	while (!TAILQ_EMPTY(&dev->ioch_queue)) {
+	while (!done && !TAILQ_EMPTY(&dev->ioch_queue)) {
 		ioch = TAILQ_FIRST(&dev->ioch_queue);
 		TAILQ_REMOVE(&dev->ioch_queue, ioch, tailq);
 		TAILQ_INSERT_TAIL(&ioch_queue, ioch, tailq);
 
-		num_remaining = dev->xfer_size - batch->num_entries;
-		while (num_remaining > 0) {
+		while (!done) {
+			if (spdk_unlikely(!ftl_prep_current_batches(dev))) {
+				done = true;
+				break;
+			}
+
+			/* Only dequeue as many entries as can be placed regardless of their stream */
 			num_dequeued = spdk_ring_dequeue(ioch->submit_queue, (void **)entries,
-							 spdk_min(num_remaining,
+							 spdk_min(ftl_current_batches_space(dev),
 									 FTL_DEQUEUE_ENTRIES));
 			if (num_dequeued == 0) {
 				break;
 			}
 
 			for (i = 0; i < num_dequeued; ++i) {
-				batch->iov[batch->num_entries + i].iov_base = entries[i]->payload;
-				batch->iov[batch->num_entries + i].iov_len = FTL_BLOCK_SIZE;
-
-				if (batch->metadata != NULL) {
-					metadata = (uint64_t *)((char *)batch->metadata +
-								i * dev->md_size);
-					*metadata = entries[i]->lba;
+				batch = ftl_batch_add_entry(dev, entries[i]);
+				if (batch != NULL && batch->stream == stream) {
+					done = true;
 				}
-
-				TAILQ_INSERT_TAIL(&batch->entries, entries[i], tailq);
 			}
-
-			batch->num_entries += num_dequeued;
-			num_remaining -= num_dequeued;
 		}
+	}
 
-		if (num_remaining == 0) {
-			break;
+	TAILQ_CONCAT(&dev->ioch_queue, &ioch_queue, tailq);
+	ftl_release_current_batches(dev);
+}
+
+static struct ftl_batch *
+ftl_get_next_batch(struct spdk_ftl_dev *dev, enum ftl_stream stream)
+{
+	struct ftl_batch *batch;
+
+	batch = ftl_get_pending_batch(dev, stream);
+	if (batch != NULL) {
+		return batch;
+	}
+
+	ftl_route_wbuf_entries(dev, stream);
+
+	return ftl_get_pending_batch(dev, stream);
+}
+
+static size_t
+ftl_stream_num_entries(const struct spdk_ftl_dev *dev, enum ftl_stream stream)
+{
+	const struct ftl_batch *batch;
+	size_t num_entries = 0;
+
+	if (dev->current_batch[stream] != NULL) {
+		num_entries += dev->current_batch[stream]->num_entries;
+	}
+
+	TAILQ_FOREACH(batch, &dev->pending_batches, tailq) {
+		if (batch->stream == stream) {
+			num_entries += batch->num_entries;
 		}
 	}
 
-	TAILQ_CONCAT(&dev->ioch_queue, &ioch_queue, tailq);
+	return num_entries;
+}
 
-	if (batch->num_entries == dev->xfer_size) {
-		dev->current_batch = NULL;
-	} else {
-		dev->current_batch = batch;
-		batch = NULL;
+static size_t
+ftl_num_queued_entries(const struct spdk_ftl_dev *dev)
+{
+	struct ftl_io_channel *ioch;
+	size_t num_entries = 0;
+
+	TAILQ_FOREACH(ioch, &dev->ioch_queue, tailq) {
+		num_entries += spdk_ring_count(ioch->submit_queue);
 	}
 
-	return batch;
+	return num_entries;
 }
 
 static void
@@ -743,7 +924,7 @@ ftl_band_set_direct_access(struct ftl_band *band, bool access)
 }
 
 static int
-ftl_add_wptr(struct spdk_ftl_dev *dev)
+ftl_add_wptr(struct spdk_ftl_dev *dev, enum ftl_stream stream)
 {
 	struct ftl_band *band;
 	struct ftl_wptr *wptr;
@@ -763,9 +944,11 @@ ftl_add_wptr(struct spdk_ftl_dev *dev)
 		return -1;
 	}
 
+	wptr->stream = stream;
+	band->stream = stream;
 	LIST_INSERT_HEAD(&dev->wptr_list, wptr, list_entry);
 
-	SPDK_DEBUGLOG(SPDK_LOG_FTL_CORE, "wptr: band %u\n", band->id);
+	SPDK_DEBUGLOG(SPDK_LOG_FTL_CORE, "wptr: band %u, stream %d\n", band->id, stream);
 	ftl_trace_write_band(dev, band);
 	return 0;
 }
@@ -932,7 +1115,7 @@ unlock:
 }
 
 static void
-ftl_pad_wbuf(struct spdk_ftl_dev *dev, size_t size)
+ftl_pad_wbuf(struct spdk_ftl_dev *dev, size_t size, enum ftl_stream stream)
 {
 	struct ftl_wbuf_entry *entry;
 	struct ftl_io_channel *ioch;
@@ -948,6 +1131,7 @@ ftl_pad_wbuf(struct spdk_ftl_dev *dev, size_t size)
 
 		entry->lba = FTL_LBA_INVALID;
 		entry->addr = ftl_to_addr(FTL_ADDR_INVALID);
+		entry->stream = stream;
 		memset(entry->payload, 0, FTL_BLOCK_SIZE);
 
 		spdk_ring_enqueue(ioch->submit_queue, (void **)&entry, 1, NULL);
@@ -968,14 +1152,12 @@ static void
 ftl_wptr_pad_band(struct ftl_wptr *wptr)
 {
 	struct spdk_ftl_dev *dev = wptr->dev;
-	struct ftl_batch *batch = dev->current_batch;
 	struct ftl_io_channel *ioch;
 	size_t size, pad_size, blocks_left;
 
-	size = batch != NULL ? batch->num_entries : 0;
-	TAILQ_FOREACH(ioch, &dev->ioch_queue, tailq) {
-		size += spdk_ring_count(ioch->submit_queue);
-	}
+	/* Make sure the entries are accounted to the proper streams */
+	ftl_route_wbuf_entries(dev, FTL_STREAM_COUNT);
+	size = ftl_stream_num_entries(dev, wptr->stream) + ftl_num_queued_entries(dev);
 
 	ioch = ftl_io_channel_get_ctx(ftl_get_io_channel(dev));
 
@@ -984,26 +1166,50 @@ ftl_wptr_pad_band(struct ftl_wptr *wptr)
 	assert(blocks_left % dev->xfer_size == 0);
 	pad_size = spdk_min(blocks_left - size, spdk_ring_count(ioch->free_queue));
 
-	ftl_pad_wbuf(dev, pad_size);
+	ftl_pad_wbuf(dev, pad_size, wptr->stream);
+}
+
+static bool
+ftl_stream_has_data(const struct spdk_ftl_dev *dev, enum ftl_stream stream)
+{
+	return ftl_stream_num_entries(dev, stream) > 0;
+}
+
+static bool
+ftl_stream_has_wptr(const struct spdk_ftl_dev *dev, enum ftl_stream stream)
+{
+	struct ftl_wptr *wptr;
+
+	LIST_FOREACH(wptr, &dev->wptr_list, list_entry) {
+		if (wptr->stream == stream) {
+			return true;
+		}
+	}
+
+	return false;
 }
 
 static void
 ftl_wptr_process_shutdown(struct ftl_wptr *wptr)
 {
 	struct spdk_ftl_dev *dev = wptr->dev;
-	struct ftl_batch *batch = dev->current_batch;
-	struct ftl_io_channel *ioch;
+	unsigned int stream;
 	size_t size;
 
-	size = batch != NULL ? batch->num_entries : 0;
-	TAILQ_FOREACH(ioch, &dev->ioch_queue, tailq) {
-		size += spdk_ring_count(ioch->submit_queue);
-	}
+	ftl_route_wbuf_entries(dev, FTL_STREAM_COUNT);
+	size = ftl_stream_num_entries(dev, wptr->stream) + ftl_num_queued_entries(dev);
 
 	if (size >= dev->xfer_size) {
 		return;
 	}
 
+	/* Wait until all streams with outstanding data have bands to write it to */
+	for (stream = 0; stream < dev->num_streams; ++stream) {
+		if (ftl_stream_has_data(dev, stream) && !ftl_stream_has_wptr(dev, stream)) {
+			return;
+		}
+	}
+
 	/* If we reach this point we need to remove free bands */
 	/* and pad current wptr band to the end */
 	ftl_remove_free_bands(dev);
@@ -1087,6 +1293,25 @@ ftl_invalidate_addr(struct spdk_ftl_dev *dev, struct ftl_addr addr)
 	return rc;
 }
 
+static void
+ftl_io_l2p_waiter_cb(void *ctx, int status)
+{
+	struct ftl_io *io = ctx;
+	struct ftl_io_channel *ioch = ftl_io_channel_get_ctx(io->ioch);
+
+	if (spdk_unlikely(status != 0)) {
+		ftl_io_fail(io, status);
+		if (ftl_io_done(io)) {
+			ftl_io_complete(io);
+		}
+
+		return;
+	}
+
+	/* The L2P page is resident now, so the request can be resubmitted */
+	TAILQ_INSERT_TAIL(&ioch->retry_queue, io, ioch_entry);
+}
+
 static int
 ftl_read_retry(int rc)
 {
@@ -1123,13 +1348,18 @@ out:
 }
 
 static int
-ftl_read_next_logical_addr(struct ftl_io *io, struct ftl_addr *addr)
+_ftl_read_next_logical_addr(struct ftl_io *io, struct ftl_addr *addr)
 {
 	struct spdk_ftl_dev *dev = io->dev;
 	struct ftl_addr next_addr;
 	size_t i;
 
-	*addr = ftl_l2p_get(dev, ftl_io_current_lba(io));
+	/* The page is pinned, so this can only fail if the L2P cache is broken */
+	if (spdk_unlikely(ftl_l2p_try_get(dev, ftl_io_current_lba(io), addr))) {
+		*addr = ftl_to_addr(FTL_ADDR_INVALID);
+		assert(0);
+		return -EIO;
+	}
 
 	SPDK_DEBUGLOG(SPDK_LOG_FTL_CORE, "Read addr:%lx, lba:%lu\n",
 		      addr->offset, ftl_io_current_lba(io));
@@ -1149,7 +1379,10 @@ ftl_read_next_logical_addr(struct ftl_io *io, struct ftl_addr *addr)
 	}
 
 	for (i = 1; i < ftl_io_iovec_len_left(io); ++i) {
-		next_addr = ftl_l2p_get(dev, ftl_io_get_lba(io, io->pos + i));
+		/* Stop at the first entry whose L2P page isn't resident */
+		if (ftl_l2p_try_get(dev, ftl_io_get_lba(io, io->pos + i), &next_addr)) {
+			break;
+		}
 
 		if (ftl_addr_invalid(next_addr) || ftl_addr_cached(next_addr)) {
 			break;
@@ -1163,6 +1396,34 @@ ftl_read_next_logical_addr(struct ftl_io *io, struct ftl_addr *addr)
 	return i;
 }
 
+static int
+ftl_read_next_logical_addr(struct ftl_io *io, struct ftl_addr *addr)
+{
+	uint64_t lba = ftl_io_current_lba(io);
+	int rc;
+
+	/* Keep the L2P page resident while the address is looked up and read from the cache */
+	rc = ftl_l2p_pin(io->dev, lba, &io->l2p_waiter, ftl_io_l2p_waiter_cb, io);
+	if (spdk_unlikely(rc != 0)) {
+		*addr = ftl_to_addr(FTL_ADDR_INVALID);
+
+		/* -EAGAIN is used for retrying the lookup right away, so report the */
+		/* wait for the page to be loaded as -EBUSY */
+		if (rc == -EAGAIN) {
+			return -EBUSY;
+		}
+
+		/* Make sure the failure isn't mistaken for an unmapped LBA (-EFAULT) */
+		SPDK_ERRLOG("Failed to load the L2P page of LBA %"PRIu64"\n", lba);
+		return rc == -EFAULT ? -EIO : rc;
+	}
+
+	rc = _ftl_read_next_logical_addr(io, addr);
+	ftl_l2p_unpin(io->dev, lba);
+
+	return rc;
+}
+
 static int
 ftl_submit_read(struct ftl_io *io)
 {
@@ -1189,6 +1450,17 @@ ftl_submit_read(struct ftl_io *io)
 			continue;
 		}
 
+		/* The request is resubmitted once the L2P page is loaded */
+		if (rc == -EBUSY) {
+			rc = 0;
+			break;
+		}
+
+		if (spdk_unlikely(rc < 0 && rc != -EFAULT)) {
+			ftl_io_fail(io, rc);
+			break;
+		}
+
 		/* We don't have to schedule the read, as it was read from cache */
 		if (ftl_read_canceled(rc)) {
 			ftl_io_advance(io, 1);
@@ -1582,6 +1854,14 @@ ftl_write_cb(struct ftl_io *io, void *arg, int status)
 				entry->valid = true;
 			}
 			pthread_spin_unlock(&entry->lock);
+
+			/* When the L2P's size is limited, point it at the on-disk address right */
+			/* away, so that its page doesn't have to stay resident until the entry is */
+			/* reused */
+			if (dev->l2p_cache) {
+				ftl_evict_cache_entry(dev, entry);
+				ftl_l2p_unpin(dev, entry->lba);
+			}
 		}
 
 		SPDK_DEBUGLOG(SPDK_LOG_FTL_CORE, "Write addr:%lu, lba:%lu\n",
@@ -1597,10 +1877,20 @@ ftl_write_cb(struct ftl_io *io, void *arg, int status)
 static void
 ftl_update_stats(struct spdk_ftl_dev *dev, const struct ftl_wbuf_entry *entry)
 {
-	if (entry->io_flags & FTL_IO_INTERNAL) {
-		dev->stats.write_user++;
+	struct ftl_stats *stats = &dev->stats;
+
+	if (!(entry->io_flags & FTL_IO_INTERNAL)) {
+		stats->write_user++;
+		stats->stream[entry->stream].write_user++;
 	}
-	dev->stats.write_total++;
+
+	/* Account relocated data to the stream it was originally written through */
+	if (entry->io_flags & FTL_IO_WEAK) {
+		stats->stream[entry->band->stream].write_reloc++;
+	}
+
+	stats->write_total++;
+	stats->stream[entry->stream].write_total++;
 }
 
 static void
@@ -1810,22 +2100,22 @@ ftl_submit_write(struct ftl_wptr *wptr, struct ftl_io *io)
 }
 
 static void
-ftl_flush_pad_batch(struct spdk_ftl_dev *dev)
+ftl_flush_pad_batch(struct spdk_ftl_dev *dev, enum ftl_stream stream)
 {
-	struct ftl_batch *batch = dev->current_batch;
-	struct ftl_io_channel *ioch;
-	size_t size = 0, num_entries = 0;
-
-	assert(batch != NULL);
-	assert(batch->num_entries < dev->xfer_size);
+	struct ftl_batch *batch = dev->current_batch[stream];
+	size_t size, num_entries;
 
-	TAILQ_FOREACH(ioch, &dev->ioch_queue, tailq) {
-		size += spdk_ring_count(ioch->submit_queue);
+	/* Nothing to pad, the stream's entries have all been sent out already */
+	if (batch == NULL) {
+		return;
 	}
 
+	assert(batch->num_entries < dev->xfer_size);
+
+	size = ftl_num_queued_entries(dev);
 	num_entries = dev->xfer_size - batch->num_entries;
 	if (size < num_entries) {
-		ftl_pad_wbuf(dev, num_entries - size);
+		ftl_pad_wbuf(dev, num_entries - size, stream);
 	}
 }
 
@@ -1873,12 +2163,12 @@ ftl_wptr_process_writes(struct ftl_wptr *wptr)
 		ftl_wptr_pad_band(wptr);
 	}
 
-	batch = ftl_get_next_batch(dev);
+	batch = ftl_get_next_batch(dev, wptr->stream);
 	if (!batch) {
 		/* If there are queued flush requests we need to pad the write buffer to */
 		/* force out remaining entries */
 		if (!LIST_EMPTY(&dev->flush_list) || ftl_check_io_channel_flush(dev)) {
-			ftl_flush_pad_batch(dev);
+			ftl_flush_pad_batch(dev, wptr->stream);
 		}
 
 		return 0;
@@ -1922,8 +2212,9 @@ static int
 ftl_process_writes(struct spdk_ftl_dev *dev)
 {
 	struct ftl_wptr *wptr, *twptr;
-	size_t num_active = 0;
+	size_t num_active[FTL_STREAM_COUNT] = {};
 	enum ftl_band_state state;
+	unsigned int stream;
 
 	LIST_FOREACH_SAFE(wptr, &dev->wptr_list, list_entry, twptr) {
 		ftl_wptr_process_writes(wptr);
@@ -1932,12 +2223,17 @@ ftl_process_writes(struct spdk_ftl_dev *dev)
 		if (state != FTL_BAND_STATE_FULL &&
 		    state != FTL_BAND_STATE_CLOSING &&
 		    state != FTL_BAND_STATE_CLOSED) {
-			num_active++;
+			num_active[wptr->stream]++;
 		}
 	}
 
-	if (num_active < 1) {
-		ftl_add_wptr(dev);
+	/* The default stream always has an open band, the remaining ones are only opened */
+	/* once there's some data to be written through them */
+	for (stream = 0; stream < dev->num_streams; ++stream) {
+		if (num_active[stream] < 1 &&
+		    (stream == FTL_STREAM_HOT || ftl_stream_has_data(dev, stream))) {
+			ftl_add_wptr(dev, stream);
+		}
 	}
 
 	return 0;
@@ -1964,17 +2260,32 @@ ftl_wbuf_fill(struct ftl_io *io)
 	struct spdk_ftl_dev *dev = io->dev;
 	struct ftl_io_channel *ioch;
 	struct ftl_wbuf_entry *entry;
+	uint64_t lba;
+	int rc;
 
 	ioch = ftl_io_channel_get_ctx(io->ioch);
 
 	while (io->pos < io->num_blocks) {
-		if (ftl_io_current_lba(io) == FTL_LBA_INVALID) {
+		lba = ftl_io_current_lba(io);
+		if (lba == FTL_LBA_INVALID) {
 			ftl_io_advance(io, 1);
 			continue;
 		}
 
+		/* The L2P page is unpinned once the entry is written out */
+		rc = ftl_l2p_pin(dev, lba, &io->l2p_waiter, ftl_io_l2p_waiter_cb, io);
+		if (spdk_unlikely(rc != 0)) {
+			if (rc == -EAGAIN) {
+				return 0;
+			}
+
+			ftl_io_fail(io, rc);
+			break;
+		}
+
 		entry = ftl_acquire_wbuf_entry(ioch, io->flags);
 		if (!entry) {
+			ftl_l2p_unpin(dev, lba);
 			TAILQ_INSERT_TAIL(&ioch->retry_queue, io, ioch_entry);
 			return 0;
 		}
@@ -1992,7 +2303,7 @@ ftl_wbuf_fill(struct ftl_io *io)
 	}
 
 	if (ftl_io_done(io)) {
-		if (ftl_dev_has_nv_cache(dev) && !(io->flags & FTL_IO_BYPASS_CACHE)) {
+		if (ftl_dev_has_nv_cache(dev) && !(io->flags & FTL_IO_BYPASS_CACHE) && !io->status) {
 			ftl_write_nv_cache(io);
 		} else {
 			TAILQ_INSERT_TAIL(&ioch->write_cmpl_queue, io, ioch_entry);
@@ -2026,7 +2337,7 @@ static double
 ftl_band_calc_merit(struct ftl_band *band, size_t *threshold_valid)
 {
 	size_t usable, valid, invalid;
-	double vld_ratio;
+	double vld_ratio, utilization;
 
 	/* If the band doesn't have any usable blocks it's of no use */
 	usable = ftl_band_num_usable_blocks(band);
@@ -2035,11 +2346,25 @@ ftl_band_calc_merit(struct ftl_band *band, size_t *threshold_valid)
 	}
 
 	valid =  threshold_valid ? (usable - *threshold_valid) : band->lba_map.num_vld;
-	invalid = usable - valid;
 
-	/* Add one to avoid division by 0 */
-	vld_ratio = (double)invalid / (double)(valid + 1);
-	return vld_ratio * ftl_band_age(band);
+	if (!band->dev->conf.hot_cold_separation) {
+		invalid = usable - valid;
+
+		/* Add one to avoid division by 0 */
+		vld_ratio = (double)invalid / (double)(valid + 1);
+		return vld_ratio * ftl_band_age(band);
+	}
+
+	utilization = (double)valid / (double)usable;
+
+	/*
+	 * Cost-benefit policy: the amount of space reclaimed weighted by the age of the data,
+	 * divided by the cost of reading and rewriting the valid blocks.  Since hot, cold and
+	 * relocated data are written through separate bands, the age reflects the update
+	 * frequency of the band's class: hot bands are picked as soon as they're mostly invalid,
+	 * while cold ones need to be left untouched for a while first.
+	 */
+	return (1.0 - utilization) * ftl_band_age(band) / (1.0 + utilization);
 }
 
 static bool
@@ -2090,6 +2415,7 @@ ftl_process_relocs(struct spdk_ftl_dev *dev)
 		if (band) {
 			ftl_reloc_add(dev->reloc, band, 0, ftl_get_num_blocks_in_band(dev), 0, true);
 			ftl_trace_defrag_band(dev, band);
+			dev->stats.stream[band->stream].defrag++;
 		}
 	}
 
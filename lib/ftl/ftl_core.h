@@ -47,6 +47,7 @@
 
 #include "ftl_addr.h"
 #include "ftl_io.h"
+#include "ftl_l2p_cache.h"
 #include "ftl_trace.h"
 
 #ifdef SPDK_CONFIG_PMDK
@@ -64,6 +65,20 @@ struct ftl_reloc;
 struct ftl_anm_event;
 struct ftl_band_flush;
 
+struct ftl_stream_stats {
+	/* Number of user writes steered to the stream */
+	uint64_t				write_user;
+
+	/* Total number of writes to the stream's bands (including padding and relocation) */
+	uint64_t				write_total;
+
+	/* Number of blocks relocated out of the stream's bands */
+	uint64_t				write_reloc;
+
+	/* Number of the stream's bands selected for defrag */
+	uint64_t				defrag;
+};
+
 struct ftl_stats {
 	/* Number of writes scheduled directly by the user */
 	uint64_t				write_user;
@@ -71,6 +86,9 @@ struct ftl_stats {
 	/* Total number of writes */
 	uint64_t				write_total;
 
+	/* Per write stream statistics */
+	struct ftl_stream_stats			stream[FTL_STREAM_COUNT];
+
 	/* Traces */
 	struct ftl_trace			trace;
 
@@ -111,11 +129,36 @@ struct ftl_nv_cache {
 	pthread_spinlock_t			lock;
 };
 
+/* Number of LBAs (as a power of two) sharing a single write frequency counter */
+#define FTL_WRITE_HEAT_RANGE_SHIFT 8
+
+/*
+ * Per LBA range write counters used for telling frequently updated (hot) data apart from the
+ * rarely updated (cold) one. The counters are periodically halved, so that they reflect the
+ * recent write frequency.
+ */
+struct ftl_write_heat {
+	/* Array of counters, one per (1 << FTL_WRITE_HEAT_RANGE_SHIFT) LBAs */
+	uint16_t				*counters;
+	/* Number of counters */
+	uint64_t				num_ranges;
+	/* Sum of all counters */
+	uint64_t				sum;
+	/* Number of non-zero counters */
+	uint64_t				num_active;
+	/* Number of writes since the counters were last halved */
+	uint64_t				num_writes;
+	/* Number of writes after which the counters are halved */
+	uint64_t				decay_interval;
+};
+
 struct ftl_batch {
 	/* Queue of write buffer entries, can reach up to xfer_size entries */
 	TAILQ_HEAD(, ftl_wbuf_entry)		entries;
 	/* Number of entries in the queue above */
 	uint32_t				num_entries;
+	/* Write stream the batch is built for */
+	enum ftl_stream				stream;
 	/* Index within spdk_ftl_dev.batch_array */
 	uint32_t				index;
 	struct iovec				*iov;
@@ -175,12 +218,21 @@ struct spdk_ftl_dev {
 	/* List of write pointers */
 	LIST_HEAD(, ftl_wptr)			wptr_list;
 
+	/* Number of write streams in use (1 if hot/cold separation is disabled) */
+	unsigned int				num_streams;
+	/* Write frequency tracking used for selecting the stream of user writes */
+	struct ftl_write_heat			heat;
+
 	/* Logical -> physical table */
 	void					*l2p;
 	/* Size of the l2p table */
 	uint64_t				num_lbas;
 	/* Size of pages mmapped for l2p, valid only for mapping on persistent memory */
 	size_t					l2p_pmem_len;
+	/* Resident part of the l2p, used instead of l2p when its size is limited */
+	struct ftl_l2p_cache			*l2p_cache;
+	/* Bdev backing the l2p when its size is limited */
+	struct spdk_bdev_desc			*l2p_bdev_desc;
 
 	/* Address size */
 	size_t					addr_len;
@@ -236,10 +288,11 @@ struct spdk_ftl_dev {
 	struct ftl_batch			batch_array[FTL_BATCH_COUNT];
 	/* Iovec buffer used by batches */
 	struct iovec				*iov_buf;
-	/* Batch currently being filled  */
-	struct ftl_batch			*current_batch;
+	/* Batches currently being filled, one per write stream */
+	struct ftl_batch			*current_batch[FTL_STREAM_COUNT];
 	/* Full and ready to be sent batches. A batch is put on this queue in
-	 * case it's already filled, but cannot be sent.
+	 * case it's already filled, but cannot be sent yet (e.g. it belongs to
+	 * a different write stream than the one being processed).
 	 */
 	TAILQ_HEAD(, ftl_batch)			pending_batches;
 	TAILQ_HEAD(, ftl_batch)			free_batches;
@@ -464,6 +517,17 @@ ftl_l2p_set(struct spdk_ftl_dev *dev, uint64_t lba, struct ftl_addr addr)
 {
 	assert(dev->num_lbas > lba);
 
+	if (spdk_unlikely(dev->l2p_cache != NULL)) {
+		/* The caller is required to pin the entry's page beforehand */
+		if (spdk_unlikely(ftl_l2p_cache_set(dev->l2p_cache, lba, ftl_addr_packed(dev) ?
+						    ftl_addr_to_packed(dev, addr).offset : addr.offset))) {
+			SPDK_ERRLOG("Setting LBA %"PRIu64" whose L2P page isn't pinned\n", lba);
+			assert(0);
+		}
+
+		return;
+	}
+
 	if (ftl_addr_packed(dev)) {
 		_ftl_l2p_set32(dev->l2p, lba, ftl_addr_to_packed(dev, addr).offset);
 	} else {
@@ -475,11 +539,37 @@ ftl_l2p_set(struct spdk_ftl_dev *dev, uint64_t lba, struct ftl_addr addr)
 	}
 }
 
+static inline struct ftl_addr
+ftl_l2p_cache_addr(const struct spdk_ftl_dev *dev, uint64_t val)
+{
+	if (ftl_addr_packed(dev)) {
+		return ftl_addr_from_packed(dev, ftl_to_addr_packed(val));
+	} else {
+		return ftl_to_addr(val);
+	}
+}
+
+/*
+ * When the size of the L2P is limited, the entry's page needs to be pinned. Otherwise an invalid
+ * address is returned.
+ */
 static inline struct ftl_addr
 ftl_l2p_get(struct spdk_ftl_dev *dev, uint64_t lba)
 {
+	uint64_t val;
+
 	assert(dev->num_lbas > lba);
 
+	if (spdk_unlikely(dev->l2p_cache != NULL)) {
+		if (spdk_unlikely(ftl_l2p_cache_get(dev->l2p_cache, lba, &val))) {
+			SPDK_ERRLOG("Looking up LBA %"PRIu64" whose L2P page isn't pinned\n", lba);
+			assert(0);
+			return ftl_to_addr(FTL_ADDR_INVALID);
+		}
+
+		return ftl_l2p_cache_addr(dev, val);
+	}
+
 	if (ftl_addr_packed(dev)) {
 		return ftl_addr_from_packed(dev, ftl_to_addr_packed(
 						    _ftl_l2p_get32(dev->l2p, lba)));
@@ -488,6 +578,53 @@ ftl_l2p_get(struct spdk_ftl_dev *dev, uint64_t lba)
 	}
 }
 
+/*
+ * Looks up the entry without pinning its page, which might not be resident if the size of the
+ * L2P is limited. Returns -EAGAIN in that case.
+ */
+static inline int
+ftl_l2p_try_get(struct spdk_ftl_dev *dev, uint64_t lba, struct ftl_addr *addr)
+{
+	uint64_t val;
+	int rc;
+
+	if (spdk_unlikely(dev->l2p_cache != NULL)) {
+		rc = ftl_l2p_cache_get(dev->l2p_cache, lba, &val);
+		if (spdk_likely(rc == 0)) {
+			*addr = ftl_l2p_cache_addr(dev, val);
+		}
+
+		return rc;
+	}
+
+	*addr = ftl_l2p_get(dev, lba);
+	return 0;
+}
+
+/*
+ * When the size of the L2P is limited, its entries can only be accessed after their page is
+ * pinned. This returns -EAGAIN if the page needs to be loaded first, in which case cb_fn is
+ * called on the current thread once it's worth retrying.
+ */
+static inline int
+ftl_l2p_pin(struct spdk_ftl_dev *dev, uint64_t lba, struct ftl_l2p_cache_waiter *waiter,
+	    ftl_l2p_cache_fn cb_fn, void *cb_arg)
+{
+	if (spdk_likely(dev->l2p_cache == NULL)) {
+		return 0;
+	}
+
+	return ftl_l2p_cache_pin(dev->l2p_cache, lba, waiter, cb_fn, cb_arg);
+}
+
+static inline void
+ftl_l2p_unpin(struct spdk_ftl_dev *dev, uint64_t lba)
+{
+	if (spdk_unlikely(dev->l2p_cache != NULL)) {
+		ftl_l2p_cache_unpin(dev->l2p_cache, lba);
+	}
+}
+
 static inline bool
 ftl_dev_has_nv_cache(const struct spdk_ftl_dev *dev)
 {
@@ -73,7 +73,11 @@ ftl_band_validate_md(struct ftl_band *band)
 		}
 
 		addr_md = ftl_band_addr_from_block_offset(band, i);
-		addr_l2p = ftl_l2p_get(dev, lba_map->map[i]);
+
+		/* Entries whose L2P page isn't resident can't be verified */
+		if (ftl_l2p_try_get(dev, lba_map->map[i], &addr_l2p)) {
+			continue;
+		}
 
 		if (addr_l2p.cached) {
 			continue;
@@ -163,6 +167,42 @@ ftl_dev_dump_stats(const struct spdk_ftl_dev *dev)
 	for (i = 0; i < SPDK_FTL_LIMIT_MAX; ++i) {
 		ftl_debug(" %5s: %"PRIu64"\n", limits[i], dev->stats.limits[i]);
 	}
+
+	if (dev->l2p_cache) {
+		struct ftl_l2p_cache_stats l2p_stats;
+
+		ftl_l2p_cache_get_stats(dev->l2p_cache, &l2p_stats);
+		ftl_debug("l2p cache:\n");
+		ftl_debug(" resident pages:     %zu\n", ftl_l2p_cache_num_resident(dev->l2p_cache));
+		ftl_debug(" hits:               %"PRIu64"\n", l2p_stats.hits);
+		ftl_debug(" misses:             %"PRIu64"\n", l2p_stats.misses);
+		ftl_debug(" evictions:          %"PRIu64"\n", l2p_stats.evictions);
+		ftl_debug(" writebacks:         %"PRIu64"\n", l2p_stats.writebacks);
+	}
+
+	if (dev->num_streams > 1) {
+		const char *streams[] = {
+			[FTL_STREAM_HOT]   = "hot",
+			[FTL_STREAM_COLD]  = "cold",
+			[FTL_STREAM_RELOC] = "reloc"
+		};
+		const struct ftl_stream_stats *sstats;
+
+		ftl_debug("write streams:\n");
+		for (i = 0; i < FTL_STREAM_COUNT; ++i) {
+			sstats = &dev->stats.stream[i];
+			ftl_debug(" %5s: total writes:   %"PRIu64"\n", streams[i], sstats->write_total);
+			ftl_debug("        user writes:    %"PRIu64"\n", sstats->write_user);
+			ftl_debug("        reloc writes:   %"PRIu64"\n", sstats->write_reloc);
+			ftl_debug("        defrags:        %"PRIu64"\n", sstats->defrag);
+			/* Relocated data's write amplification is accounted to the stream it came from */
+			if (sstats->write_user != 0) {
+				waf = (double)(sstats->write_user + sstats->write_reloc) /
+				      (double)sstats->write_user;
+				ftl_debug("        WAF:            %.4lf\n", waf);
+			}
+		}
+	}
 }
 
 #endif /* defined(FTL_DUMP_STATS) */
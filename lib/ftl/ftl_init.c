@@ -578,6 +578,27 @@ ftl_dev_l2p_alloc_dram(struct spdk_ftl_dev *dev, size_t l2p_size)
 	return 0;
 }
 
+static int
+ftl_dev_l2p_alloc_cache(struct spdk_ftl_dev *dev, size_t addr_size)
+{
+	/* Pages are pinned by the write buffer entries until they're written out, so there */
+	/* needs to be enough of them to always allow a full batch to be formed */
+	if (dev->conf.l2p_dram_limit < 2 * dev->xfer_size * FTL_BLOCK_SIZE) {
+		SPDK_ERRLOG("l2p_dram_limit too small, need at least %zu bytes\n",
+			    2 * dev->xfer_size * FTL_BLOCK_SIZE);
+		return -1;
+	}
+
+	dev->l2p_cache = ftl_l2p_cache_init(dev->l2p_bdev_desc, dev->core_thread, dev->num_lbas,
+					    addr_size, dev->conf.l2p_dram_limit);
+	if (!dev->l2p_cache) {
+		SPDK_ERRLOG("Failed to initialize l2p cache\n");
+		return -1;
+	}
+
+	return 0;
+}
+
 static int
 ftl_dev_l2p_alloc(struct spdk_ftl_dev *dev)
 {
@@ -590,19 +611,54 @@ ftl_dev_l2p_alloc(struct spdk_ftl_dev *dev)
 		return -1;
 	}
 
-	if (dev->l2p) {
+	if (dev->l2p || dev->l2p_cache) {
 		SPDK_ERRLOG("L2p table already allocated\n");
 		return -1;
 	}
 
 	dev->l2p_pmem_len = 0;
-	if (l2p_path) {
+	if (dev->conf.l2p_dram_limit) {
+		if (!dev->l2p_bdev_desc) {
+			SPDK_ERRLOG("Limiting l2p memory usage requires l2p_bdev\n");
+			return -1;
+		}
+
+		return ftl_dev_l2p_alloc_cache(dev, addr_size);
+	} else if (l2p_path) {
 		return ftl_dev_l2p_alloc_pmem(dev, l2p_size, l2p_path);
 	} else {
 		return ftl_dev_l2p_alloc_dram(dev, l2p_size);
 	}
 }
 
+static int
+ftl_dev_init_streams(struct spdk_ftl_dev *dev)
+{
+	struct ftl_write_heat *heat = &dev->heat;
+
+	if (!dev->conf.hot_cold_separation) {
+		return 0;
+	}
+
+	if (heat->counters) {
+		SPDK_ERRLOG("Write heat counters already allocated\n");
+		return -1;
+	}
+
+	heat->num_ranges = spdk_divide_round_up(dev->num_lbas, 1ULL << FTL_WRITE_HEAT_RANGE_SHIFT);
+	heat->counters = calloc(heat->num_ranges, sizeof(*heat->counters));
+	if (!heat->counters) {
+		SPDK_ERRLOG("Failed to allocate write heat counters\n");
+		return -1;
+	}
+
+	/* Age the counters each time a quarter of the device is written */
+	heat->decay_interval = spdk_max(dev->num_lbas / 4, 1);
+	dev->num_streams = FTL_STREAM_COUNT;
+
+	return 0;
+}
+
 static void
 ftl_dev_free_init_ctx(struct ftl_dev_init_ctx *init_ctx)
 {
@@ -743,6 +799,11 @@ ftl_setup_initial_state(struct ftl_dev_init_ctx *init_ctx)
 		return -1;
 	}
 
+	if (ftl_dev_init_streams(dev)) {
+		SPDK_ERRLOG("Unable to init write streams\n");
+		return -1;
+	}
+
 	if (ftl_init_bands_state(dev)) {
 		SPDK_ERRLOG("Unable to finish the initialization\n");
 		return -1;
@@ -813,6 +874,11 @@ ftl_restore_md_cb(struct ftl_restore *restore, int status, void *cb_arg)
 		goto error;
 	}
 
+	if (ftl_dev_init_streams(init_ctx->dev)) {
+		SPDK_ERRLOG("Failed to initialize write streams\n");
+		goto error;
+	}
+
 	if (ftl_restore_device(restore, ftl_restore_device_cb, init_ctx)) {
 		SPDK_ERRLOG("Failed to start device restoration from the SSD\n");
 		goto error;
@@ -1294,6 +1360,40 @@ ftl_dev_init_io_channel(struct spdk_ftl_dev *dev)
 	return 0;
 }
 
+static int
+ftl_dev_init_l2p_bdev(struct spdk_ftl_dev *dev, const char *bdev_name)
+{
+	struct spdk_bdev *bdev;
+
+	if (!bdev_name) {
+		return 0;
+	}
+
+	bdev = spdk_bdev_get_by_name(bdev_name);
+	if (!bdev) {
+		SPDK_ERRLOG("Unable to find bdev: %s\n", bdev_name);
+		return -1;
+	}
+
+	if (spdk_bdev_open_ext(bdev_name, true, ftl_bdev_event_cb,
+			       dev, &dev->l2p_bdev_desc)) {
+		SPDK_ERRLOG("Unable to open bdev: %s\n", bdev_name);
+		return -1;
+	}
+
+	if (spdk_bdev_module_claim_bdev(bdev, dev->l2p_bdev_desc, &g_ftl_bdev_module)) {
+		spdk_bdev_close(dev->l2p_bdev_desc);
+		dev->l2p_bdev_desc = NULL;
+		SPDK_ERRLOG("Unable to claim bdev %s\n", bdev_name);
+		return -1;
+	}
+
+	SPDK_INFOLOG(SPDK_LOG_FTL_INIT, "Using %s to store the l2p\n",
+		     spdk_bdev_get_name(bdev));
+
+	return 0;
+}
+
 static int
 ftl_dev_init_base_bdev(struct spdk_ftl_dev *dev, const char *bdev_name)
 {
@@ -1394,7 +1494,9 @@ ftl_dev_free_sync(struct spdk_ftl_dev *dev)
 	pthread_mutex_unlock(&g_ftl_queue_lock);
 
 	assert(LIST_EMPTY(&dev->wptr_list));
-	assert(dev->current_batch == NULL);
+	for (i = 0; i < FTL_STREAM_COUNT; ++i) {
+		assert(dev->current_batch[i] == NULL);
+	}
 
 	ftl_dev_dump_bands(dev);
 	ftl_dev_dump_stats(dev);
@@ -1420,6 +1522,7 @@ ftl_dev_free_sync(struct spdk_ftl_dev *dev)
 	ftl_reloc_free(dev->reloc);
 
 	ftl_release_bdev(dev->nv_cache.bdev_desc);
+	ftl_release_bdev(dev->l2p_bdev_desc);
 	ftl_release_bdev(dev->base_bdev_desc);
 
 	spdk_free(dev->md_buf);
@@ -1429,7 +1532,10 @@ ftl_dev_free_sync(struct spdk_ftl_dev *dev)
 	free(dev->iov_buf);
 	free(dev->name);
 	free(dev->bands);
-	if (dev->l2p_pmem_len != 0) {
+	free(dev->heat.counters);
+	if (dev->l2p_cache) {
+		ftl_l2p_cache_free(dev->l2p_cache);
+	} else if (dev->l2p_pmem_len != 0) {
 #ifdef SPDK_CONFIG_PMDK
 		pmem_unmap(dev->l2p, dev->l2p_pmem_len);
 #endif /* SPDK_CONFIG_PMDK */
@@ -1437,6 +1543,7 @@ ftl_dev_free_sync(struct spdk_ftl_dev *dev)
 		free(dev->l2p);
 	}
 	free((char *)dev->conf.l2p_path);
+	free((char *)dev->conf.l2p_bdev);
 	free(dev);
 }
 
@@ -1476,6 +1583,7 @@ spdk_ftl_dev_init(const struct spdk_ftl_dev_init_opts *_opts, spdk_ftl_init_fn c
 
 	dev->conf = *opts.conf;
 	dev->limit = SPDK_FTL_LIMIT_MAX;
+	dev->num_streams = 1;
 
 	dev->name = strdup(opts.name);
 	if (!dev->name) {
@@ -1496,6 +1604,14 @@ spdk_ftl_dev_init(const struct spdk_ftl_dev_init_opts *_opts, spdk_ftl_init_fn c
 		}
 	}
 
+	if (opts.conf->l2p_bdev) {
+		dev->conf.l2p_bdev = strdup(opts.conf->l2p_bdev);
+		if (!dev->conf.l2p_bdev) {
+			rc = -ENOMEM;
+			goto fail_sync;
+		}
+	}
+
 	/* In case of errors, we free all of the memory in ftl_dev_free_sync(), */
 	/* so we don't have to clean up in each of the init functions. */
 	if (ftl_check_conf(dev, opts.conf)) {
@@ -1525,6 +1641,11 @@ spdk_ftl_dev_init(const struct spdk_ftl_dev_init_opts *_opts, spdk_ftl_init_fn c
 		goto fail_sync;
 	}
 
+	if (ftl_dev_init_l2p_bdev(dev, dev->conf.l2p_bdev)) {
+		SPDK_ERRLOG("Unable to initialize l2p bdev\n");
+		goto fail_sync;
+	}
+
 	dev->reloc = ftl_reloc_init(dev);
 	if (!dev->reloc) {
 		SPDK_ERRLOG("Unable to initialize reloc structures\n");
@@ -1605,6 +1726,38 @@ ftl_nv_cache_header_fini_cb(struct spdk_bdev_io *bdev_io, bool success, void *cb
 	spdk_thread_send_msg(fini_ctx->thread, ftl_put_io_channel_cb, fini_ctx);
 }
 
+static void
+ftl_halt_write_nv_cache_header(struct ftl_dev_init_ctx *fini_ctx)
+{
+	struct spdk_ftl_dev *dev = fini_ctx->dev;
+
+	if (ftl_dev_has_nv_cache(dev)) {
+		ftl_nv_cache_write_header(&dev->nv_cache, true,
+					  ftl_nv_cache_header_fini_cb, fini_ctx);
+	} else {
+		fini_ctx->halt_complete_status = 0;
+		spdk_thread_send_msg(fini_ctx->thread, ftl_put_io_channel_cb, fini_ctx);
+	}
+}
+
+static void
+ftl_halt_l2p_flush_cb(void *ctx, int status)
+{
+	struct ftl_dev_init_ctx *fini_ctx = ctx;
+	struct spdk_ftl_dev *dev = fini_ctx->dev;
+
+	ftl_l2p_cache_put_io_channel(dev->l2p_cache);
+
+	if (spdk_unlikely(status != 0)) {
+		SPDK_ERRLOG("Failed to write back the l2p: %s\n", spdk_strerror(-status));
+		fini_ctx->halt_complete_status = status;
+		spdk_thread_send_msg(fini_ctx->thread, ftl_put_io_channel_cb, fini_ctx);
+		return;
+	}
+
+	ftl_halt_write_nv_cache_header(fini_ctx);
+}
+
 static int
 ftl_halt_poller(void *ctx)
 {
@@ -1614,12 +1767,11 @@ ftl_halt_poller(void *ctx)
 	if (!dev->core_poller) {
 		spdk_poller_unregister(&fini_ctx->poller);
 
-		if (ftl_dev_has_nv_cache(dev)) {
-			ftl_nv_cache_write_header(&dev->nv_cache, true,
-						  ftl_nv_cache_header_fini_cb, fini_ctx);
+		/* Persist the modified l2p pages before the device is closed */
+		if (dev->l2p_cache) {
+			ftl_l2p_cache_flush(dev->l2p_cache, ftl_halt_l2p_flush_cb, fini_ctx);
 		} else {
-			fini_ctx->halt_complete_status = 0;
-			spdk_thread_send_msg(fini_ctx->thread, ftl_put_io_channel_cb, fini_ctx);
+			ftl_halt_write_nv_cache_header(fini_ctx);
 		}
 	}
 
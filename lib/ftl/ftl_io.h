@@ -39,6 +39,7 @@
 #include "spdk/ftl.h"
 
 #include "ftl_addr.h"
+#include "ftl_l2p_cache.h"
 #include "ftl_trace.h"
 
 struct spdk_ftl_dev;
@@ -75,6 +76,17 @@ enum ftl_io_flags {
 	FTL_IO_BYPASS_CACHE	= (1 << 9),
 };
 
+/* Write streams (temperature classes) the data is steered to */
+enum ftl_stream {
+	/* Frequently updated user data, all data if stream separation is disabled */
+	FTL_STREAM_HOT,
+	/* Rarely updated user data */
+	FTL_STREAM_COLD,
+	/* Data moved by the relocation */
+	FTL_STREAM_RELOC,
+	FTL_STREAM_COUNT
+};
+
 enum ftl_io_type {
 	FTL_IO_READ,
 	FTL_IO_WRITE,
@@ -148,6 +160,9 @@ struct ftl_wbuf_entry {
 	/* Trace ID of the requests the entry is part of */
 	uint64_t				trace;
 
+	/* Write stream the entry is written through */
+	enum ftl_stream				stream;
+
 	/* Indicates that the entry was written out and is still present in the
 	 * L2P table.
 	 */
@@ -283,6 +298,9 @@ struct ftl_io {
 
 	/* Used by retry and write completion queues */
 	TAILQ_ENTRY(ftl_io)			ioch_entry;
+
+	/* Used for waiting on L2P pages to be loaded */
+	struct ftl_l2p_cache_waiter		l2p_waiter;
 };
 
 /* Metadata IO */
@@ -0,0 +1,884 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk/bdev.h"
+#include "spdk/bit_array.h"
+#include "spdk/env.h"
+#include "spdk/likely.h"
+#include "spdk/queue.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+#include "spdk_internal/log.h"
+
+#include "ftl_addr.h"
+#include "ftl_l2p_cache.h"
+
+/*
+ * The L2P table is split into fixed size pages, which are kept on a backing bdev and loaded
+ * into memory on demand. At most max_size bytes worth of pages are resident at any given
+ * time. Once that limit is reached, the least recently used page that isn't pinned is dropped
+ * to make room for the one that's needed. Modified pages need to be written back before they
+ * can be dropped.
+ *
+ * Requests accessing a page that isn't resident are parked until the page is loaded. All of
+ * the page I/O is submitted asynchronously from the cache's thread, so the lookups never block
+ * on the backing bdev.
+ *
+ * Resident pages are accessed without taking the cache's lock. A page is pinned by atomically
+ * incrementing its pin count, which keeps it from being dropped, since a page can only be
+ * claimed for another part of the table by swapping its zero pin count for
+ * FTL_L2P_PAGE_UNUSED. The pin counts of pages that are unused or still being loaded are kept
+ * at that value as well, so they cannot be pinned. Instead of reordering the LRU list on each
+ * access, pinning only marks the page as accessed and the list is updated once a page needs
+ * to be dropped.
+ *
+ * Pages that were never written back don't have to be read from the bdev, as their contents
+ * are known to be all invalid addresses, so the bdev doesn't need to be initialized when the
+ * device is created.
+ */
+#define FTL_L2P_CACHE_PAGE_SIZE		FTL_BLOCK_SIZE
+
+/* Maximum number of pages written back at the same time to make room for other pages */
+#define FTL_L2P_CACHE_MAX_WRITEBACKS	8
+
+/* Pin count of pages that aren't ready to be accessed */
+#define FTL_L2P_PAGE_UNUSED		UINT_MAX
+
+enum ftl_l2p_page_state {
+	/* Page is being read from the backing bdev */
+	FTL_L2P_PAGE_LOADING,
+	/* Page is resident and its entries can be accessed */
+	FTL_L2P_PAGE_READY,
+};
+
+TAILQ_HEAD(ftl_l2p_waiter_list, ftl_l2p_cache_waiter);
+
+struct ftl_l2p_page {
+	struct ftl_l2p_cache			*cache;
+
+	/* Index of the page within the L2P table */
+	uint64_t				page_idx;
+
+	enum ftl_l2p_page_state			state;
+
+	/* Number of users requiring the page to stay resident */
+	unsigned int				pin_cnt;
+
+	/* Indicates the page was pinned since the LRU list was last updated */
+	bool					accessed;
+
+	/* Indicates the page was modified since it was last written back */
+	bool					dirty;
+
+	/* Indicates the page is being written back */
+	bool					writeback;
+
+	/* Page's entries */
+	void					*buf;
+
+	/* Requests waiting for the page to be loaded */
+	struct ftl_l2p_waiter_list		waiters;
+
+	/* Used to resubmit the page's I/O once the bdev has free requests */
+	struct spdk_bdev_io_wait_entry		bio_wait;
+
+	/* LRU / free list link */
+	TAILQ_ENTRY(ftl_l2p_page)		tailq;
+};
+
+struct ftl_l2p_cache {
+	/* Backing bdev */
+	struct spdk_bdev_desc			*desc;
+	struct spdk_io_channel			*ioch;
+
+	/* Thread the page I/O is submitted from */
+	struct spdk_thread			*thread;
+
+	/* Number of backing bdev's blocks in a single page */
+	uint64_t				blocks_per_page;
+
+	/* Size of a single L2P entry (4 or 8 bytes) */
+	size_t					entry_size;
+
+	/* Number of entries in the table */
+	uint64_t				num_entries;
+
+	/* Number of entries in a single page */
+	uint64_t				entries_per_page;
+
+	/* Number of pages the table is divided into */
+	uint64_t				num_pages;
+
+	/* Maps page index to its resident copy (or NULL if it's not resident) */
+	struct ftl_l2p_page			**page_map;
+
+	/* Marks pages that were written back to the bdev at least once */
+	struct spdk_bit_array			*persisted;
+
+	/* Array of page descriptors and the memory backing them */
+	struct ftl_l2p_page			*pages;
+	void					*page_buf;
+	size_t					num_slots;
+	size_t					num_resident;
+
+	/* Unused page descriptors */
+	TAILQ_HEAD(, ftl_l2p_page)		free_list;
+
+	/* Resident pages, least recently used first */
+	TAILQ_HEAD(, ftl_l2p_page)		lru_list;
+
+	/* Requests for pages that aren't resident and aren't being loaded yet */
+	struct ftl_l2p_waiter_list		pending;
+	size_t					num_pending;
+
+	/* Indicates processing of the pending requests was already scheduled */
+	bool					pending_scheduled;
+
+	/* Number of page writes in progress */
+	size_t					num_writebacks;
+
+	/*
+	 * Set once a page couldn't be written back. Its entries are only valid in memory, so
+	 * the page stays resident and no other pages are loaded afterwards.
+	 */
+	int					status;
+
+	struct {
+		ftl_l2p_cache_fn		cb_fn;
+		void				*cb_arg;
+		int				status;
+		bool				active;
+	} flush;
+
+	/* Protects everything except for the accesses to pinned pages */
+	pthread_mutex_t				lock;
+
+	struct ftl_l2p_cache_stats		stats;
+};
+
+static void ftl_l2p_cache_page_submit(struct ftl_l2p_page *page);
+static void ftl_l2p_cache_page_unpin(struct ftl_l2p_page *page);
+static void ftl_l2p_cache_process_pending(void *ctx);
+
+static void
+ftl_l2p_cache_waiter_cb(void *ctx)
+{
+	struct ftl_l2p_cache_waiter *waiter = ctx;
+
+	waiter->cb_fn(waiter->cb_arg, waiter->status);
+}
+
+static void
+ftl_l2p_cache_wake(struct ftl_l2p_waiter_list *waiters)
+{
+	struct ftl_l2p_cache_waiter *waiter;
+
+	/* The waiter can be reused as soon as the message is sent, so it needs to be removed */
+	/* from the list beforehand */
+	while ((waiter = TAILQ_FIRST(waiters)) != NULL) {
+		TAILQ_REMOVE(waiters, waiter, tailq);
+		spdk_thread_send_msg(waiter->thread, ftl_l2p_cache_waiter_cb, waiter);
+	}
+}
+
+static void
+ftl_l2p_cache_schedule_pending(struct ftl_l2p_cache *cache)
+{
+	if (cache->pending_scheduled || TAILQ_EMPTY(&cache->pending)) {
+		return;
+	}
+
+	cache->pending_scheduled = true;
+	spdk_thread_send_msg(cache->thread, ftl_l2p_cache_process_pending, cache);
+}
+
+static void
+ftl_l2p_cache_flush_cb(void *ctx)
+{
+	struct ftl_l2p_cache *cache = ctx;
+
+	cache->flush.cb_fn(cache->flush.cb_arg, cache->flush.status);
+}
+
+static void
+ftl_l2p_cache_flush_complete(struct ftl_l2p_cache *cache)
+{
+	cache->flush.active = false;
+	spdk_thread_send_msg(cache->thread, ftl_l2p_cache_flush_cb, cache);
+}
+
+static void
+ftl_l2p_cache_page_load_done(struct ftl_l2p_page *page, int status)
+{
+	struct ftl_l2p_cache *cache = page->cache;
+	struct ftl_l2p_cache_waiter *waiter;
+
+	assert(page->state == FTL_L2P_PAGE_LOADING);
+
+	if (spdk_unlikely(status != 0)) {
+		SPDK_ERRLOG("Failed to load L2P page %"PRIu64": %s\n",
+			    page->page_idx, spdk_strerror(-status));
+
+		TAILQ_FOREACH(waiter, &page->waiters, tailq) {
+			waiter->status = status;
+		}
+
+		cache->page_map[page->page_idx] = NULL;
+		cache->num_resident--;
+		TAILQ_INSERT_TAIL(&cache->free_list, page, tailq);
+
+		/* The slot is free again, so it can be used by another page */
+		ftl_l2p_cache_schedule_pending(cache);
+	} else {
+		page->state = FTL_L2P_PAGE_READY;
+		TAILQ_INSERT_TAIL(&cache->lru_list, page, tailq);
+
+		/* From now on the page can be pinned without the lock */
+		__atomic_store_n(&page->pin_cnt, 0, __ATOMIC_SEQ_CST);
+	}
+
+	ftl_l2p_cache_wake(&page->waiters);
+}
+
+static void
+ftl_l2p_cache_page_writeback_done(struct ftl_l2p_page *page, int status)
+{
+	struct ftl_l2p_cache *cache = page->cache;
+
+	assert(page->writeback);
+	assert(cache->num_writebacks > 0);
+
+	page->writeback = false;
+	cache->num_writebacks--;
+
+	if (spdk_unlikely(status != 0)) {
+		SPDK_ERRLOG("Failed to write back L2P page %"PRIu64": %s\n",
+			    page->page_idx, spdk_strerror(-status));
+
+		__atomic_store_n(&page->dirty, true, __ATOMIC_SEQ_CST);
+		cache->status = status;
+		cache->flush.status = status;
+	} else {
+		spdk_bit_array_set(cache->persisted, (uint32_t)page->page_idx);
+		cache->stats.writebacks++;
+	}
+
+	if (cache->flush.active && cache->num_writebacks == 0) {
+		ftl_l2p_cache_flush_complete(cache);
+	}
+
+	ftl_l2p_cache_schedule_pending(cache);
+}
+
+static void
+ftl_l2p_cache_page_io_done(struct ftl_l2p_page *page, int status)
+{
+	if (page->state == FTL_L2P_PAGE_LOADING) {
+		ftl_l2p_cache_page_load_done(page, status);
+	} else {
+		ftl_l2p_cache_page_writeback_done(page, status);
+	}
+}
+
+static void
+ftl_l2p_cache_page_io_cb(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct ftl_l2p_page *page = cb_arg;
+	struct ftl_l2p_cache *cache = page->cache;
+
+	spdk_bdev_free_io(bdev_io);
+
+	pthread_mutex_lock(&cache->lock);
+	ftl_l2p_cache_page_io_done(page, success ? 0 : -EIO);
+	pthread_mutex_unlock(&cache->lock);
+}
+
+static void
+ftl_l2p_cache_page_resubmit(void *ctx)
+{
+	struct ftl_l2p_page *page = ctx;
+	struct ftl_l2p_cache *cache = page->cache;
+
+	pthread_mutex_lock(&cache->lock);
+	ftl_l2p_cache_page_submit(page);
+	pthread_mutex_unlock(&cache->lock);
+}
+
+static void
+ftl_l2p_cache_page_submit(struct ftl_l2p_page *page)
+{
+	struct ftl_l2p_cache *cache = page->cache;
+	uint64_t offset = page->page_idx * cache->blocks_per_page;
+	int rc;
+
+	assert(spdk_get_thread() == cache->thread);
+
+	if (spdk_unlikely(!cache->ioch)) {
+		cache->ioch = spdk_bdev_get_io_channel(cache->desc);
+		if (!cache->ioch) {
+			ftl_l2p_cache_page_io_done(page, -ENOMEM);
+			return;
+		}
+	}
+
+	if (page->state == FTL_L2P_PAGE_LOADING) {
+		rc = spdk_bdev_read_blocks(cache->desc, cache->ioch, page->buf, offset,
+					   cache->blocks_per_page, ftl_l2p_cache_page_io_cb, page);
+	} else {
+		rc = spdk_bdev_write_blocks(cache->desc, cache->ioch, page->buf, offset,
+					    cache->blocks_per_page, ftl_l2p_cache_page_io_cb, page);
+	}
+
+	if (spdk_unlikely(rc == -ENOMEM)) {
+		page->bio_wait.bdev = spdk_bdev_desc_get_bdev(cache->desc);
+		page->bio_wait.cb_fn = ftl_l2p_cache_page_resubmit;
+		page->bio_wait.cb_arg = page;
+
+		rc = spdk_bdev_queue_io_wait(page->bio_wait.bdev, cache->ioch, &page->bio_wait);
+	}
+
+	if (spdk_unlikely(rc != 0)) {
+		ftl_l2p_cache_page_io_done(page, rc);
+	}
+}
+
+static void
+ftl_l2p_cache_page_writeback(struct ftl_l2p_page *page)
+{
+	assert(page->state == FTL_L2P_PAGE_READY);
+	assert(!page->writeback);
+
+	page->writeback = true;
+	__atomic_store_n(&page->dirty, false, __ATOMIC_SEQ_CST);
+	page->cache->num_writebacks++;
+
+	ftl_l2p_cache_page_submit(page);
+}
+
+static void
+ftl_l2p_cache_page_load(struct ftl_l2p_page *page, struct ftl_l2p_cache_waiter *waiter)
+{
+	struct ftl_l2p_cache *cache = page->cache;
+
+	assert(page->pin_cnt == FTL_L2P_PAGE_UNUSED);
+
+	page->page_idx = waiter->page_idx;
+	page->state = FTL_L2P_PAGE_LOADING;
+	page->accessed = false;
+	page->dirty = false;
+	TAILQ_INSERT_TAIL(&page->waiters, waiter, tailq);
+	__atomic_store_n(&cache->page_map[page->page_idx], page, __ATOMIC_SEQ_CST);
+
+	if (spdk_bit_array_get(cache->persisted, (uint32_t)page->page_idx)) {
+		ftl_l2p_cache_page_submit(page);
+	} else {
+		memset(page->buf, FTL_ADDR_INVALID, FTL_L2P_CACHE_PAGE_SIZE);
+		ftl_l2p_cache_page_load_done(page, 0);
+	}
+}
+
+/* Moves the pages accessed since the last update to the end of the LRU list */
+static void
+ftl_l2p_cache_update_lru(struct ftl_l2p_cache *cache)
+{
+	struct ftl_l2p_page *page, *tmp;
+	TAILQ_HEAD(, ftl_l2p_page) accessed;
+
+	TAILQ_INIT(&accessed);
+
+	TAILQ_FOREACH_SAFE(page, &cache->lru_list, tailq, tmp) {
+		if (__atomic_exchange_n(&page->accessed, false, __ATOMIC_SEQ_CST)) {
+			TAILQ_REMOVE(&cache->lru_list, page, tailq);
+			TAILQ_INSERT_TAIL(&accessed, page, tailq);
+		}
+	}
+
+	TAILQ_CONCAT(&cache->lru_list, &accessed, tailq);
+}
+
+/* Prevents the page from being pinned, as long as it's clean and isn't pinned already */
+static bool
+ftl_l2p_cache_page_claim(struct ftl_l2p_page *page)
+{
+	unsigned int pin_cnt = 0;
+
+	if (!__atomic_compare_exchange_n(&page->pin_cnt, &pin_cnt, FTL_L2P_PAGE_UNUSED, false,
+					 __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+		return false;
+	}
+
+	/* The page might have been modified right before it was claimed */
+	if (spdk_unlikely(__atomic_load_n(&page->dirty, __ATOMIC_SEQ_CST))) {
+		__atomic_store_n(&page->pin_cnt, 0, __ATOMIC_SEQ_CST);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Finds a slot for a new page, either an unused one or one held by a clean page that isn't
+ * pinned. Dirty pages encountered on the way are written back, so that they can be dropped
+ * once that's done.
+ */
+static struct ftl_l2p_page *
+ftl_l2p_cache_get_free_page(struct ftl_l2p_cache *cache)
+{
+	struct ftl_l2p_page *page, *tmp;
+
+	page = TAILQ_FIRST(&cache->free_list);
+	if (page != NULL) {
+		TAILQ_REMOVE(&cache->free_list, page, tailq);
+		cache->num_resident++;
+		return page;
+	}
+
+	ftl_l2p_cache_update_lru(cache);
+
+	TAILQ_FOREACH_SAFE(page, &cache->lru_list, tailq, tmp) {
+		if (page->writeback || __atomic_load_n(&page->pin_cnt, __ATOMIC_SEQ_CST) > 0) {
+			continue;
+		}
+
+		if (ftl_l2p_cache_page_claim(page)) {
+			TAILQ_REMOVE(&cache->lru_list, page, tailq);
+			__atomic_store_n(&cache->page_map[page->page_idx], NULL, __ATOMIC_SEQ_CST);
+			cache->stats.evictions++;
+			return page;
+		}
+
+		if (!__atomic_load_n(&page->dirty, __ATOMIC_SEQ_CST)) {
+			/* The page was pinned in the meantime */
+			continue;
+		}
+
+		if (cache->num_writebacks < FTL_L2P_CACHE_MAX_WRITEBACKS) {
+			ftl_l2p_cache_page_writeback(page);
+		}
+	}
+
+	return NULL;
+}
+
+static void
+ftl_l2p_cache_remove_pending(struct ftl_l2p_cache *cache, struct ftl_l2p_cache_waiter *waiter)
+{
+	TAILQ_REMOVE(&cache->pending, waiter, tailq);
+	__atomic_sub_fetch(&cache->num_pending, 1, __ATOMIC_SEQ_CST);
+}
+
+static void
+ftl_l2p_cache_process_pending(void *ctx)
+{
+	struct ftl_l2p_cache *cache = ctx;
+	struct ftl_l2p_cache_waiter *waiter;
+	struct ftl_l2p_waiter_list wake;
+	struct ftl_l2p_page *page;
+
+	TAILQ_INIT(&wake);
+
+	pthread_mutex_lock(&cache->lock);
+	cache->pending_scheduled = false;
+
+	while ((waiter = TAILQ_FIRST(&cache->pending)) != NULL) {
+		page = cache->page_map[waiter->page_idx];
+		if (page != NULL) {
+			ftl_l2p_cache_remove_pending(cache, waiter);
+			if (page->state == FTL_L2P_PAGE_READY) {
+				TAILQ_INSERT_TAIL(&wake, waiter, tailq);
+			} else {
+				TAILQ_INSERT_TAIL(&page->waiters, waiter, tailq);
+			}
+
+			continue;
+		}
+
+		if (spdk_unlikely(cache->status != 0)) {
+			ftl_l2p_cache_remove_pending(cache, waiter);
+			waiter->status = cache->status;
+			TAILQ_INSERT_TAIL(&wake, waiter, tailq);
+			continue;
+		}
+
+		/* The remaining requests are retried once a page is written back or unpinned */
+		page = ftl_l2p_cache_get_free_page(cache);
+		if (!page) {
+			break;
+		}
+
+		ftl_l2p_cache_remove_pending(cache, waiter);
+		ftl_l2p_cache_page_load(page, waiter);
+	}
+
+	ftl_l2p_cache_wake(&wake);
+	pthread_mutex_unlock(&cache->lock);
+}
+
+/*
+ * Pins the page if it's resident. Doesn't need the lock, as the page cannot be dropped or
+ * reused while its pin count is neither zero nor FTL_L2P_PAGE_UNUSED.
+ */
+static struct ftl_l2p_page *
+ftl_l2p_cache_page_try_pin(struct ftl_l2p_cache *cache, uint64_t page_idx)
+{
+	struct ftl_l2p_page *page;
+	unsigned int pin_cnt;
+
+	page = __atomic_load_n(&cache->page_map[page_idx], __ATOMIC_SEQ_CST);
+	if (page == NULL) {
+		return NULL;
+	}
+
+	pin_cnt = __atomic_load_n(&page->pin_cnt, __ATOMIC_SEQ_CST);
+	do {
+		if (pin_cnt == FTL_L2P_PAGE_UNUSED) {
+			return NULL;
+		}
+	} while (!__atomic_compare_exchange_n(&page->pin_cnt, &pin_cnt, pin_cnt + 1, false,
+					      __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST));
+
+	/* The page could have been reused for another part of the table in the meantime */
+	if (spdk_unlikely(page->page_idx != page_idx)) {
+		ftl_l2p_cache_page_unpin(page);
+		return NULL;
+	}
+
+	return page;
+}
+
+static void
+ftl_l2p_cache_page_unpin(struct ftl_l2p_page *page)
+{
+	struct ftl_l2p_cache *cache = page->cache;
+
+	assert(page->pin_cnt > 0 && page->pin_cnt != FTL_L2P_PAGE_UNUSED);
+
+	/* Once the page is unpinned it can be dropped to make room for the pending requests */
+	if (__atomic_sub_fetch(&page->pin_cnt, 1, __ATOMIC_SEQ_CST) == 0 &&
+	    __atomic_load_n(&cache->num_pending, __ATOMIC_SEQ_CST) > 0) {
+		pthread_mutex_lock(&cache->lock);
+		ftl_l2p_cache_schedule_pending(cache);
+		pthread_mutex_unlock(&cache->lock);
+	}
+}
+
+int
+ftl_l2p_cache_pin(struct ftl_l2p_cache *cache, uint64_t idx, struct ftl_l2p_cache_waiter *waiter,
+		  ftl_l2p_cache_fn cb_fn, void *cb_arg)
+{
+	uint64_t page_idx = idx / cache->entries_per_page;
+	struct ftl_l2p_page *page;
+	int rc = -EAGAIN;
+
+	assert(idx < cache->num_entries);
+
+	page = ftl_l2p_cache_page_try_pin(cache, page_idx);
+	if (spdk_likely(page != NULL)) {
+		__atomic_store_n(&page->accessed, true, __ATOMIC_SEQ_CST);
+		__atomic_add_fetch(&cache->stats.hits, 1, __ATOMIC_RELAXED);
+		return 0;
+	}
+
+	pthread_mutex_lock(&cache->lock);
+	page = cache->page_map[page_idx];
+	if (page != NULL && page->state == FTL_L2P_PAGE_READY) {
+		/* The page was loaded after the lookup above, it cannot be claimed while the */
+		/* lock is held */
+		__atomic_add_fetch(&page->pin_cnt, 1, __ATOMIC_SEQ_CST);
+		__atomic_store_n(&page->accessed, true, __ATOMIC_SEQ_CST);
+		__atomic_add_fetch(&cache->stats.hits, 1, __ATOMIC_RELAXED);
+		rc = 0;
+		goto out;
+	}
+
+	if (spdk_unlikely(page == NULL && cache->status != 0)) {
+		rc = cache->status;
+		goto out;
+	}
+
+	cache->stats.misses++;
+
+	waiter->page_idx = page_idx;
+	waiter->cb_fn = cb_fn;
+	waiter->cb_arg = cb_arg;
+	waiter->thread = spdk_get_thread();
+	waiter->status = 0;
+
+	if (page != NULL) {
+		TAILQ_INSERT_TAIL(&page->waiters, waiter, tailq);
+	} else {
+		TAILQ_INSERT_TAIL(&cache->pending, waiter, tailq);
+		__atomic_add_fetch(&cache->num_pending, 1, __ATOMIC_SEQ_CST);
+		ftl_l2p_cache_schedule_pending(cache);
+	}
+out:
+	pthread_mutex_unlock(&cache->lock);
+	return rc;
+}
+
+void
+ftl_l2p_cache_unpin(struct ftl_l2p_cache *cache, uint64_t idx)
+{
+	struct ftl_l2p_page *page;
+
+	assert(idx < cache->num_entries);
+
+	page = __atomic_load_n(&cache->page_map[idx / cache->entries_per_page], __ATOMIC_SEQ_CST);
+	assert(page != NULL);
+
+	ftl_l2p_cache_page_unpin(page);
+}
+
+int
+ftl_l2p_cache_get(struct ftl_l2p_cache *cache, uint64_t idx, uint64_t *val)
+{
+	struct ftl_l2p_page *page;
+	uint64_t offset;
+
+	assert(idx < cache->num_entries);
+
+	/* Pin the page for the duration of the lookup, in case the caller didn't */
+	page = ftl_l2p_cache_page_try_pin(cache, idx / cache->entries_per_page);
+	if (spdk_unlikely(page == NULL)) {
+		return -EAGAIN;
+	}
+
+	offset = idx % cache->entries_per_page;
+	if (cache->entry_size == sizeof(uint32_t)) {
+		*val = __atomic_load_n((uint32_t *)page->buf + offset, __ATOMIC_SEQ_CST);
+	} else {
+		*val = __atomic_load_n((uint64_t *)page->buf + offset, __ATOMIC_SEQ_CST);
+	}
+
+	ftl_l2p_cache_page_unpin(page);
+
+	return 0;
+}
+
+int
+ftl_l2p_cache_set(struct ftl_l2p_cache *cache, uint64_t idx, uint64_t val)
+{
+	struct ftl_l2p_page *page;
+	uint64_t offset;
+
+	assert(idx < cache->num_entries);
+
+	page = ftl_l2p_cache_page_try_pin(cache, idx / cache->entries_per_page);
+	if (spdk_unlikely(page == NULL)) {
+		return -EAGAIN;
+	}
+
+	offset = idx % cache->entries_per_page;
+	if (cache->entry_size == sizeof(uint32_t)) {
+		__atomic_store_n((uint32_t *)page->buf + offset, (uint32_t)val, __ATOMIC_SEQ_CST);
+	} else {
+		__atomic_store_n((uint64_t *)page->buf + offset, val, __ATOMIC_SEQ_CST);
+	}
+
+	/* Needs to be marked after the entry is updated in case it's being written back */
+	__atomic_store_n(&page->dirty, true, __ATOMIC_SEQ_CST);
+	ftl_l2p_cache_page_unpin(page);
+
+	return 0;
+}
+
+void
+ftl_l2p_cache_flush(struct ftl_l2p_cache *cache, ftl_l2p_cache_fn cb_fn, void *cb_arg)
+{
+	struct ftl_l2p_page *page;
+
+	assert(spdk_get_thread() == cache->thread);
+
+	pthread_mutex_lock(&cache->lock);
+	assert(!cache->flush.active);
+
+	cache->flush.cb_fn = cb_fn;
+	cache->flush.cb_arg = cb_arg;
+	cache->flush.status = 0;
+	cache->flush.active = true;
+
+	TAILQ_FOREACH(page, &cache->lru_list, tailq) {
+		if (__atomic_load_n(&page->dirty, __ATOMIC_SEQ_CST) && !page->writeback) {
+			ftl_l2p_cache_page_writeback(page);
+		}
+	}
+
+	if (cache->flush.active && cache->num_writebacks == 0) {
+		ftl_l2p_cache_flush_complete(cache);
+	}
+	pthread_mutex_unlock(&cache->lock);
+}
+
+void
+ftl_l2p_cache_put_io_channel(struct ftl_l2p_cache *cache)
+{
+	assert(spdk_get_thread() == cache->thread);
+	assert(cache->num_writebacks == 0);
+
+	if (cache->ioch) {
+		spdk_put_io_channel(cache->ioch);
+		cache->ioch = NULL;
+	}
+}
+
+size_t
+ftl_l2p_cache_num_resident(const struct ftl_l2p_cache *cache)
+{
+	return cache->num_resident;
+}
+
+void
+ftl_l2p_cache_get_stats(const struct ftl_l2p_cache *cache, struct ftl_l2p_cache_stats *stats)
+{
+	*stats = cache->stats;
+}
+
+static int
+ftl_l2p_cache_check_bdev(struct ftl_l2p_cache *cache)
+{
+	struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(cache->desc);
+	uint32_t block_size = spdk_bdev_get_block_size(bdev);
+
+	if (block_size > FTL_L2P_CACHE_PAGE_SIZE || FTL_L2P_CACHE_PAGE_SIZE % block_size != 0) {
+		SPDK_ERRLOG("Unsupported l2p bdev block size (%"PRIu32")\n", block_size);
+		return -EINVAL;
+	}
+
+	cache->blocks_per_page = FTL_L2P_CACHE_PAGE_SIZE / block_size;
+	if (spdk_bdev_get_num_blocks(bdev) < cache->num_pages * cache->blocks_per_page) {
+		SPDK_ERRLOG("l2p bdev is too small, need at least %"PRIu64" bytes\n",
+			    cache->num_pages * FTL_L2P_CACHE_PAGE_SIZE);
+		return -ENOSPC;
+	}
+
+	return 0;
+}
+
+struct ftl_l2p_cache *
+ftl_l2p_cache_init(struct spdk_bdev_desc *desc, struct spdk_thread *thread, uint64_t num_entries,
+		   size_t entry_size, size_t max_size)
+{
+	struct ftl_l2p_cache *cache;
+	size_t i;
+
+	if (entry_size != sizeof(uint32_t) && entry_size != sizeof(uint64_t)) {
+		SPDK_ERRLOG("Invalid L2P entry size: %zu\n", entry_size);
+		return NULL;
+	}
+
+	cache = calloc(1, sizeof(*cache));
+	if (!cache) {
+		return NULL;
+	}
+
+	cache->desc = desc;
+	cache->thread = thread;
+	cache->entry_size = entry_size;
+	cache->num_entries = num_entries;
+	cache->entries_per_page = FTL_L2P_CACHE_PAGE_SIZE / entry_size;
+	cache->num_pages = spdk_divide_round_up(num_entries, cache->entries_per_page);
+	cache->num_slots = spdk_min(max_size / FTL_L2P_CACHE_PAGE_SIZE, cache->num_pages);
+	TAILQ_INIT(&cache->free_list);
+	TAILQ_INIT(&cache->lru_list);
+	TAILQ_INIT(&cache->pending);
+
+	if (cache->num_slots == 0) {
+		SPDK_ERRLOG("L2P memory limit too small, need at least %u bytes\n",
+			    FTL_L2P_CACHE_PAGE_SIZE);
+		goto error;
+	}
+
+	if (cache->num_pages > UINT32_MAX) {
+		SPDK_ERRLOG("L2P table too large\n");
+		goto error;
+	}
+
+	if (ftl_l2p_cache_check_bdev(cache)) {
+		goto error;
+	}
+
+	cache->page_map = calloc(cache->num_pages, sizeof(*cache->page_map));
+	cache->persisted = spdk_bit_array_create((uint32_t)cache->num_pages);
+	cache->pages = calloc(cache->num_slots, sizeof(*cache->pages));
+	if (!cache->page_map || !cache->persisted || !cache->pages) {
+		goto error;
+	}
+
+	cache->page_buf = spdk_zmalloc(cache->num_slots * FTL_L2P_CACHE_PAGE_SIZE,
+				       FTL_L2P_CACHE_PAGE_SIZE, NULL, SPDK_ENV_LCORE_ID_ANY,
+				       SPDK_MALLOC_DMA);
+	if (!cache->page_buf) {
+		goto error;
+	}
+
+	for (i = 0; i < cache->num_slots; ++i) {
+		cache->pages[i].cache = cache;
+		cache->pages[i].pin_cnt = FTL_L2P_PAGE_UNUSED;
+		cache->pages[i].buf = (char *)cache->page_buf + i * FTL_L2P_CACHE_PAGE_SIZE;
+		TAILQ_INIT(&cache->pages[i].waiters);
+		TAILQ_INSERT_TAIL(&cache->free_list, &cache->pages[i], tailq);
+	}
+
+	if (pthread_mutex_init(&cache->lock, NULL)) {
+		goto error;
+	}
+
+	return cache;
+error:
+	spdk_free(cache->page_buf);
+	free(cache->pages);
+	spdk_bit_array_free(&cache->persisted);
+	free(cache->page_map);
+	free(cache);
+	return NULL;
+}
+
+void
+ftl_l2p_cache_free(struct ftl_l2p_cache *cache)
+{
+	if (!cache) {
+		return;
+	}
+
+	assert(!cache->ioch);
+	assert(TAILQ_EMPTY(&cache->pending));
+
+	pthread_mutex_destroy(&cache->lock);
+	spdk_free(cache->page_buf);
+	free(cache->pages);
+	spdk_bit_array_free(&cache->persisted);
+	free(cache->page_map);
+	free(cache);
+}
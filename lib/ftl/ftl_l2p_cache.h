@@ -0,0 +1,109 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FTL_L2P_CACHE_H
+#define FTL_L2P_CACHE_H
+
+#include "spdk/stdinc.h"
+#include "spdk/queue.h"
+
+struct spdk_bdev_desc;
+struct spdk_thread;
+struct ftl_l2p_cache;
+
+typedef void (*ftl_l2p_cache_fn)(void *cb_arg, int status);
+
+/* Request waiting for an L2P page to become resident */
+struct ftl_l2p_cache_waiter {
+	/* Index of the page the request is waiting for */
+	uint64_t				page_idx;
+
+	/* Callback executed on the waiter's thread once the page is loaded */
+	ftl_l2p_cache_fn			cb_fn;
+	void					*cb_arg;
+	struct spdk_thread			*thread;
+
+	/* Status passed to the callback */
+	int					status;
+
+	TAILQ_ENTRY(ftl_l2p_cache_waiter)	tailq;
+};
+
+struct ftl_l2p_cache_stats {
+	/* Number of lookups served from resident pages */
+	uint64_t				hits;
+	/* Number of lookups that required loading a page */
+	uint64_t				misses;
+	/* Number of pages dropped to make room for other pages */
+	uint64_t				evictions;
+	/* Number of dirty pages written back to the backing bdev */
+	uint64_t				writebacks;
+};
+
+/*
+ * All of the page I/O is submitted from the thread passed in here, while the lookups can be
+ * done from any thread.
+ */
+struct ftl_l2p_cache	*ftl_l2p_cache_init(struct spdk_bdev_desc *desc, struct spdk_thread *thread,
+		uint64_t num_entries, size_t entry_size, size_t max_size);
+void			ftl_l2p_cache_free(struct ftl_l2p_cache *cache);
+
+/*
+ * Makes sure the page holding given entry stays resident until it's unpinned. Returns 0 if the
+ * page was already resident, -EAGAIN if it needs to be loaded first (in which case cb_fn is
+ * called on the current thread once the pin can be retried), or other negative errno when the
+ * page cannot be loaded.
+ */
+int			ftl_l2p_cache_pin(struct ftl_l2p_cache *cache, uint64_t idx,
+					  struct ftl_l2p_cache_waiter *waiter,
+					  ftl_l2p_cache_fn cb_fn, void *cb_arg);
+void			ftl_l2p_cache_unpin(struct ftl_l2p_cache *cache, uint64_t idx);
+
+/*
+ * Both return -EAGAIN if the entry's page isn't resident, which cannot happen as long as the
+ * caller keeps the page pinned. Neither of them takes the cache's lock.
+ */
+int			ftl_l2p_cache_get(struct ftl_l2p_cache *cache, uint64_t idx, uint64_t *val);
+int			ftl_l2p_cache_set(struct ftl_l2p_cache *cache, uint64_t idx, uint64_t val);
+
+/* Writes back all dirty pages, needs to be called on the cache's thread */
+void			ftl_l2p_cache_flush(struct ftl_l2p_cache *cache, ftl_l2p_cache_fn cb_fn,
+		void *cb_arg);
+/* Releases the IO channel used for the page I/O, needs to be called on the cache's thread */
+void			ftl_l2p_cache_put_io_channel(struct ftl_l2p_cache *cache);
+
+size_t			ftl_l2p_cache_num_resident(const struct ftl_l2p_cache *cache);
+void			ftl_l2p_cache_get_stats(const struct ftl_l2p_cache *cache,
+		struct ftl_l2p_cache_stats *stats);
+
+#endif /* FTL_L2P_CACHE_H */
@@ -48,6 +48,10 @@ struct ftl_restore_band {
 	struct ftl_band			*band;
 	/* Status of retrieving this band's metadata */
 	enum ftl_md_status		md_status;
+	/* Offset of the next block to restore the L2P from */
+	size_t				l2p_offset;
+	/* Used for waiting on L2P pages to be loaded */
+	struct ftl_l2p_cache_waiter	l2p_waiter;
 	/* Padded queue link  */
 	STAILQ_ENTRY(ftl_restore_band)	stailq;
 };
@@ -382,15 +386,24 @@ ftl_restore_md(struct spdk_ftl_dev *dev, ftl_restore_fn cb, void *cb_arg)
 	return 0;
 }
 
+static void ftl_restore_l2p_cb(void *ctx, int status);
+
+/*
+ * Returns -EAGAIN when the restoration has to wait for an L2P page to be loaded, in which case
+ * it's resumed from ftl_restore_l2p_cb().
+ */
 static int
-ftl_restore_l2p(struct ftl_band *band)
+ftl_restore_l2p(struct ftl_restore_band *rband)
 {
+	struct ftl_band *band = rband->band;
 	struct spdk_ftl_dev *dev = band->dev;
 	struct ftl_addr addr;
 	uint64_t lba;
 	size_t i;
+	int rc;
 
-	for (i = 0; i < ftl_get_num_blocks_in_band(band->dev); ++i) {
+	for (; rband->l2p_offset < ftl_get_num_blocks_in_band(dev); ++rband->l2p_offset) {
+		i = rband->l2p_offset;
 		if (!spdk_bit_array_get(band->lba_map.vld, i)) {
 			continue;
 		}
@@ -400,6 +413,11 @@ ftl_restore_l2p(struct ftl_band *band)
 			return -1;
 		}
 
+		rc = ftl_l2p_pin(dev, lba, &rband->l2p_waiter, ftl_restore_l2p_cb, rband);
+		if (spdk_unlikely(rc != 0)) {
+			return rc;
+		}
+
 		addr = ftl_l2p_get(dev, lba);
 		if (!ftl_addr_invalid(addr)) {
 			ftl_invalidate_addr(dev, addr);
@@ -409,6 +427,7 @@ ftl_restore_l2p(struct ftl_band *band)
 
 		ftl_band_set_addr(band, lba, addr);
 		ftl_l2p_set(dev, lba, addr);
+		ftl_l2p_unpin(dev, lba);
 	}
 
 	return 0;
@@ -1269,32 +1288,16 @@ ftl_restore_pad_open_bands(void *ctx)
 }
 
 static void
-ftl_restore_tail_md_cb(struct ftl_io *io, void *ctx, int status)
+ftl_restore_l2p_done(struct ftl_restore_band *rband, int status)
 {
-	struct ftl_restore_band *rband = ctx;
 	struct ftl_restore *restore = rband->parent;
 	struct spdk_ftl_dev *dev = restore->dev;
 
+	ftl_band_release_lba_map(rband->band);
 	if (status) {
-		if (!dev->conf.allow_open_bands) {
-			SPDK_ERRLOG("%s while restoring tail md in band %u.\n",
-				    spdk_strerror(-status), rband->band->id);
-			ftl_band_release_lba_map(rband->band);
-			ftl_restore_complete(restore, status);
-			return;
-		} else {
-			SPDK_ERRLOG("%s while restoring tail md. Will attempt to pad band %u.\n",
-				    spdk_strerror(-status), rband->band->id);
-			STAILQ_INSERT_TAIL(&restore->pad_bands, rband, stailq);
-		}
-	}
-
-	if (!status && ftl_restore_l2p(rband->band)) {
-		ftl_band_release_lba_map(rband->band);
 		ftl_restore_complete(restore, -ENOTRECOVERABLE);
 		return;
 	}
-	ftl_band_release_lba_map(rband->band);
 
 	rband = ftl_restore_next_band(restore);
 	if (!rband) {
@@ -1311,6 +1314,48 @@ ftl_restore_tail_md_cb(struct ftl_io *io, void *ctx, int status)
 	ftl_restore_tail_md(rband);
 }
 
+static void
+ftl_restore_l2p_cb(void *ctx, int status)
+{
+	struct ftl_restore_band *rband = ctx;
+
+	if (!status) {
+		status = ftl_restore_l2p(rband);
+		if (status == -EAGAIN) {
+			return;
+		}
+	}
+
+	ftl_restore_l2p_done(rband, status);
+}
+
+static void
+ftl_restore_tail_md_cb(struct ftl_io *io, void *ctx, int status)
+{
+	struct ftl_restore_band *rband = ctx;
+	struct ftl_restore *restore = rband->parent;
+	struct spdk_ftl_dev *dev = restore->dev;
+
+	if (status) {
+		if (!dev->conf.allow_open_bands) {
+			SPDK_ERRLOG("%s while restoring tail md in band %u.\n",
+				    spdk_strerror(-status), rband->band->id);
+			ftl_band_release_lba_map(rband->band);
+			ftl_restore_complete(restore, status);
+			return;
+		} else {
+			SPDK_ERRLOG("%s while restoring tail md. Will attempt to pad band %u.\n",
+				    spdk_strerror(-status), rband->band->id);
+			STAILQ_INSERT_TAIL(&restore->pad_bands, rband, stailq);
+		}
+
+		ftl_restore_l2p_done(rband, 0);
+		return;
+	}
+
+	ftl_restore_l2p_cb(rband, 0);
+}
+
 static int
 ftl_restore_tail_md(struct ftl_restore_band *rband)
 {
@@ -35,8 +35,123 @@
 
 #include "spdk_internal/utf.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #define SPDK_JSON_MAX_NESTING_DEPTH	64
 
+static inline bool
+json_is_whitespace(uint8_t c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static inline bool
+json_is_plain_string_char(uint8_t c)
+{
+	/* Printable ASCII that is copied to the decoded string unchanged */
+	return c >= 0x20 && c < 0x80 && c != '"' && c != '\\';
+}
+
+/*
+ * Find the length of the run of plain string characters (see json_is_plain_string_char())
+ *  at the beginning of str.
+ *
+ * Most strings in JSON-RPC requests and configuration files consist only of such characters,
+ *  so they are classified 16 bytes at a time where SIMD instructions are available.
+ */
+static inline size_t
+json_plain_string_len(const uint8_t *str, const uint8_t *buf_end)
+{
+	const uint8_t *p = str;
+
+#if defined(__SSE2__)
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i space = _mm_set1_epi8(0x20);
+	__m128i v, special;
+	int mask;
+
+	while (buf_end - p >= 16) {
+		v = _mm_loadu_si128((const __m128i *)p);
+		/* Signed compare catches both control characters and bytes >= 0x80 */
+		special = _mm_or_si128(_mm_cmplt_epi8(v, space),
+				       _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)));
+		mask = _mm_movemask_epi8(special);
+		if (mask != 0) {
+			return p - str + __builtin_ctz(mask);
+		}
+		p += 16;
+	}
+#elif defined(__aarch64__)
+	const uint8x16_t quote = vdupq_n_u8('"');
+	const uint8x16_t backslash = vdupq_n_u8('\\');
+	const uint8x16_t space = vdupq_n_u8(0x20);
+	const uint8x16_t high = vdupq_n_u8(0x80);
+	uint8x16_t v, special;
+	uint64_t mask;
+
+	while (buf_end - p >= 16) {
+		v = vld1q_u8(p);
+		special = vorrq_u8(vorrq_u8(vcltq_u8(v, space), vcgeq_u8(v, high)),
+				   vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)));
+		/* Narrow to 4 bits per input byte so the first match can be found with ctz */
+		mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(special), 4)), 0);
+		if (mask != 0) {
+			return p - str + (__builtin_ctzll(mask) >> 2);
+		}
+		p += 16;
+	}
+#endif
+
+	while (p < buf_end && json_is_plain_string_char(*p)) {
+		p++;
+	}
+
+	return p - str;
+}
+
+/*
+ * Skip a run of whitespace starting at data.
+ *
+ * \return Pointer to the first non-whitespace byte or buf_end.
+ */
+static inline uint8_t *
+json_skip_whitespace(uint8_t *data, uint8_t *buf_end)
+{
+#if defined(__SSE2__)
+	const __m128i sp = _mm_set1_epi8(' ');
+	const __m128i tab = _mm_set1_epi8('\t');
+	const __m128i cr = _mm_set1_epi8('\r');
+	const __m128i lf = _mm_set1_epi8('\n');
+	__m128i v, ws;
+	int mask;
+
+	/* Short runs (single spaces between tokens) are cheaper to handle one byte at a time */
+	if (buf_end - data >= 16 && json_is_whitespace(data[0]) && json_is_whitespace(data[1])) {
+		do {
+			v = _mm_loadu_si128((const __m128i *)data);
+			ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, tab)),
+					  _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, lf)));
+			mask = ~_mm_movemask_epi8(ws) & 0xffff;
+			if (mask != 0) {
+				return data + __builtin_ctz(mask);
+			}
+			data += 16;
+		} while (buf_end - data >= 16);
+	}
+#endif
+
+	while (data < buf_end && json_is_whitespace(*data)) {
+		data++;
+	}
+
+	return data;
+}
+
 static int
 hex_value(uint8_t c)
 {
@@ -199,6 +314,7 @@ json_decode_string(uint8_t *str_start, uint8_t *buf_end, uint8_t **str_end, uint
 {
 	uint8_t *str = str_start;
 	uint8_t *out = str_start + 1; /* Decode string in place (skip the initial quote) */
+	size_t plain_len;
 	int rc;
 
 	if (buf_end - str_start < 2) {
@@ -216,6 +332,18 @@ json_decode_string(uint8_t *str_start, uint8_t *buf_end, uint8_t **str_end, uint
 	}
 
 	while (str < buf_end) {
+		plain_len = json_plain_string_len(str, buf_end);
+		if (plain_len != 0) {
+			if (out != str && (flags & SPDK_JSON_PARSE_FLAG_DECODE_IN_PLACE)) {
+				memmove(out, str, plain_len);
+			}
+			out += plain_len;
+			str += plain_len;
+			if (str == buf_end) {
+				break;
+			}
+		}
+
 		if (str[0] == '"') {
 			/*
 			 * End of string.
@@ -480,7 +608,7 @@ spdk_json_parse(void *json, size_t size, struct spdk_json_val *values, size_t nu
 		case '\r':
 		case '\n':
 			/* Whitespace is allowed between any tokens. */
-			data++;
+			data = json_skip_whitespace(data, json_end);
 			break;
 
 		case 't':
@@ -629,15 +757,7 @@ spdk_json_parse(void *json, size_t size, struct spdk_json_val *values, size_t nu
 
 	if (state == STATE_END) {
 		/* Skip trailing whitespace */
-		while (data < json_end) {
-			uint8_t c = *data;
-
-			if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
-				data++;
-			} else {
-				break;
-			}
-		}
+		data = json_skip_whitespace(data, json_end);
 
 		/*
 		 * These asserts are just for sanity checking - they are guaranteed by the allowed
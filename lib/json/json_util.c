@@ -32,12 +32,127 @@
  */
 
 #include "spdk/json.h"
+#include "spdk/util.h"
 
 #include "spdk_internal/utf.h"
 #include "spdk_internal/log.h"
 
 #define SPDK_JSON_DEBUG(...) SPDK_DEBUGLOG(SPDK_LOG_JSON_UTIL, __VA_ARGS__)
 
+#define SPDK_JSON_ARENA_DEFAULT_CHUNK_SIZE	(64 * 1024)
+#define SPDK_JSON_ARENA_ALIGN			8
+#define SPDK_JSON_ARENA_MIN_FREE		64
+
+/* Objects with up to this many decoders track seen members on the stack */
+#define SPDK_JSON_DECODE_MAX_STACK_DECODERS	64
+
+struct spdk_json_arena_chunk {
+	struct spdk_json_arena_chunk	*next;
+	size_t				size;
+	size_t				used;
+	uint8_t				data[];
+};
+
+struct spdk_json_arena {
+	/* Chunks in allocation order; cur is the first one that may have free space */
+	struct spdk_json_arena_chunk	*head;
+	struct spdk_json_arena_chunk	*cur;
+	size_t				chunk_size;
+};
+
+/* Arena used by spdk_json_decode_string() while spdk_json_decode_object_arena() runs */
+static __thread struct spdk_json_arena *t_decode_arena;
+
+struct spdk_json_arena *
+spdk_json_arena_create(size_t chunk_size)
+{
+	struct spdk_json_arena *arena;
+
+	arena = calloc(1, sizeof(*arena));
+	if (arena == NULL) {
+		return NULL;
+	}
+
+	arena->chunk_size = chunk_size ? chunk_size : SPDK_JSON_ARENA_DEFAULT_CHUNK_SIZE;
+	return arena;
+}
+
+void *
+spdk_json_arena_alloc(struct spdk_json_arena *arena, size_t size)
+{
+	struct spdk_json_arena_chunk *chunk, *last = NULL;
+	size_t chunk_size;
+	void *buf;
+
+	size = (size + SPDK_JSON_ARENA_ALIGN - 1) & ~((size_t)SPDK_JSON_ARENA_ALIGN - 1);
+
+	for (chunk = arena->cur; chunk != NULL; chunk = chunk->next) {
+		if (chunk->size - chunk->used >= size) {
+			break;
+		}
+		last = chunk;
+	}
+
+	if (chunk == NULL) {
+		chunk_size = spdk_max(arena->chunk_size, size);
+		chunk = malloc(sizeof(*chunk) + chunk_size);
+		if (chunk == NULL) {
+			return NULL;
+		}
+
+		chunk->next = NULL;
+		chunk->size = chunk_size;
+		chunk->used = 0;
+		if (last != NULL) {
+			last->next = chunk;
+		} else {
+			/* cur is only NULL while the arena has no chunks at all */
+			arena->head = chunk;
+			arena->cur = chunk;
+		}
+	}
+
+	buf = chunk->data + chunk->used;
+	chunk->used += size;
+
+	/* Don't keep searching chunks that are (nearly) full */
+	while (arena->cur->next != NULL &&
+	       arena->cur->size - arena->cur->used < SPDK_JSON_ARENA_MIN_FREE) {
+		arena->cur = arena->cur->next;
+	}
+
+	return buf;
+}
+
+void
+spdk_json_arena_reset(struct spdk_json_arena *arena)
+{
+	struct spdk_json_arena_chunk *chunk;
+
+	for (chunk = arena->head; chunk != NULL; chunk = chunk->next) {
+		chunk->used = 0;
+	}
+
+	arena->cur = arena->head;
+}
+
+void
+spdk_json_arena_free(struct spdk_json_arena *arena)
+{
+	struct spdk_json_arena_chunk *chunk, *next;
+
+	if (arena == NULL) {
+		return;
+	}
+
+	for (chunk = arena->head; chunk != NULL; chunk = next) {
+		next = chunk->next;
+		free(chunk);
+	}
+
+	free(arena);
+}
+
 size_t
 spdk_json_val_len(const struct spdk_json_val *val)
 {
@@ -97,6 +212,34 @@ spdk_json_strdup(const struct spdk_json_val *val)
 	return s;
 }
 
+static char *
+json_strdup_arena(const struct spdk_json_val *val, struct spdk_json_arena *arena)
+{
+	size_t len;
+	char *s;
+
+	if (val->type != SPDK_JSON_VAL_STRING && val->type != SPDK_JSON_VAL_NAME) {
+		return NULL;
+	}
+
+	len = val->len;
+
+	if (memchr(val->start, '\0', len)) {
+		/* String contains embedded NUL, so it is not a valid C string. */
+		return NULL;
+	}
+
+	s = spdk_json_arena_alloc(arena, len + 1);
+	if (s == NULL) {
+		return NULL;
+	}
+
+	memcpy(s, val->start, len);
+	s[len] = '\0';
+
+	return s;
+}
+
 struct spdk_json_num {
 	bool negative;
 	uint64_t significand;
@@ -305,15 +448,21 @@ spdk_json_decode_object(const struct spdk_json_val *values,
 	uint32_t i;
 	bool invalid = false;
 	size_t decidx;
+	bool seen_stack[SPDK_JSON_DECODE_MAX_STACK_DECODERS];
 	bool *seen;
 
 	if (values == NULL || values->type != SPDK_JSON_VAL_OBJECT_BEGIN) {
 		return -1;
 	}
 
-	seen = calloc(sizeof(bool), num_decoders);
-	if (seen == NULL) {
-		return -1;
+	if (num_decoders <= SPDK_COUNTOF(seen_stack)) {
+		seen = seen_stack;
+		memset(seen, 0, sizeof(bool) * num_decoders);
+	} else {
+		seen = calloc(sizeof(bool), num_decoders);
+		if (seen == NULL) {
+			return -1;
+		}
 	}
 
 	for (i = 0; i < values->len;) {
@@ -360,10 +509,27 @@ spdk_json_decode_object(const struct spdk_json_val *values,
 		}
 	}
 
-	free(seen);
+	if (seen != seen_stack) {
+		free(seen);
+	}
 	return invalid ? -1 : 0;
 }
 
+int
+spdk_json_decode_object_arena(const struct spdk_json_val *values,
+			      const struct spdk_json_object_decoder *decoders, size_t num_decoders,
+			      void *out, struct spdk_json_arena *arena)
+{
+	struct spdk_json_arena *prev_arena = t_decode_arena;
+	int rc;
+
+	t_decode_arena = arena;
+	rc = spdk_json_decode_object(values, decoders, num_decoders, out);
+	t_decode_arena = prev_arena;
+
+	return rc;
+}
+
 int
 spdk_json_decode_array(const struct spdk_json_val *values, spdk_json_decode_fn decode_func,
 		       void *out, size_t max_size, size_t *out_size, size_t stride)
@@ -448,9 +614,13 @@ spdk_json_decode_string(const struct spdk_json_val *val, void *out)
 {
 	char **s = out;
 
-	free(*s);
-
-	*s = spdk_json_strdup(val);
+	if (t_decode_arena != NULL) {
+		/* The previous value, if any, belongs to the arena too */
+		*s = json_strdup_arena(val, t_decode_arena);
+	} else {
+		free(*s);
+		*s = spdk_json_strdup(val);
+	}
 
 	if (*s) {
 		return 0;
@@ -43,6 +43,8 @@
 #define SPDK_JSONRPC_RECV_BUF_SIZE	(32 * 1024)
 #define SPDK_JSONRPC_SEND_BUF_SIZE_INIT	(32 * 1024)
 #define SPDK_JSONRPC_SEND_BUF_SIZE_MAX	(32 * 1024 * 1024)
+/* Responses larger than this are sent while they are still being written */
+#define SPDK_JSONRPC_SEND_STREAM_SIZE	(256 * 1024)
 #define SPDK_JSONRPC_ID_MAX_LEN		128
 #define SPDK_JSONRPC_MAX_CONNS		64
 #define SPDK_JSONRPC_MAX_VALUES		1024
@@ -70,6 +72,15 @@ struct spdk_jsonrpc_request {
 
 	struct spdk_json_write_ctx *response;
 
+	/*
+	 * The response is queued for sending before it's complete. send_buf, send_len and
+	 * send_offset are then protected by the queue_lock of the connection.
+	 */
+	bool streaming;
+
+	/* The whole response is written, set only for streaming responses */
+	bool send_complete;
+
 	STAILQ_ENTRY(spdk_jsonrpc_request) link;
 };
 
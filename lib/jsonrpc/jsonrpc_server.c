@@ -108,11 +108,17 @@ invalid:
 }
 
 static int
-spdk_jsonrpc_server_write_cb(void *cb_ctx, const void *data, size_t size)
+spdk_jsonrpc_server_append(struct spdk_jsonrpc_request *request, const void *data, size_t size)
 {
-	struct spdk_jsonrpc_request *request = cb_ctx;
 	size_t new_size = request->send_buf_size;
 
+	if (request->send_offset > 0 &&
+	    request->send_buf_size - request->send_offset - request->send_len < size) {
+		/* Reuse the space of the part of a streaming response that has been sent */
+		memmove(request->send_buf, request->send_buf + request->send_offset, request->send_len);
+		request->send_offset = 0;
+	}
+
 	while (new_size - request->send_len < size) {
 		if (new_size >= SPDK_JSONRPC_SEND_BUF_SIZE_MAX) {
 			SPDK_ERRLOG("Send buf exceeded maximum size (%zu)\n",
@@ -137,12 +143,48 @@ spdk_jsonrpc_server_write_cb(void *cb_ctx, const void *data, size_t size)
 		request->send_buf_size = new_size;
 	}
 
-	memcpy(request->send_buf + request->send_len, data, size);
+	memcpy(request->send_buf + request->send_offset + request->send_len, data, size);
 	request->send_len += size;
 
 	return 0;
 }
 
+static bool
+spdk_jsonrpc_request_has_response(struct spdk_jsonrpc_request *request)
+{
+	/* If there was no ID in request we skip response. */
+	return request->id && request->id->type != SPDK_JSON_VAL_NULL;
+}
+
+static int
+spdk_jsonrpc_server_write_cb(void *cb_ctx, const void *data, size_t size)
+{
+	struct spdk_jsonrpc_request *request = cb_ctx;
+	struct spdk_jsonrpc_server_conn *conn = request->conn;
+	int rc = 0;
+
+	if (!request->streaming) {
+		rc = spdk_jsonrpc_server_append(request, data, size);
+		if (rc == 0 && request->send_len >= SPDK_JSONRPC_SEND_STREAM_SIZE &&
+		    spdk_jsonrpc_request_has_response(request)) {
+			/* Start sending the response before it is complete */
+			request->streaming = true;
+			spdk_jsonrpc_server_send_response(request);
+		}
+
+		return rc;
+	}
+
+	pthread_spin_lock(&conn->queue_lock);
+	/* Discard the rest of the response if the connection was closed */
+	if (conn->sockfd >= 0) {
+		rc = spdk_jsonrpc_server_append(request, data, size);
+	}
+	pthread_spin_unlock(&conn->queue_lock);
+
+	return rc;
+}
+
 int
 spdk_jsonrpc_parse_request(struct spdk_jsonrpc_server_conn *conn, const void *json, size_t size)
 {
@@ -219,7 +261,7 @@ spdk_jsonrpc_parse_request(struct spdk_jsonrpc_server_conn *conn, const void *js
 	}
 
 	/* Decode a second time now that there is a full JSON value available. */
-	rc = spdk_json_parse(request->recv_buffer, size, request->values, request->values_cnt, &end,
+	rc = spdk_json_parse(request->recv_buffer, len, request->values, request->values_cnt, &end,
 			     SPDK_JSON_PARSE_FLAG_DECODE_IN_PLACE);
 	if (rc < 0 || rc > SPDK_JSONRPC_MAX_VALUES) {
 		SPDK_DEBUGLOG(SPDK_LOG_RPC, "JSON parse error on second pass\n");
@@ -270,21 +312,31 @@ begin_response(struct spdk_jsonrpc_request *request)
 static void
 skip_response(struct spdk_jsonrpc_request *request)
 {
-	request->send_len = 0;
 	spdk_json_write_end(request->response);
 	request->response = NULL;
+	request->send_len = 0;
 	spdk_jsonrpc_server_send_response(request);
 }
 
 static void
 end_response(struct spdk_jsonrpc_request *request)
 {
+	struct spdk_jsonrpc_server_conn *conn = request->conn;
+
 	spdk_json_write_object_end(request->response);
 	spdk_json_write_end(request->response);
 	request->response = NULL;
 
 	spdk_jsonrpc_server_write_cb(request, "\n", 1);
-	spdk_jsonrpc_server_send_response(request);
+
+	if (request->streaming) {
+		/* The request is already queued - just let the sender free it once it's sent */
+		pthread_spin_lock(&conn->queue_lock);
+		request->send_complete = true;
+		pthread_spin_unlock(&conn->queue_lock);
+	} else {
+		spdk_jsonrpc_server_send_response(request);
+	}
 }
 
 void
@@ -319,14 +371,30 @@ spdk_jsonrpc_end_result(struct spdk_jsonrpc_request *request, struct spdk_json_w
 	assert(w != NULL);
 	assert(w == request->response);
 
-	/* If there was no ID in request we skip response. */
-	if (request->id && request->id->type != SPDK_JSON_VAL_NULL) {
+	if (spdk_jsonrpc_request_has_response(request)) {
 		end_response(request);
 	} else {
 		skip_response(request);
 	}
 }
 
+size_t
+spdk_jsonrpc_get_unsent_len(struct spdk_jsonrpc_request *request)
+{
+	struct spdk_jsonrpc_server_conn *conn = request->conn;
+	size_t len;
+
+	if (!request->streaming) {
+		return request->send_len;
+	}
+
+	pthread_spin_lock(&conn->queue_lock);
+	len = request->send_len;
+	pthread_spin_unlock(&conn->queue_lock);
+
+	return len;
+}
+
 void
 spdk_jsonrpc_send_error_response(struct spdk_jsonrpc_request *request,
 				 int error_code, const char *msg)
@@ -115,11 +115,30 @@ spdk_jsonrpc_server_dequeue_request(struct spdk_jsonrpc_server_conn *conn)
 static void
 spdk_jsonrpc_server_free_conn_request(struct spdk_jsonrpc_server_conn *conn)
 {
-	struct spdk_jsonrpc_request *request;
+	STAILQ_HEAD(, spdk_jsonrpc_request) free_queue = STAILQ_HEAD_INITIALIZER(free_queue);
+	struct spdk_jsonrpc_request *request, *tmp;
+
+	pthread_spin_lock(&conn->queue_lock);
+	if (conn->send_request != NULL) {
+		STAILQ_INSERT_HEAD(&conn->send_queue, conn->send_request, link);
+		conn->send_request = NULL;
+	}
+
+	STAILQ_FOREACH_SAFE(request, &conn->send_queue, link, tmp) {
+		if (request->streaming && !request->send_complete) {
+			/* The response is still being written, it will be freed once it's complete */
+			request->send_offset = 0;
+			request->send_len = 0;
+			continue;
+		}
+
+		STAILQ_REMOVE(&conn->send_queue, request, spdk_jsonrpc_request, link);
+		STAILQ_INSERT_TAIL(&free_queue, request, link);
+	}
+	pthread_spin_unlock(&conn->queue_lock);
 
-	spdk_jsonrpc_free_request(conn->send_request);
-	conn->send_request = NULL ;
-	while ((request = spdk_jsonrpc_server_dequeue_request(conn)) != NULL) {
+	while ((request = STAILQ_FIRST(&free_queue)) != NULL) {
+		STAILQ_REMOVE_HEAD(&free_queue, link);
 		spdk_jsonrpc_free_request(request);
 	}
 }
@@ -130,9 +149,11 @@ spdk_jsonrpc_server_conn_close(struct spdk_jsonrpc_server_conn *conn)
 	conn->closed = true;
 
 	if (conn->sockfd >= 0) {
-		spdk_jsonrpc_server_free_conn_request(conn);
 		close(conn->sockfd);
+		pthread_spin_lock(&conn->queue_lock);
 		conn->sockfd = -1;
+		pthread_spin_unlock(&conn->queue_lock);
+		spdk_jsonrpc_server_free_conn_request(conn);
 
 		if (conn->close_cb) {
 			conn->close_cb(conn, conn->close_cb_ctx);
@@ -364,10 +385,19 @@ more:
 		return 0;
 	}
 
+	/* A streaming response is written to send_buf while it's being sent */
+	if (request->streaming) {
+		pthread_spin_lock(&conn->queue_lock);
+	}
+
 	if (request->send_len > 0) {
 		rc = send(conn->sockfd, request->send_buf + request->send_offset,
 			  request->send_len, 0);
 		if (rc < 0) {
+			if (request->streaming) {
+				pthread_spin_unlock(&conn->queue_lock);
+			}
+
 			if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
 				return 0;
 			}
@@ -380,6 +410,16 @@ more:
 		request->send_len -= rc;
 	}
 
+	if (request->streaming) {
+		if (request->send_len == 0 && !request->send_complete) {
+			/* Everything written so far has been sent, wait for the rest of the response */
+			request->send_offset = 0;
+			pthread_spin_unlock(&conn->queue_lock);
+			return 0;
+		}
+		pthread_spin_unlock(&conn->queue_lock);
+	}
+
 	if (request->send_len == 0) {
 		/*
 		 * Full response has been sent.
@@ -405,6 +445,11 @@ spdk_jsonrpc_server_poll(struct spdk_jsonrpc_server *server)
 			spdk_jsonrpc_server_conn_close(conn);
 		}
 
+		/* Free the responses completed after the connection was closed */
+		if (conn->sockfd == -1 && conn->outstanding_requests != 0) {
+			spdk_jsonrpc_server_free_conn_request(conn);
+		}
+
 		if (conn->sockfd == -1 && conn->outstanding_requests == 0) {
 			spdk_jsonrpc_server_conn_remove(conn);
 		}
@@ -52,6 +52,14 @@
 #define GET_IO_LOOP_COUNT		16
 #define NBD_BUSY_WAITING_MS		1000
 #define NBD_BUSY_POLLING_INTERVAL_US	20000
+/* Size of the per connection buffer that nbd request headers are read into */
+#define NBD_RECV_BUF_SIZE		4096
+/* Maximum number of io vectors transmitted with a single writev() */
+#define NBD_XMIT_IOV_MAX		64
+
+#ifndef NBD_FLAG_CAN_MULTI_CONN
+#define NBD_FLAG_CAN_MULTI_CONN		(1 << 8)
+#endif
 
 enum nbd_io_state_t {
 	/* Receiving or ready to receive nbd request header */
@@ -65,7 +73,7 @@ enum nbd_io_state_t {
 };
 
 struct nbd_io {
-	struct spdk_nbd_disk	*nbd;
+	struct nbd_conn		*conn;
 	enum nbd_io_state_t	state;
 
 	void			*payload;
@@ -94,25 +102,49 @@ enum nbd_disk_state_t {
 	NBD_DISK_STATE_HARDDISC,
 };
 
-struct spdk_nbd_disk {
-	struct spdk_bdev	*bdev;
-	struct spdk_bdev_desc	*bdev_desc;
+/*
+ * One socket connection between the kernel and the nbd disk.
+ * Everything below is accessed only from the connection thread.
+ */
+struct nbd_conn {
+	struct spdk_nbd_disk	*nbd;
+	struct spdk_thread	*thread;
 	struct spdk_io_channel	*ch;
-	int			dev_fd;
-	char			*nbd_path;
 	int			kernel_sp_fd;
 	int			spdk_sp_fd;
-	struct spdk_poller	*nbd_poller;
-	uint32_t		buf_align;
+	struct spdk_poller	*poller;
 
 	struct nbd_io		*io_in_recv;
 	TAILQ_HEAD(, nbd_io)	received_io_list;
 	TAILQ_HEAD(, nbd_io)	executed_io_list;
 
 	enum nbd_disk_state_t	state;
-	/* count of nbd_io in spdk_nbd_disk */
+	/* count of nbd_io in nbd_conn */
 	int			io_count;
 
+	/* Data read from the socket and not consumed yet */
+	uint32_t		recv_off;
+	uint32_t		recv_len;
+	uint8_t			recv_buf[NBD_RECV_BUF_SIZE];
+};
+
+struct spdk_nbd_disk {
+	struct spdk_bdev	*bdev;
+	struct spdk_bdev_desc	*bdev_desc;
+	int			dev_fd;
+	char			*nbd_path;
+	uint32_t		buf_align;
+
+	/* Thread the disk was started on. It owns bdev_desc and the conns array. */
+	struct spdk_thread	*thread;
+	struct nbd_conn		*conns;
+	uint32_t		num_conns;
+	/* count of conns started and not yet stopped */
+	uint32_t		num_conns_running;
+	/* count of conns disconnected by the kernel */
+	uint32_t		num_conns_disconnected;
+	bool			stopping;
+
 	TAILQ_ENTRY(spdk_nbd_disk)	tailq;
 };
 
@@ -123,7 +155,7 @@ struct spdk_nbd_disk_globals {
 static struct spdk_nbd_disk_globals g_spdk_nbd;
 
 static int
-nbd_submit_bdev_io(struct spdk_nbd_disk *nbd, struct nbd_io *io);
+nbd_submit_bdev_io(struct nbd_conn *conn, struct nbd_io *io);
 
 int
 spdk_nbd_init(void)
@@ -218,6 +250,12 @@ spdk_nbd_disk_get_bdev_name(struct spdk_nbd_disk *nbd)
 	return spdk_bdev_get_name(nbd->bdev);
 }
 
+uint32_t
+spdk_nbd_disk_get_num_connections(struct spdk_nbd_disk *nbd)
+{
+	return nbd->num_conns;
+}
+
 void
 spdk_nbd_write_config_json(struct spdk_json_write_ctx *w)
 {
@@ -233,6 +271,9 @@ spdk_nbd_write_config_json(struct spdk_json_write_ctx *w)
 		spdk_json_write_named_object_begin(w, "params");
 		spdk_json_write_named_string(w, "nbd_device",  spdk_nbd_disk_get_nbd_path(nbd));
 		spdk_json_write_named_string(w, "bdev_name", spdk_nbd_disk_get_bdev_name(nbd));
+		if (nbd->num_conns > 1) {
+			spdk_json_write_named_uint32(w, "num_connections", nbd->num_conns);
+		}
 		spdk_json_write_object_end(w);
 
 		spdk_json_write_object_end(w);
@@ -253,7 +294,7 @@ nbd_disconnect(struct spdk_nbd_disk *nbd)
 }
 
 static struct nbd_io *
-spdk_get_nbd_io(struct spdk_nbd_disk *nbd)
+spdk_get_nbd_io(struct nbd_conn *conn)
 {
 	struct nbd_io *io;
 
@@ -262,23 +303,23 @@ spdk_get_nbd_io(struct spdk_nbd_disk *nbd)
 		return NULL;
 	}
 
-	io->nbd = nbd;
+	io->conn = conn;
 	to_be32(&io->resp.magic, NBD_REPLY_MAGIC);
 
-	nbd->io_count++;
+	conn->io_count++;
 
 	return io;
 }
 
 static void
-spdk_put_nbd_io(struct spdk_nbd_disk *nbd, struct nbd_io *io)
+spdk_put_nbd_io(struct nbd_conn *conn, struct nbd_io *io)
 {
 	if (io->payload) {
 		spdk_free(io->payload);
 	}
 	free(io);
 
-	nbd->io_count--;
+	conn->io_count--;
 }
 
 /*
@@ -288,11 +329,11 @@ spdk_put_nbd_io(struct spdk_nbd_disk *nbd, struct nbd_io *io)
  *         0 all nbd_io received are transmitted.
  */
 static int
-spdk_nbd_io_xmit_check(struct spdk_nbd_disk *nbd)
+spdk_nbd_io_xmit_check(struct nbd_conn *conn)
 {
-	if (nbd->io_count == 0) {
+	if (conn->io_count == 0) {
 		return 0;
-	} else if (nbd->io_count == 1 && nbd->io_in_recv != NULL) {
+	} else if (conn->io_count == 1 && conn->io_in_recv != NULL) {
 		return 0;
 	}
 
@@ -307,29 +348,29 @@ spdk_nbd_io_xmit_check(struct spdk_nbd_disk *nbd)
  *         0 all nbd_io gotten are freed.
  */
 static int
-spdk_nbd_cleanup_io(struct spdk_nbd_disk *nbd)
+spdk_nbd_cleanup_io(struct nbd_conn *conn)
 {
 	struct nbd_io *io, *io_tmp;
 
 	/* free io_in_recv */
-	if (nbd->io_in_recv != NULL) {
-		spdk_put_nbd_io(nbd, nbd->io_in_recv);
-		nbd->io_in_recv = NULL;
+	if (conn->io_in_recv != NULL) {
+		spdk_put_nbd_io(conn, conn->io_in_recv);
+		conn->io_in_recv = NULL;
 	}
 
 	/* free io in received_io_list */
-	if (!TAILQ_EMPTY(&nbd->received_io_list)) {
-		TAILQ_FOREACH_SAFE(io, &nbd->received_io_list, tailq, io_tmp) {
-			TAILQ_REMOVE(&nbd->received_io_list, io, tailq);
-			spdk_put_nbd_io(nbd, io);
+	if (!TAILQ_EMPTY(&conn->received_io_list)) {
+		TAILQ_FOREACH_SAFE(io, &conn->received_io_list, tailq, io_tmp) {
+			TAILQ_REMOVE(&conn->received_io_list, io, tailq);
+			spdk_put_nbd_io(conn, io);
 		}
 	}
 
 	/* free io in executed_io_list */
-	if (!TAILQ_EMPTY(&nbd->executed_io_list)) {
-		TAILQ_FOREACH_SAFE(io, &nbd->executed_io_list, tailq, io_tmp) {
-			TAILQ_REMOVE(&nbd->executed_io_list, io, tailq);
-			spdk_put_nbd_io(nbd, io);
+	if (!TAILQ_EMPTY(&conn->executed_io_list)) {
+		TAILQ_FOREACH_SAFE(io, &conn->executed_io_list, tailq, io_tmp) {
+			TAILQ_REMOVE(&conn->executed_io_list, io, tailq);
+			spdk_put_nbd_io(conn, io);
 		}
 	}
 
@@ -337,7 +378,7 @@ spdk_nbd_cleanup_io(struct spdk_nbd_disk *nbd)
 	 * Some nbd_io may be under executing in bdev.
 	 * Wait for their done operation.
 	 */
-	if (nbd->io_count != 0) {
+	if (conn->io_count != 0) {
 		return 1;
 	}
 
@@ -347,20 +388,22 @@ spdk_nbd_cleanup_io(struct spdk_nbd_disk *nbd)
 static void
 _nbd_stop(struct spdk_nbd_disk *nbd)
 {
-	if (nbd->ch) {
-		spdk_put_io_channel(nbd->ch);
-	}
+	uint32_t i;
+
+	assert(nbd->num_conns_running == 0);
 
 	if (nbd->bdev_desc) {
 		spdk_bdev_close(nbd->bdev_desc);
 	}
 
-	if (nbd->spdk_sp_fd >= 0) {
-		close(nbd->spdk_sp_fd);
-	}
+	for (i = 0; i < nbd->num_conns; i++) {
+		if (nbd->conns[i].spdk_sp_fd >= 0) {
+			close(nbd->conns[i].spdk_sp_fd);
+		}
 
-	if (nbd->kernel_sp_fd >= 0) {
-		close(nbd->kernel_sp_fd);
+		if (nbd->conns[i].kernel_sp_fd >= 0) {
+			close(nbd->conns[i].kernel_sp_fd);
+		}
 	}
 
 	if (nbd->dev_fd >= 0) {
@@ -376,29 +419,139 @@ _nbd_stop(struct spdk_nbd_disk *nbd)
 		free(nbd->nbd_path);
 	}
 
-	if (nbd->nbd_poller) {
-		spdk_poller_unregister(&nbd->nbd_poller);
-	}
-
 	spdk_nbd_disk_unregister(nbd);
 
+	free(nbd->conns);
 	free(nbd);
 }
 
-void
-spdk_nbd_stop(struct spdk_nbd_disk *nbd)
+/* Called on the disk thread each time one of its conns has stopped */
+static void
+_nbd_conn_stopped(void *arg)
 {
-	if (nbd == NULL) {
+	struct spdk_nbd_disk *nbd = arg;
+
+	assert(nbd->num_conns_running > 0);
+	if (--nbd->num_conns_running == 0) {
+		_nbd_stop(nbd);
+	}
+}
+
+static void
+nbd_conn_thread_exit(void *arg)
+{
+	int rc __attribute__((unused));
+
+	rc = spdk_thread_exit(spdk_get_thread());
+	assert(rc == 0);
+}
+
+static void
+nbd_conn_stopped(struct nbd_conn *conn)
+{
+	struct spdk_nbd_disk *nbd = conn->nbd;
+	struct spdk_thread *thread = conn->thread;
+
+	if (conn->ch) {
+		spdk_put_io_channel(conn->ch);
+		conn->ch = NULL;
+	}
+
+	if (thread == nbd->thread) {
+		_nbd_conn_stopped(nbd);
 		return;
 	}
 
-	nbd->state = NBD_DISK_STATE_HARDDISC;
+	/* Exit only after the io channel has been released */
+	spdk_thread_send_msg(thread, nbd_conn_thread_exit, NULL);
+	/* conn may be freed by the disk thread from now on */
+	spdk_thread_send_msg(nbd->thread, _nbd_conn_stopped, nbd);
+}
+
+static void
+_nbd_conn_stop(void *arg)
+{
+	struct nbd_conn *conn = arg;
+
+	conn->state = NBD_DISK_STATE_HARDDISC;
+	spdk_poller_unregister(&conn->poller);
 
 	/*
 	 * Stop action should be called only after all nbd_io are executed.
 	 */
-	if (!spdk_nbd_cleanup_io(nbd)) {
+	if (!spdk_nbd_cleanup_io(conn)) {
+		nbd_conn_stopped(conn);
+	}
+}
+
+void
+spdk_nbd_stop(struct spdk_nbd_disk *nbd)
+{
+	struct nbd_conn *conn;
+	uint32_t i, num_conns_running;
+
+	if (nbd == NULL || nbd->stopping) {
+		return;
+	}
+
+	nbd->stopping = true;
+
+	if (nbd->num_conns_running == 0) {
 		_nbd_stop(nbd);
+		return;
+	}
+
+	/*
+	 * Conns are started in order, so the first num_conns_running ones are
+	 * started. Hold an extra reference, as the conn running on this thread
+	 * may stop synchronously.
+	 */
+	num_conns_running = nbd->num_conns_running++;
+	for (i = 0; i < num_conns_running; i++) {
+		conn = &nbd->conns[i];
+		if (conn->thread == nbd->thread) {
+			_nbd_conn_stop(conn);
+		} else {
+			spdk_thread_send_msg(conn->thread, _nbd_conn_stop, conn);
+		}
+	}
+
+	_nbd_conn_stopped(nbd);
+}
+
+static void
+_nbd_conn_error(void *arg)
+{
+	spdk_nbd_stop(arg);
+}
+
+static void
+_nbd_conn_disconnected(void *arg)
+{
+	struct spdk_nbd_disk *nbd = arg;
+
+	/* The kernel sends NBD_CMD_DISC on each conn, stop once all of them are done */
+	if (++nbd->num_conns_disconnected == nbd->num_conns) {
+		spdk_nbd_stop(nbd);
+	}
+}
+
+/* Called on the conn thread when the conn cannot continue */
+static void
+nbd_conn_done(struct nbd_conn *conn, spdk_msg_fn fn)
+{
+	struct spdk_nbd_disk *nbd = conn->nbd;
+
+	spdk_poller_unregister(&conn->poller);
+
+	if (conn->thread == nbd->thread) {
+		fn(nbd);
+	} else {
+		/*
+		 * The disk is freed only after this conn reports it has stopped,
+		 * which happens after this message is delivered.
+		 */
+		spdk_thread_send_msg(nbd->thread, fn, nbd);
 	}
 }
 
@@ -421,11 +574,11 @@ read_from_socket(int fd, void *buf, size_t length)
 }
 
 static int64_t
-write_to_socket(int fd, void *buf, size_t length)
+writev_to_socket(int fd, struct iovec *iov, int iovcnt)
 {
 	ssize_t bytes_written;
 
-	bytes_written = write(fd, buf, length);
+	bytes_written = writev(fd, iov, iovcnt);
 	if (bytes_written == 0) {
 		return -EIO;
 	} else if (bytes_written == -1) {
@@ -438,11 +591,44 @@ write_to_socket(int fd, void *buf, size_t length)
 	}
 }
 
+/*
+ * Read from the conn socket. Short reads, i.e. request headers, are served
+ * from recv_buf, which is refilled with a single read(), so that all the
+ * request headers queued by the kernel are received with one system call.
+ */
+static int64_t
+nbd_conn_read(struct nbd_conn *conn, void *buf, size_t length)
+{
+	int64_t ret;
+	size_t len;
+
+	if (conn->recv_len == 0) {
+		if (length >= sizeof(conn->recv_buf)) {
+			return read_from_socket(conn->spdk_sp_fd, buf, length);
+		}
+
+		ret = read_from_socket(conn->spdk_sp_fd, conn->recv_buf, sizeof(conn->recv_buf));
+		if (ret <= 0) {
+			return ret;
+		}
+
+		conn->recv_off = 0;
+		conn->recv_len = ret;
+	}
+
+	len = spdk_min(length, conn->recv_len);
+	memcpy(buf, conn->recv_buf + conn->recv_off, len);
+	conn->recv_off += len;
+	conn->recv_len -= len;
+
+	return len;
+}
+
 static void
 nbd_io_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 {
 	struct nbd_io	*io = cb_arg;
-	struct spdk_nbd_disk *nbd = io->nbd;
+	struct nbd_conn *conn = io->conn;
 
 	if (success) {
 		io->resp.error = 0;
@@ -451,14 +637,14 @@ nbd_io_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 	}
 
 	memcpy(&io->resp.handle, &io->req.handle, sizeof(io->resp.handle));
-	TAILQ_INSERT_TAIL(&nbd->executed_io_list, io, tailq);
+	TAILQ_INSERT_TAIL(&conn->executed_io_list, io, tailq);
 
 	if (bdev_io != NULL) {
 		spdk_bdev_free_io(bdev_io);
 	}
 
-	if (nbd->state == NBD_DISK_STATE_HARDDISC && !spdk_nbd_cleanup_io(nbd)) {
-		_nbd_stop(nbd);
+	if (conn->state == NBD_DISK_STATE_HARDDISC && !spdk_nbd_cleanup_io(conn)) {
+		nbd_conn_stopped(conn);
 	}
 }
 
@@ -466,13 +652,13 @@ static void
 nbd_resubmit_io(void *arg)
 {
 	struct nbd_io *io = (struct nbd_io *)arg;
-	struct spdk_nbd_disk *nbd = io->nbd;
+	struct nbd_conn *conn = io->conn;
 	int rc = 0;
 
-	rc = nbd_submit_bdev_io(nbd, io);
+	rc = nbd_submit_bdev_io(conn, io);
 	if (rc) {
 		SPDK_INFOLOG(SPDK_LOG_NBD, "nbd: io resubmit for dev %s , io_type %d, returned %d.\n",
-			     spdk_nbd_disk_get_bdev_name(nbd), from_be32(&io->req.type), rc);
+			     spdk_nbd_disk_get_bdev_name(conn->nbd), from_be32(&io->req.type), rc);
 	}
 }
 
@@ -480,13 +666,13 @@ static void
 nbd_queue_io(struct nbd_io *io)
 {
 	int rc;
-	struct spdk_bdev *bdev = io->nbd->bdev;
+	struct spdk_bdev *bdev = io->conn->nbd->bdev;
 
 	io->bdev_io_wait.bdev = bdev;
 	io->bdev_io_wait.cb_fn = nbd_resubmit_io;
 	io->bdev_io_wait.cb_arg = io;
 
-	rc = spdk_bdev_queue_io_wait(bdev, io->nbd->ch, &io->bdev_io_wait);
+	rc = spdk_bdev_queue_io_wait(bdev, io->conn->ch, &io->bdev_io_wait);
 	if (rc != 0) {
 		SPDK_ERRLOG("Queue io failed in nbd_queue_io, rc=%d.\n", rc);
 		nbd_io_done(NULL, false, io);
@@ -494,10 +680,11 @@ nbd_queue_io(struct nbd_io *io)
 }
 
 static int
-nbd_submit_bdev_io(struct spdk_nbd_disk *nbd, struct nbd_io *io)
+nbd_submit_bdev_io(struct nbd_conn *conn, struct nbd_io *io)
 {
+	struct spdk_nbd_disk *nbd = conn->nbd;
 	struct spdk_bdev_desc *desc = nbd->bdev_desc;
-	struct spdk_io_channel *ch = nbd->ch;
+	struct spdk_io_channel *ch = conn->ch;
 	int rc = 0;
 
 	switch (from_be32(&io->req.type)) {
@@ -523,8 +710,8 @@ nbd_submit_bdev_io(struct spdk_nbd_disk *nbd, struct nbd_io *io)
 		break;
 #endif
 	case NBD_CMD_DISC:
-		spdk_put_nbd_io(nbd, io);
-		nbd->state = NBD_DISK_STATE_SOFTDISC;
+		spdk_put_nbd_io(conn, io);
+		conn->state = NBD_DISK_STATE_SOFTDISC;
 		break;
 	default:
 		rc = -1;
@@ -544,7 +731,7 @@ nbd_submit_bdev_io(struct spdk_nbd_disk *nbd, struct nbd_io *io)
 }
 
 static int
-spdk_nbd_io_exec(struct spdk_nbd_disk *nbd)
+spdk_nbd_io_exec(struct nbd_conn *conn)
 {
 	struct nbd_io *io, *io_tmp;
 	int ret = 0;
@@ -553,14 +740,14 @@ spdk_nbd_io_exec(struct spdk_nbd_disk *nbd)
 	 * For soft disconnection, nbd server must handle all outstanding
 	 * request before closing connection.
 	 */
-	if (nbd->state == NBD_DISK_STATE_HARDDISC) {
+	if (conn->state == NBD_DISK_STATE_HARDDISC) {
 		return 0;
 	}
 
-	if (!TAILQ_EMPTY(&nbd->received_io_list)) {
-		TAILQ_FOREACH_SAFE(io, &nbd->received_io_list, tailq, io_tmp) {
-			TAILQ_REMOVE(&nbd->received_io_list, io, tailq);
-			ret = nbd_submit_bdev_io(nbd, io);
+	if (!TAILQ_EMPTY(&conn->received_io_list)) {
+		TAILQ_FOREACH_SAFE(io, &conn->received_io_list, tailq, io_tmp) {
+			TAILQ_REMOVE(&conn->received_io_list, io, tailq);
+			ret = nbd_submit_bdev_io(conn, io);
 			if (ret < 0) {
 				break;
 			}
@@ -570,27 +757,34 @@ spdk_nbd_io_exec(struct spdk_nbd_disk *nbd)
 	return ret;
 }
 
-static int
-spdk_nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
+/*
+ * Receive a single nbd request.
+ *
+ * \return number of bytes received by the last read, 0 if the socket
+ *         is drained or negated errno on error.
+ */
+static int64_t
+spdk_nbd_io_recv_internal(struct nbd_conn *conn)
 {
+	struct spdk_nbd_disk *nbd = conn->nbd;
 	struct nbd_io *io;
-	int ret = 0;
+	int64_t ret = 0;
 
-	if (nbd->io_in_recv == NULL) {
-		nbd->io_in_recv = spdk_get_nbd_io(nbd);
-		if (!nbd->io_in_recv) {
+	if (conn->io_in_recv == NULL) {
+		conn->io_in_recv = spdk_get_nbd_io(conn);
+		if (!conn->io_in_recv) {
 			return -ENOMEM;
 		}
 	}
 
-	io = nbd->io_in_recv;
+	io = conn->io_in_recv;
 
 	if (io->state == NBD_IO_RECV_REQ) {
-		ret = read_from_socket(nbd->spdk_sp_fd, (char *)&io->req + io->offset,
-				       sizeof(io->req) - io->offset);
+		ret = nbd_conn_read(conn, (char *)&io->req + io->offset,
+				    sizeof(io->req) - io->offset);
 		if (ret < 0) {
-			spdk_put_nbd_io(nbd, io);
-			nbd->io_in_recv = NULL;
+			spdk_put_nbd_io(conn, io);
+			conn->io_in_recv = NULL;
 			return ret;
 		}
 
@@ -603,8 +797,8 @@ spdk_nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 			/* req magic check */
 			if (from_be32(&io->req.magic) != NBD_REQUEST_MAGIC) {
 				SPDK_ERRLOG("invalid request magic\n");
-				spdk_put_nbd_io(nbd, io);
-				nbd->io_in_recv = NULL;
+				spdk_put_nbd_io(conn, io);
+				conn->io_in_recv = NULL;
 				return -EINVAL;
 			}
 
@@ -622,8 +816,8 @@ spdk_nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 							  SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
 				if (io->payload == NULL) {
 					SPDK_ERRLOG("could not allocate io->payload of size %d\n", io->payload_size);
-					spdk_put_nbd_io(nbd, io);
-					nbd->io_in_recv = NULL;
+					spdk_put_nbd_io(conn, io);
+					conn->io_in_recv = NULL;
 					return -ENOMEM;
 				}
 			} else {
@@ -635,17 +829,17 @@ spdk_nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 				io->state = NBD_IO_RECV_PAYLOAD;
 			} else {
 				io->state = NBD_IO_XMIT_RESP;
-				nbd->io_in_recv = NULL;
-				TAILQ_INSERT_TAIL(&nbd->received_io_list, io, tailq);
+				conn->io_in_recv = NULL;
+				TAILQ_INSERT_TAIL(&conn->received_io_list, io, tailq);
 			}
 		}
 	}
 
 	if (io->state == NBD_IO_RECV_PAYLOAD) {
-		ret = read_from_socket(nbd->spdk_sp_fd, io->payload + io->offset, io->payload_size - io->offset);
+		ret = nbd_conn_read(conn, io->payload + io->offset, io->payload_size - io->offset);
 		if (ret < 0) {
-			spdk_put_nbd_io(nbd, io);
-			nbd->io_in_recv = NULL;
+			spdk_put_nbd_io(conn, io);
+			conn->io_in_recv = NULL;
 			return ret;
 		}
 
@@ -655,102 +849,141 @@ spdk_nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 		if (io->offset == io->payload_size) {
 			io->offset = 0;
 			io->state = NBD_IO_XMIT_RESP;
-			nbd->io_in_recv = NULL;
-			TAILQ_INSERT_TAIL(&nbd->received_io_list, io, tailq);
+			conn->io_in_recv = NULL;
+			TAILQ_INSERT_TAIL(&conn->received_io_list, io, tailq);
 		}
 
 	}
 
-	return 0;
+	return ret;
 }
 
 static int
-spdk_nbd_io_recv(struct spdk_nbd_disk *nbd)
+spdk_nbd_io_recv(struct nbd_conn *conn)
 {
-	int i, ret = 0;
+	int i;
+	int64_t ret = 0;
 
 	/*
 	 * nbd server should not accept request in both soft and hard
 	 * disconnect states.
 	 */
-	if (nbd->state != NBD_DISK_STATE_RUNNING) {
+	if (conn->state != NBD_DISK_STATE_RUNNING) {
 		return 0;
 	}
 
 	for (i = 0; i < GET_IO_LOOP_COUNT; i++) {
-		ret = spdk_nbd_io_recv_internal(nbd);
-		if (ret != 0) {
+		ret = spdk_nbd_io_recv_internal(conn);
+		if (ret < 0) {
 			return ret;
+		} else if (ret == 0) {
+			/* socket is drained */
+			break;
 		}
 	}
 
 	return 0;
 }
 
+static bool
+nbd_io_has_xmit_payload(struct nbd_io *io)
+{
+	/* transmit payload only when NBD_CMD_READ with no resp error */
+	return from_be32(&io->req.type) == NBD_CMD_READ && io->resp.error == 0 &&
+	       io->payload_size != 0;
+}
+
+/*
+ * Transmit responses and read payloads of as many executed nbd_io
+ * as fit in a single writev().
+ *
+ * \return 1 if everything gathered was transmitted, 0 if the socket is full
+ *         or negated errno on error.
+ */
 static int
-spdk_nbd_io_xmit_internal(struct spdk_nbd_disk *nbd)
+spdk_nbd_io_xmit_internal(struct nbd_conn *conn)
 {
-	struct nbd_io *io;
-	int ret = 0;
+	struct iovec iov[NBD_XMIT_IOV_MAX];
+	struct nbd_io *io, *io_tmp;
+	int iovcnt = 0;
+	uint64_t total = 0;
+	int64_t ret, left;
+	size_t len;
 
-	io = TAILQ_FIRST(&nbd->executed_io_list);
-	if (io == NULL) {
-		return 0;
-	}
+	/* resp error and handler are already set in io_done */
+	TAILQ_FOREACH(io, &conn->executed_io_list, tailq) {
+		if (iovcnt + 2 > NBD_XMIT_IOV_MAX) {
+			break;
+		}
 
-	/* Remove IO from list now assuming it will be completed.  It will be inserted
-	 *  back to the head if it cannot be completed.  This approach is specifically
-	 *  taken to work around a scan-build use-after-free mischaracterization.
-	 */
-	TAILQ_REMOVE(&nbd->executed_io_list, io, tailq);
+		if (io->state == NBD_IO_XMIT_RESP) {
+			iov[iovcnt].iov_base = (char *)&io->resp + io->offset;
+			iov[iovcnt].iov_len = sizeof(io->resp) - io->offset;
+			total += iov[iovcnt++].iov_len;
 
-	/* resp error and handler are already set in io_done */
+			if (!nbd_io_has_xmit_payload(io)) {
+				continue;
+			}
 
-	if (io->state == NBD_IO_XMIT_RESP) {
-		ret = write_to_socket(nbd->spdk_sp_fd, (char *)&io->resp + io->offset,
-				      sizeof(io->resp) - io->offset);
-		if (ret <= 0) {
-			goto reinsert;
+			iov[iovcnt].iov_base = io->payload;
+			iov[iovcnt].iov_len = io->payload_size;
+		} else {
+			iov[iovcnt].iov_base = io->payload + io->offset;
+			iov[iovcnt].iov_len = io->payload_size - io->offset;
 		}
+		total += iov[iovcnt++].iov_len;
+	}
 
-		io->offset += ret;
+	if (iovcnt == 0) {
+		return 0;
+	}
 
-		/* response is fully transmitted */
-		if (io->offset == sizeof(io->resp)) {
-			io->offset = 0;
+	ret = writev_to_socket(conn->spdk_sp_fd, iov, iovcnt);
+	if (ret <= 0) {
+		return ret;
+	}
 
-			/* transmit payload only when NBD_CMD_READ with no resp error */
-			if (from_be32(&io->req.type) != NBD_CMD_READ || io->resp.error != 0) {
-				spdk_put_nbd_io(nbd, io);
-				return 0;
-			} else {
-				io->state = NBD_IO_XMIT_PAYLOAD;
+	/* Advance nbd_io by the number of bytes written and put the ones fully transmitted */
+	left = ret;
+	TAILQ_FOREACH_SAFE(io, &conn->executed_io_list, tailq, io_tmp) {
+		if (io->state == NBD_IO_XMIT_RESP) {
+			len = spdk_min((size_t)left, sizeof(io->resp) - io->offset);
+			io->offset += len;
+			left -= len;
+
+			/* response is partially transmitted */
+			if (io->offset != sizeof(io->resp)) {
+				break;
 			}
-		}
-	}
 
-	if (io->state == NBD_IO_XMIT_PAYLOAD) {
-		ret = write_to_socket(nbd->spdk_sp_fd, io->payload + io->offset, io->payload_size - io->offset);
-		if (ret <= 0) {
-			goto reinsert;
+			io->offset = 0;
+			if (!nbd_io_has_xmit_payload(io)) {
+				TAILQ_REMOVE(&conn->executed_io_list, io, tailq);
+				spdk_put_nbd_io(conn, io);
+				continue;
+			}
+
+			io->state = NBD_IO_XMIT_PAYLOAD;
 		}
 
-		io->offset += ret;
+		len = spdk_min((size_t)left, io->payload_size - io->offset);
+		io->offset += len;
+		left -= len;
 
-		/* read payload is fully transmitted */
-		if (io->offset == io->payload_size) {
-			spdk_put_nbd_io(nbd, io);
-			return 0;
+		/* read payload is partially transmitted */
+		if (io->offset != io->payload_size) {
+			break;
 		}
+
+		TAILQ_REMOVE(&conn->executed_io_list, io, tailq);
+		spdk_put_nbd_io(conn, io);
 	}
 
-reinsert:
-	TAILQ_INSERT_HEAD(&nbd->executed_io_list, io, tailq);
-	return ret;
+	return (uint64_t)ret == total ? 1 : 0;
 }
 
 static int
-spdk_nbd_io_xmit(struct spdk_nbd_disk *nbd)
+spdk_nbd_io_xmit(struct nbd_conn *conn)
 {
 	int ret = 0;
 
@@ -758,14 +991,17 @@ spdk_nbd_io_xmit(struct spdk_nbd_disk *nbd)
 	 * For soft disconnection, nbd server must handle all outstanding
 	 * request before closing connection.
 	 */
-	if (nbd->state == NBD_DISK_STATE_HARDDISC) {
+	if (conn->state == NBD_DISK_STATE_HARDDISC) {
 		return 0;
 	}
 
-	while (!TAILQ_EMPTY(&nbd->executed_io_list)) {
-		ret = spdk_nbd_io_xmit_internal(nbd);
-		if (ret != 0) {
+	while (!TAILQ_EMPTY(&conn->executed_io_list)) {
+		ret = spdk_nbd_io_xmit_internal(conn);
+		if (ret < 0) {
 			return ret;
+		} else if (ret == 0) {
+			/* socket is full, continue on next poll */
+			break;
 		}
 	}
 
@@ -773,7 +1009,7 @@ spdk_nbd_io_xmit(struct spdk_nbd_disk *nbd)
 	 * For soft disconnection, nbd server can close connection after all
 	 * outstanding request are transmitted.
 	 */
-	if (nbd->state == NBD_DISK_STATE_SOFTDISC && !spdk_nbd_io_xmit_check(nbd)) {
+	if (conn->state == NBD_DISK_STATE_SOFTDISC && !spdk_nbd_io_xmit_check(conn)) {
 		return -1;
 	}
 
@@ -781,27 +1017,27 @@ spdk_nbd_io_xmit(struct spdk_nbd_disk *nbd)
 }
 
 /**
- * Poll an NBD instance.
+ * Poll an NBD connection.
  *
  * \return 0 on success or negated errno values on error (e.g. connection closed).
  */
 static int
-_spdk_nbd_poll(struct spdk_nbd_disk *nbd)
+_spdk_nbd_poll(struct nbd_conn *conn)
 {
 	int rc;
 
 	/* transmit executed io first */
-	rc = spdk_nbd_io_xmit(nbd);
+	rc = spdk_nbd_io_xmit(conn);
 	if (rc < 0) {
 		return rc;
 	}
 
-	rc = spdk_nbd_io_recv(nbd);
+	rc = spdk_nbd_io_recv(conn);
 	if (rc < 0) {
 		return rc;
 	}
 
-	rc = spdk_nbd_io_exec(nbd);
+	rc = spdk_nbd_io_exec(conn);
 
 	return rc;
 }
@@ -809,19 +1045,111 @@ _spdk_nbd_poll(struct spdk_nbd_disk *nbd)
 static int
 spdk_nbd_poll(void *arg)
 {
-	struct spdk_nbd_disk *nbd = arg;
+	struct nbd_conn *conn = arg;
 	int rc;
 
-	rc = _spdk_nbd_poll(nbd);
+	rc = _spdk_nbd_poll(conn);
 	if (rc < 0) {
 		SPDK_INFOLOG(SPDK_LOG_NBD, "spdk_nbd_poll() returned %s (%d); closing connection\n",
 			     spdk_strerror(-rc), rc);
-		spdk_nbd_stop(nbd);
+		if (conn->state == NBD_DISK_STATE_SOFTDISC) {
+			nbd_conn_done(conn, _nbd_conn_disconnected);
+		} else {
+			nbd_conn_done(conn, _nbd_conn_error);
+		}
 	}
 
 	return -1;
 }
 
+/* Called on the conn thread */
+static int
+nbd_conn_start(struct nbd_conn *conn)
+{
+	conn->ch = spdk_bdev_get_io_channel(conn->nbd->bdev_desc);
+	if (conn->ch == NULL) {
+		SPDK_ERRLOG("could not get io channel for %s\n", conn->nbd->nbd_path);
+		return -ENOMEM;
+	}
+
+	conn->poller = spdk_poller_register(spdk_nbd_poll, conn, 0);
+	return 0;
+}
+
+static void
+_nbd_conn_start(void *arg)
+{
+	struct nbd_conn *conn = arg;
+
+	if (nbd_conn_start(conn) != 0) {
+		nbd_conn_done(conn, _nbd_conn_error);
+	}
+}
+
+/*
+ * Start the conns. The first one runs on the disk thread, the other ones
+ * on their own threads spread across the remaining cores. On failure the
+ * conns that were already started keep running and have to be stopped
+ * with spdk_nbd_stop().
+ */
+static int
+nbd_start_conns(struct spdk_nbd_disk *nbd)
+{
+	struct nbd_conn *conn;
+	struct spdk_cpuset cpumask;
+	uint32_t *cores, core_count = 0, current_idx = 0;
+	uint32_t i, core;
+	const char *dev_name;
+	char thread_name[64];
+	int rc = 0;
+
+	cores = calloc(spdk_env_get_core_count(), sizeof(*cores));
+	if (cores == NULL) {
+		return -ENOMEM;
+	}
+
+	SPDK_ENV_FOREACH_CORE(core) {
+		if (core == spdk_env_get_current_core()) {
+			current_idx = core_count;
+		}
+		cores[core_count++] = core;
+	}
+
+	dev_name = strrchr(nbd->nbd_path, '/');
+	dev_name = dev_name ? dev_name + 1 : nbd->nbd_path;
+
+	for (i = 0; i < nbd->num_conns; i++) {
+		conn = &nbd->conns[i];
+
+		if (i == 0) {
+			/* Started synchronously, so a failure can be reported to the caller */
+			conn->thread = nbd->thread;
+			rc = nbd_conn_start(conn);
+			if (rc != 0) {
+				break;
+			}
+		} else {
+			spdk_cpuset_zero(&cpumask);
+			spdk_cpuset_set_cpu(&cpumask, cores[(current_idx + i) % core_count], true);
+			snprintf(thread_name, sizeof(thread_name), "%s.%"PRIu32, dev_name, i);
+			conn->thread = spdk_thread_create(thread_name, &cpumask);
+			if (conn->thread == NULL) {
+				SPDK_ERRLOG("%s: failed to create thread for connection %"PRIu32"\n",
+					    nbd->nbd_path, i);
+				rc = -EIO;
+				break;
+			}
+
+			spdk_thread_send_msg(conn->thread, _nbd_conn_start, conn);
+		}
+
+		nbd->num_conns_running++;
+	}
+
+	free(cores);
+	return rc;
+}
+
 static void *
 nbd_start_kernel(void *arg)
 {
@@ -849,6 +1177,8 @@ struct spdk_nbd_start_ctx {
 	void			*cb_arg;
 	struct spdk_poller	*poller;
 	int			polling_count;
+	/* index of the next conn to hand over to the kernel */
+	uint32_t		conn_idx;
 };
 
 static void
@@ -857,6 +1187,8 @@ spdk_nbd_start_complete(struct spdk_nbd_start_ctx *ctx)
 	int		rc;
 	pthread_t	tid;
 	int		flag;
+	uint32_t	i;
+	unsigned long	nbd_flags = 0;
 
 	/* Add nbd_disk to the end of disk list */
 	rc = spdk_nbd_disk_register(ctx->nbd);
@@ -881,13 +1213,21 @@ spdk_nbd_start_complete(struct spdk_nbd_start_ctx *ctx)
 	}
 
 #ifdef NBD_FLAG_SEND_TRIM
-	rc = ioctl(ctx->nbd->dev_fd, NBD_SET_FLAGS, NBD_FLAG_SEND_TRIM);
-	if (rc == -1) {
-		SPDK_ERRLOG("ioctl(NBD_SET_FLAGS) failed: %s\n", spdk_strerror(errno));
-		rc = -errno;
-		goto err;
-	}
+	nbd_flags |= NBD_FLAG_SEND_TRIM;
 #endif
+	/* All conns submit to the same bdev, so a flush on any of them covers them all */
+	if (ctx->nbd->num_conns > 1) {
+		nbd_flags |= NBD_FLAG_CAN_MULTI_CONN;
+	}
+
+	if (nbd_flags != 0) {
+		rc = ioctl(ctx->nbd->dev_fd, NBD_SET_FLAGS, nbd_flags);
+		if (rc == -1) {
+			SPDK_ERRLOG("ioctl(NBD_SET_FLAGS) failed: %s\n", spdk_strerror(errno));
+			rc = -errno;
+			goto err;
+		}
+	}
 
 	rc = pthread_create(&tid, NULL, nbd_start_kernel, (void *)(intptr_t)ctx->nbd->dev_fd);
 	if (rc != 0) {
@@ -903,15 +1243,20 @@ spdk_nbd_start_complete(struct spdk_nbd_start_ctx *ctx)
 		goto err;
 	}
 
-	flag = fcntl(ctx->nbd->spdk_sp_fd, F_GETFL);
-	if (fcntl(ctx->nbd->spdk_sp_fd, F_SETFL, flag | O_NONBLOCK) < 0) {
-		SPDK_ERRLOG("fcntl can't set nonblocking mode for socket, fd: %d (%s)\n",
-			    ctx->nbd->spdk_sp_fd, spdk_strerror(errno));
-		rc = -errno;
-		goto err;
+	for (i = 0; i < ctx->nbd->num_conns; i++) {
+		flag = fcntl(ctx->nbd->conns[i].spdk_sp_fd, F_GETFL);
+		if (fcntl(ctx->nbd->conns[i].spdk_sp_fd, F_SETFL, flag | O_NONBLOCK) < 0) {
+			SPDK_ERRLOG("fcntl can't set nonblocking mode for socket, fd: %d (%s)\n",
+				    ctx->nbd->conns[i].spdk_sp_fd, spdk_strerror(errno));
+			rc = -errno;
+			goto err;
+		}
 	}
 
-	ctx->nbd->nbd_poller = spdk_poller_register(spdk_nbd_poll, ctx->nbd, 0);
+	rc = nbd_start_conns(ctx->nbd);
+	if (rc != 0) {
+		goto err;
+	}
 
 	if (ctx->cb_fn) {
 		ctx->cb_fn(ctx->cb_arg, ctx->nbd, 0);
@@ -935,8 +1280,14 @@ spdk_nbd_enable_kernel(void *arg)
 	int rc;
 
 	/* Declare device setup by this process */
-	rc = ioctl(ctx->nbd->dev_fd, NBD_SET_SOCK, ctx->nbd->kernel_sp_fd);
-	if (rc == -1) {
+	for (; ctx->conn_idx < ctx->nbd->num_conns; ctx->conn_idx++) {
+		rc = ioctl(ctx->nbd->dev_fd, NBD_SET_SOCK, ctx->nbd->conns[ctx->conn_idx].kernel_sp_fd);
+		if (rc == -1) {
+			break;
+		}
+	}
+
+	if (ctx->conn_idx < ctx->nbd->num_conns) {
 		if (errno == EBUSY && ctx->polling_count-- > 0) {
 			if (ctx->poller == NULL) {
 				ctx->poller = spdk_poller_register(spdk_nbd_enable_kernel, ctx,
@@ -971,14 +1322,22 @@ spdk_nbd_enable_kernel(void *arg)
 }
 
 void
-spdk_nbd_start(const char *bdev_name, const char *nbd_path,
-	       spdk_nbd_start_cb cb_fn, void *cb_arg)
+spdk_nbd_start_ext(const char *bdev_name, const char *nbd_path, uint32_t num_connections,
+		   spdk_nbd_start_cb cb_fn, void *cb_arg)
 {
 	struct spdk_nbd_start_ctx	*ctx = NULL;
 	struct spdk_nbd_disk		*nbd = NULL;
 	struct spdk_bdev		*bdev;
 	int				rc;
 	int				sp[2];
+	uint32_t			i;
+
+	if (num_connections == 0 || num_connections > SPDK_NBD_MAX_CONNECTIONS) {
+		SPDK_ERRLOG("invalid number of connections %"PRIu32", allowed 1-%d\n",
+			    num_connections, SPDK_NBD_MAX_CONNECTIONS);
+		rc = -EINVAL;
+		goto err;
+	}
 
 	bdev = spdk_bdev_get_by_name(bdev_name);
 	if (bdev == NULL) {
@@ -994,8 +1353,22 @@ spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 	}
 
 	nbd->dev_fd = -1;
-	nbd->spdk_sp_fd = -1;
-	nbd->kernel_sp_fd = -1;
+	nbd->thread = spdk_get_thread();
+
+	nbd->conns = calloc(num_connections, sizeof(*nbd->conns));
+	if (nbd->conns == NULL) {
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	nbd->num_conns = num_connections;
+	for (i = 0; i < num_connections; i++) {
+		nbd->conns[i].nbd = nbd;
+		nbd->conns[i].spdk_sp_fd = -1;
+		nbd->conns[i].kernel_sp_fd = -1;
+		TAILQ_INIT(&nbd->conns[i].received_io_list);
+		TAILQ_INIT(&nbd->conns[i].executed_io_list);
+	}
 
 	ctx = calloc(1, sizeof(*ctx));
 	if (ctx == NULL) {
@@ -1016,18 +1389,20 @@ spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 
 	nbd->bdev = bdev;
 
-	nbd->ch = spdk_bdev_get_io_channel(nbd->bdev_desc);
 	nbd->buf_align = spdk_max(spdk_bdev_get_buf_align(bdev), 64);
 
-	rc = socketpair(AF_UNIX, SOCK_STREAM, 0, sp);
-	if (rc != 0) {
-		SPDK_ERRLOG("socketpair failed\n");
-		rc = -errno;
-		goto err;
+	for (i = 0; i < num_connections; i++) {
+		rc = socketpair(AF_UNIX, SOCK_STREAM, 0, sp);
+		if (rc != 0) {
+			SPDK_ERRLOG("socketpair failed\n");
+			rc = -errno;
+			goto err;
+		}
+
+		nbd->conns[i].spdk_sp_fd = sp[0];
+		nbd->conns[i].kernel_sp_fd = sp[1];
 	}
 
-	nbd->spdk_sp_fd = sp[0];
-	nbd->kernel_sp_fd = sp[1];
 	nbd->nbd_path = strdup(nbd_path);
 	if (!nbd->nbd_path) {
 		SPDK_ERRLOG("strdup allocation failure\n");
@@ -1035,9 +1410,6 @@ spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 		goto err;
 	}
 
-	TAILQ_INIT(&nbd->received_io_list);
-	TAILQ_INIT(&nbd->executed_io_list);
-
 	/* Make sure nbd_path is not used in this SPDK app */
 	if (spdk_nbd_disk_find_by_nbd_path(nbd->nbd_path)) {
 		SPDK_NOTICELOG("%s is already exported\n", nbd->nbd_path);
@@ -1052,8 +1424,8 @@ spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 		goto err;
 	}
 
-	SPDK_INFOLOG(SPDK_LOG_NBD, "Enabling kernel access to bdev %s via %s\n",
-		     spdk_bdev_get_name(bdev), nbd_path);
+	SPDK_INFOLOG(SPDK_LOG_NBD, "Enabling kernel access to bdev %s via %s with %"PRIu32" connection(s)\n",
+		     spdk_bdev_get_name(bdev), nbd_path, num_connections);
 
 	spdk_nbd_enable_kernel(ctx);
 	return;
@@ -1069,6 +1441,13 @@ err:
 	}
 }
 
+void
+spdk_nbd_start(const char *bdev_name, const char *nbd_path,
+	       spdk_nbd_start_cb cb_fn, void *cb_arg)
+{
+	spdk_nbd_start_ext(bdev_name, nbd_path, 1, cb_fn, cb_arg);
+}
+
 const char *
 spdk_nbd_get_path(struct spdk_nbd_disk *nbd)
 {
@@ -663,6 +663,7 @@ spdk_nvme_probe_ctx_init(struct spdk_nvme_probe_ctx *probe_ctx,
 	probe_ctx->attach_cb = attach_cb;
 	probe_ctx->remove_cb = remove_cb;
 	TAILQ_INIT(&probe_ctx->init_ctrlrs);
+	probe_ctx->init_failed = false;
 }
 
 int
@@ -1224,23 +1225,29 @@ spdk_nvme_probe_poll_async(struct spdk_nvme_probe_ctx *probe_ctx)
 		return 0;
 	}
 
+	/*
+	 * A failed controller is already removed from init_ctrlrs and destructed,
+	 *  so keep polling the remaining ones instead of abandoning them.
+	 */
 	TAILQ_FOREACH_SAFE(ctrlr, &probe_ctx->init_ctrlrs, tailq, ctrlr_tmp) {
-		rc = nvme_ctrlr_poll_internal(ctrlr, probe_ctx);
-		if (rc != 0) {
-			rc = -EIO;
-			break;
+		if (nvme_ctrlr_poll_internal(ctrlr, probe_ctx) != 0) {
+			probe_ctx->init_failed = true;
 		}
 	}
 
-	if (rc != 0 || TAILQ_EMPTY(&probe_ctx->init_ctrlrs)) {
-		nvme_robust_mutex_lock(&g_spdk_nvme_driver->lock);
-		g_spdk_nvme_driver->initialized = true;
-		nvme_robust_mutex_unlock(&g_spdk_nvme_driver->lock);
-		free(probe_ctx);
-		return rc;
+	if (!TAILQ_EMPTY(&probe_ctx->init_ctrlrs)) {
+		return -EAGAIN;
 	}
 
-	return -EAGAIN;
+	if (probe_ctx->init_failed) {
+		rc = -EIO;
+	}
+
+	nvme_robust_mutex_lock(&g_spdk_nvme_driver->lock);
+	g_spdk_nvme_driver->initialized = true;
+	nvme_robust_mutex_unlock(&g_spdk_nvme_driver->lock);
+	free(probe_ctx);
+	return rc;
 }
 
 struct spdk_nvme_probe_ctx *
@@ -43,6 +43,9 @@ static int nvme_ctrlr_construct_and_submit_aer(struct spdk_nvme_ctrlr *ctrlr,
 		struct nvme_async_event_request *aer);
 static int nvme_ctrlr_identify_ns_async(struct spdk_nvme_ns *ns);
 static int nvme_ctrlr_identify_id_desc_async(struct spdk_nvme_ns *ns);
+static void nvme_ctrlr_destruct_namespaces(struct spdk_nvme_ctrlr *ctrlr);
+static void nvme_ctrlr_set_state(struct spdk_nvme_ctrlr *ctrlr, enum nvme_ctrlr_state state,
+				 uint64_t timeout_in_ms);
 
 static int
 nvme_ctrlr_get_cc(struct spdk_nvme_ctrlr *ctrlr, union spdk_nvme_cc_register *cc)
@@ -532,57 +535,69 @@ nvme_ctrlr_construct_intel_support_log_page_list(struct spdk_nvme_ctrlr *ctrlr,
 	}
 }
 
+struct nvme_intel_log_pages_ctx {
+	struct spdk_nvme_ctrlr				*ctrlr;
+	struct spdk_nvme_intel_log_page_directory	*log_page_directory;
+};
+
+static void
+nvme_ctrlr_set_intel_support_log_pages_done(void *arg, const struct spdk_nvme_cpl *cpl)
+{
+	struct nvme_intel_log_pages_ctx *ctx = arg;
+	struct spdk_nvme_ctrlr *ctrlr = ctx->ctrlr;
+
+	if (spdk_nvme_cpl_is_error(cpl)) {
+		SPDK_WARNLOG("Intel log pages not supported on Intel drive!\n");
+	} else {
+		nvme_ctrlr_construct_intel_support_log_page_list(ctrlr, ctx->log_page_directory);
+	}
+
+	spdk_free(ctx->log_page_directory);
+	free(ctx);
+	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_SET_SUPPORTED_FEATURES,
+			     ctrlr->opts.admin_timeout_ms);
+}
+
 static int nvme_ctrlr_set_intel_support_log_pages(struct spdk_nvme_ctrlr *ctrlr)
 {
 	int rc = 0;
-	struct nvme_completion_poll_status	*status;
-	struct spdk_nvme_intel_log_page_directory *log_page_directory;
+	struct nvme_intel_log_pages_ctx *ctx;
 
-	log_page_directory = spdk_zmalloc(sizeof(struct spdk_nvme_intel_log_page_directory),
-					  64, NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
-	if (log_page_directory == NULL) {
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		SPDK_ERRLOG("Failed to allocate log page context\n");
+		return -ENOMEM;
+	}
+
+	ctx->ctrlr = ctrlr;
+	ctx->log_page_directory = spdk_zmalloc(sizeof(struct spdk_nvme_intel_log_page_directory),
+					       64, NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	if (ctx->log_page_directory == NULL) {
 		SPDK_ERRLOG("could not allocate log_page_directory\n");
+		free(ctx);
 		return -ENXIO;
 	}
 
-	status = malloc(sizeof(*status));
-	if (!status) {
-		SPDK_ERRLOG("Failed to allocate status tracker\n");
-		spdk_free(log_page_directory);
-		return -ENOMEM;
-	}
+	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_WAIT_FOR_SUPPORTED_INTEL_LOG_PAGES,
+			     ctrlr->opts.admin_timeout_ms);
 
 	rc = spdk_nvme_ctrlr_cmd_get_log_page(ctrlr, SPDK_NVME_INTEL_LOG_PAGE_DIRECTORY,
-					      SPDK_NVME_GLOBAL_NS_TAG, log_page_directory,
+					      SPDK_NVME_GLOBAL_NS_TAG, ctx->log_page_directory,
 					      sizeof(struct spdk_nvme_intel_log_page_directory),
-					      0, nvme_completion_poll_cb, status);
+					      0, nvme_ctrlr_set_intel_support_log_pages_done, ctx);
 	if (rc != 0) {
-		spdk_free(log_page_directory);
-		free(status);
+		spdk_free(ctx->log_page_directory);
+		free(ctx);
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
 		return rc;
 	}
 
-	if (spdk_nvme_wait_for_completion_timeout(ctrlr->adminq, status,
-			ctrlr->opts.admin_timeout_ms / 1000)) {
-		spdk_free(log_page_directory);
-		SPDK_WARNLOG("Intel log pages not supported on Intel drive!\n");
-		if (!status->timed_out) {
-			free(status);
-		}
-		return 0;
-	}
-
-	nvme_ctrlr_construct_intel_support_log_page_list(ctrlr, log_page_directory);
-	spdk_free(log_page_directory);
-	free(status);
 	return 0;
 }
 
 static int
 nvme_ctrlr_set_supported_log_pages(struct spdk_nvme_ctrlr *ctrlr)
 {
-	int	rc = 0;
-
 	memset(ctrlr->log_page_supported, 0, sizeof(ctrlr->log_page_supported));
 	/* Mandatory pages */
 	ctrlr->log_page_supported[SPDK_NVME_LOG_ERROR] = true;
@@ -592,10 +607,12 @@ nvme_ctrlr_set_supported_log_pages(struct spdk_nvme_ctrlr *ctrlr)
 		ctrlr->log_page_supported[SPDK_NVME_LOG_COMMAND_EFFECTS_LOG] = true;
 	}
 	if (ctrlr->cdata.vid == SPDK_PCI_VID_INTEL && !(ctrlr->quirks & NVME_INTEL_QUIRK_NO_LOG_PAGES)) {
-		rc = nvme_ctrlr_set_intel_support_log_pages(ctrlr);
+		return nvme_ctrlr_set_intel_support_log_pages(ctrlr);
 	}
 
-	return rc;
+	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_SET_SUPPORTED_FEATURES,
+			     ctrlr->opts.admin_timeout_ms);
+	return 0;
 }
 
 static void
@@ -610,25 +627,31 @@ nvme_ctrlr_set_intel_supported_features(struct spdk_nvme_ctrlr *ctrlr)
 	ctrlr->feature_supported[SPDK_NVME_INTEL_FEAT_LATENCY_TRACKING] = true;
 }
 
+static void
+nvme_ctrlr_set_arbitration_feature_done(void *arg, const struct spdk_nvme_cpl *cpl)
+{
+	struct spdk_nvme_ctrlr *ctrlr = arg;
+
+	if (spdk_nvme_cpl_is_error(cpl)) {
+		SPDK_ERRLOG("Set arbitration feature failed\n");
+	}
+
+	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_SET_DB_BUF_CFG,
+			     ctrlr->opts.admin_timeout_ms);
+}
+
 static void
 nvme_ctrlr_set_arbitration_feature(struct spdk_nvme_ctrlr *ctrlr)
 {
 	uint32_t cdw11;
-	struct nvme_completion_poll_status *status;
 
 	if (ctrlr->opts.arbitration_burst == 0) {
-		return;
+		goto done;
 	}
 
 	if (ctrlr->opts.arbitration_burst > 7) {
 		SPDK_WARNLOG("Valid arbitration burst values is from 0-7\n");
-		return;
-	}
-
-	status = malloc(sizeof(*status));
-	if (!status) {
-		SPDK_ERRLOG("Failed to allocate status tracker\n");
-		return;
+		goto done;
 	}
 
 	cdw11 = ctrlr->opts.arbitration_burst;
@@ -639,22 +662,20 @@ nvme_ctrlr_set_arbitration_feature(struct spdk_nvme_ctrlr *ctrlr)
 		cdw11 |= (uint32_t)ctrlr->opts.high_priority_weight << 24;
 	}
 
+	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_WAIT_FOR_ARBITRATION_FEATURE,
+			     ctrlr->opts.admin_timeout_ms);
+
 	if (spdk_nvme_ctrlr_cmd_set_feature(ctrlr, SPDK_NVME_FEAT_ARBITRATION,
 					    cdw11, 0, NULL, 0,
-					    nvme_completion_poll_cb, status) < 0) {
+					    nvme_ctrlr_set_arbitration_feature_done, ctrlr) < 0) {
 		SPDK_ERRLOG("Set arbitration feature failed\n");
-		free(status);
-		return;
+		goto done;
 	}
 
-	if (spdk_nvme_wait_for_completion_timeout(ctrlr->adminq, status,
-			ctrlr->opts.admin_timeout_ms / 1000)) {
-		SPDK_ERRLOG("Timeout to set arbitration feature\n");
-	}
-
-	if (!status->timed_out) {
-		free(status);
-	}
+	return;
+done:
+	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_SET_DB_BUF_CFG,
+			     ctrlr->opts.admin_timeout_ms);
 }
 
 static void
@@ -907,6 +928,8 @@ nvme_ctrlr_state_string(enum nvme_ctrlr_state state)
 		return "construct namespaces";
 	case NVME_CTRLR_STATE_IDENTIFY_ACTIVE_NS:
 		return "identify active ns";
+	case NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_ACTIVE_NS:
+		return "wait for identify active ns";
 	case NVME_CTRLR_STATE_IDENTIFY_NS:
 		return "identify ns";
 	case NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_NS:
@@ -921,8 +944,12 @@ nvme_ctrlr_state_string(enum nvme_ctrlr_state state)
 		return "wait for configure aer";
 	case NVME_CTRLR_STATE_SET_SUPPORTED_LOG_PAGES:
 		return "set supported log pages";
+	case NVME_CTRLR_STATE_WAIT_FOR_SUPPORTED_INTEL_LOG_PAGES:
+		return "wait for supported intel log pages";
 	case NVME_CTRLR_STATE_SET_SUPPORTED_FEATURES:
 		return "set supported features";
+	case NVME_CTRLR_STATE_WAIT_FOR_ARBITRATION_FEATURE:
+		return "wait for arbitration feature";
 	case NVME_CTRLR_STATE_SET_DB_BUF_CFG:
 		return "set doorbell buffer config";
 	case NVME_CTRLR_STATE_WAIT_FOR_DB_BUF_CFG:
@@ -1286,6 +1313,41 @@ nvme_ctrlr_identify(struct spdk_nvme_ctrlr *ctrlr)
 	return 0;
 }
 
+static bool
+nvme_ctrlr_active_ns_list_supported(struct spdk_nvme_ctrlr *ctrlr)
+{
+	return ctrlr->vs.raw >= SPDK_NVME_VERSION(1, 1, 0) && !(ctrlr->quirks & NVME_QUIRK_IDENTIFY_CNS);
+}
+
+static uint32_t *
+nvme_ctrlr_alloc_active_ns_list(struct spdk_nvme_ctrlr *ctrlr, uint32_t *num_pages)
+{
+	uint32_t *new_ns_list;
+
+	/*
+	 * The allocated size must be a multiple of sizeof(struct spdk_nvme_ns_list)
+	 */
+	*num_pages = (ctrlr->num_ns * sizeof(new_ns_list[0]) - 1) / sizeof(struct spdk_nvme_ns_list) + 1;
+	new_ns_list = spdk_zmalloc(*num_pages * sizeof(struct spdk_nvme_ns_list), ctrlr->page_size,
+				   NULL, SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA | SPDK_MALLOC_SHARE);
+	if (!new_ns_list) {
+		SPDK_ERRLOG("Failed to allocate active_ns_list!\n");
+	}
+
+	return new_ns_list;
+}
+
+static void
+nvme_ctrlr_swap_active_ns_list(struct spdk_nvme_ctrlr *ctrlr, uint32_t *new_ns_list)
+{
+	/*
+	 * Now that that the list is properly setup, we can swap it in to the ctrlr and
+	 * free up the previous one.
+	 */
+	spdk_free(ctrlr->active_ns_list);
+	ctrlr->active_ns_list = new_ns_list;
+}
+
 int
 nvme_ctrlr_identify_active_ns(struct spdk_nvme_ctrlr *ctrlr)
 {
@@ -1303,14 +1365,8 @@ nvme_ctrlr_identify_active_ns(struct spdk_nvme_ctrlr *ctrlr)
 		return 0;
 	}
 
-	/*
-	 * The allocated size must be a multiple of sizeof(struct spdk_nvme_ns_list)
-	 */
-	num_pages = (ctrlr->num_ns * sizeof(new_ns_list[0]) - 1) / sizeof(struct spdk_nvme_ns_list) + 1;
-	new_ns_list = spdk_zmalloc(num_pages * sizeof(struct spdk_nvme_ns_list), ctrlr->page_size,
-				   NULL, SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA | SPDK_MALLOC_SHARE);
+	new_ns_list = nvme_ctrlr_alloc_active_ns_list(ctrlr, &num_pages);
 	if (!new_ns_list) {
-		SPDK_ERRLOG("Failed to allocate active_ns_list!\n");
 		return -ENOMEM;
 	}
 
@@ -1321,7 +1377,7 @@ nvme_ctrlr_identify_active_ns(struct spdk_nvme_ctrlr *ctrlr)
 		return -ENOMEM;
 	}
 
-	if (ctrlr->vs.raw >= SPDK_NVME_VERSION(1, 1, 0) && !(ctrlr->quirks & NVME_QUIRK_IDENTIFY_CNS)) {
+	if (nvme_ctrlr_active_ns_list_supported(ctrlr)) {
 		/*
 		 * Iterate through the pages and fetch each chunk of 1024 namespaces until
 		 * there are no more active namespaces
@@ -1357,12 +1413,7 @@ nvme_ctrlr_identify_active_ns(struct spdk_nvme_ctrlr *ctrlr)
 		}
 	}
 
-	/*
-	 * Now that that the list is properly setup, we can swap it in to the ctrlr and
-	 * free up the previous one.
-	 */
-	spdk_free(ctrlr->active_ns_list);
-	ctrlr->active_ns_list = new_ns_list;
+	nvme_ctrlr_swap_active_ns_list(ctrlr, new_ns_list);
 	free(status);
 
 	return 0;
@@ -1374,6 +1425,104 @@ fail:
 	return rc;
 }
 
+/* Active namespace list retrieval done without blocking during controller initialization */
+struct nvme_active_ns_ctx {
+	struct spdk_nvme_ctrlr	*ctrlr;
+	uint32_t		page;
+	uint32_t		num_pages;
+	uint32_t		next_nsid;
+	uint32_t		*new_ns_list;
+};
+
+static void
+nvme_ctrlr_identify_active_ns_async_fail(struct nvme_active_ns_ctx *ctx)
+{
+	struct spdk_nvme_ctrlr *ctrlr = ctx->ctrlr;
+
+	spdk_free(ctx->new_ns_list);
+	free(ctx);
+	nvme_ctrlr_destruct_namespaces(ctrlr);
+	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
+}
+
+static int nvme_ctrlr_identify_active_ns_async_page(struct nvme_active_ns_ctx *ctx);
+
+static void
+nvme_ctrlr_identify_active_ns_async_done(void *arg, const struct spdk_nvme_cpl *cpl)
+{
+	struct nvme_active_ns_ctx *ctx = arg;
+	struct spdk_nvme_ctrlr *ctrlr = ctx->ctrlr;
+
+	if (spdk_nvme_cpl_is_error(cpl)) {
+		SPDK_ERRLOG("nvme_ctrlr_cmd_identify_active_ns_list failed!\n");
+		nvme_ctrlr_identify_active_ns_async_fail(ctx);
+		return;
+	}
+
+	ctx->next_nsid = ctx->new_ns_list[1024 * ctx->page + 1023];
+	ctx->page++;
+	if (ctx->next_nsid != 0 && ctx->page < ctx->num_pages) {
+		if (nvme_ctrlr_identify_active_ns_async_page(ctx) != 0) {
+			nvme_ctrlr_identify_active_ns_async_fail(ctx);
+		}
+		return;
+	}
+
+	nvme_ctrlr_swap_active_ns_list(ctrlr, ctx->new_ns_list);
+	free(ctx);
+	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_IDENTIFY_NS, ctrlr->opts.admin_timeout_ms);
+}
+
+static int
+nvme_ctrlr_identify_active_ns_async_page(struct nvme_active_ns_ctx *ctx)
+{
+	return nvme_ctrlr_cmd_identify(ctx->ctrlr, SPDK_NVME_IDENTIFY_ACTIVE_NS_LIST, 0, ctx->next_nsid,
+				       &ctx->new_ns_list[1024 * ctx->page], sizeof(struct spdk_nvme_ns_list),
+				       nvme_ctrlr_identify_active_ns_async_done, ctx);
+}
+
+static int
+nvme_ctrlr_identify_active_ns_async(struct spdk_nvme_ctrlr *ctrlr)
+{
+	struct nvme_active_ns_ctx *ctx;
+	int rc;
+
+	if (ctrlr->num_ns == 0 || !nvme_ctrlr_active_ns_list_supported(ctrlr)) {
+		/* No admin commands needed */
+		rc = nvme_ctrlr_identify_active_ns(ctrlr);
+		if (rc < 0) {
+			nvme_ctrlr_destruct_namespaces(ctrlr);
+		}
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_IDENTIFY_NS,
+				     ctrlr->opts.admin_timeout_ms);
+		return rc;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		SPDK_ERRLOG("Failed to allocate active ns context\n");
+		return -ENOMEM;
+	}
+
+	ctx->ctrlr = ctrlr;
+	ctx->new_ns_list = nvme_ctrlr_alloc_active_ns_list(ctrlr, &ctx->num_pages);
+	if (!ctx->new_ns_list) {
+		free(ctx);
+		return -ENOMEM;
+	}
+
+	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_ACTIVE_NS,
+			     ctrlr->opts.admin_timeout_ms);
+
+	rc = nvme_ctrlr_identify_active_ns_async_page(ctx);
+	if (rc != 0) {
+		nvme_ctrlr_identify_active_ns_async_fail(ctx);
+		return rc;
+	}
+
+	return 0;
+}
+
 static void
 nvme_ctrlr_identify_ns_async_done(void *arg, const struct spdk_nvme_cpl *cpl)
 {
@@ -2430,12 +2579,11 @@ nvme_ctrlr_process_init(struct spdk_nvme_ctrlr *ctrlr)
 		break;
 
 	case NVME_CTRLR_STATE_IDENTIFY_ACTIVE_NS:
-		rc = nvme_ctrlr_identify_active_ns(ctrlr);
-		if (rc < 0) {
-			nvme_ctrlr_destruct_namespaces(ctrlr);
-		}
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_IDENTIFY_NS,
-				     ctrlr->opts.admin_timeout_ms);
+		rc = nvme_ctrlr_identify_active_ns_async(ctrlr);
+		break;
+
+	case NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_ACTIVE_NS:
+		spdk_nvme_qpair_process_completions(ctrlr->adminq, 0);
 		break;
 
 	case NVME_CTRLR_STATE_IDENTIFY_NS:
@@ -2464,14 +2612,18 @@ nvme_ctrlr_process_init(struct spdk_nvme_ctrlr *ctrlr)
 
 	case NVME_CTRLR_STATE_SET_SUPPORTED_LOG_PAGES:
 		rc = nvme_ctrlr_set_supported_log_pages(ctrlr);
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_SET_SUPPORTED_FEATURES,
-				     ctrlr->opts.admin_timeout_ms);
+		break;
+
+	case NVME_CTRLR_STATE_WAIT_FOR_SUPPORTED_INTEL_LOG_PAGES:
+		spdk_nvme_qpair_process_completions(ctrlr->adminq, 0);
 		break;
 
 	case NVME_CTRLR_STATE_SET_SUPPORTED_FEATURES:
 		nvme_ctrlr_set_supported_features(ctrlr);
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_SET_DB_BUF_CFG,
-				     ctrlr->opts.admin_timeout_ms);
+		break;
+
+	case NVME_CTRLR_STATE_WAIT_FOR_ARBITRATION_FEATURE:
+		spdk_nvme_qpair_process_completions(ctrlr->adminq, 0);
 		break;
 
 	case NVME_CTRLR_STATE_SET_DB_BUF_CFG:
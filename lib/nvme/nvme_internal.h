@@ -502,6 +502,11 @@ enum nvme_ctrlr_state {
 	 */
 	NVME_CTRLR_STATE_IDENTIFY_ACTIVE_NS,
 
+	/**
+	 * Waiting for the Identify Active Namespace ID list commands to be completed.
+	 */
+	NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_ACTIVE_NS,
+
 	/**
 	 * Get Identify Namespace Data structure for each NS.
 	 */
@@ -538,11 +543,21 @@ enum nvme_ctrlr_state {
 	 */
 	NVME_CTRLR_STATE_SET_SUPPORTED_LOG_PAGES,
 
+	/**
+	 * Waiting for the Intel log page directory to be retrieved.
+	 */
+	NVME_CTRLR_STATE_WAIT_FOR_SUPPORTED_INTEL_LOG_PAGES,
+
 	/**
 	 * Set supported features of the controller.
 	 */
 	NVME_CTRLR_STATE_SET_SUPPORTED_FEATURES,
 
+	/**
+	 * Waiting for the Set Features - Arbitration command to be completed.
+	 */
+	NVME_CTRLR_STATE_WAIT_FOR_ARBITRATION_FEATURE,
+
 	/**
 	 * Set Doorbell Buffer Config of the controller.
 	 */
@@ -750,6 +765,8 @@ struct spdk_nvme_probe_ctx {
 	spdk_nvme_attach_cb			attach_cb;
 	spdk_nvme_remove_cb			remove_cb;
 	TAILQ_HEAD(, spdk_nvme_ctrlr)		init_ctrlrs;
+	/* Set when any of the controllers failed to initialize */
+	bool					init_failed;
 };
 
 struct nvme_driver {
@@ -1769,7 +1769,8 @@ nvme_pcie_prp_list_append(struct nvme_tracker *tr, uint32_t *prp_index, void *vi
 {
 	struct spdk_nvme_cmd *cmd = &tr->req->cmd;
 	uintptr_t page_mask = page_size - 1;
-	uint64_t phys_addr;
+	uint64_t phys_addr = 0;
+	uint64_t mapping_len = 0;
 	uint32_t i;
 
 	SPDK_DEBUGLOG(SPDK_LOG_NVME, "prp_index:%u virt_addr:%p len:%u\n",
@@ -1793,10 +1794,14 @@ nvme_pcie_prp_list_append(struct nvme_tracker *tr, uint32_t *prp_index, void *vi
 			return -EFAULT;
 		}
 
-		phys_addr = spdk_vtophys(virt_addr, NULL);
-		if (spdk_unlikely(phys_addr == SPDK_VTOPHYS_ERROR)) {
-			SPDK_ERRLOG("vtophys(%p) failed\n", virt_addr);
-			return -EFAULT;
+		/* Translate once per physically contiguous region rather than once per page */
+		if (mapping_len == 0) {
+			mapping_len = len;
+			phys_addr = spdk_vtophys(virt_addr, &mapping_len);
+			if (spdk_unlikely(phys_addr == SPDK_VTOPHYS_ERROR)) {
+				SPDK_ERRLOG("vtophys(%p) failed\n", virt_addr);
+				return -EFAULT;
+			}
 		}
 
 		if (i == 0) {
@@ -1818,6 +1823,13 @@ nvme_pcie_prp_list_append(struct nvme_tracker *tr, uint32_t *prp_index, void *vi
 		virt_addr += seg_len;
 		len -= seg_len;
 		i++;
+
+		if (mapping_len > seg_len) {
+			mapping_len -= seg_len;
+			phys_addr += seg_len;
+		} else {
+			mapping_len = 0;
+		}
 	}
 
 	cmd->psdt = SPDK_NVME_PSDT_PRP;
@@ -1953,7 +1965,7 @@ nvme_pcie_qpair_build_hw_sgl_request(struct spdk_nvme_qpair *qpair, struct nvme_
 {
 	int rc;
 	void *virt_addr;
-	uint64_t phys_addr;
+	uint64_t phys_addr, mapping_length;
 	uint32_t remaining_transfer_len, remaining_user_sge_len, length;
 	struct spdk_nvme_sgl_descriptor *sgl;
 	uint32_t nseg = 0;
@@ -1994,12 +2006,13 @@ nvme_pcie_qpair_build_hw_sgl_request(struct spdk_nvme_qpair *qpair, struct nvme_
 				goto exit;
 			}
 
-			phys_addr = spdk_vtophys(virt_addr, NULL);
+			mapping_length = remaining_user_sge_len;
+			phys_addr = spdk_vtophys(virt_addr, &mapping_length);
 			if (phys_addr == SPDK_VTOPHYS_ERROR) {
 				goto exit;
 			}
 
-			length = spdk_min(remaining_user_sge_len, VALUE_2MB - _2MB_OFFSET(virt_addr));
+			length = spdk_min(remaining_user_sge_len, mapping_length);
 			remaining_user_sge_len -= length;
 			virt_addr += length;
 
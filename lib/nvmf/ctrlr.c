@@ -2815,6 +2815,7 @@ spdk_nvmf_request_complete(struct spdk_nvmf_request *req)
 	struct spdk_nvme_cpl *rsp = &req->rsp->nvme_cpl;
 	struct spdk_nvmf_qpair *qpair;
 	struct spdk_nvmf_subsystem_poll_group *sgroup = NULL;
+	struct spdk_nvmf_subsystem_pg_ns_info *ns_info = NULL;
 	bool is_connect = req->cmd->nvmf_cmd.opcode == SPDK_NVME_OPC_FABRIC &&
 			  req->cmd->nvmf_cmd.fctype == SPDK_NVMF_FABRIC_COMMAND_CONNECT;
 
@@ -2825,6 +2826,8 @@ spdk_nvmf_request_complete(struct spdk_nvmf_request *req)
 	qpair = req->qpair;
 	if (qpair->ctrlr) {
 		sgroup = &qpair->group->sgroups[qpair->ctrlr->subsys->id];
+		/* Look it up before the transport may reuse the command buffer */
+		ns_info = _spdk_nvmf_request_get_ns_info(req, sgroup);
 	}
 
 	SPDK_DEBUGLOG(SPDK_LOG_NVMF,
@@ -2847,6 +2850,16 @@ spdk_nvmf_request_complete(struct spdk_nvmf_request *req)
 		}
 	}
 
+	if (ns_info != NULL) {
+		assert(ns_info->io_outstanding > 0);
+		ns_info->io_outstanding--;
+		if (ns_info->state == SPDK_NVMF_PG_NS_PAUSING &&
+		    ns_info->io_outstanding == 0) {
+			ns_info->state = SPDK_NVMF_PG_NS_PAUSED;
+			ns_info->pause_cb_fn(ns_info->pause_cb_arg, 0);
+		}
+	}
+
 	spdk_nvmf_qpair_request_cleanup(qpair);
 
 	return 0;
@@ -2896,6 +2909,20 @@ nvmf_trace_command(union nvmf_h2c_msg *h2c_msg, bool is_admin_queue)
 	}
 }
 
+static void
+nvmf_request_track_outstanding(struct spdk_nvmf_request *req,
+			       struct spdk_nvmf_subsystem_poll_group *sgroup)
+{
+	struct spdk_nvmf_subsystem_pg_ns_info *ns_info;
+
+	sgroup->io_outstanding++;
+
+	ns_info = _spdk_nvmf_request_get_ns_info(req, sgroup);
+	if (ns_info != NULL) {
+		ns_info->io_outstanding++;
+	}
+}
+
 static void
 _nvmf_request_exec(struct spdk_nvmf_request *req,
 		   struct spdk_nvmf_subsystem_poll_group *sgroup)
@@ -2906,7 +2933,7 @@ _nvmf_request_exec(struct spdk_nvmf_request *req,
 	nvmf_trace_command(req->cmd, spdk_nvmf_qpair_is_admin_queue(qpair));
 
 	if (sgroup) {
-		sgroup->io_outstanding++;
+		nvmf_request_track_outstanding(req, sgroup);
 	}
 
 	/* Place the request on the outstanding list so we can keep track of it */
@@ -2945,6 +2972,7 @@ spdk_nvmf_request_exec(struct spdk_nvmf_request *req)
 {
 	struct spdk_nvmf_qpair *qpair = req->qpair;
 	struct spdk_nvmf_subsystem_poll_group *sgroup = NULL;
+	struct spdk_nvmf_subsystem_pg_ns_info *ns_info;
 
 	if (qpair->ctrlr) {
 		sgroup = &qpair->group->sgroups[qpair->ctrlr->subsys->id];
@@ -2957,16 +2985,18 @@ spdk_nvmf_request_exec(struct spdk_nvmf_request *req)
 		TAILQ_INSERT_TAIL(&qpair->outstanding, req, link);
 		/* Still increment io_outstanding because request_complete decrements it */
 		if (sgroup != NULL) {
-			sgroup->io_outstanding++;
+			nvmf_request_track_outstanding(req, sgroup);
 		}
 		spdk_nvmf_request_complete(req);
 		return;
 	}
 
-	/* Check if the subsystem is paused (if there is a subsystem) */
+	/* Check if the subsystem or the namespace is paused (if there is a subsystem) */
 	if (sgroup != NULL) {
-		if (sgroup->state != SPDK_NVMF_SUBSYSTEM_ACTIVE) {
-			/* The subsystem is not currently active. Queue this request. */
+		ns_info = _spdk_nvmf_request_get_ns_info(req, sgroup);
+		if (sgroup->state != SPDK_NVMF_SUBSYSTEM_ACTIVE ||
+		    (ns_info != NULL && ns_info->state != SPDK_NVMF_PG_NS_ACTIVE)) {
+			/* The subsystem or the namespace is not currently active. Queue this request. */
 			TAILQ_INSERT_TAIL(&sgroup->queued, req, link);
 			return;
 		}
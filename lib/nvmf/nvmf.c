@@ -958,19 +958,121 @@ spdk_nvmf_poll_group_add_transport(struct spdk_nvmf_poll_group *group,
 	return 0;
 }
 
+static void
+poll_group_ns_info_clear(struct spdk_nvmf_subsystem_pg_ns_info *ns_info)
+{
+	struct spdk_nvmf_subsystem_pg_ns_info cleared = {};
+
+	/* The pause state belongs to the namespace ID, not to the bdev behind it */
+	cleared.io_outstanding = ns_info->io_outstanding;
+	cleared.state = ns_info->state;
+	cleared.pause_cb_fn = ns_info->pause_cb_fn;
+	cleared.pause_cb_arg = ns_info->pause_cb_arg;
+	*ns_info = cleared;
+}
+
+static int
+poll_group_update_ns(struct spdk_nvmf_poll_group *group,
+		     struct spdk_nvmf_subsystem *subsystem,
+		     struct spdk_nvmf_subsystem_pg_ns_info *ns_info,
+		     uint32_t nsid, bool *ns_changed)
+{
+	struct spdk_nvmf_ns *ns;
+	struct spdk_nvmf_registrant *reg, *tmp;
+	struct spdk_io_channel *ch;
+	uint32_t j;
+
+	ns = _spdk_nvmf_subsystem_get_ns(subsystem, nsid);
+	ch = ns_info->channel;
+
+	if (ns == NULL && ch == NULL) {
+		/* Both NULL. Leave empty */
+	} else if (ns == NULL && ch != NULL) {
+		/* There was a channel here, but the namespace is gone. */
+		*ns_changed = true;
+		spdk_put_io_channel(ch);
+		ns_info->channel = NULL;
+	} else if (ns != NULL && ch == NULL) {
+		/* A namespace appeared but there is no channel yet */
+		*ns_changed = true;
+		ch = spdk_bdev_get_io_channel(ns->desc);
+		if (ch == NULL) {
+			SPDK_ERRLOG("Could not allocate I/O channel.\n");
+			return -ENOMEM;
+		}
+		ns_info->channel = ch;
+	} else if (spdk_uuid_compare(&ns_info->uuid, spdk_bdev_get_uuid(ns->bdev)) != 0) {
+		/* A namespace was here before, but was replaced by a new one. */
+		*ns_changed = true;
+		spdk_put_io_channel(ns_info->channel);
+		poll_group_ns_info_clear(ns_info);
+
+		ch = spdk_bdev_get_io_channel(ns->desc);
+		if (ch == NULL) {
+			SPDK_ERRLOG("Could not allocate I/O channel.\n");
+			return -ENOMEM;
+		}
+		ns_info->channel = ch;
+	} else if (ns_info->num_blocks != spdk_bdev_get_num_blocks(ns->bdev)) {
+		/* Namespace is still there but size has changed */
+		SPDK_DEBUGLOG(SPDK_LOG_NVMF, "Namespace resized: subsystem_id %d,"
+			      " nsid %u, pg %p, old %lu, new %lu\n",
+			      subsystem->id,
+			      ns->nsid,
+			      group,
+			      ns_info->num_blocks,
+			      spdk_bdev_get_num_blocks(ns->bdev));
+		*ns_changed = true;
+	}
+
+	if (ns == NULL) {
+		poll_group_ns_info_clear(ns_info);
+	} else {
+		ns_info->uuid = *spdk_bdev_get_uuid(ns->bdev);
+		ns_info->num_blocks = spdk_bdev_get_num_blocks(ns->bdev);
+		ns_info->crkey = ns->crkey;
+		ns_info->rtype = ns->rtype;
+		if (ns->holder) {
+			ns_info->holder_id = ns->holder->hostid;
+		}
+
+		memset(&ns_info->reg_hostid, 0, SPDK_NVMF_MAX_NUM_REGISTRANTS * sizeof(struct spdk_uuid));
+		j = 0;
+		TAILQ_FOREACH_SAFE(reg, &ns->registrants, link, tmp) {
+			if (j >= SPDK_NVMF_MAX_NUM_REGISTRANTS) {
+				SPDK_ERRLOG("Maximum %u registrants can support.\n", SPDK_NVMF_MAX_NUM_REGISTRANTS);
+				return -EINVAL;
+			}
+			ns_info->reg_hostid[j++] = reg->hostid;
+		}
+	}
+
+	return 0;
+}
+
+static void
+poll_group_ns_changed(struct spdk_nvmf_poll_group *group,
+		      struct spdk_nvmf_subsystem *subsystem)
+{
+	struct spdk_nvmf_ctrlr *ctrlr;
+
+	TAILQ_FOREACH(ctrlr, &subsystem->ctrlrs, link) {
+		if (ctrlr->admin_qpair->group == group) {
+			spdk_nvmf_ctrlr_async_event_ns_notice(ctrlr);
+		}
+	}
+}
+
 static int
 poll_group_update_subsystem(struct spdk_nvmf_poll_group *group,
 			    struct spdk_nvmf_subsystem *subsystem)
 {
 	struct spdk_nvmf_subsystem_poll_group *sgroup;
 	uint32_t new_num_ns, old_num_ns;
-	uint32_t i, j;
-	struct spdk_nvmf_ns *ns;
-	struct spdk_nvmf_registrant *reg, *tmp;
-	struct spdk_io_channel *ch;
+	uint32_t i;
 	struct spdk_nvmf_subsystem_pg_ns_info *ns_info;
-	struct spdk_nvmf_ctrlr *ctrlr;
 	bool ns_changed;
+	int rc;
 
 	/* Make sure our poll group has memory for this subsystem allocated */
 	if (subsystem->id >= group->num_sgroups) {
@@ -1038,79 +1140,14 @@ poll_group_update_subsystem(struct spdk_nvmf_poll_group *group,
 
 	/* Detect bdevs that were added or removed */
 	for (i = 0; i < sgroup->num_ns; i++) {
-		ns = subsystem->ns[i];
-		ns_info = &sgroup->ns_info[i];
-		ch = ns_info->channel;
-
-		if (ns == NULL && ch == NULL) {
-			/* Both NULL. Leave empty */
-		} else if (ns == NULL && ch != NULL) {
-			/* There was a channel here, but the namespace is gone. */
-			ns_changed = true;
-			spdk_put_io_channel(ch);
-			ns_info->channel = NULL;
-		} else if (ns != NULL && ch == NULL) {
-			/* A namespace appeared but there is no channel yet */
-			ns_changed = true;
-			ch = spdk_bdev_get_io_channel(ns->desc);
-			if (ch == NULL) {
-				SPDK_ERRLOG("Could not allocate I/O channel.\n");
-				return -ENOMEM;
-			}
-			ns_info->channel = ch;
-		} else if (spdk_uuid_compare(&ns_info->uuid, spdk_bdev_get_uuid(ns->bdev)) != 0) {
-			/* A namespace was here before, but was replaced by a new one. */
-			ns_changed = true;
-			spdk_put_io_channel(ns_info->channel);
-			memset(ns_info, 0, sizeof(*ns_info));
-
-			ch = spdk_bdev_get_io_channel(ns->desc);
-			if (ch == NULL) {
-				SPDK_ERRLOG("Could not allocate I/O channel.\n");
-				return -ENOMEM;
-			}
-			ns_info->channel = ch;
-		} else if (ns_info->num_blocks != spdk_bdev_get_num_blocks(ns->bdev)) {
-			/* Namespace is still there but size has changed */
-			SPDK_DEBUGLOG(SPDK_LOG_NVMF, "Namespace resized: subsystem_id %d,"
-				      " nsid %u, pg %p, old %lu, new %lu\n",
-				      subsystem->id,
-				      ns->nsid,
-				      group,
-				      ns_info->num_blocks,
-				      spdk_bdev_get_num_blocks(ns->bdev));
-			ns_changed = true;
-		}
-
-		if (ns == NULL) {
-			memset(ns_info, 0, sizeof(*ns_info));
-		} else {
-			ns_info->uuid = *spdk_bdev_get_uuid(ns->bdev);
-			ns_info->num_blocks = spdk_bdev_get_num_blocks(ns->bdev);
-			ns_info->crkey = ns->crkey;
-			ns_info->rtype = ns->rtype;
-			if (ns->holder) {
-				ns_info->holder_id = ns->holder->hostid;
-			}
-
-			memset(&ns_info->reg_hostid, 0, SPDK_NVMF_MAX_NUM_REGISTRANTS * sizeof(struct spdk_uuid));
-			j = 0;
-			TAILQ_FOREACH_SAFE(reg, &ns->registrants, link, tmp) {
-				if (j >= SPDK_NVMF_MAX_NUM_REGISTRANTS) {
-					SPDK_ERRLOG("Maximum %u registrants can support.\n", SPDK_NVMF_MAX_NUM_REGISTRANTS);
-					return -EINVAL;
-				}
-				ns_info->reg_hostid[j++] = reg->hostid;
-			}
+		rc = poll_group_update_ns(group, subsystem, &sgroup->ns_info[i], i + 1, &ns_changed);
+		if (rc) {
+			return rc;
 		}
 	}
 
 	if (ns_changed) {
-		TAILQ_FOREACH(ctrlr, &subsystem->ctrlrs, link) {
-			if (ctrlr->admin_qpair->group == group) {
-				spdk_nvmf_ctrlr_async_event_ns_notice(ctrlr);
-			}
-		}
+		poll_group_ns_changed(group, subsystem);
 	}
 
 	return 0;
@@ -1305,8 +1342,9 @@ spdk_nvmf_poll_group_resume_subsystem(struct spdk_nvmf_poll_group *group,
 				      struct spdk_nvmf_subsystem *subsystem,
 				      spdk_nvmf_poll_group_mod_done cb_fn, void *cb_arg)
 {
-	struct spdk_nvmf_request *req, *tmp;
+	struct spdk_nvmf_request *req;
 	struct spdk_nvmf_subsystem_poll_group *sgroup;
+	TAILQ_HEAD(, spdk_nvmf_request) queued;
 	int rc = 0;
 
 	if (subsystem->id >= group->num_sgroups) {
@@ -1325,9 +1363,13 @@ spdk_nvmf_poll_group_resume_subsystem(struct spdk_nvmf_poll_group *group,
 
 	sgroup->state = SPDK_NVMF_SUBSYSTEM_ACTIVE;
 
-	/* Release all queued requests */
-	TAILQ_FOREACH_SAFE(req, &sgroup->queued, link, tmp) {
-		TAILQ_REMOVE(&sgroup->queued, req, link);
+	/* Release all queued requests. Requests for namespaces that are still paused are put
+	 * back on sgroup->queued by spdk_nvmf_request_exec(), so walk a detached list. */
+	TAILQ_INIT(&queued);
+	TAILQ_SWAP(&sgroup->queued, &queued, spdk_nvmf_request, link);
+	while (!TAILQ_EMPTY(&queued)) {
+		req = TAILQ_FIRST(&queued);
+		TAILQ_REMOVE(&queued, req, link);
 		spdk_nvmf_request_exec(req);
 	}
 fini:
@@ -1336,6 +1378,98 @@ fini:
 	}
 }
 
+void
+spdk_nvmf_poll_group_pause_ns(struct spdk_nvmf_poll_group *group,
+			      struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+			      spdk_nvmf_poll_group_mod_done cb_fn, void *cb_arg)
+{
+	struct spdk_nvmf_subsystem_poll_group *sgroup;
+	struct spdk_nvmf_subsystem_pg_ns_info *ns_info;
+	int rc = 0;
+
+	if (subsystem->id >= group->num_sgroups) {
+		rc = -1;
+		goto fini;
+	}
+
+	sgroup = &group->sgroups[subsystem->id];
+	if (nsid == 0 || nsid > sgroup->num_ns) {
+		/* The namespace was never seen by this poll group, so nothing to drain */
+		goto fini;
+	}
+
+	ns_info = &sgroup->ns_info[nsid - 1];
+	assert(ns_info->state == SPDK_NVMF_PG_NS_ACTIVE);
+	ns_info->state = SPDK_NVMF_PG_NS_PAUSING;
+
+	if (ns_info->io_outstanding > 0) {
+		ns_info->pause_cb_fn = cb_fn;
+		ns_info->pause_cb_arg = cb_arg;
+		return;
+	}
+
+	ns_info->state = SPDK_NVMF_PG_NS_PAUSED;
+fini:
+	if (cb_fn) {
+		cb_fn(cb_arg, rc);
+	}
+}
+
+void
+spdk_nvmf_poll_group_resume_ns(struct spdk_nvmf_poll_group *group,
+			       struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+			       spdk_nvmf_poll_group_mod_done cb_fn, void *cb_arg)
+{
+	struct spdk_nvmf_request *req, *tmp;
+	struct spdk_nvmf_subsystem_poll_group *sgroup;
+	struct spdk_nvmf_subsystem_pg_ns_info *ns_info;
+	bool ns_changed = false;
+	int rc = 0;
+
+	if (subsystem->id >= group->num_sgroups) {
+		rc = -1;
+		goto fini;
+	}
+
+	sgroup = &group->sgroups[subsystem->id];
+	if (nsid == 0 || nsid > sgroup->num_ns) {
+		goto fini;
+	}
+
+	ns_info = &sgroup->ns_info[nsid - 1];
+
+	/* Only this namespace changed, so leave the rest of the subsystem alone */
+	rc = poll_group_update_ns(group, subsystem, ns_info, nsid, &ns_changed);
+	if (rc) {
+		goto fini;
+	}
+
+	if (ns_changed) {
+		poll_group_ns_changed(group, subsystem);
+	}
+
+	ns_info->state = SPDK_NVMF_PG_NS_ACTIVE;
+	ns_info->pause_cb_fn = NULL;
+	ns_info->pause_cb_arg = NULL;
+
+	if (sgroup->state != SPDK_NVMF_SUBSYSTEM_ACTIVE) {
+		/* The requests will be released once the subsystem is resumed */
+		goto fini;
+	}
+
+	/* Release the requests queued for this namespace, keeping their order */
+	TAILQ_FOREACH_SAFE(req, &sgroup->queued, link, tmp) {
+		if (_spdk_nvmf_request_get_ns_info(req, sgroup) == ns_info) {
+			TAILQ_REMOVE(&sgroup->queued, req, link);
+			spdk_nvmf_request_exec(req);
+		}
+	}
+fini:
+	if (cb_fn) {
+		cb_fn(cb_arg, rc);
+	}
+}
+
 
 struct spdk_nvmf_poll_group *
 spdk_nvmf_get_optimal_poll_group(struct spdk_nvmf_qpair *qpair)
@@ -57,6 +57,13 @@ enum spdk_nvmf_subsystem_state {
 	SPDK_NVMF_SUBSYSTEM_DEACTIVATING,
 };
 
+/* State of a single namespace within a subsystem poll group */
+enum spdk_nvmf_pg_ns_state {
+	SPDK_NVMF_PG_NS_ACTIVE = 0,
+	SPDK_NVMF_PG_NS_PAUSING,
+	SPDK_NVMF_PG_NS_PAUSED,
+};
+
 struct spdk_nvmf_tgt {
 	char					name[NVMF_TGT_NAME_MAX_LENGTH];
 
@@ -119,6 +126,13 @@ struct spdk_nvmf_subsystem_pg_ns_info {
 	/* Host ID for the registrants with the namespace */
 	struct spdk_uuid		reg_hostid[SPDK_NVMF_MAX_NUM_REGISTRANTS];
 	uint64_t			num_blocks;
+
+	/* I/O commands to this namespace being executed on the poll group */
+	uint64_t			io_outstanding;
+	enum spdk_nvmf_pg_ns_state	state;
+	/* Called once the namespace is paused on this poll group */
+	void				(*pause_cb_fn)(void *cb_arg, int status);
+	void				*pause_cb_arg;
 };
 
 typedef void(*spdk_nvmf_poll_group_mod_done)(void *cb_arg, int status);
@@ -134,6 +148,7 @@ struct spdk_nvmf_subsystem_poll_group {
 
 	enum spdk_nvmf_subsystem_state		state;
 
+	/* Requests held while the subsystem or the namespace they target is paused */
 	TAILQ_HEAD(, spdk_nvmf_request)		queued;
 };
 
@@ -166,6 +181,10 @@ struct spdk_nvmf_ns {
 	char *ptpl_file;
 	/* Persist Through Power Loss feature is enabled */
 	bool ptpl_activated;
+	/* Bdev events waiting for the subsystem to finish a state change */
+	bool remove_pending;
+	bool resize_pending;
+	struct spdk_poller *event_retry_poller;
 };
 
 struct spdk_nvmf_ctrlr_feat {
@@ -246,6 +265,8 @@ struct spdk_nvmf_subsystem {
 	uint32_t				max_nsid;
 	/* This is the maximum allowed nsid to a subsystem */
 	uint32_t				max_allowed_nsid;
+	/* Namespaces paused by spdk_nvmf_subsystem_pause_ns(), indexed by nsid - 1 */
+	struct spdk_bit_array			*paused_ns;
 
 	TAILQ_HEAD(, spdk_nvmf_ctrlr)			ctrlrs;
 	TAILQ_HEAD(, spdk_nvmf_host)			hosts;
@@ -267,6 +288,12 @@ void spdk_nvmf_poll_group_pause_subsystem(struct spdk_nvmf_poll_group *group,
 		struct spdk_nvmf_subsystem *subsystem, spdk_nvmf_poll_group_mod_done cb_fn, void *cb_arg);
 void spdk_nvmf_poll_group_resume_subsystem(struct spdk_nvmf_poll_group *group,
 		struct spdk_nvmf_subsystem *subsystem, spdk_nvmf_poll_group_mod_done cb_fn, void *cb_arg);
+void spdk_nvmf_poll_group_pause_ns(struct spdk_nvmf_poll_group *group,
+				   struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+				   spdk_nvmf_poll_group_mod_done cb_fn, void *cb_arg);
+void spdk_nvmf_poll_group_resume_ns(struct spdk_nvmf_poll_group *group,
+				    struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+				    spdk_nvmf_poll_group_mod_done cb_fn, void *cb_arg);
 
 void spdk_nvmf_get_discovery_log_page(struct spdk_nvmf_tgt *tgt, const char *hostnqn,
 				      struct iovec *iov,
@@ -347,7 +374,8 @@ _spdk_nvmf_subsystem_get_ns(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid
 		return NULL;
 	}
 
-	return subsystem->ns[nsid - 1];
+	/* Pairs with the release store that publishes a namespace in spdk_nvmf_subsystem_add_ns() */
+	return __atomic_load_n(&subsystem->ns[nsid - 1], __ATOMIC_ACQUIRE);
 }
 
 static inline bool
@@ -356,4 +384,29 @@ spdk_nvmf_qpair_is_admin_queue(struct spdk_nvmf_qpair *qpair)
 	return qpair->qid == 0;
 }
 
+/*
+ * Get the poll group namespace information of the namespace targeted by an I/O
+ * command. Returns NULL for admin and fabrics commands, which are not subject
+ * to namespace pausing.
+ */
+static inline struct spdk_nvmf_subsystem_pg_ns_info *
+_spdk_nvmf_request_get_ns_info(struct spdk_nvmf_request *req,
+			       struct spdk_nvmf_subsystem_poll_group *sgroup)
+{
+	uint32_t nsid;
+
+	if (spdk_nvmf_qpair_is_admin_queue(req->qpair) ||
+	    req->cmd->nvmf_cmd.opcode == SPDK_NVME_OPC_FABRIC) {
+		return NULL;
+	}
+
+	nsid = req->cmd->nvme_cmd.nsid;
+	/* NOTE: This implicitly also checks for 0, since 0 - 1 wraps around to UINT32_MAX. */
+	if (spdk_unlikely(nsid - 1 >= sgroup->num_ns)) {
+		return NULL;
+	}
+
+	return &sgroup->ns_info[nsid - 1];
+}
+
 #endif /* __NVMF_INTERNAL_H__ */
@@ -184,14 +184,32 @@ decode_ns_uuid(const struct spdk_json_val *val, void *out)
 	return rc;
 }
 
+/* Number of subsystems written by nvmf_get_subsystems before yielding to other RPCs */
+#define RPC_GET_SUBSYSTEMS_BATCH	64
+/* Wait for the client to receive the response before writing more than this */
+#define RPC_GET_SUBSYSTEMS_MAX_UNSENT	(4 * 1024 * 1024)
+
 struct rpc_get_subsystem {
 	char *tgt_name;
+	char *nqn;
+	uint32_t offset;
+	uint32_t count;
 };
 
 static const struct spdk_json_object_decoder rpc_get_subsystem_decoders[] = {
 	{"tgt_name", offsetof(struct rpc_get_subsystem, tgt_name), spdk_json_decode_string, true},
+	{"nqn", offsetof(struct rpc_get_subsystem, nqn), spdk_json_decode_string, true},
+	{"offset", offsetof(struct rpc_get_subsystem, offset), spdk_json_decode_uint32, true},
+	{"count", offsetof(struct rpc_get_subsystem, count), spdk_json_decode_uint32, true},
 };
 
+static void
+free_rpc_get_subsystem(struct rpc_get_subsystem *r)
+{
+	free(r->tgt_name);
+	free(r->nqn);
+}
+
 static void
 dump_nvmf_subsystem(struct spdk_json_write_ctx *w, struct spdk_nvmf_subsystem *subsystem)
 {
@@ -295,11 +313,94 @@ dump_nvmf_subsystem(struct spdk_json_write_ctx *w, struct spdk_nvmf_subsystem *s
 	spdk_json_write_object_end(w);
 }
 
+struct rpc_get_subsystems_ctx {
+	struct rpc_get_subsystem req;
+	struct spdk_jsonrpc_request *request;
+	struct spdk_json_write_ctx *w;
+	/* Subsystem ID to continue from */
+	uint32_t next_sid;
+	/* Number of subsystems left to write, UINT32_MAX if unlimited */
+	uint32_t remaining;
+	struct spdk_poller *poller;
+};
+
+/*
+ * Write the next batch of subsystems. Subsystems can be added and removed between
+ * batches, so the position is kept as a subsystem ID.
+ *
+ * \return true once all the subsystems are written.
+ */
+static bool
+rpc_nvmf_get_subsystems_write_batch(struct rpc_get_subsystems_ctx *ctx)
+{
+	struct spdk_nvmf_subsystem *subsystem;
+	struct spdk_nvmf_tgt *tgt;
+	uint32_t written = 0;
+
+	/* The target may have been destroyed in the meantime */
+	tgt = spdk_nvmf_get_tgt(ctx->req.tgt_name);
+	if (tgt == NULL) {
+		return true;
+	}
+
+	for (; ctx->next_sid < tgt->max_subsystems; ctx->next_sid++) {
+		if (ctx->remaining == 0 || written == RPC_GET_SUBSYSTEMS_BATCH) {
+			break;
+		}
+
+		subsystem = tgt->subsystems[ctx->next_sid];
+		if (subsystem == NULL) {
+			continue;
+		}
+
+		if (ctx->req.offset > 0) {
+			ctx->req.offset--;
+			continue;
+		}
+
+		dump_nvmf_subsystem(ctx->w, subsystem);
+		written++;
+		if (ctx->remaining != UINT32_MAX) {
+			ctx->remaining--;
+		}
+	}
+
+	return ctx->next_sid == tgt->max_subsystems || ctx->remaining == 0;
+}
+
+static void
+rpc_nvmf_get_subsystems_done(struct rpc_get_subsystems_ctx *ctx)
+{
+	spdk_json_write_array_end(ctx->w);
+	spdk_jsonrpc_end_result(ctx->request, ctx->w);
+
+	spdk_poller_unregister(&ctx->poller);
+	free_rpc_get_subsystem(&ctx->req);
+	free(ctx);
+}
+
+static int
+rpc_nvmf_get_subsystems_poll(void *arg)
+{
+	struct rpc_get_subsystems_ctx *ctx = arg;
+
+	if (spdk_jsonrpc_get_unsent_len(ctx->request) > RPC_GET_SUBSYSTEMS_MAX_UNSENT) {
+		return 0;
+	}
+
+	if (rpc_nvmf_get_subsystems_write_batch(ctx)) {
+		rpc_nvmf_get_subsystems_done(ctx);
+	}
+
+	return 1;
+}
+
 static void
 spdk_rpc_nvmf_get_subsystems(struct spdk_jsonrpc_request *request,
 			     const struct spdk_json_val *params)
 {
 	struct rpc_get_subsystem req = { 0 };
+	struct rpc_get_subsystems_ctx *ctx;
 	struct spdk_json_write_ctx *w;
 	struct spdk_nvmf_subsystem *subsystem;
 	struct spdk_nvmf_tgt *tgt;
@@ -310,6 +411,7 @@ spdk_rpc_nvmf_get_subsystems(struct spdk_jsonrpc_request *request,
 					    &req)) {
 			SPDK_ERRLOG("spdk_json_decode_object failed\n");
 			spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+			free_rpc_get_subsystem(&req);
 			return;
 		}
 	}
@@ -318,20 +420,54 @@ spdk_rpc_nvmf_get_subsystems(struct spdk_jsonrpc_request *request,
 	if (!tgt) {
 		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
 						 "Unable to find a target.");
-		free(req.tgt_name);
+		free_rpc_get_subsystem(&req);
 		return;
 	}
 
-	w = spdk_jsonrpc_begin_result(request);
-	spdk_json_write_array_begin(w);
-	subsystem = spdk_nvmf_subsystem_get_first(tgt);
-	while (subsystem) {
+	if (req.nqn) {
+		subsystem = spdk_nvmf_tgt_find_subsystem(tgt, req.nqn);
+		if (!subsystem) {
+			SPDK_ERRLOG("Unable to find subsystem with NQN %s\n", req.nqn);
+			spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+			free_rpc_get_subsystem(&req);
+			return;
+		}
+
+		w = spdk_jsonrpc_begin_result(request);
+		spdk_json_write_array_begin(w);
 		dump_nvmf_subsystem(w, subsystem);
-		subsystem = spdk_nvmf_subsystem_get_next(subsystem);
+		spdk_json_write_array_end(w);
+		spdk_jsonrpc_end_result(request, w);
+		free_rpc_get_subsystem(&req);
+		return;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "Memory allocation error");
+		free_rpc_get_subsystem(&req);
+		return;
+	}
+
+	ctx->req = req;
+	ctx->request = request;
+	ctx->remaining = req.count != 0 ? req.count : UINT32_MAX;
+	ctx->w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_array_begin(ctx->w);
+
+	if (rpc_nvmf_get_subsystems_write_batch(ctx)) {
+		rpc_nvmf_get_subsystems_done(ctx);
+		return;
+	}
+
+	/* Write the rest of the subsystems over the following polls, so other RPCs aren't held up */
+	ctx->poller = spdk_poller_register(rpc_nvmf_get_subsystems_poll, ctx, 0);
+	if (!ctx->poller) {
+		while (!rpc_nvmf_get_subsystems_write_batch(ctx)) {
+		}
+		rpc_nvmf_get_subsystems_done(ctx);
 	}
-	spdk_json_write_array_end(w);
-	spdk_jsonrpc_end_result(request, w);
-	free(req.tgt_name);
 }
 SPDK_RPC_REGISTER("nvmf_get_subsystems", spdk_rpc_nvmf_get_subsystems, SPDK_RPC_RUNTIME)
 SPDK_RPC_REGISTER_ALIAS_DEPRECATED(nvmf_get_subsystems, get_nvmf_subsystems)
@@ -910,6 +1046,8 @@ struct nvmf_rpc_ns_ctx {
 	char *nqn;
 	char *tgt_name;
 	struct spdk_nvmf_ns_params ns_params;
+	/* Only this namespace is paused instead of the whole subsystem, if not 0 */
+	uint32_t paused_nsid;
 
 	struct spdk_jsonrpc_request *request;
 	bool response_sent;
@@ -959,6 +1097,7 @@ nvmf_rpc_ns_paused(struct spdk_nvmf_subsystem *subsystem,
 	struct nvmf_rpc_ns_ctx *ctx = cb_arg;
 	struct spdk_nvmf_ns_opts ns_opts;
 	struct spdk_bdev *bdev;
+	int rc;
 
 	bdev = spdk_bdev_get_by_name(ctx->ns_params.bdev_name);
 	if (!bdev) {
@@ -993,13 +1132,53 @@ nvmf_rpc_ns_paused(struct spdk_nvmf_subsystem *subsystem,
 	}
 
 resume:
-	if (spdk_nvmf_subsystem_resume(subsystem, nvmf_rpc_ns_resumed, ctx)) {
+	if (ctx->paused_nsid != 0) {
+		rc = spdk_nvmf_subsystem_resume_ns(subsystem, ctx->paused_nsid, nvmf_rpc_ns_resumed, ctx);
+	} else {
+		rc = spdk_nvmf_subsystem_resume(subsystem, nvmf_rpc_ns_resumed, ctx);
+	}
+
+	if (rc) {
 		spdk_jsonrpc_send_error_response(ctx->request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR, "Internal error");
 		nvmf_rpc_ns_ctx_free(ctx);
 		return;
 	}
 }
 
+/*
+ * A namespace that fits into the current NSID range of an active subsystem is
+ * added or removed by pausing only that namespace, so that I/O to the other
+ * namespaces of the subsystem is not held. Returns the NSID to pause, or 0 if
+ * the whole subsystem has to be paused.
+ */
+static uint32_t
+nvmf_rpc_ns_get_pause_nsid(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid, bool add)
+{
+	if (subsystem->state != SPDK_NVMF_SUBSYSTEM_ACTIVE) {
+		return 0;
+	}
+
+	if (nsid == 0 && add) {
+		/* Pick the same NSID spdk_nvmf_subsystem_add_ns() would */
+		for (nsid = 1; nsid <= subsystem->max_nsid; nsid++) {
+			if (_spdk_nvmf_subsystem_get_ns(subsystem, nsid) == NULL) {
+				return nsid;
+			}
+		}
+		return 0;
+	}
+
+	if (nsid == 0 || nsid > subsystem->max_nsid) {
+		return 0;
+	}
+
+	if (add && _spdk_nvmf_subsystem_get_ns(subsystem, nsid) != NULL) {
+		return 0;
+	}
+
+	return nsid;
+}
+
 static void
 spdk_rpc_nvmf_subsystem_add_ns(struct spdk_jsonrpc_request *request,
 			       const struct spdk_json_val *params)
@@ -1043,6 +1222,16 @@ spdk_rpc_nvmf_subsystem_add_ns(struct spdk_jsonrpc_request *request,
 		return;
 	}
 
+	ctx->paused_nsid = nvmf_rpc_ns_get_pause_nsid(subsystem, ctx->ns_params.nsid, true);
+	if (ctx->paused_nsid != 0) {
+		if (spdk_nvmf_subsystem_pause_ns(subsystem, ctx->paused_nsid, nvmf_rpc_ns_paused, ctx) == 0) {
+			ctx->ns_params.nsid = ctx->paused_nsid;
+			return;
+		}
+		/* E.g. the NSID is being changed by another request - fall back to a subsystem pause */
+		ctx->paused_nsid = 0;
+	}
+
 	if (spdk_nvmf_subsystem_pause(subsystem, nvmf_rpc_ns_paused, ctx)) {
 		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR, "Internal error");
 		nvmf_rpc_ns_ctx_free(ctx);
@@ -1055,6 +1244,8 @@ struct nvmf_rpc_remove_ns_ctx {
 	char *nqn;
 	char *tgt_name;
 	uint32_t nsid;
+	/* Only the namespace is paused instead of the whole subsystem */
+	bool ns_paused;
 
 	struct spdk_jsonrpc_request *request;
 	bool response_sent;
@@ -1109,7 +1300,13 @@ nvmf_rpc_remove_ns_paused(struct spdk_nvmf_subsystem *subsystem,
 		ctx->response_sent = true;
 	}
 
-	if (spdk_nvmf_subsystem_resume(subsystem, nvmf_rpc_remove_ns_resumed, ctx)) {
+	if (ctx->ns_paused) {
+		ret = spdk_nvmf_subsystem_resume_ns(subsystem, ctx->nsid, nvmf_rpc_remove_ns_resumed, ctx);
+	} else {
+		ret = spdk_nvmf_subsystem_resume(subsystem, nvmf_rpc_remove_ns_resumed, ctx);
+	}
+
+	if (ret) {
 		if (!ctx->response_sent) {
 			spdk_jsonrpc_send_error_response(ctx->request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR, "Internal error");
 		}
@@ -1161,6 +1358,12 @@ spdk_rpc_nvmf_subsystem_remove_ns(struct spdk_jsonrpc_request *request,
 		return;
 	}
 
+	if (nvmf_rpc_ns_get_pause_nsid(subsystem, ctx->nsid, false) != 0 &&
+	    spdk_nvmf_subsystem_pause_ns(subsystem, ctx->nsid, nvmf_rpc_remove_ns_paused, ctx) == 0) {
+		ctx->ns_paused = true;
+		return;
+	}
+
 	if (spdk_nvmf_subsystem_pause(subsystem, nvmf_rpc_remove_ns_paused, ctx)) {
 		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR, "Internal error");
 		nvmf_rpc_remove_ns_ctx_free(ctx);
@@ -1615,6 +1818,10 @@ static const struct spdk_json_object_decoder nvmf_rpc_create_transport_decoder[]
 		"sock_priority", offsetof(struct nvmf_rpc_create_transport_ctx, opts.sock_priority),
 		spdk_json_decode_uint32, true
 	},
+	{
+		"sock_busy_poll", offsetof(struct nvmf_rpc_create_transport_ctx, opts.sock_busy_poll),
+		spdk_json_decode_uint32, true
+	},
 	{
 		"tgt_name", offsetof(struct nvmf_rpc_create_transport_ctx, tgt_name),
 		spdk_json_decode_string, true
@@ -1765,6 +1972,7 @@ dump_nvmf_transport(struct spdk_json_write_ctx *w, struct spdk_nvmf_transport *t
 	} else if (type == SPDK_NVME_TRANSPORT_TCP) {
 		spdk_json_write_named_bool(w, "c2h_success", opts->c2h_success);
 		spdk_json_write_named_uint32(w, "sock_priority", opts->sock_priority);
+		spdk_json_write_named_uint32(w, "sock_busy_poll", opts->sock_busy_poll);
 	}
 
 	spdk_json_write_object_end(w);
@@ -1880,6 +2088,13 @@ write_nvmf_transport_stats(struct spdk_json_write_ctx *w,
 		}
 		spdk_json_write_array_end(w);
 		break;
+	case SPDK_NVME_TRANSPORT_TCP:
+		spdk_json_write_named_uint64(w, "placement_hits", stat->tcp.placement_hits);
+		spdk_json_write_named_uint64(w, "placement_misses", stat->tcp.placement_misses);
+		spdk_json_write_named_uint64(w, "no_placement_id", stat->tcp.no_placement_id);
+		spdk_json_write_named_uint64(w, "pdus_sent", stat->tcp.pdus_sent);
+		spdk_json_write_named_uint64(w, "sends", stat->tcp.sends);
+		break;
 	default:
 		break;
 	}
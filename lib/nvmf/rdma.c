@@ -1547,49 +1547,44 @@ nvmf_rdma_replace_buffer(struct spdk_nvmf_rdma_poll_group *rgroup, void **buf)
 	return 0;
 }
 
+static inline uint32_t
+nvmf_rdma_translation_to_lkey(uint64_t translation)
+{
+	if (!g_nvmf_hooks.get_rkey) {
+		return ((struct ibv_mr *)translation)->lkey;
+	} else {
+		return translation;
+	}
+}
+
 static bool
 nvmf_rdma_get_lkey(struct spdk_nvmf_rdma_device *device, struct iovec *iov,
 		   uint32_t *_lkey)
 {
 	uint64_t	translation_len;
-	uint32_t	lkey;
+	uint64_t	translation;
 
 	translation_len = iov->iov_len;
-
-	if (!g_nvmf_hooks.get_rkey) {
-		lkey = ((struct ibv_mr *)spdk_mem_map_translate(device->map,
-				(uint64_t)iov->iov_base, &translation_len))->lkey;
-	} else {
-		lkey = spdk_mem_map_translate(device->map,
-					      (uint64_t)iov->iov_base, &translation_len);
-	}
+	translation = spdk_mem_map_translate(device->map, (uint64_t)iov->iov_base, &translation_len);
 
 	if (spdk_unlikely(translation_len < iov->iov_len)) {
 		return false;
 	}
 
-	*_lkey = lkey;
+	*_lkey = nvmf_rdma_translation_to_lkey(translation);
 	return true;
 }
 
-static bool
-nvmf_rdma_fill_wr_sge(struct spdk_nvmf_rdma_device *device,
-		      struct iovec *iov, struct ibv_send_wr **_wr,
+static void
+nvmf_rdma_fill_wr_sge(uint32_t lkey, struct iovec *iov, struct ibv_send_wr **_wr,
 		      uint32_t *_remaining_data_block, uint32_t *_offset,
 		      uint32_t *_num_extra_wrs,
 		      const struct spdk_dif_ctx *dif_ctx)
 {
 	struct ibv_send_wr *wr = *_wr;
 	struct ibv_sge	*sg_ele = &wr->sg_list[wr->num_sge];
-	uint32_t	lkey = 0;
 	uint32_t	remaining, data_block_size, md_size, sge_len;
 
-	if (spdk_unlikely(!nvmf_rdma_get_lkey(device, iov, &lkey))) {
-		/* This is a very rare case that can occur when using DPDK version < 19.05 */
-		SPDK_ERRLOG("Data buffer split over multiple RDMA Memory Regions. Removing it from circulation.\n");
-		return false;
-	}
-
 	if (spdk_likely(!dif_ctx)) {
 		sg_ele->lkey = lkey;
 		sg_ele->addr = (uintptr_t)(iov->iov_base);
@@ -1638,8 +1633,6 @@ nvmf_rdma_fill_wr_sge(struct spdk_nvmf_rdma_device *device,
 			}
 		}
 	}
-
-	return true;
 }
 
 static int
@@ -1652,8 +1645,15 @@ nvmf_rdma_fill_wr_sgl(struct spdk_nvmf_rdma_poll_group *rgroup,
 {
 	struct spdk_nvmf_request *req = &rdma_req->req;
 	struct spdk_dif_ctx *dif_ctx = NULL;
+	uint64_t translations[NVMF_REQ_MAX_BUFFERS];
 	uint32_t remaining_data_block = 0;
 	uint32_t offset = 0;
+	uint32_t lkey = 0;
+	uint32_t iovcnt = 0;
+	uint32_t translated_len = 0;
+	int num_translated;
+	bool split;
+	int i;
 
 	if (spdk_unlikely(rdma_req->req.dif.dif_insert_or_strip)) {
 		dif_ctx = &rdma_req->req.dif.dif_ctx;
@@ -1662,17 +1662,37 @@ nvmf_rdma_fill_wr_sgl(struct spdk_nvmf_rdma_poll_group *rgroup,
 
 	wr->num_sge = 0;
 
-	while (length && (num_extra_wrs || wr->num_sge < SPDK_NVMF_MAX_SGL_ENTRIES)) {
-		while (spdk_unlikely(!nvmf_rdma_fill_wr_sge(device, &req->iov[rdma_req->iovpos], &wr,
-				     &remaining_data_block, &offset, &num_extra_wrs, dif_ctx))) {
-			if (nvmf_rdma_replace_buffer(rgroup, &req->buffers[rdma_req->iovpos]) == -ENOMEM) {
-				return -ENOMEM;
+	/* Translate all the buffers that hold this part of the data at once */
+	while (translated_len < length && rdma_req->iovpos + iovcnt < (uint32_t)req->iovcnt &&
+	       iovcnt < NVMF_REQ_MAX_BUFFERS) {
+		translated_len += req->iov[rdma_req->iovpos + iovcnt].iov_len;
+		iovcnt++;
+	}
+	num_translated = spdk_mem_map_translate_iov(device->map, &req->iov[rdma_req->iovpos],
+			 iovcnt, translations);
+
+	for (i = 0; length && (num_extra_wrs || wr->num_sge < SPDK_NVMF_MAX_SGL_ENTRIES); i++) {
+		if (spdk_likely(i < num_translated)) {
+			lkey = nvmf_rdma_translation_to_lkey(translations[i]);
+		} else {
+			/* The buffer that stopped the batch translation is known to be split */
+			split = (i == num_translated && i < (int)iovcnt);
+			while (spdk_unlikely(split || !nvmf_rdma_get_lkey(device, &req->iov[rdma_req->iovpos], &lkey))) {
+				split = false;
+				/* This is a very rare case that can occur when using DPDK version < 19.05 */
+				SPDK_ERRLOG("Data buffer split over multiple RDMA Memory Regions. Removing it from circulation.\n");
+				if (nvmf_rdma_replace_buffer(rgroup, &req->buffers[rdma_req->iovpos]) == -ENOMEM) {
+					return -ENOMEM;
+				}
+				req->iov[rdma_req->iovpos].iov_base = (void *)((uintptr_t)(req->buffers[rdma_req->iovpos] +
+								      NVMF_DATA_BUFFER_MASK) &
+								      ~NVMF_DATA_BUFFER_MASK);
 			}
-			req->iov[rdma_req->iovpos].iov_base = (void *)((uintptr_t)(req->buffers[rdma_req->iovpos] +
-							      NVMF_DATA_BUFFER_MASK) &
-							      ~NVMF_DATA_BUFFER_MASK);
 		}
 
+		nvmf_rdma_fill_wr_sge(lkey, &req->iov[rdma_req->iovpos], &wr,
+				      &remaining_data_block, &offset, &num_extra_wrs, dif_ctx);
+
 		length -= req->iov[rdma_req->iovpos].iov_len;
 		rdma_req->iovpos++;
 	}
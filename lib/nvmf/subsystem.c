@@ -36,6 +36,7 @@
 #include "nvmf_internal.h"
 #include "transport.h"
 
+#include "spdk/bit_array.h"
 #include "spdk/event.h"
 #include "spdk/likely.h"
 #include "spdk/string.h"
@@ -51,6 +52,9 @@
 
 #define MODEL_NUMBER_DEFAULT "SPDK bdev Controller"
 
+/* How often a bdev event is retried while the subsystem is changing state */
+#define NVMF_NS_EVENT_RETRY_US 1000
+
 /*
  * States for parsing valid domains in NQNs according to RFC 1034
  */
@@ -364,6 +368,7 @@ spdk_nvmf_subsystem_destroy(struct spdk_nvmf_subsystem *subsystem)
 	}
 
 	free(subsystem->ns);
+	spdk_bit_array_free(&subsystem->paused_ns);
 
 	subsystem->tgt->subsystems[subsystem->id] = NULL;
 	subsystem->tgt->discovery_genctr++;
@@ -576,6 +581,131 @@ spdk_nvmf_subsystem_resume(struct spdk_nvmf_subsystem *subsystem,
 	return spdk_nvmf_subsystem_state_change(subsystem, SPDK_NVMF_SUBSYSTEM_ACTIVE, cb_fn, cb_arg);
 }
 
+struct subsystem_ns_state_change_ctx {
+	struct spdk_nvmf_subsystem *subsystem;
+	uint32_t nsid;
+	bool pause;
+
+	spdk_nvmf_subsystem_state_change_done cb_fn;
+	void *cb_arg;
+};
+
+static bool
+nvmf_subsystem_ns_is_paused(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid)
+{
+	return subsystem->paused_ns != NULL && nsid != 0 &&
+	       spdk_bit_array_get(subsystem->paused_ns, nsid - 1);
+}
+
+static void
+subsystem_ns_state_change_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct subsystem_ns_state_change_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+
+	if (!ctx->pause) {
+		spdk_bit_array_clear(ctx->subsystem->paused_ns, ctx->nsid - 1);
+	}
+
+	if (ctx->cb_fn) {
+		ctx->cb_fn(ctx->subsystem, ctx->cb_arg, status);
+	}
+	free(ctx);
+}
+
+static void
+subsystem_ns_state_change_on_pg(struct spdk_io_channel_iter *i)
+{
+	struct subsystem_ns_state_change_ctx *ctx;
+	struct spdk_nvmf_poll_group *group;
+
+	ctx = spdk_io_channel_iter_get_ctx(i);
+	group = spdk_io_channel_get_ctx(spdk_io_channel_iter_get_channel(i));
+
+	if (ctx->pause) {
+		spdk_nvmf_poll_group_pause_ns(group, ctx->subsystem, ctx->nsid,
+					      subsystem_state_change_continue, i);
+	} else {
+		spdk_nvmf_poll_group_resume_ns(group, ctx->subsystem, ctx->nsid,
+					       subsystem_state_change_continue, i);
+	}
+}
+
+static int
+spdk_nvmf_subsystem_ns_state_change(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+				    bool pause, spdk_nvmf_subsystem_state_change_done cb_fn,
+				    void *cb_arg)
+{
+	struct subsystem_ns_state_change_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		return -ENOMEM;
+	}
+
+	ctx->subsystem = subsystem;
+	ctx->nsid = nsid;
+	ctx->pause = pause;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	spdk_for_each_channel(subsystem->tgt,
+			      subsystem_ns_state_change_on_pg,
+			      ctx,
+			      subsystem_ns_state_change_done);
+
+	return 0;
+}
+
+int
+spdk_nvmf_subsystem_pause_ns(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+			     spdk_nvmf_subsystem_state_change_done cb_fn,
+			     void *cb_arg)
+{
+	int rc;
+
+	if (subsystem->state != SPDK_NVMF_SUBSYSTEM_ACTIVE) {
+		return -EBUSY;
+	}
+
+	if (nsid == 0 || nsid > subsystem->max_nsid) {
+		return -EINVAL;
+	}
+
+	if (nvmf_subsystem_ns_is_paused(subsystem, nsid)) {
+		return -EBUSY;
+	}
+
+	if (subsystem->paused_ns == NULL ||
+	    spdk_bit_array_capacity(subsystem->paused_ns) < subsystem->max_nsid) {
+		rc = spdk_bit_array_resize(&subsystem->paused_ns, subsystem->max_nsid);
+		if (rc) {
+			return rc;
+		}
+	}
+
+	rc = spdk_nvmf_subsystem_ns_state_change(subsystem, nsid, true, cb_fn, cb_arg);
+	if (rc) {
+		return rc;
+	}
+
+	/* Set right away, so that add/remove see the namespace as paused once cb_fn is called */
+	spdk_bit_array_set(subsystem->paused_ns, nsid - 1);
+
+	return 0;
+}
+
+int
+spdk_nvmf_subsystem_resume_ns(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+			      spdk_nvmf_subsystem_state_change_done cb_fn,
+			      void *cb_arg)
+{
+	if (!nvmf_subsystem_ns_is_paused(subsystem, nsid)) {
+		return -EINVAL;
+	}
+
+	return spdk_nvmf_subsystem_ns_state_change(subsystem, nsid, false, cb_fn, cb_arg);
+}
+
 struct spdk_nvmf_subsystem *
 spdk_nvmf_subsystem_get_first(struct spdk_nvmf_tgt *tgt)
 {
@@ -968,14 +1098,45 @@ spdk_nvmf_subsystem_ns_changed(struct spdk_nvmf_subsystem *subsystem, uint32_t n
 	}
 }
 
+static void
+nvmf_ns_free(struct spdk_nvmf_ns *ns)
+{
+	struct spdk_nvmf_registrant *reg, *reg_tmp;
+
+	TAILQ_FOREACH_SAFE(reg, &ns->registrants, link, reg_tmp) {
+		TAILQ_REMOVE(&ns->registrants, reg, link);
+		free(reg);
+	}
+	spdk_poller_unregister(&ns->event_retry_poller);
+	spdk_bdev_module_release_bdev(ns->bdev);
+	spdk_bdev_close(ns->desc);
+	if (ns->ptpl_file) {
+		free(ns->ptpl_file);
+	}
+	free(ns);
+}
+
+static void
+nvmf_ns_free_on_pg(struct spdk_io_channel_iter *i)
+{
+	/* Nothing to do - reaching every poll group thread is the point */
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+nvmf_ns_free_done(struct spdk_io_channel_iter *i, int status)
+{
+	nvmf_ns_free(spdk_io_channel_iter_get_ctx(i));
+}
+
 int
 spdk_nvmf_subsystem_remove_ns(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid)
 {
 	struct spdk_nvmf_ns *ns;
-	struct spdk_nvmf_registrant *reg, *reg_tmp;
 
 	if (!(subsystem->state == SPDK_NVMF_SUBSYSTEM_INACTIVE ||
-	      subsystem->state == SPDK_NVMF_SUBSYSTEM_PAUSED)) {
+	      subsystem->state == SPDK_NVMF_SUBSYSTEM_PAUSED ||
+	      nvmf_subsystem_ns_is_paused(subsystem, nsid))) {
 		assert(false);
 		return -1;
 	}
@@ -989,27 +1150,47 @@ spdk_nvmf_subsystem_remove_ns(struct spdk_nvmf_subsystem *subsystem, uint32_t ns
 		return -1;
 	}
 
-	subsystem->ns[nsid - 1] = NULL;
-
-	TAILQ_FOREACH_SAFE(reg, &ns->registrants, link, reg_tmp) {
-		TAILQ_REMOVE(&ns->registrants, reg, link);
-		free(reg);
-	}
-	spdk_bdev_module_release_bdev(ns->bdev);
-	spdk_bdev_close(ns->desc);
-	if (ns->ptpl_file) {
-		free(ns->ptpl_file);
+	if (subsystem->state == SPDK_NVMF_SUBSYSTEM_INACTIVE ||
+	    subsystem->state == SPDK_NVMF_SUBSYSTEM_PAUSED) {
+		subsystem->ns[nsid - 1] = NULL;
+		nvmf_ns_free(ns);
+	} else {
+		/*
+		 * Only this namespace is paused, so admin commands on the poll groups
+		 * may still be looking at it. Unpublish it now and free it once every
+		 * poll group thread has been through a message since.
+		 */
+		__atomic_store_n(&subsystem->ns[nsid - 1], NULL, __ATOMIC_RELEASE);
+		spdk_for_each_channel(subsystem->tgt, nvmf_ns_free_on_pg, ns, nvmf_ns_free_done);
 	}
-	free(ns);
 
 	spdk_nvmf_subsystem_ns_changed(subsystem, nsid);
 
 	return 0;
 }
 
+static void spdk_nvmf_ns_event_retry_later(struct spdk_nvmf_ns *ns);
+
 static void
 _spdk_nvmf_ns_hot_remove(struct spdk_nvmf_subsystem *subsystem,
 			 void *cb_arg, int status)
+{
+	struct spdk_nvmf_ns *ns = cb_arg;
+	/* The namespace may be freed by the removal */
+	uint32_t nsid = ns->opts.nsid;
+	int rc;
+
+	rc = spdk_nvmf_subsystem_remove_ns(subsystem, nsid);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to make changes to NVME-oF subsystem with id: %u\n", subsystem->id);
+	}
+
+	spdk_nvmf_subsystem_resume_ns(subsystem, nsid, NULL, NULL);
+}
+
+static void
+_spdk_nvmf_ns_hot_remove_subsystem_paused(struct spdk_nvmf_subsystem *subsystem,
+		void *cb_arg, int status)
 {
 	struct spdk_nvmf_ns *ns = cb_arg;
 	int rc;
@@ -1026,12 +1207,34 @@ static void
 spdk_nvmf_ns_hot_remove(void *remove_ctx)
 {
 	struct spdk_nvmf_ns *ns = remove_ctx;
-	int rc;
+	struct spdk_nvmf_subsystem *subsystem = ns->subsystem;
 
-	rc = spdk_nvmf_subsystem_pause(ns->subsystem, _spdk_nvmf_ns_hot_remove, ns);
-	if (rc) {
-		SPDK_ERRLOG("Unable to pause subsystem to process namespace removal!\n");
+	/* The removal supersedes any resize still waiting to be processed */
+	ns->resize_pending = false;
+	ns->remove_pending = false;
+
+	if (subsystem->state == SPDK_NVMF_SUBSYSTEM_INACTIVE) {
+		/* No I/O can reach the namespace, so it can go right away */
+		if (spdk_nvmf_subsystem_remove_ns(subsystem, ns->opts.nsid)) {
+			SPDK_ERRLOG("Failed to make changes to NVME-oF subsystem with id: %u\n", subsystem->id);
+		}
+		return;
 	}
+
+	if (subsystem->state == SPDK_NVMF_SUBSYSTEM_ACTIVE) {
+		if (spdk_nvmf_subsystem_pause_ns(subsystem, ns->opts.nsid, _spdk_nvmf_ns_hot_remove, ns) == 0) {
+			return;
+		}
+
+		/* E.g. the namespace is already paused by an RPC - fall back to a subsystem pause */
+		if (spdk_nvmf_subsystem_pause(subsystem, _spdk_nvmf_ns_hot_remove_subsystem_paused, ns) == 0) {
+			return;
+		}
+	}
+
+	/* The subsystem is paused or changing state - try again once it's active */
+	ns->remove_pending = true;
+	spdk_nvmf_ns_event_retry_later(ns);
 }
 
 static void
@@ -1039,6 +1242,16 @@ _spdk_nvmf_ns_resize(struct spdk_nvmf_subsystem *subsystem, void *cb_arg, int st
 {
 	struct spdk_nvmf_ns *ns = cb_arg;
 
+	spdk_nvmf_subsystem_ns_changed(subsystem, ns->opts.nsid);
+	spdk_nvmf_subsystem_resume_ns(subsystem, ns->opts.nsid, NULL, NULL);
+}
+
+static void
+_spdk_nvmf_ns_resize_subsystem_paused(struct spdk_nvmf_subsystem *subsystem, void *cb_arg,
+				      int status)
+{
+	struct spdk_nvmf_ns *ns = cb_arg;
+
 	spdk_nvmf_subsystem_ns_changed(subsystem, ns->opts.nsid);
 	spdk_nvmf_subsystem_resume(subsystem, NULL, NULL);
 }
@@ -1047,11 +1260,58 @@ static void
 spdk_nvmf_ns_resize(void *event_ctx)
 {
 	struct spdk_nvmf_ns *ns = event_ctx;
-	int rc;
+	struct spdk_nvmf_subsystem *subsystem = ns->subsystem;
 
-	rc = spdk_nvmf_subsystem_pause(ns->subsystem, _spdk_nvmf_ns_resize, ns);
-	if (rc) {
-		SPDK_ERRLOG("Unable to pause subsystem to process namespace resize!\n");
+	ns->resize_pending = false;
+
+	if (subsystem->state == SPDK_NVMF_SUBSYSTEM_INACTIVE) {
+		spdk_nvmf_subsystem_ns_changed(subsystem, ns->opts.nsid);
+		return;
+	}
+
+	if (subsystem->state == SPDK_NVMF_SUBSYSTEM_ACTIVE) {
+		if (spdk_nvmf_subsystem_pause_ns(subsystem, ns->opts.nsid, _spdk_nvmf_ns_resize, ns) == 0) {
+			return;
+		}
+
+		if (spdk_nvmf_subsystem_pause(subsystem, _spdk_nvmf_ns_resize_subsystem_paused, ns) == 0) {
+			return;
+		}
+	}
+
+	ns->resize_pending = true;
+	spdk_nvmf_ns_event_retry_later(ns);
+}
+
+static int
+spdk_nvmf_ns_event_retry(void *ctx)
+{
+	struct spdk_nvmf_ns *ns = ctx;
+
+	spdk_poller_unregister(&ns->event_retry_poller);
+
+	if (ns->remove_pending) {
+		/* May free the namespace */
+		spdk_nvmf_ns_hot_remove(ns);
+	} else if (ns->resize_pending) {
+		spdk_nvmf_ns_resize(ns);
+	}
+
+	return 1;
+}
+
+static void
+spdk_nvmf_ns_event_retry_later(struct spdk_nvmf_ns *ns)
+{
+	if (ns->event_retry_poller != NULL) {
+		return;
+	}
+
+	ns->event_retry_poller = spdk_poller_register(spdk_nvmf_ns_event_retry, ns,
+				 NVMF_NS_EVENT_RETRY_US);
+	if (ns->event_retry_poller == NULL) {
+		SPDK_ERRLOG("Unable to pause namespace to process namespace %s!\n",
+			    ns->remove_pending ? "removal" : "resize");
 	}
 }
 
@@ -1104,11 +1364,13 @@ spdk_nvmf_subsystem_add_ns(struct spdk_nvmf_subsystem *subsystem, struct spdk_bd
 	struct spdk_nvmf_ns_opts opts;
 	struct spdk_nvmf_ns *ns;
 	struct spdk_nvmf_reservation_info info = {0};
+	bool ns_paused = false;
 	int rc;
 
 	if (!(subsystem->state == SPDK_NVMF_SUBSYSTEM_INACTIVE ||
 	      subsystem->state == SPDK_NVMF_SUBSYSTEM_PAUSED)) {
-		return 0;
+		/* Otherwise only the namespace being added may be paused */
+		ns_paused = true;
 	}
 
 	if (spdk_bdev_get_md_size(bdev) != 0 && !spdk_bdev_is_md_interleaved(bdev)) {
@@ -1130,6 +1392,10 @@ spdk_nvmf_subsystem_add_ns(struct spdk_nvmf_subsystem *subsystem, struct spdk_bd
 		return 0;
 	}
 
+	if (ns_paused && !nvmf_subsystem_ns_is_paused(subsystem, opts.nsid)) {
+		return 0;
+	}
+
 	if (opts.nsid == 0) {
 		/*
 		 * NSID not specified - find a free index.
@@ -1198,7 +1464,6 @@ spdk_nvmf_subsystem_add_ns(struct spdk_nvmf_subsystem *subsystem, struct spdk_bd
 		free(ns);
 		return 0;
 	}
-	subsystem->ns[opts.nsid - 1] = ns;
 	ns->nsid = opts.nsid;
 	TAILQ_INIT(&ns->registrants);
 
@@ -1208,7 +1473,6 @@ spdk_nvmf_subsystem_add_ns(struct spdk_nvmf_subsystem *subsystem, struct spdk_bd
 			rc = nvmf_ns_reservation_restore(ns, &info);
 			if (rc) {
 				SPDK_ERRLOG("Subsystem restore reservation failed\n");
-				subsystem->ns[opts.nsid - 1] = NULL;
 				spdk_bdev_close(ns->desc);
 				free(ns);
 				return 0;
@@ -1217,6 +1481,12 @@ spdk_nvmf_subsystem_add_ns(struct spdk_nvmf_subsystem *subsystem, struct spdk_bd
 		ns->ptpl_file = strdup(ptpl_file);
 	}
 
+	/*
+	 * Publish the namespace only once it is fully set up, the poll groups may
+	 * look it up concurrently when just the namespace is paused.
+	 */
+	__atomic_store_n(&subsystem->ns[opts.nsid - 1], ns, __ATOMIC_RELEASE);
+
 	SPDK_DEBUGLOG(SPDK_LOG_NVMF, "Subsystem %s: bdev %s assigned nsid %" PRIu32 "\n",
 		      spdk_nvmf_subsystem_get_nqn(subsystem),
 		      spdk_bdev_get_name(bdev),
@@ -47,6 +47,9 @@
 #include "spdk_internal/nvme_tcp.h"
 
 #define NVMF_TCP_MAX_ACCEPT_SOCK_ONE_TIME 16
+#define NVMF_TCP_MIN_C2H_DATA_SIZE 4096
+/* Maximum number of C2H data PDUs the data of a single request is split into */
+#define NVMF_TCP_MAX_C2H_DATA_PDUS 4
 #define SPDK_NVMF_TCP_DEFAULT_MAX_SOCK_PRIORITY 6
 #define SPDK_NVMF_TCP_RECV_BUF_SIZE_FACTOR 4
 
@@ -168,7 +171,9 @@ struct spdk_nvmf_tcp_req  {
 	struct spdk_nvme_cmd			cmd;
 
 	/* A PDU that can be used for sending responses. This is
-	 * not the incoming PDU! */
+	 * not the incoming PDU! It's the first of the qpair's
+	 * c2h_data_pdus PDUs reserved for the request, the rest
+	 * of them are only used for sending the split C2H data. */
 	struct nvme_tcp_pdu			*pdu;
 
 	/*
@@ -194,6 +199,12 @@ struct spdk_nvmf_tcp_req  {
 	 */
 	uint32_t				h2c_offset;
 
+	/*
+	 * c2h_offset is the offset of the next c2h_data PDU when the
+	 * data is sent in more than one PDU.
+	 */
+	uint32_t				c2h_offset;
+
 	STAILQ_ENTRY(spdk_nvmf_tcp_req)		link;
 	TAILQ_ENTRY(spdk_nvmf_tcp_req)		state_link;
 };
@@ -217,6 +228,19 @@ struct spdk_nvmf_tcp_qpair {
 
 	TAILQ_HEAD(, nvme_tcp_pdu)		send_queue;
 
+	/* PDUs built during the current poll. They are handed to the socket
+	 * together at the end of the poll, so that they go out in one send. */
+	TAILQ_HEAD(, nvme_tcp_pdu)		send_pending;
+	bool					send_batching;
+	bool					send_linked;
+	TAILQ_ENTRY(spdk_nvmf_tcp_qpair)	send_link;
+
+	/* Maximum amount of data in a single c2h_data PDU */
+	uint32_t				maxc2hdata;
+
+	/* Number of c2h_data PDUs needed for the largest request */
+	uint32_t				c2h_data_pdus;
+
 	/* Arrays of in-capsule buffers, requests, and pdus.
 	 * Each array is 'resource_count' number of elements */
 	void					*bufs;
@@ -250,12 +274,31 @@ struct spdk_nvmf_tcp_qpair {
 	TAILQ_ENTRY(spdk_nvmf_tcp_qpair)	link;
 };
 
+struct spdk_nvmf_tcp_poll_group_stat {
+	/* Connections placed on the poll group serving their NIC receive queue */
+	uint64_t				placement_hits;
+	/* Connections whose NIC receive queue is served by another poll group */
+	uint64_t				placement_misses;
+	/* Connections without a NIC receive queue (NAPI) ID */
+	uint64_t				no_placement_id;
+	/* PDUs sent and the number of qpair flushes that sent data */
+	uint64_t				pdus_sent;
+	uint64_t				sends;
+};
+
 struct spdk_nvmf_tcp_poll_group {
 	struct spdk_nvmf_transport_poll_group	group;
 	struct spdk_sock_group			*sock_group;
 
 	TAILQ_HEAD(, spdk_nvmf_tcp_qpair)	qpairs;
 	TAILQ_HEAD(, spdk_nvmf_tcp_qpair)	await_req;
+
+	/* Qpairs with PDUs waiting to be sent at the end of the poll */
+	TAILQ_HEAD(, spdk_nvmf_tcp_qpair)	send_pending;
+
+	struct spdk_nvmf_tcp_poll_group_stat	stat;
+
+	TAILQ_ENTRY(spdk_nvmf_tcp_poll_group)	link;
 };
 
 struct spdk_nvmf_tcp_port {
@@ -270,6 +313,10 @@ struct spdk_nvmf_tcp_transport {
 	pthread_mutex_t				lock;
 
 	TAILQ_HEAD(, spdk_nvmf_tcp_port)	ports;
+
+	/* Poll groups to assign NIC receive queues to, round robin */
+	TAILQ_HEAD(, spdk_nvmf_tcp_poll_group)	poll_groups;
+	struct spdk_nvmf_tcp_poll_group		*next_pg;
 };
 
 static bool spdk_nvmf_tcp_req_process(struct spdk_nvmf_tcp_transport *ttransport,
@@ -325,6 +372,7 @@ spdk_nvmf_tcp_req_get(struct spdk_nvmf_tcp_qpair *tqpair)
 
 	memset(&tcp_req->rsp, 0, sizeof(tcp_req->rsp));
 	tcp_req->h2c_offset = 0;
+	tcp_req->c2h_offset = 0;
 	tcp_req->has_incapsule_data = false;
 	tcp_req->req.dif.dif_insert_or_strip = false;
 
@@ -461,6 +509,7 @@ spdk_nvmf_tcp_create(struct spdk_nvmf_transport_opts *opts)
 	}
 
 	TAILQ_INIT(&ttransport->ports);
+	TAILQ_INIT(&ttransport->poll_groups);
 
 	ttransport->transport.ops = &spdk_nvmf_transport_tcp;
 
@@ -471,7 +520,8 @@ spdk_nvmf_tcp_create(struct spdk_nvmf_transport_opts *opts)
 		     "  max_qpairs_per_ctrlr=%d, io_unit_size=%d,\n"
 		     "  in_capsule_data_size=%d, max_aq_depth=%d\n"
 		     "  num_shared_buffers=%d, c2h_success=%d,\n"
-		     "  dif_insert_or_strip=%d, sock_priority=%d\n",
+		     "  dif_insert_or_strip=%d, sock_priority=%d,\n"
+		     "  sock_busy_poll=%d\n",
 		     opts->max_queue_depth,
 		     opts->max_io_size,
 		     opts->max_qpairs_per_ctrlr,
@@ -481,7 +531,8 @@ spdk_nvmf_tcp_create(struct spdk_nvmf_transport_opts *opts)
 		     opts->num_shared_buffers,
 		     opts->c2h_success,
 		     opts->dif_insert_or_strip,
-		     opts->sock_priority);
+		     opts->sock_priority,
+		     opts->sock_busy_poll);
 
 	if (opts->sock_priority > SPDK_NVMF_TCP_DEFAULT_MAX_SOCK_PRIORITY) {
 		SPDK_ERRLOG("Unsupported socket_priority=%d, the current range is: 0 to %d\n"
@@ -704,6 +755,41 @@ _pdu_write_done(void *_pdu, int err)
 	pdu->cb_fn(pdu->cb_arg);
 }
 
+static void
+spdk_nvmf_tcp_qpair_flush_pdus(struct spdk_nvmf_tcp_qpair *tqpair)
+{
+	struct spdk_nvmf_tcp_poll_group	*tgroup = tqpair->group;
+	struct nvme_tcp_pdu		*pdu;
+	uint64_t			count = 0;
+
+	if (tqpair->send_linked) {
+		TAILQ_REMOVE(&tgroup->send_pending, tqpair, send_link);
+		tqpair->send_linked = false;
+	}
+
+	while (!TAILQ_EMPTY(&tqpair->send_pending)) {
+		pdu = TAILQ_FIRST(&tqpair->send_pending);
+		TAILQ_REMOVE(&tqpair->send_pending, pdu, tailq);
+		TAILQ_INSERT_TAIL(&tqpair->send_queue, pdu, tailq);
+		spdk_sock_writev_async(tqpair->sock, &pdu->sock_req);
+		count++;
+	}
+
+	if (count == 0) {
+		return;
+	}
+
+	tgroup->stat.pdus_sent += count;
+
+	/* Errors are handled when the socket group is polled next. Nothing may be
+	 * sent yet if the socket is full, or if the socket implementation writes
+	 * from its group poll, then the group poll sends the PDUs later.
+	 */
+	if (spdk_sock_flush(tqpair->sock) > 0) {
+		tgroup->stat.sends++;
+	}
+}
+
 static void
 spdk_nvmf_tcp_qpair_write_pdu(struct spdk_nvmf_tcp_qpair *tqpair,
 			      struct nvme_tcp_pdu *pdu,
@@ -739,9 +825,13 @@ spdk_nvmf_tcp_qpair_write_pdu(struct spdk_nvmf_tcp_qpair *tqpair,
 			       &mapped_length);
 	pdu->sock_req.cb_fn = _pdu_write_done;
 	pdu->sock_req.cb_arg = pdu;
-	TAILQ_INSERT_TAIL(&tqpair->send_queue, pdu, tailq);
 	if (pdu->hdr.common.pdu_type == SPDK_NVME_TCP_PDU_TYPE_IC_RESP ||
 	    pdu->hdr.common.pdu_type == SPDK_NVME_TCP_PDU_TYPE_C2H_TERM_REQ) {
+		/* Send the PDUs built so far ahead of this one */
+		if (tqpair->send_batching) {
+			spdk_nvmf_tcp_qpair_flush_pdus(tqpair);
+		}
+		TAILQ_INSERT_TAIL(&tqpair->send_queue, pdu, tailq);
 		rc = spdk_sock_writev(tqpair->sock, pdu->iov, pdu->sock_req.iovcnt);
 		if (rc == mapped_length) {
 			_pdu_write_done(pdu, 0);
@@ -749,7 +839,14 @@ spdk_nvmf_tcp_qpair_write_pdu(struct spdk_nvmf_tcp_qpair *tqpair,
 			SPDK_ERRLOG("IC_RESP or TERM_REQ could not write to socket.\n");
 			_pdu_write_done(pdu, -1);
 		}
+	} else if (tqpair->send_batching) {
+		TAILQ_INSERT_TAIL(&tqpair->send_pending, pdu, tailq);
+		if (!tqpair->send_linked) {
+			TAILQ_INSERT_TAIL(&tqpair->group->send_pending, tqpair, send_link);
+			tqpair->send_linked = true;
+		}
 	} else {
+		TAILQ_INSERT_TAIL(&tqpair->send_queue, pdu, tailq);
 		spdk_sock_writev_async(tqpair->sock, &pdu->sock_req);
 	}
 }
@@ -788,20 +885,25 @@ spdk_nvmf_tcp_qpair_init_mem_resource(struct spdk_nvmf_tcp_qpair *tqpair)
 		}
 	}
 
-	tqpair->pdus = spdk_dma_malloc(tqpair->resource_count * sizeof(*tqpair->pdus), 0x1000, NULL);
+	/* All of the C2H data PDUs of a request are queued at once */
+	tqpair->pdus = spdk_dma_malloc(tqpair->resource_count * tqpair->c2h_data_pdus *
+				       sizeof(*tqpair->pdus), 0x1000, NULL);
 	if (!tqpair->pdus) {
 		SPDK_ERRLOG("Unable to allocate pdu pool on tqpair =%p.\n", tqpair);
 		return -1;
 	}
 
+	for (i = 0; i < tqpair->resource_count * tqpair->c2h_data_pdus; i++) {
+		tqpair->pdus[i].qpair = tqpair;
+	}
+
 	for (i = 0; i < tqpair->resource_count; i++) {
 		struct spdk_nvmf_tcp_req *tcp_req = &tqpair->reqs[i];
 
 		tcp_req->ttag = i + 1;
 		tcp_req->req.qpair = &tqpair->qpair;
 
-		tcp_req->pdu = &tqpair->pdus[i];
-		tcp_req->pdu->qpair = tqpair;
+		tcp_req->pdu = &tqpair->pdus[i * tqpair->c2h_data_pdus];
 
 		/* Set up memory to receive commands */
 		if (tqpair->bufs) {
@@ -832,6 +934,7 @@ spdk_nvmf_tcp_qpair_init(struct spdk_nvmf_qpair *qpair)
 	SPDK_DEBUGLOG(SPDK_LOG_NVMF_TCP, "New TCP Connection: %p\n", qpair);
 
 	TAILQ_INIT(&tqpair->send_queue);
+	TAILQ_INIT(&tqpair->send_pending);
 
 	/* Initialise request state queues of the qpair */
 	for (i = TCP_REQUEST_STATE_FREE; i < TCP_REQUEST_NUM_STATES; i++) {
@@ -847,6 +950,8 @@ spdk_nvmf_tcp_qpair_init(struct spdk_nvmf_qpair *qpair)
 static int
 spdk_nvmf_tcp_qpair_sock_init(struct spdk_nvmf_tcp_qpair *tqpair)
 {
+	uint32_t chunk, max_io_size;
+	int sndbuf;
 	int rc;
 
 	/* set low water mark */
@@ -856,6 +961,30 @@ spdk_nvmf_tcp_qpair_sock_init(struct spdk_nvmf_tcp_qpair *tqpair)
 		return rc;
 	}
 
+	if (tqpair->qpair.transport->opts.sock_busy_poll) {
+		/* Not fatal, e.g. raising it above net.core.busy_read needs CAP_NET_ADMIN */
+		rc = spdk_sock_set_busy_poll(tqpair->sock, tqpair->qpair.transport->opts.sock_busy_poll);
+		if (rc != 0) {
+			SPDK_WARNLOG("Failed to enable busy polling for tqpair=%p (errno=%d)\n", tqpair, errno);
+		}
+	}
+
+	/* Split the C2H data so that two PDUs fit into the send buffer. The kernel
+	 * can then take the next PDU while the previous one is still being sent.
+	 * Each request needs a PDU per chunk, so their number is limited. */
+	max_io_size = tqpair->qpair.transport->opts.max_io_size;
+	tqpair->maxc2hdata = max_io_size;
+	if (spdk_sock_get_sendbuf(tqpair->sock, &sndbuf) == 0 && sndbuf > 0) {
+		chunk = SPDK_ALIGN_FLOOR((uint32_t)sndbuf / 2, NVMF_TCP_MIN_C2H_DATA_SIZE);
+		chunk = spdk_max(chunk, NVMF_TCP_MIN_C2H_DATA_SIZE);
+		chunk = spdk_max(chunk, SPDK_ALIGN_CEIL(spdk_divide_round_up(max_io_size,
+				 NVMF_TCP_MAX_C2H_DATA_PDUS), NVMF_TCP_MIN_C2H_DATA_SIZE));
+		tqpair->maxc2hdata = spdk_min(tqpair->maxc2hdata, chunk);
+	}
+	tqpair->c2h_data_pdus = spdk_max(spdk_divide_round_up(max_io_size, tqpair->maxc2hdata), 1);
+	SPDK_DEBUGLOG(SPDK_LOG_NVMF_TCP, "tqpair=%p maxc2hdata=%u c2h_data_pdus=%u\n", tqpair,
+		      tqpair->maxc2hdata, tqpair->c2h_data_pdus);
+
 	return 0;
 }
 
@@ -952,8 +1081,11 @@ spdk_nvmf_tcp_discover(struct spdk_nvmf_transport *transport,
 static struct spdk_nvmf_transport_poll_group *
 spdk_nvmf_tcp_poll_group_create(struct spdk_nvmf_transport *transport)
 {
+	struct spdk_nvmf_tcp_transport *ttransport;
 	struct spdk_nvmf_tcp_poll_group *tgroup;
 
+	ttransport = SPDK_CONTAINEROF(transport, struct spdk_nvmf_tcp_transport, transport);
+
 	tgroup = calloc(1, sizeof(*tgroup));
 	if (!tgroup) {
 		return NULL;
@@ -966,6 +1098,14 @@ spdk_nvmf_tcp_poll_group_create(struct spdk_nvmf_transport *transport)
 
 	TAILQ_INIT(&tgroup->qpairs);
 	TAILQ_INIT(&tgroup->await_req);
+	TAILQ_INIT(&tgroup->send_pending);
+
+	pthread_mutex_lock(&ttransport->lock);
+	TAILQ_INSERT_TAIL(&ttransport->poll_groups, tgroup, link);
+	if (ttransport->next_pg == NULL) {
+		ttransport->next_pg = tgroup;
+	}
+	pthread_mutex_unlock(&ttransport->lock);
 
 	return &tgroup->group;
 
@@ -974,15 +1114,36 @@ cleanup:
 	return NULL;
 }
 
+/*
+ * Connections receiving on the same NIC receive queue go to the same poll group,
+ * so that the core polling the queue in the kernel also processes the connections.
+ * The first connection on a queue assigns it to the next poll group round robin.
+ * Connections without a placement ID are left to the generic scheduling.
+ */
 static struct spdk_nvmf_transport_poll_group *
 spdk_nvmf_tcp_get_optimal_poll_group(struct spdk_nvmf_qpair *qpair)
 {
+	struct spdk_nvmf_tcp_transport *ttransport;
 	struct spdk_nvmf_tcp_qpair *tqpair;
+	struct spdk_nvmf_tcp_poll_group *hint;
 	struct spdk_sock_group *group = NULL;
 	int rc;
 
+	ttransport = SPDK_CONTAINEROF(qpair->transport, struct spdk_nvmf_tcp_transport, transport);
 	tqpair = SPDK_CONTAINEROF(qpair, struct spdk_nvmf_tcp_qpair, qpair);
-	rc = spdk_sock_get_optimal_sock_group(tqpair->sock, &group);
+
+	pthread_mutex_lock(&ttransport->lock);
+	hint = ttransport->next_pg;
+	rc = spdk_sock_get_optimal_sock_group(tqpair->sock, &group,
+					      hint != NULL ? hint->sock_group : NULL);
+	if (!rc && group != NULL && group == hint->sock_group) {
+		ttransport->next_pg = TAILQ_NEXT(hint, link);
+		if (ttransport->next_pg == NULL) {
+			ttransport->next_pg = TAILQ_FIRST(&ttransport->poll_groups);
+		}
+	}
+	pthread_mutex_unlock(&ttransport->lock);
+
 	if (!rc && group != NULL) {
 		return spdk_sock_group_get_ctx(group);
 	}
@@ -993,9 +1154,22 @@ spdk_nvmf_tcp_get_optimal_poll_group(struct spdk_nvmf_qpair *qpair)
 static void
 spdk_nvmf_tcp_poll_group_destroy(struct spdk_nvmf_transport_poll_group *group)
 {
+	struct spdk_nvmf_tcp_transport *ttransport;
 	struct spdk_nvmf_tcp_poll_group *tgroup;
 
 	tgroup = SPDK_CONTAINEROF(group, struct spdk_nvmf_tcp_poll_group, group);
+	ttransport = SPDK_CONTAINEROF(group->transport, struct spdk_nvmf_tcp_transport, transport);
+
+	pthread_mutex_lock(&ttransport->lock);
+	if (ttransport->next_pg == tgroup) {
+		ttransport->next_pg = TAILQ_NEXT(tgroup, link);
+	}
+	TAILQ_REMOVE(&ttransport->poll_groups, tgroup, link);
+	if (ttransport->next_pg == NULL) {
+		ttransport->next_pg = TAILQ_FIRST(&ttransport->poll_groups);
+	}
+	pthread_mutex_unlock(&ttransport->lock);
+
 	spdk_sock_group_close(&tgroup->sock_group);
 
 	free(tgroup);
@@ -1278,15 +1452,23 @@ spdk_nvmf_tcp_send_capsule_resp_pdu(struct spdk_nvmf_tcp_req *tcp_req,
 	spdk_nvmf_tcp_qpair_write_pdu(tqpair, rsp_pdu, spdk_nvmf_tcp_pdu_cmd_complete, tcp_req);
 }
 
+static void
+spdk_nvmf_tcp_pdu_c2h_data_sent(void *cb_arg)
+{
+	/* Nothing to do, the request is completed once its last PDU is sent */
+}
+
 static void
 spdk_nvmf_tcp_pdu_c2h_data_complete(void *cb_arg)
 {
-	struct spdk_nvmf_tcp_req *tcp_req = cb_arg;
+	struct nvme_tcp_pdu *pdu = cb_arg;
+	struct spdk_nvmf_tcp_req *tcp_req = pdu->req;
 	struct spdk_nvmf_tcp_qpair *tqpair = SPDK_CONTAINEROF(tcp_req->req.qpair,
 					     struct spdk_nvmf_tcp_qpair, qpair);
 
 	assert(tqpair != NULL);
-	if (tqpair->qpair.transport->opts.c2h_success) {
+	assert(pdu->hdr.c2h_data.common.flags & SPDK_NVME_TCP_C2H_DATA_FLAGS_LAST_PDU);
+	if (pdu->hdr.c2h_data.common.flags & SPDK_NVME_TCP_C2H_DATA_FLAGS_SUCCESS) {
 		nvmf_tcp_request_free(tcp_req);
 	} else {
 		nvmf_tcp_req_pdu_fini(tcp_req);
@@ -1922,20 +2104,31 @@ nvmf_tcp_dif_error_to_compl_status(uint8_t err_type) {
 	return result;
 }
 
-static void
-spdk_nvmf_tcp_send_c2h_data(struct spdk_nvmf_tcp_qpair *tqpair,
-			    struct spdk_nvmf_tcp_req *tcp_req)
+/*
+ * The SUCCESS flag stands in for the capsule response, so it can only be set
+ * when the response carries nothing but a successful status.
+ */
+static bool
+nvmf_tcp_req_c2h_success_allowed(struct spdk_nvmf_tcp_qpair *tqpair,
+				 struct spdk_nvmf_tcp_req *tcp_req)
+{
+	struct spdk_nvme_cpl *rsp = &tcp_req->req.rsp->nvme_cpl;
+
+	return tqpair->qpair.transport->opts.c2h_success &&
+	       rsp->status.sct == SPDK_NVME_SCT_GENERIC &&
+	       rsp->status.sc == SPDK_NVME_SC_SUCCESS &&
+	       rsp->cdw0 == 0 && rsp->rsvd1 == 0;
+}
+
+static int
+nvmf_tcp_build_c2h_data_pdu(struct spdk_nvmf_tcp_qpair *tqpair,
+			    struct spdk_nvmf_tcp_req *tcp_req,
+			    struct nvme_tcp_pdu *rsp_pdu)
 {
-	struct nvme_tcp_pdu *rsp_pdu;
 	struct spdk_nvme_tcp_c2h_data_hdr *c2h_data;
 	uint32_t plen, pdo, alignment;
 	int rc;
 
-	SPDK_DEBUGLOG(SPDK_LOG_NVMF_TCP, "enter\n");
-
-	rsp_pdu = nvmf_tcp_req_pdu_init(tcp_req);
-	assert(rsp_pdu != NULL);
-
 	c2h_data = &rsp_pdu->hdr.c2h_data;
 	c2h_data->common.pdu_type = SPDK_NVME_TCP_PDU_TYPE_C2H_DATA;
 	plen = c2h_data->common.hlen = sizeof(*c2h_data);
@@ -1947,8 +2140,12 @@ spdk_nvmf_tcp_send_c2h_data(struct spdk_nvmf_tcp_qpair *tqpair,
 
 	/* set the psh */
 	c2h_data->cccid = tcp_req->req.cmd->nvme_cmd.cid;
-	c2h_data->datal = tcp_req->req.length;
-	c2h_data->datao = 0;
+	c2h_data->datao = tcp_req->c2h_offset;
+	c2h_data->datal = tcp_req->req.length - tcp_req->c2h_offset;
+	/* DIF is verified over the whole transfer, so it's sent in a single PDU */
+	if (spdk_likely(!tcp_req->req.dif.dif_insert_or_strip)) {
+		c2h_data->datal = spdk_min(c2h_data->datal, tqpair->maxc2hdata);
+	}
 
 	/* set the padding */
 	rsp_pdu->padding_len = 0;
@@ -1988,18 +2185,61 @@ spdk_nvmf_tcp_send_c2h_data(struct spdk_nvmf_tcp_qpair *tqpair,
 				    err_blk.err_type, err_blk.err_offset);
 			rsp->status.sct = SPDK_NVME_SCT_MEDIA_ERROR;
 			rsp->status.sc = nvmf_tcp_dif_error_to_compl_status(err_blk.err_type);
+			return rc;
+		}
+	}
+
+	tcp_req->c2h_offset += c2h_data->datal;
+	if (tcp_req->c2h_offset == tcp_req->req.length) {
+		c2h_data->common.flags |= SPDK_NVME_TCP_C2H_DATA_FLAGS_LAST_PDU;
+		if (nvmf_tcp_req_c2h_success_allowed(tqpair, tcp_req)) {
+			c2h_data->common.flags |= SPDK_NVME_TCP_C2H_DATA_FLAGS_SUCCESS;
+		}
+	}
+
+	return 0;
+}
+
+static void
+spdk_nvmf_tcp_send_c2h_data(struct spdk_nvmf_tcp_qpair *tqpair,
+			    struct spdk_nvmf_tcp_req *tcp_req)
+{
+	struct nvme_tcp_pdu *rsp_pdu;
+	uint32_t i, num_pdus = 0;
+
+	SPDK_DEBUGLOG(SPDK_LOG_NVMF_TCP, "enter\n");
+
+	rsp_pdu = nvmf_tcp_req_pdu_init(tcp_req);
+	assert(rsp_pdu != NULL);
+
+	/* Build all of the PDUs up front, so that the whole data is queued at once
+	 * instead of waiting for each PDU to be sent before building the next one */
+	while (true) {
+		assert(num_pdus < tqpair->c2h_data_pdus);
+
+		if (nvmf_tcp_build_c2h_data_pdu(tqpair, tcp_req, rsp_pdu) != 0) {
 			nvmf_tcp_req_pdu_fini(tcp_req);
 			spdk_nvmf_tcp_send_capsule_resp_pdu(tcp_req, tqpair);
 			return;
 		}
+
+		num_pdus++;
+		if (tcp_req->c2h_offset == tcp_req->req.length) {
+			break;
+		}
+
+		rsp_pdu = &tcp_req->pdu[num_pdus];
+		memset(rsp_pdu, 0, sizeof(*rsp_pdu));
+		rsp_pdu->qpair = tqpair;
 	}
 
-	c2h_data->common.flags |= SPDK_NVME_TCP_C2H_DATA_FLAGS_LAST_PDU;
-	if (tqpair->qpair.transport->opts.c2h_success) {
-		c2h_data->common.flags |= SPDK_NVME_TCP_C2H_DATA_FLAGS_SUCCESS;
+	for (i = 0; i < num_pdus - 1; i++) {
+		spdk_nvmf_tcp_qpair_write_pdu(tqpair, &tcp_req->pdu[i], spdk_nvmf_tcp_pdu_c2h_data_sent,
+					      NULL);
 	}
 
-	spdk_nvmf_tcp_qpair_write_pdu(tqpair, rsp_pdu, spdk_nvmf_tcp_pdu_c2h_data_complete, tcp_req);
+	rsp_pdu->req = tcp_req;
+	spdk_nvmf_tcp_qpair_write_pdu(tqpair, rsp_pdu, spdk_nvmf_tcp_pdu_c2h_data_complete, rsp_pdu);
 }
 
 static int
@@ -2257,6 +2497,23 @@ spdk_nvmf_tcp_sock_cb(void *arg, struct spdk_sock_group *group, struct spdk_sock
 	}
 }
 
+static void
+spdk_nvmf_tcp_poll_group_count_placement(struct spdk_nvmf_tcp_poll_group *tgroup,
+		struct spdk_nvmf_tcp_qpair *tqpair)
+{
+	struct spdk_sock_group *group = NULL;
+	int rc;
+
+	rc = spdk_sock_get_optimal_sock_group(tqpair->sock, &group, NULL);
+	if (rc != 0) {
+		tgroup->stat.no_placement_id++;
+	} else if (group == NULL || group == tgroup->sock_group) {
+		tgroup->stat.placement_hits++;
+	} else {
+		tgroup->stat.placement_misses++;
+	}
+}
+
 static int
 spdk_nvmf_tcp_poll_group_add(struct spdk_nvmf_transport_poll_group *group,
 			     struct spdk_nvmf_qpair *qpair)
@@ -2268,6 +2525,8 @@ spdk_nvmf_tcp_poll_group_add(struct spdk_nvmf_transport_poll_group *group,
 	tgroup = SPDK_CONTAINEROF(group, struct spdk_nvmf_tcp_poll_group, group);
 	tqpair = SPDK_CONTAINEROF(qpair, struct spdk_nvmf_tcp_qpair, qpair);
 
+	spdk_nvmf_tcp_poll_group_count_placement(tgroup, tqpair);
+
 	rc = spdk_sock_group_add_sock(tgroup->sock_group, tqpair->sock,
 				      spdk_nvmf_tcp_sock_cb, tqpair);
 	if (rc != 0) {
@@ -2295,6 +2554,7 @@ spdk_nvmf_tcp_poll_group_add(struct spdk_nvmf_transport_poll_group *group,
 	}
 
 	tqpair->group = tgroup;
+	tqpair->send_batching = true;
 	tqpair->state = NVME_TCP_QPAIR_STATE_INVALID;
 	TAILQ_INSERT_TAIL(&tgroup->qpairs, tqpair, link);
 
@@ -2321,6 +2581,10 @@ spdk_nvmf_tcp_poll_group_remove(struct spdk_nvmf_transport_poll_group *group,
 		TAILQ_REMOVE(&tgroup->qpairs, tqpair, link);
 	}
 
+	/* Nothing polls the qpair from now on, so send what's left right away */
+	spdk_nvmf_tcp_qpair_flush_pdus(tqpair);
+	tqpair->send_batching = false;
+
 	rc = spdk_sock_group_remove_sock(tgroup->sock_group, tqpair->sock);
 	if (rc != 0) {
 		SPDK_ERRLOG("Could not remove sock from sock_group: %s (%d)\n",
@@ -2390,6 +2654,11 @@ spdk_nvmf_tcp_poll_group_poll(struct spdk_nvmf_transport_poll_group *group)
 		spdk_nvmf_tcp_sock_process(tqpair);
 	}
 
+	/* Flush the PDUs built during this poll, each qpair's PDUs with a single flush */
+	while (!TAILQ_EMPTY(&tgroup->send_pending)) {
+		spdk_nvmf_tcp_qpair_flush_pdus(TAILQ_FIRST(&tgroup->send_pending));
+	}
+
 	return rc;
 }
 
@@ -2444,6 +2713,49 @@ spdk_nvmf_tcp_qpair_get_listen_trid(struct spdk_nvmf_qpair *qpair,
 	return spdk_nvmf_tcp_qpair_get_trid(qpair, trid, 0);
 }
 
+static int
+spdk_nvmf_tcp_poll_group_get_stat(struct spdk_nvmf_tgt *tgt,
+				  struct spdk_nvmf_transport_poll_group_stat **stat)
+{
+	struct spdk_io_channel *ch;
+	struct spdk_nvmf_poll_group *group;
+	struct spdk_nvmf_transport_poll_group *tgroup;
+	struct spdk_nvmf_tcp_poll_group *ttgroup;
+
+	if (tgt == NULL || stat == NULL) {
+		return -EINVAL;
+	}
+
+	ch = spdk_get_io_channel(tgt);
+	group = spdk_io_channel_get_ctx(ch);
+	spdk_put_io_channel(ch);
+	TAILQ_FOREACH(tgroup, &group->tgroups, link) {
+		if (SPDK_NVME_TRANSPORT_TCP == tgroup->transport->ops->type) {
+			*stat = calloc(1, sizeof(struct spdk_nvmf_transport_poll_group_stat));
+			if (!*stat) {
+				SPDK_ERRLOG("Failed to allocate memory for NVMf TCP statistics\n");
+				return -ENOMEM;
+			}
+			(*stat)->trtype = SPDK_NVME_TRANSPORT_TCP;
+
+			ttgroup = SPDK_CONTAINEROF(tgroup, struct spdk_nvmf_tcp_poll_group, group);
+			(*stat)->tcp.placement_hits = ttgroup->stat.placement_hits;
+			(*stat)->tcp.placement_misses = ttgroup->stat.placement_misses;
+			(*stat)->tcp.no_placement_id = ttgroup->stat.no_placement_id;
+			(*stat)->tcp.pdus_sent = ttgroup->stat.pdus_sent;
+			(*stat)->tcp.sends = ttgroup->stat.sends;
+			return 0;
+		}
+	}
+	return -ENOENT;
+}
+
+static void
+spdk_nvmf_tcp_poll_group_free_stat(struct spdk_nvmf_transport_poll_group_stat *stat)
+{
+	free(stat);
+}
+
 #define SPDK_NVMF_TCP_DEFAULT_MAX_QUEUE_DEPTH 128
 #define SPDK_NVMF_TCP_DEFAULT_AQ_DEPTH 128
 #define SPDK_NVMF_TCP_DEFAULT_MAX_QPAIRS_PER_CTRLR 128
@@ -2455,6 +2767,7 @@ spdk_nvmf_tcp_qpair_get_listen_trid(struct spdk_nvmf_qpair *qpair,
 #define SPDK_NVMF_TCP_DEFAULT_SUCCESS_OPTIMIZATION true
 #define SPDK_NVMF_TCP_DEFAULT_DIF_INSERT_OR_STRIP false
 #define SPDK_NVMF_TCP_DEFAULT_SOCK_PRIORITY 0
+#define SPDK_NVMF_TCP_DEFAULT_SOCK_BUSY_POLL 0
 
 static void
 spdk_nvmf_tcp_opts_init(struct spdk_nvmf_transport_opts *opts)
@@ -2470,6 +2783,7 @@ spdk_nvmf_tcp_opts_init(struct spdk_nvmf_transport_opts *opts)
 	opts->c2h_success =		SPDK_NVMF_TCP_DEFAULT_SUCCESS_OPTIMIZATION;
 	opts->dif_insert_or_strip =	SPDK_NVMF_TCP_DEFAULT_DIF_INSERT_OR_STRIP;
 	opts->sock_priority =		SPDK_NVMF_TCP_DEFAULT_SOCK_PRIORITY;
+	opts->sock_busy_poll =		SPDK_NVMF_TCP_DEFAULT_SOCK_BUSY_POLL;
 }
 
 const struct spdk_nvmf_transport_ops spdk_nvmf_transport_tcp = {
@@ -2499,6 +2813,9 @@ const struct spdk_nvmf_transport_ops spdk_nvmf_transport_tcp = {
 	.qpair_get_local_trid = spdk_nvmf_tcp_qpair_get_local_trid,
 	.qpair_get_peer_trid = spdk_nvmf_tcp_qpair_get_peer_trid,
 	.qpair_get_listen_trid = spdk_nvmf_tcp_qpair_get_listen_trid,
+
+	.poll_group_get_stat = spdk_nvmf_tcp_poll_group_get_stat,
+	.poll_group_free_stat = spdk_nvmf_tcp_poll_group_free_stat,
 };
 
 SPDK_NVMF_TRANSPORT_REGISTER(tcp, &spdk_nvmf_transport_tcp);
@@ -56,7 +56,7 @@
 struct spdk_reduce_vol_superblock {
 	uint8_t				signature[8];
 	struct spdk_reduce_vol_params	params;
-	uint8_t				reserved[4048];
+	uint8_t				reserved[4040];
 };
 SPDK_STATIC_ASSERT(sizeof(struct spdk_reduce_vol_superblock) == 4096, "size incorrect");
 
@@ -137,6 +137,27 @@ struct spdk_reduce_vol_request {
 	struct spdk_reduce_vol_cb_args		backing_cb_args;
 };
 
+/**
+ * Decompressed copy of one chunk, keyed by its logical map index.  Unused
+ *  entries have a logical_map_index of REDUCE_EMPTY_MAP_ENTRY and sit at the
+ *  tail of the LRU list, so they are always picked before any valid entry.
+ */
+struct reduce_chunk_cache_entry {
+	uint64_t				logical_map_index;
+	uint8_t					*buf;
+	TAILQ_ENTRY(reduce_chunk_cache_entry)	lru;
+	LIST_ENTRY(reduce_chunk_cache_entry)	hash;
+};
+
+struct reduce_chunk_cache {
+	struct reduce_chunk_cache_entry		*entries;
+	uint8_t					*buf_mem;
+	uint32_t				num_entries;
+	uint32_t				hash_mask;
+	LIST_HEAD(, reduce_chunk_cache_entry)	*buckets;
+	TAILQ_HEAD(reduce_chunk_cache_lru, reduce_chunk_cache_entry)	lru;
+};
+
 struct spdk_reduce_vol {
 	struct spdk_reduce_vol_params		params;
 	uint32_t				backing_io_units_per_chunk;
@@ -160,6 +181,9 @@ struct spdk_reduce_vol {
 	/* Single contiguous buffer used for all request buffers for this volume. */
 	uint8_t					*buf_mem;
 	struct iovec				*buf_iov_mem;
+
+	/* LRU cache of decompressed chunks, disabled when num_entries == 0. */
+	struct reduce_chunk_cache		chunk_cache;
 };
 
 static void _start_readv_request(struct spdk_reduce_vol_request *req);
@@ -379,6 +403,114 @@ _allocate_vol_requests(struct spdk_reduce_vol *vol)
 	return 0;
 }
 
+static void
+_chunk_cache_free(struct reduce_chunk_cache *cache)
+{
+	free(cache->entries);
+	free(cache->buckets);
+	free(cache->buf_mem);
+	memset(cache, 0, sizeof(*cache));
+}
+
+static int
+_chunk_cache_alloc(struct spdk_reduce_vol *vol, uint32_t num_entries)
+{
+	struct reduce_chunk_cache *cache = &vol->chunk_cache;
+	struct reduce_chunk_cache_entry *entry;
+	uint32_t i, num_buckets;
+
+	_chunk_cache_free(cache);
+	TAILQ_INIT(&cache->lru);
+
+	if (num_entries == 0) {
+		return 0;
+	}
+
+	num_buckets = spdk_align32pow2(num_entries);
+	cache->entries = calloc(num_entries, sizeof(*cache->entries));
+	cache->buckets = calloc(num_buckets, sizeof(*cache->buckets));
+	cache->buf_mem = malloc((size_t)num_entries * vol->params.chunk_size);
+	if (cache->entries == NULL || cache->buckets == NULL || cache->buf_mem == NULL) {
+		_chunk_cache_free(cache);
+		TAILQ_INIT(&cache->lru);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < num_buckets; i++) {
+		LIST_INIT(&cache->buckets[i]);
+	}
+
+	for (i = 0; i < num_entries; i++) {
+		entry = &cache->entries[i];
+		entry->logical_map_index = REDUCE_EMPTY_MAP_ENTRY;
+		entry->buf = cache->buf_mem + (size_t)i * vol->params.chunk_size;
+		TAILQ_INSERT_TAIL(&cache->lru, entry, lru);
+	}
+
+	cache->num_entries = num_entries;
+	cache->hash_mask = num_buckets - 1;
+
+	return 0;
+}
+
+static struct reduce_chunk_cache_entry *
+_chunk_cache_lookup(struct spdk_reduce_vol *vol, uint64_t logical_map_index)
+{
+	struct reduce_chunk_cache *cache = &vol->chunk_cache;
+	struct reduce_chunk_cache_entry *entry;
+
+	if (cache->num_entries == 0) {
+		return NULL;
+	}
+
+	LIST_FOREACH(entry, &cache->buckets[logical_map_index & cache->hash_mask], hash) {
+		if (entry->logical_map_index == logical_map_index) {
+			TAILQ_REMOVE(&cache->lru, entry, lru);
+			TAILQ_INSERT_HEAD(&cache->lru, entry, lru);
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Store the chunk described by iov into the cache, replacing the least recently
+ *  used entry if the chunk isn't cached yet.  The iovs must cover the whole chunk.
+ */
+static void
+_chunk_cache_fill(struct spdk_reduce_vol *vol, uint64_t logical_map_index,
+		  const struct iovec *iov, int iovcnt)
+{
+	struct reduce_chunk_cache *cache = &vol->chunk_cache;
+	struct reduce_chunk_cache_entry *entry;
+	uint8_t *buf;
+	int i;
+
+	if (cache->num_entries == 0) {
+		return;
+	}
+
+	entry = _chunk_cache_lookup(vol, logical_map_index);
+	if (entry == NULL) {
+		entry = TAILQ_LAST(&cache->lru, reduce_chunk_cache_lru);
+		if (entry->logical_map_index != REDUCE_EMPTY_MAP_ENTRY) {
+			LIST_REMOVE(entry, hash);
+		}
+		entry->logical_map_index = logical_map_index;
+		LIST_INSERT_HEAD(&cache->buckets[logical_map_index & cache->hash_mask], entry, hash);
+		TAILQ_REMOVE(&cache->lru, entry, lru);
+		TAILQ_INSERT_HEAD(&cache->lru, entry, lru);
+	}
+
+	buf = entry->buf;
+	for (i = 0; i < iovcnt; i++) {
+		memcpy(buf, iov[i].iov_base, iov[i].iov_len);
+		buf += iov[i].iov_len;
+	}
+	assert(buf == entry->buf + vol->params.chunk_size);
+}
+
 static void
 _init_load_cleanup(struct spdk_reduce_vol *vol, struct reduce_init_load_ctx *ctx)
 {
@@ -398,6 +530,7 @@ _init_load_cleanup(struct spdk_reduce_vol *vol, struct reduce_init_load_ctx *ctx
 		free(vol->request_mem);
 		free(vol->buf_iov_mem);
 		spdk_free(vol->buf_mem);
+		_chunk_cache_free(&vol->chunk_cache);
 		free(vol);
 	}
 }
@@ -1017,6 +1150,15 @@ _write_write_done(void *_req, int reduce_errno)
 
 	_reduce_persist(vol, &vol->pm_logical_map[req->logical_map_index], sizeof(uint64_t));
 
+	/*
+	 * decomp_iov still describes the full uncompressed chunk that was just written.
+	 *  Keep a cached copy up to date, and cache chunks that are being partially
+	 *  overwritten since they are likely to be overwritten again.
+	 */
+	if (req->rmw || _chunk_cache_lookup(vol, req->logical_map_index) != NULL) {
+		_chunk_cache_fill(vol, req->logical_map_index, req->decomp_iov, req->decomp_iovcnt);
+	}
+
 	_reduce_vol_complete_req(req, 0);
 }
 
@@ -1313,6 +1455,12 @@ _read_decompress_done(void *_req, int reduce_errno)
 		return;
 	}
 
+	if (req->chunk_is_compressed) {
+		_chunk_cache_fill(vol, req->logical_map_index, req->decomp_iov, req->decomp_iovcnt);
+	} else {
+		_chunk_cache_fill(vol, req->logical_map_index, req->decomp_buf_iov, req->num_io_units);
+	}
+
 	_reduce_vol_complete_req(req, 0);
 }
 
@@ -1407,7 +1555,26 @@ _check_overlap(struct spdk_reduce_vol *vol, uint64_t logical_map_index)
 static void
 _start_readv_request(struct spdk_reduce_vol_request *req)
 {
-	TAILQ_INSERT_TAIL(&req->vol->executing_requests, req, tailq);
+	struct spdk_reduce_vol *vol = req->vol;
+	struct reduce_chunk_cache_entry *entry;
+	uint64_t chunk_offset;
+	uint8_t *buf;
+	int i;
+
+	TAILQ_INSERT_TAIL(&vol->executing_requests, req, tailq);
+
+	entry = _chunk_cache_lookup(vol, req->logical_map_index);
+	if (entry != NULL) {
+		chunk_offset = req->offset % vol->logical_blocks_per_chunk;
+		buf = entry->buf + chunk_offset * vol->params.logical_block_size;
+		for (i = 0; i < req->iovcnt; i++) {
+			memcpy(req->iov[i].iov_base, buf, req->iov[i].iov_len);
+			buf += req->iov[i].iov_len;
+		}
+		_reduce_vol_complete_req(req, 0);
+		return;
+	}
+
 	_reduce_vol_read_chunk(req, _read_read_done);
 }
 
@@ -1480,6 +1647,7 @@ static void
 _start_writev_request(struct spdk_reduce_vol_request *req)
 {
 	struct spdk_reduce_vol *vol = req->vol;
+	struct reduce_chunk_cache_entry *entry;
 	uint64_t chunk_offset, ttl_len = 0;
 	uint64_t remainder = 0;
 	uint32_t lbsize;
@@ -1489,9 +1657,16 @@ _start_writev_request(struct spdk_reduce_vol_request *req)
 	if (vol->pm_logical_map[req->logical_map_index] != REDUCE_EMPTY_MAP_ENTRY) {
 		if ((req->length * vol->params.logical_block_size) < vol->params.chunk_size) {
 			/* Read old chunk, then overwrite with data from this write
-			 *  operation.
+			 *  operation.  If the old chunk is cached, skip the read and
+			 *  decompression altogether.
 			 */
 			req->rmw = true;
+			entry = _chunk_cache_lookup(vol, req->logical_map_index);
+			if (entry != NULL) {
+				memcpy(req->decomp_buf, entry->buf, vol->params.chunk_size);
+				_write_decompress_done(req, vol->params.chunk_size);
+				return;
+			}
 			_reduce_vol_read_chunk(req, _write_read_done);
 			return;
 		}
@@ -1581,6 +1756,19 @@ spdk_reduce_vol_writev(struct spdk_reduce_vol *vol,
 	}
 }
 
+int
+spdk_reduce_vol_set_cache_size(struct spdk_reduce_vol *vol, uint64_t size)
+{
+	uint64_t num_entries;
+
+	num_entries = size / vol->params.chunk_size;
+	if (num_entries > UINT32_MAX) {
+		return -EINVAL;
+	}
+
+	return _chunk_cache_alloc(vol, (uint32_t)num_entries);
+}
+
 const struct spdk_reduce_vol_params *
 spdk_reduce_vol_get_params(struct spdk_reduce_vol *vol)
 {
@@ -1607,6 +1795,7 @@ void spdk_reduce_vol_print_info(struct spdk_reduce_vol *vol)
 	SPDK_NOTICELOG("\ttotal_chunks_size = 0x%" PRIx64 "\n", ttl_chunk_sz);
 	struct_size = _reduce_vol_get_chunk_struct_size(vol->backing_io_units_per_chunk);
 	SPDK_NOTICELOG("\tchunk_struct_size = 0x%x\n", struct_size);
+	SPDK_NOTICELOG("\tchunk cache entries = %" PRIu32 "\n", vol->chunk_cache.num_entries);
 
 	SPDK_NOTICELOG("pmem info:\n");
 	SPDK_NOTICELOG("\tvol->pm_file.size = 0x%" PRIx64 "\n", vol->pm_file.size);
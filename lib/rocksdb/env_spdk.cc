@@ -32,6 +32,7 @@
  */
 
 #include "rocksdb/env.h"
+#include <algorithm>
 #include <set>
 #include <iostream>
 #include <stdexcept>
@@ -238,18 +239,33 @@ SpdkRandomAccessFile::InvalidateCache(__attribute__((unused)) size_t offset,
 	return Status::OK();
 }
 
+/*
+ * Files opened for direct writes stage appends in a DMA-safe buffer of this
+ *  size, so that blobfs receives large aligned writes it can submit straight
+ *  to the blob instead of copying them into its cache.
+ */
+#define SPDK_DIRECT_WRITE_BUF_SIZE (1024 * 1024)
+
 class SpdkWritableFile : public WritableFile
 {
 	struct spdk_file *mFile;
 	uint64_t mSize;
+	char *mDirectBuf;
+	uint64_t mDirectLen;
+
+	int FlushDirectBuf();
 
 public:
-	SpdkWritableFile(struct spdk_file *file) : mFile(file), mSize(0) {}
+	SpdkWritableFile(struct spdk_file *file, char *direct_buf) : mFile(file), mSize(0),
+		mDirectBuf(direct_buf), mDirectLen(0)
+	{
+	}
 	~SpdkWritableFile()
 	{
 		if (mFile != NULL) {
 			Close();
 		}
+		spdk_free(mDirectBuf);
 	}
 
 	virtual void SetIOPriority(Env::IOPriority pri)
@@ -264,7 +280,10 @@ public:
 		int rc;
 
 		set_channel();
-		rc = spdk_file_truncate(mFile, g_sync_args.channel, size);
+		rc = FlushDirectBuf();
+		if (!rc) {
+			rc = spdk_file_truncate(mFile, g_sync_args.channel, size);
+		}
 		if (!rc) {
 			mSize = size;
 			return Status::OK();
@@ -275,10 +294,18 @@ public:
 	}
 	virtual Status Close() override
 	{
+		Status s;
+		int rc;
+
 		set_channel();
+		rc = FlushDirectBuf();
+		if (rc) {
+			errno = -rc;
+			s = Status::IOError(spdk_file_get_name(mFile), strerror(errno));
+		}
 		spdk_file_close(mFile, g_sync_args.channel);
 		mFile = NULL;
-		return Status::OK();
+		return s;
 	}
 	virtual Status Append(const Slice &data) override;
 	virtual Status Flush() override
@@ -290,7 +317,10 @@ public:
 		int rc;
 
 		set_channel();
-		rc = spdk_file_sync(mFile, g_sync_args.channel);
+		rc = FlushDirectBuf();
+		if (!rc) {
+			rc = spdk_file_sync(mFile, g_sync_args.channel);
+		}
 		if (!rc) {
 			return Status::OK();
 		} else {
@@ -303,7 +333,10 @@ public:
 		int rc;
 
 		set_channel();
-		rc = spdk_file_sync(mFile, g_sync_args.channel);
+		rc = FlushDirectBuf();
+		if (!rc) {
+			rc = spdk_file_sync(mFile, g_sync_args.channel);
+		}
 		if (!rc) {
 			return Status::OK();
 		} else {
@@ -329,7 +362,10 @@ public:
 		int rc;
 
 		set_channel();
-		rc = spdk_file_truncate(mFile, g_sync_args.channel, offset + len);
+		rc = FlushDirectBuf();
+		if (!rc) {
+			rc = spdk_file_truncate(mFile, g_sync_args.channel, offset + len);
+		}
 		if (!rc) {
 			return Status::OK();
 		} else {
@@ -347,7 +383,10 @@ public:
 		 *  the whole file.
 		 */
 		set_channel();
-		rc = spdk_file_sync(mFile, g_sync_args.channel);
+		rc = FlushDirectBuf();
+		if (!rc) {
+			rc = spdk_file_sync(mFile, g_sync_args.channel);
+		}
 		if (!rc) {
 			return Status::OK();
 		} else {
@@ -368,12 +407,54 @@ public:
 	}
 };
 
+int
+SpdkWritableFile::FlushDirectBuf()
+{
+	int rc;
+
+	if (mDirectLen == 0) {
+		return 0;
+	}
+
+	rc = spdk_file_write(mFile, g_sync_args.channel, mDirectBuf, mSize - mDirectLen, mDirectLen);
+	if (rc == 0) {
+		mDirectLen = 0;
+	}
+
+	return rc;
+}
+
 Status
 SpdkWritableFile::Append(const Slice &data)
 {
 	int64_t rc;
 
 	set_channel();
+	if (mDirectBuf != NULL) {
+		const char *src = data.data();
+		uint64_t remaining = data.size();
+		uint64_t copy;
+
+		while (remaining > 0) {
+			copy = std::min(remaining, (uint64_t)SPDK_DIRECT_WRITE_BUF_SIZE - mDirectLen);
+			memcpy(mDirectBuf + mDirectLen, src, copy);
+			mDirectLen += copy;
+			mSize += copy;
+			src += copy;
+			remaining -= copy;
+
+			if (mDirectLen == SPDK_DIRECT_WRITE_BUF_SIZE) {
+				rc = FlushDirectBuf();
+				if (rc < 0) {
+					errno = -rc;
+					return Status::IOError(spdk_file_get_name(mFile), strerror(errno));
+				}
+			}
+		}
+
+		return Status::OK();
+	}
+
 	rc = spdk_file_write(mFile, g_sync_args.channel, (void *)data.data(), mSize, data.size());
 	if (rc >= 0) {
 		mSize += data.size();
@@ -474,15 +555,32 @@ public:
 		if (fname.compare(0, mDirectory.length(), mDirectory) == 0) {
 			std::string name = sanitize_path(fname, mDirectory);
 			struct spdk_file *file;
+			uint32_t flags = SPDK_BLOBFS_OPEN_CREATE;
+			char *direct_buf = NULL;
 			int rc;
 
+			/*
+			 * RocksDB only asks for direct writes on flush and compaction
+			 *  output (use_direct_io_for_flush_and_compaction), so the WAL
+			 *  and other small writers keep using the blobfs cache.
+			 *  Without a staging buffer, the file falls back to cached writes.
+			 */
+			if (options.use_direct_writes) {
+				direct_buf = (char *)spdk_malloc(SPDK_DIRECT_WRITE_BUF_SIZE, 0x1000, NULL,
+								 SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+				if (direct_buf != NULL) {
+					flags |= SPDK_BLOBFS_OPEN_DIRECT;
+				}
+			}
+
 			set_channel();
 			rc = spdk_fs_open_file(g_fs, g_sync_args.channel, name.c_str(),
-					       SPDK_BLOBFS_OPEN_CREATE, &file);
+					       flags, &file);
 			if (rc == 0) {
-				result->reset(new SpdkWritableFile(file));
+				result->reset(new SpdkWritableFile(file, direct_buf));
 				return Status::OK();
 			} else {
+				spdk_free(direct_buf);
 				errno = -rc;
 				return Status::IOError(name, strerror(errno));
 			}
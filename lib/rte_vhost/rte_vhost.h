@@ -343,6 +343,20 @@ int rte_vhost_driver_get_features(const char *path, uint64_t *features);
  */
 int rte_vhost_get_negotiated_features(int vid, uint64_t *features);
 
+/**
+ * Get the log base and log size of the vhost device
+ *
+ * @param vid
+ *  Vhost device ID
+ * @param log_base
+ *  vhost log base
+ * @param log_size
+ *  vhost log size
+ * @return
+ *  0 on success, -1 on failure
+ */
+int rte_vhost_get_log_base(int vid, uint64_t *log_base, uint64_t *log_size);
+
 /* Register callbacks. */
 int rte_vhost_driver_callback_register(const char *path,
 	struct vhost_device_ops const * const ops);
@@ -337,6 +337,20 @@ rte_vhost_get_negotiated_features(int vid, uint64_t *features)
 	return 0;
 }
 
+int
+rte_vhost_get_log_base(int vid, uint64_t *log_base, uint64_t *log_size)
+{
+	struct virtio_net *dev;
+
+	dev = get_device(vid);
+	if (!dev || !log_base || !log_size)
+		return -1;
+
+	*log_base = dev->log_base;
+	*log_size = dev->log_size;
+	return 0;
+}
+
 int
 rte_vhost_get_mem_table(int vid, struct rte_vhost_memory **mem)
 {
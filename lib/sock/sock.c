@@ -112,9 +112,15 @@ spdk_sock_map_release(int placement_id)
 	pthread_mutex_unlock(&g_map_table_mutex);
 }
 
-/* Look up the group for a placement_id. */
+/* Look up the group for a placement_id.
+ * If no group serves the placement_id yet and a hint is given, the hint becomes
+ * the group for it, so that sockets accepted before the first one is added to
+ * its group are placed together. The sock holds the reference to the new entry
+ * until it's added to a group or closed.
+ */
 static void
-spdk_sock_map_lookup(int placement_id, struct spdk_sock_group **group)
+spdk_sock_map_lookup(struct spdk_sock *sock, int placement_id, struct spdk_sock_group **group,
+		     struct spdk_sock_group *hint)
 {
 	struct spdk_sock_placement_id_entry *entry;
 
@@ -124,7 +130,23 @@ spdk_sock_map_lookup(int placement_id, struct spdk_sock_group **group)
 		if (placement_id == entry->placement_id) {
 			assert(entry->group != NULL);
 			*group = entry->group;
-			break;
+			pthread_mutex_unlock(&g_map_table_mutex);
+			return;
+		}
+	}
+
+	if (hint != NULL) {
+		entry = calloc(1, sizeof(*entry));
+		if (!entry) {
+			SPDK_ERRLOG("Cannot allocate an entry for placement_id=%u\n", placement_id);
+		} else {
+			entry->placement_id = placement_id;
+			entry->group = hint;
+			entry->ref++;
+			STAILQ_INSERT_TAIL(&g_placement_id_map, entry, link);
+			assert(sock->placement_id == 0);
+			sock->placement_id = placement_id;
+			*group = hint;
 		}
 	}
 	pthread_mutex_unlock(&g_map_table_mutex);
@@ -148,13 +170,15 @@ spdk_sock_remove_sock_group_from_map_table(struct spdk_sock_group *group)
 }
 
 int
-spdk_sock_get_optimal_sock_group(struct spdk_sock *sock, struct spdk_sock_group **group)
+spdk_sock_get_optimal_sock_group(struct spdk_sock *sock, struct spdk_sock_group **group,
+				 struct spdk_sock_group *hint)
 {
 	int placement_id = 0, rc;
 
+	*group = NULL;
 	rc = sock->net_impl->get_placement_id(sock, &placement_id);
 	if (!rc && (placement_id != 0)) {
-		spdk_sock_map_lookup(placement_id, group);
+		spdk_sock_map_lookup(sock, placement_id, group, hint);
 		return 0;
 	} else {
 		return -1;
@@ -246,6 +270,12 @@ spdk_sock_close(struct spdk_sock **_sock)
 		return -1;
 	}
 
+	/* Drop the placement_id reference taken by spdk_sock_get_optimal_sock_group() */
+	if (sock->placement_id != 0) {
+		spdk_sock_map_release(sock->placement_id);
+		sock->placement_id = 0;
+	}
+
 	sock->flags.closed = true;
 
 	if (sock->cb_cnt > 0) {
@@ -361,12 +391,34 @@ spdk_sock_set_sendbuf(struct spdk_sock *sock, int sz)
 	return sock->net_impl->set_sendbuf(sock, sz);
 }
 
+int
+spdk_sock_get_sendbuf(struct spdk_sock *sock, int *sz)
+{
+	if (sock->net_impl->get_sendbuf == NULL) {
+		errno = ENOTSUP;
+		return -1;
+	}
+
+	return sock->net_impl->get_sendbuf(sock, sz);
+}
+
 int
 spdk_sock_set_priority(struct spdk_sock *sock, int priority)
 {
 	return sock->net_impl->set_priority(sock, priority);
 }
 
+int
+spdk_sock_set_busy_poll(struct spdk_sock *sock, int usec)
+{
+	if (sock->net_impl->set_busy_poll == NULL) {
+		errno = ENOTSUP;
+		return -1;
+	}
+
+	return sock->net_impl->set_busy_poll(sock, usec);
+}
+
 bool
 spdk_sock_is_ipv6(struct spdk_sock *sock)
 {
@@ -449,6 +501,8 @@ spdk_sock_group_add_sock(struct spdk_sock_group *group, struct spdk_sock *sock,
 		if (rc < 0) {
 			return -1;
 		}
+	} else {
+		placement_id = 0;
 	}
 
 	STAILQ_FOREACH_FROM(group_impl, &group->group_impls, link) {
@@ -458,6 +512,9 @@ spdk_sock_group_add_sock(struct spdk_sock_group *group, struct spdk_sock *sock,
 	}
 
 	if (group_impl == NULL) {
+		if (placement_id != 0) {
+			spdk_sock_map_release(placement_id);
+		}
 		errno = EINVAL;
 		return -1;
 	}
@@ -468,6 +525,16 @@ spdk_sock_group_add_sock(struct spdk_sock_group *group, struct spdk_sock *sock,
 		sock->group_impl = group_impl;
 		sock->cb_fn = cb_fn;
 		sock->cb_arg = cb_arg;
+		/* The reference taken when the sock was placed isn't needed anymore. */
+		if (sock->placement_id != 0) {
+			spdk_sock_map_release(sock->placement_id);
+		}
+		/* The NAPI ID can change while the socket is in the group, so remember
+		 * the one the reference was taken for.
+		 */
+		sock->placement_id = placement_id;
+	} else if (placement_id != 0) {
+		spdk_sock_map_release(placement_id);
 	}
 
 	return rc;
@@ -477,7 +544,7 @@ int
 spdk_sock_group_remove_sock(struct spdk_sock_group *group, struct spdk_sock *sock)
 {
 	struct spdk_sock_group_impl *group_impl = NULL;
-	int rc, placement_id = 0;
+	int rc;
 
 	STAILQ_FOREACH_FROM(group_impl, &group->group_impls, link) {
 		if (sock->net_impl == group_impl->net_impl) {
@@ -492,17 +559,16 @@ spdk_sock_group_remove_sock(struct spdk_sock_group *group, struct spdk_sock *soc
 
 	assert(group_impl == sock->group_impl);
 
-	rc = sock->net_impl->get_placement_id(sock, &placement_id);
-	if (!rc && (placement_id != 0)) {
-		spdk_sock_map_release(placement_id);
-	}
-
 	rc = group_impl->net_impl->group_impl_remove_sock(group_impl, sock);
 	if (rc == 0) {
 		TAILQ_REMOVE(&group_impl->socks, sock, link);
 		sock->group_impl = NULL;
 		sock->cb_fn = NULL;
 		sock->cb_arg = NULL;
+		if (sock->placement_id != 0) {
+			spdk_sock_map_release(sock->placement_id);
+			sock->placement_id = 0;
+		}
 	}
 
 	return rc;
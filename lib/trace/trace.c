@@ -34,6 +34,7 @@
 #include "spdk/stdinc.h"
 
 #include "spdk/env.h"
+#include "spdk/likely.h"
 #include "spdk/string.h"
 #include "spdk/trace.h"
 #include "spdk/util.h"
@@ -44,59 +45,112 @@ static char g_shm_name[64];
 
 struct spdk_trace_histories *g_trace_histories;
 
+static __thread uint64_t t_thread_id;
+
 void
-_spdk_trace_record(uint64_t tsc, uint16_t tpoint_id, uint16_t poller_id, uint32_t size,
-		   uint64_t object_id, uint64_t arg1)
+spdk_trace_set_thread_id(uint64_t thread_id)
+{
+	t_thread_id = thread_id;
+}
+
+static inline void
+_trace_fill_entry(struct spdk_trace_history *lcore_history, uint64_t *entry_idx, uint64_t tsc,
+		  uint16_t tpoint_id, uint16_t poller_id, uint32_t size, uint64_t object_id,
+		  uint64_t arg1)
 {
-	struct spdk_trace_history *lcore_history;
 	struct spdk_trace_entry *next_entry;
-	unsigned lcore;
-	uint64_t next_circular_entry;
 
-	lcore = spdk_env_get_current_core();
-	if (lcore >= SPDK_TRACE_MAX_LCORE) {
+	/* Get next entry in the circular buffer */
+	next_entry = &lcore_history->entries[*entry_idx & (lcore_history->num_entries - 1)];
+	next_entry->tsc = tsc;
+	next_entry->tpoint_id = tpoint_id;
+	next_entry->poller_id = poller_id;
+	next_entry->size = size;
+	next_entry->object_id = object_id;
+	next_entry->arg1 = arg1;
+	(*entry_idx)++;
+}
+
+void
+_spdk_trace_record_args(uint64_t tsc, uint16_t tpoint_id, uint16_t poller_id, uint32_t size,
+			uint64_t object_id, uint8_t num_args, const uint64_t *args)
+{
+	struct spdk_trace_history *lcore_history;
+	uint64_t entry_idx;
+	uint8_t i;
+
+	lcore_history = spdk_get_per_lcore_history(g_trace_histories, spdk_env_get_current_core());
+	if (lcore_history == NULL) {
 		return;
 	}
 
-	lcore_history = spdk_get_per_lcore_history(g_trace_histories, lcore);
 	if (tsc == 0) {
 		tsc = spdk_get_ticks();
 	}
 
 	lcore_history->tpoint_count[tpoint_id]++;
 
-	/* Get next entry index in the circular buffer */
-	next_circular_entry = lcore_history->next_entry & (lcore_history->num_entries - 1);
-	next_entry = &lcore_history->entries[next_circular_entry];
-	next_entry->tsc = tsc;
-	next_entry->tpoint_id = tpoint_id;
-	next_entry->poller_id = poller_id;
-	next_entry->size = size;
-	next_entry->object_id = object_id;
-	next_entry->arg1 = arg1;
+	entry_idx = lcore_history->next_entry;
 
-	/* Ensure all elements of the trace entry are visible to outside trace tools */
+	/*
+	 * Note the spdk_thread whenever it changes. While a thread keeps running on
+	 *  this lcore, note it again every quarter of the buffer, so that the oldest
+	 *  entries can still be attributed after the buffer wrapped.
+	 */
+	if (spdk_unlikely(t_thread_id != lcore_history->thread_id ||
+			  (t_thread_id != 0 &&
+			   entry_idx - lcore_history->thread_entry >= lcore_history->num_entries / 4))) {
+		lcore_history->thread_id = t_thread_id;
+		lcore_history->thread_entry = entry_idx;
+		_trace_fill_entry(lcore_history, &entry_idx, tsc, SPDK_TRACE_TPOINT_THREAD, 0, 0,
+				  t_thread_id, 0);
+	}
+
+	_trace_fill_entry(lcore_history, &entry_idx, tsc, tpoint_id, poller_id, size, object_id,
+			  num_args > 0 ? args[0] : 0);
+
+	for (i = 1; i < num_args; i += SPDK_TRACE_ENTRY_EXTRA_ARGS) {
+		_trace_fill_entry(lcore_history, &entry_idx, tsc, SPDK_TRACE_TPOINT_ARGS, 0, 0,
+				  args[i], i + 1 < num_args ? args[i + 1] : 0);
+	}
+
+	/* Ensure all elements of the trace entries are visible to outside trace tools */
 	spdk_smp_wmb();
-	lcore_history->next_entry++;
+	lcore_history->next_entry = entry_idx;
+}
+
+void
+_spdk_trace_record(uint64_t tsc, uint16_t tpoint_id, uint16_t poller_id, uint32_t size,
+		   uint64_t object_id, uint64_t arg1)
+{
+	_spdk_trace_record_args(tsc, tpoint_id, poller_id, size, object_id, 1, &arg1);
 }
 
 int
 spdk_trace_init(const char *shm_name, uint64_t num_entries)
 {
-	int i = 0;
-	int histories_size;
-	uint64_t lcore_offsets[SPDK_TRACE_MAX_LCORE + 1];
+	uint32_t i = 0;
+	uint64_t histories_size;
+	uint64_t lcore_offsets[SPDK_TRACE_MAX_LCORE + 1] = {};
 
 	/* 0 entries requested - skip trace initialization */
 	if (num_entries == 0) {
 		return 0;
 	}
 
-	lcore_offsets[0] = sizeof(struct spdk_trace_flags);
-	for (i = 1; i < (int)SPDK_COUNTOF(lcore_offsets); i++) {
-		lcore_offsets[i] = spdk_get_trace_history_size(num_entries) + lcore_offsets[i - 1];
+	/* Only lcores the application runs on get a trace history */
+	histories_size = sizeof(struct spdk_trace_flags);
+	SPDK_ENV_FOREACH_CORE(i) {
+		if (i >= SPDK_TRACE_MAX_LCORE) {
+			fprintf(stderr, "lcore %u exceeds the maximum %u for tracing\n", i,
+				SPDK_TRACE_MAX_LCORE - 1);
+			continue;
+		}
+
+		lcore_offsets[i] = histories_size;
+		histories_size += spdk_get_trace_history_size(num_entries);
 	}
-	histories_size = lcore_offsets[SPDK_TRACE_MAX_LCORE];
+	lcore_offsets[SPDK_TRACE_MAX_LCORE] = histories_size;
 
 	snprintf(g_shm_name, sizeof(g_shm_name), "%s", shm_name);
 
@@ -144,6 +198,10 @@ spdk_trace_init(const char *shm_name, uint64_t num_entries)
 
 		g_trace_flags->lcore_history_offsets[i] = lcore_offsets[i];
 		lcore_history = spdk_get_per_lcore_history(g_trace_histories, i);
+		if (lcore_history == NULL) {
+			continue;
+		}
+
 		lcore_history->lcore = i;
 		lcore_history->num_entries = num_entries;
 	}
@@ -169,7 +227,7 @@ trace_init_err:
 void
 spdk_trace_cleanup(void)
 {
-	bool unlink;
+	bool unlink = true;
 	int i;
 	struct spdk_trace_history *lcore_history;
 
@@ -184,13 +242,17 @@ spdk_trace_cleanup(void)
 	 */
 	for (i = 0; i < SPDK_TRACE_MAX_LCORE; i++) {
 		lcore_history = spdk_get_per_lcore_history(g_trace_histories, i);
+		if (lcore_history == NULL) {
+			continue;
+		}
+
 		unlink = lcore_history->entries[0].tsc == 0;
 		if (!unlink) {
 			break;
 		}
 	}
 
-	munmap(g_trace_histories, sizeof(struct spdk_trace_histories));
+	munmap(g_trace_histories, spdk_get_trace_histories_size(g_trace_histories));
 	g_trace_histories = NULL;
 	close(g_trace_fd);
 
@@ -237,11 +237,12 @@ spdk_trace_register_object(uint8_t type, char id_prefix)
 }
 
 void
-spdk_trace_register_description(const char *name, uint16_t tpoint_id, uint8_t owner_type,
-				uint8_t object_type, uint8_t new_object,
-				uint8_t arg1_type, const char *arg1_name)
+spdk_trace_register_description_ext(const char *name, uint16_t tpoint_id, uint8_t owner_type,
+				    uint8_t object_type, uint8_t new_object, uint8_t num_args,
+				    const struct spdk_trace_tpoint_arg *args)
 {
 	struct spdk_trace_tpoint *tpoint;
+	uint8_t i;
 
 	assert(tpoint_id != 0);
 	assert(tpoint_id < SPDK_TRACE_MAX_TPOINT_ID);
@@ -250,6 +251,12 @@ spdk_trace_register_description(const char *name, uint16_t tpoint_id, uint8_t ow
 		SPDK_ERRLOG("name (%s) too long\n", name);
 	}
 
+	if (num_args > SPDK_TRACE_MAX_ARGS_COUNT) {
+		SPDK_ERRLOG("too many arguments (%u) for tpoint %s\n", num_args, name);
+		assert(false);
+		return;
+	}
+
 	tpoint = &g_trace_flags->tpoint[tpoint_id];
 	assert(tpoint->tpoint_id == 0);
 
@@ -258,8 +265,31 @@ spdk_trace_register_description(const char *name, uint16_t tpoint_id, uint8_t ow
 	tpoint->object_type = object_type;
 	tpoint->owner_type = owner_type;
 	tpoint->new_object = new_object;
-	tpoint->arg1_type = arg1_type;
-	snprintf(tpoint->arg1_name, sizeof(tpoint->arg1_name), "%s", arg1_name);
+	tpoint->num_args = num_args;
+
+	if (num_args > 0) {
+		tpoint->arg1_type = args[0].type;
+		snprintf(tpoint->arg1_name, sizeof(tpoint->arg1_name), "%s", args[0].name);
+	}
+
+	for (i = 1; i < num_args; i++) {
+		tpoint->args[i - 1].type = args[i].type;
+		snprintf(tpoint->args[i - 1].name, sizeof(tpoint->args[i - 1].name), "%s", args[i].name);
+	}
+}
+
+void
+spdk_trace_register_description(const char *name, uint16_t tpoint_id, uint8_t owner_type,
+				uint8_t object_type, uint8_t new_object,
+				uint8_t arg1_type, const char *arg1_name)
+{
+	struct spdk_trace_tpoint_arg arg1 = {
+		.name = arg1_name,
+		.type = arg1_type,
+	};
+
+	spdk_trace_register_description_ext(name, tpoint_id, owner_type, object_type, new_object,
+					    arg1_name[0] != '\0' ? 1 : 0, &arg1);
 }
 
 void
@@ -204,11 +204,28 @@ spdk_extern_vhost_pre_msg_handler(int vid, void *_msg)
 		 * We will start the device again from the post-processing
 		 * message handler.
 		 */
+	case VHOST_USER_SET_LOG_BASE:
+		/* Same for the dirty page log. Stopping the session flushes
+		 * any log updates it still buffers into the previous log,
+		 * and restarting it makes SPDK map the new one.
+		 */
 		if (vsession->started) {
 			g_spdk_vhost_ops.destroy_device(vid);
 			vsession->needs_restart = true;
 		}
 		break;
+	case VHOST_USER_SET_FEATURES:
+		/* The dirty page log is only set up when a session starts, and
+		 * rte_vhost doesn't stop the sessions we started ourselves for
+		 * forced polling. Restart the session whenever VHOST_F_LOG_ALL
+		 * is turned on or off, so that logging follows the features.
+		 */
+		if (vsession->started &&
+		    ((msg->payload.u64 ^ vsession->negotiated_features) & (1ULL << VHOST_F_LOG_ALL))) {
+			g_spdk_vhost_ops.destroy_device(vid);
+			vsession->needs_restart = true;
+		}
+		break;
 	case VHOST_USER_GET_CONFIG: {
 		int rc = 0;
 
@@ -99,6 +99,116 @@ void *vhost_gpa_to_vva(struct spdk_vhost_session *vsession, uint64_t addr, uint6
 
 }
 
+void
+vhost_vq_group_log_flush(struct spdk_vhost_session *vsession, struct spdk_vhost_vq_group *group)
+{
+	struct vhost_log_cache_entry *entry;
+	uint64_t offset, val;
+	uint16_t i, j;
+
+	if (group->log_cache_cnt == 0) {
+		return;
+	}
+
+	/* Make sure guest memory updates are committed before logging them */
+	spdk_smp_wmb();
+
+	for (i = 0; i < group->log_cache_cnt; i++) {
+		entry = &group->log_cache[i];
+		offset = entry->offset * sizeof(uint64_t);
+
+		if (spdk_likely(((uintptr_t)vsession->log.base & (sizeof(uint64_t) - 1)) == 0 &&
+				offset + sizeof(uint64_t) <= vsession->log.size)) {
+			__atomic_fetch_or((uint64_t *)(vsession->log.base + offset), entry->val,
+					  __ATOMIC_RELAXED);
+			continue;
+		}
+
+		/* Unaligned log or its last, partial word */
+		for (j = 0; j < sizeof(uint64_t) && offset + j < vsession->log.size; j++) {
+			val = (entry->val >> (j * 8)) & 0xff;
+			if (val != 0) {
+				__atomic_fetch_or(vsession->log.base + offset + j, (uint8_t)val,
+						  __ATOMIC_RELAXED);
+			}
+		}
+	}
+
+	group->log_cache_cnt = 0;
+}
+
+static void
+vhost_log_cache_add(struct spdk_vhost_session *vsession, struct spdk_vhost_vq_group *group,
+		    uint64_t offset, uint64_t val)
+{
+	struct vhost_log_cache_entry *entry;
+	uint16_t i;
+
+	for (i = 0; i < group->log_cache_cnt; i++) {
+		entry = &group->log_cache[i];
+		if (entry->offset == offset) {
+			entry->val |= val;
+			return;
+		}
+	}
+
+	if (spdk_unlikely(group->log_cache_cnt == SPDK_VHOST_LOG_CACHE_SIZE)) {
+		vhost_vq_group_log_flush(vsession, group);
+	}
+
+	entry = &group->log_cache[group->log_cache_cnt++];
+	entry->offset = offset;
+	entry->val = val;
+}
+
+/*
+ * Mark the pages of given guest physical range as dirty. The updates are
+ * buffered one 64-bit log word at a time by the group of the virtqueue
+ * and written by vhost_vq_group_log_flush().
+ */
+static void
+vhost_log_write(struct spdk_vhost_session *vsession, struct spdk_vhost_virtqueue *virtqueue,
+		uint64_t addr, uint64_t len)
+{
+	uint64_t page, last_page, word_last_page, mask;
+
+	if (spdk_unlikely(len == 0)) {
+		return;
+	}
+
+	last_page = (addr + len - 1) / SPDK_VHOST_LOG_PAGE;
+	if (spdk_unlikely(last_page / 8 >= vsession->log.size)) {
+		return;
+	}
+
+	for (page = addr / SPDK_VHOST_LOG_PAGE; page <= last_page; page = word_last_page + 1) {
+		word_last_page = spdk_min(last_page, page | 63);
+		mask = (UINT64_MAX << (page % 64)) & (UINT64_MAX >> (63 - word_last_page % 64));
+		vhost_log_cache_add(vsession, virtqueue->group, page / 64, mask);
+	}
+}
+
+static void
+vhost_session_log_init(struct spdk_vhost_session *vsession)
+{
+	uint64_t log_base = 0, log_size = 0;
+
+	vsession->log.enabled = false;
+	if (!vhost_dev_has_feature(vsession, VHOST_F_LOG_ALL)) {
+		return;
+	}
+
+	if (rte_vhost_get_log_base(vsession->vid, &log_base, &log_size) != 0 || log_base == 0) {
+		SPDK_WARNLOG("%s: VHOST_F_LOG_ALL negotiated, but no dirty page log is set.\n",
+			     vsession->name);
+		return;
+	}
+
+	vsession->log.base = (uint8_t *)(uintptr_t)log_base;
+	vsession->log.size = log_size;
+	vsession->log.enabled = true;
+}
+
 static void
 vhost_log_req_desc(struct spdk_vhost_session *vsession, struct spdk_vhost_virtqueue *virtqueue,
 		   uint16_t req_id)
@@ -107,10 +217,6 @@ vhost_log_req_desc(struct spdk_vhost_session *vsession, struct spdk_vhost_virtqu
 	uint32_t desc_table_size;
 	int rc;
 
-	if (spdk_likely(!vhost_dev_has_feature(vsession, VHOST_F_LOG_ALL))) {
-		return;
-	}
-
 	rc = vhost_vq_get_desc(vsession, virtqueue, req_id, &desc, &desc_table, &desc_table_size);
 	if (spdk_unlikely(rc != 0)) {
 		SPDK_ERRLOG("Can't log used ring descriptors!\n");
@@ -123,7 +229,7 @@ vhost_log_req_desc(struct spdk_vhost_session *vsession, struct spdk_vhost_virtqu
 			 * doing so would require tracking those changes in each backed.
 			 * Also backend most likely will touch all/most of those pages so
 			 * for lets assume we touched all pages passed to as writeable buffers. */
-			rte_vhost_log_write(vsession->vid, desc->addr, desc->len);
+			vhost_log_write(vsession, virtqueue, desc->addr, desc->len);
 		}
 		vhost_vring_desc_get_next(&desc, desc_table, desc_table_size);
 	} while (desc);
@@ -135,17 +241,11 @@ vhost_log_used_vring_elem(struct spdk_vhost_session *vsession,
 			  uint16_t idx)
 {
 	uint64_t offset, len;
-	uint16_t vq_idx;
-
-	if (spdk_likely(!vhost_dev_has_feature(vsession, VHOST_F_LOG_ALL))) {
-		return;
-	}
 
 	offset = offsetof(struct vring_used, ring[idx]);
 	len = sizeof(virtqueue->vring.used->ring[idx]);
-	vq_idx = virtqueue - vsession->virtqueue;
 
-	rte_vhost_log_used_vring(vsession->vid, vq_idx, offset, len);
+	vhost_log_write(vsession, virtqueue, virtqueue->vring.log_guest_addr + offset, len);
 }
 
 static void
@@ -153,17 +253,120 @@ vhost_log_used_vring_idx(struct spdk_vhost_session *vsession,
 			 struct spdk_vhost_virtqueue *virtqueue)
 {
 	uint64_t offset, len;
-	uint16_t vq_idx;
-
-	if (spdk_likely(!vhost_dev_has_feature(vsession, VHOST_F_LOG_ALL))) {
-		return;
-	}
 
 	offset = offsetof(struct vring_used, idx);
 	len = sizeof(virtqueue->vring.used->idx);
-	vq_idx = virtqueue - vsession->virtqueue;
 
-	rte_vhost_log_used_vring(vsession->vid, vq_idx, offset, len);
+	vhost_log_write(vsession, virtqueue, virtqueue->vring.log_guest_addr + offset, len);
+}
+
+static inline uint16_t
+vhost_vq_packed_idx_add(uint16_t idx, uint16_t count, uint16_t size, bool *phase)
+{
+	/* Packed virtqueue sizes don't have to be a power of 2. */
+	idx += count;
+	if (idx >= size) {
+		idx -= size;
+		*phase = !*phase;
+	}
+
+	return idx;
+}
+
+static bool
+vhost_vq_packed_desc_is_avail(struct spdk_vhost_virtqueue *virtqueue, uint16_t idx)
+{
+	uint16_t flags = *(volatile uint16_t *)&virtqueue->vring.desc_packed[idx].flags;
+
+	/* The driver makes a descriptor available by setting the AVAIL bit
+	 * to its wrap counter and the USED bit to the inverse of it.
+	 */
+	return !!(flags & VRING_DESC_F_AVAIL) == virtqueue->packed.avail_phase &&
+	       !!(flags & VRING_DESC_F_USED) != virtqueue->packed.avail_phase;
+}
+
+/*
+ * Write a used descriptor for given buffer ID and return the chain's
+ * ring slots to the driver.
+ */
+static void
+vhost_vq_packed_desc_mark_used(struct spdk_vhost_virtqueue *virtqueue, uint16_t buffer_id,
+			       uint16_t num_descs, uint32_t len)
+{
+	struct vring_packed_desc *desc = &virtqueue->vring.desc_packed[virtqueue->last_used_idx];
+	uint16_t flags = 0;
+
+	desc->id = buffer_id;
+	desc->len = len;
+	if (len != 0) {
+		flags |= VRING_DESC_F_WRITE;
+	}
+	if (virtqueue->packed.used_phase) {
+		flags |= VRING_DESC_F_AVAIL_USED;
+	}
+
+	/* The ID and length must be visible before the descriptor is marked used. */
+	spdk_smp_wmb();
+	*(volatile uint16_t *)&desc->flags = flags;
+
+	virtqueue->last_used_idx = vhost_vq_packed_idx_add(virtqueue->last_used_idx, num_descs,
+				   virtqueue->vring.size, &virtqueue->packed.used_phase);
+}
+
+static uint16_t
+vhost_vq_packed_ring_get(struct spdk_vhost_virtqueue *virtqueue, uint16_t *reqs,
+			 uint16_t reqs_len)
+{
+	struct rte_vhost_vring *vring = &virtqueue->vring;
+	struct vring_packed_desc *desc;
+	uint16_t head, idx, num_descs, buffer_id;
+	uint16_t count = 0;
+
+	while (count < reqs_len && vhost_vq_packed_desc_is_avail(virtqueue, virtqueue->last_avail_idx)) {
+		/* The driver makes the head available last, so the rest
+		 * of the chain can be read once the head is seen.
+		 */
+		spdk_smp_rmb();
+
+		head = idx = virtqueue->last_avail_idx;
+		desc = &vring->desc_packed[idx];
+		num_descs = 1;
+		while (desc->flags & VRING_DESC_F_NEXT) {
+			if (spdk_unlikely(num_descs == vring->size)) {
+				/* TODO: the queue is unrecoverably broken and should be marked so.
+				 * For now we will fail silently and report there are no new avail entries.
+				 */
+				return count;
+			}
+
+			idx = idx + 1 == vring->size ? 0 : idx + 1;
+			desc = &vring->desc_packed[idx];
+			num_descs++;
+		}
+
+		/* The buffer ID is only valid in the last descriptor of the chain. */
+		buffer_id = desc->id;
+		virtqueue->last_avail_idx = vhost_vq_packed_idx_add(head, num_descs, vring->size,
+					    &virtqueue->packed.avail_phase);
+
+		if (spdk_unlikely(buffer_id >= vring->size)) {
+			SPDK_ERRLOG("Buffer ID %"PRIu16" exceeds virtqueue size (%"PRIu16").\n",
+				    buffer_id, vring->size);
+			vhost_vq_packed_desc_mark_used(virtqueue, buffer_id, num_descs, 0);
+			virtqueue->used_req_cnt++;
+			continue;
+		}
+
+		virtqueue->packed.bufs[buffer_id].head = head;
+		virtqueue->packed.bufs[buffer_id].num_descs = num_descs;
+		reqs[count++] = buffer_id;
+	}
+
+	SPDK_DEBUGLOG(SPDK_LOG_VHOST_RING,
+		      "AVAIL: last_idx=%"PRIu16" avail_phase=%d count=%"PRIu16"\n",
+		      virtqueue->last_avail_idx, virtqueue->packed.avail_phase, count);
+
+	return count;
 }
 
 /*
@@ -176,9 +379,17 @@ vhost_vq_avail_ring_get(struct spdk_vhost_virtqueue *virtqueue, uint16_t *reqs,
 	struct rte_vhost_vring *vring = &virtqueue->vring;
 	struct vring_avail *avail = vring->avail;
 	uint16_t size_mask = vring->size - 1;
-	uint16_t last_idx = virtqueue->last_avail_idx, avail_idx = avail->idx;
+	uint16_t last_idx, avail_idx;
 	uint16_t count, i;
 
+	if (virtqueue->packed.packed_ring) {
+		count = vhost_vq_packed_ring_get(virtqueue, reqs, reqs_len);
+		virtqueue->coalescing.inflight += count;
+		return count;
+	}
+
+	last_idx = virtqueue->last_avail_idx;
+	avail_idx = avail->idx;
 	count = avail_idx - last_idx;
 	if (spdk_likely(count == 0)) {
 		return 0;
@@ -193,6 +404,7 @@ vhost_vq_avail_ring_get(struct spdk_vhost_virtqueue *virtqueue, uint16_t *reqs,
 
 	count = spdk_min(count, reqs_len);
 	virtqueue->last_avail_idx += count;
+	virtqueue->coalescing.inflight += count;
 	for (i = 0; i < count; i++) {
 		reqs[i] = vring->avail->ring[(last_idx + i) & size_mask];
 	}
@@ -210,6 +422,60 @@ vhost_vring_desc_is_indirect(struct vring_desc *cur_desc)
 	return !!(cur_desc->flags & VRING_DESC_F_INDIRECT);
 }
 
+/*
+ * Copy a packed descriptor chain into the virtqueue's split layout table.
+ * Packed chains are either consecutive ring entries linked by the NEXT
+ * flag or a whole indirect table, so the copy gets sequential next indexes.
+ */
+static int
+vhost_vq_get_desc_packed(struct spdk_vhost_session *vsession,
+			 struct spdk_vhost_virtqueue *virtqueue, uint16_t buffer_id,
+			 struct vring_desc **desc, struct vring_desc **desc_table,
+			 uint32_t *desc_table_size)
+{
+	struct vhost_packed_buf *buf = &virtqueue->packed.bufs[buffer_id];
+	struct vring_desc *table = virtqueue->packed.desc_table;
+	struct vring_packed_desc *src, *src_table;
+	uint16_t size = virtqueue->vring.size;
+	uint16_t i, cnt, idx;
+
+	src = &virtqueue->vring.desc_packed[buf->head];
+	if (src->flags & VRING_DESC_F_INDIRECT) {
+		cnt = src->len / sizeof(*src);
+		if (spdk_unlikely(cnt == 0 || cnt > size)) {
+			return -1;
+		}
+
+		src_table = vhost_gpa_to_vva(vsession, src->addr, sizeof(*src) * cnt);
+		if (spdk_unlikely(src_table == NULL)) {
+			return -1;
+		}
+		idx = 0;
+	} else {
+		src_table = virtqueue->vring.desc_packed;
+		cnt = buf->num_descs;
+		idx = buf->head;
+	}
+
+	for (i = 0; i < cnt; i++) {
+		src = &src_table[idx];
+		table[i].addr = src->addr;
+		table[i].len = src->len;
+		table[i].flags = src->flags & VRING_DESC_F_WRITE;
+		if (i + 1 < cnt) {
+			table[i].flags |= VRING_DESC_F_NEXT;
+		}
+		table[i].next = i + 1;
+		idx = idx + 1 == size ? 0 : idx + 1;
+	}
+
+	*desc = table;
+	*desc_table = table;
+	*desc_table_size = cnt;
+
+	return 0;
+}
+
 int
 vhost_vq_get_desc(struct spdk_vhost_session *vsession, struct spdk_vhost_virtqueue *virtqueue,
 		  uint16_t req_idx, struct vring_desc **desc, struct vring_desc **desc_table,
@@ -219,6 +485,11 @@ vhost_vq_get_desc(struct spdk_vhost_session *vsession, struct spdk_vhost_virtque
 		return -1;
 	}
 
+	if (virtqueue->packed.packed_ring) {
+		return vhost_vq_get_desc_packed(vsession, virtqueue, req_idx, desc, desc_table,
+						desc_table_size);
+	}
+
 	*desc = &virtqueue->vring.desc[req_idx];
 
 	if (vhost_vring_desc_is_indirect(*desc)) {
@@ -239,6 +510,16 @@ vhost_vq_get_desc(struct spdk_vhost_session *vsession, struct spdk_vhost_virtque
 	return 0;
 }
 
+static bool
+vhost_vq_event_is_suppressed(struct spdk_vhost_virtqueue *virtqueue)
+{
+	if (virtqueue->packed.packed_ring) {
+		return virtqueue->vring.driver_event->flags == VRING_PACKED_EVENT_FLAG_DISABLE;
+	}
+
+	return virtqueue->vring.avail->flags & VRING_AVAIL_F_NO_INTERRUPT;
+}
+
 int
 vhost_vq_used_signal(struct spdk_vhost_session *vsession,
 		     struct spdk_vhost_virtqueue *virtqueue)
@@ -265,7 +546,8 @@ vhost_vq_used_signal(struct spdk_vhost_session *vsession,
 
 
 static void
-check_session_io_stats(struct spdk_vhost_session *vsession, uint64_t now)
+check_session_io_stats(struct spdk_vhost_session *vsession, struct spdk_vhost_vq_group *group,
+		       uint64_t now)
 {
 	struct spdk_vhost_virtqueue *virtqueue;
 	uint32_t irq_delay_base = vsession->coalescing_delay_time_base;
@@ -274,12 +556,12 @@ check_session_io_stats(struct spdk_vhost_session *vsession, uint64_t now)
 	uint32_t req_cnt;
 	uint16_t q_idx;
 
-	if (now < vsession->next_stats_check_time) {
+	if (now < group->next_stats_check_time) {
 		return;
 	}
 
-	vsession->next_stats_check_time = now + vsession->stats_check_interval;
-	for (q_idx = 0; q_idx < vsession->max_queues; q_idx++) {
+	group->next_stats_check_time = now + vsession->stats_check_interval;
+	for (q_idx = group->first_vq; q_idx < vsession->max_queues; q_idx += group->vq_stride) {
 		virtqueue = &vsession->virtqueue[q_idx];
 
 		req_cnt = virtqueue->req_cnt + virtqueue->used_req_cnt;
@@ -295,19 +577,90 @@ check_session_io_stats(struct spdk_vhost_session *vsession, uint64_t now)
 	}
 }
 
+static void
+vhost_vq_coalescing_pending_reset(struct spdk_vhost_virtqueue *virtqueue)
+{
+	virtqueue->coalescing.pending = 0;
+	virtqueue->coalescing.pending_tsc_sum = 0;
+}
+
+/*
+ * Adaptive per virtqueue coalescing. The event is sent once the oldest
+ * pending completion has waited for the whole latency budget, or earlier
+ * if waiting is unlikely to batch any more completions.
+ */
+static int
+vhost_vq_adaptive_used_signal(struct spdk_vhost_session *vsession,
+			      struct spdk_vhost_virtqueue *virtqueue, uint64_t now)
+{
+	uint64_t deadline;
+
+	if (virtqueue->coalescing.pending == 0 || virtqueue->vring.desc == NULL) {
+		return 0;
+	}
+
+	/* The driver is polling or will look at the ring later on its own, so
+	 * the pending completions don't wait for us.
+	 */
+	if (vhost_vq_event_is_suppressed(virtqueue)) {
+		vhost_vq_coalescing_pending_reset(virtqueue);
+		return 0;
+	}
+
+	deadline = virtqueue->coalescing.first_pending_tsc + virtqueue->coalescing.latency_budget;
+	if (now < deadline && virtqueue->coalescing.inflight > 0 &&
+	    now + virtqueue->coalescing.avg_completion_interval < deadline) {
+		/* Another completion is expected within the budget */
+		return 0;
+	}
+
+	if (!vhost_vq_used_signal(vsession, virtqueue)) {
+		return 0;
+	}
+
+	virtqueue->coalescing.events++;
+	virtqueue->coalescing.completions += virtqueue->coalescing.pending;
+	virtqueue->coalescing.added_latency += virtqueue->coalescing.pending * now -
+					       virtqueue->coalescing.pending_tsc_sum;
+	vhost_vq_coalescing_pending_reset(virtqueue);
+	return 1;
+}
+
+void
+vhost_vq_group_init(struct spdk_vhost_session *vsession, struct spdk_vhost_vq_group *group,
+		    struct spdk_thread *thread, uint16_t first_vq, uint16_t vq_stride)
+{
+	uint16_t q_idx;
+
+	assert(vq_stride > 0);
+	memset(group, 0, sizeof(*group));
+	group->thread = thread;
+	group->first_vq = first_vq;
+	group->vq_stride = vq_stride;
+
+	for (q_idx = first_vq; q_idx < SPDK_VHOST_MAX_VQUEUES; q_idx += vq_stride) {
+		vsession->virtqueue[q_idx].group = group;
+	}
+}
+
 void
-vhost_session_used_signal(struct spdk_vhost_session *vsession)
+vhost_vq_group_used_signal(struct spdk_vhost_session *vsession, struct spdk_vhost_vq_group *group)
 {
 	struct spdk_vhost_virtqueue *virtqueue;
 	uint64_t now;
 	uint16_t q_idx;
 
-	if (vsession->coalescing_delay_time_base == 0) {
-		for (q_idx = 0; q_idx < vsession->max_queues; q_idx++) {
+	/* Log all pages dirtied in this poller iteration at once */
+	if (spdk_unlikely(group->log_cache_cnt != 0)) {
+		vhost_vq_group_log_flush(vsession, group);
+	}
+
+	if (vsession->coalescing_delay_time_base == 0 && !vsession->adaptive_coalescing) {
+		for (q_idx = group->first_vq; q_idx < vsession->max_queues; q_idx += group->vq_stride) {
 			virtqueue = &vsession->virtqueue[q_idx];
 
 			if (virtqueue->vring.desc == NULL ||
-			    (virtqueue->vring.avail->flags & VRING_AVAIL_F_NO_INTERRUPT)) {
+			    vhost_vq_event_is_suppressed(virtqueue)) {
 				continue;
 			}
 
@@ -315,14 +668,33 @@ vhost_session_used_signal(struct spdk_vhost_session *vsession)
 		}
 	} else {
 		now = spdk_get_ticks();
-		check_session_io_stats(vsession, now);
+		if (vsession->coalescing_delay_time_base != 0) {
+			check_session_io_stats(vsession, group, now);
+		}
 
-		for (q_idx = 0; q_idx < vsession->max_queues; q_idx++) {
+		for (q_idx = group->first_vq; q_idx < vsession->max_queues; q_idx += group->vq_stride) {
 			virtqueue = &vsession->virtqueue[q_idx];
 
+			if (virtqueue->coalescing.latency_budget != 0) {
+				if (vhost_vq_adaptive_used_signal(vsession, virtqueue, now)) {
+					now = spdk_get_ticks();
+				}
+				continue;
+			}
+
+			if (vsession->coalescing_delay_time_base == 0) {
+				if (virtqueue->vring.desc == NULL ||
+				    vhost_vq_event_is_suppressed(virtqueue)) {
+					continue;
+				}
+
+				vhost_vq_used_signal(vsession, virtqueue);
+				continue;
+			}
+
 			/* No need for event right now */
 			if (now < virtqueue->next_event_time ||
-			    (virtqueue->vring.avail->flags & VRING_AVAIL_F_NO_INTERRUPT)) {
+			    vhost_vq_event_is_suppressed(virtqueue)) {
 				continue;
 			}
 
@@ -337,14 +709,37 @@ vhost_session_used_signal(struct spdk_vhost_session *vsession)
 	}
 }
 
+void
+vhost_session_used_signal(struct spdk_vhost_session *vsession)
+{
+	vhost_vq_group_used_signal(vsession, &vsession->group);
+}
+
 static int
 vhost_session_set_coalescing(struct spdk_vhost_dev *vdev,
 			     struct spdk_vhost_session *vsession, void *ctx)
 {
+	struct spdk_vhost_virtqueue *virtqueue;
+	uint16_t q_idx;
+
 	vsession->coalescing_delay_time_base =
 		vdev->coalescing_delay_us * spdk_get_ticks_hz() / 1000000ULL;
 	vsession->coalescing_io_rate_threshold =
 		vdev->coalescing_iops_threshold * SPDK_VHOST_STATS_CHECK_INTERVAL_MS / 1000U;
+
+	vsession->adaptive_coalescing = false;
+	for (q_idx = 0; q_idx < SPDK_VHOST_MAX_VQUEUES; q_idx++) {
+		virtqueue = &vsession->virtqueue[q_idx];
+		virtqueue->coalescing.latency_budget =
+			vdev->vq_latency_budget_us[q_idx] * spdk_get_ticks_hz() / 1000000ULL;
+		if (virtqueue->coalescing.latency_budget != 0) {
+			vsession->adaptive_coalescing = true;
+		}
+		if (virtqueue->coalescing.stats_start_tsc == 0) {
+			virtqueue->coalescing.stats_start_tsc = spdk_get_ticks();
+		}
+	}
+
 	return 0;
 }
 
@@ -397,6 +792,88 @@ spdk_vhost_get_coalescing(struct spdk_vhost_dev *vdev, uint32_t *delay_base_us,
 	}
 }
 
+int
+spdk_vhost_set_vq_coalescing(struct spdk_vhost_dev *vdev, uint16_t vq_idx,
+			     uint32_t latency_budget_us)
+{
+	if (vq_idx >= SPDK_VHOST_MAX_VQUEUES) {
+		SPDK_ERRLOG("Virtqueue index %"PRIu16" is invalid (max %u)\n", vq_idx,
+			    SPDK_VHOST_MAX_VQUEUES - 1);
+		return -EINVAL;
+	}
+
+	vdev->vq_latency_budget_us[vq_idx] = latency_budget_us;
+	vhost_dev_foreach_session(vdev, vhost_session_set_coalescing, NULL, NULL);
+	return 0;
+}
+
+uint32_t
+spdk_vhost_get_vq_coalescing(struct spdk_vhost_dev *vdev, uint16_t vq_idx)
+{
+	if (vq_idx >= SPDK_VHOST_MAX_VQUEUES) {
+		return 0;
+	}
+
+	return vdev->vq_latency_budget_us[vq_idx];
+}
+
+static void
+vhost_vq_coalescing_completed(struct spdk_vhost_virtqueue *virtqueue)
+{
+	uint64_t now, interval;
+
+	if (spdk_likely(virtqueue->coalescing.inflight > 0)) {
+		virtqueue->coalescing.inflight--;
+	}
+
+	if (virtqueue->coalescing.latency_budget == 0) {
+		return;
+	}
+
+	now = spdk_get_ticks();
+	if (virtqueue->coalescing.pending++ == 0) {
+		virtqueue->coalescing.first_pending_tsc = now;
+	}
+	virtqueue->coalescing.pending_tsc_sum += now;
+
+	/* Exponential moving average with 1/8 weight of the newest sample */
+	if (virtqueue->coalescing.last_completion_tsc != 0) {
+		interval = now - virtqueue->coalescing.last_completion_tsc;
+		virtqueue->coalescing.avg_completion_interval +=
+			(int64_t)(interval - virtqueue->coalescing.avg_completion_interval) / 8;
+	}
+	virtqueue->coalescing.last_completion_tsc = now;
+}
+
+static void
+vhost_vq_packed_ring_enqueue(struct spdk_vhost_session *vsession,
+			     struct spdk_vhost_virtqueue *virtqueue,
+			     uint16_t buffer_id, uint32_t len)
+{
+	uint16_t last_idx = virtqueue->last_used_idx;
+
+	SPDK_DEBUGLOG(SPDK_LOG_VHOST_RING,
+		      "Queue %td - USED RING: last_idx=%"PRIu16" buffer id=%"PRIu16" len=%"PRIu32"\n",
+		      virtqueue - vsession->virtqueue, last_idx, buffer_id, len);
+
+	if (spdk_unlikely(buffer_id >= virtqueue->vring.size)) {
+		SPDK_ERRLOG("%s: buffer ID %"PRIu16" exceeds virtqueue size (%"PRIu16").\n",
+			    vsession->name, buffer_id, virtqueue->vring.size);
+		return;
+	}
+
+	/* There's no dirty page logging here. Unlike in split virtqueues, the
+	 * descriptors of a completed chain may already be overwritten by the used
+	 * entries of other chains, so its buffers can't be walked and logged.
+	 * Devices with packed virtqueues don't offer VHOST_F_LOG_ALL instead.
+	 */
+	vhost_vq_packed_desc_mark_used(virtqueue, buffer_id,
+				       virtqueue->packed.bufs[buffer_id].num_descs, len);
+
+	virtqueue->used_req_cnt++;
+	vhost_vq_coalescing_completed(virtqueue);
+}
+
 /*
  * Enqueue id and len to used ring.
  */
@@ -410,11 +887,22 @@ vhost_vq_used_ring_enqueue(struct spdk_vhost_session *vsession,
 	uint16_t last_idx = virtqueue->last_used_idx & (vring->size - 1);
 	uint16_t vq_idx = virtqueue->vring_idx;
 
+	if (virtqueue->packed.packed_ring) {
+		vhost_vq_packed_ring_enqueue(vsession, virtqueue, id, len);
+		return;
+	}
+
 	SPDK_DEBUGLOG(SPDK_LOG_VHOST_RING,
 		      "Queue %td - USED RING: last_idx=%"PRIu16" req id=%"PRIu16" len=%"PRIu32"\n",
 		      virtqueue - vsession->virtqueue, virtqueue->last_used_idx, id, len);
 
-	vhost_log_req_desc(vsession, virtqueue, id);
+	/* Dirty page logging is only needed during live migration. The log
+	 * updates are buffered, so the used ring can be logged before it's
+	 * written, as long as the buffer isn't flushed in between.
+	 */
+	if (spdk_unlikely(vsession->log.enabled)) {
+		vhost_log_req_desc(vsession, virtqueue, id);
+	}
 
 	virtqueue->last_used_idx++;
 	used->ring[last_idx].id = id;
@@ -425,13 +913,16 @@ vhost_vq_used_ring_enqueue(struct spdk_vhost_session *vsession,
 
 	rte_vhost_set_last_inflight_io_split(vsession->vid, vq_idx, id);
 
-	vhost_log_used_vring_elem(vsession, virtqueue, last_idx);
 	* (volatile uint16_t *) &used->idx = virtqueue->last_used_idx;
-	vhost_log_used_vring_idx(vsession, virtqueue);
+	if (spdk_unlikely(vsession->log.enabled)) {
+		vhost_log_used_vring_elem(vsession, virtqueue, last_idx);
+		vhost_log_used_vring_idx(vsession, virtqueue);
+	}
 
 	rte_vhost_clr_inflight_desc_split(vsession->vid, vq_idx, virtqueue->last_used_idx, id);
 
 	virtqueue->used_req_cnt++;
+	vhost_vq_coalescing_completed(virtqueue);
 }
 
 int
@@ -621,6 +1112,19 @@ vhost_dev_register(struct spdk_vhost_dev *vdev, const char *name, const char *ma
 		return -EEXIST;
 	}
 
+	if (vdev->packed_ring) {
+#ifdef SPDK_CONFIG_VHOST_INTERNAL_LIB
+		SPDK_ERRLOG("Packed virtqueues are not supported with the internal vhost library.\n");
+		return -ENOTSUP;
+#else
+		vdev->virtio_features |= (1ULL << VIRTIO_F_RING_PACKED);
+		/* The buffers of packed virtqueues are not logged as dirty, so
+		 * live migration is not supported, see vhost_vq_packed_ring_enqueue()
+		 */
+		vdev->virtio_features &= ~(1ULL << VHOST_F_LOG_ALL);
+#endif
+	}
+
 	if (snprintf(path, sizeof(path), "%s%s", dev_dirname, name) >= (int)sizeof(path)) {
 		SPDK_ERRLOG("Resulting socket path for controller %s is too long: %s%s\n", name, dev_dirname,
 			    name);
@@ -866,11 +1370,48 @@ vhost_dev_foreach_session(struct spdk_vhost_dev *vdev,
 	spdk_thread_send_msg(vdev->thread, foreach_session, ev_ctx);
 }
 
+static void
+vhost_session_free_packed_rings(struct spdk_vhost_session *vsession)
+{
+	struct spdk_vhost_virtqueue *q;
+	uint16_t i;
+
+	for (i = 0; i < vsession->max_queues; i++) {
+		q = &vsession->virtqueue[i];
+		free(q->packed.bufs);
+		q->packed.bufs = NULL;
+		free(q->packed.desc_table);
+		q->packed.desc_table = NULL;
+	}
+}
+
+static int
+vhost_vq_packed_ring_init(struct spdk_vhost_virtqueue *q)
+{
+	/* Packed virtqueues have at most 2^15 entries, so the ring
+	 * bases carry the wrap counters in their most significant bit.
+	 */
+	q->packed.packed_ring = true;
+	q->packed.avail_phase = q->last_avail_idx >> 15;
+	q->last_avail_idx &= 0x7FFF;
+	q->packed.used_phase = q->last_used_idx >> 15;
+	q->last_used_idx &= 0x7FFF;
+
+	q->packed.bufs = calloc(q->vring.size, sizeof(*q->packed.bufs));
+	q->packed.desc_table = calloc(q->vring.size, sizeof(*q->packed.desc_table));
+	if (q->packed.bufs == NULL || q->packed.desc_table == NULL) {
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
 static int
 _stop_session(struct spdk_vhost_session *vsession)
 {
 	struct spdk_vhost_dev *vdev = vsession->vdev;
 	struct spdk_vhost_virtqueue *q;
+	uint16_t last_avail_idx, last_used_idx;
 	int rc;
 	uint16_t i;
 
@@ -881,14 +1422,28 @@ _stop_session(struct spdk_vhost_session *vsession)
 		return rc;
 	}
 
+	/* The master syncs the dirty log once the rings are stopped, so the
+	 * last pending updates have to be written now. Backends flush any
+	 * other groups they use when stopping them.
+	 */
+	vhost_vq_group_log_flush(vsession, &vsession->group);
+
 	for (i = 0; i < vsession->max_queues; i++) {
 		q = &vsession->virtqueue[i];
 		if (q->vring.desc == NULL) {
 			continue;
 		}
-		rte_vhost_set_vring_base(vsession->vid, i, q->last_avail_idx, q->last_used_idx);
+
+		last_avail_idx = q->last_avail_idx;
+		last_used_idx = q->last_used_idx;
+		if (q->packed.packed_ring) {
+			last_avail_idx |= (uint16_t)q->packed.avail_phase << 15;
+			last_used_idx |= (uint16_t)q->packed.used_phase << 15;
+		}
+		rte_vhost_set_vring_base(vsession->vid, i, last_avail_idx, last_used_idx);
 	}
 
+	vhost_session_free_packed_rings(vsession);
 	vhost_session_mem_unregister(vsession->mem);
 	free(vsession->mem);
 
@@ -944,8 +1499,16 @@ vhost_start_device_cb(int vid)
 		goto out;
 	}
 
+	if (vhost_get_negotiated_features(vid, &vsession->negotiated_features) != 0) {
+		SPDK_ERRLOG("vhost device %d: Failed to get negotiated driver features\n", vid);
+		goto out;
+	}
+
+	vhost_session_log_init(vsession);
+
 	vsession->max_queues = 0;
 	memset(vsession->virtqueue, 0, sizeof(vsession->virtqueue));
+	vhost_vq_group_init(vsession, &vsession->group, vdev->thread, 0, 1);
 	for (i = 0; i < SPDK_VHOST_MAX_VQUEUES; i++) {
 		struct spdk_vhost_virtqueue *q = &vsession->virtqueue[i];
 
@@ -965,18 +1528,26 @@ vhost_start_device_cb(int vid)
 			continue;
 		}
 
-		/* Disable I/O submission notifications, we'll be polling. */
-		q->vring.used->flags = VRING_USED_F_NO_NOTIFY;
 		vsession->max_queues = i + 1;
-	}
+		if (vhost_dev_has_feature(vsession, VIRTIO_F_RING_PACKED)) {
+			if (vhost_vq_packed_ring_init(q) != 0) {
+				SPDK_ERRLOG("vhost device %d: Failed to allocate packed virtqueue %"PRIu16"\n",
+					    vid, i);
+				vhost_session_free_packed_rings(vsession);
+				goto out;
+			}
 
-	if (vhost_get_negotiated_features(vid, &vsession->negotiated_features) != 0) {
-		SPDK_ERRLOG("vhost device %d: Failed to get negotiated driver features\n", vid);
-		goto out;
+			/* Disable I/O submission notifications, we'll be polling. */
+			q->vring.device_event->flags = VRING_PACKED_EVENT_FLAG_DISABLE;
+		} else {
+			/* Disable I/O submission notifications, we'll be polling. */
+			q->vring.used->flags = VRING_USED_F_NO_NOTIFY;
+		}
 	}
 
 	if (vhost_get_mem_table(vid, &vsession->mem) != 0) {
 		SPDK_ERRLOG("vhost device %d: Failed to get guest memory table\n", vid);
+		vhost_session_free_packed_rings(vsession);
 		goto out;
 	}
 
@@ -1002,6 +1573,7 @@ vhost_start_device_cb(int vid)
 	vsession->initialized = true;
 	rc = vdev->backend->start_session(vsession);
 	if (rc != 0) {
+		vhost_session_free_packed_rings(vsession);
 		vhost_session_mem_unregister(vsession->mem);
 		free(vsession->mem);
 		goto out;
@@ -1093,6 +1665,56 @@ vhost_dump_info_json(struct spdk_vhost_dev *vdev, struct spdk_json_write_ctx *w)
 	vdev->backend->dump_info_json(vdev, w);
 }
 
+void
+vhost_dump_vq_coalescing_json(struct spdk_vhost_dev *vdev, struct spdk_json_write_ctx *w)
+{
+	struct spdk_vhost_session *vsession;
+	struct spdk_vhost_virtqueue *virtqueue;
+	uint64_t events, completions, added_latency;
+	uint64_t ticks_hz = spdk_get_ticks_hz();
+	uint64_t now = spdk_get_ticks();
+	double event_rate;
+	uint16_t q_idx;
+
+	spdk_json_write_named_array_begin(w, "vq_coalescing");
+	for (q_idx = 0; q_idx < SPDK_VHOST_MAX_VQUEUES; q_idx++) {
+		if (vdev->vq_latency_budget_us[q_idx] == 0) {
+			continue;
+		}
+
+		/* The counters are updated by the session threads without any
+		 * locking, so the sums below are only approximate.
+		 */
+		events = completions = added_latency = 0;
+		event_rate = 0;
+		TAILQ_FOREACH(vsession, &vdev->vsessions, tailq) {
+			if (!vsession->started || q_idx >= vsession->max_queues) {
+				continue;
+			}
+
+			virtqueue = &vsession->virtqueue[q_idx];
+			events += virtqueue->coalescing.events;
+			completions += virtqueue->coalescing.completions;
+			added_latency += virtqueue->coalescing.added_latency;
+			if (now > virtqueue->coalescing.stats_start_tsc) {
+				event_rate += (double)virtqueue->coalescing.events * ticks_hz /
+					      (now - virtqueue->coalescing.stats_start_tsc);
+			}
+		}
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_uint32(w, "vq_idx", q_idx);
+		spdk_json_write_named_uint32(w, "latency_budget_us", vdev->vq_latency_budget_us[q_idx]);
+		spdk_json_write_named_uint64(w, "events", events);
+		spdk_json_write_named_uint64(w, "completions", completions);
+		spdk_json_write_named_uint64(w, "events_per_second", (uint64_t)event_rate);
+		spdk_json_write_named_uint64(w, "avg_added_latency_us", completions == 0 ? 0 :
+					     added_latency / completions * 1000000ULL / ticks_hz);
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+}
+
 int
 spdk_vhost_dev_remove(struct spdk_vhost_dev *vdev)
 {
@@ -1148,7 +1770,6 @@ vhost_new_connection_cb(int vid, const char *ifname)
 	}
 	vsession->started = false;
 	vsession->initialized = false;
-	vsession->next_stats_check_time = 0;
 	vsession->stats_check_interval = SPDK_VHOST_STATS_CHECK_INTERVAL_MS *
 					 spdk_get_ticks_hz() / 1000UL;
 	TAILQ_INSERT_TAIL(&vdev->vsessions, vsession, tailq);
@@ -1319,6 +1940,7 @@ spdk_vhost_config_json(struct spdk_json_write_ctx *w)
 	struct spdk_vhost_dev *vdev;
 	uint32_t delay_base_us;
 	uint32_t iops_threshold;
+	uint16_t q_idx;
 
 	spdk_json_write_array_begin(w);
 
@@ -1340,6 +1962,23 @@ spdk_vhost_config_json(struct spdk_json_write_ctx *w)
 
 			spdk_json_write_object_end(w);
 		}
+
+		for (q_idx = 0; q_idx < SPDK_VHOST_MAX_VQUEUES; q_idx++) {
+			if (vdev->vq_latency_budget_us[q_idx] == 0) {
+				continue;
+			}
+
+			spdk_json_write_object_begin(w);
+			spdk_json_write_named_string(w, "method", "vhost_controller_set_vq_coalescing");
+
+			spdk_json_write_named_object_begin(w, "params");
+			spdk_json_write_named_string(w, "ctrlr", vdev->name);
+			spdk_json_write_named_uint32(w, "vq_idx", q_idx);
+			spdk_json_write_named_uint32(w, "latency_budget_us", vdev->vq_latency_budget_us[q_idx]);
+			spdk_json_write_object_end(w);
+
+			spdk_json_write_object_end(w);
+		}
 		vdev = spdk_vhost_dev_next(vdev);
 	}
 	spdk_vhost_unlock();
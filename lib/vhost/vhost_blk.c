@@ -69,6 +69,7 @@
 struct spdk_vhost_blk_task {
 	struct spdk_bdev_io *bdev_io;
 	struct spdk_vhost_blk_session *bvsession;
+	struct spdk_vhost_blk_poll_group *pg;
 	struct spdk_vhost_virtqueue *vq;
 
 	volatile uint8_t *status;
@@ -83,6 +84,8 @@ struct spdk_vhost_blk_task {
 
 	/** Number of bytes that were written. */
 	uint32_t used_len;
+	/** Length of the data payload, without the request header and status. */
+	uint32_t payload_len;
 	uint16_t iovcnt;
 	struct iovec iovs[SPDK_VHOST_IOVS_MAX];
 };
@@ -92,30 +95,63 @@ struct spdk_vhost_blk_dev {
 	struct spdk_bdev *bdev;
 	struct spdk_bdev_desc *bdev_desc;
 	bool readonly;
+
+	/* Threads polling the virtqueues of multi-queue sessions, one per
+	 * core of the device cpumask. Not used if the cpumask has one core.
+	 */
+	struct spdk_thread **io_threads;
+	uint32_t io_thread_cnt;
+	/* First io_thread used by the next multi-queue session */
+	uint32_t next_io_thread;
+
+	/* The bdev is being hot-removed */
+	bool bdev_removing;
+	/* Thread bdev_remove_cb() was called on */
+	struct spdk_thread *bdev_remove_thread;
+	/* Poll groups yet to stop using the hot-removed bdev, plus the
+	 * completion of the removal while it's being sent to bdev_remove_thread
+	 */
+	uint32_t bdev_remove_pending;
+	/* Close the bdev once bdev_remove_pending drops to 0 */
+	bool bdev_close_pending;
+};
+
+/* Virtqueues of a session polled by one thread, each with its own I/O channel */
+struct spdk_vhost_blk_poll_group {
+	struct spdk_vhost_vq_group group;
+	struct spdk_vhost_blk_session *bvsession;
+	struct spdk_poller *requestq_poller;
+	struct spdk_io_channel *io_channel;
+	struct spdk_poller *stop_poller;
 };
 
 struct spdk_vhost_blk_session {
 	/* The parent session must be the very first field in this struct */
 	struct spdk_vhost_session vsession;
 	struct spdk_vhost_blk_dev *bvdev;
-	struct spdk_poller *requestq_poller;
-	struct spdk_io_channel *io_channel;
-	struct spdk_poller *stop_poller;
+
+	struct spdk_vhost_blk_poll_group *poll_groups;
+	uint16_t poll_group_cnt;
+	/* Poll group being started or stopped */
+	uint16_t poll_group_idx;
+	/* Result of starting the poll groups */
+	int start_rc;
+	/* Poll groups yet to stop using the hot-removed bdev. The poll groups
+	 * are not freed by a session stop before they are done.
+	 */
+	uint32_t bdev_remove_pending;
 };
 
 /* forward declaration */
 static const struct spdk_vhost_dev_backend vhost_blk_device_backend;
 
-static int
-process_blk_request(struct spdk_vhost_blk_task *task,
-		    struct spdk_vhost_blk_session *bvsession,
-		    struct spdk_vhost_virtqueue *vq);
+static int submit_blk_request(struct spdk_vhost_blk_task *task);
 
 static void
 blk_task_finish(struct spdk_vhost_blk_task *task)
 {
-	assert(task->bvsession->vsession.task_cnt > 0);
-	task->bvsession->vsession.task_cnt--;
+	assert(task->pg->group.task_cnt > 0);
+	task->pg->group.task_cnt--;
 	task->used = false;
 }
 
@@ -246,9 +282,10 @@ blk_request_resubmit(void *arg)
 	struct spdk_vhost_blk_task *task = (struct spdk_vhost_blk_task *)arg;
 	int rc = 0;
 
-	blk_task_init(task);
-
-	rc = process_blk_request(task, task->bvsession, task->vq);
+	/* The request was already parsed. Don't walk its descriptors again,
+	 * in packed virtqueues they may be overwritten by now.
+	 */
+	rc = submit_blk_request(task);
 	if (rc == 0) {
 		SPDK_DEBUGLOG(SPDK_LOG_VHOST_BLK, "====== Task %p resubmitted ======\n", task);
 	} else {
@@ -267,7 +304,7 @@ blk_request_queue_io(struct spdk_vhost_blk_task *task)
 	task->bdev_io_wait.cb_fn = blk_request_resubmit;
 	task->bdev_io_wait.cb_arg = task;
 
-	rc = spdk_bdev_queue_io_wait(bdev, bvsession->io_channel, &task->bdev_io_wait);
+	rc = spdk_bdev_queue_io_wait(bdev, task->pg->io_channel, &task->bdev_io_wait);
 	if (rc != 0) {
 		SPDK_ERRLOG("%s: failed to queue I/O, rc=%d\n", bvsession->vsession.name, rc);
 		invalid_blk_request(task, VIRTIO_BLK_S_IOERR);
@@ -279,14 +316,9 @@ process_blk_request(struct spdk_vhost_blk_task *task,
 		    struct spdk_vhost_blk_session *bvsession,
 		    struct spdk_vhost_virtqueue *vq)
 {
-	struct spdk_vhost_blk_dev *bvdev = bvsession->bvdev;
 	const struct virtio_blk_outhdr *req;
-	struct virtio_blk_discard_write_zeroes *desc;
 	struct iovec *iov;
-	uint32_t type;
 	uint32_t payload_len;
-	uint64_t flush_bytes;
-	int rc;
 
 	if (blk_iovs_setup(bvsession, vq, task->req_idx, task->iovs, &task->iovcnt, &payload_len)) {
 		SPDK_DEBUGLOG(SPDK_LOG_VHOST_BLK, "Invalid request (req_idx = %"PRIu16").\n", task->req_idx);
@@ -318,6 +350,22 @@ process_blk_request(struct spdk_vhost_blk_task *task,
 	task->status = iov->iov_base;
 	payload_len -= sizeof(*req) + sizeof(*task->status);
 	task->iovcnt -= 2;
+	task->payload_len = payload_len;
+
+	return submit_blk_request(task);
+}
+
+static int
+submit_blk_request(struct spdk_vhost_blk_task *task)
+{
+	struct spdk_vhost_blk_dev *bvdev = task->bvsession->bvdev;
+	struct spdk_io_channel *ch = task->pg->io_channel;
+	const struct virtio_blk_outhdr *req = task->iovs[0].iov_base;
+	struct virtio_blk_discard_write_zeroes *desc;
+	uint32_t payload_len = task->payload_len;
+	uint32_t type;
+	uint64_t flush_bytes;
+	int rc;
 
 	type = req->type;
 #ifdef VIRTIO_BLK_T_BARRIER
@@ -337,12 +385,12 @@ process_blk_request(struct spdk_vhost_blk_task *task,
 
 		if (type == VIRTIO_BLK_T_IN) {
 			task->used_len = payload_len + sizeof(*task->status);
-			rc = spdk_bdev_readv(bvdev->bdev_desc, bvsession->io_channel,
+			rc = spdk_bdev_readv(bvdev->bdev_desc, ch,
 					     &task->iovs[1], task->iovcnt, req->sector * 512,
 					     payload_len, blk_request_complete_cb, task);
 		} else if (!bvdev->readonly) {
 			task->used_len = sizeof(*task->status);
-			rc = spdk_bdev_writev(bvdev->bdev_desc, bvsession->io_channel,
+			rc = spdk_bdev_writev(bvdev->bdev_desc, ch,
 					      &task->iovs[1], task->iovcnt, req->sector * 512,
 					      payload_len, blk_request_complete_cb, task);
 		} else {
@@ -368,7 +416,7 @@ process_blk_request(struct spdk_vhost_blk_task *task,
 			return -1;
 		}
 
-		rc = spdk_bdev_unmap(bvdev->bdev_desc, bvsession->io_channel,
+		rc = spdk_bdev_unmap(bvdev->bdev_desc, ch,
 				     desc->sector * 512, desc->num_sectors * 512,
 				     blk_request_complete_cb, task);
 		if (rc) {
@@ -396,7 +444,7 @@ process_blk_request(struct spdk_vhost_blk_task *task,
 			return -1;
 		}
 
-		rc = spdk_bdev_write_zeroes(bvdev->bdev_desc, bvsession->io_channel,
+		rc = spdk_bdev_write_zeroes(bvdev->bdev_desc, ch,
 					    desc->sector * 512, desc->num_sectors * 512,
 					    blk_request_complete_cb, task);
 		if (rc) {
@@ -416,7 +464,7 @@ process_blk_request(struct spdk_vhost_blk_task *task,
 			invalid_blk_request(task, VIRTIO_BLK_S_IOERR);
 			return -1;
 		}
-		rc = spdk_bdev_flush(bvdev->bdev_desc, bvsession->io_channel,
+		rc = spdk_bdev_flush(bvdev->bdev_desc, ch,
 				     0, flush_bytes,
 				     blk_request_complete_cb, task);
 		if (rc) {
@@ -462,7 +510,7 @@ process_blk_task(struct spdk_vhost_virtqueue *vq, uint16_t req_idx)
 		return;
 	}
 
-	task->bvsession->vsession.task_cnt++;
+	task->pg->group.task_cnt++;
 
 	blk_task_init(task);
 
@@ -483,7 +531,9 @@ submit_inflight_desc(struct spdk_vhost_blk_session *bvsession,
 	spdk_vhost_resubmit_desc *resubmit_list;
 	uint16_t req_idx;
 
-	if (spdk_likely(resubmit == NULL || resubmit->resubmit_list == NULL)) {
+	/* Inflight descriptors are only tracked for split virtqueues. */
+	if (spdk_likely(resubmit == NULL || resubmit->resubmit_list == NULL ||
+			vq->packed.packed_ring)) {
 		return;
 	}
 
@@ -533,7 +583,9 @@ process_vq(struct spdk_vhost_blk_session *bvsession, struct spdk_vhost_virtqueue
 			continue;
 		}
 
-		rte_vhost_set_inflight_desc_split(vsession->vid, vq_idx, reqs[i]);
+		if (!vq->packed.packed_ring) {
+			rte_vhost_set_inflight_desc_split(vsession->vid, vq_idx, reqs[i]);
+		}
 
 		process_blk_task(vq, reqs[i]);
 	}
@@ -542,16 +594,16 @@ process_vq(struct spdk_vhost_blk_session *bvsession, struct spdk_vhost_virtqueue
 static int
 vdev_worker(void *arg)
 {
-	struct spdk_vhost_blk_session *bvsession = arg;
+	struct spdk_vhost_blk_poll_group *pg = arg;
+	struct spdk_vhost_blk_session *bvsession = pg->bvsession;
 	struct spdk_vhost_session *vsession = &bvsession->vsession;
-
 	uint16_t q_idx;
 
-	for (q_idx = 0; q_idx < vsession->max_queues; q_idx++) {
+	for (q_idx = pg->group.first_vq; q_idx < vsession->max_queues; q_idx += pg->group.vq_stride) {
 		process_vq(bvsession, &vsession->virtqueue[q_idx]);
 	}
 
-	vhost_session_used_signal(vsession);
+	vhost_vq_group_used_signal(vsession, &pg->group);
 
 	return -1;
 }
@@ -580,19 +632,20 @@ no_bdev_process_vq(struct spdk_vhost_blk_session *bvsession, struct spdk_vhost_v
 static int
 no_bdev_vdev_worker(void *arg)
 {
-	struct spdk_vhost_blk_session *bvsession = arg;
+	struct spdk_vhost_blk_poll_group *pg = arg;
+	struct spdk_vhost_blk_session *bvsession = pg->bvsession;
 	struct spdk_vhost_session *vsession = &bvsession->vsession;
 	uint16_t q_idx;
 
-	for (q_idx = 0; q_idx < vsession->max_queues; q_idx++) {
+	for (q_idx = pg->group.first_vq; q_idx < vsession->max_queues; q_idx += pg->group.vq_stride) {
 		no_bdev_process_vq(bvsession, &vsession->virtqueue[q_idx]);
 	}
 
-	vhost_session_used_signal(vsession);
+	vhost_vq_group_used_signal(vsession, &pg->group);
 
-	if (vsession->task_cnt == 0 && bvsession->io_channel) {
-		spdk_put_io_channel(bvsession->io_channel);
-		bvsession->io_channel = NULL;
+	if (pg->group.task_cnt == 0 && pg->io_channel) {
+		spdk_put_io_channel(pg->io_channel);
+		pg->io_channel = NULL;
 	}
 
 	return -1;
@@ -630,16 +683,93 @@ spdk_vhost_blk_get_dev(struct spdk_vhost_dev *vdev)
 }
 
 static void
-vhost_dev_bdev_remove_cpl_cb(struct spdk_vhost_dev *vdev, void *ctx)
+vhost_blk_bdev_close(struct spdk_vhost_blk_dev *bvdev)
+{
+	spdk_bdev_close(bvdev->bdev_desc);
+	bvdev->bdev_desc = NULL;
+	bvdev->bdev = NULL;
+	bvdev->bdev_close_pending = false;
+}
+
+static void
+vhost_blk_bdev_remove_cpl(void *arg)
 {
+	struct spdk_vhost_blk_dev *bvdev = arg;
+
+	if (spdk_vhost_trylock() != 0) {
+		spdk_thread_send_msg(spdk_get_thread(), vhost_blk_bdev_remove_cpl, bvdev);
+		return;
+	}
+
+	/* All sessions have been notified, time to close the bdev. Poll groups
+	 * on other threads may still be using it though, so the last one of
+	 * them closes it instead.
+	 */
+	assert(bvdev->bdev_remove_pending > 0);
+	bvdev->bdev_remove_pending--;
+	bvdev->bdev_close_pending = true;
+	if (bvdev->bdev_remove_pending == 0) {
+		vhost_blk_bdev_close(bvdev);
+	}
+
+	spdk_vhost_unlock();
+}
 
-	/* All sessions have been notified, time to close the bdev */
+static void
+vhost_dev_bdev_remove_cpl_cb(struct spdk_vhost_dev *vdev, void *ctx)
+{
 	struct spdk_vhost_blk_dev *bvdev = to_blk_dev(vdev);
 
 	assert(bvdev != NULL);
-	spdk_bdev_close(bvdev->bdev_desc);
-	bvdev->bdev_desc = NULL;
-	bvdev->bdev = NULL;
+
+	/* This runs on the vhost init thread, but the bdev has to be closed on
+	 * the thread it was opened on, which is the one bdev_remove_cb() was
+	 * called on.
+	 */
+	bvdev->bdev_remove_pending++;
+	spdk_thread_send_msg(bvdev->bdev_remove_thread, vhost_blk_bdev_remove_cpl, bvdev);
+}
+
+static void
+vhost_poll_group_bdev_remove_done(void *arg)
+{
+	struct spdk_vhost_blk_session *bvsession = arg;
+	struct spdk_vhost_blk_dev *bvdev = bvsession->bvdev;
+
+	if (spdk_vhost_trylock() != 0) {
+		spdk_thread_send_msg(spdk_get_thread(), vhost_poll_group_bdev_remove_done, bvsession);
+		return;
+	}
+
+	assert(bvsession->bdev_remove_pending > 0);
+	bvsession->bdev_remove_pending--;
+	assert(bvdev->bdev_remove_pending > 0);
+	bvdev->bdev_remove_pending--;
+	if (bvdev->bdev_remove_pending == 0 && bvdev->bdev_close_pending) {
+		vhost_blk_bdev_close(bvdev);
+	}
+
+	spdk_vhost_unlock();
+}
+
+static void
+poll_group_bdev_remove(struct spdk_vhost_blk_poll_group *pg)
+{
+	if (pg->requestq_poller) {
+		spdk_poller_unregister(&pg->requestq_poller);
+		pg->requestq_poller = spdk_poller_register(no_bdev_vdev_worker, pg, 0);
+	}
+}
+
+static void
+vhost_poll_group_bdev_remove(void *arg)
+{
+	struct spdk_vhost_blk_poll_group *pg = arg;
+	struct spdk_vhost_blk_session *bvsession = pg->bvsession;
+
+	poll_group_bdev_remove(pg);
+	spdk_thread_send_msg(bvsession->bvdev->bdev_remove_thread, vhost_poll_group_bdev_remove_done,
+			     bvsession);
 }
 
 static int
@@ -648,11 +778,25 @@ vhost_session_bdev_remove_cb(struct spdk_vhost_dev *vdev,
 			     void *ctx)
 {
 	struct spdk_vhost_blk_session *bvsession;
+	struct spdk_vhost_blk_poll_group *pg;
+	uint16_t i;
 
 	bvsession = (struct spdk_vhost_blk_session *)vsession;
-	if (bvsession->requestq_poller) {
-		spdk_poller_unregister(&bvsession->requestq_poller);
-		bvsession->requestq_poller = spdk_poller_register(no_bdev_vdev_worker, bvsession, 0);
+
+	/* Even if the session is stopping, the poll groups that are not stopped
+	 * yet keep submitting I/O, so every one of them has to be switched away
+	 * from the bdev. Groups that have stopped polling are left as they are.
+	 */
+	for (i = 0; i < bvsession->poll_group_cnt; i++) {
+		pg = &bvsession->poll_groups[i];
+		if (pg->group.thread == spdk_get_thread()) {
+			poll_group_bdev_remove(pg);
+			continue;
+		}
+
+		bvsession->bdev_remove_pending++;
+		bvsession->bvdev->bdev_remove_pending++;
+		spdk_thread_send_msg(pg->group.thread, vhost_poll_group_bdev_remove, pg);
 	}
 
 	return 0;
@@ -667,6 +811,8 @@ bdev_remove_cb(void *remove_ctx)
 		     bvdev->vdev.name);
 
 	spdk_vhost_lock();
+	bvdev->bdev_removing = true;
+	bvdev->bdev_remove_thread = spdk_get_thread();
 	vhost_dev_foreach_session(&bvdev->vdev, vhost_session_bdev_remove_cb,
 				  vhost_dev_bdev_remove_cpl_cb, NULL);
 	spdk_vhost_unlock();
@@ -727,6 +873,7 @@ alloc_task_pool(struct spdk_vhost_blk_session *bvsession)
 		for (j = 0; j < task_cnt; j++) {
 			task = &((struct spdk_vhost_blk_task *)vq->tasks)[j];
 			task->bvsession = bvsession;
+			task->pg = SPDK_CONTAINEROF(vq->group, struct spdk_vhost_blk_poll_group, group);
 			task->req_idx = j;
 			task->vq = vq;
 		}
@@ -735,12 +882,220 @@ alloc_task_pool(struct spdk_vhost_blk_session *bvsession)
 	return 0;
 }
 
+static void vhost_blk_poll_group_stop(void *arg);
+
+static void
+vhost_blk_session_stopped(void *arg)
+{
+	struct spdk_vhost_blk_session *bvsession = arg;
+	struct spdk_vhost_session *vsession = &bvsession->vsession;
+
+	if (spdk_vhost_trylock() != 0) {
+		spdk_thread_send_msg(spdk_get_thread(), vhost_blk_session_stopped, bvsession);
+		return;
+	}
+
+	if (bvsession->bdev_remove_pending > 0) {
+		/* Wait for the poll groups to be switched away from a hot-removed bdev */
+		spdk_vhost_unlock();
+		spdk_thread_send_msg(spdk_get_thread(), vhost_blk_session_stopped, bvsession);
+		return;
+	}
+
+	free_task_pool(bvsession);
+	free(bvsession->poll_groups);
+	bvsession->poll_groups = NULL;
+	bvsession->poll_group_cnt = 0;
+
+	if (bvsession->start_rc != 0) {
+		/* The session failed to start and was stopped right away */
+		vhost_session_start_done(vsession, bvsession->start_rc);
+	} else {
+		vhost_session_stop_done(vsession, 0);
+	}
+
+	spdk_vhost_unlock();
+}
+
+static void
+vhost_blk_poll_group_stopped(void *arg)
+{
+	struct spdk_vhost_blk_session *bvsession = arg;
+	struct spdk_vhost_blk_poll_group *pg;
+
+	bvsession->poll_group_idx++;
+	if (bvsession->poll_group_idx < bvsession->poll_group_cnt) {
+		pg = &bvsession->poll_groups[bvsession->poll_group_idx];
+		spdk_thread_send_msg(pg->group.thread, vhost_blk_poll_group_stop, pg);
+		return;
+	}
+
+	vhost_blk_session_stopped(bvsession);
+}
+
+static int
+destroy_poll_group_poller_cb(void *arg)
+{
+	struct spdk_vhost_blk_poll_group *pg = arg;
+	struct spdk_vhost_session *vsession = &pg->bvsession->vsession;
+	uint16_t i;
+
+	if (pg->group.task_cnt > 0) {
+		return -1;
+	}
+
+	for (i = pg->group.first_vq; i < vsession->max_queues; i += pg->group.vq_stride) {
+		vsession->virtqueue[i].next_event_time = 0;
+		vhost_vq_used_signal(vsession, &vsession->virtqueue[i]);
+	}
+
+	vhost_vq_group_log_flush(vsession, &pg->group);
+
+	SPDK_INFOLOG(SPDK_LOG_VHOST, "%s: stopping poller on lcore %d\n",
+		     vsession->name, spdk_env_get_current_core());
+
+	if (pg->io_channel) {
+		spdk_put_io_channel(pg->io_channel);
+		pg->io_channel = NULL;
+	}
+
+	spdk_poller_unregister(&pg->stop_poller);
+	spdk_thread_send_msg(vsession->vdev->thread, vhost_blk_poll_group_stopped, pg->bvsession);
+	return -1;
+}
+
+static void
+vhost_blk_poll_group_stop(void *arg)
+{
+	struct spdk_vhost_blk_poll_group *pg = arg;
+
+	spdk_poller_unregister(&pg->requestq_poller);
+	pg->stop_poller = spdk_poller_register(destroy_poll_group_poller_cb, pg, 1000);
+}
+
+/*
+ * Poll groups are started and stopped one by one, each on its own thread,
+ * with the device thread driving the sequence. If any of them fails to
+ * start, the ones started so far are stopped before the session start is
+ * reported as failed.
+ */
+static void vhost_blk_poll_group_start(void *arg);
+
+static void
+vhost_blk_session_started(void *arg)
+{
+	struct spdk_vhost_blk_session *bvsession = arg;
+
+	if (spdk_vhost_trylock() != 0) {
+		spdk_thread_send_msg(spdk_get_thread(), vhost_blk_session_started, bvsession);
+		return;
+	}
+
+	vhost_session_start_done(&bvsession->vsession, 0);
+	spdk_vhost_unlock();
+}
+
+static void
+vhost_blk_poll_group_started(void *arg)
+{
+	struct spdk_vhost_blk_session *bvsession = arg;
+	struct spdk_vhost_blk_poll_group *pg;
+
+	if (bvsession->start_rc != 0) {
+		bvsession->poll_group_idx = 0;
+		pg = &bvsession->poll_groups[0];
+		spdk_thread_send_msg(pg->group.thread, vhost_blk_poll_group_stop, pg);
+		return;
+	}
+
+	bvsession->poll_group_idx++;
+	if (bvsession->poll_group_idx < bvsession->poll_group_cnt) {
+		pg = &bvsession->poll_groups[bvsession->poll_group_idx];
+		spdk_thread_send_msg(pg->group.thread, vhost_blk_poll_group_start, pg);
+		return;
+	}
+
+	vhost_blk_session_started(bvsession);
+}
+
+static void
+vhost_blk_poll_group_start(void *arg)
+{
+	struct spdk_vhost_blk_poll_group *pg = arg;
+	struct spdk_vhost_blk_session *bvsession = pg->bvsession;
+	struct spdk_vhost_blk_dev *bvdev = bvsession->bvdev;
+	struct spdk_vhost_session *vsession = &bvsession->vsession;
+
+	if (bvdev->bdev && !bvdev->bdev_removing) {
+		pg->io_channel = spdk_bdev_get_io_channel(bvdev->bdev_desc);
+		if (!pg->io_channel) {
+			SPDK_ERRLOG("%s: I/O channel allocation failed\n", vsession->name);
+			bvsession->start_rc = -1;
+			goto out;
+		}
+	}
+
+	pg->requestq_poller = spdk_poller_register(pg->io_channel ? vdev_worker : no_bdev_vdev_worker,
+			      pg, 0);
+	SPDK_INFOLOG(SPDK_LOG_VHOST, "%s: started poller on lcore %d\n",
+		     vsession->name, spdk_env_get_current_core());
+out:
+	spdk_thread_send_msg(vsession->vdev->thread, vhost_blk_poll_group_started, bvsession);
+}
+
+static int
+alloc_poll_groups(struct spdk_vhost_blk_session *bvsession)
+{
+	struct spdk_vhost_session *vsession = &bvsession->vsession;
+	struct spdk_vhost_blk_dev *bvdev = bvsession->bvdev;
+	struct spdk_vhost_blk_poll_group *pg;
+	struct spdk_thread *thread;
+	uint16_t cnt, i;
+
+	/* Spread the virtqueues of multi-queue sessions over the cores of the
+	 * device cpumask, one poll group per core at most.
+	 */
+	cnt = 1;
+	if (bvdev->io_thread_cnt > 1 && vsession->max_queues > 1) {
+		cnt = spdk_min(bvdev->io_thread_cnt, vsession->max_queues);
+	}
+
+	bvsession->poll_groups = calloc(cnt, sizeof(*bvsession->poll_groups));
+	if (bvsession->poll_groups == NULL) {
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < cnt; i++) {
+		pg = &bvsession->poll_groups[i];
+		if (cnt == 1) {
+			thread = vsession->vdev->thread;
+		} else {
+			thread = bvdev->io_threads[(bvdev->next_io_thread + i) % bvdev->io_thread_cnt];
+		}
+
+		vhost_vq_group_init(vsession, &pg->group, thread, i, cnt);
+		pg->bvsession = bvsession;
+	}
+
+	if (cnt > 1) {
+		bvdev->next_io_thread = (bvdev->next_io_thread + cnt) % bvdev->io_thread_cnt;
+		SPDK_INFOLOG(SPDK_LOG_VHOST, "%s: polling %"PRIu16" virtqueues on %"PRIu16" threads\n",
+			     vsession->name, vsession->max_queues, cnt);
+	}
+
+	bvsession->poll_group_cnt = cnt;
+	bvsession->poll_group_idx = 0;
+	bvsession->start_rc = 0;
+	return 0;
+}
+
 static int
 vhost_blk_start_cb(struct spdk_vhost_dev *vdev,
 		   struct spdk_vhost_session *vsession, void *unused)
 {
 	struct spdk_vhost_blk_session *bvsession = to_blk_session(vsession);
 	struct spdk_vhost_blk_dev *bvdev;
+	struct spdk_vhost_blk_poll_group *pg;
 	int i, rc = 0;
 
 	bvdev = to_blk_dev(vdev);
@@ -756,26 +1111,25 @@ vhost_blk_start_cb(struct spdk_vhost_dev *vdev,
 		}
 	}
 
-	rc = alloc_task_pool(bvsession);
+	rc = alloc_poll_groups(bvsession);
 	if (rc != 0) {
-		SPDK_ERRLOG("%s: failed to alloc task pool.\n", vsession->name);
+		SPDK_ERRLOG("%s: failed to alloc poll groups.\n", vsession->name);
 		goto out;
 	}
 
-	if (bvdev->bdev) {
-		bvsession->io_channel = spdk_bdev_get_io_channel(bvdev->bdev_desc);
-		if (!bvsession->io_channel) {
-			free_task_pool(bvsession);
-			SPDK_ERRLOG("%s: I/O channel allocation failed\n", vsession->name);
-			rc = -1;
-			goto out;
-		}
+	rc = alloc_task_pool(bvsession);
+	if (rc != 0) {
+		SPDK_ERRLOG("%s: failed to alloc task pool.\n", vsession->name);
+		free(bvsession->poll_groups);
+		bvsession->poll_groups = NULL;
+		bvsession->poll_group_cnt = 0;
+		goto out;
 	}
 
-	bvsession->requestq_poller = spdk_poller_register(bvdev->bdev ? vdev_worker : no_bdev_vdev_worker,
-				     bvsession, 0);
-	SPDK_INFOLOG(SPDK_LOG_VHOST, "%s: started poller on lcore %d\n",
-		     vsession->name, spdk_env_get_current_core());
+	/* The session start is completed by vhost_blk_session_started() */
+	pg = &bvsession->poll_groups[0];
+	spdk_thread_send_msg(pg->group.thread, vhost_blk_poll_group_start, pg);
+	return 0;
 out:
 	vhost_session_start_done(vsession, rc);
 	return rc;
@@ -788,51 +1142,18 @@ vhost_blk_start(struct spdk_vhost_session *vsession)
 					3, "start session");
 }
 
-static int
-destroy_session_poller_cb(void *arg)
-{
-	struct spdk_vhost_blk_session *bvsession = arg;
-	struct spdk_vhost_session *vsession = &bvsession->vsession;
-	int i;
-
-	if (vsession->task_cnt > 0) {
-		return -1;
-	}
-
-	if (spdk_vhost_trylock() != 0) {
-		return -1;
-	}
-
-	for (i = 0; i < vsession->max_queues; i++) {
-		vsession->virtqueue[i].next_event_time = 0;
-		vhost_vq_used_signal(vsession, &vsession->virtqueue[i]);
-	}
-
-	SPDK_INFOLOG(SPDK_LOG_VHOST, "%s: stopping poller on lcore %d\n",
-		     vsession->name, spdk_env_get_current_core());
-
-	if (bvsession->io_channel) {
-		spdk_put_io_channel(bvsession->io_channel);
-		bvsession->io_channel = NULL;
-	}
-
-	free_task_pool(bvsession);
-	spdk_poller_unregister(&bvsession->stop_poller);
-	vhost_session_stop_done(vsession, 0);
-
-	spdk_vhost_unlock();
-	return -1;
-}
-
 static int
 vhost_blk_stop_cb(struct spdk_vhost_dev *vdev,
 		  struct spdk_vhost_session *vsession, void *unused)
 {
 	struct spdk_vhost_blk_session *bvsession = to_blk_session(vsession);
+	struct spdk_vhost_blk_poll_group *pg;
 
-	spdk_poller_unregister(&bvsession->requestq_poller);
-	bvsession->stop_poller = spdk_poller_register(destroy_session_poller_cb,
-				 bvsession, 1000);
+	/* The session stop is completed by vhost_blk_session_stopped() */
+	bvsession->start_rc = 0;
+	bvsession->poll_group_idx = 0;
+	pg = &bvsession->poll_groups[0];
+	spdk_thread_send_msg(pg->group.thread, vhost_blk_poll_group_stop, pg);
 	return 0;
 }
 
@@ -885,6 +1206,7 @@ vhost_blk_write_config_json(struct spdk_vhost_dev *vdev, struct spdk_json_write_
 	spdk_json_write_named_string(w, "cpumask",
 				     spdk_cpuset_fmt(spdk_thread_get_cpumask(vdev->thread)));
 	spdk_json_write_named_bool(w, "readonly", bvdev->readonly);
+	spdk_json_write_named_bool(w, "packed_ring", vdev->packed_ring);
 	spdk_json_write_object_end(w);
 
 	spdk_json_write_object_end(w);
@@ -976,6 +1298,7 @@ vhost_blk_controller_construct(void)
 	char *cpumask;
 	char *name;
 	bool readonly;
+	bool packed_ring;
 
 	for (sp = spdk_conf_first_section(NULL); sp != NULL; sp = spdk_conf_next_section(sp)) {
 		if (!spdk_conf_section_match_prefix(sp, "VhostBlk")) {
@@ -996,13 +1319,14 @@ vhost_blk_controller_construct(void)
 
 		cpumask = spdk_conf_section_get_val(sp, "Cpumask");
 		readonly = spdk_conf_section_get_boolval(sp, "ReadOnly", false);
+		packed_ring = spdk_conf_section_get_boolval(sp, "PackedRing", false);
 
 		bdev_name = spdk_conf_section_get_val(sp, "Dev");
 		if (bdev_name == NULL) {
 			continue;
 		}
 
-		if (spdk_vhost_blk_construct(name, cpumask, bdev_name, readonly) < 0) {
+		if (spdk_vhost_blk_construct(name, cpumask, bdev_name, readonly, packed_ring) < 0) {
 			return -1;
 		}
 	}
@@ -1010,8 +1334,69 @@ vhost_blk_controller_construct(void)
 	return 0;
 }
 
+static void
+vhost_blk_io_thread_exit(void *arg1)
+{
+	int rc __attribute__((unused));
+
+	rc = spdk_thread_exit(spdk_get_thread());
+	assert(rc == 0);
+}
+
+static void
+vhost_blk_destroy_io_threads(struct spdk_vhost_blk_dev *bvdev)
+{
+	uint32_t i;
+
+	for (i = 0; i < bvdev->io_thread_cnt; i++) {
+		spdk_thread_send_msg(bvdev->io_threads[i], vhost_blk_io_thread_exit, NULL);
+	}
+
+	free(bvdev->io_threads);
+	bvdev->io_threads = NULL;
+	bvdev->io_thread_cnt = 0;
+}
+
+static int
+vhost_blk_create_io_threads(struct spdk_vhost_blk_dev *bvdev)
+{
+	const struct spdk_cpuset *cpumask = spdk_thread_get_cpumask(bvdev->vdev.thread);
+	struct spdk_cpuset thread_cpumask;
+	char thread_name[64];
+	uint32_t cpu;
+
+	if (spdk_cpuset_count(cpumask) < 2) {
+		return 0;
+	}
+
+	bvdev->io_threads = calloc(spdk_cpuset_count(cpumask), sizeof(*bvdev->io_threads));
+	if (bvdev->io_threads == NULL) {
+		return -ENOMEM;
+	}
+
+	SPDK_ENV_FOREACH_CORE(cpu) {
+		if (!spdk_cpuset_get_cpu(cpumask, cpu)) {
+			continue;
+		}
+
+		spdk_cpuset_zero(&thread_cpumask);
+		spdk_cpuset_set_cpu(&thread_cpumask, cpu, true);
+		snprintf(thread_name, sizeof(thread_name), "%s.%"PRIu32, bvdev->vdev.name, cpu);
+		bvdev->io_threads[bvdev->io_thread_cnt] = spdk_thread_create(thread_name, &thread_cpumask);
+		if (bvdev->io_threads[bvdev->io_thread_cnt] == NULL) {
+			SPDK_ERRLOG("%s: failed to create thread for core %"PRIu32"\n", bvdev->vdev.name, cpu);
+			vhost_blk_destroy_io_threads(bvdev);
+			return -EIO;
+		}
+		bvdev->io_thread_cnt++;
+	}
+
+	return 0;
+}
+
 int
-spdk_vhost_blk_construct(const char *name, const char *cpumask, const char *dev_name, bool readonly)
+spdk_vhost_blk_construct(const char *name, const char *cpumask, const char *dev_name,
+			 bool readonly, bool packed_ring)
 {
 	struct spdk_vhost_blk_dev *bvdev = NULL;
 	struct spdk_vhost_dev *vdev;
@@ -1060,12 +1445,20 @@ spdk_vhost_blk_construct(const char *name, const char *cpumask, const char *dev_
 
 	bvdev->bdev = bdev;
 	bvdev->readonly = readonly;
+	vdev->packed_ring = packed_ring;
 	ret = vhost_dev_register(vdev, name, cpumask, &vhost_blk_device_backend);
 	if (ret != 0) {
 		spdk_bdev_close(bvdev->bdev_desc);
 		goto out;
 	}
 
+	ret = vhost_blk_create_io_threads(bvdev);
+	if (ret != 0) {
+		vhost_dev_unregister(vdev);
+		spdk_bdev_close(bvdev->bdev_desc);
+		goto out;
+	}
+
 	SPDK_INFOLOG(SPDK_LOG_VHOST, "%s: using bdev '%s'\n", name, dev_name);
 out:
 	if (ret != 0 && bvdev) {
@@ -1082,11 +1475,18 @@ vhost_blk_destroy(struct spdk_vhost_dev *vdev)
 	int rc;
 
 	assert(bvdev != NULL);
+	if (bvdev->bdev_remove_pending > 0) {
+		SPDK_ERRLOG("%s: bdev hot-removal is still in progress.\n", vdev->name);
+		return -EBUSY;
+	}
+
 	rc = vhost_dev_unregister(&bvdev->vdev);
 	if (rc != 0) {
 		return rc;
 	}
 
+	vhost_blk_destroy_io_threads(bvdev);
+
 	if (bvdev->bdev_desc) {
 		spdk_bdev_close(bvdev->bdev_desc);
 		bvdev->bdev_desc = NULL;
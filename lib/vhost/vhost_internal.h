@@ -79,9 +79,58 @@
 #define SPDK_VHOST_DISABLED_FEATURES ((1ULL << VIRTIO_RING_F_EVENT_IDX) | \
 	(1ULL << VIRTIO_F_NOTIFY_ON_EMPTY))
 
+#ifndef VRING_DESC_F_AVAIL
+#define VRING_DESC_F_AVAIL	(1ULL << VRING_PACKED_DESC_F_AVAIL)
+#define VRING_DESC_F_USED	(1ULL << VRING_PACKED_DESC_F_USED)
+#endif
+#define VRING_DESC_F_AVAIL_USED	(VRING_DESC_F_AVAIL | VRING_DESC_F_USED)
+
+/* Guest page size used by the dirty page log */
+#define SPDK_VHOST_LOG_PAGE	4096
+
+/* Number of dirty log bitmap words buffered by a session between flushes */
+#define SPDK_VHOST_LOG_CACHE_SIZE	32
+
 typedef struct rte_vhost_resubmit_desc spdk_vhost_resubmit_desc;
 typedef struct rte_vhost_resubmit_info spdk_vhost_resubmit_info;
 
+struct vhost_log_cache_entry {
+	/* Index of a 64-bit word in the dirty page log */
+	uint64_t offset;
+	/* Bits to be set in that word */
+	uint64_t val;
+};
+
+/*
+ * Virtqueues of a session polled by a single spdk_thread. Each session has a
+ * default group with all its virtqueues, polled on the device thread. Backends
+ * may split the virtqueues into more groups, see vhost_vq_group_init().
+ */
+struct spdk_vhost_vq_group {
+	struct spdk_thread *thread;
+
+	/* Polled virtqueues are first_vq, first_vq + vq_stride, ... */
+	uint16_t first_vq;
+	uint16_t vq_stride;
+
+	/* Number of requests being processed */
+	int task_cnt;
+
+	/* Next time when stats for event coalescing will be checked. */
+	uint64_t next_stats_check_time;
+
+	/* Dirty page log updates not written to the log yet */
+	uint16_t log_cache_cnt;
+	struct vhost_log_cache_entry log_cache[SPDK_VHOST_LOG_CACHE_SIZE];
+};
+
+struct vhost_packed_buf {
+	/* Ring index of the first descriptor of the chain */
+	uint16_t head;
+	/* Number of ring descriptors the chain occupies */
+	uint16_t num_descs;
+};
+
 struct spdk_vhost_virtqueue {
 	struct rte_vhost_vring vring;
 	struct rte_vhost_ring_inflight vring_inflight;
@@ -104,6 +153,49 @@ struct spdk_vhost_virtqueue {
 
 	/* Associated vhost_virtqueue in the virtio device's virtqueue list */
 	uint32_t vring_idx;
+
+	/* Group this virtqueue is polled by */
+	struct spdk_vhost_vq_group *group;
+
+	/* Adaptive interrupt coalescing, see spdk_vhost_set_vq_coalescing() */
+	struct {
+		/* Maximum time a completion may wait for its event, in ticks. 0 if disabled. */
+		uint64_t latency_budget;
+
+		/* Requests fetched from the avail ring and not completed yet */
+		uint32_t inflight;
+
+		/* Completions not signalled yet */
+		uint32_t pending;
+		uint64_t first_pending_tsc;
+		uint64_t pending_tsc_sum;
+
+		/* Moving average of time between completions, in ticks */
+		uint64_t last_completion_tsc;
+		uint64_t avg_completion_interval;
+
+		/* Statistics since the session was started */
+		uint64_t stats_start_tsc;
+		uint64_t events;
+		uint64_t completions;
+		/* Sum of the time completions waited for their events, in ticks */
+		uint64_t added_latency;
+	} coalescing;
+
+	struct {
+		/* VIRTIO_F_RING_PACKED was negotiated for this virtqueue */
+		bool packed_ring;
+
+		/* Driver and device ring wrap counters */
+		bool avail_phase;
+		bool used_phase;
+
+		/* Outstanding descriptor chains, indexed by buffer ID */
+		struct vhost_packed_buf *bufs;
+
+		/* Split layout copy of the chain being parsed, see vhost_vq_get_desc() */
+		struct vring_desc *desc_table;
+	} packed;
 } __attribute((aligned(SPDK_CACHE_LINE_SIZE)));
 
 struct spdk_vhost_session {
@@ -124,8 +216,6 @@ struct spdk_vhost_session {
 
 	struct rte_vhost_memory *mem;
 
-	int task_cnt;
-
 	uint16_t max_queues;
 
 	uint64_t negotiated_features;
@@ -134,12 +224,24 @@ struct spdk_vhost_session {
 	uint32_t coalescing_delay_time_base;
 	uint32_t coalescing_io_rate_threshold;
 
-	/* Next time when stats for event coalescing will be checked. */
-	uint64_t next_stats_check_time;
-
 	/* Interval used for event coalescing checking. */
 	uint64_t stats_check_interval;
 
+	/* At least one virtqueue uses adaptive coalescing. */
+	bool adaptive_coalescing;
+
+	/* Dirty page logging for live migration, see vhost_vq_group_log_flush() */
+	struct {
+		/* VHOST_F_LOG_ALL was negotiated and the log is mapped */
+		bool enabled;
+		uint8_t *base;
+		/* Log size in bytes */
+		uint64_t size;
+	} log;
+
+	/* Default virtqueue group with all the virtqueues */
+	struct spdk_vhost_vq_group group;
+
 	struct spdk_vhost_virtqueue virtqueue[SPDK_VHOST_MAX_VQUEUES];
 
 	TAILQ_ENTRY(spdk_vhost_session) tailq;
@@ -156,6 +258,9 @@ struct spdk_vhost_dev {
 	uint64_t disabled_features;
 	uint64_t protocol_features;
 
+	/* Offer VIRTIO_F_RING_PACKED to the driver */
+	bool packed_ring;
+
 	const struct spdk_vhost_dev_backend *backend;
 
 	/* Saved orginal values used to setup coalescing to avoid integer
@@ -164,6 +269,9 @@ struct spdk_vhost_dev {
 	uint32_t coalescing_delay_us;
 	uint32_t coalescing_iops_threshold;
 
+	/* Per virtqueue adaptive coalescing latency budgets */
+	uint32_t vq_latency_budget_us[SPDK_VHOST_MAX_VQUEUES];
+
 	/* Current connections to the device */
 	TAILQ_HEAD(, spdk_vhost_session) vsessions;
 
@@ -219,6 +327,17 @@ struct spdk_vhost_dev_backend {
 
 void *vhost_gpa_to_vva(struct spdk_vhost_session *vsession, uint64_t addr, uint64_t len);
 
+/**
+ * Get available requests from the virtqueue. For split virtqueues these
+ * are head descriptor indexes, for packed virtqueues these are buffer IDs.
+ * Either way the values are lower than the virtqueue size (unless the
+ * driver is broken) and can be passed to \c vhost_vq_get_desc and
+ * \c vhost_vq_used_ring_enqueue.
+ * \param vq virtqueue
+ * \param reqs array to be filled with request IDs
+ * \param reqs_len size of the *reqs* array
+ * \return number of requests fetched
+ */
 uint16_t vhost_vq_avail_ring_get(struct spdk_vhost_virtqueue *vq, uint16_t *reqs,
 				 uint16_t reqs_len);
 
@@ -227,9 +346,13 @@ uint16_t vhost_vq_avail_ring_get(struct spdk_vhost_virtqueue *vq, uint16_t *reqs
  * The descriptor will provide access to the entire descriptor
  * chain. The subsequent descriptors are accesible via
  * \c spdk_vhost_vring_desc_get_next.
+ *
+ * Packed virtqueue chains are presented in the split layout, so they
+ * can be walked with the same helpers. The returned descriptors are
+ * only valid until the next call on the same virtqueue.
  * \param vsession vhost session
  * \param vq virtqueue
- * \param req_idx descriptor index
+ * \param req_idx request ID returned by \c vhost_vq_avail_ring_get
  * \param desc pointer to be set to the descriptor
  * \param desc_table descriptor table to be used with
  * \c spdk_vhost_vring_desc_get_next. This might be either
@@ -261,6 +384,42 @@ int vhost_vq_used_signal(struct spdk_vhost_session *vsession, struct spdk_vhost_
  */
 void vhost_session_used_signal(struct spdk_vhost_session *vsession);
 
+/**
+ * Assign virtqueues first_vq, first_vq + vq_stride, ... of a session to
+ * the group. The group is then responsible for polling them on its thread
+ * and calling vhost_vq_group_used_signal() after each poller iteration.
+ *
+ * \param vsession vhost session
+ * \param group virtqueue group
+ * \param thread thread the group is polled on
+ * \param first_vq index of the first virtqueue
+ * \param vq_stride distance between the virtqueues, must be at least 1
+ */
+void vhost_vq_group_init(struct spdk_vhost_session *vsession, struct spdk_vhost_vq_group *group,
+			 struct spdk_thread *thread, uint16_t first_vq, uint16_t vq_stride);
+
+/**
+ * Send IRQs for the queues of a group that need to be signaled. Must be
+ * called on the group's thread. vhost_session_used_signal() does it for
+ * the default group.
+ *
+ * \param vsession vhost session
+ * \param group virtqueue group
+ */
+void vhost_vq_group_used_signal(struct spdk_vhost_session *vsession,
+				struct spdk_vhost_vq_group *group);
+
+/**
+ * Write the dirty page log updates buffered by a virtqueue group into the log
+ * shared with the vhost-user master. This is done at the end of each poller
+ * iteration in vhost_vq_group_used_signal().
+ *
+ * \param vsession vhost session
+ * \param group virtqueue group
+ */
+void vhost_vq_group_log_flush(struct spdk_vhost_session *vsession,
+			      struct spdk_vhost_vq_group *group);
+
 void vhost_vq_used_ring_enqueue(struct spdk_vhost_session *vsession,
 				struct spdk_vhost_virtqueue *vq,
 				uint16_t id, uint32_t len);
@@ -296,6 +455,7 @@ int vhost_dev_unregister(struct spdk_vhost_dev *vdev);
 int vhost_scsi_controller_construct(void);
 int vhost_blk_controller_construct(void);
 void vhost_dump_info_json(struct spdk_vhost_dev *vdev, struct spdk_json_write_ctx *w);
+void vhost_dump_vq_coalescing_json(struct spdk_vhost_dev *vdev, struct spdk_json_write_ctx *w);
 
 /*
  * Vhost callbacks for vhost_device_ops interface
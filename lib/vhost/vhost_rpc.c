@@ -47,6 +47,7 @@
 struct rpc_vhost_scsi_ctrlr {
 	char *ctrlr;
 	char *cpumask;
+	bool packed_ring;
 };
 
 static void
@@ -59,6 +60,7 @@ free_rpc_vhost_scsi_ctrlr(struct rpc_vhost_scsi_ctrlr *req)
 static const struct spdk_json_object_decoder rpc_vhost_create_scsi_ctrlr[] = {
 	{"ctrlr", offsetof(struct rpc_vhost_scsi_ctrlr, ctrlr), spdk_json_decode_string },
 	{"cpumask", offsetof(struct rpc_vhost_scsi_ctrlr, cpumask), spdk_json_decode_string, true},
+	{"packed_ring", offsetof(struct rpc_vhost_scsi_ctrlr, packed_ring), spdk_json_decode_bool, true},
 };
 
 static void
@@ -77,7 +79,7 @@ spdk_rpc_vhost_create_scsi_controller(struct spdk_jsonrpc_request *request,
 		goto invalid;
 	}
 
-	rc = spdk_vhost_scsi_dev_construct(req.ctrlr, req.cpumask);
+	rc = spdk_vhost_scsi_dev_construct(req.ctrlr, req.cpumask, req.packed_ring);
 	if (rc < 0) {
 		goto invalid;
 	}
@@ -242,6 +244,7 @@ struct rpc_vhost_blk_ctrlr {
 	char *dev_name;
 	char *cpumask;
 	bool readonly;
+	bool packed_ring;
 };
 
 static const struct spdk_json_object_decoder rpc_construct_vhost_blk_ctrlr[] = {
@@ -249,6 +252,7 @@ static const struct spdk_json_object_decoder rpc_construct_vhost_blk_ctrlr[] = {
 	{"dev_name", offsetof(struct rpc_vhost_blk_ctrlr, dev_name), spdk_json_decode_string },
 	{"cpumask", offsetof(struct rpc_vhost_blk_ctrlr, cpumask), spdk_json_decode_string, true},
 	{"readonly", offsetof(struct rpc_vhost_blk_ctrlr, readonly), spdk_json_decode_bool, true},
+	{"packed_ring", offsetof(struct rpc_vhost_blk_ctrlr, packed_ring), spdk_json_decode_bool, true},
 };
 
 static void
@@ -275,7 +279,8 @@ spdk_rpc_vhost_create_blk_controller(struct spdk_jsonrpc_request *request,
 		goto invalid;
 	}
 
-	rc = spdk_vhost_blk_construct(req.ctrlr, req.cpumask, req.dev_name, req.readonly);
+	rc = spdk_vhost_blk_construct(req.ctrlr, req.cpumask, req.dev_name,
+				      req.readonly, req.packed_ring);
 	if (rc < 0) {
 		goto invalid;
 	}
@@ -376,6 +381,7 @@ _spdk_rpc_get_vhost_controller(struct spdk_json_write_ctx *w, struct spdk_vhost_
 					 spdk_cpuset_fmt(spdk_thread_get_cpumask(vdev->thread)));
 	spdk_json_write_named_uint32(w, "delay_base_us", delay_base_us);
 	spdk_json_write_named_uint32(w, "iops_threshold", iops_threshold);
+	vhost_dump_vq_coalescing_json(vdev, w);
 	spdk_json_write_named_string(w, "socket", vdev->path);
 
 	spdk_json_write_named_object_begin(w, "backend_specific");
@@ -523,6 +529,70 @@ SPDK_RPC_REGISTER("vhost_controller_set_coalescing", spdk_rpc_vhost_controller_s
 		  SPDK_RPC_RUNTIME)
 SPDK_RPC_REGISTER_ALIAS_DEPRECATED(vhost_controller_set_coalescing, set_vhost_controller_coalescing)
 
+struct rpc_vhost_ctrlr_vq_coalescing {
+	char *ctrlr;
+	uint16_t vq_idx;
+	uint32_t latency_budget_us;
+};
+
+static const struct spdk_json_object_decoder rpc_set_vhost_ctrlr_vq_coalescing[] = {
+	{"ctrlr", offsetof(struct rpc_vhost_ctrlr_vq_coalescing, ctrlr), spdk_json_decode_string },
+	{"vq_idx", offsetof(struct rpc_vhost_ctrlr_vq_coalescing, vq_idx), spdk_json_decode_uint16},
+	{"latency_budget_us", offsetof(struct rpc_vhost_ctrlr_vq_coalescing, latency_budget_us), spdk_json_decode_uint32},
+};
+
+static void
+free_rpc_set_vhost_controller_vq_coalescing(struct rpc_vhost_ctrlr_vq_coalescing *req)
+{
+	free(req->ctrlr);
+}
+
+static void
+spdk_rpc_vhost_controller_set_vq_coalescing(struct spdk_jsonrpc_request *request,
+		const struct spdk_json_val *params)
+{
+	struct rpc_vhost_ctrlr_vq_coalescing req = {0};
+	struct spdk_json_write_ctx *w;
+	struct spdk_vhost_dev *vdev;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_set_vhost_ctrlr_vq_coalescing,
+				    SPDK_COUNTOF(rpc_set_vhost_ctrlr_vq_coalescing), &req)) {
+		SPDK_DEBUGLOG(SPDK_LOG_VHOST_RPC, "spdk_json_decode_object failed\n");
+		rc = -EINVAL;
+		goto invalid;
+	}
+
+	spdk_vhost_lock();
+	vdev = spdk_vhost_dev_find(req.ctrlr);
+	if (vdev == NULL) {
+		spdk_vhost_unlock();
+		rc = -ENODEV;
+		goto invalid;
+	}
+
+	rc = spdk_vhost_set_vq_coalescing(vdev, req.vq_idx, req.latency_budget_us);
+	spdk_vhost_unlock();
+	if (rc) {
+		goto invalid;
+	}
+
+	free_rpc_set_vhost_controller_vq_coalescing(&req);
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_bool(w, true);
+	spdk_jsonrpc_end_result(request, w);
+
+	return;
+
+invalid:
+	free_rpc_set_vhost_controller_vq_coalescing(&req);
+	spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+					 spdk_strerror(-rc));
+}
+SPDK_RPC_REGISTER("vhost_controller_set_vq_coalescing",
+		  spdk_rpc_vhost_controller_set_vq_coalescing, SPDK_RPC_RUNTIME)
+
 #ifdef SPDK_CONFIG_VHOST_INTERNAL_LIB
 
 struct rpc_vhost_nvme_ctrlr {
@@ -168,8 +168,8 @@ vhost_scsi_task_free_cb(struct spdk_scsi_task *scsi_task)
 	struct spdk_vhost_scsi_task *task = SPDK_CONTAINEROF(scsi_task, struct spdk_vhost_scsi_task, scsi);
 	struct spdk_vhost_session *vsession = &task->svsession->vsession;
 
-	assert(vsession->task_cnt > 0);
-	vsession->task_cnt--;
+	assert(vsession->group.task_cnt > 0);
+	vsession->group.task_cnt--;
 	task->used = false;
 }
 
@@ -707,7 +707,7 @@ process_controlq(struct spdk_vhost_scsi_session *svsession, struct spdk_vhost_vi
 			continue;
 		}
 
-		vsession->task_cnt++;
+		vsession->group.task_cnt++;
 		memset(&task->scsi, 0, sizeof(task->scsi));
 		task->tmf_resp = NULL;
 		task->used = true;
@@ -746,7 +746,7 @@ process_requestq(struct spdk_vhost_scsi_session *svsession, struct spdk_vhost_vi
 			continue;
 		}
 
-		vsession->task_cnt++;
+		vsession->group.task_cnt++;
 		memset(&task->scsi, 0, sizeof(task->scsi));
 		task->resp = NULL;
 		task->used = true;
@@ -822,7 +822,7 @@ to_scsi_session(struct spdk_vhost_session *vsession)
 }
 
 int
-spdk_vhost_scsi_dev_construct(const char *name, const char *cpumask)
+spdk_vhost_scsi_dev_construct(const char *name, const char *cpumask, bool packed_ring)
 {
 	struct spdk_vhost_scsi_dev *svdev = calloc(1, sizeof(*svdev));
 	int rc;
@@ -833,6 +833,7 @@ spdk_vhost_scsi_dev_construct(const char *name, const char *cpumask)
 
 	svdev->vdev.virtio_features = SPDK_VHOST_SCSI_FEATURES;
 	svdev->vdev.disabled_features = SPDK_VHOST_SCSI_DISABLED_FEATURES;
+	svdev->vdev.packed_ring = packed_ring;
 
 	spdk_vhost_lock();
 	rc = vhost_dev_register(&svdev->vdev, name, cpumask,
@@ -1172,6 +1173,7 @@ vhost_scsi_controller_construct(void)
 	char *cpumask;
 	char *name;
 	char *tgt = NULL;
+	bool packed_ring;
 
 	while (sp != NULL) {
 		if (!spdk_conf_section_match_prefix(sp, "VhostScsi")) {
@@ -1187,8 +1189,9 @@ vhost_scsi_controller_construct(void)
 
 		name =  spdk_conf_section_get_val(sp, "Name");
 		cpumask = spdk_conf_section_get_val(sp, "Cpumask");
+		packed_ring = spdk_conf_section_get_boolval(sp, "PackedRing", false);
 
-		if (spdk_vhost_scsi_dev_construct(name, cpumask) < 0) {
+		if (spdk_vhost_scsi_dev_construct(name, cpumask, packed_ring) < 0) {
 			return -1;
 		}
 
@@ -1375,7 +1378,7 @@ destroy_session_poller_cb(void *arg)
 	struct spdk_scsi_dev_session_state *state;
 	uint32_t i;
 
-	if (vsession->task_cnt > 0) {
+	if (vsession->group.task_cnt > 0) {
 		return -1;
 	}
 
@@ -1516,6 +1519,7 @@ vhost_scsi_write_config_json(struct spdk_vhost_dev *vdev, struct spdk_json_write
 	spdk_json_write_named_string(w, "ctrlr", vdev->name);
 	spdk_json_write_named_string(w, "cpumask",
 				     spdk_cpuset_fmt(spdk_thread_get_cpumask(vdev->thread)));
+	spdk_json_write_named_bool(w, "packed_ring", vdev->packed_ring);
 	spdk_json_write_object_end(w);
 
 	spdk_json_write_object_end(w);
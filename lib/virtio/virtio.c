@@ -47,6 +47,11 @@
 #define virtio_rmb()	spdk_smp_rmb()
 #define virtio_wmb()	spdk_smp_wmb()
 
+#ifndef VRING_DESC_F_AVAIL
+#define VRING_DESC_F_AVAIL	(1 << VRING_PACKED_DESC_F_AVAIL)
+#define VRING_DESC_F_USED	(1 << VRING_PACKED_DESC_F_USED)
+#endif
+
 /* Chain all the descriptors in the ring with an END */
 static inline void
 vring_desc_init(struct vring_desc *dp, uint16_t n)
@@ -59,6 +64,57 @@ vring_desc_init(struct vring_desc *dp, uint16_t n)
 	dp[i].next = VQ_RING_DESC_CHAIN_END;
 }
 
+void
+virtqueue_get_ring_offsets(struct virtqueue *vq, uint64_t *driver_area_offset,
+			   uint64_t *device_area_offset)
+{
+	if (vq->packed.packed_ring) {
+		*driver_area_offset = vq->vq_nentries * sizeof(struct vring_packed_desc);
+		*device_area_offset = *driver_area_offset + sizeof(struct vring_packed_desc_event);
+		return;
+	}
+
+	*driver_area_offset = vq->vq_nentries * sizeof(struct vring_desc);
+	*device_area_offset = SPDK_ALIGN_CEIL(*driver_area_offset +
+					      offsetof(struct vring_avail, ring[vq->vq_nentries]),
+					      VIRTIO_PCI_VRING_ALIGN);
+}
+
+static void
+virtio_init_packed_vring(struct virtqueue *vq)
+{
+	uint8_t *ring_mem = vq->vq_ring_virt_mem;
+	uint64_t driver_area_offset, device_area_offset;
+	uint16_t i;
+
+	memset(ring_mem, 0, vq->vq_ring_size);
+	virtqueue_get_ring_offsets(vq, &driver_area_offset, &device_area_offset);
+	vq->packed.desc = (struct vring_packed_desc *)ring_mem;
+	vq->packed.driver_event = (struct vring_packed_desc_event *)(ring_mem + driver_area_offset);
+	vq->packed.device_event = (struct vring_packed_desc_event *)(ring_mem + device_area_offset);
+	vq->packed.avail_flags = VRING_DESC_F_AVAIL;
+	vq->packed.used_wrap_counter = true;
+
+	vq->vq_used_cons_idx = 0;
+	vq->vq_avail_idx = 0;
+	vq->vq_free_cnt = vq->vq_nentries;
+	vq->req_start = VQ_RING_DESC_CHAIN_END;
+	vq->req_end = VQ_RING_DESC_CHAIN_END;
+	vq->reqs_finished = 0;
+	memset(vq->vq_descx, 0, sizeof(struct vq_desc_extra) * vq->vq_nentries);
+
+	/* All buffer IDs are free */
+	for (i = 0; i < vq->vq_nentries - 1; i++) {
+		vq->vq_descx[i].next = i + 1;
+	}
+	vq->vq_descx[i].next = VQ_RING_DESC_CHAIN_END;
+	vq->vq_desc_head_idx = 0;
+	vq->vq_desc_tail_idx = (uint16_t)(vq->vq_nentries - 1);
+
+	/* Tell the backend not to interrupt us. We poll for used descriptors. */
+	vq->packed.driver_event->flags = VRING_PACKED_EVENT_FLAG_DISABLE;
+}
+
 static void
 virtio_init_vring(struct virtqueue *vq)
 {
@@ -115,7 +171,8 @@ virtio_init_queue(struct virtio_dev *dev, uint16_t vtpci_queue_idx)
 		return -EINVAL;
 	}
 
-	if (!spdk_u32_is_pow2(vq_size)) {
+	/* Packed virtqueues don't need to be power of 2 sized */
+	if (!spdk_u32_is_pow2(vq_size) && !virtio_dev_has_feature(dev, VIRTIO_F_RING_PACKED)) {
 		SPDK_ERRLOG("virtqueue %"PRIu16" size (%u) is not powerof 2\n",
 			    vtpci_queue_idx, vq_size);
 		return -EINVAL;
@@ -133,11 +190,17 @@ virtio_init_queue(struct virtio_dev *dev, uint16_t vtpci_queue_idx)
 	vq->vdev = dev;
 	vq->vq_queue_index = vtpci_queue_idx;
 	vq->vq_nentries = vq_size;
+	vq->packed.packed_ring = virtio_dev_has_feature(dev, VIRTIO_F_RING_PACKED);
 
 	/*
 	 * Reserve a memzone for vring elements
 	 */
-	size = vring_size(vq_size, VIRTIO_PCI_VRING_ALIGN);
+	if (vq->packed.packed_ring) {
+		size = vq_size * sizeof(struct vring_packed_desc) +
+		       2 * sizeof(struct vring_packed_desc_event);
+	} else {
+		size = vring_size(vq_size, VIRTIO_PCI_VRING_ALIGN);
+	}
 	vq->vq_ring_size = SPDK_ALIGN_CEIL(size, VIRTIO_PCI_VRING_ALIGN);
 	SPDK_DEBUGLOG(SPDK_LOG_VIRTIO_DEV, "vring_size: %u, rounded_vring_size: %u\n",
 		      size, vq->vq_ring_size);
@@ -157,7 +220,11 @@ virtio_init_queue(struct virtio_dev *dev, uint16_t vtpci_queue_idx)
 	SPDK_DEBUGLOG(SPDK_LOG_VIRTIO_DEV, "vq->vq_ring_virt_mem: 0x%" PRIx64 "\n",
 		      (uint64_t)(uintptr_t)vq->vq_ring_virt_mem);
 
-	virtio_init_vring(vq);
+	if (vq->packed.packed_ring) {
+		virtio_init_packed_vring(vq);
+	} else {
+		virtio_init_vring(vq);
+	}
 	return 0;
 }
 
@@ -395,29 +462,224 @@ virtqueue_dequeue_burst_rx(struct virtqueue *vq, void **rx_pkts,
 	return i;
 }
 
+static inline bool
+packed_desc_is_used(uint16_t flags, bool used_wrap_counter)
+{
+	bool avail = !!(flags & VRING_DESC_F_AVAIL);
+	bool used = !!(flags & VRING_DESC_F_USED);
+
+	return avail == used && used == used_wrap_counter;
+}
+
+static void
+packed_free_id(struct virtqueue *vq, uint16_t id)
+{
+	vq->vq_descx[id].next = VQ_RING_DESC_CHAIN_END;
+	if (vq->vq_desc_tail_idx == VQ_RING_DESC_CHAIN_END) {
+		vq->vq_desc_head_idx = id;
+	} else {
+		vq->vq_descx[vq->vq_desc_tail_idx].next = id;
+	}
+	vq->vq_desc_tail_idx = id;
+}
+
+static uint16_t
+virtqueue_dequeue_burst_rx_packed(struct virtqueue *vq, void **rx_pkts,
+				  uint32_t *len, uint16_t num)
+{
+	volatile struct vring_packed_desc *desc;
+	struct vq_desc_extra *dxp;
+	uint16_t i, id;
+
+	for (i = 0; i < num; i++) {
+		desc = &vq->packed.desc[vq->vq_used_cons_idx];
+		if (!packed_desc_is_used(desc->flags, vq->packed.used_wrap_counter)) {
+			break;
+		}
+
+		/* Don't read the id and len before the flags */
+		virtio_rmb();
+		id = desc->id;
+		if (spdk_unlikely(id >= vq->vq_nentries || vq->vq_descx[id].cookie == NULL)) {
+			SPDK_WARNLOG("vring descriptor with no mbuf cookie at %"PRIu16"\n",
+				     vq->vq_used_cons_idx);
+			break;
+		}
+
+		dxp = &vq->vq_descx[id];
+		len[i] = desc->len;
+		__builtin_prefetch(dxp->cookie);
+		rx_pkts[i] = dxp->cookie;
+
+		/* The device skips as many ring slots as the chain had */
+		vq->vq_used_cons_idx += dxp->ndescs;
+		if (vq->vq_used_cons_idx >= vq->vq_nentries) {
+			vq->vq_used_cons_idx -= vq->vq_nentries;
+			vq->packed.used_wrap_counter = !vq->packed.used_wrap_counter;
+		}
+
+		vq->vq_free_cnt = (uint16_t)(vq->vq_free_cnt + dxp->ndescs);
+		dxp->ndescs = 0;
+		dxp->cookie = NULL;
+		packed_free_id(vq, id);
+	}
+
+	return i;
+}
+
+static void
+finish_req_packed(struct virtqueue *vq)
+{
+	struct vring_packed_desc *head = &vq->packed.desc[vq->packed.req_head_idx];
+
+	if (vq->req_end == vq->packed.req_head_idx) {
+		vq->packed.req_head_flags &= ~VRING_DESC_F_NEXT;
+	} else {
+		vq->packed.desc[vq->req_end].flags &= ~VRING_DESC_F_NEXT;
+	}
+
+	/*
+	 * The whole chain becomes visible to the device once the head
+	 * descriptor flags are written, so do it last.
+	 */
+	virtio_wmb();
+	*(volatile uint16_t *)&head->flags = vq->packed.req_head_flags;
+	vq->reqs_finished += vq->vq_descx[vq->req_start].ndescs;
+	vq->stats.reqs++;
+	vq->req_end = VQ_RING_DESC_CHAIN_END;
+}
+
+static void
+virtqueue_req_add_iovs_packed(struct virtqueue *vq, struct iovec *iovs, uint16_t iovcnt,
+			      enum spdk_virtio_desc_type desc_type)
+{
+	struct vring_packed_desc *desc;
+	struct vq_desc_extra *dxp;
+	uint16_t i, id, flags;
+
+	assert(vq->req_start != VQ_RING_DESC_CHAIN_END);
+	assert(iovcnt <= vq->vq_free_cnt);
+
+	id = vq->req_start;
+	dxp = &vq->vq_descx[id];
+	if (vq->req_end == VQ_RING_DESC_CHAIN_END && iovcnt > 0) {
+		/* First descriptors of this request - take its buffer ID */
+		assert(vq->vq_desc_head_idx == id);
+		vq->vq_desc_head_idx = dxp->next;
+		if (vq->vq_desc_head_idx == VQ_RING_DESC_CHAIN_END) {
+			vq->vq_desc_tail_idx = VQ_RING_DESC_CHAIN_END;
+		}
+		vq->packed.req_head_idx = vq->vq_avail_idx;
+	}
+
+	for (i = 0; i < iovcnt; ++i) {
+		desc = &vq->packed.desc[vq->vq_avail_idx];
+
+		if (!vq->vdev->is_hw) {
+			desc->addr = (uintptr_t)iovs[i].iov_base;
+		} else {
+			desc->addr = spdk_vtophys(iovs[i].iov_base, NULL);
+		}
+
+		desc->len = iovs[i].iov_len;
+		desc->id = id;
+		/* always set NEXT flag. unset it on the last descriptor
+		 * in the request-ending function.
+		 */
+		flags = desc_type | VRING_DESC_F_NEXT | vq->packed.avail_flags;
+		if (vq->vq_avail_idx == vq->packed.req_head_idx &&
+		    vq->req_end == VQ_RING_DESC_CHAIN_END) {
+			vq->packed.req_head_flags = flags;
+		} else {
+			desc->flags = flags;
+		}
+
+		vq->req_end = vq->vq_avail_idx;
+		if (++vq->vq_avail_idx == vq->vq_nentries) {
+			vq->vq_avail_idx = 0;
+			vq->packed.avail_flags ^= VRING_DESC_F_AVAIL | VRING_DESC_F_USED;
+		}
+	}
+
+	dxp->ndescs += iovcnt;
+	vq->vq_free_cnt = (uint16_t)(vq->vq_free_cnt - iovcnt);
+}
+
+static void
+virtqueue_req_abort_packed(struct virtqueue *vq)
+{
+	struct vq_desc_extra *dxp = &vq->vq_descx[vq->req_start];
+
+	if (vq->req_end != VQ_RING_DESC_CHAIN_END) {
+		/* The head descriptor was never published, so simply rewind */
+		if (vq->packed.req_head_idx + dxp->ndescs >= vq->vq_nentries) {
+			vq->packed.avail_flags ^= VRING_DESC_F_AVAIL | VRING_DESC_F_USED;
+		}
+		vq->vq_avail_idx = vq->packed.req_head_idx;
+		vq->vq_free_cnt = (uint16_t)(vq->vq_free_cnt + dxp->ndescs);
+
+		/* Put the buffer ID back at the head of the free chain */
+		dxp->next = vq->vq_desc_head_idx;
+		vq->vq_desc_head_idx = vq->req_start;
+		if (vq->vq_desc_tail_idx == VQ_RING_DESC_CHAIN_END) {
+			vq->vq_desc_tail_idx = vq->req_start;
+		}
+	}
+
+	dxp->ndescs = 0;
+	dxp->cookie = NULL;
+	vq->req_start = VQ_RING_DESC_CHAIN_END;
+	vq->req_end = VQ_RING_DESC_CHAIN_END;
+}
+
+static bool
+virtqueue_packed_need_notify(struct virtqueue *vq, uint16_t descs_added)
+{
+	uint16_t flags, off_wrap, event_idx;
+
+	flags = vq->packed.device_event->flags;
+	if (flags == VRING_PACKED_EVENT_FLAG_DISABLE) {
+		return false;
+	} else if (flags != VRING_PACKED_EVENT_FLAG_DESC) {
+		return true;
+	}
+
+	off_wrap = vq->packed.device_event->off_wrap;
+	event_idx = off_wrap & ~(1 << VRING_PACKED_EVENT_F_WRAP_CTR);
+	if (!!(off_wrap >> VRING_PACKED_EVENT_F_WRAP_CTR) !=
+	    !!(vq->packed.avail_flags & VRING_DESC_F_AVAIL)) {
+		event_idx -= vq->vq_nentries;
+	}
+
+	return vring_need_event(event_idx, vq->vq_avail_idx,
+				(uint16_t)(vq->vq_avail_idx - descs_added));
+}
+
 static void
 finish_req(struct virtqueue *vq)
 {
 	struct vring_desc *desc;
 	uint16_t avail_idx;
 
+	if (vq->packed.packed_ring) {
+		finish_req_packed(vq);
+		return;
+	}
+
 	desc = &vq->vq_ring.desc[vq->req_end];
 	desc->flags &= ~VRING_DESC_F_NEXT;
 
 	/*
-	 * Place the head of the descriptor chain into the next slot and make
-	 * it usable to the host. The chain is made available now rather than
-	 * deferring to virtqueue_req_flush() in the hopes that if the host is
-	 * currently running on another CPU, we can keep it processing the new
-	 * descriptor.
+	 * Place the head of the descriptor chain into the next slot. The avail
+	 * index is only published in virtqueue_req_flush(), so that a batch of
+	 * requests costs a single write to the cache line shared with the device.
 	 */
 	avail_idx = (uint16_t)(vq->vq_avail_idx & (vq->vq_nentries - 1));
 	vq->vq_ring.avail->ring[avail_idx] = vq->req_start;
 	vq->vq_avail_idx++;
 	vq->req_end = VQ_RING_DESC_CHAIN_END;
-	virtio_wmb();
-	vq->vq_ring.avail->idx = vq->vq_avail_idx;
 	vq->reqs_finished++;
+	vq->stats.reqs++;
 }
 
 int
@@ -441,23 +703,35 @@ virtqueue_req_start(struct virtqueue *vq, void *cookie, int iovcnt)
 	return 0;
 }
 
-void
+bool
 virtqueue_req_flush(struct virtqueue *vq)
 {
 	uint16_t reqs_finished;
 
-	if (vq->req_end == VQ_RING_DESC_CHAIN_END) {
+	if (vq->req_end != VQ_RING_DESC_CHAIN_END) {
+		finish_req(vq);
+	}
+
+	if (vq->reqs_finished == 0) {
 		/* no non-empty requests have been started */
-		return;
+		return false;
 	}
 
-	finish_req(vq);
+	if (!vq->packed.packed_ring) {
+		/* Publish all requests finished since the last flush at once. */
+		virtio_wmb();
+		vq->vq_ring.avail->idx = vq->vq_avail_idx;
+	}
 	virtio_mb();
 
 	reqs_finished = vq->reqs_finished;
 	vq->reqs_finished = 0;
 
-	if (vq->vdev->negotiated_features & (1ULL << VIRTIO_RING_F_EVENT_IDX)) {
+	if (vq->packed.packed_ring) {
+		if (!virtqueue_packed_need_notify(vq, reqs_finished)) {
+			return false;
+		}
+	} else if (vq->vdev->negotiated_features & (1ULL << VIRTIO_RING_F_EVENT_IDX)) {
 		/* Set used event idx to a value the device will never reach.
 		 * This effectively disables interrupts.
 		 */
@@ -466,14 +740,16 @@ virtqueue_req_flush(struct virtqueue *vq)
 		if (!vring_need_event(vring_avail_event(&vq->vq_ring),
 				      vq->vq_avail_idx,
 				      vq->vq_avail_idx - reqs_finished)) {
-			return;
+			return false;
 		}
 	} else if (vq->vq_ring.used->flags & VRING_USED_F_NO_NOTIFY) {
-		return;
+		return false;
 	}
 
 	virtio_dev_backend_ops(vq->vdev)->notify_queue(vq->vdev, vq);
+	vq->stats.notifies++;
 	SPDK_DEBUGLOG(SPDK_LOG_VIRTIO_DEV, "Notified backend after xmit\n");
+	return true;
 }
 
 void
@@ -486,6 +762,11 @@ virtqueue_req_abort(struct virtqueue *vq)
 		return;
 	}
 
+	if (vq->packed.packed_ring) {
+		virtqueue_req_abort_packed(vq);
+		return;
+	}
+
 	desc = &vq->vq_ring.desc[vq->req_end];
 	desc->flags &= ~VRING_DESC_F_NEXT;
 
@@ -501,6 +782,11 @@ virtqueue_req_add_iovs(struct virtqueue *vq, struct iovec *iovs, uint16_t iovcnt
 	struct vq_desc_extra *dxp;
 	uint16_t i, prev_head, new_head;
 
+	if (vq->packed.packed_ring) {
+		virtqueue_req_add_iovs_packed(vq, iovs, iovcnt, desc_type);
+		return;
+	}
+
 	assert(vq->req_start != VQ_RING_DESC_CHAIN_END);
 	assert(iovcnt <= vq->vq_free_cnt);
 
@@ -547,6 +833,10 @@ virtio_recv_pkts(struct virtqueue *vq, void **io, uint32_t *len, uint16_t nb_pkt
 {
 	uint16_t nb_used, num;
 
+	if (vq->packed.packed_ring) {
+		return virtqueue_dequeue_burst_rx_packed(vq, io, len, nb_pkts);
+	}
+
 	nb_used = vq->vq_ring.used->idx - vq->vq_used_cons_idx;
 	virtio_rmb();
 
@@ -702,6 +992,19 @@ virtio_dev_backend_ops(struct virtio_dev *dev)
 void
 virtio_dev_dump_json_info(struct virtio_dev *hw, struct spdk_json_write_ctx *w)
 {
+	struct virtqueue *vq;
+	uint64_t reqs = 0, notifies = 0;
+	uint16_t i;
+
+	/* The counters are updated by the queue owners, so these are just a snapshot. */
+	for (i = 0; i < hw->max_queues; i++) {
+		vq = hw->vqs ? hw->vqs[i] : NULL;
+		if (vq != NULL) {
+			reqs += vq->stats.reqs;
+			notifies += vq->stats.notifies;
+		}
+	}
+
 	spdk_json_write_named_object_begin(w, "virtio");
 
 	spdk_json_write_named_uint32(w, "vq_count", hw->max_queues);
@@ -711,6 +1014,11 @@ virtio_dev_dump_json_info(struct virtio_dev *hw, struct spdk_json_write_ctx *w)
 
 	virtio_dev_backend_ops(hw)->dump_json_info(hw, w);
 
+	spdk_json_write_named_uint64(w, "requests", reqs);
+	spdk_json_write_named_uint64(w, "notifies", notifies);
+	spdk_json_write_named_string_fmt(w, "notifies_per_io", "%.3f",
+					 reqs ? (double)notifies / reqs : 0.0);
+
 	spdk_json_write_object_end(w);
 }
 
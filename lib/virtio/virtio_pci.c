@@ -260,6 +260,7 @@ modern_setup_queue(struct virtio_dev *dev, struct virtqueue *vq)
 {
 	struct virtio_hw *hw = dev->ctx;
 	uint64_t desc_addr, avail_addr, used_addr;
+	uint64_t avail_offset, used_offset;
 	uint16_t notify_off;
 	void *queue_mem;
 	uint64_t queue_mem_phys_addr;
@@ -292,10 +293,10 @@ modern_setup_queue(struct virtio_dev *dev, struct virtqueue *vq)
 		return -ENOMEM;
 	}
 
+	virtqueue_get_ring_offsets(vq, &avail_offset, &used_offset);
 	desc_addr = vq->vq_ring_mem;
-	avail_addr = desc_addr + vq->vq_nentries * sizeof(struct vring_desc);
-	used_addr = (avail_addr + offsetof(struct vring_avail, ring[vq->vq_nentries])
-		     + VIRTIO_PCI_VRING_ALIGN - 1) & ~(VIRTIO_PCI_VRING_ALIGN - 1);
+	avail_addr = desc_addr + avail_offset;
+	used_addr = desc_addr + used_offset;
 
 	spdk_mmio_write_2(&hw->common_cfg->queue_select, vq->vq_queue_index);
 
@@ -96,6 +96,10 @@ virtio_user_kick_queue(struct virtio_dev *vdev, uint32_t queue_sel)
 
 	state.index = queue_sel;
 	state.num = 0; /* no reservation */
+	if (virtio_dev_has_feature(vdev, VIRTIO_F_RING_PACKED)) {
+		/* Both wrap counters start at 1 */
+		state.num |= 1 << 15;
+	}
 	rc = dev->ops->send_request(dev, VHOST_USER_SET_VRING_BASE, &state);
 	if (rc < 0) {
 		return rc;
@@ -434,6 +438,7 @@ virtio_user_setup_queue(struct virtio_dev *vdev, struct virtqueue *vq)
 	uint16_t queue_idx = vq->vq_queue_index;
 	void *queue_mem;
 	uint64_t desc_addr, avail_addr, used_addr;
+	uint64_t avail_offset, used_offset;
 	int callfd, kickfd, rc;
 
 	if (dev->callfds[queue_idx] != -1 || dev->kickfds[queue_idx] != -1) {
@@ -487,11 +492,11 @@ virtio_user_setup_queue(struct virtio_dev *vdev, struct virtqueue *vq)
 	dev->callfds[queue_idx] = callfd;
 	dev->kickfds[queue_idx] = kickfd;
 
+	/* For packed virtqueues avail and used point to the event suppression areas */
+	virtqueue_get_ring_offsets(vq, &avail_offset, &used_offset);
 	desc_addr = (uintptr_t)vq->vq_ring_virt_mem;
-	avail_addr = desc_addr + vq->vq_nentries * sizeof(struct vring_desc);
-	used_addr = SPDK_ALIGN_CEIL(avail_addr + offsetof(struct vring_avail,
-				    ring[vq->vq_nentries]),
-				    VIRTIO_PCI_VRING_ALIGN);
+	avail_addr = desc_addr + avail_offset;
+	used_addr = desc_addr + used_offset;
 
 	dev->vrings[queue_idx].num = vq->vq_nentries;
 	dev->vrings[queue_idx].desc = (void *)(uintptr_t)desc_addr;
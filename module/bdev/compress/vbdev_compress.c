@@ -32,6 +32,7 @@
  */
 
 #include "vbdev_compress.h"
+#include "vbdev_compress_sw.h"
 
 #include "spdk/reduce.h"
 #include "spdk/stdinc.h"
@@ -64,10 +65,13 @@
 
 #define ISAL_PMD "compress_isal"
 #define QAT_PMD "compress_qat"
+#define SW_BACKEND "software"
 #define NUM_MBUFS		8192
 #define POOL_CACHE_SIZE		256
 
 static enum compress_pmd g_opts;
+/* Size in bytes of the decompressed chunk cache given to each newly created or loaded volume. */
+static uint64_t g_chunk_cache_size;
 
 /* Global list of available compression devices. */
 struct compress_dev {
@@ -106,6 +110,22 @@ struct vbdev_comp_op {
 	TAILQ_ENTRY(vbdev_comp_op)	link;
 };
 
+struct vbdev_compress;
+
+/* Operations of a compression backend. */
+struct compress_backend {
+	const char		*name;		/* reported as the compression PMD of the bdev */
+	enum compress_pmd	pmd;		/* selects the backend, persisted with the volume */
+	bool			(*available)(void);
+	/* Set up the backend on the reduce thread when the first channel is created. */
+	int			(*channel_create)(struct vbdev_compress *comp_bdev);
+	/* Start an operation, -ENOMEM means it has to be queued up and resubmitted. */
+	int			(*submit)(struct vbdev_compress *comp_bdev,
+					  struct iovec *src_iovs, int src_iovcnt,
+					  struct iovec *dst_iovs, int dst_iovcnt,
+					  bool compress, void *cb_arg);
+};
+
 /* List of virtual bdevs and associated info for each. */
 struct vbdev_compress {
 	struct spdk_bdev		*base_bdev;	/* the thing we're attaching to */
@@ -113,8 +133,10 @@ struct vbdev_compress {
 	struct spdk_io_channel		*base_ch;	/* IO channel of base device */
 	struct spdk_bdev		comp_bdev;	/* the compression virtual bdev */
 	struct comp_io_channel		*comp_ch;	/* channel associated with this bdev */
-	char				*drv_name;	/* name of the compression device driver */
+	const struct compress_backend	*backend;	/* carries out the compression operations */
 	struct comp_device_qp		*device_qp;
+	uint32_t			sw_level;	/* compression level used by the software backend */
+	struct compress_sw_queue	sw_queue;	/* software ops waiting for the next poll */
 	struct spdk_thread		*reduce_thread;
 	pthread_mutex_t			reduce_lock;
 	uint32_t			ch_count;
@@ -431,23 +453,19 @@ spdk_reduce_rw_blocks_cb(void *arg, int reduce_errno)
 }
 
 static int
-_compress_operation(struct spdk_reduce_backing_dev *backing_dev, struct iovec *src_iovs,
-		    int src_iovcnt, struct iovec *dst_iovs,
-		    int dst_iovcnt, bool compress, void *cb_arg)
+comp_dev_submit(struct vbdev_compress *comp_bdev, struct iovec *src_iovs, int src_iovcnt,
+		struct iovec *dst_iovs, int dst_iovcnt, bool compress, void *cb_arg)
 {
 	void *reduce_cb_arg = cb_arg;
-	struct vbdev_compress *comp_bdev = SPDK_CONTAINEROF(backing_dev, struct vbdev_compress,
-					   backing_dev);
 	struct rte_comp_op *comp_op;
 	struct rte_mbuf *src_mbufs[MAX_MBUFS_PER_OP];
 	struct rte_mbuf *dst_mbufs[MAX_MBUFS_PER_OP];
-	uint8_t cdev_id = comp_bdev->device_qp->device->cdev_id;
+	uint8_t cdev_id;
 	uint64_t updated_length, remainder, phys_addr, total_length = 0;
 	uint8_t *current_src_base = NULL;
 	uint8_t *current_dst_base = NULL;
 	int iov_index, mbuf_index;
 	int rc = 0;
-	struct vbdev_comp_op *op_to_queue;
 	int i;
 	int src_mbuf_total = src_iovcnt;
 	int dst_mbuf_total = dst_iovcnt;
@@ -455,6 +473,8 @@ _compress_operation(struct spdk_reduce_backing_dev *backing_dev, struct iovec *s
 
 	assert(src_iovcnt < MAX_MBUFS_PER_OP);
 
+	cdev_id = comp_bdev->device_qp->device->cdev_id;
+
 #ifdef DEBUG
 	memset(src_mbufs, 0, sizeof(src_mbufs));
 	memset(dst_mbufs, 0, sizeof(dst_mbufs));
@@ -635,6 +655,37 @@ error_get_op:
 		return -EINVAL;
 	}
 
+	return -ENOMEM;
+}
+
+static int
+comp_sw_submit(struct vbdev_compress *comp_bdev, struct iovec *src_iovs, int src_iovcnt,
+	       struct iovec *dst_iovs, int dst_iovcnt, bool compress, void *cb_arg)
+{
+	return compress_sw_queue_op(&comp_bdev->sw_queue, src_iovs, src_iovcnt,
+				    dst_iovs, dst_iovcnt, compress,
+				    comp_bdev->sw_level, cb_arg);
+}
+
+/* Submit an operation to the backend of the bdev, or queue it up to be resubmitted
+ * by the poller if the backend is out of resources.
+ */
+static int
+_compress_operation(struct spdk_reduce_backing_dev *backing_dev, struct iovec *src_iovs,
+		    int src_iovcnt, struct iovec *dst_iovs,
+		    int dst_iovcnt, bool compress, void *cb_arg)
+{
+	struct vbdev_compress *comp_bdev = SPDK_CONTAINEROF(backing_dev, struct vbdev_compress,
+					   backing_dev);
+	struct vbdev_comp_op *op_to_queue;
+	int rc;
+
+	rc = comp_bdev->backend->submit(comp_bdev, src_iovs, src_iovcnt, dst_iovs, dst_iovcnt,
+					compress, cb_arg);
+	if (rc != -ENOMEM) {
+		return rc;
+	}
+
 	op_to_queue = calloc(1, sizeof(struct vbdev_comp_op));
 	if (op_to_queue == NULL) {
 		SPDK_ERRLOG("unable to allocate operation for queueing.\n");
@@ -716,6 +767,130 @@ comp_dev_poller(void *args)
 	return 0;
 }
 
+/* Poller for the software backend. Ops queued since the last poll are sent to
+ * the worker threads together.
+ */
+static int
+comp_sw_poller(void *args)
+{
+	struct vbdev_compress *comp_bdev = args;
+	TAILQ_HEAD(, vbdev_comp_op) retry_ops = TAILQ_HEAD_INITIALIZER(retry_ops);
+	struct vbdev_comp_op *op_to_resubmit;
+	struct spdk_reduce_vol_cb_args *reduce_args;
+	int rc;
+
+	/* Ops that are still out of resources get queued again by _compress_operation(),
+	 * so only retry the ones that were queued before this poll.
+	 */
+	TAILQ_CONCAT(&retry_ops, &comp_bdev->queued_comp_ops, link);
+	while ((op_to_resubmit = TAILQ_FIRST(&retry_ops))) {
+		TAILQ_REMOVE(&retry_ops, op_to_resubmit, link);
+		rc = _compress_operation(op_to_resubmit->backing_dev,
+					 op_to_resubmit->src_iovs,
+					 op_to_resubmit->src_iovcnt,
+					 op_to_resubmit->dst_iovs,
+					 op_to_resubmit->dst_iovcnt,
+					 op_to_resubmit->compress,
+					 op_to_resubmit->cb_arg);
+		if (rc) {
+			reduce_args = op_to_resubmit->cb_arg;
+			reduce_args->cb_fn(reduce_args->cb_arg, rc);
+		}
+		free(op_to_resubmit);
+	}
+
+	return compress_sw_queue_flush(&comp_bdev->sw_queue);
+}
+
+/* Called on the reduce thread when the first channel of a bdev using a compressdev
+ * PMD is created.
+ */
+static int
+comp_dev_channel_create(struct vbdev_compress *comp_bdev)
+{
+	struct comp_device_qp *device_qp;
+
+	comp_bdev->poller = spdk_poller_register(comp_dev_poller, comp_bdev, 0);
+	/* Now assign a q pair */
+	pthread_mutex_lock(&g_comp_device_qp_lock);
+	TAILQ_FOREACH(device_qp, &g_comp_device_qp, link) {
+		if ((strcmp(device_qp->device->cdev_info.driver_name, comp_bdev->backend->name) == 0)) {
+			if (device_qp->thread == spdk_get_thread()) {
+				comp_bdev->device_qp = device_qp;
+				break;
+			}
+			if (device_qp->thread == NULL) {
+				comp_bdev->device_qp = device_qp;
+				device_qp->thread = spdk_get_thread();
+				break;
+			}
+		}
+	}
+	pthread_mutex_unlock(&g_comp_device_qp_lock);
+
+	if (comp_bdev->device_qp == NULL) {
+		SPDK_ERRLOG("out of qpairs, cannot assign one to comp_bdev %p\n", comp_bdev);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+/* The software backend needs no queue pair, just a poller to dispatch ops. */
+static int
+comp_sw_channel_create(struct vbdev_compress *comp_bdev)
+{
+	compress_sw_queue_init(&comp_bdev->sw_queue);
+	comp_bdev->poller = spdk_poller_register(comp_sw_poller, comp_bdev, 0);
+
+	return 0;
+}
+
+static bool
+comp_qat_available(void)
+{
+	return g_qat_available;
+}
+
+static bool
+comp_isal_available(void)
+{
+	return g_isal_available;
+}
+
+static const struct compress_backend g_qat_backend = {
+	.name = QAT_PMD,
+	.pmd = COMPRESS_PMD_QAT_ONLY,
+	.available = comp_qat_available,
+	.channel_create = comp_dev_channel_create,
+	.submit = comp_dev_submit,
+};
+
+static const struct compress_backend g_isal_backend = {
+	.name = ISAL_PMD,
+	.pmd = COMPRESS_PMD_ISAL_ONLY,
+	.available = comp_isal_available,
+	.channel_create = comp_dev_channel_create,
+	.submit = comp_dev_submit,
+};
+
+static const struct compress_backend g_sw_backend = {
+	.name = SW_BACKEND,
+	.pmd = COMPRESS_PMD_SW_ONLY,
+	.available = compress_sw_available,
+	.channel_create = comp_sw_channel_create,
+	.submit = comp_sw_submit,
+};
+
+/* All backends, in the order auto-select prefers them. Without hardware, the
+ * compressdev layer is skipped and data is compressed in-process.
+ */
+static const struct compress_backend *g_compress_backends[] = {
+	&g_qat_backend,
+	&g_sw_backend,
+	&g_isal_backend,
+};
+
 /* Entry point for reduce lib to issue a compress operation. */
 static void
 _comp_reduce_compress(struct spdk_reduce_backing_dev *dev,
@@ -1065,7 +1240,10 @@ vbdev_compress_dump_info_json(void *ctx, struct spdk_json_write_ctx *w)
 	spdk_json_write_object_begin(w);
 	spdk_json_write_named_string(w, "name", spdk_bdev_get_name(&comp_bdev->comp_bdev));
 	spdk_json_write_named_string(w, "base_bdev_name", spdk_bdev_get_name(comp_bdev->base_bdev));
-	spdk_json_write_named_string(w, "compression_pmd", comp_bdev->drv_name);
+	spdk_json_write_named_string(w, "compression_pmd", comp_bdev->backend->name);
+	if (comp_bdev->backend == &g_sw_backend) {
+		spdk_json_write_named_uint32(w, "sw_level", comp_bdev->sw_level);
+	}
 	spdk_json_write_object_end(w);
 
 	return 0;
@@ -1083,7 +1261,8 @@ vbdev_compress_config_json(struct spdk_json_write_ctx *w)
 		spdk_json_write_named_object_begin(w, "params");
 		spdk_json_write_named_string(w, "base_bdev_name", spdk_bdev_get_name(comp_bdev->base_bdev));
 		spdk_json_write_named_string(w, "name", spdk_bdev_get_name(&comp_bdev->comp_bdev));
-		spdk_json_write_named_string(w, "compression_pmd", comp_bdev->drv_name);
+		spdk_json_write_named_string(w, "compression_pmd",
+					     comp_bdev->backend ? comp_bdev->backend->name : "None");
 		spdk_json_write_object_end(w);
 		spdk_json_write_object_end(w);
 	}
@@ -1098,6 +1277,19 @@ _vbdev_reduce_init_cb(void *ctx)
 	spdk_bdev_close(desc);
 }
 
+static void
+vbdev_compress_set_chunk_cache(struct vbdev_compress *comp_bdev)
+{
+	int rc;
+
+	rc = spdk_reduce_vol_set_cache_size(comp_bdev->vol, g_chunk_cache_size);
+	if (rc) {
+		/* Not fatal, the volume simply runs without a chunk cache. */
+		SPDK_ERRLOG("could not allocate %" PRIu64 " byte chunk cache for vol %s, error %d\n",
+			    g_chunk_cache_size, spdk_bdev_get_name(comp_bdev->base_bdev), rc);
+	}
+}
+
 /* Callback from reduce for when init is complete. We'll pass the vbdev_comp struct
  * used for initial metadata operations to claim where it will be further filled out
  * and added to the global list.
@@ -1119,6 +1311,7 @@ vbdev_reduce_init_cb(void *cb_arg, struct spdk_reduce_vol *vol, int reduce_errno
 
 	if (reduce_errno == 0) {
 		meta_ctx->vol = vol;
+		vbdev_compress_set_chunk_cache(meta_ctx);
 		vbdev_compress_claim(meta_ctx);
 	} else {
 		SPDK_ERRLOG("for vol %s, error %u\n",
@@ -1275,7 +1468,7 @@ _prepare_for_load_init(struct spdk_bdev *bdev)
 		return NULL;
 	}
 
-	meta_ctx->drv_name = "None";
+	meta_ctx->sw_level = COMPRESS_SW_DEFAULT_LEVEL;
 	meta_ctx->base_bdev = bdev;
 	meta_ctx->backing_dev.unmap = _comp_reduce_unmap;
 	meta_ctx->backing_dev.readv = _comp_reduce_readv;
@@ -1293,29 +1486,55 @@ _prepare_for_load_init(struct spdk_bdev *bdev)
 }
 
 static bool
-_set_pmd(struct vbdev_compress *comp_dev)
+_set_pmd(struct vbdev_compress *comp_dev, enum compress_pmd pmd)
 {
-	if (g_opts == COMPRESS_PMD_AUTO) {
-		if (g_qat_available) {
-			comp_dev->drv_name = QAT_PMD;
-		} else {
-			comp_dev->drv_name = ISAL_PMD;
+	const struct compress_backend *backend;
+	size_t i;
+
+	comp_dev->backend = NULL;
+	for (i = 0; i < SPDK_COUNTOF(g_compress_backends); i++) {
+		backend = g_compress_backends[i];
+		if ((pmd == COMPRESS_PMD_AUTO || pmd == backend->pmd) && backend->available()) {
+			comp_dev->backend = backend;
+			break;
 		}
-	} else if (g_opts == COMPRESS_PMD_QAT_ONLY && g_qat_available) {
-		comp_dev->drv_name = QAT_PMD;
-	} else if (g_opts == COMPRESS_PMD_ISAL_ONLY && g_isal_available) {
-		comp_dev->drv_name = ISAL_PMD;
-	} else {
+	}
+
+	if (comp_dev->backend == NULL) {
 		SPDK_ERRLOG("Requested PMD is not available.\n");
 		return false;
 	}
-	SPDK_NOTICELOG("PMD being used: %s\n", comp_dev->drv_name);
+	SPDK_NOTICELOG("PMD being used: %s\n", comp_dev->backend->name);
 	return true;
 }
 
+/* Select the backend of a loaded volume. Volumes created before the backend was persisted
+ * use the one set by compress_set_pmd(). All backends produce the same format, so if the
+ * persisted one isn't available anymore, another one is used instead.
+ */
+static bool
+_set_loaded_pmd(struct vbdev_compress *comp_dev)
+{
+	if (comp_dev->params.comp_backend == 0 || comp_dev->params.comp_backend >= COMPRESS_PMD_MAX) {
+		return _set_pmd(comp_dev, g_opts);
+	}
+
+	if (comp_dev->params.comp_level <= COMPRESS_SW_MAX_LEVEL) {
+		comp_dev->sw_level = comp_dev->params.comp_level;
+	}
+
+	if (_set_pmd(comp_dev, (enum compress_pmd)comp_dev->params.comp_backend)) {
+		return true;
+	}
+
+	SPDK_NOTICELOG("Falling back to the default PMD for %s\n",
+		       spdk_bdev_get_name(comp_dev->base_bdev));
+	return _set_pmd(comp_dev, g_opts);
+}
+
 /* Call reducelib to initialize a new volume */
 static int
-vbdev_init_reduce(struct spdk_bdev *bdev, const char *pm_path)
+vbdev_init_reduce(struct spdk_bdev *bdev, const char *pm_path, int pmd, uint32_t sw_level)
 {
 	struct vbdev_compress *meta_ctx;
 	int rc;
@@ -1325,12 +1544,17 @@ vbdev_init_reduce(struct spdk_bdev *bdev, const char *pm_path)
 		return -EINVAL;
 	}
 
-	if (_set_pmd(meta_ctx) == false) {
+	meta_ctx->sw_level = sw_level;
+	if (_set_pmd(meta_ctx, pmd < 0 ? g_opts : (enum compress_pmd)pmd) == false) {
 		SPDK_ERRLOG("could not find required pmd\n");
 		free(meta_ctx);
 		return -EINVAL;
 	}
 
+	/* Persist the backend and level so that they're used again when the volume is loaded. */
+	meta_ctx->params.comp_backend = meta_ctx->backend->pmd;
+	meta_ctx->params.comp_level = meta_ctx->sw_level;
+
 	rc = spdk_bdev_open(meta_ctx->base_bdev, true, vbdev_compress_base_bdev_hotremove_cb,
 			    meta_ctx->base_bdev, &meta_ctx->base_desc);
 	if (rc) {
@@ -1361,7 +1585,7 @@ static int
 comp_bdev_ch_create_cb(void *io_device, void *ctx_buf)
 {
 	struct vbdev_compress *comp_bdev = io_device;
-	struct comp_device_qp *device_qp;
+	int rc = 0;
 
 	/* We use this queue to track outstanding IO in our layer. */
 	TAILQ_INIT(&comp_bdev->pending_comp_ios);
@@ -1374,34 +1598,13 @@ comp_bdev_ch_create_cb(void *io_device, void *ctx_buf)
 	if (comp_bdev->ch_count == 0) {
 		comp_bdev->base_ch = spdk_bdev_get_io_channel(comp_bdev->base_desc);
 		comp_bdev->reduce_thread = spdk_get_thread();
-		comp_bdev->poller = spdk_poller_register(comp_dev_poller, comp_bdev, 0);
-		/* Now assign a q pair */
-		pthread_mutex_lock(&g_comp_device_qp_lock);
-		TAILQ_FOREACH(device_qp, &g_comp_device_qp, link) {
-			if ((strcmp(device_qp->device->cdev_info.driver_name, comp_bdev->drv_name) == 0)) {
-				if (device_qp->thread == spdk_get_thread()) {
-					comp_bdev->device_qp = device_qp;
-					break;
-				}
-				if (device_qp->thread == NULL) {
-					comp_bdev->device_qp = device_qp;
-					device_qp->thread = spdk_get_thread();
-					break;
-				}
-			}
-		}
-		pthread_mutex_unlock(&g_comp_device_qp_lock);
+		rc = comp_bdev->backend->channel_create(comp_bdev);
 	}
 	comp_bdev->ch_count++;
 	pthread_mutex_unlock(&comp_bdev->reduce_lock);
 
-	if (comp_bdev->device_qp != NULL) {
-		return 0;
-	} else {
-		SPDK_ERRLOG("out of qpairs, cannot assign one to comp_bdev %p\n", comp_bdev);
-		assert(false);
-		return -ENOMEM;
-	}
+	assert(rc == 0);
+	return rc;
 }
 
 static void
@@ -1454,7 +1657,7 @@ comp_bdev_ch_destroy_cb(void *io_device, void *ctx_buf)
 
 /* RPC entry point for compression vbdev creation. */
 int
-create_compress_bdev(const char *bdev_name, const char *pm_path)
+create_compress_bdev(const char *bdev_name, const char *pm_path, int pmd, uint32_t sw_level)
 {
 	struct spdk_bdev *bdev;
 
@@ -1463,7 +1666,11 @@ create_compress_bdev(const char *bdev_name, const char *pm_path)
 		return -ENODEV;
 	}
 
-	return vbdev_init_reduce(bdev, pm_path);;
+	if (pmd >= COMPRESS_PMD_MAX || sw_level > COMPRESS_SW_MAX_LEVEL) {
+		return -EINVAL;
+	}
+
+	return vbdev_init_reduce(bdev, pm_path, pmd, sw_level);
 }
 
 /* On init, just init the compress drivers. All metadata is stored on disk. */
@@ -1475,6 +1682,11 @@ vbdev_compress_init(void)
 		return -EINVAL;
 	}
 
+	/* Not fatal, volumes can still use the compressdev PMDs. */
+	if (compress_sw_init(CHUNK_SIZE)) {
+		SPDK_ERRLOG("Error setting up software compression\n");
+	}
+
 	return 0;
 }
 
@@ -1491,6 +1703,7 @@ vbdev_compress_finish(void)
 	}
 	pthread_mutex_destroy(&g_comp_device_qp_lock);
 
+	compress_sw_fini();
 	rte_mempool_free(g_comp_op_mp);
 	rte_mempool_free(g_mbuf_mp);
 }
@@ -1564,7 +1777,7 @@ vbdev_compress_claim(struct vbdev_compress *comp_bdev)
 	comp_bdev->comp_bdev.product_name = COMP_BDEV_NAME;
 	comp_bdev->comp_bdev.write_cache = comp_bdev->base_bdev->write_cache;
 
-	if (strcmp(comp_bdev->drv_name, QAT_PMD) == 0) {
+	if (comp_bdev->backend == &g_qat_backend) {
 		comp_bdev->comp_bdev.required_alignment =
 			spdk_max(spdk_u32log2(comp_bdev->base_bdev->blocklen),
 				 comp_bdev->base_bdev->required_alignment);
@@ -1742,17 +1955,18 @@ err:
 		return;
 	}
 
-	if (_set_pmd(meta_ctx) == false) {
+	/* Update information following volume load. */
+	meta_ctx->vol = vol;
+	memcpy(&meta_ctx->params, spdk_reduce_vol_get_params(vol),
+	       sizeof(struct spdk_reduce_vol_params));
+
+	if (_set_loaded_pmd(meta_ctx) == false) {
 		SPDK_ERRLOG("could not find required pmd\n");
 		free(meta_ctx);
 		spdk_bdev_module_examine_done(&compress_if);
 		return;
 	}
-
-	/* Update information following volume load. */
-	meta_ctx->vol = vol;
-	memcpy(&meta_ctx->params, spdk_reduce_vol_get_params(vol),
-	       sizeof(struct spdk_reduce_vol_params));
+	vbdev_compress_set_chunk_cache(meta_ctx);
 	vbdev_compress_claim(meta_ctx);
 	spdk_bdev_module_examine_done(&compress_if);
 }
@@ -1801,4 +2015,16 @@ compress_set_pmd(enum compress_pmd *opts)
 	return 0;
 }
 
+int
+compress_set_chunk_cache_size(uint64_t size)
+{
+	if (size != 0 && size < CHUNK_SIZE) {
+		return -EINVAL;
+	}
+
+	g_chunk_cache_size = size;
+
+	return 0;
+}
+
 SPDK_LOG_REGISTER_COMPONENT("vbdev_compress", SPDK_LOG_VBDEV_COMPRESS)
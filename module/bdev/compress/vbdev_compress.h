@@ -73,11 +73,22 @@ enum compress_pmd {
 	COMPRESS_PMD_AUTO = 0,
 	COMPRESS_PMD_QAT_ONLY,
 	COMPRESS_PMD_ISAL_ONLY,
+	COMPRESS_PMD_SW_ONLY,
 	COMPRESS_PMD_MAX
 };
 
 int compress_set_pmd(enum compress_pmd *opts);
 
+/**
+ * Set the size of the decompressed chunk cache of compression bdevs.
+ *
+ * Only applies to compression bdevs created or loaded afterwards.
+ *
+ * \param size Cache size in bytes per compression bdev, 0 disables the cache.
+ * \return 0 on success, negative errno on failure.
+ */
+int compress_set_chunk_cache_size(uint64_t size);
+
 typedef void (*spdk_delete_compress_complete)(void *cb_arg, int bdeverrno);
 
 /**
@@ -85,9 +96,12 @@ typedef void (*spdk_delete_compress_complete)(void *cb_arg, int bdeverrno);
  *
  * \param bdev_name Bdev on which compression bdev will be created.
  * \param pm_path Path to persistent memory.
+ * \param pmd Compression backend to use, or -1 for the one set by compress_set_pmd().
+ * \param sw_level Compression level used if the software backend is selected, from
+ * COMPRESS_SW_MIN_LEVEL (fastest) to COMPRESS_SW_MAX_LEVEL (best ratio).
  * \return 0 on success, other on failure.
  */
-int create_compress_bdev(const char *bdev_name, const char *pm_path);
+int create_compress_bdev(const char *bdev_name, const char *pm_path, int pmd, uint32_t sw_level);
 
 /**
  * Delete compress bdev.
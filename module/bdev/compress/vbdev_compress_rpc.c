@@ -32,6 +32,7 @@
  */
 
 #include "vbdev_compress.h"
+#include "vbdev_compress_sw.h"
 #include "spdk/rpc.h"
 #include "spdk/util.h"
 #include "spdk/string.h"
@@ -145,10 +146,52 @@ SPDK_RPC_REGISTER("compress_set_pmd", spdk_rpc_compress_set_pmd,
 		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
 SPDK_RPC_REGISTER_ALIAS_DEPRECATED(compress_set_pmd, set_compress_pmd)
 
+struct rpc_compress_set_chunk_cache_size {
+	uint64_t size;
+};
+
+static const struct spdk_json_object_decoder rpc_compress_chunk_cache_size_decoder[] = {
+	{"size", offsetof(struct rpc_compress_set_chunk_cache_size, size), spdk_json_decode_uint64},
+};
+
+static void
+spdk_rpc_compress_set_chunk_cache_size(struct spdk_jsonrpc_request *request,
+				       const struct spdk_json_val *params)
+{
+	struct rpc_compress_set_chunk_cache_size req;
+	struct spdk_json_write_ctx *w;
+	int rc = 0;
+
+	if (spdk_json_decode_object(params, rpc_compress_chunk_cache_size_decoder,
+				    SPDK_COUNTOF(rpc_compress_chunk_cache_size_decoder),
+				    &req)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		return;
+	}
+
+	rc = compress_set_chunk_cache_size(req.size);
+	if (rc) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		return;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	if (w != NULL) {
+		spdk_json_write_bool(w, true);
+		spdk_jsonrpc_end_result(request, w);
+	}
+}
+SPDK_RPC_REGISTER("compress_set_chunk_cache_size", spdk_rpc_compress_set_chunk_cache_size,
+		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
+
 /* Structure to hold the parameters for this RPC method. */
 struct rpc_construct_compress {
 	char *base_bdev_name;
 	char *pm_path;
+	int32_t pmd;
+	uint32_t sw_level;
 };
 
 /* Free the allocated memory resource after the RPC handling. */
@@ -163,6 +206,8 @@ free_rpc_construct_compress(struct rpc_construct_compress *r)
 static const struct spdk_json_object_decoder rpc_construct_compress_decoders[] = {
 	{"base_bdev_name", offsetof(struct rpc_construct_compress, base_bdev_name), spdk_json_decode_string},
 	{"pm_path", offsetof(struct rpc_construct_compress, pm_path), spdk_json_decode_string},
+	{"pmd", offsetof(struct rpc_construct_compress, pmd), spdk_json_decode_int32, true},
+	{"sw_level", offsetof(struct rpc_construct_compress, sw_level), spdk_json_decode_uint32, true},
 };
 
 /* Decode the parameters for this RPC method and properly construct the compress
@@ -177,6 +222,8 @@ spdk_rpc_bdev_compress_create(struct spdk_jsonrpc_request *request,
 	char *name;
 	int rc;
 
+	req.pmd = -1;
+	req.sw_level = COMPRESS_SW_DEFAULT_LEVEL;
 	if (spdk_json_decode_object(params, rpc_construct_compress_decoders,
 				    SPDK_COUNTOF(rpc_construct_compress_decoders),
 				    &req)) {
@@ -186,7 +233,7 @@ spdk_rpc_bdev_compress_create(struct spdk_jsonrpc_request *request,
 		goto cleanup;
 	}
 
-	rc = create_compress_bdev(req.base_bdev_name, req.pm_path);
+	rc = create_compress_bdev(req.base_bdev_name, req.pm_path, req.pmd, req.sw_level);
 	if (rc != 0) {
 		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
 		goto cleanup;
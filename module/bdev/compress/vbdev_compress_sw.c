@@ -0,0 +1,458 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vbdev_compress_sw.h"
+
+#include "spdk/env.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+
+#include "spdk_internal/log.h"
+
+#ifdef SPDK_CONFIG_ISAL
+#include <isa-l/include/igzip_lib.h>
+#endif
+
+#define COMPRESS_SW_NUM_OPS	8192
+
+struct compress_sw_worker {
+	struct spdk_thread		*thread;
+	uint8_t				*src_buf;	/* gathered input when there's more than one src iov */
+	uint8_t				*dst_buf;	/* output to scatter when there's more than one dst iov */
+	uint8_t				*level_buf;	/* scratch space required by deflate levels above 0 */
+#ifdef SPDK_CONFIG_ISAL
+	struct isal_zstream		stream;
+	struct inflate_state		state;
+#endif
+};
+
+struct compress_sw_op {
+	struct iovec			*src_iovs;
+	int				src_iovcnt;
+	struct iovec			*dst_iovs;
+	int				dst_iovcnt;
+	bool				compress;
+	uint32_t			level;
+	int				status;
+	struct spdk_reduce_vol_cb_args	*cb_arg;
+	struct spdk_thread		*thread;	/* thread to complete the op on */
+	struct compress_sw_worker	*worker;
+	struct compress_sw_op		*batch_next;	/* next op sent in the same batch */
+	STAILQ_ENTRY(compress_sw_op)	link;
+};
+
+static struct spdk_mempool *g_sw_op_mp;
+static struct compress_sw_worker **g_workers;
+static uint32_t g_num_workers;
+/* Used to run ops on the submitting thread when there's only one core. */
+static struct compress_sw_worker *g_inline_worker;
+static uint32_t g_max_chunk_size;
+
+bool
+compress_sw_available(void)
+{
+	return g_sw_op_mp != NULL;
+}
+
+static void
+_compress_sw_worker_free(struct compress_sw_worker *worker)
+{
+	if (worker == NULL) {
+		return;
+	}
+
+	free(worker->src_buf);
+	free(worker->dst_buf);
+	free(worker->level_buf);
+	free(worker);
+}
+
+static struct compress_sw_worker *
+_compress_sw_worker_alloc(void)
+{
+	struct compress_sw_worker *worker;
+
+	worker = calloc(1, sizeof(*worker));
+	if (worker == NULL) {
+		return NULL;
+	}
+
+	worker->src_buf = malloc(g_max_chunk_size);
+	worker->dst_buf = malloc(g_max_chunk_size);
+#ifdef SPDK_CONFIG_ISAL
+	worker->level_buf = malloc(ISAL_DEF_LVL3_DEFAULT);
+	if (worker->level_buf == NULL) {
+		_compress_sw_worker_free(worker);
+		return NULL;
+	}
+#endif
+	if (worker->src_buf == NULL || worker->dst_buf == NULL) {
+		_compress_sw_worker_free(worker);
+		return NULL;
+	}
+
+	return worker;
+}
+
+static int
+_compress_sw_deflate(struct compress_sw_worker *worker, uint8_t *src, uint32_t src_len,
+		     uint8_t *dst, uint32_t dst_len, uint32_t level)
+{
+#ifdef SPDK_CONFIG_ISAL
+	struct isal_zstream *stream = &worker->stream;
+	int rc;
+
+	isal_deflate_stateless_init(stream);
+	stream->level = spdk_min(level, ISAL_DEF_MAX_LEVEL);
+	stream->level_buf = worker->level_buf;
+	stream->level_buf_size = ISAL_DEF_LVL3_DEFAULT;
+	stream->gzip_flag = IGZIP_DEFLATE;
+	stream->flush = NO_FLUSH;
+	stream->end_of_stream = 1;
+	stream->next_in = src;
+	stream->avail_in = src_len;
+	stream->next_out = dst;
+	stream->avail_out = dst_len;
+
+	rc = isal_deflate_stateless(stream);
+	if (rc == STATELESS_OVERFLOW) {
+		/* Doesn't compress well enough, reduce will store it uncompressed. */
+		return -ENOSPC;
+	} else if (rc != COMP_OK) {
+		return -EIO;
+	}
+
+	return stream->total_out;
+#else
+	return -ENOTSUP;
+#endif
+}
+
+static int
+_compress_sw_inflate(struct compress_sw_worker *worker, uint8_t *src, uint32_t src_len,
+		     uint8_t *dst, uint32_t dst_len)
+{
+#ifdef SPDK_CONFIG_ISAL
+	struct inflate_state *state = &worker->state;
+	int rc;
+
+	isal_inflate_init(state);
+	state->crc_flag = ISAL_DEFLATE;
+	state->next_in = src;
+	state->avail_in = src_len;
+	state->next_out = dst;
+	state->avail_out = dst_len;
+
+	rc = isal_inflate_stateless(state);
+	if (rc != ISAL_DECOMP_OK) {
+		return -EIO;
+	}
+
+	return state->total_out;
+#else
+	return -ENOTSUP;
+#endif
+}
+
+static uint64_t
+_iovs_len(struct iovec *iovs, int iovcnt)
+{
+	uint64_t len = 0;
+	int i;
+
+	for (i = 0; i < iovcnt; i++) {
+		len += iovs[i].iov_len;
+	}
+
+	return len;
+}
+
+/* Run one op on the current thread, using the worker's scratch buffers. */
+static void
+_compress_sw_execute(struct compress_sw_worker *worker, struct compress_sw_op *op)
+{
+	uint64_t src_len, dst_len, off;
+	uint8_t *src, *dst;
+	int i, rc;
+
+	src_len = _iovs_len(op->src_iovs, op->src_iovcnt);
+	dst_len = _iovs_len(op->dst_iovs, op->dst_iovcnt);
+	if (src_len > g_max_chunk_size || dst_len > g_max_chunk_size) {
+		op->status = -EINVAL;
+		return;
+	}
+
+	if (op->src_iovcnt == 1) {
+		src = op->src_iovs[0].iov_base;
+	} else {
+		src = worker->src_buf;
+		for (i = 0, off = 0; i < op->src_iovcnt; i++) {
+			memcpy(src + off, op->src_iovs[i].iov_base, op->src_iovs[i].iov_len);
+			off += op->src_iovs[i].iov_len;
+		}
+	}
+
+	dst = op->dst_iovcnt == 1 ? op->dst_iovs[0].iov_base : worker->dst_buf;
+
+	if (op->compress) {
+		rc = _compress_sw_deflate(worker, src, src_len, dst, dst_len, op->level);
+	} else {
+		rc = _compress_sw_inflate(worker, src, src_len, dst, dst_len);
+	}
+
+	if (rc > 0 && op->dst_iovcnt > 1) {
+		for (i = 0, off = 0; i < op->dst_iovcnt && off < (uint64_t)rc; i++) {
+			memcpy(op->dst_iovs[i].iov_base, dst + off,
+			       spdk_min(op->dst_iovs[i].iov_len, (uint64_t)rc - off));
+			off += op->dst_iovs[i].iov_len;
+		}
+	}
+
+	op->status = rc;
+}
+
+/* Complete a batch of ops on the thread that submitted them. */
+static void
+_compress_sw_complete_batch(void *arg)
+{
+	struct compress_sw_op *op = arg;
+	struct compress_sw_op *next;
+	struct spdk_reduce_vol_cb_args *cb_arg;
+
+	while (op != NULL) {
+		next = op->batch_next;
+		cb_arg = op->cb_arg;
+		cb_arg->cb_fn(cb_arg->cb_arg, op->status);
+		spdk_mempool_put(g_sw_op_mp, op);
+		op = next;
+	}
+}
+
+static void
+_compress_sw_execute_batch(void *arg)
+{
+	struct compress_sw_op *first = arg;
+	struct compress_sw_op *op;
+
+	for (op = first; op != NULL; op = op->batch_next) {
+		_compress_sw_execute(op->worker, op);
+	}
+
+	spdk_thread_send_msg(first->thread, _compress_sw_complete_batch, first);
+}
+
+void
+compress_sw_queue_init(struct compress_sw_queue *queue)
+{
+	STAILQ_INIT(&queue->ops);
+	queue->num_ops = 0;
+	queue->next_worker = 0;
+}
+
+int
+compress_sw_queue_op(struct compress_sw_queue *queue,
+		     struct iovec *src_iovs, int src_iovcnt,
+		     struct iovec *dst_iovs, int dst_iovcnt,
+		     bool compress, uint32_t level,
+		     struct spdk_reduce_vol_cb_args *cb_arg)
+{
+	struct compress_sw_op *op;
+
+	if (g_sw_op_mp == NULL) {
+		return -ENOTSUP;
+	}
+
+	op = spdk_mempool_get(g_sw_op_mp);
+	if (op == NULL) {
+		return -ENOMEM;
+	}
+
+	op->src_iovs = src_iovs;
+	op->src_iovcnt = src_iovcnt;
+	op->dst_iovs = dst_iovs;
+	op->dst_iovcnt = dst_iovcnt;
+	op->compress = compress;
+	op->level = level;
+	op->status = 0;
+	op->cb_arg = cb_arg;
+	op->thread = spdk_get_thread();
+	op->worker = NULL;
+	op->batch_next = NULL;
+	STAILQ_INSERT_TAIL(&queue->ops, op, link);
+	queue->num_ops++;
+
+	return 0;
+}
+
+int
+compress_sw_queue_flush(struct compress_sw_queue *queue)
+{
+	struct compress_sw_worker *worker;
+	struct compress_sw_op *op, *first, *last;
+	uint32_t batch_size, count, num_ops;
+
+	num_ops = queue->num_ops;
+	if (num_ops == 0) {
+		return 0;
+	}
+
+	if (g_num_workers == 0) {
+		/* Ops may be queued again from the completion callbacks, so detach them first. */
+		first = STAILQ_FIRST(&queue->ops);
+		for (op = first; op != NULL; op = STAILQ_NEXT(op, link)) {
+			op->batch_next = STAILQ_NEXT(op, link);
+			_compress_sw_execute(g_inline_worker, op);
+		}
+		STAILQ_INIT(&queue->ops);
+		queue->num_ops = 0;
+		_compress_sw_complete_batch(first);
+		return num_ops;
+	}
+
+	/* Spread the ops evenly, sending each worker one message with its share. */
+	batch_size = spdk_divide_round_up(num_ops, g_num_workers);
+	while (!STAILQ_EMPTY(&queue->ops)) {
+		worker = g_workers[queue->next_worker];
+		queue->next_worker = (queue->next_worker + 1) % g_num_workers;
+
+		first = last = NULL;
+		for (count = 0; count < batch_size && !STAILQ_EMPTY(&queue->ops); count++) {
+			op = STAILQ_FIRST(&queue->ops);
+			STAILQ_REMOVE_HEAD(&queue->ops, link);
+			op->worker = worker;
+			op->batch_next = NULL;
+			if (last == NULL) {
+				first = op;
+			} else {
+				last->batch_next = op;
+			}
+			last = op;
+		}
+
+		spdk_thread_send_msg(worker->thread, _compress_sw_execute_batch, first);
+	}
+	queue->num_ops = 0;
+
+	return num_ops;
+}
+
+static void
+_compress_sw_worker_exit(void *arg)
+{
+	struct compress_sw_worker *worker = arg;
+
+	_compress_sw_worker_free(worker);
+	spdk_thread_exit(spdk_get_thread());
+}
+
+int
+compress_sw_init(uint32_t max_chunk_size)
+{
+#ifdef SPDK_CONFIG_ISAL
+	struct spdk_cpuset cpumask = {};
+	struct compress_sw_worker *worker;
+	char thread_name[32];
+	uint32_t i;
+
+	g_max_chunk_size = max_chunk_size;
+	g_sw_op_mp = spdk_mempool_create("comp_sw_op_mp", COMPRESS_SW_NUM_OPS,
+					 sizeof(struct compress_sw_op),
+					 SPDK_MEMPOOL_DEFAULT_CACHE_SIZE,
+					 SPDK_ENV_SOCKET_ID_ANY);
+	if (g_sw_op_mp == NULL) {
+		SPDK_ERRLOG("Cannot create software compression op pool\n");
+		return -ENOMEM;
+	}
+
+	/* With a single core there's nothing to spread the work over. */
+	if (spdk_env_get_core_count() > 1) {
+		g_workers = calloc(spdk_env_get_core_count(), sizeof(*g_workers));
+		if (g_workers == NULL) {
+			goto err;
+		}
+
+		SPDK_ENV_FOREACH_CORE(i) {
+			worker = _compress_sw_worker_alloc();
+			if (worker == NULL) {
+				goto err;
+			}
+
+			spdk_cpuset_zero(&cpumask);
+			spdk_cpuset_set_cpu(&cpumask, i, true);
+			snprintf(thread_name, sizeof(thread_name), "compress_sw_%u", i);
+			worker->thread = spdk_thread_create(thread_name, &cpumask);
+			if (worker->thread == NULL) {
+				_compress_sw_worker_free(worker);
+				goto err;
+			}
+			g_workers[g_num_workers++] = worker;
+		}
+	} else {
+		g_inline_worker = _compress_sw_worker_alloc();
+		if (g_inline_worker == NULL) {
+			goto err;
+		}
+	}
+
+	SPDK_NOTICELOG("software compression using %u worker threads\n", g_num_workers);
+
+	return 0;
+
+err:
+	SPDK_ERRLOG("Cannot set up software compression workers\n");
+	compress_sw_fini();
+	return -ENOMEM;
+#else
+	/* igzip is required, leave the software backend unavailable. */
+	return 0;
+#endif
+}
+
+void
+compress_sw_fini(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < g_num_workers; i++) {
+		spdk_thread_send_msg(g_workers[i]->thread, _compress_sw_worker_exit, g_workers[i]);
+	}
+	free(g_workers);
+	g_workers = NULL;
+	g_num_workers = 0;
+
+	_compress_sw_worker_free(g_inline_worker);
+	g_inline_worker = NULL;
+
+	spdk_mempool_free(g_sw_op_mp);
+	g_sw_op_mp = NULL;
+}
@@ -0,0 +1,113 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SPDK_VBDEV_COMPRESS_SW_H
+#define SPDK_VBDEV_COMPRESS_SW_H
+
+#include "spdk/stdinc.h"
+
+#include "spdk/queue.h"
+#include "spdk/reduce.h"
+
+/*
+ * In-process software compression backend for the compress vbdev.  Operations
+ * are queued by the reduce thread of a compression bdev and then dispatched in
+ * batches to a set of worker threads, one per core, which run ISA-L igzip on
+ * them.  The output is raw deflate, the same format produced by the
+ * compressdev PMDs, so a volume can be switched between backends.
+ */
+
+#define COMPRESS_SW_MIN_LEVEL		0
+#define COMPRESS_SW_MAX_LEVEL		3
+#define COMPRESS_SW_DEFAULT_LEVEL	1
+
+struct compress_sw_op;
+
+/* Operations queued by one compression bdev and not yet sent to a worker. */
+struct compress_sw_queue {
+	STAILQ_HEAD(, compress_sw_op)	ops;
+	uint32_t			num_ops;
+	uint32_t			next_worker;
+};
+
+/**
+ * Check whether the software backend can be used.  It requires ISA-L and a
+ * successful compress_sw_init().
+ *
+ * \return true if it can be used, false otherwise.
+ */
+bool compress_sw_available(void);
+
+/**
+ * Initialize the software backend and start its worker threads.
+ *
+ * \param max_chunk_size Largest buffer that will be compressed or decompressed.
+ * \return 0 on success, negative errno on failure.
+ */
+int compress_sw_init(uint32_t max_chunk_size);
+
+/**
+ * Stop the worker threads and free all resources of the software backend.
+ */
+void compress_sw_fini(void);
+
+/**
+ * Initialize an operation queue.
+ *
+ * \param queue Queue to initialize.
+ */
+void compress_sw_queue_init(struct compress_sw_queue *queue);
+
+/**
+ * Queue a compress or decompress operation.  It is started by the next
+ * compress_sw_queue_flush() call on the same thread, and cb_arg is completed
+ * on that thread with the number of bytes produced or a negative errno.
+ *
+ * \return 0 on success, -ENOMEM if no operation could be allocated and the
+ * call should be retried later, other negative errno on failure.
+ */
+int compress_sw_queue_op(struct compress_sw_queue *queue,
+			 struct iovec *src_iovs, int src_iovcnt,
+			 struct iovec *dst_iovs, int dst_iovcnt,
+			 bool compress, uint32_t level,
+			 struct spdk_reduce_vol_cb_args *cb_arg);
+
+/**
+ * Dispatch all queued operations, split into one batch per worker thread.
+ *
+ * \param queue Queue to flush.
+ * \return number of operations dispatched.
+ */
+int compress_sw_queue_flush(struct compress_sw_queue *queue);
+
+#endif /* SPDK_VBDEV_COMPRESS_SW_H */
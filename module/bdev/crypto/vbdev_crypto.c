@@ -32,6 +32,7 @@
  */
 
 #include "vbdev_crypto.h"
+#include "vbdev_crypto_sw.h"
 
 #include "spdk/env.h"
 #include "spdk/conf.h"
@@ -51,7 +52,7 @@
  * Note that the string names are defined by the DPDK PMD in question so be
  * sure to use the exact names.
  */
-#define MAX_NUM_DRV_TYPES 2
+#define MAX_NUM_DRV_TYPES 3
 
 /* The VF spread is the number of queue pairs between virtual functions, we use this to
  * load balance the QAT device.
@@ -60,7 +61,7 @@
 static uint8_t g_qat_total_qp = 0;
 static uint8_t g_next_qat_index;
 
-const char *g_driver_names[MAX_NUM_DRV_TYPES] = { AESNI_MB, QAT };
+const char *g_driver_names[MAX_NUM_DRV_TYPES] = { AESNI_MB, QAT, CRYPTO_SW };
 
 /* Global list of available crypto devices. */
 struct vbdev_dev {
@@ -157,6 +158,7 @@ struct bdev_names {
 	char			*drv_name;	/* name of the crypto device driver */
 	char			*cipher;	/* AES_CBC or AES_XTS */
 	uint8_t			*key2;		/* key #2 for AES_XTS, per bdev */
+	uint32_t		data_unit_size;	/* CRYPTO_SW only, 0 for base block size */
 	TAILQ_ENTRY(bdev_names)	link;
 };
 static TAILQ_HEAD(, bdev_names) g_bdev_names = TAILQ_HEAD_INITIALIZER(g_bdev_names);
@@ -176,6 +178,9 @@ struct vbdev_crypto {
 	struct rte_cryptodev_sym_session *session_encrypt;	/* encryption session for this bdev */
 	struct rte_cryptodev_sym_session *session_decrypt;	/* decryption session for this bdev */
 	struct rte_crypto_sym_xform	cipher_xform;		/* crypto control struct for this bdev */
+	bool				sw_backend;		/* CRYPTO_SW, no CryptoDev involved */
+	uint32_t			data_unit_size;		/* as configured, 0 for base block size */
+	uint32_t			base_blocks_per_block;	/* base bdev blocks per crypto bdev block */
 	TAILQ_ENTRY(vbdev_crypto)	link;
 	struct spdk_thread		*thread;		/* thread where base device is opened */
 };
@@ -185,6 +190,7 @@ static TAILQ_HEAD(, vbdev_crypto) g_vbdev_crypto = TAILQ_HEAD_INITIALIZER(g_vbde
 static struct rte_mempool *g_session_mp = NULL;
 static struct rte_mempool *g_session_mp_priv = NULL;
 static struct spdk_mempool *g_mbuf_mp = NULL;		/* mbuf mempool */
+static bool g_aesni_mb_vdev = false;			/* AESNI_MB vdev was created */
 static struct rte_mempool *g_crypto_op_mp = NULL;	/* crypto operations, must be rte* mempool */
 
 /* For queueing up crypto operations that we can't submit for some reason */
@@ -208,6 +214,7 @@ struct crypto_io_channel {
 	TAILQ_HEAD(, spdk_bdev_io)	pending_cry_ios;	/* outstanding operations to the crypto device */
 	struct spdk_io_channel_iter	*iter;			/* used with for_each_channel in reset */
 	TAILQ_HEAD(, vbdev_crypto_op)	queued_cry_ops;		/* queued for re-submission to CryptoDev */
+	struct crypto_sw_ctx		sw_ctx;			/* cipher state for CRYPTO_SW */
 };
 
 /* This is the crypto per IO context that the bdev layer allocates for us opaquely and attaches to
@@ -232,6 +239,15 @@ struct crypto_bdev_io {
 	struct spdk_io_channel *ch;
 };
 
+/* With CRYPTO_SW the crypto bdev may expose a larger block size than its base
+ * bdev so that each data unit is one crypto bdev block. Convert to base blocks.
+ */
+static inline uint64_t
+_to_base_blocks(struct vbdev_crypto *crypto_bdev, uint64_t num_blocks)
+{
+	return num_blocks * crypto_bdev->base_blocks_per_block;
+}
+
 /* Called by vbdev_crypto_init_crypto_drivers() to init each discovered crypto device */
 static int
 create_vbdev_dev(uint8_t index, uint16_t num_lcores)
@@ -382,12 +398,18 @@ vbdev_crypto_init_crypto_drivers(void)
 		return 0;
 	}
 
-	/* We always init AESNI_MB */
-	snprintf(aesni_args, sizeof(aesni_args), "max_nb_queue_pairs=%d", AESNI_MB_NUM_QP);
-	rc = rte_vdev_init(AESNI_MB, aesni_args);
-	if (rc) {
-		SPDK_ERRLOG("error creating virtual PMD %s\n", AESNI_MB);
-		return -EINVAL;
+	/* We always try to init AESNI_MB. It is not fatal if that fails, e.g. because DPDK
+	 * was built without it, as CRYPTO_SW and any HW devices can still be used.
+	 */
+	if (!g_aesni_mb_vdev) {
+		snprintf(aesni_args, sizeof(aesni_args), "max_nb_queue_pairs=%d", AESNI_MB_NUM_QP);
+		rc = rte_vdev_init(AESNI_MB, aesni_args);
+		if (rc) {
+			SPDK_WARNLOG("error creating virtual PMD %s, it will not be available\n", AESNI_MB);
+			rc = 0;
+		} else {
+			g_aesni_mb_vdev = true;
+		}
 	}
 
 	/* If we have no crypto devices, there's no reason to continue. */
@@ -532,9 +554,10 @@ _crypto_operation_complete(struct spdk_bdev_io *bdev_io)
 		if (io_ctx->bdev_io_status != SPDK_BDEV_IO_STATUS_FAILED) {
 			/* Write the encrypted data. */
 			rc = spdk_bdev_writev_blocks(crypto_bdev->base_desc, crypto_ch->base_ch,
-						     &io_ctx->aux_buf_iov, 1, io_ctx->aux_offset_blocks,
-						     io_ctx->aux_num_blocks, _complete_internal_write,
-						     bdev_io);
+						     &io_ctx->aux_buf_iov, 1,
+						     _to_base_blocks(crypto_bdev, io_ctx->aux_offset_blocks),
+						     _to_base_blocks(crypto_bdev, io_ctx->aux_num_blocks),
+						     _complete_internal_write, bdev_io);
 		} else {
 			SPDK_ERRLOG("Issue with encryption on bdev_io %p\n", bdev_io);
 			rc = -EINVAL;
@@ -555,6 +578,48 @@ static int _crypto_operation(struct spdk_bdev_io *bdev_io,
 			     enum rte_crypto_cipher_operation crypto_op,
 			     void *aux_buf);
 
+/* With the software backend the whole bdev_io is encrypted or decrypted right away on
+ * this thread, one data unit per cipher call straight out of the IO vectors. There are
+ * no mbufs or crypto ops to allocate and nothing to poll for, so we go directly on to
+ * the same completion handling the poller uses.
+ */
+static int
+_crypto_sw_operation(struct spdk_bdev_io *bdev_io, enum rte_crypto_cipher_operation crypto_op,
+		     void *aux_buf)
+{
+	struct crypto_bdev_io *io_ctx = (struct crypto_bdev_io *)bdev_io->driver_ctx;
+	struct crypto_io_channel *crypto_ch = io_ctx->crypto_ch;
+	uint64_t total_length = bdev_io->u.bdev.num_blocks * io_ctx->crypto_bdev->crypto_bdev.blocklen;
+	uint64_t alignment = spdk_bdev_get_buf_align(&io_ctx->crypto_bdev->crypto_bdev);
+	int rc;
+
+	if (crypto_op == RTE_CRYPTO_CIPHER_OP_ENCRYPT) {
+		io_ctx->aux_buf_iov.iov_len = total_length;
+		io_ctx->aux_buf_raw = aux_buf;
+		io_ctx->aux_buf_iov.iov_base  = (void *)(((uintptr_t)aux_buf + (alignment - 1)) & ~(alignment - 1));
+		io_ctx->aux_offset_blocks = bdev_io->u.bdev.offset_blocks;
+		io_ctx->aux_num_blocks = bdev_io->u.bdev.num_blocks;
+		rc = crypto_sw_crypt(&crypto_ch->sw_ctx, true, bdev_io->u.bdev.iovs,
+				     bdev_io->u.bdev.iovcnt, &io_ctx->aux_buf_iov, 1,
+				     bdev_io->u.bdev.offset_blocks, total_length);
+	} else {
+		rc = crypto_sw_crypt(&crypto_ch->sw_ctx, false, bdev_io->u.bdev.iovs,
+				     bdev_io->u.bdev.iovcnt, NULL, 0,
+				     bdev_io->u.bdev.offset_blocks, total_length);
+	}
+	if (rc != 0) {
+		SPDK_ERRLOG("error %d from software crypto on bdev_io %p\n", rc, bdev_io);
+		io_ctx->bdev_io_status = SPDK_BDEV_IO_STATUS_FAILED;
+	}
+
+	/* The completion path removes the bdev_io from the pending list. */
+	TAILQ_INSERT_TAIL(&crypto_ch->pending_cry_ios, bdev_io, module_link);
+	io_ctx->on_pending_list = true;
+	_crypto_operation_complete(bdev_io);
+
+	return 0;
+}
+
 /* This is the poller for the crypto device. It uses a single API to dequeue whatever is ready at
  * the device. Then we need to decide if what we've got so far (including previous poller
  * runs) totals up to one or more complete bdev_ios and if so continue with the bdev_io
@@ -683,7 +748,7 @@ _crypto_operation(struct spdk_bdev_io *bdev_io, enum rte_crypto_cipher_operation
 	uint32_t cryop_cnt = bdev_io->u.bdev.num_blocks;
 	struct crypto_bdev_io *io_ctx = (struct crypto_bdev_io *)bdev_io->driver_ctx;
 	struct crypto_io_channel *crypto_ch = io_ctx->crypto_ch;
-	uint8_t cdev_id = crypto_ch->device_qp->device->cdev_id;
+	uint8_t cdev_id;
 	uint32_t crypto_len = io_ctx->crypto_bdev->crypto_bdev.blocklen;
 	uint64_t total_length = bdev_io->u.bdev.num_blocks * crypto_len;
 	int rc;
@@ -701,6 +766,11 @@ _crypto_operation(struct spdk_bdev_io *bdev_io, enum rte_crypto_cipher_operation
 	struct vbdev_crypto_op *op_to_queue;
 	uint64_t alignment = spdk_bdev_get_buf_align(&io_ctx->crypto_bdev->crypto_bdev);
 
+	if (io_ctx->crypto_bdev->sw_backend) {
+		return _crypto_sw_operation(bdev_io, crypto_op, aux_buf);
+	}
+	cdev_id = crypto_ch->device_qp->device->cdev_id;
+
 	assert((bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen) <= CRYPTO_MAX_IO);
 
 	/* Get the number of source mbufs that we need. These will always be 1:1 because we
@@ -943,6 +1013,14 @@ _ch_quiesce(struct spdk_io_channel_iter *i)
 	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
 	struct crypto_io_channel *crypto_ch = spdk_io_channel_get_ctx(ch);
 
+	/* The software backend completes crypto work inline so there is
+	 * never anything outstanding to wait for.
+	 */
+	if (crypto_ch->poller == NULL) {
+		spdk_for_each_channel_continue(i, 0);
+		return;
+	}
+
 	crypto_ch->iter = i;
 	/* When the poller runs, it will see the non-NULL iter and handle
 	 * the quiesce.
@@ -1061,9 +1139,10 @@ crypto_read_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io,
 	}
 
 	rc = spdk_bdev_readv_blocks(crypto_bdev->base_desc, crypto_ch->base_ch, bdev_io->u.bdev.iovs,
-				    bdev_io->u.bdev.iovcnt, bdev_io->u.bdev.offset_blocks,
-				    bdev_io->u.bdev.num_blocks, _complete_internal_read,
-				    bdev_io);
+				    bdev_io->u.bdev.iovcnt,
+				    _to_base_blocks(crypto_bdev, bdev_io->u.bdev.offset_blocks),
+				    _to_base_blocks(crypto_bdev, bdev_io->u.bdev.num_blocks),
+				    _complete_internal_read, bdev_io);
 	if (rc != 0) {
 		if (rc == -ENOMEM) {
 			SPDK_DEBUGLOG(SPDK_LOG_CRYPTO, "No memory, queue the IO.\n");
@@ -1136,14 +1215,14 @@ vbdev_crypto_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bde
 		break;
 	case SPDK_BDEV_IO_TYPE_UNMAP:
 		rc = spdk_bdev_unmap_blocks(crypto_bdev->base_desc, crypto_ch->base_ch,
-					    bdev_io->u.bdev.offset_blocks,
-					    bdev_io->u.bdev.num_blocks,
+					    _to_base_blocks(crypto_bdev, bdev_io->u.bdev.offset_blocks),
+					    _to_base_blocks(crypto_bdev, bdev_io->u.bdev.num_blocks),
 					    _complete_internal_io, bdev_io);
 		break;
 	case SPDK_BDEV_IO_TYPE_FLUSH:
 		rc = spdk_bdev_flush_blocks(crypto_bdev->base_desc, crypto_ch->base_ch,
-					    bdev_io->u.bdev.offset_blocks,
-					    bdev_io->u.bdev.num_blocks,
+					    _to_base_blocks(crypto_bdev, bdev_io->u.bdev.offset_blocks),
+					    _to_base_blocks(crypto_bdev, bdev_io->u.bdev.num_blocks),
 					    _complete_internal_io, bdev_io);
 		break;
 	case SPDK_BDEV_IO_TYPE_RESET:
@@ -1201,8 +1280,10 @@ _device_unregister_cb(void *io_device)
 	struct vbdev_crypto *crypto_bdev = io_device;
 
 	/* Done with this crypto_bdev. */
-	rte_cryptodev_sym_session_free(crypto_bdev->session_decrypt);
-	rte_cryptodev_sym_session_free(crypto_bdev->session_encrypt);
+	if (!crypto_bdev->sw_backend) {
+		rte_cryptodev_sym_session_free(crypto_bdev->session_decrypt);
+		rte_cryptodev_sym_session_free(crypto_bdev->session_encrypt);
+	}
 	free(crypto_bdev->drv_name);
 	free(crypto_bdev->key);
 	free(crypto_bdev->key2);
@@ -1285,6 +1366,9 @@ vbdev_crypto_dump_info_json(void *ctx, struct spdk_json_write_ctx *w)
 		spdk_json_write_named_string(w, "key2", crypto_bdev->key);
 	}
 	spdk_json_write_named_string(w, "cipher", crypto_bdev->cipher);
+	if (crypto_bdev->sw_backend) {
+		spdk_json_write_named_uint32(w, "data_unit_size", crypto_bdev->crypto_bdev.blocklen);
+	}
 	spdk_json_write_object_end(w);
 	return 0;
 }
@@ -1306,6 +1390,9 @@ vbdev_crypto_config_json(struct spdk_json_write_ctx *w)
 			spdk_json_write_named_string(w, "key2", crypto_bdev->key);
 		}
 		spdk_json_write_named_string(w, "cipher", crypto_bdev->cipher);
+		if (crypto_bdev->data_unit_size) {
+			spdk_json_write_named_uint32(w, "data_unit_size", crypto_bdev->data_unit_size);
+		}
 		spdk_json_write_object_end(w);
 		spdk_json_write_object_end(w);
 	}
@@ -1361,21 +1448,37 @@ crypto_bdev_ch_create_cb(void *io_device, void *ctx_buf)
 	struct crypto_io_channel *crypto_ch = ctx_buf;
 	struct vbdev_crypto *crypto_bdev = io_device;
 	struct device_qp *device_qp = NULL;
+	int rc;
+
+	/* We use this queue to track outstanding IO in our layer. */
+	TAILQ_INIT(&crypto_ch->pending_cry_ios);
+
+	/* We use this to queue up crypto ops when the device is busy. */
+	TAILQ_INIT(&crypto_ch->queued_cry_ops);
+
+	crypto_ch->device_qp = NULL;
+	crypto_ch->poller = NULL;
+
+	/* The software backend keeps its own cipher state per channel, so it
+	 * needs neither a device/qp nor a completion poller.
+	 */
+	if (crypto_bdev->sw_backend) {
+		rc = crypto_sw_ctx_init(&crypto_ch->sw_ctx, crypto_bdev->cipher, crypto_bdev->key,
+					crypto_bdev->key2, crypto_bdev->crypto_bdev.blocklen);
+		if (rc) {
+			return rc;
+		}
+		crypto_ch->base_ch = spdk_bdev_get_io_channel(crypto_bdev->base_desc);
+		return 0;
+	}
 
 	crypto_ch->base_ch = spdk_bdev_get_io_channel(crypto_bdev->base_desc);
 	crypto_ch->poller = spdk_poller_register(crypto_dev_poller, crypto_ch, 0);
-	crypto_ch->device_qp = NULL;
 
 	/* Assign a device/qp combination that is unique per channel per PMD. */
 	_assign_device_qp(crypto_bdev, device_qp, crypto_ch);
 	assert(crypto_ch->device_qp);
 
-	/* We use this queue to track outstanding IO in our layer. */
-	TAILQ_INIT(&crypto_ch->pending_cry_ios);
-
-	/* We use this to queue up crypto ops when the device is busy. */
-	TAILQ_INIT(&crypto_ch->queued_cry_ops);
-
 	return 0;
 }
 
@@ -1387,6 +1490,13 @@ static void
 crypto_bdev_ch_destroy_cb(void *io_device, void *ctx_buf)
 {
 	struct crypto_io_channel *crypto_ch = ctx_buf;
+	struct vbdev_crypto *crypto_bdev = io_device;
+
+	if (crypto_bdev->sw_backend) {
+		crypto_sw_ctx_fini(&crypto_ch->sw_ctx);
+		spdk_put_io_channel(crypto_ch->base_ch);
+		return;
+	}
 
 	pthread_mutex_lock(&g_device_qp_lock);
 	crypto_ch->device_qp->in_use = false;
@@ -1401,7 +1511,8 @@ crypto_bdev_ch_destroy_cb(void *io_device, void *ctx_buf)
 static int
 vbdev_crypto_insert_name(const char *bdev_name, const char *vbdev_name,
 			 const char *crypto_pmd, const char *key,
-			 const char *cipher, const char *key2)
+			 const char *cipher, const char *key2,
+			 uint32_t data_unit_size)
 {
 	struct bdev_names *name;
 	int rc, j;
@@ -1452,6 +1563,22 @@ vbdev_crypto_insert_name(const char *bdev_name, const char *vbdev_name,
 		goto error_invalid_pmd;
 	}
 
+	if (data_unit_size != 0) {
+		if (strcmp(crypto_pmd, CRYPTO_SW) != 0) {
+			SPDK_ERRLOG("data unit size is only supported by %s\n", CRYPTO_SW);
+			rc = -EINVAL;
+			goto error_invalid_pmd;
+		}
+		if (!spdk_u32_is_pow2(data_unit_size) ||
+		    data_unit_size < CRYPTO_SW_MIN_DATA_UNIT_SIZE ||
+		    data_unit_size > CRYPTO_SW_MAX_DATA_UNIT_SIZE) {
+			SPDK_ERRLOG("invalid data unit size %u\n", data_unit_size);
+			rc = -EINVAL;
+			goto error_invalid_pmd;
+		}
+	}
+	name->data_unit_size = data_unit_size;
+
 	name->key = strdup(key);
 	if (!name->key) {
 		SPDK_ERRLOG("could not allocate name->key\n");
@@ -1517,14 +1644,16 @@ error_alloc_bname:
 int
 create_crypto_disk(const char *bdev_name, const char *vbdev_name,
 		   const char *crypto_pmd, const char *key,
-		   const char *cipher, const char *key2)
+		   const char *cipher, const char *key2,
+		   uint32_t data_unit_size)
 {
 	struct spdk_bdev *bdev = NULL;
 	int rc = 0;
 
 	bdev = spdk_bdev_get_by_name(bdev_name);
 
-	rc = vbdev_crypto_insert_name(bdev_name, vbdev_name, crypto_pmd, key, cipher, key2);
+	rc = vbdev_crypto_insert_name(bdev_name, vbdev_name, crypto_pmd, key, cipher, key2,
+				      data_unit_size);
 	if (rc) {
 		return rc;
 	}
@@ -1610,7 +1739,7 @@ vbdev_crypto_init(void)
 
 		/* Note: config file options do not support QAT AES_XTS, use RPC */
 		rc = vbdev_crypto_insert_name(conf_bdev_name, conf_vbdev_name,
-					      crypto_pmd, key, cipher, key2);
+					      crypto_pmd, key, cipher, key2, 0);
 		if (rc != 0) {
 			return rc;
 		}
@@ -1655,9 +1784,12 @@ vbdev_crypto_finish(void)
 		}
 		free(device);
 	}
-	rc = rte_vdev_uninit(AESNI_MB);
-	if (rc) {
-		SPDK_ERRLOG("%d from rte_vdev_uninit\n", rc);
+	if (g_aesni_mb_vdev) {
+		rc = rte_vdev_uninit(AESNI_MB);
+		if (rc) {
+			SPDK_ERRLOG("%d from rte_vdev_uninit\n", rc);
+		}
+		g_aesni_mb_vdev = false;
 	}
 
 	while ((dev_qp = TAILQ_FIRST(&g_device_qp_qat))) {
@@ -1746,13 +1878,90 @@ static struct spdk_bdev_module crypto_if = {
 
 SPDK_BDEV_MODULE_REGISTER(crypto, &crypto_if)
 
+/* Create and init the CryptoDev encrypt/decrypt sessions of a vbdev. */
+static int
+_vbdev_crypto_init_sessions(struct vbdev_crypto *vbdev, const char *cipher)
+{
+	struct vbdev_dev *device;
+	bool found = false;
+	int rc;
+
+	/* To init the session we have to get the cryptoDev device ID for this vbdev */
+	TAILQ_FOREACH(device, &g_vbdev_devs, link) {
+		if (strcmp(device->cdev_info.driver_name, vbdev->drv_name) == 0) {
+			found = true;
+			break;
+		}
+	}
+	if (found == false) {
+		SPDK_ERRLOG("ERROR can't match crypto device driver to crypto vbdev!\n");
+		return -EINVAL;
+	}
+
+	/* Get sessions. */
+	vbdev->session_encrypt = rte_cryptodev_sym_session_create(g_session_mp);
+	if (NULL == vbdev->session_encrypt) {
+		SPDK_ERRLOG("ERROR trying to create crypto session!\n");
+		return -EINVAL;
+	}
+
+	vbdev->session_decrypt = rte_cryptodev_sym_session_create(g_session_mp);
+	if (NULL == vbdev->session_decrypt) {
+		SPDK_ERRLOG("ERROR trying to create crypto session!\n");
+		rc = -EINVAL;
+		goto error_session_de_create;
+	}
+
+	/* Init our per vbdev xform with the desired cipher options. */
+	vbdev->cipher_xform.type = RTE_CRYPTO_SYM_XFORM_CIPHER;
+	vbdev->cipher_xform.cipher.iv.offset = IV_OFFSET;
+	if (strcmp(cipher, AES_CBC) == 0) {
+		vbdev->cipher_xform.cipher.key.data = vbdev->key;
+		vbdev->cipher_xform.cipher.algo = RTE_CRYPTO_CIPHER_AES_CBC;
+		vbdev->cipher_xform.cipher.key.length = AES_CBC_KEY_LENGTH;
+	} else {
+		vbdev->cipher_xform.cipher.key.data = vbdev->xts_key;
+		vbdev->cipher_xform.cipher.algo = RTE_CRYPTO_CIPHER_AES_XTS;
+		vbdev->cipher_xform.cipher.key.length = AES_XTS_KEY_LENGTH * 2;
+	}
+	vbdev->cipher_xform.cipher.iv.length = AES_CBC_IV_LENGTH;
+
+	vbdev->cipher_xform.cipher.op = RTE_CRYPTO_CIPHER_OP_ENCRYPT;
+	rc = rte_cryptodev_sym_session_init(device->cdev_id, vbdev->session_encrypt,
+					    &vbdev->cipher_xform,
+					    g_session_mp_priv ? g_session_mp_priv : g_session_mp);
+	if (rc < 0) {
+		SPDK_ERRLOG("ERROR trying to init encrypt session!\n");
+		rc = -EINVAL;
+		goto error_session_init;
+	}
+
+	vbdev->cipher_xform.cipher.op = RTE_CRYPTO_CIPHER_OP_DECRYPT;
+	rc = rte_cryptodev_sym_session_init(device->cdev_id, vbdev->session_decrypt,
+					    &vbdev->cipher_xform,
+					    g_session_mp_priv ? g_session_mp_priv : g_session_mp);
+	if (rc < 0) {
+		SPDK_ERRLOG("ERROR trying to init decrypt session!\n");
+		rc = -EINVAL;
+		goto error_session_init;
+	}
+
+	return 0;
+
+	/* Error cleanup paths. */
+error_session_init:
+	rte_cryptodev_sym_session_free(vbdev->session_decrypt);
+error_session_de_create:
+	rte_cryptodev_sym_session_free(vbdev->session_encrypt);
+	return rc;
+}
+
 static int
 vbdev_crypto_claim(struct spdk_bdev *bdev)
 {
 	struct bdev_names *name;
 	struct vbdev_crypto *vbdev;
-	struct vbdev_dev *device;
-	bool found = false;
+	struct crypto_sw_ctx sw_ctx;
 	int rc = 0;
 
 	if (g_number_of_claimed_volumes >= MAX_CRYPTO_VOLUMES) {
@@ -1810,6 +2019,7 @@ vbdev_crypto_claim(struct spdk_bdev *bdev)
 			goto error_drv_name;
 		}
 
+		vbdev->sw_backend = strcmp(vbdev->drv_name, CRYPTO_SW) == 0;
 		vbdev->crypto_bdev.product_name = "crypto";
 		vbdev->crypto_bdev.write_cache = bdev->write_cache;
 		vbdev->cipher = AES_CBC;
@@ -1836,19 +2046,53 @@ vbdev_crypto_claim(struct spdk_bdev *bdev)
 			}
 		} else {
 			vbdev->crypto_bdev.required_alignment = bdev->required_alignment;
+			if (vbdev->sw_backend && strcmp(name->cipher, AES_XTS) == 0) {
+				vbdev->cipher = AES_XTS;
+			}
 		}
+
+		/* Each crypto bdev block is encrypted with its own IV so a data unit
+		 * larger than the base block size is exposed as a larger block size.
+		 */
+		vbdev->data_unit_size = name->data_unit_size;
+		vbdev->base_blocks_per_block = 1;
+		vbdev->crypto_bdev.blocklen = bdev->blocklen;
+		vbdev->crypto_bdev.blockcnt = bdev->blockcnt;
+		if (vbdev->data_unit_size != 0) {
+			if (vbdev->data_unit_size < bdev->blocklen ||
+			    vbdev->data_unit_size % bdev->blocklen != 0) {
+				SPDK_ERRLOG("data unit size %u is not a multiple of the %s block size %u\n",
+					    vbdev->data_unit_size, spdk_bdev_get_name(bdev), bdev->blocklen);
+				rc = -EINVAL;
+				goto error_data_unit;
+			}
+			vbdev->base_blocks_per_block = vbdev->data_unit_size / bdev->blocklen;
+			vbdev->crypto_bdev.blocklen = vbdev->data_unit_size;
+			vbdev->crypto_bdev.blockcnt = bdev->blockcnt / vbdev->base_blocks_per_block;
+		}
+
+		/* Check the keys up front as channel creation can't report why it failed. */
+		if (vbdev->sw_backend) {
+			rc = crypto_sw_ctx_init(&sw_ctx, vbdev->cipher, vbdev->key, vbdev->key2,
+						vbdev->crypto_bdev.blocklen);
+			if (rc) {
+				SPDK_ERRLOG("could not set up %s for %s\n", CRYPTO_SW, name->vbdev_name);
+				goto error_data_unit;
+			}
+			crypto_sw_ctx_fini(&sw_ctx);
+		}
+
 		/* Note: CRYPTO_MAX_IO is in units of bytes, optimal_io_boundary is
 		 * in units of blocks.
 		 */
 		if (bdev->optimal_io_boundary > 0) {
 			vbdev->crypto_bdev.optimal_io_boundary =
-				spdk_min((CRYPTO_MAX_IO / bdev->blocklen), bdev->optimal_io_boundary);
+				spdk_min((CRYPTO_MAX_IO / vbdev->crypto_bdev.blocklen),
+					 bdev->optimal_io_boundary / vbdev->base_blocks_per_block);
 		} else {
-			vbdev->crypto_bdev.optimal_io_boundary = (CRYPTO_MAX_IO / bdev->blocklen);
+			vbdev->crypto_bdev.optimal_io_boundary = (CRYPTO_MAX_IO / vbdev->crypto_bdev.blocklen);
 		}
 		vbdev->crypto_bdev.split_on_optimal_io_boundary = true;
-		vbdev->crypto_bdev.blocklen = bdev->blocklen;
-		vbdev->crypto_bdev.blockcnt = bdev->blockcnt;
 
 		/* This is the context that is passed to us when the bdev
 		 * layer calls in so we'll save our crypto_bdev node here.
@@ -1877,67 +2121,13 @@ vbdev_crypto_claim(struct spdk_bdev *bdev)
 			goto error_claim;
 		}
 
-		/* To init the session we have to get the cryptoDev device ID for this vbdev */
-		TAILQ_FOREACH(device, &g_vbdev_devs, link) {
-			if (strcmp(device->cdev_info.driver_name, vbdev->drv_name) == 0) {
-				found = true;
-				break;
+		/* The software backend has no CryptoDev sessions. */
+		if (!vbdev->sw_backend) {
+			rc = _vbdev_crypto_init_sessions(vbdev, name->cipher);
+			if (rc) {
+				goto error_sessions;
 			}
 		}
-		if (found == false) {
-			SPDK_ERRLOG("ERROR can't match crypto device driver to crypto vbdev!\n");
-			rc = -EINVAL;
-			goto error_cant_find_devid;
-		}
-
-		/* Get sessions. */
-		vbdev->session_encrypt = rte_cryptodev_sym_session_create(g_session_mp);
-		if (NULL == vbdev->session_encrypt) {
-			SPDK_ERRLOG("ERROR trying to create crypto session!\n");
-			rc = -EINVAL;
-			goto error_session_en_create;
-		}
-
-		vbdev->session_decrypt = rte_cryptodev_sym_session_create(g_session_mp);
-		if (NULL == vbdev->session_decrypt) {
-			SPDK_ERRLOG("ERROR trying to create crypto session!\n");
-			rc = -EINVAL;
-			goto error_session_de_create;
-		}
-
-		/* Init our per vbdev xform with the desired cipher options. */
-		vbdev->cipher_xform.type = RTE_CRYPTO_SYM_XFORM_CIPHER;
-		vbdev->cipher_xform.cipher.iv.offset = IV_OFFSET;
-		if (strcmp(name->cipher, AES_CBC) == 0) {
-			vbdev->cipher_xform.cipher.key.data = vbdev->key;
-			vbdev->cipher_xform.cipher.algo = RTE_CRYPTO_CIPHER_AES_CBC;
-			vbdev->cipher_xform.cipher.key.length = AES_CBC_KEY_LENGTH;
-		} else {
-			vbdev->cipher_xform.cipher.key.data = vbdev->xts_key;
-			vbdev->cipher_xform.cipher.algo = RTE_CRYPTO_CIPHER_AES_XTS;
-			vbdev->cipher_xform.cipher.key.length = AES_XTS_KEY_LENGTH * 2;
-		}
-		vbdev->cipher_xform.cipher.iv.length = AES_CBC_IV_LENGTH;
-
-		vbdev->cipher_xform.cipher.op = RTE_CRYPTO_CIPHER_OP_ENCRYPT;
-		rc = rte_cryptodev_sym_session_init(device->cdev_id, vbdev->session_encrypt,
-						    &vbdev->cipher_xform,
-						    g_session_mp_priv ? g_session_mp_priv : g_session_mp);
-		if (rc < 0) {
-			SPDK_ERRLOG("ERROR trying to init encrypt session!\n");
-			rc = -EINVAL;
-			goto error_session_init;
-		}
-
-		vbdev->cipher_xform.cipher.op = RTE_CRYPTO_CIPHER_OP_DECRYPT;
-		rc = rte_cryptodev_sym_session_init(device->cdev_id, vbdev->session_decrypt,
-						    &vbdev->cipher_xform,
-						    g_session_mp_priv ? g_session_mp_priv : g_session_mp);
-		if (rc < 0) {
-			SPDK_ERRLOG("ERROR trying to init decrypt session!\n");
-			rc = -EINVAL;
-			goto error_session_init;
-		}
 
 		rc = spdk_bdev_register(&vbdev->crypto_bdev);
 		if (rc < 0) {
@@ -1954,17 +2144,17 @@ vbdev_crypto_claim(struct spdk_bdev *bdev)
 
 	/* Error cleanup paths. */
 error_bdev_register:
-error_session_init:
-	rte_cryptodev_sym_session_free(vbdev->session_decrypt);
-error_session_de_create:
-	rte_cryptodev_sym_session_free(vbdev->session_encrypt);
-error_session_en_create:
-error_cant_find_devid:
+	if (!vbdev->sw_backend) {
+		rte_cryptodev_sym_session_free(vbdev->session_decrypt);
+		rte_cryptodev_sym_session_free(vbdev->session_encrypt);
+	}
+error_sessions:
 error_claim:
 	spdk_bdev_close(vbdev->base_desc);
 error_open:
 	TAILQ_REMOVE(&g_vbdev_crypto, vbdev, link);
 	spdk_io_device_unregister(vbdev, NULL);
+error_data_unit:
 	free(vbdev->xts_key);
 error_xts_key:
 	free(vbdev->drv_name);
@@ -43,10 +43,11 @@
 
 #define AESNI_MB "crypto_aesni_mb"
 #define QAT "crypto_qat"
+#define CRYPTO_SW "crypto_sw" /* in-process software backend, no CryptoDev */
 
 /* Supported ciphers */
-#define AES_CBC "AES_CBC" /* QAT and AESNI_MB */
-#define AES_XTS "AES_XTS" /* QAT only */
+#define AES_CBC "AES_CBC" /* QAT, AESNI_MB and CRYPTO_SW */
+#define AES_XTS "AES_XTS" /* QAT and CRYPTO_SW */
 
 typedef void (*spdk_delete_crypto_complete)(void *cb_arg, int bdeverrno);
 
@@ -59,11 +60,14 @@ typedef void (*spdk_delete_crypto_complete)(void *cb_arg, int bdeverrno);
  * \param key The key to use for this vbdev.
  * \param cipher The cipher to use for this vbdev.
  * \param keys The 2nd key to use for AES_XTS cipher.
+ * \param data_unit_size Size in bytes of the unit encrypted with one tweak/IV,
+ * 0 to use the block size of the base bdev. Only supported by CRYPTO_SW.
  * \return 0 on success, other on failure.
  */
 int create_crypto_disk(const char *bdev_name, const char *vbdev_name,
 		       const char *crypto_pmd, const char *key,
-		       const char *cipher, const char *key2);
+		       const char *cipher, const char *key2,
+		       uint32_t data_unit_size);
 
 /**
  * Delete crypto bdev.
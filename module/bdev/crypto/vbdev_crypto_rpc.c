@@ -41,6 +41,7 @@ struct rpc_construct_crypto {
 	char *key;
 	char *cipher;
 	char *key2;
+	uint32_t data_unit_size;
 };
 
 /* Free the allocated memory resource after the RPC handling. */
@@ -63,6 +64,7 @@ static const struct spdk_json_object_decoder rpc_construct_crypto_decoders[] = {
 	{"key", offsetof(struct rpc_construct_crypto, key), spdk_json_decode_string},
 	{"cipher", offsetof(struct rpc_construct_crypto, cipher), spdk_json_decode_string, true},
 	{"key2", offsetof(struct rpc_construct_crypto, key2), spdk_json_decode_string, true},
+	{"data_unit_size", offsetof(struct rpc_construct_crypto, data_unit_size), spdk_json_decode_uint32, true},
 };
 
 /* Decode the parameters for this RPC method and properly construct the crypto
@@ -102,7 +104,7 @@ spdk_rpc_bdev_crypto_create(struct spdk_jsonrpc_request *request,
 
 	if (strcmp(req.crypto_pmd, AESNI_MB) == 0 && strcmp(req.cipher, AES_XTS) == 0) {
 		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
-						 "Invalid cipher. AES_XTS is only available on QAT.");
+						 "Invalid cipher. AES_XTS is only available on QAT and " CRYPTO_SW ".");
 		goto cleanup;
 	}
 
@@ -118,8 +120,15 @@ spdk_rpc_bdev_crypto_create(struct spdk_jsonrpc_request *request,
 		goto cleanup;
 	}
 
+	if (req.data_unit_size != 0 && strcmp(req.crypto_pmd, CRYPTO_SW) != 0) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Invalid data_unit_size. It is only supported by " CRYPTO_SW ".");
+		goto cleanup;
+	}
+
 	rc = create_crypto_disk(req.base_bdev_name, req.name,
-				req.crypto_pmd, req.key, req.cipher, req.key2);
+				req.crypto_pmd, req.key, req.cipher, req.key2,
+				req.data_unit_size);
 	if (rc) {
 		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
 		goto cleanup;
@@ -0,0 +1,284 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vbdev_crypto_sw.h"
+#include "vbdev_crypto.h"
+
+#include "spdk/endian.h"
+
+#define CRYPTO_SW_KEY_LENGTH	16
+#define CRYPTO_SW_IV_LENGTH	16
+
+/* Walks a list of iovecs one data unit at a time. */
+struct crypto_sw_iov_iter {
+	struct iovec	*iovs;
+	int		iovcnt;
+	int		idx;
+	size_t		offset;
+};
+
+static void
+_iov_iter_init(struct crypto_sw_iov_iter *iter, struct iovec *iovs, int iovcnt)
+{
+	iter->iovs = iovs;
+	iter->iovcnt = iovcnt;
+	iter->idx = 0;
+	iter->offset = 0;
+}
+
+static void
+_iov_iter_advance(struct crypto_sw_iov_iter *iter, size_t len)
+{
+	iter->offset += len;
+	while (iter->idx < iter->iovcnt && iter->offset >= iter->iovs[iter->idx].iov_len) {
+		iter->offset -= iter->iovs[iter->idx].iov_len;
+		iter->idx++;
+	}
+}
+
+/* Returns a pointer to the next len bytes if they are contiguous, NULL otherwise. */
+static uint8_t *
+_iov_iter_contig(struct crypto_sw_iov_iter *iter, size_t len)
+{
+	struct iovec *iov = &iter->iovs[iter->idx];
+
+	if (iov->iov_len - iter->offset < len) {
+		return NULL;
+	}
+
+	return (uint8_t *)iov->iov_base + iter->offset;
+}
+
+/* Copies the next len bytes out of the iovecs into buf. */
+static void
+_iov_iter_gather(struct crypto_sw_iov_iter *iter, uint8_t *buf, size_t len)
+{
+	size_t n;
+
+	while (len > 0) {
+		n = spdk_min(len, iter->iovs[iter->idx].iov_len - iter->offset);
+		memcpy(buf, (uint8_t *)iter->iovs[iter->idx].iov_base + iter->offset, n);
+		buf += n;
+		len -= n;
+		_iov_iter_advance(iter, n);
+	}
+}
+
+/* Copies len bytes of buf into the next bytes of the iovecs. */
+static void
+_iov_iter_scatter(struct crypto_sw_iov_iter *iter, const uint8_t *buf, size_t len)
+{
+	size_t n;
+
+	while (len > 0) {
+		n = spdk_min(len, iter->iovs[iter->idx].iov_len - iter->offset);
+		memcpy((uint8_t *)iter->iovs[iter->idx].iov_base + iter->offset, buf, n);
+		buf += n;
+		len -= n;
+		_iov_iter_advance(iter, n);
+	}
+}
+
+static uint64_t
+_iovs_len(struct iovec *iovs, int iovcnt)
+{
+	uint64_t len = 0;
+	int i;
+
+	for (i = 0; i < iovcnt; i++) {
+		len += iovs[i].iov_len;
+	}
+
+	return len;
+}
+
+static EVP_CIPHER_CTX *
+_cipher_ctx_create(const EVP_CIPHER *type, const uint8_t *key, int enc)
+{
+	EVP_CIPHER_CTX *cctx;
+
+	cctx = EVP_CIPHER_CTX_new();
+	if (cctx == NULL) {
+		return NULL;
+	}
+
+	/* The key schedule is expanded here once, each data unit then only sets its IV. */
+	if (EVP_CipherInit_ex(cctx, type, NULL, key, NULL, enc) != 1) {
+		EVP_CIPHER_CTX_free(cctx);
+		return NULL;
+	}
+	EVP_CIPHER_CTX_set_padding(cctx, 0);
+
+	return cctx;
+}
+
+int
+crypto_sw_ctx_init(struct crypto_sw_ctx *ctx, const char *cipher,
+		   const uint8_t *key, const uint8_t *key2,
+		   uint32_t data_unit_size)
+{
+	uint8_t xts_key[CRYPTO_SW_KEY_LENGTH * 2];
+	const EVP_CIPHER *type;
+	const uint8_t *cipher_key;
+
+	memset(ctx, 0, sizeof(*ctx));
+
+	if (data_unit_size == 0 || data_unit_size % CRYPTO_SW_IV_LENGTH != 0 ||
+	    data_unit_size > CRYPTO_SW_MAX_DATA_UNIT_SIZE) {
+		SPDK_ERRLOG("invalid data unit size %u\n", data_unit_size);
+		return -EINVAL;
+	}
+
+	if (strcmp(cipher, AES_XTS) == 0) {
+		if (key2 == NULL) {
+			SPDK_ERRLOG("AES_XTS requires a 2nd key\n");
+			return -EINVAL;
+		}
+		/* libcrypto expects the data and tweak keys to be concatenated. */
+		memcpy(xts_key, key, CRYPTO_SW_KEY_LENGTH);
+		memcpy(xts_key + CRYPTO_SW_KEY_LENGTH, key2, CRYPTO_SW_KEY_LENGTH);
+		type = EVP_aes_128_xts();
+		cipher_key = xts_key;
+	} else if (strcmp(cipher, AES_CBC) == 0) {
+		type = EVP_aes_128_cbc();
+		cipher_key = key;
+	} else {
+		SPDK_ERRLOG("invalid cipher %s\n", cipher);
+		return -EINVAL;
+	}
+
+	ctx->encrypt = _cipher_ctx_create(type, cipher_key, 1);
+	ctx->decrypt = _cipher_ctx_create(type, cipher_key, 0);
+	memset(xts_key, 0, sizeof(xts_key));
+	if (ctx->encrypt == NULL || ctx->decrypt == NULL) {
+		SPDK_ERRLOG("could not set up %s cipher context\n", cipher);
+		crypto_sw_ctx_fini(ctx);
+		return -EINVAL;
+	}
+
+	ctx->bounce = malloc(data_unit_size);
+	if (ctx->bounce == NULL) {
+		crypto_sw_ctx_fini(ctx);
+		return -ENOMEM;
+	}
+	ctx->data_unit_size = data_unit_size;
+
+	return 0;
+}
+
+void
+crypto_sw_ctx_fini(struct crypto_sw_ctx *ctx)
+{
+	EVP_CIPHER_CTX_free(ctx->encrypt);
+	EVP_CIPHER_CTX_free(ctx->decrypt);
+	free(ctx->bounce);
+	memset(ctx, 0, sizeof(*ctx));
+}
+
+static int
+_crypt_unit(EVP_CIPHER_CTX *cctx, uint8_t *out, const uint8_t *in, uint32_t len,
+	    uint64_t unit)
+{
+	uint8_t iv[CRYPTO_SW_IV_LENGTH] = {};
+	int out_len = 0;
+
+	/* Same IV layout as the CryptoDev path: the unit index in the low 8 bytes. */
+	to_le64(iv, unit);
+	if (EVP_CipherInit_ex(cctx, NULL, NULL, NULL, iv, -1) != 1 ||
+	    EVP_CipherUpdate(cctx, out, &out_len, in, len) != 1 ||
+	    out_len != (int)len) {
+		return -EIO;
+	}
+
+	return 0;
+}
+
+int
+crypto_sw_crypt(struct crypto_sw_ctx *ctx, bool encrypt,
+		struct iovec *src_iovs, int src_iovcnt,
+		struct iovec *dst_iovs, int dst_iovcnt,
+		uint64_t first_unit, uint64_t len)
+{
+	EVP_CIPHER_CTX *cctx = encrypt ? ctx->encrypt : ctx->decrypt;
+	uint32_t unit_size = ctx->data_unit_size;
+	struct crypto_sw_iov_iter src, dst, out_pos;
+	uint8_t *in, *out;
+	uint64_t unit;
+	int rc;
+
+	if (len % unit_size != 0 || _iovs_len(src_iovs, src_iovcnt) < len) {
+		return -EINVAL;
+	}
+
+	/* Without a destination the data is processed in place. */
+	if (dst_iovs == NULL) {
+		dst_iovs = src_iovs;
+		dst_iovcnt = src_iovcnt;
+	} else if (_iovs_len(dst_iovs, dst_iovcnt) < len) {
+		return -EINVAL;
+	}
+
+	_iov_iter_init(&src, src_iovs, src_iovcnt);
+	_iov_iter_init(&dst, dst_iovs, dst_iovcnt);
+
+	for (unit = first_unit; len > 0; unit++, len -= unit_size) {
+		/* Most data units sit in a single iovec and are processed where they
+		 * are. Only units split across iovecs go through the bounce buffer.
+		 */
+		in = _iov_iter_contig(&src, unit_size);
+		if (in != NULL) {
+			_iov_iter_advance(&src, unit_size);
+		} else {
+			in = ctx->bounce;
+			_iov_iter_gather(&src, in, unit_size);
+		}
+
+		out_pos = dst;
+		out = _iov_iter_contig(&dst, unit_size);
+		if (out == NULL) {
+			out = ctx->bounce;
+		}
+		_iov_iter_advance(&dst, unit_size);
+
+		rc = _crypt_unit(cctx, out, in, unit_size, unit);
+		if (rc != 0) {
+			return rc;
+		}
+
+		if (out == ctx->bounce) {
+			_iov_iter_scatter(&out_pos, out, unit_size);
+		}
+	}
+
+	return 0;
+}
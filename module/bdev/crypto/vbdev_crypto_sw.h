@@ -0,0 +1,104 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SPDK_VBDEV_CRYPTO_SW_H
+#define SPDK_VBDEV_CRYPTO_SW_H
+
+#include "spdk/stdinc.h"
+
+#include <openssl/evp.h>
+
+/*
+ * In-process software backend for the crypto vbdev.  Whole iovecs are
+ * encrypted or decrypted synchronously on the calling thread with the
+ * AES-NI accelerated ciphers of libcrypto, so no mbufs or CryptoDev
+ * operations are needed per block.  Each data unit is processed with the
+ * index of the data unit as tweak/IV, laid out like the IV the CryptoDev
+ * path uses, so data is interchangeable with the QAT and AESNI_MB PMDs
+ * when the data unit size equals the block size.
+ */
+
+#define CRYPTO_SW_MIN_DATA_UNIT_SIZE	512
+#define CRYPTO_SW_MAX_DATA_UNIT_SIZE	(64 * 1024)
+
+/* Per channel cipher state; key schedules are set up once at channel creation. */
+struct crypto_sw_ctx {
+	EVP_CIPHER_CTX			*encrypt;
+	EVP_CIPHER_CTX			*decrypt;
+	uint32_t			data_unit_size;
+	/* Bounce buffer for data units that are split between iovecs */
+	uint8_t				*bounce;
+};
+
+/**
+ * Initialize the cipher state of one channel.
+ *
+ * \param ctx Context to initialize.
+ * \param cipher AES_CBC or AES_XTS.
+ * \param key Key, 16 bytes.
+ * \param key2 2nd key for AES_XTS, 16 bytes, NULL for AES_CBC.
+ * \param data_unit_size Bytes processed with a single tweak/IV, a multiple of 16.
+ * \return 0 on success, negative errno on failure.
+ */
+int crypto_sw_ctx_init(struct crypto_sw_ctx *ctx, const char *cipher,
+		       const uint8_t *key, const uint8_t *key2,
+		       uint32_t data_unit_size);
+
+/**
+ * Free the cipher state of one channel.
+ *
+ * \param ctx Context to free.
+ */
+void crypto_sw_ctx_fini(struct crypto_sw_ctx *ctx);
+
+/**
+ * Encrypt or decrypt len bytes from src_iovs into dst_iovs.  len must be a
+ * multiple of the data unit size.  If dst_iovs is NULL, the data is processed
+ * in place.
+ *
+ * \param ctx Channel context.
+ * \param encrypt true to encrypt, false to decrypt.
+ * \param src_iovs Source buffers.
+ * \param src_iovcnt Number of source buffers.
+ * \param dst_iovs Destination buffers, or NULL.
+ * \param dst_iovcnt Number of destination buffers.
+ * \param first_unit Index of the first data unit, used as tweak/IV.
+ * \param len Number of bytes to process.
+ * \return 0 on success, negative errno on failure.
+ */
+int crypto_sw_crypt(struct crypto_sw_ctx *ctx, bool encrypt,
+		    struct iovec *src_iovs, int src_iovcnt,
+		    struct iovec *dst_iovs, int dst_iovcnt,
+		    uint64_t first_unit, uint64_t len);
+
+#endif /* SPDK_VBDEV_CRYPTO_SW_H */
@@ -238,6 +238,7 @@ bdev_ftl_write_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w
 
 	spdk_json_write_named_bool(w, "allow_open_bands", conf->allow_open_bands);
 	spdk_json_write_named_uint64(w, "overprovisioning", conf->lba_rsvd);
+	spdk_json_write_named_bool(w, "hot_cold_separation", conf->hot_cold_separation);
 	spdk_json_write_named_uint64(w, "limit_crit", conf->limits[SPDK_FTL_LIMIT_CRIT].limit);
 	spdk_json_write_named_uint64(w, "limit_crit_threshold", conf->limits[SPDK_FTL_LIMIT_CRIT].thld);
 	spdk_json_write_named_uint64(w, "limit_high", conf->limits[SPDK_FTL_LIMIT_HIGH].limit);
@@ -249,6 +250,12 @@ bdev_ftl_write_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w
 	if (conf->l2p_path) {
 		spdk_json_write_named_string(w, "l2p_path", conf->l2p_path);
 	}
+	if (conf->l2p_dram_limit) {
+		spdk_json_write_named_uint64(w, "l2p_dram_limit", conf->l2p_dram_limit);
+	}
+	if (conf->l2p_bdev) {
+		spdk_json_write_named_string(w, "l2p_bdev", conf->l2p_bdev);
+	}
 
 	spdk_uuid_fmt_lower(uuid, sizeof(uuid), &attrs.uuid);
 	spdk_json_write_named_string(w, "uuid", uuid);
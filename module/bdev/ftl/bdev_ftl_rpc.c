@@ -55,6 +55,7 @@ free_rpc_bdev_ftl_create(struct rpc_bdev_ftl_create *req)
 	free(req->uuid);
 	free(req->cache_bdev);
 	free((char *)req->ftl_conf.l2p_path);
+	free((char *)req->ftl_conf.l2p_bdev);
 }
 
 static const struct spdk_json_object_decoder rpc_bdev_ftl_create_decoders[] = {
@@ -74,11 +75,25 @@ static const struct spdk_json_object_decoder rpc_bdev_ftl_create_decoders[] = {
 		"use_append", offsetof(struct rpc_bdev_ftl_create, ftl_conf) +
 		offsetof(struct spdk_ftl_conf, use_append), spdk_json_decode_bool, true
 	},
+	{
+		"hot_cold_separation", offsetof(struct rpc_bdev_ftl_create, ftl_conf) +
+		offsetof(struct spdk_ftl_conf, hot_cold_separation), spdk_json_decode_bool, true
+	},
 	{
 		"l2p_path", offsetof(struct rpc_bdev_ftl_create, ftl_conf) +
 		offsetof(struct spdk_ftl_conf, l2p_path),
 		spdk_json_decode_string, true
 	},
+	{
+		"l2p_dram_limit", offsetof(struct rpc_bdev_ftl_create, ftl_conf) +
+		offsetof(struct spdk_ftl_conf, l2p_dram_limit),
+		spdk_json_decode_uint64, true
+	},
+	{
+		"l2p_bdev", offsetof(struct rpc_bdev_ftl_create, ftl_conf) +
+		offsetof(struct spdk_ftl_conf, l2p_bdev),
+		spdk_json_decode_string, true
+	},
 	{
 		"limit_crit", offsetof(struct rpc_bdev_ftl_create, ftl_conf) +
 		offsetof(struct spdk_ftl_conf, limits[SPDK_FTL_LIMIT_CRIT]) +
@@ -98,6 +98,18 @@ struct nvme_probe_ctx {
 	const char *names[NVME_MAX_CONTROLLERS];
 	uint32_t prchk_flags[NVME_MAX_CONTROLLERS];
 	const char *hostnqn;
+	uint64_t start_tsc;
+};
+
+/* Tracks the controllers from the configuration file attached during module init */
+struct nvme_init_ctx {
+	struct nvme_probe_ctx		*probe_ctx;
+	struct spdk_nvme_probe_ctx	*pcie_probe_ctx;
+	struct spdk_poller		*pcie_poller;
+	/* Number of local probes and remote connects still in progress */
+	uint32_t			pending;
+	bool				hotplug_enabled;
+	int64_t				hotplug_period;
 };
 
 struct nvme_probe_skip_entry {
@@ -212,6 +224,7 @@ bdev_nvme_get_ctx_size(void)
 
 static struct spdk_bdev_module nvme_if = {
 	.name = "nvme",
+	.async_init = true,
 	.async_fini = true,
 	.module_init = bdev_nvme_library_init,
 	.module_fini = bdev_nvme_library_fini,
@@ -1340,6 +1353,16 @@ create_ctrlr(struct spdk_nvme_ctrlr *ctrlr,
 	return 0;
 }
 
+static void
+nvme_bdev_ctrlr_set_attach_time(struct nvme_bdev_ctrlr *nvme_bdev_ctrlr, uint64_t start_tsc)
+{
+	nvme_bdev_ctrlr->attach_time_us = (spdk_get_ticks() - start_tsc) * SPDK_SEC_TO_USEC /
+					  spdk_get_ticks_hz();
+
+	SPDK_INFOLOG(SPDK_LOG_BDEV_NVME, "Attached %s (traddr: %s) in %" PRIu64 " us\n",
+		     nvme_bdev_ctrlr->name, nvme_bdev_ctrlr->trid.traddr, nvme_bdev_ctrlr->attach_time_us);
+}
+
 static void
 attach_cb(void *cb_ctx, const struct spdk_nvme_transport_id *trid,
 	  struct spdk_nvme_ctrlr *ctrlr, const struct spdk_nvme_ctrlr_opts *opts)
@@ -1377,6 +1400,10 @@ attach_cb(void *cb_ctx, const struct spdk_nvme_transport_id *trid,
 		return;
 	}
 
+	if (ctx) {
+		nvme_bdev_ctrlr_set_attach_time(nvme_bdev_ctrlr, ctx->start_tsc);
+	}
+
 	nvme_ctrlr_populate_namespaces(nvme_bdev_ctrlr, NULL);
 
 	free(name);
@@ -1553,7 +1580,10 @@ nvme_ctrlr_populate_namespaces_done(struct nvme_async_probe_ctx *ctx)
 		}
 		assert(ns->id == nsid);
 		TAILQ_FOREACH_SAFE(nvme_bdev, &ns->bdevs, tailq, tmp) {
-			if (j < ctx->count) {
+			if (ctx->names == NULL) {
+				/* The caller is only interested in the number of bdevs */
+				j++;
+			} else if (j < ctx->count) {
 				ctx->names[j] = nvme_bdev->disk.name;
 				j++;
 			} else {
@@ -1591,6 +1621,8 @@ connect_attach_cb(void *cb_ctx, const struct spdk_nvme_transport_id *trid,
 	nvme_bdev_ctrlr = nvme_bdev_ctrlr_get(&ctx->trid);
 	assert(nvme_bdev_ctrlr != NULL);
 
+	nvme_bdev_ctrlr_set_attach_time(nvme_bdev_ctrlr, ctx->start_tsc);
+
 	nvme_ctrlr_populate_namespaces(nvme_bdev_ctrlr, ctx);
 }
 
@@ -1603,7 +1635,7 @@ bdev_nvme_async_poll(void *arg)
 	rc = spdk_nvme_probe_poll_async(ctx->probe_ctx);
 	if (spdk_unlikely(rc != -EAGAIN && rc != 0)) {
 		spdk_poller_unregister(&ctx->poller);
-		free(ctx);
+		populate_namespaces_cb(ctx, 0, rc);
 	}
 
 	return 1;
@@ -1654,6 +1686,7 @@ spdk_bdev_nvme_create(struct spdk_nvme_transport_id *trid,
 	ctx->cb_ctx = cb_ctx;
 	ctx->prchk_flags = prchk_flags;
 	ctx->trid = *trid;
+	ctx->start_tsc = spdk_get_ticks();
 
 	spdk_nvme_ctrlr_get_default_ctrlr_opts(&ctx->opts, sizeof(ctx->opts));
 	ctx->opts.transport_retry_count = g_opts.retry_count;
@@ -1710,16 +1743,99 @@ spdk_bdev_nvme_delete(const char *name)
 	return 0;
 }
 
+static void
+bdev_nvme_library_init_done(struct nvme_init_ctx *init_ctx)
+{
+	struct nvme_probe_ctx *probe_ctx = init_ctx->probe_ctx;
+	size_t i, attached = 0;
+	uint64_t elapsed_us;
+	int rc;
+
+	for (i = 0; i < probe_ctx->count; i++) {
+		if (nvme_bdev_ctrlr_get(&probe_ctx->trids[i])) {
+			attached++;
+			continue;
+		}
+
+		if (probe_ctx->trids[i].trtype == SPDK_NVME_TRANSPORT_PCIE) {
+			SPDK_ERRLOG("NVMe SSD \"%s\" could not be found.\n", probe_ctx->trids[i].traddr);
+			SPDK_ERRLOG("Check PCIe BDF and that it is attached to UIO/VFIO driver.\n");
+		} else {
+			SPDK_ERRLOG("Unable to connect to provided trid (traddr: %s)\n",
+				    probe_ctx->trids[i].traddr);
+		}
+	}
+
+	elapsed_us = (spdk_get_ticks() - probe_ctx->start_tsc) * SPDK_SEC_TO_USEC / spdk_get_ticks_hz();
+	SPDK_NOTICELOG("Attached %zu of %zu configured NVMe controllers in %" PRIu64 " us\n",
+		       attached, probe_ctx->count, elapsed_us);
+
+	/*
+	 * The hotplug poller is started only now, so that it does not race with
+	 *  the initial probe for the devices listed in the configuration file.
+	 */
+	rc = spdk_bdev_nvme_set_hotplug(init_ctx->hotplug_enabled, init_ctx->hotplug_period, NULL, NULL);
+	if (rc) {
+		SPDK_ERRLOG("Failed to setup hotplug (%d): %s", rc, spdk_strerror(rc));
+	}
+
+	free(probe_ctx);
+	free(init_ctx);
+	spdk_bdev_module_init_done(&nvme_if);
+}
+
+static void
+bdev_nvme_library_init_put(struct nvme_init_ctx *init_ctx)
+{
+	assert(init_ctx->pending > 0);
+	if (--init_ctx->pending == 0) {
+		bdev_nvme_library_init_done(init_ctx);
+	}
+}
+
+static void
+bdev_nvme_library_init_connect_done(void *cb_ctx, size_t bdev_count, int rc)
+{
+	/* Failures are reported once all the controllers are processed */
+	bdev_nvme_library_init_put(cb_ctx);
+}
+
+static int
+bdev_nvme_library_init_pcie_poll(void *arg)
+{
+	struct nvme_init_ctx *init_ctx = arg;
+	int rc;
+
+	rc = spdk_nvme_probe_poll_async(init_ctx->pcie_probe_ctx);
+	if (rc == -EAGAIN) {
+		return 1;
+	}
+
+	/* The probe context is freed by spdk_nvme_probe_poll_async() once it completes */
+	init_ctx->pcie_probe_ctx = NULL;
+	spdk_poller_unregister(&init_ctx->pcie_poller);
+	bdev_nvme_library_init_put(init_ctx);
+
+	return 1;
+}
+
+/*
+ * Controllers from the configuration file are attached concurrently: local
+ *  NVMe devices are probed asynchronously and every remote controller is
+ *  connected on its own, so that none of them waits for the others to finish
+ *  their initialization. The module completes its initialization once all of
+ *  them are done.
+ */
 static int
 bdev_nvme_library_init(void)
 {
-	struct nvme_bdev_ctrlr *nvme_bdev_ctrlr;
 	struct spdk_conf_section *sp;
 	const char *val;
 	int rc = 0;
 	int64_t intval = 0;
 	size_t i;
 	struct nvme_probe_ctx *probe_ctx = NULL;
+	struct nvme_init_ctx *init_ctx;
 	int retry_count;
 	uint32_t local_nvme_num = 0;
 	int64_t hotplug_period;
@@ -1834,9 +1950,6 @@ bdev_nvme_library_init(void)
 		probe_ctx->count++;
 
 		if (probe_ctx->trids[i].trtype != SPDK_NVME_TRANSPORT_PCIE) {
-			struct spdk_nvme_ctrlr *ctrlr;
-			struct spdk_nvme_ctrlr_opts opts;
-
 			if (nvme_bdev_ctrlr_get(&probe_ctx->trids[i])) {
 				SPDK_ERRLOG("A controller with the provided trid (traddr: %s) already exists.\n",
 					    probe_ctx->trids[i].traddr);
@@ -1849,74 +1962,72 @@ bdev_nvme_library_init(void)
 				rc = -1;
 				goto end;
 			}
-
-			spdk_nvme_ctrlr_get_default_ctrlr_opts(&opts, sizeof(opts));
-			opts.transport_retry_count = g_opts.retry_count;
-
-			if (probe_ctx->hostnqn != NULL) {
-				snprintf(opts.hostnqn, sizeof(opts.hostnqn), "%s", probe_ctx->hostnqn);
-			}
-
-			if (probe_ctx->hostids[i].hostaddr[0] != '\0') {
-				snprintf(opts.src_addr, sizeof(opts.src_addr), "%s", probe_ctx->hostids[i].hostaddr);
-			}
-
-			if (probe_ctx->hostids[i].hostsvcid[0] != '\0') {
-				snprintf(opts.src_svcid, sizeof(opts.src_svcid), "%s", probe_ctx->hostids[i].hostsvcid);
-			}
-
-			ctrlr = spdk_nvme_connect(&probe_ctx->trids[i], &opts, sizeof(opts));
-			if (ctrlr == NULL) {
-				SPDK_ERRLOG("Unable to connect to provided trid (traddr: %s)\n",
-					    probe_ctx->trids[i].traddr);
-				rc = -1;
-				goto end;
-			}
-
-			rc = create_ctrlr(ctrlr, probe_ctx->names[i], &probe_ctx->trids[i], 0);
-			if (rc) {
-				goto end;
-			}
-
-			nvme_bdev_ctrlr = nvme_bdev_ctrlr_get(&probe_ctx->trids[i]);
-			if (!nvme_bdev_ctrlr) {
-				SPDK_ERRLOG("Failed to find new NVMe controller\n");
-				rc = -ENODEV;
-				goto end;
-			}
-
-			nvme_ctrlr_populate_namespaces(nvme_bdev_ctrlr, NULL);
 		} else {
 			local_nvme_num++;
 		}
 	}
 
+	init_ctx = calloc(1, sizeof(*init_ctx));
+	if (init_ctx == NULL) {
+		SPDK_ERRLOG("Failed to allocate init_ctx\n");
+		rc = -1;
+		goto end;
+	}
+
+	init_ctx->probe_ctx = probe_ctx;
+	init_ctx->hotplug_enabled = hotplug_enabled;
+	init_ctx->hotplug_period = hotplug_period;
+	/* Hold a reference until all the attaches are started */
+	init_ctx->pending = 1;
+	probe_ctx->start_tsc = spdk_get_ticks();
+
 	if (local_nvme_num > 0) {
+		/*
+		 * Register the poller first - it doesn't run before we return, and a
+		 *  started probe couldn't be cancelled if the registration failed.
+		 */
+		init_ctx->pcie_poller = spdk_poller_register(bdev_nvme_library_init_pcie_poll, init_ctx, 0);
+		if (init_ctx->pcie_poller == NULL) {
+			SPDK_ERRLOG("Failed to register the NVMe probe poller\n");
+			free(init_ctx);
+			rc = -ENOMEM;
+			goto end;
+		}
+
 		/* used to probe local NVMe device */
-		if (spdk_nvme_probe(NULL, probe_ctx, probe_cb, attach_cb, remove_cb)) {
+		init_ctx->pcie_probe_ctx = spdk_nvme_probe_async(NULL, probe_ctx, probe_cb, attach_cb, remove_cb);
+		if (init_ctx->pcie_probe_ctx == NULL) {
+			spdk_poller_unregister(&init_ctx->pcie_poller);
+			free(init_ctx);
 			rc = -1;
 			goto end;
 		}
 
-		for (i = 0; i < probe_ctx->count; i++) {
-			if (probe_ctx->trids[i].trtype != SPDK_NVME_TRANSPORT_PCIE) {
-				continue;
-			}
+		init_ctx->pending++;
+	}
 
-			if (!nvme_bdev_ctrlr_get(&probe_ctx->trids[i])) {
-				SPDK_ERRLOG("NVMe SSD \"%s\" could not be found.\n", probe_ctx->trids[i].traddr);
-				SPDK_ERRLOG("Check PCIe BDF and that it is attached to UIO/VFIO driver.\n");
-			}
+	for (i = 0; i < probe_ctx->count; i++) {
+		if (probe_ctx->trids[i].trtype == SPDK_NVME_TRANSPORT_PCIE) {
+			continue;
 		}
-	}
 
-	rc = spdk_bdev_nvme_set_hotplug(hotplug_enabled, hotplug_period, NULL, NULL);
-	if (rc) {
-		SPDK_ERRLOG("Failed to setup hotplug (%d): %s", rc, spdk_strerror(rc));
-		rc = -1;
+		init_ctx->pending++;
+		rc = spdk_bdev_nvme_create(&probe_ctx->trids[i], &probe_ctx->hostids[i], probe_ctx->names[i],
+					   NULL, 0, probe_ctx->hostnqn, 0,
+					   bdev_nvme_library_init_connect_done, init_ctx);
+		if (rc) {
+			init_ctx->pending--;
+		}
 	}
+
+	bdev_nvme_library_init_put(init_ctx);
+	return 0;
+
 end:
 	free(probe_ctx);
+	if (rc == 0) {
+		spdk_bdev_module_init_done(&nvme_if);
+	}
 	return rc;
 }
 
@@ -372,6 +372,10 @@ spdk_rpc_dump_nvme_controller_info(struct spdk_json_write_ctx *w,
 	nvme_bdev_dump_trid_json(trid, w);
 	spdk_json_write_object_end(w);
 
+	if (nvme_bdev_ctrlr->attach_time_us != 0) {
+		spdk_json_write_named_uint64(w, "attach_time_us", nvme_bdev_ctrlr->attach_time_us);
+	}
+
 	spdk_json_write_object_end(w);
 }
 
@@ -90,6 +90,11 @@ struct nvme_bdev_ctrlr {
 	uint32_t			num_ns;
 	/** Array of pointers to namespaces indexed by nsid - 1 */
 	struct nvme_bdev_ns		**namespaces;
+	/**
+	 * Time in microseconds from the start of the probe or connect until the
+	 * controller was attached. Zero for hot inserted controllers.
+	 */
+	uint64_t			attach_time_us;
 
 	struct spdk_opal_dev		*opal_dev;
 
@@ -123,6 +128,7 @@ struct nvme_async_probe_ctx {
 	spdk_bdev_create_nvme_fn cb_fn;
 	void *cb_ctx;
 	uint32_t populates_in_progress;
+	uint64_t start_tsc;
 };
 
 struct ocssd_io_channel;
@@ -42,6 +42,58 @@
 
 ocf_ctx_t vbdev_ocf_ctx;
 
+/* Number of pages in the buffer pool
+ * Need to be power of two - 1 for better memory utilization */
+#define VBDEV_OCF_CTX_BUF_POOL_SIZE 4095
+
+/* Pool of page buffers for data allocated by OCF (e.g. cache lines)
+ * Its elements only point to pages of a single DMA-able allocation,
+ * so that the pages stay aligned without padding every element */
+static struct spdk_mempool *g_buf_pool;
+static void *g_buf_pool_pages;
+/* Pool element pointing to each of the pages */
+static void **g_buf_pool_objs;
+
+static void
+vbdev_ocf_ctx_buf_ctor(struct spdk_mempool *mp, void *arg, void *obj, unsigned idx)
+{
+	*(void **)obj = (char *)g_buf_pool_pages + (size_t)idx * PAGE_SIZE;
+	g_buf_pool_objs[idx] = obj;
+}
+
+static bool
+vbdev_ocf_ctx_buf_pooled(void *buf)
+{
+	return buf >= g_buf_pool_pages &&
+	       (char *)buf < (char *)g_buf_pool_pages + VBDEV_OCF_CTX_BUF_POOL_SIZE * PAGE_SIZE;
+}
+
+static ctx_data_t *
+vbdev_ocf_ctx_data_alloc_pooled(uint32_t pages)
+{
+	struct bdev_ocf_data *data;
+	void *objs[VBDEV_OCF_DATA_POOL_IOVS];
+	uint32_t i;
+
+	if (spdk_mempool_get_bulk(g_buf_pool, objs, pages)) {
+		return NULL;
+	}
+
+	data = vbdev_ocf_data_alloc(pages);
+	if (data == NULL) {
+		spdk_mempool_put_bulk(g_buf_pool, objs, pages);
+		return NULL;
+	}
+
+	for (i = 0; i < pages; i++) {
+		vbdev_ocf_iovs_add(data, *(void **)objs[i], PAGE_SIZE);
+	}
+
+	data->size = pages * PAGE_SIZE;
+
+	return data;
+}
+
 static ctx_data_t *
 vbdev_ocf_ctx_data_alloc(uint32_t pages)
 {
@@ -49,12 +101,25 @@ vbdev_ocf_ctx_data_alloc(uint32_t pages)
 	void *buf;
 	uint32_t sz;
 
+	/* Cache line sized buffers come from the pool's per-core cache,
+	 * larger ones (and all of them once the pool runs out) from the heap */
+	if (pages > 0 && pages <= VBDEV_OCF_DATA_POOL_IOVS) {
+		data = vbdev_ocf_ctx_data_alloc_pooled(pages);
+		if (data) {
+			return data;
+		}
+	}
+
 	data = vbdev_ocf_data_alloc(1);
+	if (data == NULL) {
+		return NULL;
+	}
 
 	sz = pages * PAGE_SIZE;
 	buf = spdk_malloc(sz, PAGE_SIZE, NULL,
 			  SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
 	if (buf == NULL) {
+		vbdev_ocf_data_free(data);
 		return NULL;
 	}
 
@@ -69,6 +134,7 @@ static void
 vbdev_ocf_ctx_data_free(ctx_data_t *ctx_data)
 {
 	struct bdev_ocf_data *data = ctx_data;
+	void *buf;
 	int i;
 
 	if (!data) {
@@ -76,7 +142,14 @@ vbdev_ocf_ctx_data_free(ctx_data_t *ctx_data)
 	}
 
 	for (i = 0; i < data->iovcnt; i++) {
-		spdk_free(data->iovs[i].iov_base);
+		buf = data->iovs[i].iov_base;
+
+		if (vbdev_ocf_ctx_buf_pooled(buf)) {
+			spdk_mempool_put(g_buf_pool,
+					 g_buf_pool_objs[((char *)buf - (char *)g_buf_pool_pages) / PAGE_SIZE]);
+		} else {
+			spdk_free(buf);
+		}
 	}
 
 	vbdev_ocf_data_free(data);
@@ -527,13 +600,75 @@ static const struct ocf_ctx_config vbdev_ocf_ctx_cfg = {
 	},
 };
 
+static void
+vbdev_ocf_ctx_buf_pool_free(void)
+{
+	if (g_buf_pool) {
+		if (spdk_mempool_count(g_buf_pool) != VBDEV_OCF_CTX_BUF_POOL_SIZE) {
+			SPDK_ERRLOG("Not all OCF buffers were freed\n");
+		}
+
+		spdk_mempool_free(g_buf_pool);
+		g_buf_pool = NULL;
+	}
+
+	spdk_free(g_buf_pool_pages);
+	g_buf_pool_pages = NULL;
+	free(g_buf_pool_objs);
+	g_buf_pool_objs = NULL;
+}
+
+static int
+vbdev_ocf_ctx_buf_pool_create(void)
+{
+	char pool_name[32];
+	size_t cache_size;
+
+	g_buf_pool_pages = spdk_malloc(VBDEV_OCF_CTX_BUF_POOL_SIZE * PAGE_SIZE, PAGE_SIZE, NULL,
+				       SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+	g_buf_pool_objs = calloc(VBDEV_OCF_CTX_BUF_POOL_SIZE, sizeof(*g_buf_pool_objs));
+	if (!g_buf_pool_pages || !g_buf_pool_objs) {
+		goto error;
+	}
+
+	/* Don't let more than half of the pages end up in the per-core caches */
+	cache_size = VBDEV_OCF_CTX_BUF_POOL_SIZE / (2 * spdk_thread_get_count());
+	snprintf(pool_name, sizeof(pool_name), "ocf_buf_%d", getpid());
+
+	g_buf_pool = spdk_mempool_create_ctor(pool_name, VBDEV_OCF_CTX_BUF_POOL_SIZE,
+					      sizeof(void *), cache_size, SPDK_ENV_SOCKET_ID_ANY,
+					      vbdev_ocf_ctx_buf_ctor, NULL);
+	if (!g_buf_pool) {
+		goto error;
+	}
+
+	return 0;
+error:
+	SPDK_ERRLOG("Failed to create OCF buffer pool\n");
+	vbdev_ocf_ctx_buf_pool_free();
+	return -ENOMEM;
+}
+
 int
 vbdev_ocf_ctx_init(void)
 {
 	int ret;
 
+	ret = vbdev_ocf_data_init();
+	if (ret) {
+		return ret;
+	}
+
+	ret = vbdev_ocf_ctx_buf_pool_create();
+	if (ret) {
+		vbdev_ocf_data_cleanup();
+		return ret;
+	}
+
 	ret = ocf_ctx_create(&vbdev_ocf_ctx, &vbdev_ocf_ctx_cfg);
 	if (ret < 0) {
+		vbdev_ocf_ctx_buf_pool_free();
+		vbdev_ocf_data_cleanup();
 		return ret;
 	}
 
@@ -545,6 +680,9 @@ vbdev_ocf_ctx_cleanup(void)
 {
 	ocf_ctx_put(vbdev_ocf_ctx);
 	vbdev_ocf_ctx = NULL;
+
+	vbdev_ocf_ctx_buf_pool_free();
+	vbdev_ocf_data_cleanup();
 }
 
 SPDK_LOG_REGISTER_COMPONENT("ocf_ocfctx", SPDK_LOG_OCFCTX)
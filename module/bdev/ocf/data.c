@@ -33,19 +33,80 @@
 
 #include <ocf/ocf.h>
 #include "spdk/bdev.h"
+#include "spdk/env.h"
 #include "data.h"
 
+/* Number of data structures in the pool
+ * Need to be power of two - 1 for better memory utilization */
+#define VBDEV_OCF_DATA_POOL_SIZE 16383
+
+static struct spdk_mempool *g_data_pool;
+
+int
+vbdev_ocf_data_init(void)
+{
+	char pool_name[32];
+
+	snprintf(pool_name, sizeof(pool_name), "ocf_data_%d", getpid());
+
+	g_data_pool = spdk_mempool_create(pool_name, VBDEV_OCF_DATA_POOL_SIZE,
+					  sizeof(struct bdev_ocf_data) +
+					  sizeof(struct iovec) * VBDEV_OCF_DATA_POOL_IOVS,
+					  SPDK_MEMPOOL_DEFAULT_CACHE_SIZE,
+					  SPDK_ENV_SOCKET_ID_ANY);
+	if (!g_data_pool) {
+		SPDK_ERRLOG("Failed to create OCF data pool\n");
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+void
+vbdev_ocf_data_cleanup(void)
+{
+	if (g_data_pool) {
+		if (spdk_mempool_count(g_data_pool) != VBDEV_OCF_DATA_POOL_SIZE) {
+			SPDK_ERRLOG("Not all OCF data structures were freed\n");
+		}
+
+		spdk_mempool_free(g_data_pool);
+		g_data_pool = NULL;
+	}
+}
+
+static inline bool
+vbdev_ocf_data_pooled(struct bdev_ocf_data *data)
+{
+	return data->iovs == (struct iovec *)(data + 1);
+}
+
 struct bdev_ocf_data *
 vbdev_ocf_data_alloc(uint32_t iovcnt)
 {
 	struct bdev_ocf_data *data;
 
+	/* Take small data from the pool, its per-core cache doesn't need any locks */
+	if (iovcnt <= VBDEV_OCF_DATA_POOL_IOVS) {
+		data = spdk_mempool_get(g_data_pool);
+		if (data) {
+			data->iovs = (struct iovec *)(data + 1);
+			data->iovcnt = 0;
+			data->iovalloc = VBDEV_OCF_DATA_POOL_IOVS;
+			data->size = 0;
+			data->seek = 0;
+
+			return data;
+		}
+	}
+
 	data = env_malloc(sizeof(*data), ENV_MEM_NOIO);
 	if (!data) {
 		return NULL;
 	}
 
 	data->seek = 0;
+	data->iovs = NULL;
 
 	if (iovcnt) {
 		data->iovs = env_malloc(sizeof(*data->iovs) * iovcnt, ENV_MEM_NOIO);
@@ -68,6 +129,11 @@ vbdev_ocf_data_free(struct bdev_ocf_data *data)
 		return;
 	}
 
+	if (vbdev_ocf_data_pooled(data)) {
+		spdk_mempool_put(g_data_pool, data);
+		return;
+	}
+
 	if (data->iovalloc != 0) {
 		env_free(data->iovs);
 	}
@@ -36,6 +36,11 @@
 
 #include "spdk/bdev_module.h"
 
+/* Number of vectors embedded in the data taken from the pool
+ * Buffers allocated for OCF of up to this many pages are described
+ * by one vector per page and don't go through the heap */
+#define VBDEV_OCF_DATA_POOL_IOVS 8
+
 struct bdev_ocf_data {
 	struct iovec *iovs;
 	int iovcnt;
@@ -46,6 +51,10 @@ struct bdev_ocf_data {
 
 struct bdev_ocf_data *vbdev_ocf_data_from_spdk_io(struct spdk_bdev_io *bdev_io);
 
+int vbdev_ocf_data_init(void);
+
+void vbdev_ocf_data_cleanup(void);
+
 struct bdev_ocf_data *vbdev_ocf_data_alloc(uint32_t nvecs);
 
 void vbdev_ocf_data_free(struct bdev_ocf_data *data);
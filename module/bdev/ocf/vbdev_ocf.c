@@ -547,12 +547,17 @@ static void
 vbdev_ocf_io_submit_cb(struct ocf_io *io, int error)
 {
 	struct spdk_bdev_io *bdev_io = io->priv1;
+	struct vbdev_ocf_qcxt *qctx = io->priv2;
+
+	qctx->stats.completed++;
 
 	if (error == 0) {
 		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
 	} else if (error == -ENOMEM) {
+		qctx->stats.nomem++;
 		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_NOMEM);
 	} else {
+		qctx->stats.failed++;
 		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
 	}
 
@@ -622,10 +627,13 @@ io_handle(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
 		goto fail;
 	}
 
-	ocf_io_set_cmpl(io, bdev_io, NULL, vbdev_ocf_io_submit_cb);
+	ocf_io_set_cmpl(io, bdev_io, qctx, vbdev_ocf_io_submit_cb);
 
+	/* Counted before submission, as OCF may complete the IO synchronously */
+	qctx->stats.submitted++;
 	err = io_submit_to_ocf(bdev_io, io);
 	if (err) {
+		qctx->stats.submitted--;
 		goto fail;
 	}
 
@@ -764,17 +772,20 @@ queue_poll(void *opaque)
 {
 	struct vbdev_ocf_qcxt *qctx = opaque;
 	uint32_t iono = ocf_queue_pending_io(qctx->queue);
-	int i, max = spdk_min(32, iono);
+	int i, max = spdk_min(VBDEV_OCF_QUEUE_POLL_BATCH, iono);
+
+	if (iono == 0) {
+		return 0;
+	}
 
 	for (i = 0; i < max; i++) {
 		ocf_queue_run_single(qctx->queue);
 	}
 
-	if (iono > 0) {
-		return 1;
-	} else {
-		return 0;
-	}
+	qctx->stats.requests_run += max;
+	qctx->stats.busy_polls++;
+
+	return 1;
 }
 
 /* Called during ocf_submit_io, ocf_purge*
@@ -43,6 +43,29 @@
 
 struct vbdev_ocf;
 
+/* Maximum number of OCF requests run by a queue poller in one iteration */
+#define VBDEV_OCF_QUEUE_POLL_BATCH 32
+
+/* Per queue statistics
+ * Updated only by the thread owning the queue */
+struct vbdev_ocf_qcxt_stats {
+	/* IOs submitted to OCF through this queue */
+	uint64_t                     submitted;
+	/* IOs completed by OCF, successfully or not */
+	uint64_t                     completed;
+	uint64_t                     failed;
+	uint64_t                     nomem;
+	/* OCF requests run by the queue poller */
+	uint64_t                     requests_run;
+	/* Poller iterations that found pending requests */
+	uint64_t                     busy_polls;
+	/* IOs submitted to base devices */
+	uint64_t                     cache_ios;
+	uint64_t                     core_ios;
+	/* Partial base IOs that needed io vectors allocated out of ocf_io context */
+	uint64_t                     iovs_allocated;
+};
+
 /* Context for OCF queue poller
  * Used for mapping SPDK threads to OCF queues */
 struct vbdev_ocf_qcxt {
@@ -55,6 +78,8 @@ struct vbdev_ocf_qcxt {
 	/* Base devices channels */
 	struct spdk_io_channel      *cache_ch;
 	struct spdk_io_channel      *core_ch;
+	/* Queue statistics */
+	struct vbdev_ocf_qcxt_stats  stats;
 	/* If true, we have to free this context on queue stop */
 	bool allocated;
 	/* Link to per-bdev list of queue contexts */
@@ -269,6 +269,88 @@ end:
 SPDK_RPC_REGISTER("bdev_ocf_get_stats", spdk_rpc_bdev_ocf_get_stats, SPDK_RPC_RUNTIME)
 SPDK_RPC_REGISTER_ALIAS_DEPRECATED(bdev_ocf_get_stats, get_ocf_stats)
 
+struct get_ocf_queue_stats_ctx {
+	struct spdk_jsonrpc_request *request;
+	struct spdk_json_write_ctx *w;
+};
+
+static void
+rpc_bdev_ocf_get_queue_stats_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct get_ocf_queue_stats_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+
+	spdk_json_write_array_end(ctx->w);
+	spdk_jsonrpc_end_result(ctx->request, ctx->w);
+	free(ctx);
+}
+
+static void
+rpc_bdev_ocf_get_queue_stats(struct spdk_io_channel_iter *i)
+{
+	struct get_ocf_queue_stats_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct vbdev_ocf_qcxt *qctx = spdk_io_channel_get_ctx(ch);
+	struct spdk_json_write_ctx *w = ctx->w;
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "thread", spdk_thread_get_name(spdk_get_thread()));
+	spdk_json_write_named_uint64(w, "submitted", qctx->stats.submitted);
+	spdk_json_write_named_uint64(w, "completed", qctx->stats.completed);
+	spdk_json_write_named_uint64(w, "failed", qctx->stats.failed);
+	spdk_json_write_named_uint64(w, "nomem", qctx->stats.nomem);
+	spdk_json_write_named_uint64(w, "requests_run", qctx->stats.requests_run);
+	spdk_json_write_named_uint64(w, "busy_polls", qctx->stats.busy_polls);
+	spdk_json_write_named_uint64(w, "cache_ios", qctx->stats.cache_ios);
+	spdk_json_write_named_uint64(w, "core_ios", qctx->stats.core_ios);
+	spdk_json_write_named_uint64(w, "iovs_allocated", qctx->stats.iovs_allocated);
+	spdk_json_write_object_end(w);
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+spdk_rpc_bdev_ocf_get_queue_stats(struct spdk_jsonrpc_request *request,
+				  const struct spdk_json_val *params)
+{
+	struct rpc_bdev_ocf_get_stats req = {NULL};
+	struct vbdev_ocf *vbdev;
+	struct get_ocf_queue_stats_ctx *ctx;
+
+	if (spdk_json_decode_object(params, rpc_bdev_ocf_get_stats_decoders,
+				    SPDK_COUNTOF(rpc_bdev_ocf_get_stats_decoders),
+				    &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Invalid parameters");
+		goto end;
+	}
+
+	vbdev = vbdev_ocf_get_by_name(req.name);
+	if (vbdev == NULL || !vbdev->state.started) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 spdk_strerror(ENODEV));
+		goto end;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "Not enough memory to process request");
+		goto end;
+	}
+
+	ctx->request = request;
+	ctx->w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_array_begin(ctx->w);
+
+	/* OCF vbdev itself is the io_device of its per-thread queue contexts */
+	spdk_for_each_channel(vbdev, rpc_bdev_ocf_get_queue_stats, ctx,
+			      rpc_bdev_ocf_get_queue_stats_done);
+
+end:
+	free_rpc_bdev_ocf_get_stats(&req);
+}
+SPDK_RPC_REGISTER("bdev_ocf_get_queue_stats", spdk_rpc_bdev_ocf_get_queue_stats, SPDK_RPC_RUNTIME)
+
 /* Structure to hold the parameters for this RPC method. */
 struct rpc_bdev_ocf_get_bdevs {
 	char *name;
@@ -242,10 +242,13 @@ prepare_submit(struct ocf_io *io)
 		return -EFAULT;
 	}
 
+	io_ctx->qctx = qctx;
 	if (base->is_cache) {
 		io_ctx->ch = qctx->cache_ch;
+		qctx->stats.cache_ios++;
 	} else {
 		io_ctx->ch = qctx->core_ch;
+		qctx->stats.core_ios++;
 	}
 
 	return rc;
@@ -325,13 +328,20 @@ vbdev_ocf_volume_submit_io(struct ocf_io *io)
 
 			iovcnt = io_ctx->data->iovcnt - i;
 
-			io_ctx->iovs_allocated = true;
-			iovs = env_malloc(sizeof(*iovs) * iovcnt, ENV_MEM_NOIO);
-
-			if (!iovs) {
-				SPDK_ERRLOG("allocation failed\n");
-				vbdev_ocf_volume_submit_io_cb(NULL, false, io);
-				return;
+			if (iovcnt <= VBDEV_OCF_IO_CTX_IOVS) {
+				iovs = io_ctx->iovs;
+			} else {
+				iovs = env_malloc(sizeof(*iovs) * iovcnt, ENV_MEM_NOIO);
+				if (!iovs) {
+					SPDK_ERRLOG("allocation failed\n");
+					vbdev_ocf_volume_submit_io_cb(NULL, false, io);
+					return;
+				}
+
+				io_ctx->iovs_allocated = true;
+				if (io_ctx->qctx) {
+					io_ctx->qctx->stats.iovs_allocated++;
+				}
 			}
 
 			initialize_cpy_vector(iovs, io_ctx->data->iovcnt, &io_ctx->data->iovs[i],
@@ -40,16 +40,27 @@
 #include "ctx.h"
 #include "data.h"
 
+/* Number of io vectors embedded in ocf_io context
+ * Partial (cache line) submissions spanning up to this many vectors
+ * do not need a separate allocation */
+#define VBDEV_OCF_IO_CTX_IOVS 8
+
+struct vbdev_ocf_qcxt;
+
 /* ocf_io context
  * It is initialized from io size and offset */
 struct ocf_io_ctx {
 	struct bdev_ocf_data *data;
 	struct spdk_io_channel *ch;
+	/* Queue context of the submitting thread, NULL for internal OCF queues */
+	struct vbdev_ocf_qcxt *qctx;
 	uint32_t offset;
 	int ref;
 	int rq_cnt;
 	int error;
 	bool iovs_allocated;
+	/* Copy of the part of data vectors submitted to base device */
+	struct iovec iovs[VBDEV_OCF_IO_CTX_IOVS];
 };
 
 int vbdev_ocf_volume_init(void);
@@ -301,25 +301,147 @@ spdk_rpc_dump_bdev_info(struct spdk_json_write_ctx *w,
 	spdk_json_write_object_end(w);
 }
 
+/* Number of bdevs examined by bdev_get_bdevs before yielding to other RPCs */
+#define RPC_BDEV_GET_BDEVS_BATCH	128
+/* Wait for the client to receive the response before writing more than this */
+#define RPC_BDEV_GET_BDEVS_MAX_UNSENT	(4 * 1024 * 1024)
+
 struct rpc_bdev_get_bdevs {
 	char *name;
+	char *product_name;
+	uint32_t offset;
+	uint32_t count;
 };
 
 static void
 free_rpc_bdev_get_bdevs(struct rpc_bdev_get_bdevs *r)
 {
 	free(r->name);
+	free(r->product_name);
 }
 
 static const struct spdk_json_object_decoder rpc_bdev_get_bdevs_decoders[] = {
 	{"name", offsetof(struct rpc_bdev_get_bdevs, name), spdk_json_decode_string, true},
+	{"product_name", offsetof(struct rpc_bdev_get_bdevs, product_name), spdk_json_decode_string, true},
+	{"offset", offsetof(struct rpc_bdev_get_bdevs, offset), spdk_json_decode_uint32, true},
+	{"count", offsetof(struct rpc_bdev_get_bdevs, count), spdk_json_decode_uint32, true},
+};
+
+struct rpc_bdev_get_bdevs_ctx {
+	struct rpc_bdev_get_bdevs req;
+	struct spdk_jsonrpc_request *request;
+	struct spdk_json_write_ctx *w;
+	/* Name of the last bdev examined, the next batch resumes right after it */
+	char *last_name;
+	/* Number of bdevs examined so far */
+	uint32_t num_examined;
+	/* Number of bdevs left to write, UINT32_MAX if unlimited */
+	uint32_t remaining;
+	struct spdk_poller *poller;
 };
 
+static struct spdk_bdev *
+rpc_bdev_get_bdevs_resume(struct rpc_bdev_get_bdevs_ctx *ctx)
+{
+	struct spdk_bdev *bdev = NULL;
+	uint32_t i;
+
+	if (ctx->num_examined == 0) {
+		return spdk_bdev_first();
+	}
+
+	if (ctx->last_name != NULL) {
+		bdev = spdk_bdev_get_by_name(ctx->last_name);
+	}
+
+	if (bdev != NULL) {
+		return spdk_bdev_next(bdev);
+	}
+
+	/* The last bdev got unregistered in the meantime, so fall back to its position */
+	bdev = spdk_bdev_first();
+	for (i = 0; bdev != NULL && i < ctx->num_examined; i++) {
+		bdev = spdk_bdev_next(bdev);
+	}
+
+	return bdev;
+}
+
+/*
+ * Write the next batch of bdevs. The bdev list can change between batches, so the
+ * position is kept as the name of the last bdev examined instead of a pointer.
+ *
+ * \return true once all the bdevs are written.
+ */
+static bool
+rpc_bdev_get_bdevs_write_batch(struct rpc_bdev_get_bdevs_ctx *ctx)
+{
+	struct spdk_bdev *bdev, *last = NULL;
+	uint32_t i;
+
+	bdev = rpc_bdev_get_bdevs_resume(ctx);
+
+	for (i = 0; bdev != NULL && ctx->remaining > 0 && i < RPC_BDEV_GET_BDEVS_BATCH; i++) {
+		ctx->num_examined++;
+		last = bdev;
+
+		if (ctx->req.product_name == NULL ||
+		    strcmp(spdk_bdev_get_product_name(bdev), ctx->req.product_name) == 0) {
+			if (ctx->req.offset > 0) {
+				ctx->req.offset--;
+			} else {
+				spdk_rpc_dump_bdev_info(ctx->w, bdev);
+				if (ctx->remaining != UINT32_MAX) {
+					ctx->remaining--;
+				}
+			}
+		}
+
+		bdev = spdk_bdev_next(bdev);
+	}
+
+	if (last != NULL) {
+		free(ctx->last_name);
+		ctx->last_name = strdup(spdk_bdev_get_name(last));
+	}
+
+	return bdev == NULL || ctx->remaining == 0;
+}
+
+static void
+rpc_bdev_get_bdevs_done(struct rpc_bdev_get_bdevs_ctx *ctx)
+{
+	spdk_json_write_array_end(ctx->w);
+	spdk_jsonrpc_end_result(ctx->request, ctx->w);
+
+	spdk_poller_unregister(&ctx->poller);
+	free_rpc_bdev_get_bdevs(&ctx->req);
+	free(ctx->last_name);
+	free(ctx);
+}
+
+static int
+rpc_bdev_get_bdevs_poll(void *arg)
+{
+	struct rpc_bdev_get_bdevs_ctx *ctx = arg;
+
+	if (spdk_jsonrpc_get_unsent_len(ctx->request) > RPC_BDEV_GET_BDEVS_MAX_UNSENT) {
+		return 0;
+	}
+
+	if (rpc_bdev_get_bdevs_write_batch(ctx)) {
+		rpc_bdev_get_bdevs_done(ctx);
+	}
+
+	return 1;
+}
+
 static void
 spdk_rpc_bdev_get_bdevs(struct spdk_jsonrpc_request *request,
 			const struct spdk_json_val *params)
 {
 	struct rpc_bdev_get_bdevs req = {};
+	struct rpc_bdev_get_bdevs_ctx *ctx;
 	struct spdk_json_write_ctx *w;
 	struct spdk_bdev *bdev = NULL;
 
@@ -341,23 +463,41 @@ spdk_rpc_bdev_get_bdevs(struct spdk_jsonrpc_request *request,
 			free_rpc_bdev_get_bdevs(&req);
 			return;
 		}
-	}
-
-	free_rpc_bdev_get_bdevs(&req);
-	w = spdk_jsonrpc_begin_result(request);
-	spdk_json_write_array_begin(w);
 
-	if (bdev != NULL) {
+		free_rpc_bdev_get_bdevs(&req);
+		w = spdk_jsonrpc_begin_result(request);
+		spdk_json_write_array_begin(w);
 		spdk_rpc_dump_bdev_info(w, bdev);
-	} else {
-		for (bdev = spdk_bdev_first(); bdev != NULL; bdev = spdk_bdev_next(bdev)) {
-			spdk_rpc_dump_bdev_info(w, bdev);
-		}
+		spdk_json_write_array_end(w);
+		spdk_jsonrpc_end_result(request, w);
+		return;
 	}
 
-	spdk_json_write_array_end(w);
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		spdk_jsonrpc_send_error_response(request, -ENOMEM, spdk_strerror(ENOMEM));
+		free_rpc_bdev_get_bdevs(&req);
+		return;
+	}
 
-	spdk_jsonrpc_end_result(request, w);
+	ctx->req = req;
+	ctx->request = request;
+	ctx->remaining = req.count != 0 ? req.count : UINT32_MAX;
+	ctx->w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_array_begin(ctx->w);
+
+	if (rpc_bdev_get_bdevs_write_batch(ctx)) {
+		rpc_bdev_get_bdevs_done(ctx);
+		return;
+	}
+
+	/* Write the rest of the bdevs over the following polls, so other RPCs aren't held up */
+	ctx->poller = spdk_poller_register(rpc_bdev_get_bdevs_poll, ctx, 0);
+	if (ctx->poller == NULL) {
+		while (!rpc_bdev_get_bdevs_write_batch(ctx)) {
+		}
+		rpc_bdev_get_bdevs_done(ctx);
+	}
 }
 SPDK_RPC_REGISTER("bdev_get_bdevs", spdk_rpc_bdev_get_bdevs, SPDK_RPC_RUNTIME)
 SPDK_RPC_REGISTER_ALIAS_DEPRECATED(bdev_get_bdevs, get_bdevs)
@@ -52,11 +52,36 @@
 
 #include "bdev_virtio.h"
 
+struct virtio_blk_io_ctx;
+
+struct bdev_virtio_blk_queue {
+	struct virtqueue		*vq;
+
+	/** Virtio response poller, running on the thread owning the virtqueue. */
+	struct spdk_poller		*poller;
+
+	/** Requests waiting for free descriptors. */
+	TAILQ_HEAD(, virtio_blk_io_ctx)	pending;
+
+	/**
+	 * Set once the owning channel is destroyed while the virtqueue still
+	 * holds requests of other channels. The virtqueue is released as soon
+	 * as it becomes idle.
+	 */
+	bool				released;
+};
+
 struct virtio_blk_dev {
 	struct virtio_dev		vdev;
 	struct spdk_bdev		bdev;
 	bool				readonly;
 	bool				unmap;
+
+	/** Per-virtqueue contexts, indexed by the virtqueue index. */
+	struct bdev_virtio_blk_queue	*queues;
+
+	/** Virtqueue to be shared by the next channel that can't get its own. */
+	uint16_t			next_shared_queue;
 };
 
 struct virtio_blk_io_ctx {
@@ -66,16 +91,25 @@ struct virtio_blk_io_ctx {
 	struct virtio_blk_outhdr		req;
 	struct virtio_blk_discard_write_zeroes	unmap;
 	uint8_t					resp;
+
+	/** Queue the request is submitted to. */
+	struct bdev_virtio_blk_queue		*queue;
+	enum spdk_bdev_io_status		status;
+	TAILQ_ENTRY(virtio_blk_io_ctx)		link;
 };
 
 struct bdev_virtio_blk_io_channel {
 	struct virtio_dev		*vdev;
 
-	/** Virtqueue exclusively assigned to this channel. */
-	struct virtqueue		*vq;
+	/**
+	 * Virtqueue this channel submits to. If there are more channels
+	 * than virtqueues, it might be owned by another thread, in which
+	 * case requests are forwarded to that thread.
+	 */
+	struct bdev_virtio_blk_queue	*queue;
 
-	/** Virtio response poller. */
-	struct spdk_poller		*poller;
+	/** True if the virtqueue is owned and polled by this channel. */
+	bool				owner;
 };
 
 /* Features desired/implemented by this driver. */
@@ -86,6 +120,7 @@ struct bdev_virtio_blk_io_channel {
 	 1ULL << VIRTIO_BLK_F_RO		|	\
 	 1ULL << VIRTIO_BLK_F_DISCARD		|	\
 	 1ULL << VIRTIO_RING_F_EVENT_IDX	|	\
+	 1ULL << VIRTIO_F_RING_PACKED		|	\
 	 1ULL << VHOST_USER_F_PROTOCOL_FEATURES)
 
 static int bdev_virtio_initialize(void);
@@ -129,20 +164,44 @@ bdev_virtio_blk_init_io_vreq(struct spdk_io_channel *ch, struct spdk_bdev_io *bd
 }
 
 static void
-bdev_virtio_blk_send_io(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
+_bdev_virtio_blk_io_complete(void *ctx)
+{
+	struct spdk_bdev_io *bdev_io = ctx;
+	struct virtio_blk_io_ctx *io_ctx = (struct virtio_blk_io_ctx *)bdev_io->driver_ctx;
+
+	spdk_bdev_io_complete(bdev_io, io_ctx->status);
+}
+
+/* Complete an I/O that may have been forwarded to the thread of another channel. */
+static void
+bdev_virtio_blk_io_complete(struct spdk_bdev_io *bdev_io, enum spdk_bdev_io_status status)
+{
+	struct virtio_blk_io_ctx *io_ctx = (struct virtio_blk_io_ctx *)bdev_io->driver_ctx;
+	struct spdk_thread *thread = spdk_bdev_io_get_thread(bdev_io);
+
+	if (spdk_likely(thread == spdk_get_thread())) {
+		spdk_bdev_io_complete(bdev_io, status);
+		return;
+	}
+
+	io_ctx->status = status;
+	spdk_thread_send_msg(thread, _bdev_virtio_blk_io_complete, bdev_io);
+}
+
+/*
+ * Put the request on the virtqueue. The device isn't notified here - all requests
+ * started within a single poller iteration are published by the next
+ * bdev_virtio_poll() with at most one notification.
+ */
+static int
+bdev_virtio_blk_start_io(struct virtqueue *vq, struct spdk_bdev_io *bdev_io)
 {
-	struct bdev_virtio_blk_io_channel *virtio_channel = spdk_io_channel_get_ctx(ch);
-	struct virtqueue *vq = virtio_channel->vq;
 	struct virtio_blk_io_ctx *io_ctx = (struct virtio_blk_io_ctx *)bdev_io->driver_ctx;
 	int rc;
 
 	rc = virtqueue_req_start(vq, bdev_io, bdev_io->u.bdev.iovcnt + 2);
-	if (rc == -ENOMEM) {
-		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_NOMEM);
-		return;
-	} else if (rc != 0) {
-		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
-		return;
+	if (rc != 0) {
+		return rc;
 	}
 
 	virtqueue_req_add_iovs(vq, &io_ctx->iov_req, 1, SPDK_VIRTIO_DESC_RO);
@@ -155,7 +214,149 @@ bdev_virtio_blk_send_io(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io
 	}
 	virtqueue_req_add_iovs(vq, &io_ctx->iov_resp, 1, SPDK_VIRTIO_DESC_WR);
 
-	virtqueue_req_flush(vq);
+	return 0;
+}
+
+/*
+ * Submit the request on a virtqueue owned by the current thread. Requests that
+ * don't fit are queued rather than completed with NOMEM, as the virtqueue may
+ * be full of requests of other channels, whose completions wouldn't trigger
+ * a retry of this channel's I/O.
+ */
+static void
+bdev_virtio_blk_queue_io(struct bdev_virtio_blk_queue *queue, struct spdk_bdev_io *bdev_io)
+{
+	struct virtio_blk_io_ctx *io_ctx = (struct virtio_blk_io_ctx *)bdev_io->driver_ctx;
+	int rc;
+
+	io_ctx->queue = queue;
+	if (spdk_unlikely(!TAILQ_EMPTY(&queue->pending))) {
+		TAILQ_INSERT_TAIL(&queue->pending, io_ctx, link);
+		return;
+	}
+
+	rc = bdev_virtio_blk_start_io(queue->vq, bdev_io);
+	if (rc == -ENOMEM) {
+		TAILQ_INSERT_TAIL(&queue->pending, io_ctx, link);
+	} else if (rc != 0) {
+		bdev_virtio_blk_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+static void
+bdev_virtio_blk_queue_retry(struct bdev_virtio_blk_queue *queue)
+{
+	struct virtio_blk_io_ctx *io_ctx;
+	struct spdk_bdev_io *bdev_io;
+	int rc;
+
+	while ((io_ctx = TAILQ_FIRST(&queue->pending)) != NULL) {
+		bdev_io = spdk_bdev_io_from_ctx(io_ctx);
+		rc = bdev_virtio_blk_start_io(queue->vq, bdev_io);
+		if (rc == -ENOMEM) {
+			break;
+		}
+
+		TAILQ_REMOVE(&queue->pending, io_ctx, link);
+		if (rc != 0) {
+			bdev_virtio_blk_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		}
+	}
+}
+
+static int bdev_virtio_poll(void *arg);
+
+static void
+bdev_virtio_blk_queue_start(struct bdev_virtio_blk_queue *queue)
+{
+	assert(queue->poller == NULL);
+	queue->released = false;
+	queue->poller = spdk_poller_register(bdev_virtio_poll, queue, 0);
+}
+
+static void
+bdev_virtio_blk_queue_stop(struct bdev_virtio_blk_queue *queue)
+{
+	spdk_poller_unregister(&queue->poller);
+	queue->released = false;
+	virtio_dev_release_queue(queue->vq->vdev, queue->vq->vq_queue_index);
+}
+
+static bool
+bdev_virtio_blk_queue_is_idle(struct bdev_virtio_blk_queue *queue)
+{
+	return queue->vq->vq_free_cnt == queue->vq->vq_nentries && TAILQ_EMPTY(&queue->pending);
+}
+
+static void bdev_virtio_blk_send_io(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io);
+
+static void
+_bdev_virtio_blk_resubmit(void *ctx)
+{
+	struct spdk_bdev_io *bdev_io = ctx;
+
+	bdev_virtio_blk_send_io(spdk_bdev_io_get_io_channel(bdev_io), bdev_io);
+}
+
+static void
+_bdev_virtio_blk_submit_forwarded(void *ctx)
+{
+	struct spdk_bdev_io *bdev_io = ctx;
+	struct virtio_blk_io_ctx *io_ctx = (struct virtio_blk_io_ctx *)bdev_io->driver_ctx;
+	struct bdev_virtio_blk_queue *queue = io_ctx->queue;
+
+	if (virtio_dev_queue_get_thread(queue->vq->vdev,
+					queue->vq->vq_queue_index) != spdk_get_thread()) {
+		/* The virtqueue changed hands in the meantime. Let the submitter retry. */
+		spdk_thread_send_msg(spdk_bdev_io_get_thread(bdev_io), _bdev_virtio_blk_resubmit, bdev_io);
+		return;
+	}
+
+	bdev_virtio_blk_queue_io(queue, bdev_io);
+}
+
+static void
+bdev_virtio_blk_forward_io(struct bdev_virtio_blk_io_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	struct virtio_blk_io_ctx *io_ctx = (struct virtio_blk_io_ctx *)bdev_io->driver_ctx;
+	struct bdev_virtio_blk_queue *queue = ch->queue;
+	uint16_t queue_idx = queue->vq->vq_queue_index;
+	struct spdk_thread *thread;
+
+	while ((thread = virtio_dev_queue_get_thread(ch->vdev, queue_idx)) == NULL) {
+		if (virtio_dev_acquire_queue(ch->vdev, queue_idx) == 0) {
+			/* The previous owner is gone, take the virtqueue over. */
+			SPDK_DEBUGLOG(SPDK_LOG_VIRTIO_BLK, "%s: taking over queue %"PRIu16"\n",
+				      ch->vdev->name, queue_idx);
+			bdev_virtio_blk_queue_start(queue);
+			ch->owner = true;
+			bdev_virtio_blk_queue_io(queue, bdev_io);
+			return;
+		}
+	}
+
+	if (thread == spdk_get_thread()) {
+		/* The virtqueue is still being drained by a channel previously on this thread. */
+		bdev_virtio_blk_queue_io(queue, bdev_io);
+		return;
+	}
+
+	io_ctx->queue = queue;
+	if (spdk_thread_send_msg(thread, _bdev_virtio_blk_submit_forwarded, bdev_io) != 0) {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+static void
+bdev_virtio_blk_send_io(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	struct bdev_virtio_blk_io_channel *virtio_channel = spdk_io_channel_get_ctx(ch);
+
+	if (spdk_likely(virtio_channel->owner)) {
+		bdev_virtio_blk_queue_io(virtio_channel->queue, bdev_io);
+	} else {
+		bdev_virtio_blk_forward_io(virtio_channel, bdev_io);
+	}
 }
 
 static void
@@ -275,6 +476,7 @@ virtio_blk_dev_unregister_cb(void *io_device)
 	virtio_dev_stop(vdev);
 	virtio_dev_destruct(vdev);
 	spdk_bdev_destruct_done(&bvdev->bdev, 0);
+	free(bvdev->queues);
 	free(bvdev);
 }
 
@@ -350,23 +552,34 @@ bdev_virtio_io_cpl(struct spdk_bdev_io *bdev_io)
 {
 	struct virtio_blk_io_ctx *io_ctx = (struct virtio_blk_io_ctx *)bdev_io->driver_ctx;
 
-	spdk_bdev_io_complete(bdev_io, io_ctx->resp == VIRTIO_BLK_S_OK ?
-			      SPDK_BDEV_IO_STATUS_SUCCESS : SPDK_BDEV_IO_STATUS_FAILED);
+	bdev_virtio_blk_io_complete(bdev_io, io_ctx->resp == VIRTIO_BLK_S_OK ?
+				    SPDK_BDEV_IO_STATUS_SUCCESS : SPDK_BDEV_IO_STATUS_FAILED);
 }
 
 static int
 bdev_virtio_poll(void *arg)
 {
-	struct bdev_virtio_blk_io_channel *ch = arg;
+	struct bdev_virtio_blk_queue *queue = arg;
 	void *io[32];
 	uint32_t io_len[32];
 	uint16_t i, cnt;
 
-	cnt = virtio_recv_pkts(ch->vq, io, io_len, SPDK_COUNTOF(io));
+	/* Publish all requests submitted since the last poll with a single notification. */
+	virtqueue_req_flush(queue->vq);
+
+	cnt = virtio_recv_pkts(queue->vq, io, io_len, SPDK_COUNTOF(io));
 	for (i = 0; i < cnt; ++i) {
 		bdev_virtio_io_cpl(io[i]);
 	}
 
+	if (spdk_unlikely(!TAILQ_EMPTY(&queue->pending))) {
+		bdev_virtio_blk_queue_retry(queue);
+	}
+
+	if (spdk_unlikely(queue->released) && bdev_virtio_blk_queue_is_idle(queue)) {
+		bdev_virtio_blk_queue_stop(queue);
+	}
+
 	return cnt;
 }
 
@@ -376,34 +589,51 @@ bdev_virtio_blk_ch_create_cb(void *io_device, void *ctx_buf)
 	struct virtio_blk_dev *bvdev = io_device;
 	struct virtio_dev *vdev = &bvdev->vdev;
 	struct bdev_virtio_blk_io_channel *ch = ctx_buf;
-	struct virtqueue *vq;
-	int32_t queue_idx;
+	uint16_t queue_idx;
 
-	queue_idx = virtio_dev_find_and_acquire_queue(vdev, 0);
-	if (queue_idx < 0) {
-		SPDK_ERRLOG("Couldn't get an unused queue for the io_channel.\n");
-		return -1;
-	}
+	ch->vdev = vdev;
 
-	vq = vdev->vqs[queue_idx];
+	for (queue_idx = 0; queue_idx < vdev->max_queues; queue_idx++) {
+		if (virtio_dev_acquire_queue(vdev, queue_idx) == 0) {
+			ch->queue = &bvdev->queues[queue_idx];
+			ch->owner = true;
+			bdev_virtio_blk_queue_start(ch->queue);
+			return 0;
+		}
+	}
 
-	ch->vdev = vdev;
-	ch->vq = vq;
+	/* There are more channels than virtqueues. Share one with another thread. */
+	pthread_mutex_lock(&vdev->mutex);
+	queue_idx = bvdev->next_shared_queue;
+	bvdev->next_shared_queue = (queue_idx + 1) % vdev->max_queues;
+	pthread_mutex_unlock(&vdev->mutex);
 
-	ch->poller = spdk_poller_register(bdev_virtio_poll, ch, 0);
+	SPDK_DEBUGLOG(SPDK_LOG_VIRTIO_BLK, "%s: no unused queue, sharing queue %"PRIu16"\n",
+		      vdev->name, queue_idx);
+	ch->queue = &bvdev->queues[queue_idx];
+	ch->owner = false;
 	return 0;
 }
 
 static void
 bdev_virtio_blk_ch_destroy_cb(void *io_device, void *ctx_buf)
 {
-	struct virtio_blk_dev *bvdev = io_device;
-	struct virtio_dev *vdev = &bvdev->vdev;
 	struct bdev_virtio_blk_io_channel *ch = ctx_buf;
-	struct virtqueue *vq = ch->vq;
+	struct bdev_virtio_blk_queue *queue = ch->queue;
 
-	spdk_poller_unregister(&ch->poller);
-	virtio_dev_release_queue(vdev, vq->vq_queue_index);
+	if (!ch->owner) {
+		return;
+	}
+
+	/*
+	 * Requests forwarded by other channels may still be in flight. Keep polling
+	 * the virtqueue until they complete, then release it.
+	 */
+	if (bdev_virtio_blk_queue_is_idle(queue)) {
+		bdev_virtio_blk_queue_stop(queue);
+	} else {
+		queue->released = true;
+	}
 }
 
 static int
@@ -413,7 +643,7 @@ virtio_blk_dev_init(struct virtio_blk_dev *bvdev, uint16_t max_queues)
 	struct spdk_bdev *bdev = &bvdev->bdev;
 	uint64_t capacity, num_blocks;
 	uint32_t block_size;
-	uint16_t host_max_queues;
+	uint16_t host_max_queues, i;
 	int rc;
 
 	if (virtio_dev_has_feature(vdev, VIRTIO_BLK_F_BLK_SIZE)) {
@@ -493,6 +723,18 @@ virtio_blk_dev_init(struct virtio_blk_dev *bvdev, uint16_t max_queues)
 		return rc;
 	}
 
+	bvdev->queues = calloc(vdev->max_queues, sizeof(*bvdev->queues));
+	if (bvdev->queues == NULL) {
+		SPDK_ERRLOG("%s: failed to allocate queue contexts\n", vdev->name);
+		virtio_dev_stop(vdev);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < vdev->max_queues; i++) {
+		bvdev->queues[i].vq = vdev->vqs[i];
+		TAILQ_INIT(&bvdev->queues[i].pending);
+	}
+
 	bdev->product_name = "VirtioBlk Disk";
 	bdev->write_cache = 0;
 	bdev->blocklen = block_size;
@@ -512,6 +754,8 @@ virtio_blk_dev_init(struct virtio_blk_dev *bvdev, uint16_t max_queues)
 		SPDK_ERRLOG("Failed to register bdev name=%s\n", bdev->name);
 		spdk_io_device_unregister(bvdev, NULL);
 		virtio_dev_stop(vdev);
+		free(bvdev->queues);
+		bvdev->queues = NULL;
 		return rc;
 	}
 
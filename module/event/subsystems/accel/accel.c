@@ -38,6 +38,8 @@
 #include "spdk_internal/event.h"
 #include "spdk/env.h"
 
+static struct spdk_subsystem g_spdk_subsystem_accel;
+
 static void
 spdk_accel_engine_subsystem_initialize(void)
 {
@@ -45,7 +47,7 @@ spdk_accel_engine_subsystem_initialize(void)
 
 	rc = spdk_accel_engine_initialize();
 
-	spdk_subsystem_init_next(rc);
+	spdk_subsystem_init_done(&g_spdk_subsystem_accel, rc);
 }
 
 static void
@@ -68,6 +70,7 @@ spdk_accel_engine_subsystem_write_config_json(struct spdk_json_write_ctx *w)
 
 static struct spdk_subsystem g_spdk_subsystem_accel = {
 	.name = "accel",
+	.concurrent_init = true,
 	.init = spdk_accel_engine_subsystem_initialize,
 	.fini = spdk_accel_engine_subsystem_finish,
 	.config = spdk_accel_engine_config_text,
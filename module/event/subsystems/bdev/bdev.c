@@ -40,10 +40,12 @@
 #include "spdk_internal/event.h"
 #include "spdk/env.h"
 
+static struct spdk_subsystem g_spdk_subsystem_bdev;
+
 static void
 spdk_bdev_initialize_complete(void *cb_arg, int rc)
 {
-	spdk_subsystem_init_next(rc);
+	spdk_subsystem_init_done(&g_spdk_subsystem_bdev, rc);
 }
 
 static void
@@ -72,6 +74,7 @@ _spdk_bdev_subsystem_config_json(struct spdk_json_write_ctx *w)
 
 static struct spdk_subsystem g_spdk_subsystem_bdev = {
 	.name = "bdev",
+	.concurrent_init = true,
 	.init = spdk_bdev_subsystem_initialize,
 	.fini = spdk_bdev_subsystem_finish,
 	.config = spdk_bdev_config_text,
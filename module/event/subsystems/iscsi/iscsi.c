@@ -37,10 +37,12 @@
 
 #include "spdk_internal/event.h"
 
+static struct spdk_subsystem g_spdk_subsystem_iscsi;
+
 static void
 spdk_iscsi_subsystem_init_complete(void *cb_arg, int rc)
 {
-	spdk_subsystem_init_next(rc);
+	spdk_subsystem_init_done(&g_spdk_subsystem_iscsi, rc);
 }
 
 static void
@@ -69,6 +71,7 @@ spdk_iscsi_subsystem_config_json(struct spdk_json_write_ctx *w)
 
 static struct spdk_subsystem g_spdk_subsystem_iscsi = {
 	.name = "iscsi",
+	.concurrent_init = true,
 	.init = spdk_iscsi_subsystem_init,
 	.fini = spdk_iscsi_subsystem_fini,
 	.config = spdk_iscsi_config_text,
@@ -77,3 +80,4 @@ static struct spdk_subsystem g_spdk_subsystem_iscsi = {
 
 SPDK_SUBSYSTEM_REGISTER(g_spdk_subsystem_iscsi);
 SPDK_SUBSYSTEM_DEPEND(iscsi, scsi)
+SPDK_SUBSYSTEM_DEPEND(iscsi, net_framework)
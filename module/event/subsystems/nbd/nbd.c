@@ -37,6 +37,8 @@
 
 #include "spdk_internal/event.h"
 
+static struct spdk_subsystem g_spdk_subsystem_nbd;
+
 static void
 spdk_nbd_subsystem_init(void)
 {
@@ -44,7 +46,7 @@ spdk_nbd_subsystem_init(void)
 
 	rc = spdk_nbd_init();
 
-	spdk_subsystem_init_next(rc);
+	spdk_subsystem_init_done(&g_spdk_subsystem_nbd, rc);
 }
 
 static void
@@ -62,6 +64,7 @@ spdk_nbd_subsystem_write_config_json(struct spdk_json_write_ctx *w)
 
 static struct spdk_subsystem g_spdk_subsystem_nbd = {
 	.name = "nbd",
+	.concurrent_init = true,
 	.init = spdk_nbd_subsystem_init,
 	.fini = spdk_nbd_subsystem_fini,
 	.config = NULL,
@@ -37,6 +37,9 @@
 
 #include "spdk_internal/event.h"
 
+static struct spdk_subsystem g_spdk_subsystem_interface;
+static struct spdk_subsystem g_spdk_subsystem_net_framework;
+
 static void
 spdk_interface_subsystem_init(void)
 {
@@ -44,7 +47,7 @@ spdk_interface_subsystem_init(void)
 
 	rc = spdk_interface_init();
 
-	spdk_subsystem_init_next(rc);
+	spdk_subsystem_init_done(&g_spdk_subsystem_interface, rc);
 }
 
 static void
@@ -56,6 +59,7 @@ spdk_interface_subsystem_destroy(void)
 
 static struct spdk_subsystem g_spdk_subsystem_interface = {
 	.name = "interface",
+	.concurrent_init = true,
 	.init = spdk_interface_subsystem_init,
 	.fini = spdk_interface_subsystem_destroy,
 	.config = NULL,
@@ -66,7 +70,7 @@ SPDK_SUBSYSTEM_REGISTER(g_spdk_subsystem_interface);
 static void
 spdk_net_start_complete(void *cb_arg, int rc)
 {
-	spdk_subsystem_init_next(rc);
+	spdk_subsystem_init_done(&g_spdk_subsystem_net_framework, rc);
 }
 
 static void
@@ -89,6 +93,7 @@ spdk_net_subsystem_fini(void)
 
 static struct spdk_subsystem g_spdk_subsystem_net_framework = {
 	.name = "net_framework",
+	.concurrent_init = true,
 	.init = spdk_net_subsystem_start,
 	.fini = spdk_net_subsystem_fini,
 	.config = NULL,
@@ -654,6 +654,11 @@ spdk_nvmf_parse_transport(struct spdk_nvmf_parse_transport_ctx *ctx)
 		if (val >= 0) {
 			opts.sock_priority = val;
 		}
+
+		val = spdk_conf_section_get_intval(ctx->sp, "SockBusyPoll");
+		if (val >= 0) {
+			opts.sock_busy_poll = val;
+		}
 	}
 
 	bval = spdk_conf_section_get_boolval(ctx->sp, "DifInsertOrStrip", false);
@@ -41,6 +41,8 @@
 #include "spdk/nvmf_cmd.h"
 #include "spdk/util.h"
 
+static struct spdk_subsystem g_spdk_subsystem_nvmf;
+
 enum nvmf_tgt_state {
 	NVMF_TGT_INIT_NONE = 0,
 	NVMF_TGT_INIT_PARSE_CONFIG,
@@ -602,7 +604,7 @@ nvmf_tgt_advance_state(void)
 			g_tgt_state = NVMF_TGT_RUNNING;
 			break;
 		case NVMF_TGT_RUNNING:
-			spdk_subsystem_init_next(0);
+			spdk_subsystem_init_done(&g_spdk_subsystem_nvmf, 0);
 			break;
 		case NVMF_TGT_FINI_STOP_SUBSYSTEMS: {
 			struct spdk_nvmf_subsystem *subsystem;
@@ -631,7 +633,7 @@ nvmf_tgt_advance_state(void)
 			spdk_subsystem_fini_next();
 			return;
 		case NVMF_TGT_ERROR:
-			spdk_subsystem_init_next(rc);
+			spdk_subsystem_init_done(&g_spdk_subsystem_nvmf, rc);
 			return;
 		}
 
@@ -682,6 +684,7 @@ spdk_nvmf_subsystem_write_config_json(struct spdk_json_write_ctx *w)
 
 static struct spdk_subsystem g_spdk_subsystem_nvmf = {
 	.name = "nvmf",
+	.concurrent_init = true,
 	.init = spdk_nvmf_subsystem_init,
 	.fini = spdk_nvmf_subsystem_fini,
 	.write_config_json = spdk_nvmf_subsystem_write_config_json,
@@ -689,3 +692,4 @@ static struct spdk_subsystem g_spdk_subsystem_nvmf = {
 
 SPDK_SUBSYSTEM_REGISTER(g_spdk_subsystem_nvmf)
 SPDK_SUBSYSTEM_DEPEND(nvmf, bdev)
+SPDK_SUBSYSTEM_DEPEND(nvmf, net_framework)
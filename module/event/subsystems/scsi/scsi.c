@@ -37,6 +37,8 @@
 
 #include "spdk_internal/event.h"
 
+static struct spdk_subsystem g_spdk_subsystem_scsi;
+
 static void
 spdk_scsi_subsystem_init(void)
 {
@@ -44,7 +46,7 @@ spdk_scsi_subsystem_init(void)
 
 	rc = spdk_scsi_init();
 
-	spdk_subsystem_init_next(rc);
+	spdk_subsystem_init_done(&g_spdk_subsystem_scsi, rc);
 }
 
 static void
@@ -56,6 +58,7 @@ spdk_scsi_subsystem_fini(void)
 
 static struct spdk_subsystem g_spdk_subsystem_scsi = {
 	.name = "scsi",
+	.concurrent_init = true,
 	.init = spdk_scsi_subsystem_init,
 	.fini = spdk_scsi_subsystem_fini,
 	.config = NULL,
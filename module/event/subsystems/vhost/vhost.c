@@ -37,10 +37,12 @@
 
 #include "spdk_internal/event.h"
 
+static struct spdk_subsystem g_spdk_subsystem_vhost;
+
 static void
 spdk_vhost_subsystem_init_done(int rc)
 {
-	spdk_subsystem_init_next(rc);
+	spdk_subsystem_init_done(&g_spdk_subsystem_vhost, rc);
 }
 
 static void
@@ -63,6 +65,7 @@ spdk_vhost_subsystem_fini(void)
 
 static struct spdk_subsystem g_spdk_subsystem_vhost = {
 	.name = "vhost",
+	.concurrent_init = true,
 	.init = spdk_vhost_subsystem_init,
 	.fini = spdk_vhost_subsystem_fini,
 	.config = NULL,
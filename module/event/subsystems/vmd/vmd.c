@@ -41,6 +41,8 @@
 #include "spdk_internal/event.h"
 #include "event_vmd.h"
 
+static struct spdk_subsystem g_spdk_subsystem_vmd;
+
 static struct spdk_poller *g_hotplug_poller;
 static bool g_enabled;
 
@@ -92,7 +94,7 @@ spdk_vmd_subsystem_init(void)
 		}
 	}
 
-	spdk_subsystem_init_next(rc);
+	spdk_subsystem_init_done(&g_spdk_subsystem_vmd, rc);
 }
 
 static void
@@ -123,6 +125,7 @@ spdk_vmd_write_config_json(struct spdk_json_write_ctx *w)
 
 static struct spdk_subsystem g_spdk_subsystem_vmd = {
 	.name = "vmd",
+	.concurrent_init = true,
 	.init = spdk_vmd_subsystem_init,
 	.fini = spdk_vmd_subsystem_fini,
 	.config = NULL,
@@ -52,6 +52,15 @@
 #define SO_SNDBUF_SIZE (2 * 1024 * 1024)
 #define IOV_BATCH_SIZE 64
 
+/*
+ * Size of the per-socket receive pipe. Small reads are served from it, so
+ * a single recv syscall can bring in many PDU headers and small payloads.
+ */
+#define RECV_PIPE_SIZE (64 * 1024)
+
+/* Reads at least this large bypass an empty pipe and go straight to the caller's buffers. */
+#define MIN_DIRECT_RECV_SIZE (16 * 1024)
+
 #if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
 #define SPDK_ZEROCOPY
 #endif
@@ -209,7 +218,7 @@ spdk_posix_sock_alloc_pipe(struct spdk_posix_sock *sock, int sz)
 	}
 
 	/* Round up to next 64 byte multiple */
-	new_buf = calloc(((sz + 1) >> 6) << 6, sizeof(uint8_t));
+	new_buf = calloc(SPDK_ALIGN_CEIL(sz + 1, 64), sizeof(uint8_t));
 	if (!new_buf) {
 		SPDK_ERRLOG("socket recv buf allocation failed\n");
 		return -ENOMEM;
@@ -289,6 +298,17 @@ spdk_posix_sock_set_sendbuf(struct spdk_sock *_sock, int sz)
 	return 0;
 }
 
+static int
+spdk_posix_sock_get_sendbuf(struct spdk_sock *_sock, int *sz)
+{
+	struct spdk_posix_sock *sock = __posix_sock(_sock);
+	socklen_t len = sizeof(*sz);
+
+	assert(sock != NULL);
+
+	return getsockopt(sock->fd, SOL_SOCKET, SO_SNDBUF, sz, &len);
+}
+
 static struct spdk_posix_sock *
 _spdk_posix_sock_alloc(int fd)
 {
@@ -308,8 +328,7 @@ _spdk_posix_sock_alloc(int fd)
 
 #ifndef __aarch64__
 	/* On ARM systems, this buffering does not help. Skip it. */
-	/* The size of the pipe is purely derived from benchmarks. It seems to work well. */
-	rc = spdk_posix_sock_alloc_pipe(sock, 8192);
+	rc = spdk_posix_sock_alloc_pipe(sock, RECV_PIPE_SIZE);
 	if (rc) {
 		SPDK_ERRLOG("unable to allocate sufficient recvbuf\n");
 		free(sock);
@@ -637,7 +656,7 @@ _sock_flush(struct spdk_sock *sock)
 	int retval;
 	struct spdk_sock_request *req;
 	int i;
-	ssize_t rc;
+	ssize_t rc, sent;
 	unsigned int offset;
 	size_t len;
 
@@ -701,6 +720,7 @@ _sock_flush(struct spdk_sock *sock)
 	}
 
 	psock->sendmsg_idx++;
+	sent = rc;
 
 	/* Consume the requests that were actually written */
 	req = TAILQ_FIRST(&sock->queued_reqs);
@@ -720,7 +740,7 @@ _sock_flush(struct spdk_sock *sock)
 			if (len > (size_t)rc) {
 				/* This element was partially sent. */
 				req->internal.offset += rc;
-				return 0;
+				return sent;
 			}
 
 			offset = 0;
@@ -752,7 +772,7 @@ _sock_flush(struct spdk_sock *sock)
 		req = TAILQ_FIRST(&sock->queued_reqs);
 	}
 
-	return 0;
+	return sent;
 }
 
 static int
@@ -822,11 +842,32 @@ _spdk_posix_sock_read(struct spdk_posix_sock *sock)
 	return bytes;
 }
 
+/* Read into an empty pipe, or directly into the user's buffers if they're large enough. */
+static ssize_t
+_spdk_posix_sock_readv_empty_pipe(struct spdk_posix_sock *sock, struct iovec *iov, int iovcnt,
+				  size_t len)
+{
+	ssize_t rc;
+
+	if (len >= MIN_DIRECT_RECV_SIZE) {
+		return readv(sock->fd, iov, iovcnt);
+	}
+
+	rc = _spdk_posix_sock_read(sock);
+	if (rc <= 0) {
+		return rc;
+	}
+
+	return spdk_posix_sock_recv_from_pipe(sock, iov, iovcnt);
+}
+
 static ssize_t
 spdk_posix_sock_readv(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
 {
 	struct spdk_posix_sock *sock = __posix_sock(_sock);
-	int rc, i;
+	struct iovec diov[IOV_BATCH_SIZE];
+	int i, diovcnt;
+	ssize_t rc, copied;
 	size_t len;
 
 	if (sock->recv_pipe == NULL) {
@@ -839,20 +880,36 @@ spdk_posix_sock_readv(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
 	}
 
 	if (spdk_pipe_reader_bytes_available(sock->recv_pipe) == 0) {
-		/* If the user is receiving a sufficiently large amount of data,
-		 * receive directly to their buffers. */
-		if (len >= 1024) {
-			return readv(sock->fd, iov, iovcnt);
-		}
+		return _spdk_posix_sock_readv_empty_pipe(sock, iov, iovcnt, len);
+	}
 
-		/* Otherwise, do a big read into our pipe */
-		rc = _spdk_posix_sock_read(sock);
-		if (rc <= 0) {
-			return rc;
-		}
+	copied = spdk_posix_sock_recv_from_pipe(sock, iov, iovcnt);
+	if (copied < 0 || (size_t)copied == len || iovcnt > IOV_BATCH_SIZE) {
+		return copied;
 	}
 
-	return spdk_posix_sock_recv_from_pipe(sock, iov, iovcnt);
+	/*
+	 * The pipe was drained before the request was satisfied, e.g. it held
+	 * a PDU header and the beginning of its payload. Read the rest right
+	 * away instead of waiting for another poll to find the socket readable.
+	 */
+	memcpy(diov, iov, iovcnt * sizeof(*diov));
+	diovcnt = iovcnt;
+	len -= copied;
+	rc = copied;
+	for (i = 0; i < diovcnt && (size_t)rc >= diov[i].iov_len; i++) {
+		rc -= diov[i].iov_len;
+	}
+	diov[i].iov_base = (uint8_t *)diov[i].iov_base + rc;
+	diov[i].iov_len -= rc;
+
+	rc = _spdk_posix_sock_readv_empty_pipe(sock, &diov[i], diovcnt - i, len);
+	if (rc > 0) {
+		copied += rc;
+	}
+
+	/* Errors and EOF will be reported by the next call. */
+	return copied;
 }
 
 static ssize_t
@@ -898,7 +955,7 @@ spdk_posix_sock_writev_async(struct spdk_sock *sock, struct spdk_sock_request *r
 	/* If there are a sufficient number queued, just flush them out immediately. */
 	if (sock->queued_iovcnt >= IOV_BATCH_SIZE) {
 		rc = _sock_flush(sock);
-		if (rc) {
+		if (rc < 0) {
 			spdk_sock_abort_requests(sock);
 		}
 	}
@@ -937,6 +994,21 @@ spdk_posix_sock_set_priority(struct spdk_sock *_sock, int priority)
 	return rc;
 }
 
+static int
+spdk_posix_sock_set_busy_poll(struct spdk_sock *_sock, int usec)
+{
+#if defined(SO_BUSY_POLL)
+	struct spdk_posix_sock *sock = __posix_sock(_sock);
+
+	assert(sock != NULL);
+
+	return setsockopt(sock->fd, SOL_SOCKET, SO_BUSY_POLL, &usec, sizeof(usec));
+#else
+	errno = ENOTSUP;
+	return -1;
+#endif
+}
+
 static bool
 spdk_posix_sock_is_ipv6(struct spdk_sock *_sock)
 {
@@ -1132,7 +1204,7 @@ spdk_posix_sock_group_impl_poll(struct spdk_sock_group_impl *_group, int max_eve
 	 * group. */
 	TAILQ_FOREACH_SAFE(sock, &_group->socks, link, tmp) {
 		rc = _sock_flush(sock);
-		if (rc) {
+		if (rc < 0) {
 			spdk_sock_abort_requests(sock);
 		}
 	}
@@ -1233,7 +1305,9 @@ static struct spdk_net_impl g_posix_net_impl = {
 	.set_recvlowat	= spdk_posix_sock_set_recvlowat,
 	.set_recvbuf	= spdk_posix_sock_set_recvbuf,
 	.set_sendbuf	= spdk_posix_sock_set_sendbuf,
+	.get_sendbuf	= spdk_posix_sock_get_sendbuf,
 	.set_priority	= spdk_posix_sock_set_priority,
+	.set_busy_poll	= spdk_posix_sock_set_busy_poll,
 	.is_ipv6	= spdk_posix_sock_is_ipv6,
 	.is_ipv4	= spdk_posix_sock_is_ipv4,
 	.is_connected	= spdk_posix_sock_is_connected,
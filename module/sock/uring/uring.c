@@ -54,9 +54,18 @@
 #define SPDK_SOCK_GROUP_QUEUE_DEPTH 4096
 #define IOV_BATCH_SIZE 64
 
+/* Size of the group's fixed file table. Sockets beyond it use their plain fds. */
+#define SPDK_URING_SOCK_MAX_FIXED_FILES 1024
+
+/* Receive buffers the kernel picks from when completing receives of a group. */
+#define SPDK_URING_SOCK_RECV_BUF_COUNT 256
+#define SPDK_URING_SOCK_RECV_BUF_SIZE (32 * 1024)
+#define SPDK_URING_SOCK_RECV_BUF_GROUP 0
+
 enum spdk_sock_task_type {
 	SPDK_SOCK_TASK_POLLIN = 0,
 	SPDK_SOCK_TASK_WRITE,
+	SPDK_SOCK_TASK_RECV,
 };
 
 enum spdk_uring_sock_task_status {
@@ -81,7 +90,30 @@ struct spdk_uring_sock {
 	struct spdk_uring_sock_group_impl	*group;
 	struct spdk_uring_task			write_task;
 	struct spdk_uring_task			pollin_task;
+	struct spdk_uring_task			recv_task;
 	int					outstanding_io;
+
+	/* Index in the group's fixed file table, -1 if the plain fd is used. */
+	int					fixed_idx;
+
+	/* Provided buffer holding received data that wasn't read yet, -1 if none. */
+	int					recv_bid;
+	uint32_t				recv_off;
+	uint32_t				recv_len;
+
+	/* Received data that outlived the group it was received in. */
+	uint8_t					*recv_stash;
+	size_t					stash_off;
+	size_t					stash_len;
+
+	/*
+	 * Data may be left in the kernel - the last receive filled its whole
+	 * buffer or couldn't get one. It has to be read with a syscall before
+	 * another receive is submitted.
+	 */
+	bool					recv_syscall;
+	bool					recv_eof;
+	int					recv_errno;
 };
 
 struct spdk_uring_sock_group_impl {
@@ -90,6 +122,17 @@ struct spdk_uring_sock_group_impl {
 	uint32_t				io_inflight;
 	uint32_t				io_queued;
 	uint32_t				io_avail;
+
+	/* Fixed file table. Free slots are kept on a stack. */
+	bool					fixed_files;
+	int					free_slots[SPDK_URING_SOCK_MAX_FIXED_FILES];
+	int					free_slot_cnt;
+
+	/* Provided receive buffers, NULL if the kernel can't select buffers. */
+	uint8_t					*recv_bufs;
+	/* Buffers consumed by the user, to be given back to the kernel. */
+	uint16_t				bufs_to_return[SPDK_URING_SOCK_RECV_BUF_COUNT];
+	int					bufs_to_return_cnt;
 };
 
 #define SPDK_URING_SOCK_REQUEST_IOV(req) ((struct iovec *)((uint8_t *)req + sizeof(struct spdk_sock_request)))
@@ -242,6 +285,17 @@ spdk_uring_sock_set_sendbuf(struct spdk_sock *_sock, int sz)
 	return 0;
 }
 
+static int
+spdk_uring_sock_get_sendbuf(struct spdk_sock *_sock, int *sz)
+{
+	struct spdk_uring_sock *sock = __uring_sock(_sock);
+	socklen_t len = sizeof(*sz);
+
+	assert(sock != NULL);
+
+	return getsockopt(sock->fd, SOL_SOCKET, SO_SNDBUF, sz, &len);
+}
+
 static struct spdk_uring_sock *
 _spdk_uring_sock_alloc(int fd)
 {
@@ -254,6 +308,8 @@ _spdk_uring_sock_alloc(int fd)
 	}
 
 	sock->fd = fd;
+	sock->fixed_idx = -1;
+	sock->recv_bid = -1;
 
 	return sock;
 }
@@ -469,28 +525,160 @@ spdk_uring_sock_close(struct spdk_sock *_sock)
 
 	assert(TAILQ_EMPTY(&_sock->pending_reqs));
 	assert(sock->group == NULL);
+	assert(sock->recv_bid == -1);
 	rc = close(sock->fd);
 	if (rc == 0) {
+		free(sock->recv_stash);
 		free(sock);
 	}
 
 	return rc;
 }
 
+static inline uint8_t *
+_group_recv_buf(struct spdk_uring_sock_group_impl *group, int bid)
+{
+	return group->recv_bufs + (size_t)bid * SPDK_URING_SOCK_RECV_BUF_SIZE;
+}
+
+static void
+_sock_recv_buf_put(struct spdk_uring_sock *sock)
+{
+	struct spdk_uring_sock_group_impl *group = sock->group;
+
+	assert(sock->recv_bid != -1);
+	assert(group->bufs_to_return_cnt < SPDK_URING_SOCK_RECV_BUF_COUNT);
+	group->bufs_to_return[group->bufs_to_return_cnt++] = sock->recv_bid;
+	sock->recv_bid = -1;
+	sock->recv_off = 0;
+	sock->recv_len = 0;
+}
+
+/* Move received data out of the group's buffer, so the socket can leave the group. */
+static int
+_sock_recv_stash(struct spdk_uring_sock *sock, const uint8_t *data, size_t len)
+{
+	uint8_t *stash;
+
+	if (sock->stash_off > 0) {
+		memmove(sock->recv_stash, sock->recv_stash + sock->stash_off, sock->stash_len);
+		sock->stash_off = 0;
+	}
+
+	stash = realloc(sock->recv_stash, sock->stash_len + len);
+	if (stash == NULL) {
+		SPDK_ERRLOG("Failed to allocate memory for received data\n");
+		return -ENOMEM;
+	}
+
+	memcpy(stash + sock->stash_len, data, len);
+	sock->recv_stash = stash;
+	sock->stash_len += len;
+	return 0;
+}
+
+static inline bool
+_sock_recv_ready(struct spdk_uring_sock *sock)
+{
+	return sock->recv_len > 0 || sock->stash_len > 0 || sock->recv_syscall ||
+	       sock->recv_eof || sock->recv_errno != 0;
+}
+
 static ssize_t
-spdk_uring_sock_recv(struct spdk_sock *_sock, void *buf, size_t len)
+_sock_recv_copy(struct spdk_uring_sock *sock, struct iovec *iov, int iovcnt)
 {
-	struct spdk_uring_sock *sock = __uring_sock(_sock);
+	struct iovec siov;
+	size_t len, copied = 0;
+
+	if (sock->stash_len > 0) {
+		siov.iov_base = sock->recv_stash + sock->stash_off;
+		siov.iov_len = sock->stash_len;
+		copied = spdk_iovcpy(&siov, 1, iov, iovcnt);
+		sock->stash_off += copied;
+		sock->stash_len -= copied;
+		if (sock->stash_len > 0) {
+			return copied;
+		}
+	}
 
-	return recv(sock->fd, buf, len, MSG_DONTWAIT);
+	if (sock->recv_len > 0) {
+		struct iovec diov[IOV_BATCH_SIZE];
+		int diovcnt;
+
+		/* Skip the part of the iovec already filled from the stash. */
+		diovcnt = spdk_min(iovcnt, IOV_BATCH_SIZE);
+		memcpy(diov, iov, diovcnt * sizeof(*diov));
+		len = copied;
+		while (diovcnt > 0 && len >= diov[0].iov_len) {
+			len -= diov[0].iov_len;
+			memmove(diov, diov + 1, --diovcnt * sizeof(*diov));
+		}
+		if (diovcnt > 0) {
+			diov[0].iov_base = (uint8_t *)diov[0].iov_base + len;
+			diov[0].iov_len -= len;
+		}
+
+		siov.iov_base = _group_recv_buf(sock->group, sock->recv_bid) + sock->recv_off;
+		siov.iov_len = sock->recv_len;
+		len = spdk_iovcpy(&siov, 1, diov, diovcnt);
+		sock->recv_off += len;
+		sock->recv_len -= len;
+		copied += len;
+		if (sock->recv_len == 0) {
+			_sock_recv_buf_put(sock);
+		}
+	}
+
+	return copied;
 }
 
 static ssize_t
 spdk_uring_sock_readv(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
 {
 	struct spdk_uring_sock *sock = __uring_sock(_sock);
+	ssize_t rc;
+
+	if (sock->stash_len > 0 || sock->recv_len > 0) {
+		return _sock_recv_copy(sock, iov, iovcnt);
+	}
+
+	if (sock->recv_eof) {
+		return 0;
+	}
 
-	return readv(sock->fd, iov, iovcnt);
+	if (sock->recv_errno != 0) {
+		errno = sock->recv_errno;
+		return -1;
+	}
+
+	/*
+	 * Reading the socket directly while a receive is outstanding would
+	 * reorder the data. Without one, only read it if there's a chance
+	 * the kernel holds anything - the next receive will pick it up otherwise.
+	 */
+	if (sock->recv_task.status != SPDK_URING_SOCK_TASK_NOT_IN_USE ||
+	    (sock->group != NULL && sock->group->recv_bufs != NULL && !sock->recv_syscall)) {
+		errno = EAGAIN;
+		return -1;
+	}
+
+	rc = readv(sock->fd, iov, iovcnt);
+	if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+		sock->recv_syscall = false;
+	}
+
+	return rc;
+}
+
+static ssize_t
+spdk_uring_sock_recv(struct spdk_sock *_sock, void *buf, size_t len)
+{
+	struct iovec iov;
+
+	iov.iov_base = buf;
+	iov.iov_len = len;
+
+	return spdk_uring_sock_readv(_sock, &iov, 1);
 }
 
 static ssize_t
@@ -612,6 +800,16 @@ spdk_sock_complete_reqs(struct spdk_sock *_sock, ssize_t rc)
 	return 0;
 }
 
+/* Point the SQE at the socket, through the fixed file table if it's registered there. */
+static inline void
+_sock_prep_fd(struct spdk_uring_sock *sock, struct io_uring_sqe *sqe)
+{
+	if (sock->fixed_idx >= 0) {
+		sqe->fd = sock->fixed_idx;
+		sqe->flags |= IOSQE_FIXED_FILE;
+	}
+}
+
 static void
 _sock_flush(struct spdk_sock *_sock)
 {
@@ -638,6 +836,7 @@ _sock_flush(struct spdk_sock *_sock)
 
 	sqe = io_uring_get_sqe(&sock->group->uring);
 	io_uring_prep_sendmsg(sqe, sock->fd, &sock->write_task.msg, 0);
+	_sock_prep_fd(sock, sqe);
 	io_uring_sqe_set_data(sqe, task);
 	task->status = SPDK_URING_SOCK_TASK_IN_PROCESS;
 }
@@ -658,18 +857,115 @@ _sock_prep_pollin(struct spdk_sock *_sock)
 
 	sqe = io_uring_get_sqe(&sock->group->uring);
 	io_uring_prep_poll_add(sqe, sock->fd, POLLIN);
+	_sock_prep_fd(sock, sqe);
 	io_uring_sqe_set_data(sqe, task);
 	task->status = SPDK_URING_SOCK_TASK_IN_PROCESS;
 }
 
+/*
+ * Receive into a buffer selected by the kernel from the group's pool. The data
+ * is then served by readv() straight from that buffer, without a syscall.
+ */
+static void
+_sock_prep_recv(struct spdk_sock *_sock)
+{
+	struct spdk_uring_sock *sock = __uring_sock(_sock);
+	struct spdk_uring_task *task = &sock->recv_task;
+	struct io_uring_sqe *sqe;
+
+	if (task->status == SPDK_URING_SOCK_TASK_IN_PROCESS || _sock_recv_ready(sock)) {
+		return;
+	}
+
+	assert(sock->group != NULL);
+	sock->group->io_queued++;
+
+	sqe = io_uring_get_sqe(&sock->group->uring);
+	io_uring_prep_recv(sqe, sock->fd, NULL, SPDK_URING_SOCK_RECV_BUF_SIZE, 0);
+	_sock_prep_fd(sock, sqe);
+	sqe->flags |= IOSQE_BUFFER_SELECT;
+	sqe->buf_group = SPDK_URING_SOCK_RECV_BUF_GROUP;
+	io_uring_sqe_set_data(sqe, task);
+	task->status = SPDK_URING_SOCK_TASK_IN_PROCESS;
+}
+
+static void
+_group_prep_provide_bufs(struct spdk_uring_sock_group_impl *group)
+{
+	struct io_uring_sqe *sqe;
+	int i, bid;
+
+	for (i = 0; i < group->bufs_to_return_cnt; i++) {
+		bid = group->bufs_to_return[i];
+		sqe = io_uring_get_sqe(&group->uring);
+		io_uring_prep_provide_buffers(sqe, _group_recv_buf(group, bid),
+					      SPDK_URING_SOCK_RECV_BUF_SIZE, 1,
+					      SPDK_URING_SOCK_RECV_BUF_GROUP, bid);
+		io_uring_sqe_set_data(sqe, NULL);
+	}
+
+	group->io_queued += group->bufs_to_return_cnt;
+	group->bufs_to_return_cnt = 0;
+}
+
+/* Handle the completion of a task of a socket that was removed from the group meanwhile. */
+static void
+_sock_removed_task_done(struct spdk_uring_sock *sock)
+{
+	if (--sock->outstanding_io == 0) {
+		sock->group = NULL;
+		/* Just for sock close case */
+		if (sock->base.flags.closed) {
+			spdk_uring_sock_close(&sock->base);
+		}
+	}
+}
+
+static void
+_sock_recv_done(struct spdk_uring_sock *sock, int status, uint32_t cqe_flags)
+{
+	struct spdk_uring_sock_group_impl *group = sock->group;
+	int bid;
+
+	if (status > 0) {
+		assert(cqe_flags & IORING_CQE_F_BUFFER);
+		bid = cqe_flags >> IORING_CQE_BUFFER_SHIFT;
+		assert(sock->recv_bid == -1);
+		sock->recv_bid = bid;
+		sock->recv_off = 0;
+		sock->recv_len = status;
+		sock->recv_syscall = (status == SPDK_URING_SOCK_RECV_BUF_SIZE);
+	} else if (status == 0) {
+		sock->recv_eof = true;
+	} else if (status == -ENOBUFS) {
+		sock->recv_syscall = true;
+	} else if (status != -EAGAIN && status != -EWOULDBLOCK && status != -EINTR) {
+		sock->recv_errno = -status;
+	}
+
+	if (spdk_unlikely(sock->outstanding_io > 0)) {
+		/* The socket isn't in the group anymore - keep the data on the side. */
+		if (sock->recv_len > 0) {
+			if (_sock_recv_stash(sock, _group_recv_buf(group, sock->recv_bid) + sock->recv_off,
+					     sock->recv_len) != 0) {
+				sock->recv_errno = ENOMEM;
+			}
+			_sock_recv_buf_put(sock);
+		}
+		_sock_removed_task_done(sock);
+	}
+}
+
 static int
 spdk_sock_uring_group_reap(struct io_uring *ring, int max,
 			   struct spdk_sock **socks)
 {
 	int i, count, ret;
 	struct io_uring_cqe *cqe;
+	struct spdk_uring_sock_group_impl *group;
 	struct spdk_uring_sock *sock;
 	struct spdk_uring_task *task;
+	uint32_t cqe_flags;
 	int status;
 
 	count = 0;
@@ -684,17 +980,35 @@ spdk_sock_uring_group_reap(struct io_uring *ring, int max,
 		}
 
 		task = (struct spdk_uring_task *)cqe->user_data;
-		assert(task != NULL);
+		status = cqe->res;
+		if (task == NULL) {
+			/* Receive buffers were given back to the kernel. */
+			group = SPDK_CONTAINEROF(ring, struct spdk_uring_sock_group_impl, uring);
+			group->io_inflight--;
+			group->io_avail++;
+			if (spdk_unlikely(status < 0)) {
+				SPDK_ERRLOG("Failed to provide a receive buffer (%d)\n", status);
+			}
+			io_uring_cqe_seen(ring, cqe);
+			continue;
+		}
+
 		sock = task->sock;
 		assert(sock != NULL);
 		assert(sock->group != NULL);
 		sock->group->io_inflight--;
 		sock->group->io_avail++;
-		status = cqe->res;
+		cqe_flags = cqe->flags;
 		io_uring_cqe_seen(ring, cqe);
 
 		task->status = SPDK_URING_SOCK_TASK_NOT_IN_USE;
 
+		if (task->type == SPDK_SOCK_TASK_RECV) {
+			/* Readable sockets are reported by the group poll. */
+			_sock_recv_done(sock, status, cqe_flags);
+			continue;
+		}
+
 		if (spdk_unlikely(status <= 0)) {
 			if (status == -EAGAIN || status == -EWOULDBLOCK) {
 				continue;
@@ -703,6 +1017,11 @@ spdk_sock_uring_group_reap(struct io_uring *ring, int max,
 
 		switch (task->type) {
 		case SPDK_SOCK_TASK_POLLIN:
+			if (spdk_unlikely(sock->outstanding_io > 0)) {
+				_sock_removed_task_done(sock);
+				break;
+			}
+
 			if ((status & POLLIN) == POLLIN) {
 				if ((socks != NULL) && (sock->base.cb_fn != NULL)) {
 					socks[count] = &sock->base;
@@ -721,13 +1040,7 @@ spdk_sock_uring_group_reap(struct io_uring *ring, int max,
 			/* For socket is removed from the group but having outstanding I/O */
 			if (spdk_unlikely(task->sock->outstanding_io > 0 &&
 					  TAILQ_EMPTY(&sock->base.pending_reqs))) {
-				if (--sock->outstanding_io == 0) {
-					sock->group = NULL;
-					/* Just for sock close case */
-					if (sock->base.flags.closed) {
-						spdk_uring_sock_close(&sock->base);
-					}
-				}
+				_sock_removed_task_done(sock);
 			}
 
 			break;
@@ -772,7 +1085,7 @@ _sock_flush_client(struct spdk_sock *_sock)
 
 	spdk_sock_complete_reqs(_sock, rc);
 
-	return 0;
+	return rc;
 }
 
 static void
@@ -786,7 +1099,7 @@ spdk_uring_sock_writev_async(struct spdk_sock *_sock, struct spdk_sock_request *
 	if (!sock->group) {
 		if (_sock->queued_iovcnt >= IOV_BATCH_SIZE) {
 			rc = _sock_flush_client(_sock);
-			if (rc) {
+			if (rc < 0) {
 				spdk_sock_abort_requests(_sock);
 			}
 		}
@@ -826,6 +1139,21 @@ spdk_uring_sock_set_priority(struct spdk_sock *_sock, int priority)
 	return rc;
 }
 
+static int
+spdk_uring_sock_set_busy_poll(struct spdk_sock *_sock, int usec)
+{
+#if defined(SO_BUSY_POLL)
+	struct spdk_uring_sock *sock = __uring_sock(_sock);
+
+	assert(sock != NULL);
+
+	return setsockopt(sock->fd, SOL_SOCKET, SO_BUSY_POLL, &usec, sizeof(usec));
+#else
+	errno = ENOTSUP;
+	return -1;
+#endif
+}
+
 static bool
 spdk_uring_sock_is_ipv6(struct spdk_sock *_sock)
 {
@@ -909,6 +1237,77 @@ spdk_uring_sock_get_placement_id(struct spdk_sock *_sock, int *placement_id)
 	return rc;
 }
 
+static void
+_group_init_fixed_files(struct spdk_uring_sock_group_impl *group)
+{
+	int fds[SPDK_URING_SOCK_MAX_FIXED_FILES];
+	int i, rc;
+
+	for (i = 0; i < SPDK_URING_SOCK_MAX_FIXED_FILES; i++) {
+		fds[i] = -1;
+		group->free_slots[i] = SPDK_URING_SOCK_MAX_FIXED_FILES - 1 - i;
+	}
+
+	/* Register an empty table, sockets get their slots once added to the group. */
+	rc = io_uring_register_files(&group->uring, fds, SPDK_URING_SOCK_MAX_FIXED_FILES);
+	if (rc < 0) {
+		SPDK_NOTICELOG("Fixed files are not supported (%d), using plain fds\n", rc);
+		return;
+	}
+
+	group->fixed_files = true;
+	group->free_slot_cnt = SPDK_URING_SOCK_MAX_FIXED_FILES;
+}
+
+static void
+_group_init_recv_bufs(struct spdk_uring_sock_group_impl *group)
+{
+	struct io_uring_probe *probe;
+	struct io_uring_sqe *sqe;
+	struct io_uring_cqe *cqe;
+	bool supported;
+	int rc;
+
+	probe = io_uring_get_probe_ring(&group->uring);
+	supported = probe != NULL &&
+		    io_uring_opcode_supported(probe, IORING_OP_PROVIDE_BUFFERS) &&
+		    io_uring_opcode_supported(probe, IORING_OP_RECV);
+	io_uring_free_probe(probe);
+	if (!supported) {
+		SPDK_NOTICELOG("Provided buffers are not supported, polling sockets instead\n");
+		return;
+	}
+
+	rc = posix_memalign((void **)&group->recv_bufs, 0x1000,
+			    (size_t)SPDK_URING_SOCK_RECV_BUF_COUNT * SPDK_URING_SOCK_RECV_BUF_SIZE);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to allocate receive buffers\n");
+		group->recv_bufs = NULL;
+		return;
+	}
+
+	sqe = io_uring_get_sqe(&group->uring);
+	io_uring_prep_provide_buffers(sqe, group->recv_bufs, SPDK_URING_SOCK_RECV_BUF_SIZE,
+				      SPDK_URING_SOCK_RECV_BUF_COUNT,
+				      SPDK_URING_SOCK_RECV_BUF_GROUP, 0);
+	io_uring_sqe_set_data(sqe, NULL);
+
+	rc = io_uring_submit_and_wait(&group->uring, 1);
+	if (rc >= 0) {
+		rc = io_uring_wait_cqe(&group->uring, &cqe);
+	}
+	if (rc >= 0) {
+		rc = cqe->res;
+		io_uring_cqe_seen(&group->uring, cqe);
+	}
+
+	if (rc < 0) {
+		SPDK_ERRLOG("Failed to provide receive buffers (%d)\n", rc);
+		free(group->recv_bufs);
+		group->recv_bufs = NULL;
+	}
+}
+
 static struct spdk_sock_group_impl *
 spdk_uring_sock_group_impl_create(void)
 {
@@ -928,6 +1327,9 @@ spdk_uring_sock_group_impl_create(void)
 		return NULL;
 	}
 
+	_group_init_fixed_files(group_impl);
+	_group_init_recv_bufs(group_impl);
+
 	return &group_impl->base;
 }
 
@@ -937,6 +1339,7 @@ spdk_uring_sock_group_impl_add_sock(struct spdk_sock_group_impl *_group,
 {
 	struct spdk_uring_sock *sock = __uring_sock(_sock);
 	struct spdk_uring_sock_group_impl *group = __uring_group_impl(_group);
+	int slot;
 
 	sock->group = group;
 	sock->write_task.sock = sock;
@@ -945,6 +1348,17 @@ spdk_uring_sock_group_impl_add_sock(struct spdk_sock_group_impl *_group,
 	sock->pollin_task.sock = sock;
 	sock->pollin_task.type = SPDK_SOCK_TASK_POLLIN;
 
+	sock->recv_task.sock = sock;
+	sock->recv_task.type = SPDK_SOCK_TASK_RECV;
+
+	if (group->fixed_files && group->free_slot_cnt > 0) {
+		slot = group->free_slots[group->free_slot_cnt - 1];
+		if (io_uring_register_files_update(&group->uring, slot, &sock->fd, 1) == 1) {
+			group->free_slot_cnt--;
+			sock->fixed_idx = slot;
+		}
+	}
+
 	return 0;
 }
 
@@ -953,6 +1367,8 @@ spdk_uring_sock_group_impl_remove_sock(struct spdk_sock_group_impl *_group,
 				       struct spdk_sock *_sock)
 {
 	struct spdk_uring_sock *sock = __uring_sock(_sock);
+	struct spdk_uring_sock_group_impl *group = __uring_group_impl(_group);
+	int fd = -1;
 
 	if (sock->write_task.status != SPDK_URING_SOCK_TASK_NOT_IN_USE) {
 		sock->outstanding_io++;
@@ -962,6 +1378,26 @@ spdk_uring_sock_group_impl_remove_sock(struct spdk_sock_group_impl *_group,
 		sock->outstanding_io++;
 	}
 
+	if (sock->recv_task.status != SPDK_URING_SOCK_TASK_NOT_IN_USE) {
+		sock->outstanding_io++;
+	}
+
+	/* The group's receive buffer can't be kept, copy the data that wasn't read yet. */
+	if (sock->recv_bid != -1) {
+		if (_sock_recv_stash(sock, _group_recv_buf(group, sock->recv_bid) + sock->recv_off,
+				     sock->recv_len) != 0) {
+			sock->recv_errno = ENOMEM;
+		}
+		_sock_recv_buf_put(sock);
+	}
+
+	/* Requests already submitted hold their own reference to the file. */
+	if (sock->fixed_idx >= 0) {
+		io_uring_register_files_update(&group->uring, sock->fixed_idx, &fd, 1);
+		group->free_slots[group->free_slot_cnt++] = sock->fixed_idx;
+		sock->fixed_idx = -1;
+	}
+
 	if (!sock->outstanding_io) {
 		sock->group = NULL;
 	}
@@ -980,7 +1416,15 @@ spdk_uring_sock_group_impl_poll(struct spdk_sock_group_impl *_group, int max_eve
 
 	TAILQ_FOREACH_SAFE(_sock, &group->base.socks, link, tmp) {
 		_sock_flush(_sock);
-		_sock_prep_pollin(_sock);
+		if (group->recv_bufs != NULL) {
+			_sock_prep_recv(_sock);
+		} else {
+			_sock_prep_pollin(_sock);
+		}
+	}
+
+	if (group->bufs_to_return_cnt > 0) {
+		_group_prep_provide_bufs(group);
 	}
 
 	to_submit = group->io_queued;
@@ -1001,8 +1445,25 @@ spdk_uring_sock_group_impl_poll(struct spdk_sock_group_impl *_group, int max_eve
 	count = 0;
 	to_complete = group->io_inflight;
 	if (to_complete > 0) {
-		to_complete = spdk_min(to_complete, max_events);
-		count = spdk_sock_uring_group_reap(&group->uring, to_complete, socks);
+		if (group->recv_bufs != NULL) {
+			/* Receive completions don't produce events, so reap all that's there. */
+			count = spdk_sock_uring_group_reap(&group->uring, to_complete, socks);
+		} else {
+			to_complete = spdk_min(to_complete, max_events);
+			count = spdk_sock_uring_group_reap(&group->uring, to_complete, socks);
+		}
+	}
+
+	/* Report sockets with received data, the same way a level-triggered poll would. */
+	if (group->recv_bufs != NULL && socks != NULL) {
+		TAILQ_FOREACH(_sock, &group->base.socks, link) {
+			if (count == max_events) {
+				break;
+			}
+			if (_sock_recv_ready(__uring_sock(_sock)) && _sock->cb_fn != NULL) {
+				socks[count++] = _sock;
+			}
+		}
 	}
 
 	return count;
@@ -1023,6 +1484,7 @@ spdk_uring_sock_group_impl_close(struct spdk_sock_group_impl *_group)
 	close(group->uring.ring_fd);
 	io_uring_queue_exit(&group->uring);
 
+	free(group->recv_bufs);
 	free(group);
 	return 0;
 }
@@ -1030,6 +1492,16 @@ spdk_uring_sock_group_impl_close(struct spdk_sock_group_impl *_group)
 static int
 spdk_uring_sock_flush(struct spdk_sock *_sock)
 {
+	struct spdk_uring_sock *sock = __uring_sock(_sock);
+
+	/* Sockets in a group are written through the group's io_uring. A sendmsg
+	 * here would race with the write task, which may already be in flight
+	 * with the same requests, so leave the data to the next group poll.
+	 */
+	if (sock->group) {
+		return 0;
+	}
+
 	return _sock_flush_client(_sock);
 }
 
@@ -1048,7 +1520,9 @@ static struct spdk_net_impl g_uring_net_impl = {
 	.set_recvlowat	= spdk_uring_sock_set_recvlowat,
 	.set_recvbuf	= spdk_uring_sock_set_recvbuf,
 	.set_sendbuf	= spdk_uring_sock_set_sendbuf,
+	.get_sendbuf	= spdk_uring_sock_get_sendbuf,
 	.set_priority	= spdk_uring_sock_set_priority,
+	.set_busy_poll	= spdk_uring_sock_set_busy_poll,
 	.is_ipv6	= spdk_uring_sock_is_ipv6,
 	.is_ipv4	= spdk_uring_sock_is_ipv4,
 	.is_connected   = spdk_uring_sock_is_connected,
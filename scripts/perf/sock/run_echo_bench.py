@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+
+# This script compares socket implementations (posix and uring by default) by
+# running the hello_sock example as an echo server and driving it with echo
+# traffic from a number of client connections.
+# Prework: Build SPDK with --with-uring to compare against the uring implementation.
+# Output: Echoed MiB/s and messages/s per implementation and, if `perf` is
+#         available, the number of syscalls made by the server per message.
+
+import argparse
+import os
+import shutil
+import socket
+import subprocess
+import sys
+import threading
+import time
+
+rootdir = os.path.abspath(os.path.join(os.path.dirname(__file__), "../../.."))
+hello_sock = os.path.join(rootdir, "examples/sock/hello_world/hello_sock")
+
+
+def wait_for_listener(addr, port, timeout=10):
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        try:
+            with socket.create_connection((addr, port), timeout=1):
+                return True
+        except OSError:
+            time.sleep(0.2)
+    return False
+
+
+def run_client(addr, port, msg_size, queue_depth, stop, results, idx):
+    msg = b"x" * msg_size
+    echoed = 0
+    with socket.create_connection((addr, port)) as s:
+        s.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        # Keep queue_depth messages in flight
+        for _ in range(queue_depth):
+            s.sendall(msg)
+        pending = 0
+        while not stop.is_set():
+            data = s.recv(msg_size * queue_depth)
+            if not data:
+                break
+            echoed += len(data)
+            pending += len(data)
+            while pending >= msg_size:
+                s.sendall(msg)
+                pending -= msg_size
+    results[idx] = echoed
+
+
+def count_syscalls(pid, run_time):
+    if shutil.which("perf") is None:
+        return None
+    cmd = ["perf", "stat", "-x,", "-e", "raw_syscalls:sys_enter", "-p", str(pid),
+           "--", "sleep", str(run_time)]
+    out = subprocess.run(cmd, stderr=subprocess.PIPE, stdout=subprocess.DEVNULL,
+                         universal_newlines=True).stderr
+    for line in out.splitlines():
+        fields = line.split(",")
+        if len(fields) > 2 and "raw_syscalls:sys_enter" in fields[2]:
+            try:
+                return int(fields[0])
+            except ValueError:
+                return None
+    return None
+
+
+def run_bench(impl, args):
+    server = subprocess.Popen([hello_sock, "-S", "-H", args.addr, "-P", str(args.port),
+                               "-N", impl, "-m", args.cpumask],
+                              stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    try:
+        if not wait_for_listener(args.addr, args.port):
+            print("{}: server did not start listening".format(impl))
+            return None
+
+        stop = threading.Event()
+        results = [0] * args.connections
+        clients = [threading.Thread(target=run_client,
+                                    args=(args.addr, args.port, args.msg_size, args.queue_depth,
+                                          stop, results, i))
+                   for i in range(args.connections)]
+        for c in clients:
+            c.start()
+
+        # Let the connections ramp up before measuring
+        time.sleep(1)
+        start_bytes = sum(results)
+        start = time.time()
+        syscalls = count_syscalls(server.pid, args.run_time)
+        if syscalls is None:
+            time.sleep(args.run_time)
+        elapsed = time.time() - start
+
+        stop.set()
+        for c in clients:
+            c.join()
+
+        echoed = sum(results) - start_bytes
+        msgs = echoed / args.msg_size
+        return {"mibps": echoed / elapsed / (1024 * 1024),
+                "msgps": msgs / elapsed,
+                "syscalls_per_msg": syscalls / msgs if syscalls is not None and msgs else None}
+    finally:
+        server.terminate()
+        server.wait()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare SPDK socket implementations with echo traffic")
+    parser.add_argument("-i", "--impls", default="posix,uring",
+                        help="Comma separated list of socket implementations to compare")
+    parser.add_argument("-a", "--addr", default="127.0.0.1", help="Address to listen on")
+    parser.add_argument("-p", "--port", type=int, default=3260, help="Port to listen on")
+    parser.add_argument("-m", "--cpumask", default="0x1", help="CPU mask of the echo server")
+    parser.add_argument("-c", "--connections", type=int, default=8, help="Number of client connections")
+    parser.add_argument("-q", "--queue-depth", type=int, default=4,
+                        help="Messages in flight per connection")
+    parser.add_argument("-s", "--msg-size", type=int, default=512,
+                        help="Message size in bytes (hello_sock echoes up to 1024 bytes at once)")
+    parser.add_argument("-t", "--run-time", type=int, default=10, help="Run time of each test in seconds")
+    args = parser.parse_args()
+
+    if not os.path.exists(hello_sock):
+        print("{} not found, build SPDK examples first".format(hello_sock))
+        sys.exit(1)
+
+    for impl in args.impls.split(","):
+        res = run_bench(impl, args)
+        if res is None:
+            continue
+        line = "{:8s} {:10.2f} MiB/s {:12.0f} msg/s".format(impl, res["mibps"], res["msgps"])
+        if res["syscalls_per_msg"] is not None:
+            line += " {:8.3f} syscalls/msg".format(res["syscalls_per_msg"])
+        print(line)
+
+
+if __name__ == "__main__":
+    main()
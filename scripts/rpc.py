@@ -61,6 +61,13 @@ if __name__ == "__main__":
                               help='Block until subsystems have been initialized')
     p.set_defaults(func=framework_wait_init)
 
+    def framework_get_startup_timeline(args):
+        print_dict(rpc.framework_get_startup_timeline(args.client))
+
+    p = subparsers.add_parser('framework_get_startup_timeline',
+                              help='Get the duration of each step of the application startup')
+    p.set_defaults(func=framework_get_startup_timeline)
+
     def rpc_get_methods(args):
         print_dict(rpc.rpc_get_methods(args.client,
                                        current=args.current,
@@ -165,12 +172,18 @@ if __name__ == "__main__":
     def bdev_compress_create(args):
         print_json(rpc.bdev.bdev_compress_create(args.client,
                                                  base_bdev_name=args.base_bdev_name,
-                                                 pm_path=args.pm_path))
+                                                 pm_path=args.pm_path,
+                                                 pmd=args.pmd,
+                                                 sw_level=args.sw_level))
 
     p = subparsers.add_parser('bdev_compress_create', aliases=['construct_compress_bdev'],
                               help='Add a compress vbdev')
     p.add_argument('-b', '--base_bdev_name', help="Name of the base bdev")
     p.add_argument('-p', '--pm_path', help="Path to persistent memory")
+    p.add_argument('-d', '--pmd', type=int, help="""Compression backend of this bdev, same values as
+    compress_set_pmd (default: the one set by compress_set_pmd)""")
+    p.add_argument('-l', '--sw_level', type=int, help="""Compression level of the software backend,
+    0 (fastest) to 3 (best ratio), default 1""")
     p.set_defaults(func=bdev_compress_create)
 
     def bdev_compress_delete(args):
@@ -187,9 +200,17 @@ if __name__ == "__main__":
                                   pmd=args.pmd)
     p = subparsers.add_parser('compress_set_pmd', aliases=['set_compress_pmd'],
                               help='Set pmd option for a compress disk')
-    p.add_argument('-p', '--pmd', type=int, help='0 = auto-select, 1= QAT only, 2 = ISAL only')
+    p.add_argument('-p', '--pmd', type=int, help='0 = auto-select, 1= QAT only, 2 = ISAL only, 3 = software only')
     p.set_defaults(func=compress_set_pmd)
 
+    def compress_set_chunk_cache_size(args):
+        rpc.bdev.compress_set_chunk_cache_size(args.client,
+                                               size=args.size)
+    p = subparsers.add_parser('compress_set_chunk_cache_size',
+                              help='Set the decompressed chunk cache size of compress disks created or loaded afterwards')
+    p.add_argument('-s', '--size', type=int, required=True, help='Cache size in bytes per compress disk, 0 = disabled')
+    p.set_defaults(func=compress_set_chunk_cache_size)
+
     def bdev_compress_get_orphans(args):
         print_dict(rpc.bdev.bdev_compress_get_orphans(args.client,
                                                       name=args.name))
@@ -205,15 +226,18 @@ if __name__ == "__main__":
                                                crypto_pmd=args.crypto_pmd,
                                                key=args.key,
                                                cipher=args.cipher,
-                                               key2=args.key2))
+                                               key2=args.key2,
+                                               data_unit_size=args.data_unit_size))
     p = subparsers.add_parser('bdev_crypto_create', aliases=['construct_crypto_bdev'],
                               help='Add a crypto vbdev')
     p.add_argument('base_bdev_name', help="Name of the base bdev")
     p.add_argument('name', help="Name of the crypto vbdev")
     p.add_argument('crypto_pmd', help="Name of the crypto device driver")
     p.add_argument('key', help="Key")
-    p.add_argument('-c', '--cipher', help="cipher to use, AES_CBC or AES_XTS (QAT only)", default="AES_CBC")
+    p.add_argument('-c', '--cipher', help="cipher to use, AES_CBC or AES_XTS (QAT and crypto_sw only)", default="AES_CBC")
     p.add_argument('-k2', '--key2', help="2nd key for cipher AET_XTS", default=None)
+    p.add_argument('-d', '--data-unit-size', help="""bytes encrypted with one IV/tweak, becomes the block size
+    of the crypto vbdev (crypto_sw only, default: block size of the base bdev)""", type=int)
     p.set_defaults(func=bdev_crypto_create)
 
     def bdev_crypto_delete(args):
@@ -256,6 +280,14 @@ if __name__ == "__main__":
     p.add_argument('name', help='Name of OCF bdev')
     p.set_defaults(func=bdev_ocf_get_stats)
 
+    def bdev_ocf_get_queue_stats(args):
+        print_dict(rpc.bdev.bdev_ocf_get_queue_stats(args.client,
+                                                     name=args.name))
+    p = subparsers.add_parser('bdev_ocf_get_queue_stats',
+                              help='Get per-thread queue statistics of chosen OCF block device')
+    p.add_argument('name', help='Name of OCF bdev')
+    p.set_defaults(func=bdev_ocf_get_queue_stats)
+
     def bdev_ocf_get_bdevs(args):
         print_dict(rpc.bdev.bdev_ocf_get_bdevs(args.client,
                                                name=args.name))
@@ -679,11 +711,18 @@ if __name__ == "__main__":
 
     def bdev_get_bdevs(args):
         print_dict(rpc.bdev.bdev_get_bdevs(args.client,
-                                           name=args.name))
+                                           name=args.name,
+                                           product_name=args.product_name,
+                                           offset=args.offset,
+                                           count=args.count))
 
     p = subparsers.add_parser('bdev_get_bdevs', aliases=['get_bdevs'],
                               help='Display current blockdev list or required blockdev')
     p.add_argument('-b', '--name', help="Name of the Blockdev. Example: Nvme0n1", required=False)
+    p.add_argument('-p', '--product_name', help="Only list blockdevs with this product name. Example: 'NVMe disk'",
+                   required=False)
+    p.add_argument('-o', '--offset', help='Number of matching blockdevs to skip', type=int, required=False)
+    p.add_argument('-c', '--count', help='Maximum number of blockdevs to list', type=int, required=False)
     p.set_defaults(func=bdev_get_bdevs)
 
     def bdev_get_iostat(args):
@@ -1559,7 +1598,10 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                                             allow_open_bands=args.allow_open_bands,
                                             overprovisioning=args.overprovisioning,
                                             l2p_path=args.l2p_path,
+                                            l2p_dram_limit=args.l2p_dram_limit,
+                                            l2p_bdev=args.l2p_bdev,
                                             use_append=args.use_append,
+                                            hot_cold_separation=args.hot_cold_separation,
                                             **arg_limits))
 
     p = subparsers.add_parser('bdev_ftl_create', aliases=['construct_ftl_bdev'], help='Add FTL bdev')
@@ -1575,7 +1617,13 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                    ' to user (optional)', type=int)
     p.add_argument('--l2p_path', help='Path to persistent memory file or device to store l2p onto, '
                                       'by default l2p is kept in DRAM and is volatile (optional)')
+    p.add_argument('--l2p_dram_limit', help='Maximum amount of DRAM (in bytes) used by the l2p. When set, '
+                   'the l2p is paged in and out of l2p_bdev on demand (optional)', type=int)
+    p.add_argument('--l2p_bdev', help='Name of the bdev used to store the l2p when l2p_dram_limit is set '
+                   '(optional)')
     p.add_argument('--use_append', help='Use appends instead of writes', action='store_true')
+    p.add_argument('--hot_cold_separation', help='Write frequently updated, rarely updated and relocated'
+                   ' data to separate bands', action='store_true')
 
     limits = p.add_argument_group('Defrag limits', 'Configures defrag limits and thresholds for'
                                   ' levels ' + str(ftl_valid_limits)[1:-1])
@@ -1604,12 +1652,15 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     def nbd_start_disk(args):
         print(rpc.nbd.nbd_start_disk(args.client,
                                      bdev_name=args.bdev_name,
-                                     nbd_device=args.nbd_device))
+                                     nbd_device=args.nbd_device,
+                                     num_connections=args.num_connections))
 
     p = subparsers.add_parser('nbd_start_disk', aliases=['start_nbd_disk'],
                               help='Export a bdev as an nbd disk')
     p.add_argument('bdev_name', help='Blockdev name to be exported. Example: Malloc0.')
     p.add_argument('nbd_device', help='Nbd device name to be assigned. Example: /dev/nbd0.', nargs='?')
+    p.add_argument('-c', '--num-connections', help='Number of socket connections to the kernel, each polled on a separate core. Default: 1.',
+                   type=int)
     p.set_defaults(func=nbd_start_disk)
 
     def nbd_stop_disk(args):
@@ -1699,7 +1750,8 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                                        no_srq=args.no_srq,
                                        c2h_success=args.c2h_success,
                                        dif_insert_or_strip=args.dif_insert_or_strip,
-                                       sock_priority=args.sock_priority)
+                                       sock_priority=args.sock_priority,
+                                       sock_busy_poll=args.sock_busy_poll)
 
     p = subparsers.add_parser('nvmf_create_transport', help='Create NVMf transport')
     p.add_argument('-t', '--trtype', help='Transport type (ex. RDMA)', type=str, required=True)
@@ -1717,6 +1769,8 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('-o', '--c2h-success', action='store_false', help='Disable C2H success optimization. Relevant only for TCP transport')
     p.add_argument('-f', '--dif-insert-or-strip', action='store_true', help='Enable DIF insert/strip. Relevant only for TCP transport')
     p.add_argument('-y', '--sock-priority', help='The sock priority of the tcp connection. Relevant only for TCP transport', type=int)
+    p.add_argument('-l', '--sock-busy-poll', help="""Time to busy poll the NIC receive queue for on socket reads (usec).
+    Relevant only for TCP transport""", type=int)
     p.set_defaults(func=nvmf_create_transport)
 
     def nvmf_get_transports(args):
@@ -1728,11 +1782,18 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.set_defaults(func=nvmf_get_transports)
 
     def nvmf_get_subsystems(args):
-        print_dict(rpc.nvmf.nvmf_get_subsystems(args.client, tgt_name=args.tgt_name))
+        print_dict(rpc.nvmf.nvmf_get_subsystems(args.client,
+                                                tgt_name=args.tgt_name,
+                                                nqn=args.nqn,
+                                                offset=args.offset,
+                                                count=args.count))
 
     p = subparsers.add_parser('nvmf_get_subsystems', aliases=['get_nvmf_subsystems'],
                               help='Display nvmf subsystems')
     p.add_argument('-t', '--tgt_name', help='The name of the parent NVMe-oF target (optional)', type=str)
+    p.add_argument('-n', '--nqn', help='Only list the subsystem with this NQN (optional)', type=str)
+    p.add_argument('-o', '--offset', help='Number of subsystems to skip (optional)', type=int)
+    p.add_argument('-c', '--count', help='Maximum number of subsystems to list (optional)', type=int)
     p.set_defaults(func=nvmf_get_subsystems)
 
     def nvmf_create_subsystem(args):
@@ -1950,16 +2011,32 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('iops_threshold', help='IOPS threshold when coalescing is enabled', type=int)
     p.set_defaults(func=vhost_controller_set_coalescing)
 
+    def vhost_controller_set_vq_coalescing(args):
+        rpc.vhost.vhost_controller_set_vq_coalescing(args.client,
+                                                     ctrlr=args.ctrlr,
+                                                     vq_idx=args.vq_idx,
+                                                     latency_budget_us=args.latency_budget_us)
+
+    p = subparsers.add_parser('vhost_controller_set_vq_coalescing',
+                              help='Set adaptive coalescing of a single vhost controller virtqueue')
+    p.add_argument('ctrlr', help='controller name')
+    p.add_argument('vq_idx', help='virtqueue index', type=int)
+    p.add_argument('latency_budget_us', help='Maximum event delay in microseconds. 0 disables adaptive coalescing',
+                   type=int)
+    p.set_defaults(func=vhost_controller_set_vq_coalescing)
+
     def vhost_create_scsi_controller(args):
         rpc.vhost.vhost_create_scsi_controller(args.client,
                                                ctrlr=args.ctrlr,
-                                               cpumask=args.cpumask)
+                                               cpumask=args.cpumask,
+                                               packed_ring=args.packed_ring)
 
     p = subparsers.add_parser(
         'vhost_create_scsi_controller', aliases=['construct_vhost_scsi_controller'],
         help='Add new vhost controller')
     p.add_argument('ctrlr', help='controller name')
     p.add_argument('--cpumask', help='cpu mask for this controller')
+    p.add_argument("-p", "--packed_ring", action='store_true', help='Offer packed virtqueues')
     p.set_defaults(func=vhost_create_scsi_controller)
 
     def vhost_scsi_controller_add_target(args):
@@ -1993,7 +2070,8 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                                               ctrlr=args.ctrlr,
                                               dev_name=args.dev_name,
                                               cpumask=args.cpumask,
-                                              readonly=args.readonly)
+                                              readonly=args.readonly,
+                                              packed_ring=args.packed_ring)
 
     p = subparsers.add_parser('vhost_create_blk_controller',
                               aliases=['construct_vhost_blk_controller'],
@@ -2002,6 +2080,7 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('dev_name', help='device name')
     p.add_argument('--cpumask', help='cpu mask for this controller')
     p.add_argument("-r", "--readonly", action='store_true', help='Set controller as read-only')
+    p.add_argument("-p", "--packed_ring", action='store_true', help='Offer packed virtqueues')
     p.set_defaults(func=vhost_create_blk_controller)
 
     def vhost_create_nvme_controller(args):
@@ -36,6 +36,11 @@ def framework_wait_init(client):
     return client.call('framework_wait_init')
 
 
+def framework_get_startup_timeline(client):
+    """Get the duration of each step of the application startup"""
+    return client.call('framework_get_startup_timeline')
+
+
 @deprecated_alias("get_rpc_methods")
 def rpc_get_methods(client, current=None, include_aliases=None):
     """Get list of supported RPC methods.
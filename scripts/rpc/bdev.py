@@ -20,17 +20,23 @@ def bdev_set_options(client, bdev_io_pool_size=None, bdev_io_cache_size=None):
 
 
 @deprecated_alias('construct_compress_bdev')
-def bdev_compress_create(client, base_bdev_name, pm_path):
+def bdev_compress_create(client, base_bdev_name, pm_path, pmd=None, sw_level=None):
     """Construct a compress virtual block device.
 
     Args:
         base_bdev_name: name of the underlying base bdev
         pm_path: path to persistent memory
+        pmd: compression backend, same values as compress_set_pmd (optional)
+        sw_level: compression level of the software backend, 0 to 3 (optional)
 
     Returns:
         Name of created virtual block device.
     """
     params = {'base_bdev_name': base_bdev_name, 'pm_path': pm_path}
+    if pmd is not None:
+        params['pmd'] = pmd
+    if sw_level is not None:
+        params['sw_level'] = sw_level
 
     return client.call('bdev_compress_create', params)
 
@@ -51,13 +57,24 @@ def compress_set_pmd(client, pmd):
     """Set pmd options for the bdev compress.
 
     Args:
-        pmd: 0 = auto-select, 1 = QAT, 2 = ISAL
+        pmd: 0 = auto-select, 1 = QAT, 2 = ISAL, 3 = software
     """
     params = {'pmd': pmd}
 
     return client.call('compress_set_pmd', params)
 
 
+def compress_set_chunk_cache_size(client, size):
+    """Set the decompressed chunk cache size of compress bdevs created or loaded afterwards.
+
+    Args:
+        size: cache size in bytes per compress bdev, 0 = disabled
+    """
+    params = {'size': size}
+
+    return client.call('compress_set_chunk_cache_size', params)
+
+
 def bdev_compress_get_orphans(client, name=None):
     """Get a list of comp bdevs that do not have a pmem file (aka orphaned).
 
@@ -74,14 +91,18 @@ def bdev_compress_get_orphans(client, name=None):
 
 
 @deprecated_alias('construct_crypto_bdev')
-def bdev_crypto_create(client, base_bdev_name, name, crypto_pmd, key, cipher=None, key2=None):
+def bdev_crypto_create(client, base_bdev_name, name, crypto_pmd, key, cipher=None, key2=None,
+                       data_unit_size=None):
     """Construct a crypto virtual block device.
 
     Args:
         base_bdev_name: name of the underlying base bdev
         name: name for the crypto vbdev
-        crypto_pmd: name of of the DPDK crypto driver to use
+        crypto_pmd: name of of the DPDK crypto driver to use, or crypto_sw
         key: key
+        cipher: AES_CBC or AES_XTS (optional)
+        key2: 2nd key for AES_XTS (optional)
+        data_unit_size: bytes encrypted with one IV/tweak, crypto_sw only (optional)
 
     Returns:
         Name of created virtual block device.
@@ -91,6 +112,8 @@ def bdev_crypto_create(client, base_bdev_name, name, crypto_pmd, key, cipher=Non
         params['cipher'] = cipher
     if key2:
         params['key2'] = key2
+    if data_unit_size:
+        params['data_unit_size'] = data_unit_size
     return client.call('bdev_crypto_create', params)
 
 
@@ -151,6 +174,20 @@ def bdev_ocf_get_stats(client, name):
     return client.call('bdev_ocf_get_stats', params)
 
 
+def bdev_ocf_get_queue_stats(client, name):
+    """Get per-thread queue statistics of chosen OCF block device
+
+    Args:
+        name: name of OCF bdev
+
+    Returns:
+        Array of per-thread queue statistics
+    """
+    params = {'name': name}
+
+    return client.call('bdev_ocf_get_queue_stats', params)
+
+
 @deprecated_alias('get_ocf_stats')
 def bdev_ocf_get_bdevs(client, name=None):
     """Get list of OCF devices including unregistered ones
@@ -950,11 +987,14 @@ def bdev_ocssd_delete(client, name):
 
 
 @deprecated_alias('get_bdevs')
-def bdev_get_bdevs(client, name=None):
+def bdev_get_bdevs(client, name=None, product_name=None, offset=None, count=None):
     """Get information about block devices.
 
     Args:
         name: bdev name to query (optional; if omitted, query all bdevs)
+        product_name: only list bdevs with this product name (optional)
+        offset: number of matching bdevs to skip (optional)
+        count: maximum number of bdevs to list (optional)
 
     Returns:
         List of bdev information objects.
@@ -962,6 +1002,12 @@ def bdev_get_bdevs(client, name=None):
     params = {}
     if name:
         params['name'] = name
+    if product_name:
+        params['product_name'] = product_name
+    if offset:
+        params['offset'] = offset
+    if count:
+        params['count'] = count
     return client.call('bdev_get_bdevs', params)
 
 
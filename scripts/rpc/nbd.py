@@ -2,12 +2,14 @@ from .helpers import deprecated_alias
 
 
 @deprecated_alias('start_nbd_disk')
-def nbd_start_disk(client, bdev_name, nbd_device):
+def nbd_start_disk(client, bdev_name, nbd_device, num_connections=None):
     params = {
         'bdev_name': bdev_name
     }
     if nbd_device:
         params['nbd_device'] = nbd_device
+    if num_connections:
+        params['num_connections'] = num_connections
     return client.call('nbd_start_disk', params)
 
 
@@ -106,7 +106,8 @@ def nvmf_create_transport(client,
                           no_srq=False,
                           c2h_success=True,
                           dif_insert_or_strip=None,
-                          sock_priority=None):
+                          sock_priority=None,
+                          sock_busy_poll=None):
     """NVMf Transport Create options.
 
     Args:
@@ -123,6 +124,8 @@ def nvmf_create_transport(client,
         no_srq: Boolean flag to disable SRQ even for devices that support it - RDMA specific (optional)
         c2h_success: Boolean flag to disable the C2H success optimization - TCP specific (optional)
         dif_insert_or_strip: Boolean flag to enable DIF insert/strip for I/O - TCP specific (optional)
+        sock_priority: The socket priority of the connections - TCP specific (optional)
+        sock_busy_poll: Time to busy poll the NIC receive queue for on socket reads in microseconds - TCP specific (optional)
 
     Returns:
         True or False
@@ -158,6 +161,8 @@ def nvmf_create_transport(client,
         params['dif_insert_or_strip'] = dif_insert_or_strip
     if sock_priority:
         params['sock_priority'] = sock_priority
+    if sock_busy_poll:
+        params['sock_busy_poll'] = sock_busy_poll
     return client.call('nvmf_create_transport', params)
 
 
@@ -182,10 +187,13 @@ def nvmf_get_transports(client, tgt_name=None):
 
 
 @deprecated_alias('get_nvmf_subsystems')
-def nvmf_get_subsystems(client, tgt_name=None):
+def nvmf_get_subsystems(client, tgt_name=None, nqn=None, offset=None, count=None):
     """Get list of NVMe-oF subsystems.
     Args:
         tgt_name: name of the parent NVMe-oF target (optional).
+        nqn: only list the subsystem with this NQN (optional).
+        offset: number of subsystems to skip (optional).
+        count: maximum number of subsystems to list (optional).
 
     Returns:
         List of NVMe-oF subsystem objects.
@@ -194,9 +202,16 @@ def nvmf_get_subsystems(client, tgt_name=None):
     params = {}
 
     if tgt_name:
-        params = {
-            'tgt_name': tgt_name,
-        }
+        params['tgt_name'] = tgt_name
+
+    if nqn:
+        params['nqn'] = nqn
+
+    if offset:
+        params['offset'] = offset
+
+    if count:
+        params['count'] = count
 
     return client.call('nvmf_get_subsystems', params)
 
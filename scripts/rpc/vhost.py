@@ -17,17 +17,35 @@ def vhost_controller_set_coalescing(client, ctrlr, delay_base_us, iops_threshold
     return client.call('vhost_controller_set_coalescing', params)
 
 
+def vhost_controller_set_vq_coalescing(client, ctrlr, vq_idx, latency_budget_us):
+    """Set adaptive coalescing for a single virtqueue of a vhost controller.
+    Args:
+        ctrlr: controller name
+        vq_idx: virtqueue index
+        latency_budget_us: maximum event delay in microseconds, 0 to disable
+    """
+    params = {
+        'ctrlr': ctrlr,
+        'vq_idx': vq_idx,
+        'latency_budget_us': latency_budget_us,
+    }
+    return client.call('vhost_controller_set_vq_coalescing', params)
+
+
 @deprecated_alias('construct_vhost_scsi_controller')
-def vhost_create_scsi_controller(client, ctrlr, cpumask=None):
+def vhost_create_scsi_controller(client, ctrlr, cpumask=None, packed_ring=None):
     """Create a vhost scsi controller.
     Args:
         ctrlr: controller name
         cpumask: cpu mask for this controller
+        packed_ring: offer packed virtqueues
     """
     params = {'ctrlr': ctrlr}
 
     if cpumask:
         params['cpumask'] = cpumask
+    if packed_ring:
+        params['packed_ring'] = packed_ring
 
     return client.call('vhost_create_scsi_controller', params)
 
@@ -97,13 +115,14 @@ def vhost_nvme_controller_add_ns(client, ctrlr, bdev_name):
 
 
 @deprecated_alias('construct_vhost_blk_controller')
-def vhost_create_blk_controller(client, ctrlr, dev_name, cpumask=None, readonly=None):
+def vhost_create_blk_controller(client, ctrlr, dev_name, cpumask=None, readonly=None, packed_ring=None):
     """Create vhost BLK controller.
     Args:
         ctrlr: controller name
         dev_name: device name to add to controller
         cpumask: cpu mask for this controller
         readonly: set controller as read-only
+        packed_ring: offer packed virtqueues
     """
     params = {
         'ctrlr': ctrlr,
@@ -113,6 +132,8 @@ def vhost_create_blk_controller(client, ctrlr, dev_name, cpumask=None, readonly=
         params['cpumask'] = cpumask
     if readonly:
         params['readonly'] = readonly
+    if packed_ring:
+        params['packed_ring'] = packed_ring
     return client.call('vhost_create_blk_controller', params)
 
 
@@ -0,0 +1,381 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/json.h"
+#include "spdk/file.h"
+#include "spdk/util.h"
+
+/*
+ * This application measures the throughput of the JSON parser and of decoding
+ *  parsed values, to track changes to lib/json.
+ *
+ * The input is either a JSON file or a generated configuration in the format
+ *  written by save_config, with one bdev_malloc_create entry per bdev.
+ *  Decoding is measured on the "config" entries of such a file, once with
+ *  strings allocated by malloc() and once with strings allocated from an arena.
+ */
+
+#define PERF_MAX_STRINGS	16
+
+struct perf_buf {
+	uint8_t	*data;
+	size_t	len;
+	size_t	size;
+};
+
+struct perf_entry {
+	char	*method;
+	char	*strings[PERF_MAX_STRINGS];
+	size_t	num_strings;
+};
+
+static double g_run_time = 5.0;
+
+static void
+usage(const char *prog)
+{
+	printf("usage: %s [options]\n", prog);
+	printf("Options:\n");
+	printf("-f file.json\tparse the given file (default: generated configuration)\n");
+	printf("-n entries\tnumber of bdevs in the generated configuration (default: 10000)\n");
+	printf("-t time\t\trun time of each test in seconds (default: 5)\n");
+	printf("-c\t\tallow comments in input (non-standard)\n");
+}
+
+static double
+now_sec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int
+perf_buf_write_cb(void *cb_ctx, const void *data, size_t size)
+{
+	struct perf_buf *buf = cb_ctx;
+	uint8_t *new_data;
+	size_t new_size;
+
+	if (buf->size - buf->len < size) {
+		new_size = spdk_max(buf->size * 2, buf->len + size);
+		new_data = realloc(buf->data, new_size);
+		if (new_data == NULL) {
+			return -1;
+		}
+		buf->data = new_data;
+		buf->size = new_size;
+	}
+
+	memcpy(buf->data + buf->len, data, size);
+	buf->len += size;
+	return 0;
+}
+
+static int
+generate_config(struct perf_buf *buf, uint32_t num_entries)
+{
+	struct spdk_json_write_ctx *w;
+	uint32_t i;
+
+	w = spdk_json_write_begin(perf_buf_write_cb, buf, SPDK_JSON_WRITE_FLAG_FORMATTED);
+	if (w == NULL) {
+		return -ENOMEM;
+	}
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_array_begin(w, "subsystems");
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "subsystem", "bdev");
+	spdk_json_write_named_array_begin(w, "config");
+	for (i = 0; i < num_entries; i++) {
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "method", "bdev_malloc_create");
+		spdk_json_write_named_object_begin(w, "params");
+		spdk_json_write_named_string_fmt(w, "name", "Malloc%u", i);
+		spdk_json_write_named_uint64(w, "num_blocks", 131072);
+		spdk_json_write_named_uint32(w, "block_size", 512);
+		spdk_json_write_named_string_fmt(w, "uuid", "%08x-4e4f-4b45-8d2c-%012x", i, i);
+		spdk_json_write_object_end(w);
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+	spdk_json_write_object_end(w);
+	spdk_json_write_array_end(w);
+	spdk_json_write_object_end(w);
+
+	return spdk_json_write_end(w);
+}
+
+static int
+decode_params(const struct spdk_json_val *val, void *out)
+{
+	struct perf_entry *entry = SPDK_CONTAINEROF(out, struct perf_entry, strings);
+	struct spdk_json_val *it, *v;
+
+	if (val->type != SPDK_JSON_VAL_OBJECT_BEGIN) {
+		return 0;
+	}
+
+	/* Decode every string member, which is what a typical RPC parameter decoder does */
+	for (it = spdk_json_object_first((struct spdk_json_val *)val); it != NULL; it = spdk_json_next(it)) {
+		v = it + 1;
+		if (v->type == SPDK_JSON_VAL_STRING && entry->num_strings < PERF_MAX_STRINGS) {
+			if (spdk_json_decode_string(v, &entry->strings[entry->num_strings++])) {
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static const struct spdk_json_object_decoder perf_entry_decoders[] = {
+	{"method", offsetof(struct perf_entry, method), spdk_json_decode_string},
+	{"params", offsetof(struct perf_entry, strings), decode_params, true},
+};
+
+static void
+free_perf_entry(struct perf_entry *entry)
+{
+	size_t i;
+
+	free(entry->method);
+	for (i = 0; i < entry->num_strings; i++) {
+		free(entry->strings[i]);
+	}
+}
+
+static void
+run_parse(const struct perf_buf *input, uint32_t flags, const char *name)
+{
+	void *buf;
+	struct spdk_json_val *values = NULL;
+	ssize_t num_values;
+	uint64_t iterations = 0;
+	double start, end, elapsed = 0.0;
+
+	buf = malloc(input->len);
+	if (buf == NULL) {
+		fprintf(stderr, "%s: out of memory\n", name);
+		return;
+	}
+
+	do {
+		/* Parsing in place modifies the input, so every iteration needs a fresh copy */
+		memcpy(buf, input->data, input->len);
+
+		start = now_sec();
+		/* Count the values first, like JSON config loading does */
+		num_values = spdk_json_parse(buf, input->len, NULL, 0, NULL, flags);
+		if (num_values <= 0) {
+			fprintf(stderr, "%s: parse failed (%zd)\n", name, num_values);
+			goto out;
+		}
+		if (values == NULL) {
+			values = calloc(num_values, sizeof(*values));
+			if (values == NULL) {
+				fprintf(stderr, "%s: out of memory\n", name);
+				goto out;
+			}
+		}
+		spdk_json_parse(buf, input->len, values, num_values, NULL, flags);
+		end = now_sec();
+
+		elapsed += end - start;
+		iterations++;
+	} while (elapsed < g_run_time);
+
+	printf("%-20s %10.2f MiB/s %14.0f values/s\n", name,
+	       iterations * input->len / elapsed / (1024 * 1024),
+	       iterations * num_values / elapsed);
+out:
+	free(values);
+	free(buf);
+}
+
+static void
+run_decode(struct spdk_json_val *config, struct spdk_json_arena *arena, const char *name)
+{
+	struct spdk_json_val *it;
+	struct perf_entry entry;
+	uint64_t decoded = 0;
+	double start, elapsed;
+	int rc;
+
+	start = now_sec();
+	do {
+		for (it = spdk_json_array_first(config); it != NULL; it = spdk_json_next(it)) {
+			memset(&entry, 0, sizeof(entry));
+			if (arena != NULL) {
+				rc = spdk_json_decode_object_arena(it, perf_entry_decoders,
+								   SPDK_COUNTOF(perf_entry_decoders), &entry, arena);
+				spdk_json_arena_reset(arena);
+			} else {
+				rc = spdk_json_decode_object(it, perf_entry_decoders,
+							     SPDK_COUNTOF(perf_entry_decoders), &entry);
+				free_perf_entry(&entry);
+			}
+			if (rc != 0) {
+				fprintf(stderr, "%s: decode failed\n", name);
+				return;
+			}
+			decoded++;
+		}
+		elapsed = now_sec() - start;
+	} while (elapsed < g_run_time);
+
+	printf("%-20s %10.0f entries/s\n", name, decoded / elapsed);
+}
+
+static int
+run_decode_tests(const struct perf_buf *input, uint32_t flags)
+{
+	struct spdk_json_val *values, *subsystems, *subsystem, *config;
+	struct spdk_json_arena *arena;
+	void *buf;
+	ssize_t num_values;
+	int rc = 0;
+
+	buf = malloc(input->len);
+	if (buf == NULL) {
+		return -ENOMEM;
+	}
+	memcpy(buf, input->data, input->len);
+
+	num_values = spdk_json_parse(buf, input->len, NULL, 0, NULL, flags);
+	values = calloc(spdk_max(num_values, 1), sizeof(*values));
+	arena = spdk_json_arena_create(0);
+	if (values == NULL || arena == NULL) {
+		rc = -ENOMEM;
+		goto out;
+	}
+	spdk_json_parse(buf, input->len, values, num_values, NULL,
+			flags | SPDK_JSON_PARSE_FLAG_DECODE_IN_PLACE);
+
+	if (spdk_json_find_array(values, "subsystems", NULL, &subsystems) != 0) {
+		printf("No \"subsystems\" array - skipping decode tests\n");
+		goto out;
+	}
+
+	for (subsystem = spdk_json_array_first(subsystems); subsystem != NULL;
+	     subsystem = spdk_json_next(subsystem)) {
+		if (spdk_json_find_array(subsystem, "config", NULL, &config) == 0 &&
+		    spdk_json_array_first(config) != NULL) {
+			break;
+		}
+	}
+
+	if (subsystem == NULL) {
+		printf("No \"config\" entries - skipping decode tests\n");
+		goto out;
+	}
+
+	run_decode(config, NULL, "decode (malloc)");
+	run_decode(config, arena, "decode (arena)");
+out:
+	spdk_json_arena_free(arena);
+	free(values);
+	free(buf);
+	return rc;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct perf_buf input = {};
+	const char *filename = NULL;
+	uint32_t num_entries = 10000;
+	uint32_t flags = 0;
+	FILE *f;
+	int ch;
+	int rc;
+
+	while ((ch = getopt(argc, argv, "cf:n:t:")) != -1) {
+		switch (ch) {
+		case 'c':
+			flags |= SPDK_JSON_PARSE_FLAG_ALLOW_COMMENTS;
+			break;
+		case 'f':
+			filename = optarg;
+			break;
+		case 'n':
+			num_entries = strtoul(optarg, NULL, 10);
+			break;
+		case 't':
+			g_run_time = strtod(optarg, NULL);
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (filename != NULL) {
+		f = fopen(filename, "r");
+		if (f == NULL) {
+			perror("fopen");
+			return 1;
+		}
+		input.data = spdk_posix_file_load(f, &input.len);
+		fclose(f);
+		if (input.data == NULL) {
+			fprintf(stderr, "%s: file read error\n", filename);
+			return 1;
+		}
+	} else {
+		rc = generate_config(&input, num_entries);
+		if (rc != 0) {
+			fprintf(stderr, "Failed to generate configuration\n");
+			free(input.data);
+			return 1;
+		}
+	}
+
+	if (spdk_json_parse(input.data, input.len, NULL, 0, NULL, flags) <= 0) {
+		fprintf(stderr, "Input is not valid JSON\n");
+		free(input.data);
+		return 1;
+	}
+
+	printf("Input: %zu bytes\n", input.len);
+	run_parse(&input, flags, "parse");
+	run_parse(&input, flags | SPDK_JSON_PARSE_FLAG_DECODE_IN_PLACE, "parse (in place)");
+	rc = run_decode_tests(&input, flags);
+
+	free(input.data);
+	return rc ? 1 : 0;
+}
@@ -67,6 +67,8 @@ case "$test_type" in
 		pmd=1;;
 	isal )
 		pmd=2;;
+	sw )
+		pmd=3;;
 	* )
 		echo "invalid pmd name"
 		exit 1
@@ -381,6 +381,174 @@ test_mem_map_translation(void)
 	CU_ASSERT(map == NULL);
 }
 
+static void
+test_mem_map_translation_cache(void)
+{
+	struct spdk_mem_map *map;
+	uint64_t default_translation = 0xDEADBEEF0BADF00D;
+	uint64_t addr;
+	uint64_t mapping_length;
+	int rc;
+
+	map = spdk_mem_map_alloc(default_translation, &test_mem_map_ops, NULL);
+	SPDK_CU_ASSERT_FATAL(map != NULL);
+
+	/* Map three contiguous regions and look them up twice, the second time from the cache */
+	rc = spdk_mem_map_set_translation(map, 0, 3 * VALUE_2MB, 0x1000);
+	CU_ASSERT(rc == 0);
+
+	mapping_length = VALUE_2MB * 3;
+	addr = spdk_mem_map_translate(map, 0, &mapping_length);
+	CU_ASSERT(addr == 0x1000);
+	CU_ASSERT(mapping_length == VALUE_2MB * 3);
+
+	mapping_length = VALUE_2MB * 3 - VALUE_4KB;
+	addr = spdk_mem_map_translate(map, VALUE_4KB, &mapping_length);
+	CU_ASSERT(addr == 0x1000);
+	CU_ASSERT(mapping_length == VALUE_2MB * 3 - VALUE_4KB);
+
+	/* Change the translation of the middle region, the cached length must not be used */
+	rc = spdk_mem_map_set_translation(map, VALUE_2MB, VALUE_2MB, 0x2000);
+	CU_ASSERT(rc == 0);
+
+	mapping_length = VALUE_2MB * 3;
+	addr = spdk_mem_map_translate(map, 0, &mapping_length);
+	CU_ASSERT(addr == 0x1000);
+	CU_ASSERT(mapping_length == VALUE_2MB);
+
+	mapping_length = VALUE_2MB * 2;
+	addr = spdk_mem_map_translate(map, VALUE_2MB, &mapping_length);
+	CU_ASSERT(addr == 0x2000);
+	CU_ASSERT(mapping_length == VALUE_2MB);
+
+	/* Clear the translation and make sure the cache doesn't return the old one */
+	rc = spdk_mem_map_clear_translation(map, 0, VALUE_2MB * 3);
+	CU_ASSERT(rc == 0);
+
+	mapping_length = VALUE_2MB;
+	addr = spdk_mem_map_translate(map, 0, &mapping_length);
+	CU_ASSERT(addr == default_translation);
+
+	spdk_mem_map_free(&map);
+	CU_ASSERT(map == NULL);
+
+	/* A new map must not see the cached translations of a freed one */
+	map = spdk_mem_map_alloc(default_translation, &test_mem_map_ops, NULL);
+	SPDK_CU_ASSERT_FATAL(map != NULL);
+
+	rc = spdk_mem_map_set_translation(map, 0, 3 * VALUE_2MB, 0x1000);
+	CU_ASSERT(rc == 0);
+
+	mapping_length = VALUE_2MB * 3;
+	addr = spdk_mem_map_translate(map, 0, &mapping_length);
+	CU_ASSERT(addr == 0x1000);
+	CU_ASSERT(mapping_length == VALUE_2MB * 3);
+
+	spdk_mem_map_free(&map);
+	CU_ASSERT(map == NULL);
+
+	map = spdk_mem_map_alloc(default_translation, &test_mem_map_ops, NULL);
+	SPDK_CU_ASSERT_FATAL(map != NULL);
+
+	rc = spdk_mem_map_set_translation(map, 0, VALUE_2MB, 0x3000);
+	CU_ASSERT(rc == 0);
+
+	mapping_length = VALUE_2MB * 3;
+	addr = spdk_mem_map_translate(map, 0, &mapping_length);
+	CU_ASSERT(addr == 0x3000);
+	CU_ASSERT(mapping_length == VALUE_2MB);
+
+	rc = spdk_mem_map_clear_translation(map, 0, VALUE_2MB);
+	CU_ASSERT(rc == 0);
+
+	/* Map two full 1GB regions, e.g. backed by 1GB hugepages */
+	rc = spdk_mem_map_set_translation(map, VALUE_1GB, 2 * VALUE_1GB, 0x4000);
+	CU_ASSERT(rc == 0);
+
+	mapping_length = VALUE_1GB * 2;
+	addr = spdk_mem_map_translate(map, VALUE_1GB + VALUE_4KB, &mapping_length);
+	CU_ASSERT(addr == 0x4000);
+	CU_ASSERT(mapping_length == VALUE_1GB * 2 - VALUE_4KB);
+
+	/* The length is limited by the end of the mapped range */
+	mapping_length = VALUE_1GB * 4;
+	addr = spdk_mem_map_translate(map, 2 * VALUE_1GB - VALUE_2MB, &mapping_length);
+	CU_ASSERT(addr == 0x4000);
+	CU_ASSERT(mapping_length == VALUE_1GB + VALUE_2MB);
+
+	/* Break the contiguity in the middle of the second 1GB region */
+	rc = spdk_mem_map_set_translation(map, 2 * VALUE_1GB + 10 * VALUE_2MB, VALUE_2MB, 0x5000);
+	CU_ASSERT(rc == 0);
+
+	mapping_length = VALUE_1GB * 2;
+	addr = spdk_mem_map_translate(map, VALUE_1GB, &mapping_length);
+	CU_ASSERT(addr == 0x4000);
+	CU_ASSERT(mapping_length == VALUE_1GB + 10 * VALUE_2MB);
+
+	/* Restore it */
+	rc = spdk_mem_map_set_translation(map, 2 * VALUE_1GB + 10 * VALUE_2MB, VALUE_2MB, 0x4000);
+	CU_ASSERT(rc == 0);
+
+	mapping_length = VALUE_1GB * 2;
+	addr = spdk_mem_map_translate(map, VALUE_1GB, &mapping_length);
+	CU_ASSERT(addr == 0x4000);
+	CU_ASSERT(mapping_length == VALUE_1GB * 2);
+
+	rc = spdk_mem_map_clear_translation(map, VALUE_1GB, 2 * VALUE_1GB);
+	CU_ASSERT(rc == 0);
+
+	spdk_mem_map_free(&map);
+	CU_ASSERT(map == NULL);
+}
+
+static void
+test_mem_map_translate_iov(void)
+{
+	struct spdk_mem_map *map;
+	uint64_t default_translation = 0xDEADBEEF0BADF00D;
+	uint64_t translations[4];
+	struct iovec iov[4];
+	int rc;
+
+	map = spdk_mem_map_alloc(default_translation, &test_mem_map_ops, NULL);
+	SPDK_CU_ASSERT_FATAL(map != NULL);
+
+	rc = spdk_mem_map_set_translation(map, 0, 2 * VALUE_2MB, 0x1000);
+	CU_ASSERT(rc == 0);
+	rc = spdk_mem_map_set_translation(map, 2 * VALUE_2MB, VALUE_2MB, 0x2000);
+	CU_ASSERT(rc == 0);
+
+	/* Buffers within single translations, including one crossing a 2MB boundary */
+	iov[0].iov_base = (void *)0;
+	iov[0].iov_len = VALUE_4KB;
+	iov[1].iov_base = (void *)(2 * VALUE_2MB);
+	iov[1].iov_len = 2 * VALUE_4KB;
+	iov[2].iov_base = (void *)(VALUE_2MB - 100);
+	iov[2].iov_len = 200;
+	/* Buffer split over two translations */
+	iov[3].iov_base = (void *)(2 * VALUE_2MB - 100);
+	iov[3].iov_len = 200;
+
+	rc = spdk_mem_map_translate_iov(map, iov, 4, translations);
+	CU_ASSERT(rc == 3);
+	CU_ASSERT(translations[0] == 0x1000);
+	CU_ASSERT(translations[1] == 0x2000);
+	CU_ASSERT(translations[2] == 0x1000);
+	CU_ASSERT(translations[3] == 0x1000);
+
+	rc = spdk_mem_map_translate_iov(map, iov, 2, translations);
+	CU_ASSERT(rc == 2);
+
+	rc = spdk_mem_map_translate_iov(map, &iov[3], 1, translations);
+	CU_ASSERT(rc == 0);
+
+	rc = spdk_mem_map_clear_translation(map, 0, 3 * VALUE_2MB);
+	CU_ASSERT(rc == 0);
+
+	spdk_mem_map_free(&map);
+	CU_ASSERT(map == NULL);
+}
+
 static void
 test_mem_map_registration(void)
 {
@@ -520,6 +688,8 @@ main(int argc, char **argv)
 	if (
 		CU_add_test(suite, "alloc and free memory map", test_mem_map_alloc_free) == NULL ||
 		CU_add_test(suite, "mem map translation", test_mem_map_translation) == NULL ||
+		CU_add_test(suite, "mem map translation cache", test_mem_map_translation_cache) == NULL ||
+		CU_add_test(suite, "mem map translate iov", test_mem_map_translate_iov) == NULL ||
 		CU_add_test(suite, "mem map registration", test_mem_map_registration) == NULL ||
 		CU_add_test(suite, "mem map adjacent registrations", test_mem_map_registration_adjacent) == NULL
 	) {
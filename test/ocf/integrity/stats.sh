@@ -12,5 +12,28 @@ bdev_perf_pid=$!
 waitforlisten $bdev_perf_pid
 sleep 1
 $rpc_py bdev_ocf_get_stats MalCache1
+
+# Every OCF queue reports its own counters; the bdevperf write load must
+# show up as submitted and completed I/O on both the cache and core bdevs
+# of the write-through device, and only on the core of the pass-through one.
+$rpc_py bdev_ocf_get_queue_stats MalCache1
+stats=$($rpc_py bdev_ocf_get_queue_stats MalCache1)
+[ "$(jq 'length' <<< "$stats")" -ge 1 ]
+[ "$(jq '[.[].submitted] | add' <<< "$stats")" -gt 0 ]
+[ "$(jq '[.[].completed] | add' <<< "$stats")" -gt 0 ]
+[ "$(jq '[.[].failed] | add' <<< "$stats")" -eq 0 ]
+[ "$(jq '[.[].cache_ios] | add' <<< "$stats")" -gt 0 ]
+[ "$(jq '[.[].core_ios] | add' <<< "$stats")" -gt 0 ]
+
+stats=$($rpc_py bdev_ocf_get_queue_stats MalCache2)
+[ "$(jq '[.[].submitted] | add' <<< "$stats")" -gt 0 ]
+[ "$(jq '[.[].core_ios] | add' <<< "$stats")" -gt 0 ]
+[ "$(jq '[.[].failed] | add' <<< "$stats")" -eq 0 ]
+
+# Unknown OCF bdev must be rejected
+if $rpc_py bdev_ocf_get_queue_stats NonExisting; then
+	exit 1
+fi
+
 kill -9 $bdev_perf_pid
 wait $bdev_perf_pid || true
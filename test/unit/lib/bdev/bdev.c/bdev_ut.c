@@ -58,6 +58,13 @@ DEFINE_STUB_V(spdk_trace_register_description, (const char *name,
 		uint8_t arg1_type, const char *arg1_name));
 DEFINE_STUB_V(_spdk_trace_record, (uint64_t tsc, uint16_t tpoint_id, uint16_t poller_id,
 				   uint32_t size, uint64_t object_id, uint64_t arg1));
+DEFINE_STUB_V(spdk_trace_register_description_ext, (const char *name,
+		uint16_t tpoint_id, uint8_t owner_type,
+		uint8_t object_type, uint8_t new_object,
+		uint8_t num_args, const struct spdk_trace_tpoint_arg *args));
+DEFINE_STUB_V(_spdk_trace_record_args, (uint64_t tsc, uint16_t tpoint_id, uint16_t poller_id,
+					uint32_t size, uint64_t object_id, uint8_t num_args,
+					const uint64_t *args));
 DEFINE_STUB(spdk_notify_send, uint64_t, (const char *type, const char *ctx), 0);
 DEFINE_STUB(spdk_notify_type_register, struct spdk_notify_type *, (const char *type), NULL);
 
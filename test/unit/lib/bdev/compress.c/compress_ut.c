@@ -292,6 +292,19 @@ DEFINE_STUB_V(spdk_reduce_vol_load, (struct spdk_reduce_backing_dev *backing_dev
 				     spdk_reduce_vol_op_with_handle_complete cb_fn, void *cb_arg));
 DEFINE_STUB(spdk_reduce_vol_get_params, const struct spdk_reduce_vol_params *,
 	    (struct spdk_reduce_vol *vol), NULL);
+DEFINE_STUB(spdk_reduce_vol_set_cache_size, int, (struct spdk_reduce_vol *vol, uint64_t size), 0);
+
+/* Software backend stubs */
+DEFINE_STUB(compress_sw_available, bool, (void), false);
+DEFINE_STUB(compress_sw_init, int, (uint32_t max_chunk_size), 0);
+DEFINE_STUB_V(compress_sw_fini, (void));
+DEFINE_STUB_V(compress_sw_queue_init, (struct compress_sw_queue *queue));
+DEFINE_STUB(compress_sw_queue_op, int, (struct compress_sw_queue *queue,
+					struct iovec *src_iovs, int src_iovcnt,
+					struct iovec *dst_iovs, int dst_iovcnt,
+					bool compress, uint32_t level,
+					struct spdk_reduce_vol_cb_args *cb_arg), 0);
+DEFINE_STUB(compress_sw_queue_flush, int, (struct compress_sw_queue *queue), 0);
 
 /* DPDK stubs */
 DEFINE_STUB(rte_socket_id, unsigned, (void), 0);
@@ -530,6 +543,7 @@ test_setup(void)
 	g_comp_bdev.backing_dev.blocklen = 512;
 	g_comp_bdev.backing_dev.blockcnt = 1024 * 16;
 
+	g_comp_bdev.backend = &g_isal_backend;
 	g_comp_bdev.device_qp = &g_device_qp;
 	g_comp_bdev.device_qp->device = &g_device;
 
@@ -1095,6 +1109,108 @@ test_supported_io(void)
 
 }
 
+static void
+test_sw_backend(void)
+{
+	struct vbdev_compress comp_bdev = {};
+	struct iovec src_iovs[1] = {};
+	struct iovec dst_iovs[1] = {};
+	struct spdk_reduce_vol_cb_args cb_arg;
+	struct vbdev_comp_op *op;
+	int rc;
+
+	/* Without QAT, auto-select prefers the software backend when it's there. */
+	g_qat_available = false;
+	g_isal_available = true;
+	MOCK_SET(compress_sw_available, true);
+	CU_ASSERT(_set_pmd(&comp_bdev, COMPRESS_PMD_AUTO) == true);
+	CU_ASSERT(comp_bdev.backend == &g_sw_backend);
+	CU_ASSERT(strcmp(comp_bdev.backend->name, SW_BACKEND) == 0);
+
+	CU_ASSERT(_set_pmd(&comp_bdev, COMPRESS_PMD_ISAL_ONLY) == true);
+	CU_ASSERT(comp_bdev.backend == &g_isal_backend);
+	CU_ASSERT(strcmp(comp_bdev.backend->name, ISAL_PMD) == 0);
+
+	g_qat_available = true;
+	CU_ASSERT(_set_pmd(&comp_bdev, COMPRESS_PMD_AUTO) == true);
+	CU_ASSERT(comp_bdev.backend == &g_qat_backend);
+	CU_ASSERT(strcmp(comp_bdev.backend->name, QAT_PMD) == 0);
+
+	CU_ASSERT(_set_pmd(&comp_bdev, COMPRESS_PMD_SW_ONLY) == true);
+	CU_ASSERT(comp_bdev.backend == &g_sw_backend);
+
+	MOCK_SET(compress_sw_available, false);
+	CU_ASSERT(_set_pmd(&comp_bdev, COMPRESS_PMD_SW_ONLY) == false);
+	g_qat_available = false;
+	CU_ASSERT(_set_pmd(&comp_bdev, COMPRESS_PMD_AUTO) == true);
+	CU_ASSERT(comp_bdev.backend == &g_isal_backend);
+	CU_ASSERT(strcmp(comp_bdev.backend->name, ISAL_PMD) == 0);
+	MOCK_CLEAR(compress_sw_available);
+	g_isal_available = false;
+
+	/* Ops go to the software queue instead of the device. */
+	g_comp_bdev.backend = &g_sw_backend;
+	CU_ASSERT(TAILQ_EMPTY(&g_comp_bdev.queued_comp_ops) == true);
+	rc = _compress_operation(&g_comp_bdev.backing_dev, src_iovs, 1, dst_iovs, 1, true, &cb_arg);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(TAILQ_EMPTY(&g_comp_bdev.queued_comp_ops) == true);
+
+	/* Errors other than running out of ops are returned. */
+	MOCK_SET(compress_sw_queue_op, -EINVAL);
+	rc = _compress_operation(&g_comp_bdev.backing_dev, src_iovs, 1, dst_iovs, 1, true, &cb_arg);
+	CU_ASSERT(rc == -EINVAL);
+	CU_ASSERT(TAILQ_EMPTY(&g_comp_bdev.queued_comp_ops) == true);
+
+	/* Out of ops, the op is queued and resubmitted by the poller. */
+	MOCK_SET(compress_sw_queue_op, -ENOMEM);
+	rc = _compress_operation(&g_comp_bdev.backing_dev, src_iovs, 1, dst_iovs, 1, false, &cb_arg);
+	CU_ASSERT(rc == 0);
+	op = TAILQ_FIRST(&g_comp_bdev.queued_comp_ops);
+	SPDK_CU_ASSERT_FATAL(op != NULL);
+	CU_ASSERT(op->compress == false);
+	CU_ASSERT(op->cb_arg == &cb_arg);
+
+	MOCK_SET(compress_sw_queue_op, 0);
+	comp_sw_poller(&g_comp_bdev);
+	CU_ASSERT(TAILQ_EMPTY(&g_comp_bdev.queued_comp_ops) == true);
+	MOCK_CLEAR(compress_sw_queue_op);
+	g_comp_bdev.backend = &g_isal_backend;
+}
+
+static void
+test_loaded_pmd(void)
+{
+	struct vbdev_compress comp_bdev = {};
+	enum compress_pmd opts = COMPRESS_PMD_AUTO;
+
+	g_qat_available = true;
+	g_isal_available = true;
+	MOCK_SET(compress_sw_available, true);
+	compress_set_pmd(&opts);
+
+	/* Volumes without a persisted backend use the default one. */
+	comp_bdev.sw_level = COMPRESS_SW_DEFAULT_LEVEL;
+	CU_ASSERT(_set_loaded_pmd(&comp_bdev) == true);
+	CU_ASSERT(comp_bdev.backend == &g_qat_backend);
+	CU_ASSERT(comp_bdev.sw_level == COMPRESS_SW_DEFAULT_LEVEL);
+
+	/* The persisted backend and level are restored. */
+	comp_bdev.params.comp_backend = COMPRESS_PMD_SW_ONLY;
+	comp_bdev.params.comp_level = COMPRESS_SW_MAX_LEVEL;
+	CU_ASSERT(_set_loaded_pmd(&comp_bdev) == true);
+	CU_ASSERT(comp_bdev.backend == &g_sw_backend);
+	CU_ASSERT(comp_bdev.sw_level == COMPRESS_SW_MAX_LEVEL);
+
+	/* If it isn't available anymore, the default one is used instead. */
+	MOCK_SET(compress_sw_available, false);
+	CU_ASSERT(_set_loaded_pmd(&comp_bdev) == true);
+	CU_ASSERT(comp_bdev.backend == &g_qat_backend);
+
+	MOCK_CLEAR(compress_sw_available);
+	g_qat_available = false;
+	g_isal_available = false;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -1121,6 +1237,10 @@ main(int argc, char **argv)
 			test_passthru) == NULL ||
 	    CU_add_test(suite, "test_initdrivers",
 			test_initdrivers) == NULL ||
+	    CU_add_test(suite, "test_sw_backend",
+			test_sw_backend) == NULL ||
+	    CU_add_test(suite, "test_loaded_pmd",
+			test_loaded_pmd) == NULL ||
 	    CU_add_test(suite, "test_supported_io",
 			test_supported_io) == NULL ||
 	    CU_add_test(suite, "test_poller",
@@ -0,0 +1,280 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "spdk/stdinc.h"
+
+#include "spdk_cunit.h"
+#include "common/lib/ut_multithread.c"
+
+#include "bdev/compress/vbdev_compress_sw.c"
+
+#define UT_CHUNK_SIZE	(16 * 1024)
+
+struct ut_op_ctx {
+	bool	done;
+	int	status;
+};
+
+static void
+ut_op_done(void *cb_arg, int status)
+{
+	struct ut_op_ctx *ctx = cb_arg;
+
+	ctx->done = true;
+	ctx->status = status;
+}
+
+/* Poll the submitting thread and the worker threads until they are all idle */
+static void
+ut_poll_workers(void)
+{
+	bool busy;
+	uint32_t i;
+
+	do {
+		busy = poll_thread(0);
+		for (i = 0; i < g_num_workers; i++) {
+			busy |= spdk_thread_poll(g_workers[i]->thread, 0, 0) > 0;
+		}
+	} while (busy);
+}
+
+static int
+ut_run_op(struct iovec *src_iovs, int src_iovcnt, struct iovec *dst_iovs, int dst_iovcnt,
+	  bool compress)
+{
+	struct compress_sw_queue queue;
+	struct spdk_reduce_vol_cb_args cb_arg;
+	struct ut_op_ctx ctx = {};
+
+	cb_arg.cb_fn = ut_op_done;
+	cb_arg.cb_arg = &ctx;
+
+	compress_sw_queue_init(&queue);
+	CU_ASSERT(compress_sw_queue_op(&queue, src_iovs, src_iovcnt, dst_iovs, dst_iovcnt, compress,
+				       COMPRESS_SW_DEFAULT_LEVEL, &cb_arg) == 0);
+	CU_ASSERT(compress_sw_queue_flush(&queue) == 1);
+	CU_ASSERT(STAILQ_EMPTY(&queue.ops));
+
+	ut_poll_workers();
+	CU_ASSERT(ctx.done);
+
+	return ctx.status;
+}
+
+static void
+test_sw_unavailable(void)
+{
+	struct compress_sw_queue queue;
+	struct spdk_reduce_vol_cb_args cb_arg = {};
+	struct iovec iov = {};
+
+	/* Nothing can be queued before the backend is initialized */
+	CU_ASSERT(!compress_sw_available());
+	compress_sw_queue_init(&queue);
+	CU_ASSERT(compress_sw_queue_op(&queue, &iov, 1, &iov, 1, true, COMPRESS_SW_DEFAULT_LEVEL,
+				       &cb_arg) == -ENOTSUP);
+	CU_ASSERT(queue.num_ops == 0);
+}
+
+#ifdef SPDK_CONFIG_ISAL
+static void
+ut_round_trip(void)
+{
+	uint8_t *data, *comp, *decomp;
+	struct iovec data_iov, comp_iovs[2], decomp_iovs[4];
+	int comp_len, rc, i;
+
+	data = calloc(1, UT_CHUNK_SIZE);
+	comp = calloc(1, UT_CHUNK_SIZE);
+	decomp = calloc(1, UT_CHUNK_SIZE);
+	SPDK_CU_ASSERT_FATAL(data != NULL && comp != NULL && decomp != NULL);
+
+	for (i = 0; i < UT_CHUNK_SIZE; i++) {
+		data[i] = 'a' + (i / 64) % 7;
+	}
+
+	data_iov.iov_base = data;
+	data_iov.iov_len = UT_CHUNK_SIZE;
+	comp_iovs[0].iov_base = comp;
+	comp_iovs[0].iov_len = UT_CHUNK_SIZE;
+
+	comp_len = ut_run_op(&data_iov, 1, comp_iovs, 1, true);
+	CU_ASSERT(comp_len > 0 && comp_len < UT_CHUNK_SIZE);
+
+	/* Decompress from two source iovs into four destination iovs, which goes through
+	 * the worker's gather and scatter buffers.
+	 */
+	comp_iovs[0].iov_len = comp_len / 2;
+	comp_iovs[1].iov_base = comp + comp_len / 2;
+	comp_iovs[1].iov_len = comp_len - comp_len / 2;
+	for (i = 0; i < 4; i++) {
+		decomp_iovs[i].iov_base = decomp + i * (UT_CHUNK_SIZE / 4);
+		decomp_iovs[i].iov_len = UT_CHUNK_SIZE / 4;
+	}
+
+	rc = ut_run_op(comp_iovs, 2, decomp_iovs, 4, false);
+	CU_ASSERT(rc == UT_CHUNK_SIZE);
+	CU_ASSERT(memcmp(data, decomp, UT_CHUNK_SIZE) == 0);
+
+	/* Compressing into multiple destination iovs gives the same result */
+	memset(decomp, 0, UT_CHUNK_SIZE);
+	rc = ut_run_op(&data_iov, 1, decomp_iovs, 4, true);
+	CU_ASSERT(rc == comp_len);
+	CU_ASSERT(memcmp(comp, decomp, comp_len) == 0);
+
+	/* Data that doesn't compress is reported as not fitting in the destination */
+	srand(0);
+	for (i = 0; i < UT_CHUNK_SIZE; i++) {
+		data[i] = rand();
+	}
+	comp_iovs[0].iov_len = UT_CHUNK_SIZE;
+	rc = ut_run_op(&data_iov, 1, comp_iovs, 1, true);
+	CU_ASSERT(rc == -ENOSPC);
+
+	/* Corrupted data cannot be decompressed */
+	memset(comp, 0xff, UT_CHUNK_SIZE);
+	rc = ut_run_op(comp_iovs, 1, &data_iov, 1, false);
+	CU_ASSERT(rc == -EIO);
+
+	/* Buffers larger than the chunk size are rejected */
+	data_iov.iov_len = UT_CHUNK_SIZE + 1;
+	rc = ut_run_op(&data_iov, 1, comp_iovs, 1, true);
+	CU_ASSERT(rc == -EINVAL);
+
+	free(data);
+	free(comp);
+	free(decomp);
+}
+
+static void
+test_sw_round_trip_inline(void)
+{
+	/* With a single core the ops run on the submitting thread */
+	CU_ASSERT(compress_sw_init(UT_CHUNK_SIZE) == 0);
+	CU_ASSERT(compress_sw_available());
+	CU_ASSERT(g_num_workers == 0);
+
+	ut_round_trip();
+
+	compress_sw_fini();
+	CU_ASSERT(!compress_sw_available());
+}
+
+static void
+test_sw_round_trip_workers(void)
+{
+	struct spdk_thread *threads[2];
+	uint32_t i;
+
+	free_cores();
+	allocate_cores(2);
+
+	CU_ASSERT(compress_sw_init(UT_CHUNK_SIZE) == 0);
+	CU_ASSERT(compress_sw_available());
+	SPDK_CU_ASSERT_FATAL(g_num_workers == 2);
+
+	ut_round_trip();
+
+	for (i = 0; i < 2; i++) {
+		threads[i] = g_workers[i]->thread;
+	}
+
+	/* The workers free their buffers and exit on their own threads */
+	compress_sw_fini();
+	for (i = 0; i < 2; i++) {
+		while (spdk_thread_poll(threads[i], 0, 0) > 0) {
+		}
+		CU_ASSERT(spdk_thread_is_exited(threads[i]));
+		spdk_thread_destroy(threads[i]);
+	}
+	set_thread(0);
+
+	free_cores();
+	allocate_cores(1);
+}
+#else
+static void
+test_sw_no_isal(void)
+{
+	/* igzip is required, so the backend stays unavailable */
+	CU_ASSERT(compress_sw_init(UT_CHUNK_SIZE) == 0);
+	CU_ASSERT(!compress_sw_available());
+	compress_sw_fini();
+}
+#endif
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	if (CU_initialize_registry() != CUE_SUCCESS) {
+		return CU_get_error();
+	}
+
+	suite = CU_add_suite("compress_sw", NULL, NULL);
+	if (suite == NULL) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	if (
+		CU_add_test(suite, "sw_unavailable", test_sw_unavailable) == NULL ||
+#ifdef SPDK_CONFIG_ISAL
+		CU_add_test(suite, "sw_round_trip_inline", test_sw_round_trip_inline) == NULL ||
+		CU_add_test(suite, "sw_round_trip_workers", test_sw_round_trip_workers) == NULL
+#else
+		CU_add_test(suite, "sw_no_isal", test_sw_no_isal) == NULL
+#endif
+	) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	allocate_cores(1);
+	allocate_threads(1);
+	set_thread(0);
+
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	num_failures = CU_get_number_of_failures();
+	CU_cleanup_registry();
+
+	free_threads();
+	free_cores();
+
+	return num_failures;
+}
@@ -138,6 +138,7 @@ mock_rte_lcore_count(void)
 }
 
 #include "bdev/crypto/vbdev_crypto.c"
+#include "bdev/crypto/vbdev_crypto_sw.c"
 
 /* SPDK stubs */
 DEFINE_STUB(spdk_bdev_queue_io_wait, int, (struct spdk_bdev *bdev, struct spdk_io_channel *ch,
@@ -236,10 +237,11 @@ rte_cryptodev_sym_get_private_session_size(uint8_t dev_id)
 	return (unsigned int)dev_id;
 }
 
+void *g_aux_buf = (void *)0xDEADBEEF;
 void
 spdk_bdev_io_get_aux_buf(struct spdk_bdev_io *bdev_io, spdk_bdev_io_get_aux_buf_cb cb)
 {
-	cb(g_io_ch, g_bdev_io, (void *)0xDEADBEEF);
+	cb(g_io_ch, g_bdev_io, g_aux_buf);
 }
 
 void
@@ -763,15 +765,17 @@ test_initdrivers(void)
 	CU_ASSERT(g_session_mp == NULL);
 	CU_ASSERT(g_session_mp_priv == NULL);
 
-	/* Test failure of DPDK dev init. */
-	MOCK_SET(rte_cryptodev_count, 2);
+	/* Failure of AESNI_MB vdev init is not fatal, CRYPTO_SW still works. */
+	g_aesni_mb_vdev = false;
 	MOCK_SET(rte_vdev_init, -1);
 	rc = vbdev_crypto_init_crypto_drivers();
-	CU_ASSERT(rc == -EINVAL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_aesni_mb_vdev == false);
 	CU_ASSERT(g_mbuf_mp == NULL);
 	CU_ASSERT(g_session_mp == NULL);
 	CU_ASSERT(g_session_mp_priv == NULL);
 	MOCK_SET(rte_vdev_init, 0);
+	MOCK_SET(rte_cryptodev_count, 2);
 
 	/* Can't create session pool. */
 	MOCK_SET(spdk_mempool_create, NULL);
@@ -1052,6 +1056,120 @@ test_assign_device_qp(void)
 	_clear_device_qp_lists();
 }
 
+static void
+test_sw_backend(void)
+{
+	uint8_t key[] = "0123456789123456";
+	uint8_t key2[] = "9012345678912345";
+	uint32_t du_size = 4096;
+	uint8_t *plain, *expected, *buf, *aux;
+	struct iovec iov;
+	struct bdev_names *name;
+	int rc, i;
+
+	/* data_unit_size is only accepted for CRYPTO_SW and must be a power of 2. */
+	rc = vbdev_crypto_insert_name("base", "sw0", AESNI_MB, "0123456789123456",
+				      AES_CBC, NULL, 4096);
+	CU_ASSERT(rc == -EINVAL);
+	rc = vbdev_crypto_insert_name("base", "sw0", CRYPTO_SW, "0123456789123456",
+				      AES_CBC, NULL, 1000);
+	CU_ASSERT(rc == -EINVAL);
+	rc = vbdev_crypto_insert_name("base", "sw0", CRYPTO_SW, "0123456789123456",
+				      AES_XTS, "9012345678912345", 4096);
+	CU_ASSERT(rc == 0);
+	name = TAILQ_FIRST(&g_bdev_names);
+	SPDK_CU_ASSERT_FATAL(name != NULL);
+	CU_ASSERT(name->data_unit_size == 4096);
+	TAILQ_REMOVE(&g_bdev_names, name, link);
+	free(name->bdev_name);
+	free(name->vbdev_name);
+	free(name->drv_name);
+	free(name->key);
+	free(name->key2);
+	free(name);
+
+	/* XTS with identical keys is rejected. */
+	rc = crypto_sw_ctx_init(&g_crypto_ch->sw_ctx, AES_XTS, key, key, du_size);
+	CU_ASSERT(rc == -EINVAL);
+
+	plain = calloc(1, 2 * du_size);
+	expected = calloc(1, 2 * du_size);
+	buf = calloc(1, 2 * du_size);
+	aux = calloc(1, 2 * du_size + 64);
+	SPDK_CU_ASSERT_FATAL(plain && expected && buf && aux);
+	for (i = 0; i < (int)(2 * du_size); i++) {
+		plain[i] = i * 7;
+	}
+
+	TAILQ_INIT(&g_crypto_ch->pending_cry_ios);
+	g_crypto_ch->device_qp = NULL;
+	MOCK_SET(spdk_bdev_writev_blocks, 0);
+	MOCK_SET(spdk_bdev_readv_blocks, 0);
+	g_crypto_bdev.sw_backend = true;
+	g_crypto_bdev.cipher = AES_XTS;
+	g_crypto_bdev.crypto_bdev.blocklen = du_size;
+	rc = crypto_sw_ctx_init(&g_crypto_ch->sw_ctx, AES_XTS, key, key2, du_size);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+
+	/* Reference: the two data units encrypted in one contiguous buffer. */
+	memcpy(expected, plain, 2 * du_size);
+	iov.iov_base = expected;
+	iov.iov_len = 2 * du_size;
+	rc = crypto_sw_crypt(&g_crypto_ch->sw_ctx, true, &iov, 1, NULL, 0, 10, 2 * du_size);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(memcmp(expected, plain, du_size) != 0);
+
+	/* Write with the 1st data unit split across IO vectors, encrypted into the aux buf. */
+	g_aux_buf = aux;
+	g_bdev_io->internal.status = SPDK_BDEV_IO_STATUS_SUCCESS;
+	g_bdev_io->type = SPDK_BDEV_IO_TYPE_WRITE;
+	g_bdev_io->u.bdev.iovcnt = 2;
+	g_bdev_io->u.bdev.offset_blocks = 10;
+	g_bdev_io->u.bdev.num_blocks = 2;
+	g_bdev_io->u.bdev.iovs[0].iov_base = plain;
+	g_bdev_io->u.bdev.iovs[0].iov_len = 1000;
+	g_bdev_io->u.bdev.iovs[1].iov_base = plain + 1000;
+	g_bdev_io->u.bdev.iovs[1].iov_len = 2 * du_size - 1000;
+	g_completion_called = false;
+	vbdev_crypto_submit_request(g_io_ch, g_bdev_io);
+	CU_ASSERT(g_completion_called == true);
+	CU_ASSERT(g_bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(g_io_ctx->aux_buf_iov.iov_len == 2 * du_size);
+	CU_ASSERT(memcmp(g_io_ctx->aux_buf_iov.iov_base, expected, 2 * du_size) == 0);
+	CU_ASSERT(TAILQ_EMPTY(&g_crypto_ch->pending_cry_ios));
+
+	/* Read the encrypted data back, split the other way, and decrypt it in place. */
+	memcpy(buf, expected, 2 * du_size);
+	g_bdev_io->internal.status = SPDK_BDEV_IO_STATUS_SUCCESS;
+	g_bdev_io->type = SPDK_BDEV_IO_TYPE_READ;
+	g_bdev_io->u.bdev.iovs[0].iov_base = buf;
+	g_bdev_io->u.bdev.iovs[0].iov_len = du_size + 512;
+	g_bdev_io->u.bdev.iovs[1].iov_base = buf + du_size + 512;
+	g_bdev_io->u.bdev.iovs[1].iov_len = du_size - 512;
+	g_completion_called = false;
+	vbdev_crypto_submit_request(g_io_ch, g_bdev_io);
+	CU_ASSERT(g_completion_called == true);
+	CU_ASSERT(g_bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(buf, plain, 2 * du_size) == 0);
+	CU_ASSERT(TAILQ_EMPTY(&g_crypto_ch->pending_cry_ios));
+
+	/* A length that isn't a whole number of data units fails the IO. */
+	g_bdev_io->internal.status = SPDK_BDEV_IO_STATUS_SUCCESS;
+	g_bdev_io->u.bdev.iovcnt = 1;
+	g_bdev_io->u.bdev.iovs[0].iov_len = 512;
+	g_crypto_bdev.crypto_bdev.blocklen = 512;
+	vbdev_crypto_submit_request(g_io_ch, g_bdev_io);
+	CU_ASSERT(g_bdev_io->internal.status == SPDK_BDEV_IO_STATUS_FAILED);
+
+	crypto_sw_ctx_fini(&g_crypto_ch->sw_ctx);
+	g_crypto_bdev.sw_backend = false;
+	g_aux_buf = (void *)0xDEADBEEF;
+	free(plain);
+	free(expected);
+	free(buf);
+	free(aux);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -1093,7 +1211,9 @@ main(int argc, char **argv)
 	    CU_add_test(suite, "test_poller",
 			test_poller) == NULL ||
 	    CU_add_test(suite, "test_assign_device_qp",
-			test_assign_device_qp) == NULL
+			test_assign_device_qp) == NULL ||
+	    CU_add_test(suite, "test_sw_backend",
+			test_sw_backend) == NULL
 	   ) {
 		CU_cleanup_registry();
 		return CU_get_error();
@@ -600,6 +600,75 @@ fs_delete_file_without_close(void)
 
 }
 
+static void
+direct_write(void)
+{
+	int rc;
+	char *w_buf, *r_buf;
+	uint64_t buf_length;
+	struct spdk_fs_thread_ctx *channel;
+	struct spdk_file_stat stat = {0};
+
+	ut_send_request(_fs_init, NULL);
+	channel = spdk_fs_alloc_thread_ctx(g_fs);
+
+	rc = spdk_fs_open_file(g_fs, channel, "testfile",
+			       SPDK_BLOBFS_OPEN_CREATE | SPDK_BLOBFS_OPEN_DIRECT, &g_file);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_file != NULL);
+	CU_ASSERT(g_file->direct_io == true);
+
+	buf_length = 2 * DIRECT_IO_WRITE_THRESHOLD;
+	w_buf = calloc(1, buf_length + 100);
+	r_buf = calloc(1, buf_length + 100);
+	SPDK_CU_ASSERT_FATAL(w_buf != NULL && r_buf != NULL);
+	memset(w_buf, 0x5a, buf_length / 2);
+	memset(w_buf + buf_length / 2, 0xa5, buf_length / 2 + 100);
+
+	/* Large aligned writes bypass the cache and go straight to the blob. */
+	rc = spdk_file_write(g_file, channel, w_buf, 0, buf_length / 2);
+	CU_ASSERT(rc == 0);
+	rc = spdk_file_write(g_file, channel, w_buf + buf_length / 2, buf_length / 2, buf_length / 2);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_file->last == NULL);
+	CU_ASSERT(g_file->append_pos == buf_length);
+	CU_ASSERT(g_file->length_flushed == buf_length);
+	CU_ASSERT(spdk_file_get_length(g_file) == buf_length);
+
+	/* A small tail write falls back to the regular path. */
+	rc = spdk_file_write(g_file, channel, w_buf + buf_length, buf_length, 100);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(spdk_file_get_length(g_file) == buf_length + 100);
+
+	rc = spdk_file_sync(g_file, channel);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_file->length_xattr == buf_length + 100);
+
+	spdk_file_close(g_file, channel);
+
+	rc = spdk_fs_file_stat(g_fs, channel, "testfile", &stat);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(stat.size == buf_length + 100);
+
+	rc = spdk_fs_open_file(g_fs, channel, "testfile", 0, &g_file);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_file != NULL);
+
+	rc = spdk_file_read(g_file, channel, r_buf, 0, buf_length + 100);
+	CU_ASSERT(rc == (int64_t)(buf_length + 100));
+	CU_ASSERT(memcmp(w_buf, r_buf, buf_length + 100) == 0);
+
+	spdk_file_close(g_file, channel);
+	rc = spdk_fs_delete_file(g_fs, channel, "testfile");
+	CU_ASSERT(rc == 0);
+
+	free(w_buf);
+	free(r_buf);
+	spdk_fs_free_thread_ctx(channel);
+
+	ut_send_request(_fs_unload, NULL);
+}
+
 static bool g_thread_exit = false;
 
 static void
@@ -648,7 +717,8 @@ int main(int argc, char **argv)
 		CU_add_test(suite, "create_sync", fs_create_sync) == NULL ||
 		CU_add_test(suite, "rename_sync", fs_rename_sync) == NULL ||
 		CU_add_test(suite, "append_no_cache", cache_append_no_cache) == NULL ||
-		CU_add_test(suite, "delete_file_without_close", fs_delete_file_without_close) == NULL
+		CU_add_test(suite, "delete_file_without_close", fs_delete_file_without_close) == NULL ||
+		CU_add_test(suite, "direct_write", direct_write) == NULL
 	) {
 		CU_cleanup_registry();
 		return CU_get_error();
@@ -39,6 +39,9 @@
 #include "event/subsystem.c"
 #include "common/lib/test_env.c"
 
+DEFINE_STUB_V(spdk_app_timeline_add, (const char *phase, const char *name, uint64_t start_tsc,
+				      uint32_t count));
+
 static struct spdk_subsystem g_ut_subsystems[8];
 static struct spdk_subsystem_depend g_ut_subsystem_deps[8];
 static int global_rc;
@@ -55,6 +58,7 @@ set_up_subsystem(struct spdk_subsystem *subsystem, const char *name)
 	subsystem->init = NULL;
 	subsystem->fini = NULL;
 	subsystem->config = NULL;
+	subsystem->concurrent_init = false;
 	subsystem->name = name;
 }
 
@@ -231,6 +235,118 @@ subsystem_sort_test_missing_dependency(void)
 
 }
 
+static bool g_ut_init_called[3];
+
+static void
+ut_init_0(void)
+{
+	g_ut_init_called[0] = true;
+}
+
+static void
+ut_init_1(void)
+{
+	g_ut_init_called[1] = true;
+}
+
+static void
+ut_init_2(void)
+{
+	g_ut_init_called[2] = true;
+}
+
+static void
+set_up_init_subsystems(bool concurrent_1)
+{
+	int i;
+
+	subsystem_clear();
+	memset(g_ut_init_called, 0, sizeof(g_ut_init_called));
+
+	set_up_subsystem(&g_ut_subsystems[0], "A");
+	set_up_subsystem(&g_ut_subsystems[1], "B");
+	set_up_subsystem(&g_ut_subsystems[2], "C");
+	g_ut_subsystems[0].init = ut_init_0;
+	g_ut_subsystems[1].init = ut_init_1;
+	g_ut_subsystems[2].init = ut_init_2;
+	g_ut_subsystems[0].concurrent_init = true;
+	g_ut_subsystems[1].concurrent_init = concurrent_1;
+	g_ut_subsystems[2].concurrent_init = true;
+
+	for (i = 0; i < 3; i++) {
+		spdk_add_subsystem(&g_ut_subsystems[i]);
+	}
+}
+
+static void
+subsystem_init_test_concurrent(void)
+{
+	/* A, B and C are concurrent and C depends on A */
+	set_up_init_subsystems(true);
+	set_up_depends(&g_ut_subsystem_deps[0], "C", "A");
+	spdk_add_subsystem_depend(&g_ut_subsystem_deps[0]);
+
+	global_rc = -1;
+	spdk_subsystem_init(ut_event_fn, NULL);
+	CU_ASSERT(g_ut_init_called[0] == true);
+	CU_ASSERT(g_ut_init_called[1] == true);
+	CU_ASSERT(g_ut_init_called[2] == false);
+
+	spdk_subsystem_init_done(&g_ut_subsystems[0], 0);
+	CU_ASSERT(g_ut_init_called[2] == true);
+	CU_ASSERT(global_rc == -1);
+
+	spdk_subsystem_init_done(&g_ut_subsystems[2], 0);
+	CU_ASSERT(global_rc == -1);
+	spdk_subsystem_init_done(&g_ut_subsystems[1], 0);
+	CU_ASSERT(global_rc == 0);
+}
+
+static void
+subsystem_init_test_serial(void)
+{
+	/* B is not concurrent, so it waits for A and C waits for it */
+	set_up_init_subsystems(false);
+
+	global_rc = -1;
+	spdk_subsystem_init(ut_event_fn, NULL);
+	CU_ASSERT(g_ut_init_called[0] == true);
+	CU_ASSERT(g_ut_init_called[1] == false);
+	CU_ASSERT(g_ut_init_called[2] == false);
+
+	spdk_subsystem_init_done(&g_ut_subsystems[0], 0);
+	CU_ASSERT(g_ut_init_called[1] == true);
+	CU_ASSERT(g_ut_init_called[2] == false);
+
+	spdk_subsystem_init_next(0);
+	CU_ASSERT(g_ut_init_called[2] == true);
+	CU_ASSERT(global_rc == -1);
+
+	spdk_subsystem_init_done(&g_ut_subsystems[2], 0);
+	CU_ASSERT(global_rc == 0);
+}
+
+static void
+subsystem_init_test_failure(void)
+{
+	set_up_init_subsystems(true);
+
+	global_rc = -1;
+	spdk_subsystem_init(ut_event_fn, NULL);
+	CU_ASSERT(g_ut_init_called[0] == true);
+	CU_ASSERT(g_ut_init_called[1] == true);
+	CU_ASSERT(g_ut_init_called[2] == true);
+
+	spdk_subsystem_init_done(&g_ut_subsystems[1], -EIO);
+	CU_ASSERT(global_rc == -EIO);
+
+	/* The failure is reported only once */
+	global_rc = -1;
+	spdk_subsystem_init_done(&g_ut_subsystems[0], 0);
+	spdk_subsystem_init_done(&g_ut_subsystems[2], 0);
+	CU_ASSERT(global_rc == -1);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -254,6 +370,12 @@ main(int argc, char **argv)
 			       subsystem_sort_test_depends_on_multiple) == NULL
 		|| CU_add_test(suite, "subsystem_sort_test_missing_dependency",
 			       subsystem_sort_test_missing_dependency) == NULL
+		|| CU_add_test(suite, "subsystem_init_test_concurrent",
+			       subsystem_init_test_concurrent) == NULL
+		|| CU_add_test(suite, "subsystem_init_test_serial",
+			       subsystem_init_test_serial) == NULL
+		|| CU_add_test(suite, "subsystem_init_test_failure",
+			       subsystem_init_test_failure) == NULL
 	) {
 		CU_cleanup_registry();
 		return CU_get_error();
@@ -77,6 +77,18 @@ DEFINE_STUB(spdk_bdev_get_block_size, uint32_t, (const struct spdk_bdev *bdev),
 DEFINE_STUB(ftl_band_validate_md, bool, (struct ftl_band *band), true);
 #endif
 DEFINE_STUB_V(ftl_trace_wbuf_fill, (struct spdk_ftl_dev *dev, const struct ftl_io *io));
+DEFINE_STUB(ftl_l2p_cache_init, struct ftl_l2p_cache *, (struct spdk_bdev_desc *desc,
+		struct spdk_thread *thread, uint64_t num_entries, size_t entry_size, size_t max_size),
+	    NULL);
+DEFINE_STUB_V(ftl_l2p_cache_free, (struct ftl_l2p_cache *cache));
+DEFINE_STUB(ftl_l2p_cache_pin, int, (struct ftl_l2p_cache *cache, uint64_t idx,
+				     struct ftl_l2p_cache_waiter *waiter, ftl_l2p_cache_fn cb_fn, void *cb_arg), 0);
+DEFINE_STUB_V(ftl_l2p_cache_unpin, (struct ftl_l2p_cache *cache, uint64_t idx));
+DEFINE_STUB(ftl_l2p_cache_get, int, (struct ftl_l2p_cache *cache, uint64_t idx, uint64_t *val), 0);
+DEFINE_STUB(ftl_l2p_cache_set, int, (struct ftl_l2p_cache *cache, uint64_t idx, uint64_t val), 0);
+DEFINE_STUB_V(ftl_l2p_cache_flush, (struct ftl_l2p_cache *cache, ftl_l2p_cache_fn cb_fn,
+				    void *cb_arg));
+DEFINE_STUB_V(ftl_l2p_cache_put_io_channel, (struct ftl_l2p_cache *cache));
 
 struct spdk_io_channel *
 spdk_bdev_get_io_channel(struct spdk_bdev_desc *bdev_desc)
@@ -123,6 +135,7 @@ setup_device(uint32_t num_threads, uint32_t xfer_size)
 
 	dev->conf = g_default_conf;
 	dev->xfer_size = xfer_size;
+	dev->num_streams = 1;
 	dev->base_bdev_desc = (struct spdk_bdev_desc *)0xdeadbeef;
 	spdk_io_device_register(dev->base_bdev_desc, channel_create_cb, channel_destroy_cb, 0, NULL);
 
@@ -147,6 +160,7 @@ free_device(struct spdk_ftl_dev *dev)
 
 	free(dev->ioch_array);
 	free(dev->iov_buf);
+	free(dev->heat.counters);
 	free(dev->ioch);
 	free(dev);
 }
@@ -859,7 +873,7 @@ test_submit_batch(void)
 
 		set_thread(ioch_idx);
 
-		batch = ftl_get_next_batch(dev);
+		batch = ftl_get_next_batch(dev, FTL_STREAM_HOT);
 		SPDK_CU_ASSERT_FATAL(batch != NULL);
 
 		TAILQ_FOREACH(entry, &batch->entries, tailq) {
@@ -873,7 +887,7 @@ test_submit_batch(void)
 	}
 
 	for (ioch_idx = 0; ioch_idx < num_io_channels - 1; ++ioch_idx) {
-		batch = ftl_get_next_batch(dev);
+		batch = ftl_get_next_batch(dev, FTL_STREAM_HOT);
 		SPDK_CU_ASSERT_FATAL(batch != NULL);
 		ftl_release_batch(dev, batch);
 	}
@@ -889,7 +903,7 @@ test_submit_batch(void)
 		CU_ASSERT(num_entries == 1);
 	}
 
-	batch = ftl_get_next_batch(dev);
+	batch = ftl_get_next_batch(dev, FTL_STREAM_HOT);
 	SPDK_CU_ASSERT_FATAL(batch != NULL);
 
 	ioch_bitmap = 0;
@@ -920,24 +934,24 @@ test_submit_batch(void)
 		}
 	}
 
-	batch = ftl_get_next_batch(dev);
+	batch = ftl_get_next_batch(dev, FTL_STREAM_HOT);
 	SPDK_CU_ASSERT_FATAL(batch != NULL);
 
 	TAILQ_INSERT_TAIL(&dev->pending_batches, batch, tailq);
-	batch2 = ftl_get_next_batch(dev);
+	batch2 = ftl_get_next_batch(dev, FTL_STREAM_HOT);
 	SPDK_CU_ASSERT_FATAL(batch2 != NULL);
 
 	CU_ASSERT(TAILQ_EMPTY(&dev->pending_batches));
 	CU_ASSERT(batch == batch2);
 
-	batch = ftl_get_next_batch(dev);
+	batch = ftl_get_next_batch(dev, FTL_STREAM_HOT);
 	SPDK_CU_ASSERT_FATAL(batch != NULL);
 
 	ftl_release_batch(dev, batch);
 	ftl_release_batch(dev, batch2);
 
 	for (ioch_idx = 2; ioch_idx < num_io_channels; ++ioch_idx) {
-		batch = ftl_get_next_batch(dev);
+		batch = ftl_get_next_batch(dev, FTL_STREAM_HOT);
 		SPDK_CU_ASSERT_FATAL(batch != NULL);
 		ftl_release_batch(dev, batch);
 	}
@@ -953,6 +967,157 @@ test_submit_batch(void)
 	free_device(dev);
 }
 
+static void
+test_write_heat(void)
+{
+	struct spdk_ftl_dev *dev;
+	uint64_t range, i;
+
+	dev = setup_device(1, 16);
+	dev->num_lbas = 64 << FTL_WRITE_HEAT_RANGE_SHIFT;
+	dev->conf.hot_cold_separation = true;
+
+	CU_ASSERT_EQUAL(ftl_dev_init_streams(dev), 0);
+	CU_ASSERT_EQUAL(dev->num_streams, FTL_STREAM_COUNT);
+	CU_ASSERT_EQUAL(dev->heat.num_ranges, 64);
+
+	/* Ranges written equally often are all considered cold */
+	for (range = 0; range < 16; ++range) {
+		CU_ASSERT_EQUAL(ftl_write_heat_update(dev, range << FTL_WRITE_HEAT_RANGE_SHIFT),
+				FTL_STREAM_COLD);
+	}
+
+	/* Ranges not written for a while shouldn't affect the classification */
+	for (range = 0; range < 16; ++range) {
+		CU_ASSERT_EQUAL(ftl_write_heat_update(dev, range << FTL_WRITE_HEAT_RANGE_SHIFT),
+				FTL_STREAM_COLD);
+	}
+
+	/* A range written much more often than the others becomes hot */
+	for (i = 0; i < 8; ++i) {
+		ftl_write_heat_update(dev, 0);
+	}
+	CU_ASSERT_EQUAL(ftl_write_heat_update(dev, 1), FTL_STREAM_HOT);
+	CU_ASSERT_EQUAL(ftl_write_heat_update(dev, 1 << FTL_WRITE_HEAT_RANGE_SHIFT),
+			FTL_STREAM_COLD);
+	CU_ASSERT_EQUAL(dev->heat.num_active, 16);
+
+	/* Check that the counters decay */
+	dev->heat.decay_interval = dev->heat.num_writes + 1;
+	ftl_write_heat_update(dev, 2 << FTL_WRITE_HEAT_RANGE_SHIFT);
+	CU_ASSERT_EQUAL(dev->heat.num_writes, 0);
+	CU_ASSERT_EQUAL(dev->heat.counters[0], 5);
+	CU_ASSERT_EQUAL(dev->heat.counters[1], 1);
+	CU_ASSERT_EQUAL(dev->heat.counters[2], 1);
+	CU_ASSERT_EQUAL(dev->heat.counters[3], 1);
+	CU_ASSERT_EQUAL(dev->heat.sum, 5 + 15);
+
+	free_device(dev);
+}
+
+static void
+test_submit_batch_streams(void)
+{
+	struct spdk_ftl_dev *dev;
+	struct spdk_io_channel *_ioch;
+	struct ftl_io_channel *ioch;
+	struct ftl_wbuf_entry *entry;
+	struct ftl_batch *batch[FTL_STREAM_COUNT];
+	uint64_t i, range;
+	size_t num_entries;
+	int stream;
+
+	dev = setup_device(1, 16);
+	dev->num_lbas = 64 << FTL_WRITE_HEAT_RANGE_SHIFT;
+	dev->conf.hot_cold_separation = true;
+	CU_ASSERT_EQUAL(ftl_dev_init_streams(dev), 0);
+
+	_ioch = spdk_get_io_channel(dev);
+	SPDK_CU_ASSERT_FATAL(_ioch != NULL);
+	ioch = ftl_io_channel_get_ctx(_ioch);
+	poll_threads();
+
+	/* Make the first range hot */
+	for (range = 0; range < 16; ++range) {
+		ftl_write_heat_update(dev, range << FTL_WRITE_HEAT_RANGE_SHIFT);
+	}
+	for (i = 0; i < 64; ++i) {
+		ftl_write_heat_update(dev, 0);
+	}
+
+	/* Interleave relocated, hot and cold entries */
+	for (i = 0; i < dev->xfer_size * FTL_STREAM_COUNT; ++i) {
+		switch (i % FTL_STREAM_COUNT) {
+		case FTL_STREAM_HOT:
+			entry = ftl_acquire_wbuf_entry(ioch, 0);
+			SPDK_CU_ASSERT_FATAL(entry != NULL);
+			entry->lba = i;
+			break;
+		case FTL_STREAM_COLD:
+			entry = ftl_acquire_wbuf_entry(ioch, 0);
+			SPDK_CU_ASSERT_FATAL(entry != NULL);
+			entry->lba = (1 + i % 15) << FTL_WRITE_HEAT_RANGE_SHIFT;
+			break;
+		default:
+			entry = ftl_acquire_wbuf_entry(ioch, FTL_IO_INTERNAL | FTL_IO_WEAK);
+			SPDK_CU_ASSERT_FATAL(entry != NULL);
+			entry->lba = 0;
+			break;
+		}
+
+		num_entries = spdk_ring_enqueue(ioch->submit_queue, (void **)&entry, 1, NULL);
+		CU_ASSERT(num_entries == 1);
+	}
+
+	/* Each stream should receive a full batch with its own entries only */
+	batch[FTL_STREAM_COLD] = ftl_get_next_batch(dev, FTL_STREAM_COLD);
+	SPDK_CU_ASSERT_FATAL(batch[FTL_STREAM_COLD] != NULL);
+
+	batch[FTL_STREAM_RELOC] = ftl_get_next_batch(dev, FTL_STREAM_RELOC);
+	SPDK_CU_ASSERT_FATAL(batch[FTL_STREAM_RELOC] != NULL);
+	batch[FTL_STREAM_HOT] = ftl_get_next_batch(dev, FTL_STREAM_HOT);
+	SPDK_CU_ASSERT_FATAL(batch[FTL_STREAM_HOT] != NULL);
+
+	CU_ASSERT(TAILQ_EMPTY(&dev->pending_batches));
+	for (stream = 0; stream < FTL_STREAM_COUNT; ++stream) {
+		CU_ASSERT_EQUAL(batch[stream]->stream, stream);
+		CU_ASSERT_EQUAL(batch[stream]->num_entries, dev->xfer_size);
+		CU_ASSERT_PTR_NULL(dev->current_batch[stream]);
+
+		TAILQ_FOREACH(entry, &batch[stream]->entries, tailq) {
+			CU_ASSERT_EQUAL(entry->stream, stream);
+			CU_ASSERT_EQUAL(!!(entry->io_flags & FTL_IO_WEAK), stream == FTL_STREAM_RELOC);
+		}
+
+		ftl_release_batch(dev, batch[stream]);
+	}
+
+	CU_ASSERT_PTR_NULL(ftl_get_next_batch(dev, FTL_STREAM_HOT));
+	CU_ASSERT_EQUAL(spdk_ring_count(ioch->free_queue), ioch->num_entries);
+
+	/* Partially filled batches are kept until they're filled up */
+	entry = ftl_acquire_wbuf_entry(ioch, FTL_IO_INTERNAL | FTL_IO_WEAK);
+	SPDK_CU_ASSERT_FATAL(entry != NULL);
+	spdk_ring_enqueue(ioch->submit_queue, (void **)&entry, 1, NULL);
+
+	CU_ASSERT_PTR_NULL(ftl_get_next_batch(dev, FTL_STREAM_HOT));
+	CU_ASSERT_PTR_NULL(dev->current_batch[FTL_STREAM_HOT]);
+	CU_ASSERT_PTR_NULL(dev->current_batch[FTL_STREAM_COLD]);
+	SPDK_CU_ASSERT_FATAL(dev->current_batch[FTL_STREAM_RELOC] != NULL);
+	CU_ASSERT_EQUAL(dev->current_batch[FTL_STREAM_RELOC]->num_entries, 1);
+	CU_ASSERT_EQUAL(ftl_stream_num_entries(dev, FTL_STREAM_RELOC), 1);
+	CU_ASSERT_TRUE(ftl_stream_has_data(dev, FTL_STREAM_RELOC));
+	CU_ASSERT_FALSE(ftl_stream_has_data(dev, FTL_STREAM_COLD));
+
+	ftl_release_batch(dev, dev->current_batch[FTL_STREAM_RELOC]);
+	dev->current_batch[FTL_STREAM_RELOC] = NULL;
+
+	spdk_put_io_channel(_ioch);
+	poll_threads();
+
+	free_device(dev);
+}
+
 static void
 test_entry_address(void)
 {
@@ -1066,6 +1231,10 @@ main(int argc, char **argv)
 			       test_io_channel_create) == NULL
 		|| CU_add_test(suite, "test_acquire_entry",
 			       test_acquire_entry) == NULL
+		|| CU_add_test(suite, "test_write_heat",
+			       test_write_heat) == NULL
+		|| CU_add_test(suite, "test_submit_batch_streams",
+			       test_submit_batch_streams) == NULL
 		|| CU_add_test(suite, "test_submit_batch",
 			       test_submit_batch) == NULL
 		|| CU_add_test(suite, "test_entry_address",
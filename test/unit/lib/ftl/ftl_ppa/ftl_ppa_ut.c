@@ -34,15 +34,158 @@
 #include "spdk/stdinc.h"
 
 #include "spdk_cunit.h"
-#include "common/lib/test_env.c"
+#include "common/lib/ut_multithread.c"
 
 #include "ftl/ftl_core.h"
+#include "ftl/ftl_l2p_cache.c"
 
-#define L2P_TABLE_SIZE 1024
+#define L2P_TABLE_SIZE 4096
+/* Number of l2p pages kept in memory by the paged suites */
+#define L2P_CACHE_NUM_PAGES 2
+/* Block size of the bdev backing the paged l2p */
+#define L2P_BDEV_BLOCK_SIZE 512
+#define L2P_BDEV_NUM_BLOCKS (L2P_TABLE_SIZE * sizeof(uint64_t) / L2P_BDEV_BLOCK_SIZE)
 
 static struct spdk_ftl_dev *g_dev;
+static char g_l2p_bdev_buf[L2P_BDEV_NUM_BLOCKS * L2P_BDEV_BLOCK_SIZE];
+static bool g_l2p_bdev_fail;
 
 DEFINE_STUB(spdk_bdev_desc_get_bdev, struct spdk_bdev *, (struct spdk_bdev_desc *desc), NULL);
+DEFINE_STUB(spdk_bdev_get_block_size, uint32_t, (const struct spdk_bdev *bdev),
+	    L2P_BDEV_BLOCK_SIZE);
+DEFINE_STUB(spdk_bdev_get_num_blocks, uint64_t, (const struct spdk_bdev *bdev),
+	    L2P_BDEV_NUM_BLOCKS);
+DEFINE_STUB(spdk_bdev_queue_io_wait, int, (struct spdk_bdev *bdev, struct spdk_io_channel *ch,
+		struct spdk_bdev_io_wait_entry *entry), 0);
+
+struct ut_bdev_io {
+	spdk_bdev_io_completion_cb	cb;
+	void				*cb_arg;
+	bool				success;
+};
+
+struct spdk_io_channel *
+spdk_bdev_get_io_channel(struct spdk_bdev_desc *desc)
+{
+	return spdk_get_io_channel(g_l2p_bdev_buf);
+}
+
+static void
+ut_bdev_io_complete(void *ctx)
+{
+	struct ut_bdev_io *io = ctx;
+
+	io->cb((struct spdk_bdev_io *)io, io->success, io->cb_arg);
+}
+
+static int
+ut_bdev_submit(void *buf, uint64_t offset_blocks, uint64_t num_blocks, bool write,
+	       spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	char *bdev_buf = g_l2p_bdev_buf + offset_blocks * L2P_BDEV_BLOCK_SIZE;
+	struct ut_bdev_io *io;
+
+	SPDK_CU_ASSERT_FATAL(offset_blocks + num_blocks <= L2P_BDEV_NUM_BLOCKS);
+
+	io = calloc(1, sizeof(*io));
+	SPDK_CU_ASSERT_FATAL(io != NULL);
+
+	io->cb = cb;
+	io->cb_arg = cb_arg;
+	io->success = !g_l2p_bdev_fail;
+
+	if (io->success) {
+		if (write) {
+			memcpy(bdev_buf, buf, num_blocks * L2P_BDEV_BLOCK_SIZE);
+		} else {
+			memcpy(buf, bdev_buf, num_blocks * L2P_BDEV_BLOCK_SIZE);
+		}
+	}
+
+	spdk_thread_send_msg(spdk_get_thread(), ut_bdev_io_complete, io);
+	return 0;
+}
+
+int
+spdk_bdev_read_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch, void *buf,
+		      uint64_t offset_blocks, uint64_t num_blocks, spdk_bdev_io_completion_cb cb,
+		      void *cb_arg)
+{
+	return ut_bdev_submit(buf, offset_blocks, num_blocks, false, cb, cb_arg);
+}
+
+int
+spdk_bdev_write_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch, void *buf,
+		       uint64_t offset_blocks, uint64_t num_blocks, spdk_bdev_io_completion_cb cb,
+		       void *cb_arg)
+{
+	return ut_bdev_submit(buf, offset_blocks, num_blocks, true, cb, cb_arg);
+}
+
+void
+spdk_bdev_free_io(struct spdk_bdev_io *bdev_io)
+{
+	free(bdev_io);
+}
+
+static int
+ut_io_channel_create_cb(void *io_device, void *ctx)
+{
+	return 0;
+}
+
+static void
+ut_io_channel_destroy_cb(void *io_device, void *ctx)
+{
+}
+
+static void
+ut_l2p_waiter_cb(void *ctx, int status)
+{
+	*(int *)ctx = status;
+}
+
+/* Pins the entry's l2p page, waiting for it to be loaded if necessary */
+static int
+ut_l2p_pin(uint64_t lba)
+{
+	struct ftl_l2p_cache_waiter waiter;
+	int rc, status;
+
+	while (true) {
+		status = 1;
+		rc = ftl_l2p_pin(g_dev, lba, &waiter, ut_l2p_waiter_cb, &status);
+		if (rc != -EAGAIN) {
+			return rc;
+		}
+
+		poll_threads();
+		SPDK_CU_ASSERT_FATAL(status != 1);
+		if (status != 0) {
+			return status;
+		}
+	}
+}
+
+static void
+ut_l2p_set(uint64_t lba, struct ftl_addr addr)
+{
+	SPDK_CU_ASSERT_FATAL(ut_l2p_pin(lba) == 0);
+	ftl_l2p_set(g_dev, lba, addr);
+	ftl_l2p_unpin(g_dev, lba);
+}
+
+static struct ftl_addr
+ut_l2p_get(uint64_t lba)
+{
+	struct ftl_addr addr;
+
+	SPDK_CU_ASSERT_FATAL(ut_l2p_pin(lba) == 0);
+	addr = ftl_l2p_get(g_dev, lba);
+	ftl_l2p_unpin(g_dev, lba);
+
+	return addr;
+}
 
 uint64_t
 spdk_bdev_get_zone_size(const struct spdk_bdev *bdev)
@@ -89,11 +232,68 @@ setup_l2p_64bit(void)
 	return 0;
 }
 
+static void
+setup_l2p_cache(size_t size, bool zero)
+{
+	size_t i;
+
+	g_l2p_bdev_fail = false;
+	g_dev->l2p_cache = ftl_l2p_cache_init((struct spdk_bdev_desc *)0xdeadbeef, spdk_get_thread(),
+					      g_dev->num_lbas, size,
+					      L2P_CACHE_NUM_PAGES * FTL_BLOCK_SIZE);
+	SPDK_CU_ASSERT_FATAL(g_dev->l2p_cache != NULL);
+
+	/* Match the contents of the DRAM tables allocated by the other suites */
+	for (i = 0; zero && i < g_dev->num_lbas; ++i) {
+		ut_l2p_set(i, ftl_to_addr(0));
+	}
+}
+
+static void
+free_l2p_cache(void)
+{
+	if (!g_dev->l2p_cache) {
+		return;
+	}
+
+	ftl_l2p_cache_put_io_channel(g_dev->l2p_cache);
+	poll_threads();
+	ftl_l2p_cache_free(g_dev->l2p_cache);
+	g_dev->l2p_cache = NULL;
+}
+
+static int
+setup_l2p_32bit_paged(void)
+{
+	g_dev = calloc(1, sizeof(*g_dev));
+	g_dev->num_lbas = L2P_TABLE_SIZE;
+	g_dev->addr_len = 24;
+	setup_l2p_cache(sizeof(uint32_t), true);
+	return 0;
+}
+
+static int
+setup_l2p_64bit_paged(void)
+{
+	g_dev = calloc(1, sizeof(*g_dev));
+	g_dev->num_lbas = L2P_TABLE_SIZE;
+	g_dev->addr_len = 63;
+	setup_l2p_cache(sizeof(uint64_t), true);
+	return 0;
+}
+
 static void
 clean_l2p(void)
 {
 	size_t l2p_elem_size;
 
+	if (g_dev->l2p_cache) {
+		l2p_elem_size = g_dev->l2p_cache->entry_size;
+		free_l2p_cache();
+		setup_l2p_cache(l2p_elem_size, true);
+		return;
+	}
+
 	if (ftl_addr_packed(g_dev)) {
 		l2p_elem_size = sizeof(uint32_t);
 	} else {
@@ -105,6 +305,7 @@ clean_l2p(void)
 static int
 cleanup(void)
 {
+	free_l2p_cache();
 	free(g_dev->l2p);
 	free(g_dev);
 	g_dev = NULL;
@@ -153,12 +354,12 @@ test_addr_invalid(void)
 
 	/* Set every other LBA as invalid */
 	for (i = 0; i < L2P_TABLE_SIZE; i += 2) {
-		ftl_l2p_set(g_dev, i, ftl_to_addr(FTL_ADDR_INVALID));
+		ut_l2p_set(i, ftl_to_addr(FTL_ADDR_INVALID));
 	}
 
 	/* Check every even LBA is invalid while others are fine */
 	for (i = 0; i < L2P_TABLE_SIZE; ++i) {
-		addr = ftl_l2p_get(g_dev, i);
+		addr = ut_l2p_get(i);
 
 		if (i % 2 == 0) {
 			CU_ASSERT_TRUE(ftl_addr_invalid(addr));
@@ -179,12 +380,12 @@ test_addr_cached(void)
 	for (i = 0; i < L2P_TABLE_SIZE; i += 2) {
 		addr.cached = 1;
 		addr.cache_offset = i;
-		ftl_l2p_set(g_dev, i, addr);
+		ut_l2p_set(i, addr);
 	}
 
 	/* Check every even LBA is cached while others are not */
 	for (i = 0; i < L2P_TABLE_SIZE; ++i) {
-		addr = ftl_l2p_get(g_dev, i);
+		addr = ut_l2p_get(i);
 
 		if (i % 2 == 0) {
 			CU_ASSERT_TRUE(ftl_addr_cached(addr));
@@ -196,16 +397,162 @@ test_addr_cached(void)
 	clean_l2p();
 }
 
+static void
+test_addr_paged(void)
+{
+	struct ftl_l2p_cache_waiter waiter;
+	struct ftl_l2p_cache_stats stats;
+	struct ftl_addr addr;
+	uint64_t entries_per_page, val;
+	int status;
+	size_t i;
+
+	/* Entries that were never set are invalid */
+	i = g_dev->l2p_cache->entry_size;
+	free_l2p_cache();
+	setup_l2p_cache(i, false);
+	entries_per_page = g_dev->l2p_cache->entries_per_page;
+	addr = ut_l2p_get(L2P_TABLE_SIZE - 1);
+	CU_ASSERT_TRUE(ftl_addr_invalid(addr));
+
+	/* Accessing an entry that isn't resident waits for its page to be loaded */
+	CU_ASSERT_EQUAL(ftl_l2p_try_get(g_dev, 0, &addr), -EAGAIN);
+	status = 1;
+	CU_ASSERT_EQUAL(ftl_l2p_pin(g_dev, 0, &waiter, ut_l2p_waiter_cb, &status), -EAGAIN);
+	CU_ASSERT_EQUAL(status, 1);
+	poll_threads();
+	CU_ASSERT_EQUAL(status, 0);
+	CU_ASSERT_EQUAL(ftl_l2p_try_get(g_dev, 0, &addr), 0);
+
+	/* Fill the whole table, forcing the pages to be evicted and written back */
+	for (i = 0; i < L2P_TABLE_SIZE; ++i) {
+		ut_l2p_set(i, ftl_to_addr(i));
+	}
+
+	CU_ASSERT_EQUAL(ftl_l2p_cache_num_resident(g_dev->l2p_cache), L2P_CACHE_NUM_PAGES);
+	ftl_l2p_cache_get_stats(g_dev->l2p_cache, &stats);
+	CU_ASSERT(stats.evictions > 0);
+	CU_ASSERT(stats.writebacks > 0);
+
+	/* Verify the evicted pages are loaded back correctly */
+	for (i = 0; i < L2P_TABLE_SIZE; ++i) {
+		addr = ut_l2p_get(i);
+		CU_ASSERT_EQUAL(addr.offset, i);
+	}
+
+	/* Resident pages are accessed without taking the cache's lock */
+	pthread_mutex_lock(&g_dev->l2p_cache->lock);
+	CU_ASSERT_EQUAL(ftl_l2p_pin(g_dev, L2P_TABLE_SIZE - 1, &waiter, ut_l2p_waiter_cb,
+				    &status), 0);
+	CU_ASSERT_EQUAL(ftl_l2p_cache_get(g_dev->l2p_cache, L2P_TABLE_SIZE - 1, &val), 0);
+	CU_ASSERT_EQUAL(val, L2P_TABLE_SIZE - 1);
+	CU_ASSERT_EQUAL(ftl_l2p_cache_set(g_dev->l2p_cache, L2P_TABLE_SIZE - 1, val), 0);
+	pthread_mutex_unlock(&g_dev->l2p_cache->lock);
+	ftl_l2p_unpin(g_dev, L2P_TABLE_SIZE - 1);
+
+	/* Entries whose page isn't resident cannot be accessed */
+	CU_ASSERT_EQUAL(ftl_l2p_cache_get(g_dev->l2p_cache, 0, &val), -EAGAIN);
+	CU_ASSERT_EQUAL(ftl_l2p_cache_set(g_dev->l2p_cache, 0, 0), -EAGAIN);
+
+	/* Pinned pages are never evicted, so the request has to wait for one to be unpinned */
+	CU_ASSERT_EQUAL(ut_l2p_pin(0), 0);
+	CU_ASSERT_EQUAL(ut_l2p_pin(entries_per_page), 0);
+	status = 1;
+	CU_ASSERT_EQUAL(ftl_l2p_pin(g_dev, 2 * entries_per_page, &waiter, ut_l2p_waiter_cb,
+				    &status), -EAGAIN);
+	poll_threads();
+	CU_ASSERT_EQUAL(status, 1);
+	ftl_l2p_unpin(g_dev, 0);
+	poll_threads();
+	CU_ASSERT_EQUAL(status, 0);
+	CU_ASSERT_EQUAL(ut_l2p_pin(2 * entries_per_page), 0);
+	CU_ASSERT_EQUAL(ftl_l2p_try_get(g_dev, 0, &addr), -EAGAIN);
+	ftl_l2p_unpin(g_dev, entries_per_page);
+	ftl_l2p_unpin(g_dev, 2 * entries_per_page);
+
+	/* Modified pages are written back on flush */
+	ut_l2p_set(2 * entries_per_page, ftl_to_addr(0));
+	ftl_l2p_cache_get_stats(g_dev->l2p_cache, &stats);
+	status = 1;
+	ftl_l2p_cache_flush(g_dev->l2p_cache, ut_l2p_waiter_cb, &status);
+	poll_threads();
+	CU_ASSERT_EQUAL(status, 0);
+	CU_ASSERT_EQUAL(g_dev->l2p_cache->stats.writebacks, stats.writebacks + 1);
+	clean_l2p();
+}
+
+static void
+test_addr_paged_error(void)
+{
+	struct ftl_l2p_cache_waiter waiter;
+	struct ftl_addr addr;
+	uint64_t entries_per_page = g_dev->l2p_cache->entries_per_page;
+	int status;
+	size_t i;
+
+	/* Make sure all of the pages are persisted on the bdev */
+	for (i = 0; i < L2P_TABLE_SIZE; ++i) {
+		ut_l2p_set(i, ftl_to_addr(i));
+	}
+
+	status = 1;
+	ftl_l2p_cache_flush(g_dev->l2p_cache, ut_l2p_waiter_cb, &status);
+	poll_threads();
+	CU_ASSERT_EQUAL(status, 0);
+
+	/* A page that cannot be read fails the requests waiting for it */
+	CU_ASSERT_EQUAL(ftl_l2p_try_get(g_dev, 0, &addr), -EAGAIN);
+	g_l2p_bdev_fail = true;
+	status = 1;
+	CU_ASSERT_EQUAL(ftl_l2p_pin(g_dev, 0, &waiter, ut_l2p_waiter_cb, &status), -EAGAIN);
+	poll_threads();
+	CU_ASSERT_EQUAL(status, -EIO);
+	CU_ASSERT_EQUAL(ftl_l2p_try_get(g_dev, 0, &addr), -EAGAIN);
+	CU_ASSERT_EQUAL(ftl_l2p_cache_num_resident(g_dev->l2p_cache), L2P_CACHE_NUM_PAGES - 1);
+
+	/* Once a dirty page cannot be written back, no other pages are loaded */
+	g_l2p_bdev_fail = false;
+	ut_l2p_set(0, ftl_to_addr(0));
+	ut_l2p_set(entries_per_page, ftl_to_addr(0));
+	g_l2p_bdev_fail = true;
+	status = 1;
+	CU_ASSERT_EQUAL(ftl_l2p_pin(g_dev, 2 * entries_per_page, &waiter, ut_l2p_waiter_cb,
+				    &status), -EAGAIN);
+	poll_threads();
+	CU_ASSERT_EQUAL(status, -EIO);
+	CU_ASSERT_EQUAL(ftl_l2p_pin(g_dev, 2 * entries_per_page, &waiter, ut_l2p_waiter_cb,
+				    &status), -EIO);
+
+	/* The pages that weren't written back stay resident */
+	addr = ut_l2p_get(0);
+	CU_ASSERT_EQUAL(addr.offset, 0);
+
+	/* The failure is reported by the flush as well */
+	status = 1;
+	ftl_l2p_cache_flush(g_dev->l2p_cache, ut_l2p_waiter_cb, &status);
+	poll_threads();
+	CU_ASSERT_EQUAL(status, -EIO);
+
+	g_l2p_bdev_fail = false;
+	clean_l2p();
+}
+
 int
 main(int argc, char **argv)
 {
 	CU_pSuite suite32 = NULL, suite64 = NULL;
+	CU_pSuite suite32_paged = NULL, suite64_paged = NULL;
 	unsigned int num_failures;
 
 	if (CU_initialize_registry() != CUE_SUCCESS) {
 		return CU_get_error();
 	}
 
+	allocate_threads(1);
+	set_thread(0);
+	spdk_io_device_register(g_l2p_bdev_buf, ut_io_channel_create_cb, ut_io_channel_destroy_cb,
+				0, NULL);
+
 	suite32 = CU_add_suite("ftl_addr32_suite", setup_l2p_32bit, cleanup);
 	if (!suite32) {
 		CU_cleanup_registry();
@@ -218,6 +565,18 @@ main(int argc, char **argv)
 		return CU_get_error();
 	}
 
+	suite32_paged = CU_add_suite("ftl_addr32_paged_suite", setup_l2p_32bit_paged, cleanup);
+	if (!suite32_paged) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	suite64_paged = CU_add_suite("ftl_addr64_paged_suite", setup_l2p_64bit_paged, cleanup);
+	if (!suite64_paged) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
 	if (
 		CU_add_test(suite32, "test_addr_pack",
 			    test_addr_pack32) == NULL
@@ -229,6 +588,22 @@ main(int argc, char **argv)
 			       test_addr_invalid) == NULL
 		|| CU_add_test(suite64, "test_addr64_cached",
 			       test_addr_cached) == NULL
+		|| CU_add_test(suite32_paged, "test_addr32_paged_invalid",
+			       test_addr_invalid) == NULL
+		|| CU_add_test(suite32_paged, "test_addr32_paged_cached",
+			       test_addr_cached) == NULL
+		|| CU_add_test(suite32_paged, "test_addr32_paged",
+			       test_addr_paged) == NULL
+		|| CU_add_test(suite32_paged, "test_addr32_paged_error",
+			       test_addr_paged_error) == NULL
+		|| CU_add_test(suite64_paged, "test_addr64_paged_invalid",
+			       test_addr_invalid) == NULL
+		|| CU_add_test(suite64_paged, "test_addr64_paged_cached",
+			       test_addr_cached) == NULL
+		|| CU_add_test(suite64_paged, "test_addr64_paged",
+			       test_addr_paged) == NULL
+		|| CU_add_test(suite64_paged, "test_addr64_paged_error",
+			       test_addr_paged_error) == NULL
 	) {
 		CU_cleanup_registry();
 		return CU_get_error();
@@ -239,5 +614,8 @@ main(int argc, char **argv)
 	num_failures = CU_get_number_of_failures();
 	CU_cleanup_registry();
 
+	spdk_io_device_unregister(g_l2p_bdev_buf, NULL);
+	free_threads();
+
 	return num_failures;
 }
@@ -158,7 +158,7 @@ test_wptr(void)
 	setup_wptr_test(&dev, &g_geo);
 
 	xfer_size = dev->xfer_size;
-	ftl_add_wptr(dev);
+	ftl_add_wptr(dev, FTL_STREAM_HOT);
 	for (i = 0; i < ftl_get_num_bands(dev); ++i) {
 		wptr = LIST_FIRST(&dev->wptr_list);
 		band = wptr->band;
@@ -185,7 +185,7 @@ test_wptr(void)
 		CU_ASSERT_EQUAL(band->state, FTL_BAND_STATE_CLOSED);
 		CU_ASSERT_TRUE(LIST_EMPTY(&dev->wptr_list));
 
-		rc = ftl_add_wptr(dev);
+		rc = ftl_add_wptr(dev, FTL_STREAM_HOT);
 
 		/* There are no free bands during the last iteration, so */
 		/* there'll be no new wptr allocation */
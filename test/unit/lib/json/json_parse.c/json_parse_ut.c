@@ -239,6 +239,105 @@ test_parse_string_control_chars(void)
 	STR_FAIL("abc\tdef", SPDK_JSON_PARSE_INVALID);
 }
 
+static void
+test_parse_string_long(void)
+{
+	uint8_t expected[64];
+	size_t len = 48, pos, i;
+	ssize_t rc;
+
+	/* Put each kind of special character at every position of a string longer than one SIMD block */
+	for (pos = 0; pos < len - 2; pos++) {
+		/* Two character escape */
+		memset(g_buf, 'a', sizeof(g_buf));
+		memset(expected, 'a', sizeof(expected));
+		g_buf[0] = '"';
+		g_buf[1 + pos] = '\\';
+		g_buf[2 + pos] = 'n';
+		g_buf[1 + len] = '"';
+		expected[pos] = '\n';
+		rc = spdk_json_parse(g_buf, len + 2, g_vals, sizeof(g_vals) / sizeof(g_vals[0]), &g_end,
+				     SPDK_JSON_PARSE_FLAG_DECODE_IN_PLACE);
+		CU_ASSERT(rc == 1);
+		CU_ASSERT(g_end == g_buf + len + 2);
+		CU_ASSERT(g_vals[0].type == SPDK_JSON_VAL_STRING);
+		CU_ASSERT(g_vals[0].len == len - 1);
+		CU_ASSERT(memcmp(g_vals[0].start, expected, len - 1) == 0);
+
+		/* Two byte UTF-8 sequence (U+00E9) */
+		memset(g_buf, 'a', sizeof(g_buf));
+		g_buf[0] = '"';
+		g_buf[1 + pos] = 0xC3;
+		g_buf[2 + pos] = 0xA9;
+		g_buf[1 + len] = '"';
+		rc = spdk_json_parse(g_buf, len + 2, g_vals, sizeof(g_vals) / sizeof(g_vals[0]), &g_end, 0);
+		CU_ASSERT(rc == 1);
+		CU_ASSERT(g_vals[0].len == len);
+
+		/* Control character must be reported at its position */
+		memset(g_buf, 'a', sizeof(g_buf));
+		g_buf[0] = '"';
+		g_buf[1 + pos] = '\t';
+		g_buf[1 + len] = '"';
+		rc = spdk_json_parse(g_buf, len + 2, NULL, 0, &g_end, 0);
+		CU_ASSERT(rc == SPDK_JSON_PARSE_INVALID);
+		CU_ASSERT(g_end == g_buf + 1 + pos);
+
+		/* Invalid UTF-8 (continuation byte without a lead byte) */
+		memset(g_buf, 'a', sizeof(g_buf));
+		g_buf[0] = '"';
+		g_buf[1 + pos] = 0x80;
+		g_buf[1 + len] = '"';
+		rc = spdk_json_parse(g_buf, len + 2, NULL, 0, &g_end, 0);
+		CU_ASSERT(rc == SPDK_JSON_PARSE_INVALID);
+		CU_ASSERT(g_end == g_buf + 1 + pos);
+
+		/* String ends early */
+		memset(g_buf, 'a', sizeof(g_buf));
+		g_buf[0] = '"';
+		g_buf[1 + pos] = '"';
+		rc = spdk_json_parse(g_buf, len + 2, g_vals, sizeof(g_vals) / sizeof(g_vals[0]), &g_end, 0);
+		CU_ASSERT(rc == 1);
+		CU_ASSERT(g_vals[0].len == pos);
+		CU_ASSERT(g_end == g_buf + 2 + pos);
+
+		/* Unterminated string */
+		rc = spdk_json_parse(g_buf, 2 + pos, NULL, 0, &g_end, 0);
+		CU_ASSERT(rc == 1);
+		g_buf[1 + pos] = 'a';
+		rc = spdk_json_parse(g_buf, 2 + pos, NULL, 0, &g_end, 0);
+		CU_ASSERT(rc == SPDK_JSON_PARSE_INCOMPLETE);
+		CU_ASSERT(g_end == g_buf + 2 + pos);
+	}
+
+	/* Whitespace runs of every length around values */
+	for (pos = 0; pos < 40; pos++) {
+		static const char ws[] = " \t\r\n";
+		size_t off = 0;
+
+		memset(g_buf, 0, sizeof(g_buf));
+		g_buf[off++] = '[';
+		for (i = 0; i < pos; i++) {
+			g_buf[off++] = ws[i % 4];
+		}
+		g_buf[off++] = '1';
+		for (i = 0; i < pos; i++) {
+			g_buf[off++] = ws[(i + 1) % 4];
+		}
+		g_buf[off++] = ']';
+		for (i = 0; i < pos; i++) {
+			g_buf[off++] = ws[(i + 2) % 4];
+		}
+		g_buf[off] = 'x';
+
+		rc = spdk_json_parse(g_buf, off + 1, g_vals, sizeof(g_vals) / sizeof(g_vals[0]), &g_end, 0);
+		CU_ASSERT(rc == 3);
+		CU_ASSERT(g_end == g_buf + off);
+		CU_ASSERT(g_vals[1].type == SPDK_JSON_VAL_NUMBER);
+		CU_ASSERT(g_vals[1].start == g_buf + 1 + pos);
+	}
+}
+
 static void
 test_parse_string_utf8(void)
 {
@@ -917,6 +1016,7 @@ int main(int argc, char **argv)
 		CU_add_test(suite, "parse_literal", test_parse_literal) == NULL ||
 		CU_add_test(suite, "parse_string_simple", test_parse_string_simple) == NULL ||
 		CU_add_test(suite, "parse_string_control_chars", test_parse_string_control_chars) == NULL ||
+		CU_add_test(suite, "parse_string_long", test_parse_string_long) == NULL ||
 		CU_add_test(suite, "parse_string_utf8", test_parse_string_utf8) == NULL ||
 		CU_add_test(suite, "parse_string_escapes_twochar", test_parse_string_escapes_twochar) == NULL ||
 		CU_add_test(suite, "parse_string_escapes_unicode", test_parse_string_escapes_unicode) == NULL ||
@@ -320,6 +320,86 @@ test_decode_array(void)
 	free(my_string[1]);
 }
 
+struct arena_object {
+	char *name;
+	char *tags[2];
+	size_t num_tags;
+	uint32_t size;
+};
+
+static int
+decode_arena_tags(const struct spdk_json_val *val, void *out)
+{
+	struct arena_object *obj = SPDK_CONTAINEROF(out, struct arena_object, tags);
+
+	return spdk_json_decode_array(val, spdk_json_decode_string, obj->tags, 2, &obj->num_tags,
+				      sizeof(char *));
+}
+
+static void
+test_decode_object_arena(void)
+{
+	char json[] = "{\"name\": \"a_name_longer_than_one_chunk\", \"tags\": [\"a\", \"bb\"], \"size\": 7}";
+	struct spdk_json_object_decoder decoders[] = {
+		{"name", offsetof(struct arena_object, name), spdk_json_decode_string},
+		{"tags", offsetof(struct arena_object, tags), decode_arena_tags},
+		{"size", offsetof(struct arena_object, size), spdk_json_decode_uint32},
+	};
+	struct spdk_json_val values[16];
+	struct arena_object obj = {};
+	struct spdk_json_arena *arena;
+	struct spdk_json_arena_chunk *chunk;
+	char *name = NULL;
+	void *buf;
+
+	CU_ASSERT(spdk_json_parse(json, sizeof(json) - 1, values, SPDK_COUNTOF(values), NULL, 0) == 11);
+
+	arena = spdk_json_arena_create(16);
+	SPDK_CU_ASSERT_FATAL(arena != NULL);
+
+	/* Strings, including the ones decoded by nested decoders, come from the arena */
+	CU_ASSERT(spdk_json_decode_object_arena(values, decoders, SPDK_COUNTOF(decoders), &obj, arena) == 0);
+	SPDK_CU_ASSERT_FATAL(obj.name != NULL);
+	CU_ASSERT(strcmp(obj.name, "a_name_longer_than_one_chunk") == 0);
+	CU_ASSERT(obj.num_tags == 2);
+	SPDK_CU_ASSERT_FATAL(obj.tags[0] != NULL && obj.tags[1] != NULL);
+	CU_ASSERT(strcmp(obj.tags[0], "a") == 0);
+	CU_ASSERT(strcmp(obj.tags[1], "bb") == 0);
+	CU_ASSERT(obj.size == 7);
+	CU_ASSERT(t_decode_arena == NULL);
+
+	/* The long name got a chunk of its own, the short tags share one */
+	chunk = arena->head;
+	SPDK_CU_ASSERT_FATAL(chunk != NULL);
+	CU_ASSERT(chunk->size == 32);
+	CU_ASSERT((uint8_t *)obj.name == chunk->data);
+	SPDK_CU_ASSERT_FATAL(chunk->next != NULL);
+	CU_ASSERT((uint8_t *)obj.tags[0] == chunk->next->data);
+	CU_ASSERT((uint8_t *)obj.tags[1] == chunk->next->data + 8);
+	CU_ASSERT(chunk->next->next == NULL);
+
+	/* Decoding again after a reset reuses the same memory */
+	spdk_json_arena_reset(arena);
+	memset(&obj, 0, sizeof(obj));
+	CU_ASSERT(spdk_json_decode_object_arena(values, decoders, SPDK_COUNTOF(decoders), &obj, arena) == 0);
+	CU_ASSERT((uint8_t *)obj.name == arena->head->data);
+	CU_ASSERT(arena->head->next->next == NULL);
+
+	/* Allocations are 8-byte aligned */
+	buf = spdk_json_arena_alloc(arena, 3);
+	CU_ASSERT(((uintptr_t)buf & 7) == 0);
+	buf = spdk_json_arena_alloc(arena, 1);
+	CU_ASSERT(((uintptr_t)buf & 7) == 0);
+
+	/* Outside of spdk_json_decode_object_arena() strings are allocated with malloc() again */
+	CU_ASSERT(spdk_json_decode_string(&values[2], &name) == 0);
+	SPDK_CU_ASSERT_FATAL(name != NULL);
+	CU_ASSERT(strcmp(name, "a_name_longer_than_one_chunk") == 0);
+	free(name);
+
+	spdk_json_arena_free(arena);
+}
+
 static void
 test_decode_bool(void)
 {
@@ -940,6 +1020,7 @@ int main(int argc, char **argv)
 		CU_add_test(suite, "num_to_uint64", test_num_to_uint64) == NULL ||
 		CU_add_test(suite, "decode_object", test_decode_object) == NULL ||
 		CU_add_test(suite, "decode_array", test_decode_array) == NULL ||
+		CU_add_test(suite, "decode_object_arena", test_decode_object_arena) == NULL ||
 		CU_add_test(suite, "decode_bool", test_decode_bool) == NULL ||
 		CU_add_test(suite, "decode_uint16", test_decode_uint16) == NULL ||
 		CU_add_test(suite, "decode_int32", test_decode_int32) == NULL ||
@@ -185,9 +185,12 @@ spdk_jsonrpc_server_handle_request(struct spdk_jsonrpc_request *request,
 	ut_handle(request, 0, method, params);
 }
 
+static struct spdk_jsonrpc_request *g_sent_request;
+
 void
 spdk_jsonrpc_server_send_response(struct spdk_jsonrpc_request *request)
 {
+	g_sent_request = request;
 }
 
 static void
@@ -384,6 +387,114 @@ test_parse_request_streaming(void)
 	free(server);
 }
 
+static size_t
+ut_consume_response(struct spdk_jsonrpc_request *request, char *buf, size_t offset, size_t size)
+{
+	size_t len = request->send_len;
+
+	SPDK_CU_ASSERT_FATAL(offset + len <= size);
+	memcpy(buf + offset, request->send_buf + request->send_offset, len);
+	request->send_offset += len;
+	request->send_len = 0;
+
+	return offset + len;
+}
+
+static void
+test_stream_response(void)
+{
+	struct spdk_jsonrpc_server *server;
+	struct spdk_jsonrpc_server_conn *conn;
+	struct spdk_json_write_ctx *w;
+	const size_t resp_size = 2 * SPDK_JSONRPC_SEND_STREAM_SIZE;
+	const char *req_id = "{\"jsonrpc\":\"2.0\",\"method\":\"a\",\"id\":1}";
+	const char *req_no_id = "{\"jsonrpc\":\"2.0\",\"method\":\"a\"}";
+	char *resp;
+	size_t resp_len = 0;
+	void *end = NULL;
+	uint32_t i;
+	ssize_t rc;
+
+	server = calloc(1, sizeof(*server));
+	SPDK_CU_ASSERT_FATAL(server != NULL);
+
+	conn = calloc(1, sizeof(*conn));
+	SPDK_CU_ASSERT_FATAL(conn != NULL);
+
+	conn->server = server;
+	conn->sockfd = 1;
+	pthread_spin_init(&conn->queue_lock, PTHREAD_PROCESS_PRIVATE);
+
+	resp = calloc(1, resp_size + 1);
+	SPDK_CU_ASSERT_FATAL(resp != NULL);
+
+	/* A large response is queued for sending before it's complete */
+	g_sent_request = NULL;
+	CU_ASSERT(spdk_jsonrpc_parse_request(conn, req_id, strlen(req_id)) == (ssize_t)strlen(req_id));
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+
+	w = spdk_jsonrpc_begin_result(g_request);
+	spdk_json_write_array_begin(w);
+	for (i = 0; g_sent_request == NULL && i < resp_size / 8; i++) {
+		spdk_json_write_uint32(w, i);
+	}
+	CU_ASSERT(g_sent_request == g_request);
+	CU_ASSERT(g_request->streaming == true);
+	CU_ASSERT(g_request->send_complete == false);
+	CU_ASSERT(spdk_jsonrpc_get_unsent_len(g_request) >= SPDK_JSONRPC_SEND_STREAM_SIZE);
+
+	/* Send what's written so far and keep writing */
+	resp_len = ut_consume_response(g_request, resp, resp_len, resp_size);
+	CU_ASSERT(spdk_jsonrpc_get_unsent_len(g_request) == 0);
+
+	for (i = 0; i < 10000; i++) {
+		spdk_json_write_uint32(w, i);
+	}
+	spdk_json_write_array_end(w);
+	spdk_jsonrpc_end_result(g_request, w);
+	CU_ASSERT(g_request->send_complete == true);
+	CU_ASSERT(spdk_jsonrpc_get_unsent_len(g_request) > 0);
+
+	resp_len = ut_consume_response(g_request, resp, resp_len, resp_size);
+
+	/* The pieces make up one valid response */
+	rc = spdk_json_parse(resp, resp_len, NULL, 0, &end, 0);
+	CU_ASSERT(rc > 0);
+	CU_ASSERT(resp[resp_len - 1] == '\n');
+	CU_ASSERT(strncmp(resp, "{\"jsonrpc\":\"2.0\",\"id\":1,\"result\":[0,", 33) == 0);
+
+	spdk_jsonrpc_free_request(g_request);
+	g_request = NULL;
+	g_sent_request = NULL;
+
+	/* A response that is skipped is never sent in pieces */
+	CU_ASSERT(spdk_jsonrpc_parse_request(conn, req_no_id, strlen(req_no_id)) ==
+		  (ssize_t)strlen(req_no_id));
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+
+	w = spdk_jsonrpc_begin_result(g_request);
+	spdk_json_write_array_begin(w);
+	for (i = 0; i < resp_size / 8; i++) {
+		spdk_json_write_uint32(w, i);
+	}
+	CU_ASSERT(g_sent_request == NULL);
+	CU_ASSERT(g_request->streaming == false);
+	spdk_json_write_array_end(w);
+	spdk_jsonrpc_end_result(g_request, w);
+	CU_ASSERT(g_sent_request == g_request);
+	CU_ASSERT(g_request->send_len == 0);
+
+	spdk_jsonrpc_free_request(g_request);
+	g_request = NULL;
+	g_sent_request = NULL;
+
+	CU_ASSERT(conn->outstanding_requests == 0);
+	pthread_spin_destroy(&conn->queue_lock);
+	free(resp);
+	free(conn);
+	free(server);
+}
+
 int main(int argc, char **argv)
 {
 	CU_pSuite	suite = NULL;
@@ -401,7 +512,8 @@ int main(int argc, char **argv)
 
 	if (
 		CU_add_test(suite, "parse_request", test_parse_request) == NULL ||
-		CU_add_test(suite, "parse_request_streaming", test_parse_request_streaming) == NULL) {
+		CU_add_test(suite, "parse_request_streaming", test_parse_request_streaming) == NULL ||
+		CU_add_test(suite, "stream_response", test_stream_response) == NULL) {
 		CU_cleanup_registry();
 		return CU_get_error();
 	}
@@ -0,0 +1,309 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "spdk/stdinc.h"
+
+#include "common/lib/ut_multithread.c"
+#include "spdk_cunit.h"
+#include "spdk_internal/mock.h"
+
+#include "nbd/nbd.c"
+
+DEFINE_STUB_V(spdk_bdev_close, (struct spdk_bdev_desc *desc));
+DEFINE_STUB(spdk_bdev_flush, int, (struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+				   uint64_t offset, uint64_t length, spdk_bdev_io_completion_cb cb, void *cb_arg), 0);
+DEFINE_STUB_V(spdk_bdev_free_io, (struct spdk_bdev_io *bdev_io));
+DEFINE_STUB(spdk_bdev_get_block_size, uint32_t, (const struct spdk_bdev *bdev), 512);
+DEFINE_STUB(spdk_bdev_get_buf_align, size_t, (const struct spdk_bdev *bdev), 0);
+DEFINE_STUB(spdk_bdev_get_by_name, struct spdk_bdev *, (const char *bdev_name), NULL);
+DEFINE_STUB(spdk_bdev_get_name, const char *, (const struct spdk_bdev *bdev), "test");
+DEFINE_STUB(spdk_bdev_get_num_blocks, uint64_t, (const struct spdk_bdev *bdev), 0);
+DEFINE_STUB(spdk_bdev_open, int, (struct spdk_bdev *bdev, bool write,
+				  spdk_bdev_remove_cb_t remove_cb, void *remove_ctx, struct spdk_bdev_desc **desc), 0);
+DEFINE_STUB(spdk_bdev_queue_io_wait, int, (struct spdk_bdev *bdev, struct spdk_io_channel *ch,
+		struct spdk_bdev_io_wait_entry *entry), 0);
+DEFINE_STUB(spdk_bdev_read, int, (struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+				  void *buf, uint64_t offset, uint64_t nbytes, spdk_bdev_io_completion_cb cb,
+				  void *cb_arg), 0);
+DEFINE_STUB(spdk_bdev_unmap, int, (struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+				   uint64_t offset, uint64_t nbytes, spdk_bdev_io_completion_cb cb, void *cb_arg), 0);
+DEFINE_STUB(spdk_bdev_write, int, (struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+				   void *buf, uint64_t offset, uint64_t nbytes, spdk_bdev_io_completion_cb cb,
+				   void *cb_arg), 0);
+DEFINE_STUB_V(spdk_unaffinitize_thread, (void));
+
+#define UT_NBD_PATH "/dev/nbd0"
+
+static int g_io_device;
+static int g_num_channels;
+/* Fail spdk_bdev_get_io_channel() on the disk thread and/or on the conn threads */
+static bool g_fail_disk_thread_ch;
+static bool g_fail_conn_thread_ch;
+
+struct spdk_io_channel *
+spdk_bdev_get_io_channel(struct spdk_bdev_desc *desc)
+{
+	bool disk_thread = spdk_get_thread() == g_ut_threads[0].thread;
+
+	if ((disk_thread && g_fail_disk_thread_ch) || (!disk_thread && g_fail_conn_thread_ch)) {
+		return NULL;
+	}
+
+	return spdk_get_io_channel(&g_io_device);
+}
+
+static int
+ut_io_channel_create_cb(void *io_device, void *ctx)
+{
+	g_num_channels++;
+	return 0;
+}
+
+static void
+ut_io_channel_destroy_cb(void *io_device, void *ctx)
+{
+	g_num_channels--;
+}
+
+static struct spdk_nbd_disk *
+ut_nbd_alloc(uint32_t num_conns)
+{
+	struct spdk_nbd_disk *nbd;
+	uint32_t i;
+	int sp[2];
+
+	nbd = calloc(1, sizeof(*nbd));
+	SPDK_CU_ASSERT_FATAL(nbd != NULL);
+
+	nbd->conns = calloc(num_conns, sizeof(*nbd->conns));
+	SPDK_CU_ASSERT_FATAL(nbd->conns != NULL);
+
+	nbd->nbd_path = strdup(UT_NBD_PATH);
+	SPDK_CU_ASSERT_FATAL(nbd->nbd_path != NULL);
+
+	nbd->dev_fd = -1;
+	nbd->thread = spdk_get_thread();
+	nbd->buf_align = 64;
+	nbd->num_conns = num_conns;
+
+	for (i = 0; i < num_conns; i++) {
+		SPDK_CU_ASSERT_FATAL(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sp) == 0);
+		nbd->conns[i].nbd = nbd;
+		nbd->conns[i].spdk_sp_fd = sp[0];
+		nbd->conns[i].kernel_sp_fd = sp[1];
+		TAILQ_INIT(&nbd->conns[i].received_io_list);
+		TAILQ_INIT(&nbd->conns[i].executed_io_list);
+	}
+
+	return nbd;
+}
+
+static void
+ut_save_conn_threads(struct spdk_nbd_disk *nbd, struct spdk_thread **threads)
+{
+	uint32_t i;
+
+	for (i = 0; i < nbd->num_conns; i++) {
+		threads[i] = nbd->conns[i].thread;
+	}
+}
+
+/* Poll the disk thread and the threads created for the conns until they are all idle */
+static void
+ut_poll_conn_threads(struct spdk_thread **threads, uint32_t num_threads)
+{
+	bool busy;
+	uint32_t i;
+
+	do {
+		busy = poll_thread(0);
+		for (i = 1; i < num_threads; i++) {
+			if (threads[i] != NULL && !spdk_thread_is_exited(threads[i])) {
+				busy |= spdk_thread_poll(threads[i], 0, 0) > 0;
+			}
+		}
+	} while (busy);
+}
+
+static void
+ut_destroy_conn_threads(struct spdk_thread **threads, uint32_t num_threads)
+{
+	uint32_t i;
+
+	for (i = 1; i < num_threads; i++) {
+		if (threads[i] != NULL) {
+			CU_ASSERT(spdk_thread_is_exited(threads[i]));
+			spdk_thread_destroy(threads[i]);
+		}
+	}
+
+	set_thread(0);
+}
+
+static void
+test_start_conns(void)
+{
+	struct spdk_thread *threads[3] = {};
+	struct spdk_nbd_disk *nbd;
+	uint32_t i;
+	int rc;
+
+	nbd = ut_nbd_alloc(3);
+
+	rc = nbd_start_conns(nbd);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(nbd->num_conns_running == 3);
+
+	/* The first conn is started right away on the disk thread */
+	CU_ASSERT(nbd->conns[0].thread == nbd->thread);
+	CU_ASSERT(nbd->conns[0].ch != NULL);
+	CU_ASSERT(nbd->conns[0].poller != NULL);
+
+	/* The other ones get their own threads */
+	for (i = 1; i < 3; i++) {
+		CU_ASSERT(nbd->conns[i].thread != NULL);
+		CU_ASSERT(nbd->conns[i].thread != nbd->thread);
+		CU_ASSERT(nbd->conns[i].ch == NULL);
+	}
+	CU_ASSERT(nbd->conns[1].thread != nbd->conns[2].thread);
+
+	ut_save_conn_threads(nbd, threads);
+	ut_poll_conn_threads(threads, 3);
+
+	for (i = 1; i < 3; i++) {
+		CU_ASSERT(nbd->conns[i].ch != NULL);
+		CU_ASSERT(nbd->conns[i].poller != NULL);
+	}
+	CU_ASSERT(g_num_channels == 3);
+
+	/* Stopping the disk stops all of its conns and their threads */
+	spdk_nbd_stop(nbd);
+	ut_poll_conn_threads(threads, 3);
+	CU_ASSERT(g_num_channels == 0);
+	ut_destroy_conn_threads(threads, 3);
+}
+
+static void
+test_start_conns_disk_thread_failure(void)
+{
+	struct spdk_nbd_disk *nbd;
+	int rc;
+
+	/* A conn that cannot be started on the disk thread fails the whole start */
+	g_fail_disk_thread_ch = true;
+	nbd = ut_nbd_alloc(2);
+
+	rc = nbd_start_conns(nbd);
+	CU_ASSERT(rc == -ENOMEM);
+	CU_ASSERT(nbd->num_conns_running == 0);
+	CU_ASSERT(nbd->conns[0].poller == NULL);
+	CU_ASSERT(nbd->conns[1].thread == NULL);
+
+	/* Nothing was started, so the disk is freed right away */
+	spdk_nbd_stop(nbd);
+	poll_threads();
+	CU_ASSERT(g_num_channels == 0);
+
+	g_fail_disk_thread_ch = false;
+}
+
+static void
+test_start_conns_conn_thread_failure(void)
+{
+	struct spdk_thread *threads[3] = {};
+	struct spdk_nbd_disk *nbd;
+	int rc;
+
+	/* Conns on their own threads start asynchronously and stop the disk when they fail */
+	g_fail_conn_thread_ch = true;
+	nbd = ut_nbd_alloc(3);
+
+	rc = nbd_start_conns(nbd);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(nbd->num_conns_running == 3);
+	CU_ASSERT(g_num_channels == 1);
+
+	ut_save_conn_threads(nbd, threads);
+	ut_poll_conn_threads(threads, 3);
+	CU_ASSERT(g_num_channels == 0);
+	ut_destroy_conn_threads(threads, 3);
+
+	g_fail_conn_thread_ch = false;
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	if (CU_initialize_registry() != CUE_SUCCESS) {
+		return CU_get_error();
+	}
+
+	suite = CU_add_suite("nbd", NULL, NULL);
+	if (suite == NULL) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	if (
+		CU_add_test(suite, "start_conns", test_start_conns) == NULL ||
+		CU_add_test(suite, "start_conns_disk_thread_failure",
+			    test_start_conns_disk_thread_failure) == NULL ||
+		CU_add_test(suite, "start_conns_conn_thread_failure",
+			    test_start_conns_conn_thread_failure) == NULL
+	) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	allocate_cores(2);
+	allocate_threads(1);
+	set_thread(0);
+	spdk_io_device_register(&g_io_device, ut_io_channel_create_cb, ut_io_channel_destroy_cb,
+				0, NULL);
+
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	num_failures = CU_get_number_of_failures();
+	CU_cleanup_registry();
+
+	spdk_io_device_unregister(&g_io_device, NULL);
+	poll_threads();
+	free_threads();
+	free_cores();
+
+	return num_failures;
+}
@@ -2072,6 +2072,53 @@ test_nvme_ctrlr_init_set_num_queues(void)
 	nvme_ctrlr_destruct(&ctrlr);
 }
 
+static void
+test_nvme_ctrlr_init_identify_active_ns(void)
+{
+	uint32_t nsid;
+	DECLARE_AND_CONSTRUCT_CTRLR();
+
+	ctrlr.page_size = 0x1000;
+	ctrlr.vs.bits.mjr = 1;
+	ctrlr.vs.bits.mnr = 2;
+	ctrlr.cdata.nn = 1531;
+
+	ctrlr.state = NVME_CTRLR_STATE_CONSTRUCT_NS;
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0); /* -> IDENTIFY_ACTIVE_NS */
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_IDENTIFY_ACTIVE_NS);
+	CU_ASSERT(ctrlr.num_ns == 1531);
+
+	/* Both pages of the active namespace list are retrieved without waiting */
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0); /* -> IDENTIFY_NS */
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_IDENTIFY_NS);
+	for (nsid = 1; nsid <= ctrlr.num_ns; nsid++) {
+		CU_ASSERT(spdk_nvme_ctrlr_is_active_ns(&ctrlr, nsid) == true);
+	}
+
+	nvme_ctrlr_destruct(&ctrlr);
+}
+
+static void
+test_nvme_ctrlr_init_supported_log_pages_and_features(void)
+{
+	DECLARE_AND_CONSTRUCT_CTRLR();
+
+	ctrlr.cdata.vid = SPDK_PCI_VID_INTEL;
+
+	ctrlr.state = NVME_CTRLR_STATE_SET_SUPPORTED_LOG_PAGES;
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0); /* -> SET_SUPPORTED_FEATURES */
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_SET_SUPPORTED_FEATURES);
+	CU_ASSERT(ctrlr.log_page_supported[SPDK_NVME_LOG_ERROR] == true);
+	CU_ASSERT(ctrlr.log_page_supported[SPDK_NVME_INTEL_LOG_PAGE_DIRECTORY] == true);
+
+	/* No arbitration burst set, so no Set Features command is sent */
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0); /* -> SET_DB_BUF_CFG */
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_SET_DB_BUF_CFG);
+	CU_ASSERT(ctrlr.feature_supported[SPDK_NVME_INTEL_FEAT_MAX_LBA] == true);
+
+	nvme_ctrlr_destruct(&ctrlr);
+}
+
 int main(int argc, char **argv)
 {
 	CU_pSuite	suite = NULL;
@@ -2133,6 +2180,10 @@ int main(int argc, char **argv)
 			       test_nvme_ctrlr_init_set_nvmf_ioccsz) == NULL
 		|| CU_add_test(suite, "test nvme ctrlr init set num queues",
 			       test_nvme_ctrlr_init_set_num_queues) == NULL
+		|| CU_add_test(suite, "test nvme ctrlr init identify active ns",
+			       test_nvme_ctrlr_init_identify_active_ns) == NULL
+		|| CU_add_test(suite, "test nvme ctrlr init supported log pages and features",
+			       test_nvme_ctrlr_init_supported_log_pages_and_features) == NULL
 	) {
 		CU_cleanup_registry();
 		return CU_get_error();
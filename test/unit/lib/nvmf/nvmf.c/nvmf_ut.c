@@ -0,0 +1,254 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "common/lib/ut_multithread.c"
+#include "spdk_cunit.h"
+#include "spdk_internal/mock.h"
+#include "spdk_internal/thread.h"
+
+#include "nvmf/nvmf.c"
+
+DEFINE_STUB(spdk_bdev_get_io_channel, struct spdk_io_channel *,
+	    (struct spdk_bdev_desc *desc), NULL);
+DEFINE_STUB(spdk_bdev_get_name, const char *, (const struct spdk_bdev *bdev), "test");
+DEFINE_STUB(spdk_bdev_get_num_blocks, uint64_t, (const struct spdk_bdev *bdev), 0);
+DEFINE_STUB(spdk_bdev_get_uuid, const struct spdk_uuid *, (const struct spdk_bdev *bdev), NULL);
+DEFINE_STUB(spdk_nvme_transport_id_adrfam_str, const char *, (enum spdk_nvmf_adrfam adrfam),
+	    NULL);
+DEFINE_STUB(spdk_nvme_transport_id_trtype_str, const char *,
+	    (enum spdk_nvme_transport_type trtype), NULL);
+DEFINE_STUB(spdk_nvmf_ctrlr_async_event_ns_notice, int, (struct spdk_nvmf_ctrlr *ctrlr), 0);
+DEFINE_STUB_V(spdk_nvmf_ctrlr_destruct, (struct spdk_nvmf_ctrlr *ctrlr));
+DEFINE_STUB(spdk_nvmf_host_get_nqn, const char *, (const struct spdk_nvmf_host *host), NULL);
+DEFINE_STUB(spdk_nvmf_ns_get_bdev, struct spdk_bdev *, (struct spdk_nvmf_ns *ns), NULL);
+DEFINE_STUB(spdk_nvmf_ns_get_id, uint32_t, (const struct spdk_nvmf_ns *ns), 0);
+DEFINE_STUB_V(spdk_nvmf_ns_get_opts, (const struct spdk_nvmf_ns *ns,
+				      struct spdk_nvmf_ns_opts *opts, size_t opts_size));
+DEFINE_STUB_V(spdk_nvmf_qpair_free_aer, (struct spdk_nvmf_qpair *qpair));
+DEFINE_STUB_V(spdk_nvmf_subsystem_destroy, (struct spdk_nvmf_subsystem *subsystem));
+DEFINE_STUB(spdk_nvmf_subsystem_get_allow_any_host, bool,
+	    (const struct spdk_nvmf_subsystem *subsystem), false);
+DEFINE_STUB(spdk_nvmf_subsystem_get_first, struct spdk_nvmf_subsystem *,
+	    (struct spdk_nvmf_tgt *tgt), NULL);
+DEFINE_STUB(spdk_nvmf_subsystem_get_first_host, struct spdk_nvmf_host *,
+	    (struct spdk_nvmf_subsystem *subsystem), NULL);
+DEFINE_STUB(spdk_nvmf_subsystem_get_first_listener, struct spdk_nvmf_subsystem_listener *,
+	    (struct spdk_nvmf_subsystem *subsystem), NULL);
+DEFINE_STUB(spdk_nvmf_subsystem_get_first_ns, struct spdk_nvmf_ns *,
+	    (struct spdk_nvmf_subsystem *subsystem), NULL);
+DEFINE_STUB(spdk_nvmf_subsystem_get_max_namespaces, uint32_t,
+	    (const struct spdk_nvmf_subsystem *subsystem), 0);
+DEFINE_STUB(spdk_nvmf_subsystem_get_mn, const char *,
+	    (const struct spdk_nvmf_subsystem *subsystem), NULL);
+DEFINE_STUB(spdk_nvmf_subsystem_get_next, struct spdk_nvmf_subsystem *,
+	    (struct spdk_nvmf_subsystem *subsystem), NULL);
+DEFINE_STUB(spdk_nvmf_subsystem_get_next_host, struct spdk_nvmf_host *,
+	    (struct spdk_nvmf_subsystem *subsystem, struct spdk_nvmf_host *prev_host), NULL);
+DEFINE_STUB(spdk_nvmf_subsystem_get_next_listener, struct spdk_nvmf_subsystem_listener *,
+	    (struct spdk_nvmf_subsystem *subsystem,
+	     struct spdk_nvmf_subsystem_listener *prev_listener), NULL);
+DEFINE_STUB(spdk_nvmf_subsystem_get_next_ns, struct spdk_nvmf_ns *,
+	    (struct spdk_nvmf_subsystem *subsystem, struct spdk_nvmf_ns *prev_ns), NULL);
+DEFINE_STUB(spdk_nvmf_subsystem_get_nqn, const char *,
+	    (const struct spdk_nvmf_subsystem *subsystem), NULL);
+DEFINE_STUB(spdk_nvmf_subsystem_get_sn, const char *,
+	    (const struct spdk_nvmf_subsystem *subsystem), NULL);
+DEFINE_STUB(spdk_nvmf_subsystem_get_type, enum spdk_nvmf_subtype,
+	    (struct spdk_nvmf_subsystem *subsystem), SPDK_NVMF_SUBTYPE_NVME);
+DEFINE_STUB(spdk_nvmf_subsystem_listener_get_trid, const struct spdk_nvme_transport_id *,
+	    (struct spdk_nvmf_subsystem_listener *listener), NULL);
+DEFINE_STUB_V(spdk_nvmf_subsystem_remove_all_listeners,
+	      (struct spdk_nvmf_subsystem *subsystem, bool stop));
+DEFINE_STUB_V(spdk_nvmf_transport_accept, (struct spdk_nvmf_transport *transport,
+		new_qpair_fn cb_fn, void *cb_arg));
+DEFINE_STUB(spdk_nvmf_transport_destroy, int, (struct spdk_nvmf_transport *transport), 0);
+DEFINE_STUB(spdk_nvmf_transport_get_optimal_poll_group, struct spdk_nvmf_transport_poll_group *,
+	    (struct spdk_nvmf_transport *transport, struct spdk_nvmf_qpair *qpair), NULL);
+DEFINE_STUB(spdk_nvmf_transport_listen, int, (struct spdk_nvmf_transport *transport,
+		const struct spdk_nvme_transport_id *trid), 0);
+DEFINE_STUB(spdk_nvmf_transport_poll_group_add, int,
+	    (struct spdk_nvmf_transport_poll_group *group, struct spdk_nvmf_qpair *qpair), 0);
+DEFINE_STUB(spdk_nvmf_transport_poll_group_create, struct spdk_nvmf_transport_poll_group *,
+	    (struct spdk_nvmf_transport *transport), NULL);
+DEFINE_STUB_V(spdk_nvmf_transport_poll_group_destroy,
+	      (struct spdk_nvmf_transport_poll_group *group));
+DEFINE_STUB(spdk_nvmf_transport_poll_group_poll, int,
+	    (struct spdk_nvmf_transport_poll_group *group), 0);
+DEFINE_STUB(spdk_nvmf_transport_poll_group_remove, int,
+	    (struct spdk_nvmf_transport_poll_group *group, struct spdk_nvmf_qpair *qpair), 0);
+DEFINE_STUB_V(spdk_nvmf_transport_qpair_fini, (struct spdk_nvmf_qpair *qpair));
+DEFINE_STUB(spdk_nvmf_transport_qpair_get_listen_trid, int,
+	    (struct spdk_nvmf_qpair *qpair, struct spdk_nvme_transport_id *trid), 0);
+DEFINE_STUB(spdk_nvmf_transport_qpair_get_local_trid, int,
+	    (struct spdk_nvmf_qpair *qpair, struct spdk_nvme_transport_id *trid), 0);
+DEFINE_STUB(spdk_nvmf_transport_qpair_get_peer_trid, int,
+	    (struct spdk_nvmf_qpair *qpair, struct spdk_nvme_transport_id *trid), 0);
+DEFINE_STUB(spdk_nvmf_transport_req_free, int, (struct spdk_nvmf_request *req), 0);
+DEFINE_STUB(spdk_nvmf_transport_stop_listen, int, (struct spdk_nvmf_transport *transport,
+		const struct spdk_nvme_transport_id *trid), 0);
+
+#define UT_MAX_EXECUTED_REQS 8
+
+static struct spdk_nvmf_request *g_executed_reqs[UT_MAX_EXECUTED_REQS];
+static int g_num_executed_reqs;
+
+void
+spdk_nvmf_request_exec(struct spdk_nvmf_request *req)
+{
+	struct spdk_nvmf_subsystem_poll_group *sgroup;
+	struct spdk_nvmf_subsystem_pg_ns_info *ns_info;
+
+	sgroup = &req->qpair->group->sgroups[req->qpair->ctrlr->subsys->id];
+	ns_info = _spdk_nvmf_request_get_ns_info(req, sgroup);
+
+	/* Requests for inactive subsystems or namespaces are queued, just like in ctrlr.c */
+	if (sgroup->state != SPDK_NVMF_SUBSYSTEM_ACTIVE ||
+	    (ns_info != NULL && ns_info->state != SPDK_NVMF_PG_NS_ACTIVE)) {
+		TAILQ_INSERT_TAIL(&sgroup->queued, req, link);
+		return;
+	}
+
+	SPDK_CU_ASSERT_FATAL(g_num_executed_reqs < UT_MAX_EXECUTED_REQS);
+	g_executed_reqs[g_num_executed_reqs++] = req;
+}
+
+static void
+ut_poll_group_mod_done(void *cb_arg, int status)
+{
+	*(int *)cb_arg = status;
+}
+
+static void
+test_poll_group_resume_subsystem(void)
+{
+	struct spdk_nvmf_subsystem subsystem = {};
+	struct spdk_nvmf_ns *ns[2] = {};
+	struct spdk_nvmf_subsystem_pg_ns_info ns_info[2] = {};
+	struct spdk_nvmf_subsystem_poll_group sgroup = {};
+	struct spdk_nvmf_poll_group group = {};
+	struct spdk_nvmf_ctrlr ctrlr = {};
+	struct spdk_nvmf_qpair qpair = {};
+	struct spdk_nvmf_request req[3] = {};
+	union nvmf_h2c_msg cmd[3] = {};
+	int i, status;
+
+	subsystem.id = 0;
+	subsystem.max_nsid = 2;
+	subsystem.ns = ns;
+	TAILQ_INIT(&subsystem.ctrlrs);
+
+	sgroup.state = SPDK_NVMF_SUBSYSTEM_PAUSED;
+	sgroup.num_ns = 2;
+	sgroup.ns_info = ns_info;
+	TAILQ_INIT(&sgroup.queued);
+
+	group.sgroups = &sgroup;
+	group.num_sgroups = 1;
+
+	ctrlr.subsys = &subsystem;
+	qpair.ctrlr = &ctrlr;
+	qpair.qid = 1;
+	qpair.group = &group;
+
+	/* Two requests for NSID 1, which stays paused, and one for NSID 2 */
+	for (i = 0; i < 3; i++) {
+		cmd[i].nvme_cmd.opc = SPDK_NVME_OPC_READ;
+		cmd[i].nvme_cmd.nsid = i < 2 ? 1 : 2;
+		req[i].qpair = &qpair;
+		req[i].cmd = &cmd[i];
+		TAILQ_INSERT_TAIL(&sgroup.queued, &req[i], link);
+	}
+	ns_info[0].state = SPDK_NVMF_PG_NS_PAUSED;
+
+	g_num_executed_reqs = 0;
+	status = -1;
+	spdk_nvmf_poll_group_resume_subsystem(&group, &subsystem, ut_poll_group_mod_done, &status);
+	CU_ASSERT(status == 0);
+	CU_ASSERT(sgroup.state == SPDK_NVMF_SUBSYSTEM_ACTIVE);
+
+	/* Only the request for the active namespace is executed */
+	CU_ASSERT(g_num_executed_reqs == 1);
+	CU_ASSERT(g_executed_reqs[0] == &req[2]);
+
+	/* The requests for the paused namespace are queued again, keeping their order */
+	CU_ASSERT(TAILQ_FIRST(&sgroup.queued) == &req[0]);
+	CU_ASSERT(TAILQ_NEXT(&req[0], link) == &req[1]);
+	CU_ASSERT(TAILQ_NEXT(&req[1], link) == NULL);
+
+	/* Resuming the namespace releases them */
+	status = -1;
+	spdk_nvmf_poll_group_resume_ns(&group, &subsystem, 1, ut_poll_group_mod_done, &status);
+	CU_ASSERT(status == 0);
+	CU_ASSERT(ns_info[0].state == SPDK_NVMF_PG_NS_ACTIVE);
+	CU_ASSERT(g_num_executed_reqs == 3);
+	CU_ASSERT(g_executed_reqs[1] == &req[0]);
+	CU_ASSERT(g_executed_reqs[2] == &req[1]);
+	CU_ASSERT(TAILQ_EMPTY(&sgroup.queued));
+}
+
+int main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	if (CU_initialize_registry() != CUE_SUCCESS) {
+		return CU_get_error();
+	}
+
+	suite = CU_add_suite("nvmf", NULL, NULL);
+	if (suite == NULL) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	if (
+		CU_add_test(suite, "poll_group_resume_subsystem", test_poll_group_resume_subsystem) == NULL
+	) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	allocate_threads(1);
+	set_thread(0);
+
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	num_failures = CU_get_number_of_failures();
+	CU_cleanup_registry();
+
+	free_threads();
+
+	return num_failures;
+}
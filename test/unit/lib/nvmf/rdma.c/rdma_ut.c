@@ -131,6 +131,24 @@ spdk_mem_map_translate(const struct spdk_mem_map *map, uint64_t vaddr, uint64_t
 	return (uint64_t)&g_rdma_mr;
 }
 
+int
+spdk_mem_map_translate_iov(const struct spdk_mem_map *map, const struct iovec *iov, int iovcnt,
+			   uint64_t *translations)
+{
+	uint64_t len;
+	int i;
+
+	for (i = 0; i < iovcnt; i++) {
+		len = iov[i].iov_len;
+		translations[i] = spdk_mem_map_translate(map, (uint64_t)iov[i].iov_base, &len);
+		if (len < iov[i].iov_len) {
+			break;
+		}
+	}
+
+	return i;
+}
+
 static void reset_nvmf_rdma_request(struct spdk_nvmf_rdma_request *rdma_req)
 {
 	int i;
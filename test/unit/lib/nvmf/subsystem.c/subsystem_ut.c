@@ -144,6 +144,20 @@ spdk_nvmf_poll_group_resume_subsystem(struct spdk_nvmf_poll_group *group,
 {
 }
 
+void
+spdk_nvmf_poll_group_pause_ns(struct spdk_nvmf_poll_group *group,
+			      struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+			      spdk_nvmf_poll_group_mod_done cb_fn, void *cb_arg)
+{
+}
+
+void
+spdk_nvmf_poll_group_resume_ns(struct spdk_nvmf_poll_group *group,
+			       struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+			       spdk_nvmf_poll_group_mod_done cb_fn, void *cb_arg)
+{
+}
+
 int
 spdk_nvme_transport_id_parse_trtype(enum spdk_nvme_transport_type *trtype, const char *str)
 {
@@ -1276,19 +1290,52 @@ test_spdk_nvmf_ns_event(void)
 	g_ns_changed_nsid = 0xFFFFFFFF;
 	g_ns_changed_ctrlr = NULL;
 	spdk_nvmf_ns_event(SPDK_BDEV_EVENT_RESIZE, &bdev1, subsystem.ns[0]);
+	/* Only the namespace is paused */
+	CU_ASSERT(SPDK_NVMF_SUBSYSTEM_ACTIVE == subsystem.state);
+	CU_ASSERT(spdk_bit_array_get(subsystem.paused_ns, 0));
+
+	poll_threads();
+	CU_ASSERT(1 == g_ns_changed_nsid);
+	CU_ASSERT(&ctrlr == g_ns_changed_ctrlr);
+	CU_ASSERT(SPDK_NVMF_SUBSYSTEM_ACTIVE == subsystem.state);
+	CU_ASSERT(!spdk_bit_array_get(subsystem.paused_ns, 0));
+
+	/* Namespace already paused - fall back to pausing the whole subsystem */
+	spdk_bit_array_set(subsystem.paused_ns, 0);
+	g_ns_changed_nsid = 0xFFFFFFFF;
+	g_ns_changed_ctrlr = NULL;
+	spdk_nvmf_ns_event(SPDK_BDEV_EVENT_RESIZE, &bdev1, subsystem.ns[0]);
 	CU_ASSERT(SPDK_NVMF_SUBSYSTEM_PAUSING == subsystem.state);
 
 	poll_threads();
 	CU_ASSERT(1 == g_ns_changed_nsid);
 	CU_ASSERT(&ctrlr == g_ns_changed_ctrlr);
 	CU_ASSERT(SPDK_NVMF_SUBSYSTEM_ACTIVE == subsystem.state);
+	spdk_bit_array_clear(subsystem.paused_ns, 0);
+
+	/* Subsystem in the middle of a state change - the event is retried later */
+	subsystem.state = SPDK_NVMF_SUBSYSTEM_PAUSING;
+	g_ns_changed_nsid = 0xFFFFFFFF;
+	g_ns_changed_ctrlr = NULL;
+	spdk_nvmf_ns_event(SPDK_BDEV_EVENT_RESIZE, &bdev1, subsystem.ns[0]);
+	CU_ASSERT(subsystem.ns[0]->resize_pending);
+	CU_ASSERT(subsystem.ns[0]->event_retry_poller != NULL);
 
-	/* Namespace remove event */
 	subsystem.state = SPDK_NVMF_SUBSYSTEM_ACTIVE;
+	spdk_delay_us(1000);
+	poll_threads();
+	CU_ASSERT(!subsystem.ns[0]->resize_pending);
+	CU_ASSERT(subsystem.ns[0]->event_retry_poller == NULL);
+	CU_ASSERT(1 == g_ns_changed_nsid);
+	CU_ASSERT(&ctrlr == g_ns_changed_ctrlr);
+	CU_ASSERT(!spdk_bit_array_get(subsystem.paused_ns, 0));
+
+	/* Namespace remove event */
 	g_ns_changed_nsid = 0xFFFFFFFF;
 	g_ns_changed_ctrlr = NULL;
 	spdk_nvmf_ns_event(SPDK_BDEV_EVENT_REMOVE, &bdev1, subsystem.ns[0]);
-	CU_ASSERT(SPDK_NVMF_SUBSYSTEM_PAUSING == subsystem.state);
+	CU_ASSERT(SPDK_NVMF_SUBSYSTEM_ACTIVE == subsystem.state);
+	CU_ASSERT(spdk_bit_array_get(subsystem.paused_ns, 0));
 	CU_ASSERT(0xFFFFFFFF == g_ns_changed_nsid);
 	CU_ASSERT(NULL == g_ns_changed_ctrlr);
 
@@ -1297,11 +1344,104 @@ test_spdk_nvmf_ns_event(void)
 	CU_ASSERT(&ctrlr == g_ns_changed_ctrlr);
 	CU_ASSERT(NULL == subsystem.ns[0]);
 	CU_ASSERT(SPDK_NVMF_SUBSYSTEM_ACTIVE == subsystem.state);
+	CU_ASSERT(!spdk_bit_array_get(subsystem.paused_ns, 0));
 
+	spdk_bit_array_free(&subsystem.paused_ns);
 	free(subsystem.ns);
 	free(tgt.subsystems);
 }
 
+static void
+ut_ns_state_change_done(struct spdk_nvmf_subsystem *subsystem, void *cb_arg, int status)
+{
+	int *done_status = cb_arg;
+
+	*done_status = status;
+}
+
+static void
+test_spdk_nvmf_subsystem_pause_ns(void)
+{
+	struct spdk_nvmf_tgt tgt = {};
+	struct spdk_nvmf_subsystem subsystem = {
+		.max_nsid = 2,
+		.tgt = &tgt,
+		.state = SPDK_NVMF_SUBSYSTEM_ACTIVE
+	};
+	struct spdk_bdev bdev1 = {}, bdev2 = {};
+	struct spdk_nvmf_ns_opts ns_opts;
+	uint32_t nsid;
+	int done_status;
+	int rc;
+
+	subsystem.ns = calloc(subsystem.max_nsid, sizeof(struct spdk_nvmf_ns *));
+	SPDK_CU_ASSERT_FATAL(subsystem.ns != NULL);
+	TAILQ_INIT(&subsystem.ctrlrs);
+
+	/* Namespaces of an active subsystem can't be added without pausing them */
+	spdk_nvmf_ns_opts_get_defaults(&ns_opts, sizeof(ns_opts));
+	ns_opts.nsid = 1;
+	nsid = spdk_nvmf_subsystem_add_ns(&subsystem, &bdev1, &ns_opts, sizeof(ns_opts), NULL);
+	CU_ASSERT(nsid == 0);
+	CU_ASSERT(subsystem.ns[0] == NULL);
+
+	/* Invalid NSIDs */
+	rc = spdk_nvmf_subsystem_pause_ns(&subsystem, 0, ut_ns_state_change_done, &done_status);
+	CU_ASSERT(rc == -EINVAL);
+	rc = spdk_nvmf_subsystem_pause_ns(&subsystem, 3, ut_ns_state_change_done, &done_status);
+	CU_ASSERT(rc == -EINVAL);
+	rc = spdk_nvmf_subsystem_resume_ns(&subsystem, 1, ut_ns_state_change_done, &done_status);
+	CU_ASSERT(rc == -EINVAL);
+
+	/* Pause NSID 1 and add a namespace there */
+	done_status = 1;
+	rc = spdk_nvmf_subsystem_pause_ns(&subsystem, 1, ut_ns_state_change_done, &done_status);
+	CU_ASSERT(rc == 0);
+	rc = spdk_nvmf_subsystem_pause_ns(&subsystem, 1, ut_ns_state_change_done, &done_status);
+	CU_ASSERT(rc == -EBUSY);
+	poll_threads();
+	CU_ASSERT(done_status == 0);
+
+	nsid = spdk_nvmf_subsystem_add_ns(&subsystem, &bdev1, &ns_opts, sizeof(ns_opts), NULL);
+	CU_ASSERT(nsid == 1);
+	CU_ASSERT(subsystem.ns[0] != NULL);
+
+	/* Only the paused NSID can be changed */
+	ns_opts.nsid = 2;
+	nsid = spdk_nvmf_subsystem_add_ns(&subsystem, &bdev2, &ns_opts, sizeof(ns_opts), NULL);
+	CU_ASSERT(nsid == 0);
+	CU_ASSERT(subsystem.ns[1] == NULL);
+
+	done_status = 1;
+	rc = spdk_nvmf_subsystem_resume_ns(&subsystem, 1, ut_ns_state_change_done, &done_status);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	CU_ASSERT(done_status == 0);
+	CU_ASSERT(!spdk_bit_array_get(subsystem.paused_ns, 0));
+
+	/* Pause NSID 1 again and remove the namespace */
+	rc = spdk_nvmf_subsystem_pause_ns(&subsystem, 1, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+
+	rc = spdk_nvmf_subsystem_remove_ns(&subsystem, 1);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(subsystem.ns[0] == NULL);
+
+	rc = spdk_nvmf_subsystem_resume_ns(&subsystem, 1, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	CU_ASSERT(!spdk_bit_array_get(subsystem.paused_ns, 0));
+
+	/* The whole subsystem has to be paused when it's not active */
+	subsystem.state = SPDK_NVMF_SUBSYSTEM_PAUSED;
+	rc = spdk_nvmf_subsystem_pause_ns(&subsystem, 1, NULL, NULL);
+	CU_ASSERT(rc == -EBUSY);
+
+	spdk_bit_array_free(&subsystem.paused_ns);
+	free(subsystem.ns);
+}
+
 
 int main(int argc, char **argv)
 {
@@ -1337,7 +1477,8 @@ int main(int argc, char **argv)
 		CU_add_test(suite, "reservation_clear_notification", test_reservation_clear_notification) == NULL ||
 		CU_add_test(suite, "reservation_preempt_notification",
 			    test_reservation_preempt_notification) == NULL ||
-		CU_add_test(suite, "spdk_nvmf_ns_event", test_spdk_nvmf_ns_event) == NULL
+		CU_add_test(suite, "spdk_nvmf_ns_event", test_spdk_nvmf_ns_event) == NULL ||
+		CU_add_test(suite, "nvmf_subsystem_pause_ns", test_spdk_nvmf_subsystem_pause_ns) == NULL
 	) {
 		CU_cleanup_registry();
 		return CU_get_error();
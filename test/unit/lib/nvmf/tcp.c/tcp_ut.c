@@ -180,7 +180,7 @@ DEFINE_STUB_V(spdk_nvmf_request_free_buffers,
 
 DEFINE_STUB(spdk_sock_get_optimal_sock_group,
 	    int,
-	    (struct spdk_sock *sock, struct spdk_sock_group **group),
+	    (struct spdk_sock *sock, struct spdk_sock_group **group, struct spdk_sock_group *hint),
 	    0);
 
 DEFINE_STUB(spdk_sock_group_get_ctx,
@@ -193,6 +193,11 @@ DEFINE_STUB(spdk_sock_set_priority,
 	    (struct spdk_sock *sock, int priority),
 	    0);
 
+DEFINE_STUB(spdk_sock_set_busy_poll,
+	    int,
+	    (struct spdk_sock *sock, int usec),
+	    0);
+
 DEFINE_STUB_V(spdk_nvmf_ns_reservation_request, (void *ctx));
 
 DEFINE_STUB_V(spdk_nvme_trid_populate_transport, (struct spdk_nvme_transport_id *trid,
@@ -470,26 +475,32 @@ test_nvmf_tcp_send_c2h_data(void)
 {
 	struct spdk_thread *thread;
 	struct spdk_nvmf_tcp_transport ttransport = {};
+	struct spdk_nvmf_tcp_poll_group tgroup = {};
 	struct spdk_nvmf_tcp_qpair tqpair = {};
 	struct spdk_nvmf_tcp_req tcp_req = {};
-	struct nvme_tcp_pdu pdu = {};
+	struct nvme_tcp_pdu pdu[2] = {};
 	struct spdk_nvme_tcp_c2h_data_hdr *c2h_data;
 
 	thread = spdk_thread_create(NULL, NULL);
 	SPDK_CU_ASSERT_FATAL(thread != NULL);
 	spdk_set_thread(thread);
 
-	tcp_req.pdu = &pdu;
+	tcp_req.pdu = &pdu[0];
 	tcp_req.req.length = 300;
 
 	tqpair.qpair.transport = &ttransport.transport;
+	ttransport.transport.opts.c2h_success = true;
+	tqpair.maxc2hdata = 4096;
+	tqpair.c2h_data_pdus = 1;
 	TAILQ_INIT(&tqpair.send_queue);
+	TAILQ_INIT(&tqpair.send_pending);
 
 	/* Set qpair state to make unrelated operations NOP */
 	tqpair.state = NVME_TCP_QPAIR_STATE_RUNNING;
 	tqpair.recv_state = NVME_TCP_PDU_RECV_STATE_ERROR;
 
 	tcp_req.req.cmd = (union nvmf_h2c_msg *)&tcp_req.cmd;
+	tcp_req.req.rsp = (union nvmf_c2h_msg *)&tcp_req.rsp;
 
 	tcp_req.req.iov[0].iov_base = (void *)0xDEADBEEF;
 	tcp_req.req.iov[0].iov_len = 101;
@@ -502,22 +513,111 @@ test_nvmf_tcp_send_c2h_data(void)
 
 	spdk_nvmf_tcp_send_c2h_data(&tqpair, &tcp_req);
 
-	CU_ASSERT(TAILQ_FIRST(&tqpair.send_queue) == &pdu);
-	TAILQ_REMOVE(&tqpair.send_queue, &pdu, tailq);
+	CU_ASSERT(TAILQ_FIRST(&tqpair.send_queue) == &pdu[0]);
+	TAILQ_REMOVE(&tqpair.send_queue, &pdu[0], tailq);
 
-	c2h_data = &pdu.hdr.c2h_data;
+	c2h_data = &pdu[0].hdr.c2h_data;
 	CU_ASSERT(c2h_data->datao == 0);
 	CU_ASSERT(c2h_data->datal = 300);
 	CU_ASSERT(c2h_data->common.plen == sizeof(*c2h_data) + 300);
 	CU_ASSERT(c2h_data->common.flags & SPDK_NVME_TCP_C2H_DATA_FLAGS_LAST_PDU);
+	CU_ASSERT(c2h_data->common.flags & SPDK_NVME_TCP_C2H_DATA_FLAGS_SUCCESS);
 
-	CU_ASSERT(pdu.data_iovcnt == 3);
-	CU_ASSERT((uint64_t)pdu.data_iov[0].iov_base == 0xDEADBEEF);
-	CU_ASSERT(pdu.data_iov[0].iov_len == 101);
-	CU_ASSERT((uint64_t)pdu.data_iov[1].iov_base == 0xFEEDBEEF);
-	CU_ASSERT(pdu.data_iov[1].iov_len == 100);
-	CU_ASSERT((uint64_t)pdu.data_iov[2].iov_base == 0xC0FFEE);
-	CU_ASSERT(pdu.data_iov[2].iov_len == 99);
+	CU_ASSERT(pdu[0].data_iovcnt == 3);
+	CU_ASSERT((uint64_t)pdu[0].data_iov[0].iov_base == 0xDEADBEEF);
+	CU_ASSERT(pdu[0].data_iov[0].iov_len == 101);
+	CU_ASSERT((uint64_t)pdu[0].data_iov[1].iov_base == 0xFEEDBEEF);
+	CU_ASSERT(pdu[0].data_iov[1].iov_len == 100);
+	CU_ASSERT((uint64_t)pdu[0].data_iov[2].iov_base == 0xC0FFEE);
+	CU_ASSERT(pdu[0].data_iov[2].iov_len == 99);
+
+	/* The response can't be replaced by the SUCCESS flag if it carries any data */
+	nvmf_tcp_req_pdu_fini(&tcp_req);
+	tcp_req.c2h_offset = 0;
+	tcp_req.rsp.cdw0 = 1;
+
+	spdk_nvmf_tcp_send_c2h_data(&tqpair, &tcp_req);
+
+	CU_ASSERT(TAILQ_FIRST(&tqpair.send_queue) == &pdu[0]);
+	TAILQ_REMOVE(&tqpair.send_queue, &pdu[0], tailq);
+	CU_ASSERT(c2h_data->common.flags & SPDK_NVME_TCP_C2H_DATA_FLAGS_LAST_PDU);
+	CU_ASSERT(!(c2h_data->common.flags & SPDK_NVME_TCP_C2H_DATA_FLAGS_SUCCESS));
+	tcp_req.rsp.cdw0 = 0;
+
+	/* Data larger than maxc2hdata is split into several PDUs, all queued at once */
+	nvmf_tcp_req_pdu_fini(&tcp_req);
+	tcp_req.c2h_offset = 0;
+	tqpair.maxc2hdata = 200;
+	tqpair.c2h_data_pdus = 2;
+
+	spdk_nvmf_tcp_send_c2h_data(&tqpair, &tcp_req);
+
+	CU_ASSERT(TAILQ_FIRST(&tqpair.send_queue) == &pdu[0]);
+	TAILQ_REMOVE(&tqpair.send_queue, &pdu[0], tailq);
+	CU_ASSERT(c2h_data->datao == 0);
+	CU_ASSERT(c2h_data->datal == 200);
+	CU_ASSERT(c2h_data->common.plen == sizeof(*c2h_data) + 200);
+	CU_ASSERT(!(c2h_data->common.flags & SPDK_NVME_TCP_C2H_DATA_FLAGS_LAST_PDU));
+	CU_ASSERT(!(c2h_data->common.flags & SPDK_NVME_TCP_C2H_DATA_FLAGS_SUCCESS));
+	CU_ASSERT(pdu[0].data_iovcnt == 2);
+	CU_ASSERT((uint64_t)pdu[0].data_iov[1].iov_base == 0xFEEDBEEF);
+	CU_ASSERT(pdu[0].data_iov[1].iov_len == 99);
+
+	CU_ASSERT(TAILQ_FIRST(&tqpair.send_queue) == &pdu[1]);
+	TAILQ_REMOVE(&tqpair.send_queue, &pdu[1], tailq);
+	CU_ASSERT(TAILQ_EMPTY(&tqpair.send_queue));
+	c2h_data = &pdu[1].hdr.c2h_data;
+	CU_ASSERT(c2h_data->datao == 200);
+	CU_ASSERT(c2h_data->datal == 100);
+	CU_ASSERT(c2h_data->common.flags & SPDK_NVME_TCP_C2H_DATA_FLAGS_LAST_PDU);
+	CU_ASSERT(c2h_data->common.flags & SPDK_NVME_TCP_C2H_DATA_FLAGS_SUCCESS);
+	CU_ASSERT(tcp_req.c2h_offset == 300);
+	CU_ASSERT(pdu[1].req == &tcp_req);
+	CU_ASSERT(pdu[1].data_iovcnt == 2);
+	CU_ASSERT((uint64_t)pdu[1].data_iov[0].iov_base == 0xFEEDBEEF + 99);
+	CU_ASSERT(pdu[1].data_iov[0].iov_len == 1);
+	CU_ASSERT((uint64_t)pdu[1].data_iov[1].iov_base == 0xC0FFEE);
+	CU_ASSERT(pdu[1].data_iov[1].iov_len == 99);
+	c2h_data = &pdu[0].hdr.c2h_data;
+
+	/* In a poll group, PDUs are held back until the qpair is flushed */
+	nvmf_tcp_req_pdu_fini(&tcp_req);
+	tcp_req.c2h_offset = 0;
+	tqpair.maxc2hdata = 4096;
+	TAILQ_INIT(&tgroup.send_pending);
+	tqpair.group = &tgroup;
+	tqpair.send_batching = true;
+
+	spdk_nvmf_tcp_send_c2h_data(&tqpair, &tcp_req);
+
+	CU_ASSERT(TAILQ_EMPTY(&tqpair.send_queue));
+	CU_ASSERT(TAILQ_FIRST(&tqpair.send_pending) == &pdu[0]);
+	CU_ASSERT(TAILQ_FIRST(&tgroup.send_pending) == &tqpair);
+
+	MOCK_SET(spdk_sock_flush, 128);
+	spdk_nvmf_tcp_qpair_flush_pdus(&tqpair);
+
+	CU_ASSERT(TAILQ_EMPTY(&tqpair.send_pending));
+	CU_ASSERT(TAILQ_EMPTY(&tgroup.send_pending));
+	CU_ASSERT(!tqpair.send_linked);
+	CU_ASSERT(TAILQ_FIRST(&tqpair.send_queue) == &pdu[0]);
+	TAILQ_REMOVE(&tqpair.send_queue, &pdu[0], tailq);
+	CU_ASSERT(tgroup.stat.pdus_sent == 1);
+	CU_ASSERT(tgroup.stat.sends == 1);
+
+	/* A flush that couldn't send anything isn't counted as a send */
+	nvmf_tcp_req_pdu_fini(&tcp_req);
+	tcp_req.c2h_offset = 0;
+	spdk_nvmf_tcp_send_c2h_data(&tqpair, &tcp_req);
+	MOCK_SET(spdk_sock_flush, 0);
+	spdk_nvmf_tcp_qpair_flush_pdus(&tqpair);
+
+	CU_ASSERT(TAILQ_EMPTY(&tqpair.send_pending));
+	CU_ASSERT(TAILQ_FIRST(&tqpair.send_queue) == &pdu[0]);
+	TAILQ_REMOVE(&tqpair.send_queue, &pdu[0], tailq);
+	CU_ASSERT(tgroup.stat.pdus_sent == 2);
+	CU_ASSERT(tgroup.stat.sends == 1);
+	MOCK_CLEAR(spdk_sock_flush);
 
 	spdk_thread_exit(thread);
 	spdk_thread_destroy(thread);
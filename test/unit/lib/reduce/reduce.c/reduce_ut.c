@@ -48,6 +48,8 @@ static size_t g_persistent_pm_buf_len;
 static char *g_backing_dev_buf;
 static char g_path[REDUCE_PATH_MAX];
 static char *g_decomp_buf;
+static uint32_t g_decompress_count;
+static uint32_t g_backing_readv_count;
 
 #define TEST_MD_PATH "/tmp"
 
@@ -287,6 +289,7 @@ static void
 backing_dev_readv(struct spdk_reduce_backing_dev *backing_dev, struct iovec *iov, int iovcnt,
 		  uint64_t lba, uint32_t lba_count, struct spdk_reduce_vol_cb_args *args)
 {
+	g_backing_readv_count++;
 	if (g_defer_bdev_io == false) {
 		CU_ASSERT(g_pending_bdev_io_count == 0);
 		CU_ASSERT(TAILQ_EMPTY(&g_pending_bdev_io));
@@ -507,6 +510,7 @@ backing_dev_decompress(struct spdk_reduce_backing_dev *backing_dev,
 	int rc, i;
 
 	CU_ASSERT(src_iovcnt == 1);
+	g_decompress_count++;
 
 	for (i = 0; i < dst_iovcnt; i++) {
 		decompressed_len += dst_iov[i].iov_len;
@@ -664,6 +668,8 @@ _load(uint32_t backing_blocklen)
 	params.chunk_size = 16 * 1024;
 	params.backing_io_unit_size = 512;
 	params.logical_block_size = 512;
+	params.comp_backend = 2;
+	params.comp_level = 3;
 	spdk_uuid_generate(&params.uuid);
 
 	backing_dev_init(&backing_dev, &params, backing_blocklen);
@@ -690,6 +696,8 @@ _load(uint32_t backing_blocklen)
 	CU_ASSERT(g_vol->params.vol_size == params.vol_size);
 	CU_ASSERT(g_vol->params.chunk_size == params.chunk_size);
 	CU_ASSERT(g_vol->params.backing_io_unit_size == params.backing_io_unit_size);
+	CU_ASSERT(g_vol->params.comp_backend == params.comp_backend);
+	CU_ASSERT(g_vol->params.comp_level == params.comp_level);
 
 	g_reduce_errno = -1;
 	spdk_reduce_vol_unload(g_vol, unload_cb, NULL);
@@ -1271,6 +1279,127 @@ compress_algorithm(void)
 	CU_ASSERT(rc == -ENOSPC);
 }
 
+static void
+chunk_cache(void)
+{
+	struct spdk_reduce_vol_params params = {};
+	struct spdk_reduce_backing_dev backing_dev = {};
+	struct iovec iov;
+	char buf[16 * 1024]; /* chunk size */
+	char compare_buf[16 * 1024];
+	uint64_t lba;
+
+	params.chunk_size = 16 * 1024;
+	params.backing_io_unit_size = 4096;
+	params.logical_block_size = 512;
+	spdk_uuid_generate(&params.uuid);
+
+	backing_dev_init(&backing_dev, &params, 512);
+
+	g_vol = NULL;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_init(&params, &backing_dev, TEST_MD_PATH, init_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	SPDK_CU_ASSERT_FATAL(g_vol != NULL);
+
+	/* Room for 2 chunks. */
+	CU_ASSERT(spdk_reduce_vol_set_cache_size(g_vol, 2 * params.chunk_size + 1) == 0);
+	CU_ASSERT(g_vol->chunk_cache.num_entries == 2);
+
+	/* Write 0xAA to 2 logical blocks in each of the first 3 chunks. */
+	memset(buf, 0xAA, 2 * params.logical_block_size);
+	iov.iov_base = buf;
+	iov.iov_len = 2 * params.logical_block_size;
+	for (lba = 0; lba < 3 * 32; lba += 32) {
+		g_reduce_errno = -1;
+		spdk_reduce_vol_writev(g_vol, &iov, 1, lba + 2, 2, write_cb, NULL);
+		CU_ASSERT(g_reduce_errno == 0);
+	}
+	/* Writes to unallocated chunks are not read-modify-write, so nothing is cached. */
+	CU_ASSERT(_chunk_cache_lookup(g_vol, 0) == NULL);
+
+	/* The first read of chunk 0 decompresses it, the following ones hit the cache. */
+	g_decompress_count = 0;
+	g_backing_readv_count = 0;
+	memset(compare_buf, 0xAA, sizeof(compare_buf));
+	memset(buf, 0xFF, params.logical_block_size);
+	iov.iov_len = params.logical_block_size;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_readv(g_vol, &iov, 1, 2, 1, read_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	CU_ASSERT(memcmp(buf, compare_buf, params.logical_block_size) == 0);
+	CU_ASSERT(g_decompress_count == 1);
+	CU_ASSERT(g_backing_readv_count == 1);
+
+	memset(buf, 0xFF, params.logical_block_size);
+	g_reduce_errno = -1;
+	spdk_reduce_vol_readv(g_vol, &iov, 1, 3, 1, read_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	CU_ASSERT(memcmp(buf, compare_buf, params.logical_block_size) == 0);
+	memset(buf, 0xFF, params.logical_block_size);
+	g_reduce_errno = -1;
+	spdk_reduce_vol_readv(g_vol, &iov, 1, 4, 1, read_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	CU_ASSERT(spdk_mem_all_zero(buf, params.logical_block_size));
+	CU_ASSERT(g_decompress_count == 1);
+	CU_ASSERT(g_backing_readv_count == 1);
+
+	/* Partial overwrite of the cached chunk skips the read and decompression. */
+	memset(buf, 0xCC, params.logical_block_size);
+	g_reduce_errno = -1;
+	spdk_reduce_vol_writev(g_vol, &iov, 1, 3, 1, write_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	CU_ASSERT(g_decompress_count == 1);
+	CU_ASSERT(g_backing_readv_count == 1);
+
+	/* The cached copy reflects the overwrite. */
+	memset(buf, 0xFF, params.logical_block_size);
+	g_reduce_errno = -1;
+	spdk_reduce_vol_readv(g_vol, &iov, 1, 3, 1, read_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	memset(compare_buf, 0xCC, sizeof(compare_buf));
+	CU_ASSERT(memcmp(buf, compare_buf, params.logical_block_size) == 0);
+	CU_ASSERT(g_decompress_count == 1);
+
+	/* Reading chunks 1 and 2 evicts chunk 0. */
+	memset(compare_buf, 0xAA, sizeof(compare_buf));
+	for (lba = 32; lba < 3 * 32; lba += 32) {
+		memset(buf, 0xFF, params.logical_block_size);
+		g_reduce_errno = -1;
+		spdk_reduce_vol_readv(g_vol, &iov, 1, lba + 2, 1, read_cb, NULL);
+		CU_ASSERT(g_reduce_errno == 0);
+		CU_ASSERT(memcmp(buf, compare_buf, params.logical_block_size) == 0);
+	}
+	CU_ASSERT(g_decompress_count == 3);
+	CU_ASSERT(_chunk_cache_lookup(g_vol, 0) == NULL);
+	CU_ASSERT(_chunk_cache_lookup(g_vol, 1) != NULL);
+	CU_ASSERT(_chunk_cache_lookup(g_vol, 2) != NULL);
+
+	/* The overwrite was persisted, so re-reading chunk 0 from disk returns the new data. */
+	memset(buf, 0xFF, params.logical_block_size);
+	g_reduce_errno = -1;
+	spdk_reduce_vol_readv(g_vol, &iov, 1, 3, 1, read_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	memset(compare_buf, 0xCC, sizeof(compare_buf));
+	CU_ASSERT(memcmp(buf, compare_buf, params.logical_block_size) == 0);
+	CU_ASSERT(g_decompress_count == 4);
+
+	/* Disabling the cache drops everything. */
+	CU_ASSERT(spdk_reduce_vol_set_cache_size(g_vol, 0) == 0);
+	CU_ASSERT(g_vol->chunk_cache.num_entries == 0);
+	g_reduce_errno = -1;
+	spdk_reduce_vol_readv(g_vol, &iov, 1, 3, 1, read_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	CU_ASSERT(g_decompress_count == 5);
+
+	g_reduce_errno = -1;
+	spdk_reduce_vol_unload(g_vol, unload_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+
+	persistent_pm_buf_destroy();
+	backing_dev_destroy(&backing_dev);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -1300,7 +1429,8 @@ main(int argc, char **argv)
 		CU_add_test(suite, "destroy", destroy) == NULL ||
 		CU_add_test(suite, "defer_bdev_io", defer_bdev_io) == NULL ||
 		CU_add_test(suite, "overlapped", overlapped) == NULL ||
-		CU_add_test(suite, "compress_algorithm", compress_algorithm) == NULL
+		CU_add_test(suite, "compress_algorithm", compress_algorithm) == NULL ||
+		CU_add_test(suite, "chunk_cache", chunk_cache) == NULL
 	) {
 		CU_cleanup_registry();
 		return CU_get_error();
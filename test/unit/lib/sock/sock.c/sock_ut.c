@@ -51,11 +51,13 @@ struct spdk_sock *g_server_sock_read;
 int g_ut_accept_count;
 struct spdk_ut_sock *g_ut_listen_sock;
 struct spdk_ut_sock *g_ut_client_sock;
+int g_ut_placement_id;
 
 struct spdk_ut_sock {
 	struct spdk_sock	base;
 	struct spdk_ut_sock	*peer;
 	size_t			bytes_avail;
+	int			sendbuf;
 	char			buf[256];
 };
 
@@ -237,6 +239,18 @@ spdk_ut_sock_set_recvbuf(struct spdk_sock *_sock, int sz)
 static int
 spdk_ut_sock_set_sendbuf(struct spdk_sock *_sock, int sz)
 {
+	struct spdk_ut_sock *sock = __ut_sock(_sock);
+
+	sock->sendbuf = sz;
+	return 0;
+}
+
+static int
+spdk_ut_sock_get_sendbuf(struct spdk_sock *_sock, int *sz)
+{
+	struct spdk_ut_sock *sock = __ut_sock(_sock);
+
+	*sz = sock->sendbuf;
 	return 0;
 }
 
@@ -263,7 +277,12 @@ spdk_ut_sock_is_connected(struct spdk_sock *_sock)
 static int
 spdk_ut_sock_get_placement_id(struct spdk_sock *_sock, int *placement_id)
 {
-	return -1;
+	if (g_ut_placement_id == 0) {
+		return -1;
+	}
+
+	*placement_id = g_ut_placement_id;
+	return 0;
 }
 
 static int
@@ -344,6 +363,7 @@ static struct spdk_net_impl g_ut_net_impl = {
 	.set_recvlowat	= spdk_ut_sock_set_recvlowat,
 	.set_recvbuf	= spdk_ut_sock_set_recvbuf,
 	.set_sendbuf	= spdk_ut_sock_set_sendbuf,
+	.get_sendbuf	= spdk_ut_sock_get_sendbuf,
 	.set_priority	= spdk_ut_sock_set_priority,
 	.is_ipv6	= spdk_ut_sock_is_ipv6,
 	.is_ipv4	= spdk_ut_sock_is_ipv4,
@@ -816,6 +836,151 @@ posix_sock_close(void)
 	_sock_close("127.0.0.1", UT_PORT, "posix");
 }
 
+static void
+ut_sock_map(void)
+{
+	struct spdk_sock_group *group_1, *group_2, *group;
+	struct spdk_sock_group_impl *group_impl;
+	struct spdk_sock *listen_sock;
+	struct spdk_sock *server_sock;
+	struct spdk_sock *client_sock;
+	int rc;
+
+	listen_sock = spdk_sock_listen(UT_IP, UT_PORT, "ut");
+	SPDK_CU_ASSERT_FATAL(listen_sock != NULL);
+
+	client_sock = spdk_sock_connect(UT_IP, UT_PORT, "ut");
+	SPDK_CU_ASSERT_FATAL(client_sock != NULL);
+
+	server_sock = spdk_sock_accept(listen_sock);
+	SPDK_CU_ASSERT_FATAL(server_sock != NULL);
+
+	group_1 = spdk_sock_group_create(NULL);
+	SPDK_CU_ASSERT_FATAL(group_1 != NULL);
+	group_2 = spdk_sock_group_create(NULL);
+	SPDK_CU_ASSERT_FATAL(group_2 != NULL);
+
+	/* No placement ID */
+	g_ut_placement_id = 0;
+	rc = spdk_sock_get_optimal_sock_group(server_sock, &group, group_1);
+	CU_ASSERT(rc != 0);
+	CU_ASSERT(group == NULL);
+
+	/* No group serves the placement ID yet */
+	g_ut_placement_id = 5;
+	rc = spdk_sock_get_optimal_sock_group(server_sock, &group, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(group == NULL);
+
+	/* The hint is assigned to the placement ID and sticks */
+	rc = spdk_sock_get_optimal_sock_group(server_sock, &group, group_1);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(group == group_1);
+	rc = spdk_sock_get_optimal_sock_group(server_sock, &group, group_2);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(group == group_1);
+
+	rc = spdk_sock_group_add_sock(group_1, server_sock, read_data, server_sock);
+	CU_ASSERT(rc == 0);
+	rc = spdk_sock_get_optimal_sock_group(server_sock, &group, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(group == group_1);
+
+	/* The reference is released for the placement ID the sock was added with */
+	g_ut_placement_id = 6;
+	rc = spdk_sock_group_remove_sock(group_1, server_sock);
+	CU_ASSERT(rc == 0);
+	g_ut_placement_id = 5;
+	rc = spdk_sock_get_optimal_sock_group(server_sock, &group, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(group == NULL);
+	CU_ASSERT(STAILQ_EMPTY(&g_placement_id_map));
+
+	/* The reference is released if the group has no impl for the sock */
+	group_impl = STAILQ_FIRST(&group_1->group_impls);
+	while (group_impl != NULL && group_impl->net_impl != server_sock->net_impl) {
+		group_impl = STAILQ_NEXT(group_impl, link);
+	}
+	SPDK_CU_ASSERT_FATAL(group_impl != NULL);
+	STAILQ_REMOVE(&group_1->group_impls, group_impl, spdk_sock_group_impl, link);
+	rc = spdk_sock_group_add_sock(group_1, server_sock, read_data, server_sock);
+	CU_ASSERT(rc == -1);
+	CU_ASSERT(errno == EINVAL);
+	CU_ASSERT(STAILQ_EMPTY(&g_placement_id_map));
+	STAILQ_INSERT_TAIL(&group_1->group_impls, group_impl, link);
+
+	/* Placing the sock takes a reference, which is dropped once it's added to a group */
+	rc = spdk_sock_get_optimal_sock_group(server_sock, &group, group_2);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(group == group_2);
+	SPDK_CU_ASSERT_FATAL(!STAILQ_EMPTY(&g_placement_id_map));
+	CU_ASSERT(STAILQ_FIRST(&g_placement_id_map)->ref == 1);
+	rc = spdk_sock_group_add_sock(group_2, server_sock, read_data, server_sock);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(!STAILQ_EMPTY(&g_placement_id_map));
+	CU_ASSERT(STAILQ_FIRST(&g_placement_id_map)->ref == 1);
+	rc = spdk_sock_group_remove_sock(group_2, server_sock);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(STAILQ_EMPTY(&g_placement_id_map));
+
+	/* ... or when the sock is closed without being added */
+	rc = spdk_sock_get_optimal_sock_group(server_sock, &group, group_2);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(group == group_2);
+	CU_ASSERT(!STAILQ_EMPTY(&g_placement_id_map));
+	rc = spdk_sock_close(&server_sock);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(STAILQ_EMPTY(&g_placement_id_map));
+
+	g_ut_placement_id = 0;
+
+	rc = spdk_sock_group_close(&group_1);
+	CU_ASSERT(rc == 0);
+	rc = spdk_sock_group_close(&group_2);
+	CU_ASSERT(rc == 0);
+
+	rc = spdk_sock_close(&client_sock);
+	CU_ASSERT(rc == 0);
+	rc = spdk_sock_close(&listen_sock);
+	CU_ASSERT(rc == 0);
+}
+
+static void
+ut_sock_get_sendbuf(void)
+{
+	struct spdk_sock *listen_sock;
+	struct spdk_sock *client_sock;
+	int rc, sz;
+
+	listen_sock = spdk_sock_listen(UT_IP, UT_PORT, "ut");
+	SPDK_CU_ASSERT_FATAL(listen_sock != NULL);
+
+	client_sock = spdk_sock_connect(UT_IP, UT_PORT, "ut");
+	SPDK_CU_ASSERT_FATAL(client_sock != NULL);
+
+	rc = spdk_sock_set_sendbuf(client_sock, 4096);
+	CU_ASSERT(rc == 0);
+	sz = 0;
+	rc = spdk_sock_get_sendbuf(client_sock, &sz);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(sz == 4096);
+
+	/* Implementations without get_sendbuf report ENOTSUP */
+	g_ut_net_impl.get_sendbuf = NULL;
+	sz = 0;
+	errno = 0;
+	rc = spdk_sock_get_sendbuf(client_sock, &sz);
+	CU_ASSERT(rc == -1);
+	CU_ASSERT(errno == ENOTSUP);
+	CU_ASSERT(sz == 0);
+	g_ut_net_impl.get_sendbuf = spdk_ut_sock_get_sendbuf;
+
+	rc = spdk_sock_close(&client_sock);
+	CU_ASSERT(rc == 0);
+	rc = spdk_sock_close(&listen_sock);
+	CU_ASSERT(rc == 0);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -838,7 +1003,9 @@ main(int argc, char **argv)
 		CU_add_test(suite, "posix_sock_group", posix_sock_group) == NULL ||
 		CU_add_test(suite, "ut_sock_group", ut_sock_group) == NULL ||
 		CU_add_test(suite, "posix_sock_group_fairness", posix_sock_group_fairness) == NULL ||
-		CU_add_test(suite, "posix_sock_close", posix_sock_close) == NULL) {
+		CU_add_test(suite, "posix_sock_close", posix_sock_close) == NULL ||
+		CU_add_test(suite, "ut_sock_map", ut_sock_map) == NULL ||
+		CU_add_test(suite, "ut_sock_get_sendbuf", ut_sock_get_sendbuf) == NULL) {
 		CU_cleanup_registry();
 		return CU_get_error();
 	}
@@ -49,6 +49,13 @@ DEFINE_STUB(io_uring_submit, int, (struct io_uring *ring), 0);
 DEFINE_STUB(io_uring_get_sqe, struct io_uring_sqe *, (struct io_uring *ring), 0);
 DEFINE_STUB(io_uring_queue_init, int, (unsigned entries, struct io_uring *ring, unsigned flags), 0);
 DEFINE_STUB_V(io_uring_queue_exit, (struct io_uring *ring));
+DEFINE_STUB(io_uring_submit_and_wait, int, (struct io_uring *ring, unsigned wait_nr), 0);
+DEFINE_STUB(io_uring_register_files, int, (struct io_uring *ring, const int *files,
+		unsigned nr_files), 0);
+DEFINE_STUB(io_uring_register_files_update, int, (struct io_uring *ring, unsigned off,
+		int *files, unsigned nr_files), 1);
+DEFINE_STUB(io_uring_get_probe_ring, struct io_uring_probe *, (struct io_uring *ring), NULL);
+DEFINE_STUB_V(io_uring_free_probe, (struct io_uring_probe *probe));
 
 static void
 _req_cb(void *cb_arg, int len)
@@ -100,7 +107,7 @@ flush_client(void)
 	MOCK_SET(sendmsg, 192);
 	cb_arg1 = false;
 	rc = _sock_flush_client(sock);
-	CU_ASSERT(rc == 0);
+	CU_ASSERT(rc == 192);
 	CU_ASSERT(cb_arg1 == true);
 	CU_ASSERT(TAILQ_EMPTY(&sock->queued_reqs));
 
@@ -111,7 +118,7 @@ flush_client(void)
 	cb_arg1 = false;
 	cb_arg2 = false;
 	rc = _sock_flush_client(sock);
-	CU_ASSERT(rc == 0);
+	CU_ASSERT(rc == 256);
 	CU_ASSERT(cb_arg1 == true);
 	CU_ASSERT(cb_arg2 == true);
 	CU_ASSERT(TAILQ_EMPTY(&sock->queued_reqs));
@@ -123,7 +130,7 @@ flush_client(void)
 	cb_arg1 = false;
 	cb_arg2 = false;
 	rc = _sock_flush_client(sock);
-	CU_ASSERT(rc == 0);
+	CU_ASSERT(rc == 192);
 	CU_ASSERT(cb_arg1 == true);
 	CU_ASSERT(cb_arg2 == false);
 	CU_ASSERT(TAILQ_FIRST(&sock->queued_reqs) == req2);
@@ -135,7 +142,7 @@ flush_client(void)
 	MOCK_SET(sendmsg, 10);
 	cb_arg1 = false;
 	rc = _sock_flush_client(sock);
-	CU_ASSERT(rc == 0);
+	CU_ASSERT(rc == 10);
 	CU_ASSERT(cb_arg1 == false);
 	CU_ASSERT(TAILQ_FIRST(&sock->queued_reqs) == req1);
 
@@ -143,7 +150,7 @@ flush_client(void)
 	MOCK_SET(sendmsg, 52);
 	cb_arg1 = false;
 	rc = _sock_flush_client(sock);
-	CU_ASSERT(rc == 0);
+	CU_ASSERT(rc == 52);
 	CU_ASSERT(cb_arg1 == false);
 	CU_ASSERT(TAILQ_FIRST(&sock->queued_reqs) == req1);
 
@@ -151,7 +158,7 @@ flush_client(void)
 	MOCK_SET(sendmsg, 130);
 	cb_arg1 = false;
 	rc = _sock_flush_client(sock);
-	CU_ASSERT(rc == 0);
+	CU_ASSERT(rc == 130);
 	CU_ASSERT(cb_arg1 == true);
 	CU_ASSERT(TAILQ_EMPTY(&sock->queued_reqs));
 
@@ -242,10 +249,119 @@ flush_server(void)
 	CU_ASSERT(cb_arg1 == true);
 	CU_ASSERT(TAILQ_EMPTY(&sock->queued_reqs));
 
+	/* A flush while the write task is in flight must not send the requests
+	 * again, they are completed by the write task. */
+	spdk_sock_request_queue(sock, req1);
+	rc = spdk_sock_prep_reqs(sock, usock.write_task.iovs, 0, NULL);
+	CU_ASSERT(rc == 2);
+	usock.write_task.iov_cnt = rc;
+	usock.write_task.status = SPDK_URING_SOCK_TASK_IN_PROCESS;
+	spdk_sock_request_queue(sock, req2);
+	MOCK_SET(sendmsg, 192);
+	cb_arg1 = false;
+	cb_arg2 = false;
+	rc = spdk_uring_sock_flush(sock);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(cb_arg1 == false);
+	CU_ASSERT(cb_arg2 == false);
+	CU_ASSERT(TAILQ_FIRST(&sock->queued_reqs) == req1);
+	CU_ASSERT(TAILQ_NEXT(req1, internal.link) == req2);
+
+	/* The write task completes the first request only */
+	usock.write_task.status = SPDK_URING_SOCK_TASK_NOT_IN_USE;
+	spdk_sock_complete_reqs(sock, 128);
+	CU_ASSERT(cb_arg1 == true);
+	CU_ASSERT(cb_arg2 == false);
+	CU_ASSERT(TAILQ_FIRST(&sock->queued_reqs) == req2);
+	TAILQ_REMOVE(&sock->queued_reqs, req2, internal.link);
+	MOCK_CLEAR(sendmsg);
+
 	free(req1);
 	free(req2);
 }
 
+static void
+recv_buffered(void)
+{
+	struct spdk_uring_sock_group_impl group = {};
+	struct spdk_uring_sock usock = {};
+	struct spdk_sock *sock = &usock.base;
+	uint8_t *data, buf[64];
+	struct iovec iov[2];
+	ssize_t rc;
+	int i;
+
+	group.recv_bufs = calloc(2, SPDK_URING_SOCK_RECV_BUF_SIZE);
+	SPDK_CU_ASSERT_FATAL(group.recv_bufs != NULL);
+	usock.group = &group;
+	usock.recv_task.sock = &usock;
+	usock.recv_task.type = SPDK_SOCK_TASK_RECV;
+	usock.recv_bid = -1;
+	usock.fixed_idx = -1;
+
+	data = _group_recv_buf(&group, 1);
+	for (i = 0; i < 100; i++) {
+		data[i] = i;
+	}
+
+	/* A receive completed into buffer 1 */
+	_sock_recv_done(&usock, 100, IORING_CQE_F_BUFFER | (1 << IORING_CQE_BUFFER_SHIFT));
+	CU_ASSERT(usock.recv_bid == 1);
+	CU_ASSERT(usock.recv_len == 100);
+	CU_ASSERT(usock.recv_syscall == false);
+	CU_ASSERT(_sock_recv_ready(&usock));
+
+	/* Read it in two parts, the second one spanning two iovecs */
+	rc = spdk_uring_sock_recv(sock, buf, 40);
+	CU_ASSERT(rc == 40);
+	CU_ASSERT(buf[0] == 0 && buf[39] == 39);
+	CU_ASSERT(group.bufs_to_return_cnt == 0);
+
+	iov[0].iov_base = buf;
+	iov[0].iov_len = 30;
+	iov[1].iov_base = buf + 30;
+	iov[1].iov_len = 34;
+	rc = spdk_uring_sock_readv(sock, iov, 2);
+	CU_ASSERT(rc == 60);
+	CU_ASSERT(buf[0] == 40 && buf[59] == 99);
+
+	/* The drained buffer is given back to the kernel */
+	CU_ASSERT(usock.recv_bid == -1);
+	CU_ASSERT(group.bufs_to_return_cnt == 1);
+	CU_ASSERT(group.bufs_to_return[0] == 1);
+	CU_ASSERT(!_sock_recv_ready(&usock));
+
+	/* Nothing buffered - the next receive will bring the data, no syscall */
+	rc = spdk_uring_sock_recv(sock, buf, sizeof(buf));
+	CU_ASSERT(rc == -1);
+	CU_ASSERT(errno == EAGAIN);
+
+	/* Data of a socket leaving the group is stashed */
+	_sock_recv_done(&usock, 10, IORING_CQE_F_BUFFER | (1 << IORING_CQE_BUFFER_SHIFT));
+	group.bufs_to_return_cnt = 0;
+	rc = spdk_uring_sock_group_impl_remove_sock(&group.base, sock);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(usock.group == NULL);
+	CU_ASSERT(usock.recv_bid == -1);
+	CU_ASSERT(usock.stash_len == 10);
+	CU_ASSERT(group.bufs_to_return_cnt == 1);
+
+	rc = spdk_uring_sock_recv(sock, buf, 4);
+	CU_ASSERT(rc == 4);
+	CU_ASSERT(buf[0] == 0 && buf[3] == 3);
+	rc = spdk_uring_sock_recv(sock, buf, sizeof(buf));
+	CU_ASSERT(rc == 6);
+	CU_ASSERT(buf[0] == 4 && buf[5] == 9);
+
+	/* EOF is reported once the data is read */
+	usock.recv_eof = true;
+	rc = spdk_uring_sock_recv(sock, buf, sizeof(buf));
+	CU_ASSERT(rc == 0);
+
+	free(usock.recv_stash);
+	free(group.recv_bufs);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -264,7 +380,8 @@ main(int argc, char **argv)
 
 	if (
 		CU_add_test(suite, "flush_client", flush_client) == NULL ||
-		CU_add_test(suite, "flush_server", flush_server) == NULL
+		CU_add_test(suite, "flush_server", flush_server) == NULL ||
+		CU_add_test(suite, "recv_buffered", recv_buffered) == NULL
 	) {
 		CU_cleanup_registry();
 		return CU_get_error();
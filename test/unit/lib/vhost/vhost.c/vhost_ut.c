@@ -84,6 +84,8 @@ spdk_app_parse_core_mask(const char *mask, struct spdk_cpuset *cpumask)
 
 DEFINE_STUB(rte_vhost_get_mem_table, int, (int vid, struct rte_vhost_memory **mem), 0);
 DEFINE_STUB(rte_vhost_get_negotiated_features, int, (int vid, uint64_t *features), 0);
+DEFINE_STUB(rte_vhost_get_log_base, int,
+	    (int vid, uint64_t *log_base, uint64_t *log_size), 0);
 DEFINE_STUB(rte_vhost_get_vhost_vring, int,
 	    (int vid, uint16_t vring_idx, struct rte_vhost_vring *vring), 0);
 DEFINE_STUB(rte_vhost_enable_guest_notification, int,
@@ -299,6 +301,20 @@ create_controller_test(void)
 	ret = alloc_vdev(&vdev2, "vdev_name_0", "0x1");
 	CU_ASSERT(ret != 0);
 	cleanup_vdev(vdev);
+
+#ifndef SPDK_CONFIG_VHOST_INTERNAL_LIB
+	/* Devices with packed virtqueues don't offer dirty page logging */
+	ret = posix_memalign((void **)&vdev, 64, sizeof(*vdev));
+	SPDK_CU_ASSERT_FATAL(ret == 0);
+	memset(vdev, 0, sizeof(*vdev));
+	vdev->virtio_features = SPDK_VHOST_FEATURES;
+	vdev->packed_ring = true;
+	ret = vhost_dev_register(vdev, "vdev_name_0", "0x1", &g_vdev_backend);
+	SPDK_CU_ASSERT_FATAL(ret == 0);
+	CU_ASSERT(vdev->virtio_features & (1ULL << VIRTIO_F_RING_PACKED));
+	CU_ASSERT(!(vdev->virtio_features & (1ULL << VHOST_F_LOG_ALL)));
+	cleanup_vdev(vdev);
+#endif
 }
 
 static void
@@ -346,7 +362,7 @@ remove_controller_test(void)
 static void
 vq_avail_ring_get_test(void)
 {
-	struct spdk_vhost_virtqueue vq;
+	struct spdk_vhost_virtqueue vq = {};
 	uint16_t avail_mem[34];
 	uint16_t reqs[32];
 	uint16_t reqs_len, ret, i;
@@ -402,6 +418,365 @@ vq_avail_ring_get_test(void)
 	}
 }
 
+static void
+vq_packed_ring_test(void)
+{
+	struct spdk_vhost_session vs = {};
+	struct spdk_vhost_virtqueue vq = {};
+	struct vring_packed_desc descs[4] = {};
+	struct vhost_packed_buf bufs[4] = {};
+	struct vring_desc table[4] = {};
+	struct vring_desc *desc, *desc_table;
+	uint32_t desc_table_size;
+	uint16_t reqs[4];
+	uint16_t ret;
+	int rc;
+
+	vs.name = "vs";
+	vq.vring.desc_packed = descs;
+	vq.vring.size = 4;
+	vq.packed.packed_ring = true;
+	vq.packed.avail_phase = true;
+	vq.packed.used_phase = true;
+	vq.packed.bufs = bufs;
+	vq.packed.desc_table = table;
+
+	/* Nothing has been made available yet */
+	ret = vhost_vq_avail_ring_get(&vq, reqs, 4);
+	CU_ASSERT(ret == 0);
+
+	/* A chain of two descriptors with buffer ID 3 and a single descriptor with ID 0 */
+	descs[0].addr = 0x1000;
+	descs[0].len = 16;
+	descs[0].flags = VRING_DESC_F_AVAIL | VRING_DESC_F_NEXT;
+	descs[1].addr = 0x2000;
+	descs[1].len = 1;
+	descs[1].id = 3;
+	descs[1].flags = VRING_DESC_F_AVAIL | VRING_DESC_F_WRITE;
+	descs[2].addr = 0x3000;
+	descs[2].len = 512;
+	descs[2].id = 0;
+	descs[2].flags = VRING_DESC_F_AVAIL;
+
+	ret = vhost_vq_avail_ring_get(&vq, reqs, 4);
+	CU_ASSERT(ret == 2);
+	CU_ASSERT(reqs[0] == 3);
+	CU_ASSERT(reqs[1] == 0);
+	CU_ASSERT(vq.last_avail_idx == 3);
+	CU_ASSERT(vq.packed.avail_phase == true);
+
+	/* The chain is presented in the split layout */
+	rc = vhost_vq_get_desc(&vs, &vq, 3, &desc, &desc_table, &desc_table_size);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(desc_table_size == 2);
+	CU_ASSERT(desc->addr == 0x1000);
+	CU_ASSERT(desc->len == 16);
+	CU_ASSERT(!vhost_vring_desc_is_wr(desc));
+	rc = vhost_vring_desc_get_next(&desc, desc_table, desc_table_size);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(desc != NULL);
+	CU_ASSERT(desc->addr == 0x2000);
+	CU_ASSERT(vhost_vring_desc_is_wr(desc));
+	rc = vhost_vring_desc_get_next(&desc, desc_table, desc_table_size);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(desc == NULL);
+
+	/* Complete the requests out of order. Used descriptors are written
+	 * sequentially and skip as many slots as the completed chain had.
+	 */
+	vhost_vq_used_ring_enqueue(&vs, &vq, 0, 512);
+	CU_ASSERT(descs[0].id == 0);
+	CU_ASSERT(descs[0].len == 512);
+	CU_ASSERT(descs[0].flags == (VRING_DESC_F_AVAIL_USED | VRING_DESC_F_WRITE));
+	CU_ASSERT(vq.last_used_idx == 1);
+
+	vhost_vq_used_ring_enqueue(&vs, &vq, 3, 0);
+	CU_ASSERT(descs[1].id == 3);
+	CU_ASSERT(descs[1].flags == VRING_DESC_F_AVAIL_USED);
+	CU_ASSERT(vq.last_used_idx == 3);
+	CU_ASSERT(vq.used_req_cnt == 2);
+
+	/* A chain wrapping around the end of the ring. The driver flips its
+	 * wrap counter, so descriptors in the next lap have AVAIL cleared.
+	 */
+	descs[3].addr = 0x4000;
+	descs[3].len = 16;
+	descs[3].flags = VRING_DESC_F_AVAIL | VRING_DESC_F_NEXT;
+	descs[0].addr = 0x5000;
+	descs[0].len = 1;
+	descs[0].id = 1;
+	descs[0].flags = VRING_DESC_F_USED | VRING_DESC_F_WRITE;
+
+	ret = vhost_vq_avail_ring_get(&vq, reqs, 4);
+	CU_ASSERT(ret == 1);
+	CU_ASSERT(reqs[0] == 1);
+	CU_ASSERT(vq.last_avail_idx == 1);
+	CU_ASSERT(vq.packed.avail_phase == false);
+
+	rc = vhost_vq_get_desc(&vs, &vq, 1, &desc, &desc_table, &desc_table_size);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(desc_table_size == 2);
+	CU_ASSERT(desc_table[0].addr == 0x4000);
+	CU_ASSERT(desc_table[1].addr == 0x5000);
+
+	/* The used descriptor in slot 1 must not be seen as available again */
+	ret = vhost_vq_avail_ring_get(&vq, reqs, 4);
+	CU_ASSERT(ret == 0);
+
+	vhost_vq_used_ring_enqueue(&vs, &vq, 1, 1);
+	CU_ASSERT(descs[3].id == 1);
+	CU_ASSERT(descs[3].flags == (VRING_DESC_F_AVAIL_USED | VRING_DESC_F_WRITE));
+	CU_ASSERT(vq.last_used_idx == 1);
+	CU_ASSERT(vq.packed.used_phase == false);
+
+	/* Buffer IDs out of range are returned to the driver right away */
+	descs[1].len = 16;
+	descs[1].id = 4;
+	descs[1].flags = VRING_DESC_F_USED;
+
+	ret = vhost_vq_avail_ring_get(&vq, reqs, 4);
+	CU_ASSERT(ret == 0);
+	CU_ASSERT(vq.last_avail_idx == 2);
+	CU_ASSERT(vq.last_used_idx == 2);
+	CU_ASSERT(descs[1].flags == 0);
+}
+
+static void
+vq_adaptive_coalescing_test(void)
+{
+	struct spdk_vhost_session vs = {};
+	struct spdk_vhost_virtqueue *vq = &vs.virtqueue[0];
+	struct vring_desc descs[4] = {};
+	struct {
+		struct vring_avail avail;
+		uint16_t ring[4 + 1];
+	} avail = {};
+	struct {
+		struct vring_used used;
+		struct vring_used_elem ring[4];
+	} used = {};
+	uint16_t reqs[4];
+
+	vs.name = "vs";
+	vs.max_queues = 1;
+	vhost_vq_group_init(&vs, &vs.group, NULL, 0, 1);
+	vs.adaptive_coalescing = true;
+	vq->vring.desc = descs;
+	vq->vring.avail = &avail.avail;
+	vq->vring.used = &used.used;
+	vq->vring.size = 4;
+	/* spdk_get_ticks_hz() is 1MHz in unit tests, so ticks are microseconds */
+	vq->coalescing.latency_budget = 100;
+
+	/* Two requests in flight. The first completion waits for the second one. */
+	avail.avail.idx = 2;
+	avail.ring[0] = 0;
+	avail.ring[1] = 1;
+	CU_ASSERT(vhost_vq_avail_ring_get(vq, reqs, 4) == 2);
+	CU_ASSERT(vq->coalescing.inflight == 2);
+
+	ut_spdk_get_ticks = 1000;
+	vhost_vq_used_ring_enqueue(&vs, vq, 0, 0);
+	CU_ASSERT(vq->coalescing.inflight == 1);
+	CU_ASSERT(vq->coalescing.pending == 1);
+
+	ut_spdk_get_ticks = 1010;
+	vhost_session_used_signal(&vs);
+	CU_ASSERT(vq->coalescing.events == 0);
+	CU_ASSERT(vq->used_req_cnt == 1);
+
+	/* Nothing else is in flight after the second completion - signal right away */
+	ut_spdk_get_ticks = 1050;
+	vhost_vq_used_ring_enqueue(&vs, vq, 1, 0);
+	CU_ASSERT(vq->coalescing.inflight == 0);
+	CU_ASSERT(vq->coalescing.avg_completion_interval == 50 / 8);
+
+	ut_spdk_get_ticks = 1060;
+	vhost_session_used_signal(&vs);
+	CU_ASSERT(vq->coalescing.events == 1);
+	CU_ASSERT(vq->coalescing.completions == 2);
+	CU_ASSERT(vq->coalescing.added_latency == (1060 - 1000) + (1060 - 1050));
+	CU_ASSERT(vq->coalescing.pending == 0);
+	CU_ASSERT(vq->used_req_cnt == 0);
+
+	/* With more requests in flight the event is held until the budget runs out */
+	avail.avail.idx = 4;
+	avail.ring[2] = 2;
+	avail.ring[3] = 3;
+	CU_ASSERT(vhost_vq_avail_ring_get(vq, reqs, 4) == 2);
+
+	ut_spdk_get_ticks = 1070;
+	vhost_vq_used_ring_enqueue(&vs, vq, 2, 0);
+
+	ut_spdk_get_ticks = 1150;
+	vhost_session_used_signal(&vs);
+	CU_ASSERT(vq->coalescing.events == 1);
+
+	ut_spdk_get_ticks = 1170;
+	vhost_session_used_signal(&vs);
+	CU_ASSERT(vq->coalescing.events == 2);
+	CU_ASSERT(vq->coalescing.completions == 3);
+
+	/* If completions are rarer than the budget, waiting won't batch anything */
+	vq->coalescing.avg_completion_interval = 500;
+	ut_spdk_get_ticks = 1200;
+	vhost_vq_used_ring_enqueue(&vs, vq, 3, 0);
+	avail.avail.idx = 5;
+	avail.ring[0] = 0;
+	CU_ASSERT(vhost_vq_avail_ring_get(vq, reqs, 4) == 1);
+	vhost_session_used_signal(&vs);
+	CU_ASSERT(vq->coalescing.events == 3);
+
+	/* Completions the driver doesn't want an event for are not signalled */
+	vhost_vq_used_ring_enqueue(&vs, vq, 0, 0);
+	avail.avail.flags = VRING_AVAIL_F_NO_INTERRUPT;
+	ut_spdk_get_ticks = 2000;
+	vhost_session_used_signal(&vs);
+	CU_ASSERT(vq->coalescing.events == 3);
+	CU_ASSERT(vq->coalescing.pending == 0);
+
+	ut_spdk_get_ticks = 0;
+}
+
+static void
+vq_dirty_log_test(void)
+{
+	struct spdk_vhost_session vs = {};
+	struct spdk_vhost_virtqueue *vq = &vs.virtqueue[0];
+	struct vring_desc descs[4] = {};
+	struct {
+		struct vring_avail avail;
+		uint16_t ring[4 + 1];
+	} avail = {};
+	struct {
+		struct vring_used used;
+		struct vring_used_elem ring[4];
+	} used = {};
+	uint64_t log[4] = {};
+	uint16_t i;
+
+	vs.name = "vs";
+	vs.max_queues = 1;
+	vhost_vq_group_init(&vs, &vs.group, NULL, 0, 1);
+	vq->vring.desc = descs;
+	vq->vring.avail = &avail.avail;
+	vq->vring.used = &used.used;
+	vq->vring.size = 4;
+	vq->vring.log_guest_addr = 32 * SPDK_VHOST_LOG_PAGE;
+
+	/* Logging is disabled - nothing gets buffered */
+	descs[0].addr = 62 * SPDK_VHOST_LOG_PAGE + 100;
+	descs[0].len = 3 * SPDK_VHOST_LOG_PAGE;
+	descs[0].flags = VRING_DESC_F_WRITE | VRING_DESC_F_NEXT;
+	descs[0].next = 1;
+	descs[1].addr = 10 * SPDK_VHOST_LOG_PAGE;
+	descs[1].len = 512;
+	vhost_vq_used_ring_enqueue(&vs, vq, 0, 0);
+	CU_ASSERT(vs.group.log_cache_cnt == 0);
+
+	vs.log.enabled = true;
+	vs.log.base = (uint8_t *)log;
+	vs.log.size = sizeof(log);
+
+	/* Only the writable descriptor and the used ring are logged. The first
+	 * one spans pages 62-65, which are in two different log words.
+	 */
+	vhost_vq_used_ring_enqueue(&vs, vq, 0, 0);
+	CU_ASSERT(vs.group.log_cache_cnt == 2);
+	CU_ASSERT(log[0] == 0 && log[1] == 0);
+
+	vhost_session_used_signal(&vs);
+	CU_ASSERT(vs.group.log_cache_cnt == 0);
+	CU_ASSERT(log[0] == ((3ULL << 62) | (1ULL << 32)));
+	CU_ASSERT(log[1] == 3);
+	CU_ASSERT(log[2] == 0 && log[3] == 0);
+
+	/* Pages of the same log word are merged. Pages beyond the log are dropped. */
+	memset(log, 0, sizeof(log));
+	descs[2].addr = 130 * SPDK_VHOST_LOG_PAGE;
+	descs[2].len = SPDK_VHOST_LOG_PAGE;
+	descs[2].flags = VRING_DESC_F_WRITE | VRING_DESC_F_NEXT;
+	descs[2].next = 3;
+	descs[3].addr = 256 * SPDK_VHOST_LOG_PAGE;
+	descs[3].len = SPDK_VHOST_LOG_PAGE;
+	descs[3].flags = VRING_DESC_F_WRITE;
+	vhost_vq_used_ring_enqueue(&vs, vq, 2, 0);
+	descs[2].addr = 191 * SPDK_VHOST_LOG_PAGE;
+	vhost_vq_used_ring_enqueue(&vs, vq, 2, 0);
+	CU_ASSERT(vs.group.log_cache_cnt == 2);
+	vhost_vq_group_log_flush(&vs, &vs.group);
+	CU_ASSERT(log[0] == 1ULL << 32);
+	CU_ASSERT(log[1] == 0);
+	CU_ASSERT(log[2] == ((1ULL << 2) | (1ULL << 63)));
+	CU_ASSERT(log[3] == 0);
+
+	/* A full cache is flushed before any new word is added */
+	memset(log, 0, sizeof(log));
+	for (i = 0; i < SPDK_VHOST_LOG_CACHE_SIZE; i++) {
+		vs.group.log_cache[i].offset = 3;
+		vs.group.log_cache[i].val = 1ULL << i;
+	}
+	vs.group.log_cache_cnt = SPDK_VHOST_LOG_CACHE_SIZE;
+	vhost_log_write(&vs, vq, 0, 1);
+	CU_ASSERT(vs.group.log_cache_cnt == 1);
+	CU_ASSERT(log[3] == UINT32_MAX);
+	CU_ASSERT(log[0] == 0);
+	vhost_vq_group_log_flush(&vs, &vs.group);
+	CU_ASSERT(log[0] == 1);
+}
+
+static void
+vq_group_test(void)
+{
+	struct spdk_vhost_session vs = {};
+	struct spdk_vhost_vq_group groups[2];
+	struct vring_desc descs[4] = {};
+	struct {
+		struct vring_avail avail;
+		uint16_t ring[4 + 1];
+	} avail[4] = {};
+	struct {
+		struct vring_used used;
+		struct vring_used_elem ring[4];
+	} used[4] = {};
+	uint16_t i;
+
+	vs.name = "vs";
+	vs.max_queues = 4;
+	vhost_vq_group_init(&vs, &vs.group, NULL, 0, 1);
+	for (i = 0; i < 4; i++) {
+		vs.virtqueue[i].vring.desc = descs;
+		vs.virtqueue[i].vring.avail = &avail[i].avail;
+		vs.virtqueue[i].vring.used = &used[i].used;
+		vs.virtqueue[i].vring.size = 4;
+		CU_ASSERT(vs.virtqueue[i].group == &vs.group);
+	}
+
+	/* Split the virtqueues into two groups polled by different threads */
+	vhost_vq_group_init(&vs, &groups[0], NULL, 0, 2);
+	vhost_vq_group_init(&vs, &groups[1], NULL, 1, 2);
+	CU_ASSERT(vs.virtqueue[0].group == &groups[0]);
+	CU_ASSERT(vs.virtqueue[1].group == &groups[1]);
+	CU_ASSERT(vs.virtqueue[2].group == &groups[0]);
+	CU_ASSERT(vs.virtqueue[3].group == &groups[1]);
+
+	for (i = 0; i < 4; i++) {
+		vhost_vq_used_ring_enqueue(&vs, &vs.virtqueue[i], 0, 0);
+		CU_ASSERT(vs.virtqueue[i].used_req_cnt == 1);
+	}
+
+	/* Each group signals only its own virtqueues */
+	vhost_vq_group_used_signal(&vs, &groups[1]);
+	CU_ASSERT(vs.virtqueue[0].used_req_cnt == 1);
+	CU_ASSERT(vs.virtqueue[1].used_req_cnt == 0);
+	CU_ASSERT(vs.virtqueue[2].used_req_cnt == 1);
+	CU_ASSERT(vs.virtqueue[3].used_req_cnt == 0);
+
+	vhost_vq_group_used_signal(&vs, &groups[0]);
+	CU_ASSERT(vs.virtqueue[0].used_req_cnt == 0);
+	CU_ASSERT(vs.virtqueue[2].used_req_cnt == 0);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -423,7 +798,11 @@ main(int argc, char **argv)
 		CU_add_test(suite, "create_controller", create_controller_test) == NULL ||
 		CU_add_test(suite, "session_find_by_vid", session_find_by_vid_test) == NULL ||
 		CU_add_test(suite, "remove_controller", remove_controller_test) == NULL ||
-		CU_add_test(suite, "vq_avail_ring_get", vq_avail_ring_get_test) == NULL
+		CU_add_test(suite, "vq_avail_ring_get", vq_avail_ring_get_test) == NULL ||
+		CU_add_test(suite, "vq_packed_ring", vq_packed_ring_test) == NULL ||
+		CU_add_test(suite, "vq_adaptive_coalescing", vq_adaptive_coalescing_test) == NULL ||
+		CU_add_test(suite, "vq_dirty_log", vq_dirty_log_test) == NULL ||
+		CU_add_test(suite, "vq_group", vq_group_test) == NULL
 	) {
 		CU_cleanup_registry();
 		return CU_get_error();
@@ -85,6 +85,7 @@ function unittest_nvmf {
 	$valgrind $testdir/lib/nvmf/ctrlr_bdev.c/ctrlr_bdev_ut
 	$valgrind $testdir/lib/nvmf/ctrlr_discovery.c/ctrlr_discovery_ut
 	$valgrind $testdir/lib/nvmf/subsystem.c/subsystem_ut
+	$valgrind $testdir/lib/nvmf/nvmf.c/nvmf_ut
 	$valgrind $testdir/lib/nvmf/tcp.c/tcp_ut
 }
 
@@ -163,6 +164,7 @@ fi
 
 if [ $SPDK_TEST_REDUCE -eq 1 ]; then
 	run_test "unittest_bdev_reduce" $valgrind $testdir/lib/bdev/compress.c/compress_ut
+	run_test "unittest_bdev_reduce_sw" $valgrind $testdir/lib/bdev/compress_sw.c/compress_sw_ut
 fi
 
 if [ $SPDK_TEST_PMDK -eq 1 ]; then
@@ -182,6 +184,10 @@ fi
 run_test "unittest_ioat" $valgrind $testdir/lib/ioat/ioat.c/ioat_ut
 run_test "unittest_iscsi" unittest_iscsi
 run_test "unittest_json" unittest_json
+if [ $(uname -s) = Linux ]; then
+	run_test "unittest_nbd" $valgrind $testdir/lib/nbd/nbd.c/nbd_ut
+fi
+
 run_test "unittest_notify" $valgrind $testdir/lib/notify/notify.c/notify_ut
 run_test "unittest_nvme" unittest_nvme
 run_test "unittest_log" $valgrind $testdir/lib/log/log.c/log_ut
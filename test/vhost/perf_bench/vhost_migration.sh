@@ -0,0 +1,121 @@
+#!/usr/bin/env bash
+
+testdir=$(readlink -f $(dirname $0))
+rootdir=$(readlink -f $testdir/../../..)
+source $rootdir/test/common/autotest_common.sh
+source $rootdir/test/vhost/common.sh
+
+# Measure how fast a live migration of a VM using a vhost-scsi disk converges
+# while the guest keeps writing to the disk. Both QEMU instances run on this
+# host and connect to the same vhost target, so the result is bound by the
+# dirty page logging done by the target and QEMU, not by the network.
+vhost_cpumask="0x1"
+migrate_speed="1g"
+rw=randwrite
+io_size=4096
+queue_depth=32
+os_image=""
+
+function usage()
+{
+	[[ -n $2 ]] && ( echo "$2"; echo ""; )
+	echo "Measure live migration convergence of a VM with a vhost-scsi disk under write load."
+	echo "Usage: $(basename $1) [OPTIONS]"
+	echo
+	echo "-h, --help                Print help and exit"
+	echo "    --os=PATH             VM image. Default: $VM_IMAGE"
+	echo "    --vhost-cpumask=MASK  CPU mask for the vhost target. Default: $vhost_cpumask"
+	echo "    --migrate-speed=BW    Migration bandwidth limit passed to QEMU. Default: $migrate_speed"
+	echo "    --rw=STR              fio workload type run in the guest. Default: $rw"
+	echo "    --io-size=INT         I/O size in bytes. Default: $io_size"
+	echo "    --queue-depth=INT     Queue depth for fio. Default: $queue_depth"
+	exit 0
+}
+
+while getopts 'h-:' optchar; do
+	case "$optchar" in
+		-)
+		case "$OPTARG" in
+			help) usage $0 ;;
+			os=*) os_image="${OPTARG#*=}" ;;
+			vhost-cpumask=*) vhost_cpumask="${OPTARG#*=}" ;;
+			migrate-speed=*) migrate_speed="${OPTARG#*=}" ;;
+			rw=*) rw="${OPTARG#*=}" ;;
+			io-size=*) io_size="${OPTARG#*=}" ;;
+			queue-depth=*) queue_depth="${OPTARG#*=}" ;;
+			*) usage $0 "Invalid argument '$OPTARG'" ;;
+		esac
+		;;
+		h) usage $0 ;;
+		*) usage $0 "Invalid argument '$OPTARG'" ;;
+	esac
+done
+
+vhosttestinit
+
+source_vm=0
+target_vm=1
+
+function vm_monitor_cmd()
+{
+	local vm_num=$1
+	local vm_monitor_port
+
+	vm_monitor_port=$(cat $VM_DIR/$vm_num/monitor_port)
+	[[ -n "$vm_monitor_port" ]] || fail "No monitor port!"
+
+	shift
+	echo -e "$*\nquit" | nc 127.0.0.1 $vm_monitor_port
+}
+
+trap 'error_exit "${FUNCNAME}" "${LINENO}"' SIGTERM SIGABRT ERR
+
+vhost_run 0 "--no-gen-nvme" "-m $vhost_cpumask"
+vhost_rpc 0 bdev_malloc_create -b Malloc0 256 4096
+vhost_rpc 0 vhost_create_scsi_controller --cpumask $vhost_cpumask naa.Malloc0.$source_vm
+vhost_rpc 0 vhost_scsi_controller_add_target naa.Malloc0.$source_vm 0 Malloc0
+vhost_rpc 0 vhost_create_scsi_controller --cpumask $vhost_cpumask naa.Malloc0.$target_vm
+vhost_rpc 0 vhost_scsi_controller_add_target naa.Malloc0.$target_vm 0 Malloc0
+
+vm_setup ${os_image:+--os="$os_image"} --force=$source_vm --disk-type=spdk_vhost_scsi \
+	--disks=Malloc0 --migrate-to=$target_vm
+vm_setup --force=$target_vm --disk-type=spdk_vhost_scsi --disks=Malloc0 --incoming=$source_vm
+vm_run $source_vm $target_vm
+vm_wait_for_boot 300 $source_vm
+
+vm_check_scsi_location $source_vm
+notice "Starting $rw load in VM$source_vm"
+vm_exec $source_vm "fio --name=dirty --filename=/dev/${SCSI_DISK%% *} --rw=$rw --bs=$io_size \
+	--iodepth=$queue_depth --ioengine=libaio --direct=1 --time_based --runtime=3600 \
+	--daemonize=/root/fio.pid"
+sleep 5
+
+target_migration_port=$(cat $VM_DIR/$target_vm/migration_port)
+vm_monitor_cmd $source_vm "migrate_set_speed $migrate_speed\nmigrate -d tcp:127.0.0.1:$target_migration_port" > /dev/null
+
+timeout=600
+while ! vm_monitor_cmd $source_vm "info migrate" > $VM_DIR/$source_vm/migration_result \
+	|| ! grep -q "Migration status: completed" $VM_DIR/$source_vm/migration_result; do
+	if grep -q "Migration status: failed" $VM_DIR/$source_vm/migration_result || ((timeout-- == 0)); then
+		cat $VM_DIR/$source_vm/migration_result
+		fail "Migration did not complete"
+	fi
+	sleep 1
+done
+
+total_time=$(awk '/^total time:/ {print $3}' $VM_DIR/$source_vm/migration_result)
+downtime=$(awk '/^downtime:/ {print $2}' $VM_DIR/$source_vm/migration_result)
+dirty_syncs=$(awk '/^dirty sync count:/ {print $4}' $VM_DIR/$source_vm/migration_result)
+
+notice "Migration total time: $total_time ms"
+notice "Migration downtime:   $downtime ms"
+notice "Dirty sync count:     $dirty_syncs"
+
+vm_exec $target_vm "kill \$(cat /root/fio.pid)" || true
+vm_shutdown_all
+vhost_rpc 0 vhost_delete_controller naa.Malloc0.$source_vm
+vhost_rpc 0 vhost_delete_controller naa.Malloc0.$target_vm
+vhost_rpc 0 bdev_malloc_delete Malloc0
+vhost_kill 0
+
+vhosttestfini
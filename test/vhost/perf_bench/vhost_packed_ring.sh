@@ -0,0 +1,111 @@
+#!/usr/bin/env bash
+
+testdir=$(readlink -f $(dirname $0))
+rootdir=$(readlink -f $testdir/../../..)
+source $rootdir/test/common/autotest_common.sh
+source $rootdir/test/vhost/common.sh
+
+# Compare split and packed virtqueues between the SPDK virtio-blk initiator
+# and the SPDK vhost-blk target. Each side runs on a single core, so the
+# reported IOPS are IOPS per core of the vhost target.
+vhost_cpumask="0x1"
+bdevperf_cpumask="0x2"
+queue_depth=128
+io_size=4096
+rw=randread
+run_time=10
+vq_size=256
+
+function usage()
+{
+	[[ -n $2 ]] && ( echo "$2"; echo ""; )
+	echo "Compare IOPS per core of split and packed virtqueues with vhost-blk."
+	echo "Usage: $(basename $1) [OPTIONS]"
+	echo
+	echo "-h, --help                Print help and exit"
+	echo "    --vhost-cpumask=MASK  CPU mask for the vhost target. Default: $vhost_cpumask"
+	echo "    --bdevperf-cpumask=MASK CPU mask for bdevperf. Default: $bdevperf_cpumask"
+	echo "    --queue-depth=INT     Queue depth for bdevperf. Default: $queue_depth"
+	echo "    --io-size=INT         I/O size in bytes. Default: $io_size"
+	echo "    --rw=STR              bdevperf workload type. Default: $rw"
+	echo "    --run-time=INT        Run time of each test in seconds. Default: $run_time"
+	echo "    --vq-size=INT         Virtqueue size. Default: $vq_size"
+	exit 0
+}
+
+while getopts 'h-:' optchar; do
+	case "$optchar" in
+		-)
+		case "$OPTARG" in
+			help) usage $0 ;;
+			vhost-cpumask=*) vhost_cpumask="${OPTARG#*=}" ;;
+			bdevperf-cpumask=*) bdevperf_cpumask="${OPTARG#*=}" ;;
+			queue-depth=*) queue_depth="${OPTARG#*=}" ;;
+			io-size=*) io_size="${OPTARG#*=}" ;;
+			rw=*) rw="${OPTARG#*=}" ;;
+			run-time=*) run_time="${OPTARG#*=}" ;;
+			vq-size=*) vq_size="${OPTARG#*=}" ;;
+			*) usage $0 "Invalid argument '$OPTARG'" ;;
+		esac
+		;;
+		h) usage $0 ;;
+		*) usage $0 "Invalid argument '$OPTARG'" ;;
+	esac
+done
+
+vhosttestinit
+
+vhost_dir="$(get_vhost_dir 0)"
+bdevperf_conf=$vhost_dir/bdevperf.json
+
+function run_bdevperf()
+{
+	local ctrlr=$1
+
+	cat <<- JSON > $bdevperf_conf
+	{
+	  "subsystems": [
+	    {
+	      "subsystem": "bdev",
+	      "config": [
+	        {
+	          "method": "bdev_virtio_attach_controller",
+	          "params": {
+	            "name": "VirtioBlk0",
+	            "trtype": "user",
+	            "traddr": "$vhost_dir/$ctrlr",
+	            "dev_type": "blk",
+	            "vq_count": 1,
+	            "vq_size": $vq_size
+	          }
+	        }
+	      ]
+	    }
+	  ]
+	}
+	JSON
+
+	$rootdir/test/bdev/bdevperf/bdevperf --json $bdevperf_conf -m $bdevperf_cpumask \
+		-q $queue_depth -o $io_size -w $rw -t $run_time | awk '/Total/ {print $3}'
+}
+
+trap 'error_exit "${FUNCNAME}" "${LINENO}"' SIGTERM SIGABRT ERR
+
+vhost_run 0 "--no-gen-nvme" "-m $vhost_cpumask"
+vhost_rpc 0 bdev_null_create Null0 1024 512
+vhost_rpc 0 bdev_null_create Null1 1024 512
+vhost_rpc 0 vhost_create_blk_controller --cpumask $vhost_cpumask split.0 Null0
+vhost_rpc 0 vhost_create_blk_controller --cpumask $vhost_cpumask --packed_ring packed.0 Null1
+
+split_iops=$(run_bdevperf split.0)
+packed_iops=$(run_bdevperf packed.0)
+
+notice "Split virtqueue:  $split_iops IOPS per core"
+notice "Packed virtqueue: $packed_iops IOPS per core"
+
+vhost_rpc 0 vhost_delete_controller split.0
+vhost_rpc 0 vhost_delete_controller packed.0
+vhost_kill 0
+rm -f $bdevperf_conf
+
+vhosttestfini